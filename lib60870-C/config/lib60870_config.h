@@ -20,6 +20,37 @@
 #define CONFIG_SLAVE_MESSAGE_QUEUE_SIZE -1
 #endif
 
+/**
+ * Size of the CS 101 slave queue for class 1 data generated by the stack or the callback handlers
+ * (e.g. ACT_CON, ACT_TERM and interrogation responses). These messages are sent before the class 1
+ * data enqueued by the application. When CONFIG_SLAVE_MESSAGE_QUEUE_SIZE is not -1 that size is used.
+ */
+#ifndef CONFIG_CS101_MESSAGE_QUEUE_HIGH_PRIO_SIZE
+#define CONFIG_CS101_MESSAGE_QUEUE_HIGH_PRIO_SIZE 50
+#endif
+
+/**
+ * Store the enqueue time with each message in the CS 101 slave queues to provide the
+ * event age (totalAgeMs, maxAgeMs) in the queue statistics.
+ *
+ * This requires 8 additional bytes of memory for each queued message. When set to 0 the
+ * event age in the queue statistics is always 0.
+ */
+#ifndef CONFIG_CS101_QUEUE_EVENT_AGE
+#define CONFIG_CS101_QUEUE_EVENT_AGE 1
+#endif
+
+/**
+ * Support the replacement of queued cyclic values by newer values in the CS 101 slave
+ * class 2 queue (see CS101_Slave_setClass2Coalescing).
+ *
+ * This requires 8 additional bytes of memory for each queued message. When set to 0 the
+ * queued values are never replaced.
+ */
+#ifndef CONFIG_CS101_QUEUE_COALESCING
+#define CONFIG_CS101_QUEUE_COALESCING 1
+#endif
+
 /**
  * Define the default size for the slave (outstation) message queue. This is used also
  * to buffer ASDUs in the case when the connection is lost.
@@ -110,4 +141,24 @@
 #define CONFIG_ALLOW_C_TS_NA_1_FOR_CS104 0
 #endif
 
+/* time (in ms) the resolved addresses of a hostname are reused for reconnects of a CS104 client connection */
+#ifndef CONFIG_CS104_RESOLVER_CACHE_TTL
+#define CONFIG_CS104_RESOLVER_CACHE_TTL 60000
+#endif
+
+/* maximum number of IP addresses that are tried for a single hostname */
+#ifndef CONFIG_CS104_MAX_RESOLVED_ADDRESSES
+#define CONFIG_CS104_MAX_RESOLVED_ADDRESSES 8
+#endif
+
+/* delay (in ms) before the next address is tried while a connection attempt is still pending (RFC 8305) */
+#ifndef CONFIG_CS104_CONNECTION_ATTEMPT_DELAY
+#define CONFIG_CS104_CONNECTION_ATTEMPT_DELAY 250
+#endif
+
+/* maximum number of paths (server addresses) of a CS104_RedundantConnection */
+#ifndef CONFIG_CS104_REDUNDANT_CONNECTION_MAX_PATHS
+#define CONFIG_CS104_REDUNDANT_CONNECTION_MAX_PATHS 4
+#endif
+
 #endif /* CONFIG_LIB60870_CONFIG_H_ */
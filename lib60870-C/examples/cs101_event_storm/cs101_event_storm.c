@@ -0,0 +1,318 @@
+/*
+ * cs101_event_storm.c
+ *
+ * Benchmark for the data queues of the unbalanced CS101_Slave. An event generator enqueues bursts of
+ * spontaneous events (class 1) and cyclic values (class 2) while a CS101_Master polls the slave over
+ * a virtual serial port.
+ *
+ * The results (response time of the slave, event age and queue statistics) are printed as JSON.
+ */
+
+#include "hal_serial.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+#include "cs101_master.h"
+#include "cs101_slave.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SAMPLES 1000000
+#define NUMBER_OF_CYCLIC_VALUES 100
+
+typedef struct {
+    int durationInS;
+    int burstSize; /* events per burst */
+    int burstInterval; /* ms */
+    int queueSize;
+    int baudRate; /* 0 = no baud rate emulation */
+    bool coalescing;
+} BenchmarkConfig;
+
+typedef struct {
+    uint64_t requestTime; /* 0 = no request pending */
+    uint64_t* responseTimes; /* in ns */
+    int numberOfSamples;
+    uint64_t asdusReceived;
+    bool measuring;
+} BenchmarkStatistics;
+
+static BenchmarkStatistics statistics;
+
+static void
+rawMessageHandler(void* parameter, uint8_t* msg, int msgSize, bool sent)
+{
+    (void) parameter;
+
+    if (sent) {
+        /* fixed frame with FC 10 or FC 11 (request user data class 1/2) */
+        if ((msgSize == 5) && (msg[0] == 0x10) && (((msg[1] & 0x0f) == 10) || ((msg[1] & 0x0f) == 11)))
+            statistics.requestTime = Hal_getMonotonicTimeInNs();
+    }
+    else if (statistics.requestTime != 0) {
+        if (statistics.measuring && (statistics.numberOfSamples < MAX_SAMPLES))
+            statistics.responseTimes[statistics.numberOfSamples++] = Hal_getMonotonicTimeInNs() - statistics.requestTime;
+
+        statistics.requestTime = 0;
+    }
+}
+
+static bool
+asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    (void) parameter;
+    (void) address;
+    (void) asdu;
+
+    if (statistics.measuring)
+        statistics.asdusReceived++;
+
+    return true;
+}
+
+static CS101_ASDU
+createASDU(CS101_Slave slave, CS101_CauseOfTransmission cot, int ioa, int value)
+{
+    CS101_ASDU asdu = CS101_ASDU_create(CS101_Slave_getAppLayerParameters(slave), false, cot, 0, 1, false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, ioa, value, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    return asdu;
+}
+
+/* enqueue a burst of events and a new value for all cyclic values */
+static void
+generateBurst(CS101_Slave slave, int burstSize, int value, CS101_ASDU* asdus)
+{
+    int i;
+
+    for (i = 0; i < burstSize; i++)
+        asdus[i] = createASDU(slave, CS101_COT_SPONTANEOUS, 1000 + i, value);
+
+    CS101_Slave_enqueueUserDataClass1Batch(slave, asdus, burstSize);
+
+    for (i = 0; i < burstSize; i++)
+        CS101_ASDU_destroy(asdus[i]);
+
+    for (i = 0; i < NUMBER_OF_CYCLIC_VALUES; i++)
+        asdus[i] = createASDU(slave, CS101_COT_PERIODIC, 1 + i, value);
+
+    CS101_Slave_enqueueUserDataClass2Batch(slave, asdus, NUMBER_OF_CYCLIC_VALUES);
+
+    for (i = 0; i < NUMBER_OF_CYCLIC_VALUES; i++)
+        CS101_ASDU_destroy(asdus[i]);
+}
+
+static int
+compareSamples(const void* a, const void* b)
+{
+    uint64_t sampleA = *((const uint64_t*) a);
+    uint64_t sampleB = *((const uint64_t*) b);
+
+    if (sampleA < sampleB)
+        return -1;
+    else if (sampleA > sampleB)
+        return 1;
+    else
+        return 0;
+}
+
+static void
+printQueueStatistics(const char* name, CS101_QueueStatistics* queueStatistics, bool last)
+{
+    printf("  \"%s\": {\n", name);
+    printf("    \"enqueued\": %llu,\n", (unsigned long long) queueStatistics->enqueued);
+    printf("    \"sent\": %llu,\n", (unsigned long long) queueStatistics->sent);
+    printf("    \"dropped\": %llu,\n", (unsigned long long) queueStatistics->dropped);
+    printf("    \"coalesced\": %llu,\n", (unsigned long long) queueStatistics->coalesced);
+    printf("    \"meanAgeMs\": %.1f,\n", (queueStatistics->sent > 0) ?
+            ((double) queueStatistics->totalAgeMs / queueStatistics->sent) : 0.0);
+    printf("    \"maxAgeMs\": %llu\n", (unsigned long long) queueStatistics->maxAgeMs);
+    printf("  }%s\n", last ? "" : ",");
+}
+
+static void
+printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("  -t <seconds>  duration of the measurement (default 10)\n");
+    printf("  -r <number>   events per burst (default 50)\n");
+    printf("  -i <ms>       interval between bursts (default 100)\n");
+    printf("  -q <number>   size of the class 1 and class 2 queues (default 100)\n");
+    printf("  -B <baud>     emulated baud rate (default 0 = unlimited)\n");
+    printf("  -c <on|off>   coalescing of cyclic values in class 2 (default on)\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    BenchmarkConfig config;
+
+    config.durationInS = 10;
+    config.burstSize = 50;
+    config.burstInterval = 100;
+    config.queueSize = 100;
+    config.baudRate = 0;
+    config.coalescing = true;
+
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if ((argv[i][0] != '-') || (i + 1 >= argc)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        const char* value = argv[++i];
+
+        switch (argv[i - 1][1]) {
+        case 't':
+            config.durationInS = atoi(value);
+            break;
+        case 'r':
+            config.burstSize = atoi(value);
+            break;
+        case 'i':
+            config.burstInterval = atoi(value);
+            break;
+        case 'q':
+            config.queueSize = atoi(value);
+            break;
+        case 'B':
+            config.baudRate = atoi(value);
+            break;
+        case 'c':
+            config.coalescing = (strcmp(value, "off") != 0);
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((config.durationInS < 1) || (config.burstSize < 1) || (config.burstInterval < 1) || (config.queueSize < 1)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    SerialPort masterPort;
+    SerialPort slavePort;
+
+    if (SerialPort_createPipePair((config.baudRate > 0) ? config.baudRate : 9600, 8, 'E', 1, &masterPort,
+            &slavePort) == false) {
+        printf("Failed to create virtual serial ports\n");
+        return 1;
+    }
+
+    if (config.baudRate > 0) {
+        SerialPort_setBaudRateEmulation(masterPort, true);
+        SerialPort_setBaudRateEmulation(slavePort, true);
+    }
+
+    statistics.responseTimes = (uint64_t*) calloc(MAX_SAMPLES, sizeof(uint64_t));
+
+    int maxAsdus = (config.burstSize > NUMBER_OF_CYCLIC_VALUES) ? config.burstSize : NUMBER_OF_CYCLIC_VALUES;
+
+    CS101_ASDU* asdus = (CS101_ASDU*) calloc(maxAsdus, sizeof(CS101_ASDU));
+
+    CS101_Slave slave = CS101_Slave_createEx(slavePort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED, config.queueSize,
+            config.queueSize);
+
+    CS101_Slave_setLinkLayerAddress(slave, 1);
+    CS101_Slave_setClass2Coalescing(slave, config.coalescing);
+
+    CS101_Master master = CS101_Master_create(masterPort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    CS101_Master_setASDUReceivedHandler(master, asduReceivedHandler, NULL);
+    CS101_Master_setRawMessageHandler(master, rawMessageHandler, NULL);
+    CS101_Master_setPollMode(master, CS101_POLL_MODE_PRIORITY);
+
+    CS101_Master_addSlave(master, 1);
+
+    /* poll class 2 data continuously - class 1 data is requested when the slave sets ACD */
+    CS101_Master_setSlavePollParameters(master, 1, 1, 1);
+
+    CS101_Slave_start(slave);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+    uint64_t measurementStart = startTime + 1000; /* give the link layers some time to start */
+    uint64_t measurementEnd = measurementStart + (uint64_t) config.durationInS * 1000;
+    uint64_t nextBurst = measurementStart;
+
+    uint64_t now = startTime;
+    int bursts = 0;
+
+    while (now < measurementEnd) {
+        CS101_Master_run(master);
+
+        now = Hal_getMonotonicTimeInMs();
+
+        if (now >= nextBurst) {
+            if (statistics.measuring == false)
+                statistics.measuring = true;
+
+            generateBurst(slave, config.burstSize, bursts, asdus);
+
+            bursts++;
+            nextBurst += config.burstInterval;
+        }
+    }
+
+    statistics.measuring = false;
+
+    CS101_Slave_stop(slave);
+
+    CS101_QueueStatistics class1Statistics;
+    CS101_QueueStatistics class2Statistics;
+
+    CS101_Slave_getClass1QueueStatistics(slave, &class1Statistics);
+    CS101_Slave_getClass2QueueStatistics(slave, &class2Statistics);
+
+    qsort(statistics.responseTimes, statistics.numberOfSamples, sizeof(uint64_t), compareSamples);
+
+    uint64_t totalResponseTime = 0;
+
+    for (i = 0; i < statistics.numberOfSamples; i++)
+        totalResponseTime += statistics.responseTimes[i];
+
+    int samples = statistics.numberOfSamples;
+
+    double duration = (double) config.durationInS;
+
+    printf("{\n");
+    printf("  \"durationS\": %i,\n", config.durationInS);
+    printf("  \"burstSize\": %i,\n", config.burstSize);
+    printf("  \"burstIntervalMs\": %i,\n", config.burstInterval);
+    printf("  \"queueSize\": %i,\n", config.queueSize);
+    printf("  \"baudRate\": %i,\n", config.baudRate);
+    printf("  \"coalescing\": %s,\n", config.coalescing ? "true" : "false");
+    printf("  \"eventsPerS\": %.1f,\n", (double) bursts * config.burstSize / duration);
+    printf("  \"asdusReceivedPerS\": %.1f,\n", statistics.asdusReceived / duration);
+    printf("  \"responses\": %i,\n", samples);
+    printf("  \"meanResponseTimeUs\": %.1f,\n", (samples > 0) ? (totalResponseTime / 1000.0 / samples) : 0.0);
+    printf("  \"p50ResponseTimeUs\": %.1f,\n", (samples > 0) ? (statistics.responseTimes[samples / 2] / 1000.0) : 0.0);
+    printf("  \"p99ResponseTimeUs\": %.1f,\n",
+            (samples > 0) ? (statistics.responseTimes[(samples * 99) / 100] / 1000.0) : 0.0);
+    printf("  \"maxResponseTimeUs\": %.1f,\n", (samples > 0) ? (statistics.responseTimes[samples - 1] / 1000.0) : 0.0);
+    printQueueStatistics("class1", &class1Statistics, false);
+    printQueueStatistics("class2", &class2Statistics, true);
+    printf("}\n");
+
+    CS101_Master_destroy(master);
+    CS101_Slave_destroy(slave);
+
+    SerialPort_close(masterPort);
+    SerialPort_destroy(masterPort);
+    SerialPort_close(slavePort);
+    SerialPort_destroy(slavePort);
+
+    free(asdus);
+    free(statistics.responseTimes);
+
+    return 0;
+}
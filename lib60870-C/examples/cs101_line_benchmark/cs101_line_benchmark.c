@@ -0,0 +1,386 @@
+/*
+ * cs101_line_benchmark.c
+ *
+ * Benchmark for the unbalanced CS 101 link layer. A CS101_Master polls many CS101_Slave instances
+ * in a single process. The master and the slaves are connected by virtual serial ports (in-memory
+ * pipes or pseudo terminals) to a bus emulator that forwards the frames of the master to the
+ * addressed slave and the responses back to the master.
+ *
+ * The master and all slaves are handled by a single CS101_PortScheduler thread. The results
+ * (poll cycle time and throughput) are printed as JSON.
+ */
+
+#include "hal_serial.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+#include "cs101_master.h"
+#include "cs101_slave.h"
+#include "cs101_port_scheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SLAVES 254
+
+typedef struct {
+    int numberOfSlaves;
+    int durationInS;
+    bool usePty;
+    int baudRate; /* 0 = no baud rate emulation */
+    int bitErrorRate; /* bit errors per million bits */
+    CS101_PollMode pollMode;
+} BenchmarkConfig;
+
+typedef struct {
+    uint64_t requests[MAX_SLAVES + 1]; /* class 2 requests sent to each slave */
+    uint64_t framesReceived;
+    uint64_t bytesReceived;
+    uint64_t asdusReceived;
+    bool measuring;
+} BenchmarkStatistics;
+
+static BenchmarkStatistics statistics;
+
+static void
+rawMessageHandler(void* parameter, uint8_t* msg, int msgSize, bool sent)
+{
+    (void) parameter;
+
+    if (statistics.measuring == false)
+        return;
+
+    if (sent) {
+        /* fixed frame with FC 11 (request user data class 2) */
+        if ((msgSize == 5) && (msg[0] == 0x10) && ((msg[1] & 0x0f) == 11))
+            statistics.requests[msg[2]]++;
+    }
+    else {
+        statistics.framesReceived++;
+        statistics.bytesReceived += msgSize;
+    }
+}
+
+static bool
+asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    (void) parameter;
+    (void) address;
+    (void) asdu;
+
+    if (statistics.measuring)
+        statistics.asdusReceived++;
+
+    return true;
+}
+
+/* provide class 2 data for the next response of the slave */
+static void
+enqueueClass2Data(CS101_Slave slave)
+{
+    CS101_ASDU asdu = CS101_ASDU_create(CS101_Slave_getAppLayerParameters(slave), false, CS101_COT_PERIODIC, 0, 1,
+            false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 100, 1, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    CS101_Slave_enqueueUserDataClass2(slave, asdu);
+
+    InformationObject_destroy(io);
+    CS101_ASDU_destroy(asdu);
+}
+
+static bool
+createPortPair(BenchmarkConfig* config, SerialPort* port, SerialPort* busPort)
+{
+    bool result;
+
+    int baudRate = (config->baudRate > 0) ? config->baudRate : 9600;
+
+    if (config->usePty)
+        result = SerialPort_createPtyPair(baudRate, 8, 'E', 1, port, busPort);
+    else
+        result = SerialPort_createPipePair(baudRate, 8, 'E', 1, port, busPort);
+
+    if (result) {
+        /* only the station side of the connection is slowed down and disturbed */
+        if (config->baudRate > 0)
+            SerialPort_setBaudRateEmulation(*port, true);
+
+        if (config->bitErrorRate > 0)
+            SerialPort_setBitErrorRate(*port, config->bitErrorRate, (uint32_t) rand());
+    }
+
+    return result;
+}
+
+/* split the byte stream of the master into frames and forward them to the addressed slave */
+static int
+forwardMasterFrames(SerialPort* slaveBusPorts, CS101_Slave* slaves, int numberOfSlaves, uint8_t* buffer,
+                    int bufferSize)
+{
+    int pos = 0;
+
+    while (pos < bufferSize) {
+        int frameSize;
+
+        if (buffer[pos] == 0x10)
+            frameSize = 5;
+        else if (buffer[pos] == 0x68) {
+            if (bufferSize - pos < 2)
+                break;
+
+            frameSize = buffer[pos + 1] + 6;
+        }
+        else {
+            pos++; /* skip unexpected byte */
+            continue;
+        }
+
+        if (bufferSize - pos < frameSize)
+            break; /* frame incomplete */
+
+        int address = (buffer[pos] == 0x10) ? buffer[pos + 2] : buffer[pos + 5];
+
+        if (address == 255) {
+            int i;
+
+            for (i = 0; i < numberOfSlaves; i++)
+                SerialPort_write(slaveBusPorts[i], buffer, pos, frameSize);
+        }
+        else if ((address >= 1) && (address <= numberOfSlaves)) {
+            /* request user data class 2 */
+            if ((buffer[pos] == 0x10) && ((buffer[pos + 1] & 0x0f) == 11))
+                enqueueClass2Data(slaves[address - 1]);
+
+            SerialPort_write(slaveBusPorts[address - 1], buffer, pos, frameSize);
+        }
+
+        pos += frameSize;
+    }
+
+    memmove(buffer, buffer + pos, bufferSize - pos);
+
+    return bufferSize - pos;
+}
+
+static void
+printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("  -n <number>   number of slaves (default 100, max 254)\n");
+    printf("  -t <seconds>  duration of the measurement (default 10)\n");
+    printf("  -b <backend>  virtual serial port backend: pipe or pty (default pipe)\n");
+    printf("  -B <baud>     emulated baud rate (default 0 = unlimited)\n");
+    printf("  -E <rate>     bit errors per million bits (default 0)\n");
+    printf("  -m <mode>     poll mode: rr or prio (default prio)\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    BenchmarkConfig config;
+
+    config.numberOfSlaves = 100;
+    config.durationInS = 10;
+    config.usePty = false;
+    config.baudRate = 0;
+    config.bitErrorRate = 0;
+    config.pollMode = CS101_POLL_MODE_PRIORITY;
+
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if ((argv[i][0] != '-') || (i + 1 >= argc)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        const char* value = argv[++i];
+
+        switch (argv[i - 1][1]) {
+        case 'n':
+            config.numberOfSlaves = atoi(value);
+            break;
+        case 't':
+            config.durationInS = atoi(value);
+            break;
+        case 'b':
+            config.usePty = (strcmp(value, "pty") == 0);
+            break;
+        case 'B':
+            config.baudRate = atoi(value);
+            break;
+        case 'E':
+            config.bitErrorRate = atoi(value);
+            break;
+        case 'm':
+            config.pollMode = (strcmp(value, "rr") == 0) ? CS101_POLL_MODE_ROUND_ROBIN : CS101_POLL_MODE_PRIORITY;
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((config.numberOfSlaves < 1) || (config.numberOfSlaves > MAX_SLAVES) || (config.durationInS < 1)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    int numberOfSlaves = config.numberOfSlaves;
+
+    SerialPort masterPort;
+    SerialPort masterBusPort;
+
+    SerialPort* slavePorts = (SerialPort*) calloc(numberOfSlaves, sizeof(SerialPort));
+    SerialPort* slaveBusPorts = (SerialPort*) calloc(numberOfSlaves, sizeof(SerialPort));
+    CS101_Slave* slaves = (CS101_Slave*) calloc(numberOfSlaves, sizeof(CS101_Slave));
+
+    if (createPortPair(&config, &masterPort, &masterBusPort) == false) {
+        printf("Failed to create virtual serial ports\n");
+        return 1;
+    }
+
+    SerialPortSet busPorts = SerialPortSet_create();
+
+    SerialPortSet_addPort(busPorts, masterBusPort, NULL);
+
+    CS101_PortScheduler scheduler = CS101_PortScheduler_create();
+
+
+    CS101_Master master = CS101_Master_create(masterPort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    CS101_Master_setPollMode(master, config.pollMode);
+    CS101_Master_setASDUReceivedHandler(master, asduReceivedHandler, NULL);
+    CS101_Master_setRawMessageHandler(master, rawMessageHandler, NULL);
+
+    for (i = 0; i < numberOfSlaves; i++) {
+        if (createPortPair(&config, &(slavePorts[i]), &(slaveBusPorts[i])) == false) {
+            printf("Failed to create virtual serial ports\n");
+            return 1;
+        }
+
+        slaves[i] = CS101_Slave_create(slavePorts[i], NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+        CS101_Slave_setLinkLayerAddress(slaves[i], i + 1);
+
+        CS101_PortScheduler_addSlave(scheduler, slaves[i]);
+
+        /* the index of the slave is used as parameter */
+        SerialPortSet_addPort(busPorts, slaveBusPorts[i], (void*) (intptr_t) (i + 1));
+
+        CS101_Master_addSlave(master, i + 1);
+
+        /* poll class 2 data continuously */
+        CS101_Master_setSlavePollParameters(master, i + 1, 1, 1);
+    }
+
+    CS101_PortScheduler_addMaster(scheduler, master);
+
+    CS101_PortScheduler_start(scheduler);
+
+    uint8_t masterBuffer[1024];
+    int masterBufferSize = 0;
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+    uint64_t measurementStart = startTime + 1000; /* give the link layers some time to start */
+    uint64_t measurementEnd = measurementStart + (uint64_t) config.durationInS * 1000;
+
+    uint64_t now = startTime;
+
+    memset(&statistics, 0, sizeof(statistics));
+
+    while (now < measurementEnd) {
+        void* readyPorts[64];
+
+        int readyCount = SerialPortSet_waitReady(busPorts, readyPorts, 64, 10);
+
+        for (i = 0; i < readyCount; i++) {
+            int slaveIndex = (int) (intptr_t) readyPorts[i];
+
+            if (slaveIndex == 0) {
+                int readBytes = SerialPort_read(masterBusPort, masterBuffer + masterBufferSize,
+                        sizeof(masterBuffer) - masterBufferSize, 0);
+
+                if (readBytes > 0)
+                    masterBufferSize = forwardMasterFrames(slaveBusPorts, slaves, numberOfSlaves, masterBuffer,
+                            masterBufferSize + readBytes);
+            }
+            else {
+                uint8_t buffer[256];
+
+                int readBytes = SerialPort_read(slaveBusPorts[slaveIndex - 1], buffer, sizeof(buffer), 0);
+
+                if (readBytes > 0)
+                    SerialPort_write(masterBusPort, buffer, 0, readBytes);
+            }
+        }
+
+        now = Hal_getMonotonicTimeInMs();
+
+        if ((statistics.measuring == false) && (now >= measurementStart))
+            statistics.measuring = true;
+    }
+
+    statistics.measuring = false;
+
+    CS101_PortScheduler_stop(scheduler);
+
+    uint64_t minRequests = UINT64_MAX;
+    uint64_t totalRequests = 0;
+
+    for (i = 1; i <= numberOfSlaves; i++) {
+        if (statistics.requests[i] < minRequests)
+            minRequests = statistics.requests[i];
+
+        totalRequests += statistics.requests[i];
+    }
+
+    double duration = (double) config.durationInS;
+
+    /* a poll cycle is complete when every slave is polled once */
+    double pollCycles = (double) totalRequests / numberOfSlaves;
+
+    printf("{\n");
+    printf("  \"slaves\": %i,\n", numberOfSlaves);
+    printf("  \"backend\": \"%s\",\n", config.usePty ? "pty" : "pipe");
+    printf("  \"baudRate\": %i,\n", config.baudRate);
+    printf("  \"bitErrorRate\": %i,\n", config.bitErrorRate);
+    printf("  \"pollMode\": \"%s\",\n", (config.pollMode == CS101_POLL_MODE_ROUND_ROBIN) ? "round-robin" : "priority");
+    printf("  \"durationS\": %i,\n", config.durationInS);
+    printf("  \"pollCycles\": %.1f,\n", pollCycles);
+    printf("  \"meanPollCycleTimeMs\": %.3f,\n", (pollCycles > 0) ? (duration * 1000.0 / pollCycles) : 0.0);
+    printf("  \"maxPollCycleTimeMs\": %.3f,\n", (minRequests > 0) ? (duration * 1000.0 / minRequests) : 0.0);
+    printf("  \"requestsPerS\": %.1f,\n", totalRequests / duration);
+    printf("  \"framesPerS\": %.1f,\n", statistics.framesReceived / duration);
+    printf("  \"bytesPerS\": %.1f,\n", statistics.bytesReceived / duration);
+    printf("  \"asdusPerS\": %.1f\n", statistics.asdusReceived / duration);
+    printf("}\n");
+
+    CS101_PortScheduler_destroy(scheduler);
+
+    CS101_Master_destroy(master);
+
+    for (i = 0; i < numberOfSlaves; i++) {
+        CS101_Slave_destroy(slaves[i]);
+
+        SerialPort_close(slavePorts[i]);
+        SerialPort_destroy(slavePorts[i]);
+        SerialPort_close(slaveBusPorts[i]);
+        SerialPort_destroy(slaveBusPorts[i]);
+    }
+
+    SerialPortSet_destroy(busPorts);
+
+    SerialPort_close(masterPort);
+    SerialPort_destroy(masterPort);
+    SerialPort_close(masterBusPort);
+    SerialPort_destroy(masterBusPort);
+
+    free(slaves);
+    free(slaveBusPorts);
+    free(slavePorts);
+
+    return 0;
+}
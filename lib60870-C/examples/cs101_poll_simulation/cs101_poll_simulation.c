@@ -0,0 +1,494 @@
+/*
+ * cs101_poll_simulation.c
+ *
+ * Simulation of an unbalanced CS 101 multi-drop line with many outstations. Every virtual
+ * slave is connected to its own pseudo terminal and a simple bus emulator forwards the
+ * frames of the master to the addressed slave and the responses back to the master.
+ *
+ * Events (class 1 data) are created at random times at random slaves. The tool measures
+ * the time until each event is received by the master for the round-robin and the priority
+ * polling mode and prints the results as JSON.
+ *
+ * NOTE: requires POSIX pseudo terminals
+ */
+
+#define _GNU_SOURCE
+
+#include "hal_serial.h"
+#include "hal_time.h"
+#include "cs101_master.h"
+#include "cs101_slave.h"
+#include "cs101_port_scheduler.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 100000
+
+typedef struct {
+    int numberOfSlaves;
+    int numberOfDeadSlaves; /* slaves configured at the master that never respond */
+    int durationInS;
+    int eventRate; /* events per second (all slaves) */
+    int class2PollInterval;
+    uint32_t seed;
+} SimulationConfig;
+
+typedef struct {
+    int address;
+    int ptyFd;
+    SerialPort port;
+    CS101_Slave slave;
+} VirtualSlave;
+
+typedef struct {
+    uint64_t* eventTime; /* creation time of each event (ms) */
+    uint64_t* latency; /* latency of the received events (ms) */
+    int eventsCreated;
+    int eventsReceived;
+} SimulationResult;
+
+static uint32_t random_state;
+
+static uint32_t
+nextRandom(void)
+{
+    /* xorshift32 */
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+
+    return random_state;
+}
+
+static bool
+asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    SimulationResult* result = (SimulationResult*) parameter;
+
+    (void) address;
+
+    if (CS101_ASDU_getCOT(asdu) == CS101_COT_SPONTANEOUS) {
+        uint64_t now = Hal_getMonotonicTimeInMs();
+
+        int i;
+
+        for (i = 0; i < CS101_ASDU_getNumberOfElements(asdu); i++) {
+            InformationObject io = CS101_ASDU_getElement(asdu, i);
+
+            if (io) {
+                int eventIndex = InformationObject_getObjectAddress(io);
+
+                if ((eventIndex >= 0) && (eventIndex < result->eventsCreated))
+                    result->latency[result->eventsReceived++] = now - result->eventTime[eventIndex];
+
+                InformationObject_destroy(io);
+            }
+        }
+    }
+
+    return true;
+}
+
+static int
+openPty(char** slaveName)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (fd == -1)
+        return -1;
+
+    if ((grantpt(fd) != 0) || (unlockpt(fd) != 0)) {
+        close(fd);
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    *slaveName = ptsname(fd);
+
+    return fd;
+}
+
+static void
+routeFrame(VirtualSlave* slaves, int numberOfSlaves, uint8_t* frame, int frameSize, int address)
+{
+    int i;
+
+    for (i = 0; i < numberOfSlaves; i++) {
+        if ((slaves[i].address == address) || (address == 255)) {
+            if (write(slaves[i].ptyFd, frame, frameSize) != frameSize)
+                printf("WARNING: failed to forward frame to slave %i\n", slaves[i].address);
+        }
+    }
+}
+
+/* split the byte stream of the master into frames and forward them to the addressed slave */
+static int
+handleMasterData(VirtualSlave* slaves, int numberOfSlaves, uint8_t* buffer, int bufferSize)
+{
+    int pos = 0;
+
+    while (pos < bufferSize) {
+        int frameSize = 0;
+        int address = -1;
+
+        if (buffer[pos] == 0x10) {
+            frameSize = 5;
+
+            if (bufferSize - pos >= frameSize)
+                address = buffer[pos + 2];
+        }
+        else if (buffer[pos] == 0x68) {
+            if (bufferSize - pos >= 6) {
+                frameSize = buffer[pos + 1] + 6;
+
+                if (bufferSize - pos >= frameSize)
+                    address = buffer[pos + 5];
+            }
+            else
+                break;
+        }
+        else {
+            pos++; /* skip unexpected byte */
+            continue;
+        }
+
+        if (address == -1)
+            break; /* frame incomplete */
+
+        routeFrame(slaves, numberOfSlaves, buffer + pos, frameSize, address);
+
+        pos += frameSize;
+    }
+
+    memmove(buffer, buffer + pos, bufferSize - pos);
+
+    return bufferSize - pos;
+}
+
+static bool
+runSimulation(SimulationConfig* config, CS101_PollMode pollMode, SimulationResult* result)
+{
+    bool success = false;
+
+    int numberOfSlaves = config->numberOfSlaves;
+    int numberOfAddresses = config->numberOfSlaves + config->numberOfDeadSlaves;
+
+    VirtualSlave* slaves = (VirtualSlave*) calloc(numberOfSlaves, sizeof(VirtualSlave));
+    struct pollfd* pollFds = (struct pollfd*) calloc(numberOfSlaves + 1, sizeof(struct pollfd));
+
+    CS101_PortScheduler scheduler = NULL;
+    CS101_Master master = NULL;
+    SerialPort masterPort = NULL;
+    int masterPtyFd = -1;
+
+    char* ptyName;
+
+    int i;
+
+    random_state = config->seed;
+
+    result->eventsCreated = 0;
+    result->eventsReceived = 0;
+
+    for (i = 0; i < numberOfSlaves; i++)
+        slaves[i].ptyFd = -1;
+
+    masterPtyFd = openPty(&ptyName);
+
+    if (masterPtyFd == -1)
+        goto exit_function;
+
+    masterPort = SerialPort_create(ptyName, 9600, 8, 'E', 1);
+
+    if (SerialPort_open(masterPort) == false)
+        goto exit_function;
+
+    master = CS101_Master_create(masterPort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    CS101_Master_setASDUReceivedHandler(master, asduReceivedHandler, result);
+    CS101_Master_setPollMode(master, pollMode);
+
+    /* the addresses of the dead slaves are interleaved with the addresses of the working slaves */
+    for (i = 0; i < numberOfAddresses; i++) {
+        CS101_Master_addSlave(master, i + 1);
+        CS101_Master_setSlavePollParameters(master, i + 1, 1, config->class2PollInterval);
+    }
+
+    scheduler = CS101_PortScheduler_create();
+
+    for (i = 0; i < numberOfSlaves; i++) {
+        VirtualSlave* vs = &(slaves[i]);
+
+        vs->address = (numberOfAddresses * (i + 1)) / numberOfSlaves;
+
+        vs->ptyFd = openPty(&ptyName);
+
+        if (vs->ptyFd == -1)
+            goto exit_function;
+
+        vs->port = SerialPort_create(ptyName, 9600, 8, 'E', 1);
+
+        if (SerialPort_open(vs->port) == false)
+            goto exit_function;
+
+        vs->slave = CS101_Slave_create(vs->port, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+        CS101_Slave_setLinkLayerAddress(vs->slave, vs->address);
+
+        CS101_PortScheduler_addSlave(scheduler, vs->slave);
+
+        pollFds[i + 1].fd = vs->ptyFd;
+        pollFds[i + 1].events = POLLIN;
+    }
+
+    pollFds[0].fd = masterPtyFd;
+    pollFds[0].events = POLLIN;
+
+    CS101_PortScheduler_start(scheduler);
+    CS101_Master_start(master);
+
+    uint8_t masterBuffer[1024];
+    int masterBufferSize = 0;
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+    uint64_t endTime = startTime + (uint64_t) config->durationInS * 1000;
+    uint64_t drainTime = endTime + 5000;
+    uint64_t nextEventTime = startTime + 2000; /* give the link layers some time to start */
+
+    uint64_t now = startTime;
+
+    while (now < drainTime) {
+        if (poll(pollFds, numberOfSlaves + 1, 1) > 0) {
+            if (pollFds[0].revents & POLLIN) {
+                int readBytes = read(masterPtyFd, masterBuffer + masterBufferSize, sizeof(masterBuffer) - masterBufferSize);
+
+                if (readBytes > 0)
+                    masterBufferSize = handleMasterData(slaves, numberOfSlaves, masterBuffer, masterBufferSize + readBytes);
+            }
+
+            for (i = 0; i < numberOfSlaves; i++) {
+                if (pollFds[i + 1].revents & POLLIN) {
+                    uint8_t buffer[256];
+
+                    int readBytes = read(slaves[i].ptyFd, buffer, sizeof(buffer));
+
+                    if (readBytes > 0) {
+                        if (write(masterPtyFd, buffer, readBytes) != readBytes)
+                            printf("WARNING: failed to forward frame to master\n");
+                    }
+                }
+            }
+        }
+
+        now = Hal_getMonotonicTimeInMs();
+
+        /* create events until the end of the measurement period */
+        while ((now < endTime) && (now >= nextEventTime) && (result->eventsCreated < MAX_EVENTS)) {
+            VirtualSlave* vs = &(slaves[nextRandom() % numberOfSlaves]);
+
+            CS101_ASDU asdu = CS101_ASDU_create(CS101_Slave_getAppLayerParameters(vs->slave), false, CS101_COT_SPONTANEOUS,
+                    0, vs->address, false, false);
+
+            InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, result->eventsCreated,
+                    (int) (nextRandom() % 1000), IEC60870_QUALITY_GOOD);
+
+            CS101_ASDU_addInformationObject(asdu, io);
+
+            result->eventTime[result->eventsCreated] = now;
+            result->eventsCreated++;
+
+            CS101_Slave_enqueueUserDataClass1(vs->slave, asdu);
+
+            InformationObject_destroy(io);
+            CS101_ASDU_destroy(asdu);
+
+            /* exponential distribution is approximated by a uniform distribution with the same mean */
+            nextEventTime += (uint64_t) (nextRandom() % (2000 / config->eventRate + 1));
+        }
+
+        if ((now >= endTime) && (result->eventsReceived >= result->eventsCreated))
+            break;
+    }
+
+    success = true;
+
+exit_function:
+
+    if (master) {
+        CS101_Master_stop(master);
+        CS101_Master_destroy(master);
+    }
+
+    if (scheduler) {
+        CS101_PortScheduler_stop(scheduler);
+        CS101_PortScheduler_destroy(scheduler);
+    }
+
+    for (i = 0; i < numberOfSlaves; i++) {
+        if (slaves[i].slave)
+            CS101_Slave_destroy(slaves[i].slave);
+
+        if (slaves[i].port) {
+            SerialPort_close(slaves[i].port);
+            SerialPort_destroy(slaves[i].port);
+        }
+
+        if (slaves[i].ptyFd != -1)
+            close(slaves[i].ptyFd);
+    }
+
+    if (masterPort) {
+        SerialPort_close(masterPort);
+        SerialPort_destroy(masterPort);
+    }
+
+    if (masterPtyFd != -1)
+        close(masterPtyFd);
+
+    free(pollFds);
+    free(slaves);
+
+    return success;
+}
+
+static int
+compareLatency(const void* a, const void* b)
+{
+    uint64_t la = *((const uint64_t*) a);
+    uint64_t lb = *((const uint64_t*) b);
+
+    return (la > lb) - (la < lb);
+}
+
+static void
+printResult(const char* modeName, SimulationResult* result, bool last)
+{
+    uint64_t sum = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+
+    int i;
+
+    qsort(result->latency, result->eventsReceived, sizeof(uint64_t), compareLatency);
+
+    for (i = 0; i < result->eventsReceived; i++)
+        sum += result->latency[i];
+
+    if (result->eventsReceived > 0) {
+        p99 = result->latency[(result->eventsReceived * 99) / 100];
+        max = result->latency[result->eventsReceived - 1];
+    }
+
+    printf("    {\"mode\": \"%s\", \"eventsCreated\": %i, \"eventsReceived\": %i, "
+           "\"meanLatencyMs\": %.1f, \"p99LatencyMs\": %llu, \"maxLatencyMs\": %llu}%s\n",
+           modeName, result->eventsCreated, result->eventsReceived,
+           (result->eventsReceived > 0) ? ((double) sum / result->eventsReceived) : 0.0,
+           (unsigned long long) p99, (unsigned long long) max, last ? "" : ",");
+}
+
+static void
+printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("  -n <number>   number of virtual slaves (default 100)\n");
+    printf("  -d <number>   number of configured slaves that do not respond (default 5)\n");
+    printf("  -t <seconds>  duration of each simulation run (default 20)\n");
+    printf("  -e <rate>     events per second for all slaves (default 5)\n");
+    printf("  -i <ms>       class 2 poll interval of each slave (default 1000)\n");
+    printf("  -s <seed>     seed of the random generator (default 1)\n");
+    printf("  -m <mode>     rr, prio or both (default both)\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    SimulationConfig config;
+
+    config.numberOfSlaves = 100;
+    config.numberOfDeadSlaves = 5;
+    config.durationInS = 20;
+    config.eventRate = 5;
+    config.class2PollInterval = 1000;
+    config.seed = 1;
+
+    bool runRoundRobin = true;
+    bool runPriority = true;
+
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if ((argv[i][0] != '-') || (i + 1 >= argc)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        const char* value = argv[++i];
+
+        switch (argv[i - 1][1]) {
+        case 'n':
+            config.numberOfSlaves = atoi(value);
+            break;
+        case 'd':
+            config.numberOfDeadSlaves = atoi(value);
+            break;
+        case 't':
+            config.durationInS = atoi(value);
+            break;
+        case 'e':
+            config.eventRate = atoi(value);
+            break;
+        case 'i':
+            config.class2PollInterval = atoi(value);
+            break;
+        case 's':
+            config.seed = (uint32_t) strtoul(value, NULL, 10);
+            break;
+        case 'm':
+            runRoundRobin = (strcmp(value, "prio") != 0);
+            runPriority = (strcmp(value, "rr") != 0);
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    /* only one byte link layer addresses are used by the bus emulator */
+    if ((config.numberOfSlaves < 1) || (config.numberOfDeadSlaves < 0) ||
+        (config.numberOfSlaves + config.numberOfDeadSlaves > 254) || (config.eventRate < 1) || (config.seed == 0)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    SimulationResult result;
+
+    result.eventTime = (uint64_t*) calloc(MAX_EVENTS, sizeof(uint64_t));
+    result.latency = (uint64_t*) calloc(MAX_EVENTS, sizeof(uint64_t));
+
+    printf("{\n  \"slaves\": %i,\n  \"deadSlaves\": %i,\n  \"durationS\": %i,\n  \"eventRate\": %i,\n"
+           "  \"class2PollIntervalMs\": %i,\n  \"results\": [\n",
+           config.numberOfSlaves, config.numberOfDeadSlaves, config.durationInS, config.eventRate,
+           config.class2PollInterval);
+
+    if (runRoundRobin) {
+        if (runSimulation(&config, CS101_POLL_MODE_ROUND_ROBIN, &result))
+            printResult("round-robin", &result, (runPriority == false));
+    }
+
+    if (runPriority) {
+        if (runSimulation(&config, CS101_POLL_MODE_PRIORITY, &result))
+            printResult("priority", &result, true);
+    }
+
+    printf("  ]\n}\n");
+
+    free(result.eventTime);
+    free(result.latency);
+
+    return 0;
+}
@@ -0,0 +1,552 @@
+/*
+ * cs104_connection_storm.c
+ *
+ * Connection storm benchmark for CS104_Slave (e.g. all clients reconnect at the same time after a
+ * control center failover). The tool starts a CS104_Slave on the loopback interface with multiple
+ * redundancy groups (mode CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS) and opens all client connections
+ * at once. Each client connects from its own loopback address (127.1.<group>.<n>) so the connections
+ * are distributed over the redundancy groups by the allowed client prefixes (127.1.<group>.0/24).
+ *
+ * A client is complete when the slave confirmed the STARTDT act message (STARTDT con). The clients
+ * are plain non-blocking sockets that are handled by a single poll loop - the slave has to accept,
+ * check and assign all connections.
+ *
+ * The storm is repeated for the following configurations:
+ *
+ * - threads:   one thread per connection (default), single server socket
+ * - workers:   worker threads (CS104_Slave_setWorkerThreads), single server socket
+ * - listeners: worker threads with own server socket (CS104_Slave_setListenerPerWorker)
+ *
+ * For every configuration the completion time of the storm (first connect to last STARTDT con)
+ * and the percentiles of the connection setup time per client are printed as JSON.
+ *
+ * The number of connections is limited by CONFIG_CS104_MAX_CLIENT_CONNECTIONS of the library
+ * (the slave refuses the other connections).
+ */
+
+#include "cs104_slave.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define MAX_CONNECTIONS 4096
+
+#define CLIENT_STATE_CONNECTING 0
+#define CLIENT_STATE_WAIT_FOR_STARTDT_CON 1
+#define CLIENT_STATE_DONE 2
+#define CLIENT_STATE_FAILED 3
+
+typedef enum {
+    CONFIGURATION_THREADS = 0,
+    CONFIGURATION_WORKERS = 1,
+    CONFIGURATION_LISTENERS = 2
+} Configuration;
+
+static const char* configurationNames[] = {"threads", "workers", "listeners"};
+
+typedef struct {
+    int fd;
+    int state;
+    uint64_t startTime;
+    uint64_t completionTime;
+    uint8_t receiveBuffer[6];
+    int received;
+} StormClient;
+
+typedef struct {
+    int connections;
+    int groups;
+    int workers;
+    int rounds;
+    int timeoutInMs;
+    int tcpPort;
+    const char* outputFile;
+} Options;
+
+typedef struct {
+    int connected;
+    int failed;
+    double completionTimeInMs;
+} RoundResult;
+
+static uint8_t STARTDT_ACT_MSG[] = {0x68, 0x04, 0x07, 0x00, 0x00, 0x00};
+
+/********************************************
+ * Helper functions
+ ********************************************/
+
+static uint64_t
+getTimeInUs(void)
+{
+    return Hal_getMonotonicTimeInNs() / 1000;
+}
+
+static int
+compareTimes(const void* a, const void* b)
+{
+    uint64_t timeA = *((const uint64_t*) a);
+    uint64_t timeB = *((const uint64_t*) b);
+
+    if (timeA < timeB)
+        return -1;
+    else if (timeA > timeB)
+        return 1;
+    else
+        return 0;
+}
+
+static uint64_t
+getPercentile(uint64_t* sortedTimes, int count, double percentile)
+{
+    if (count == 0)
+        return 0;
+
+    int index = (int) (percentile * count + 0.999999) - 1;
+
+    if (index < 0)
+        index = 0;
+
+    if (index >= count)
+        index = count - 1;
+
+    return sortedTimes[index];
+}
+
+/* local address of a client: 127.1.<group>.<n> (n = 1 .. 250) */
+static void
+getClientAddress(int client, int groups, struct sockaddr_in* address)
+{
+    int group = client % groups;
+    int host = (client / groups) % 250 + 1;
+
+    memset(address, 0, sizeof(struct sockaddr_in));
+
+    address->sin_family = AF_INET;
+    address->sin_port = 0;
+    address->sin_addr.s_addr = htonl((127u << 24) | (1u << 16) | ((uint32_t) group << 8) | (uint32_t) host);
+}
+
+/********************************************
+ * Clients
+ ********************************************/
+
+static bool
+startClient(StormClient* client, int index, Options* options)
+{
+    client->state = CLIENT_STATE_FAILED;
+    client->received = 0;
+    client->completionTime = 0;
+    client->startTime = getTimeInUs();
+
+    client->fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (client->fd == -1)
+        return false;
+
+    fcntl(client->fd, F_SETFL, fcntl(client->fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in localAddress;
+    getClientAddress(index, options->groups, &localAddress);
+
+    if (bind(client->fd, (struct sockaddr*) &localAddress, sizeof(localAddress)) == -1)
+        return false;
+
+    struct sockaddr_in serverAddress;
+    memset(&serverAddress, 0, sizeof(serverAddress));
+
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_port = htons(options->tcpPort);
+    serverAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(client->fd, (struct sockaddr*) &serverAddress, sizeof(serverAddress)) == -1) {
+        if (errno != EINPROGRESS)
+            return false;
+    }
+
+    client->state = CLIENT_STATE_CONNECTING;
+
+    return true;
+}
+
+static void
+handleClient(StormClient* client)
+{
+    if (client->state == CLIENT_STATE_CONNECTING) {
+        int error = 0;
+        socklen_t errorLen = sizeof(error);
+
+        if ((getsockopt(client->fd, SOL_SOCKET, SO_ERROR, &error, &errorLen) == -1) || (error != 0)) {
+            client->state = CLIENT_STATE_FAILED;
+            return;
+        }
+
+        if (write(client->fd, STARTDT_ACT_MSG, sizeof(STARTDT_ACT_MSG)) != sizeof(STARTDT_ACT_MSG)) {
+            client->state = CLIENT_STATE_FAILED;
+            return;
+        }
+
+        client->state = CLIENT_STATE_WAIT_FOR_STARTDT_CON;
+    }
+    else if (client->state == CLIENT_STATE_WAIT_FOR_STARTDT_CON) {
+        ssize_t result = read(client->fd, client->receiveBuffer + client->received,
+                sizeof(client->receiveBuffer) - client->received);
+
+        if (result <= 0) {
+            if ((result == -1) && (errno == EAGAIN))
+                return;
+
+            /* connection refused by the slave */
+            client->state = CLIENT_STATE_FAILED;
+            return;
+        }
+
+        client->received += (int) result;
+
+        if (client->received == (int) sizeof(client->receiveBuffer)) {
+            if ((client->receiveBuffer[0] == 0x68) && (client->receiveBuffer[2] == 0x0b)) {
+                client->completionTime = getTimeInUs();
+                client->state = CLIENT_STATE_DONE;
+            }
+            else
+                client->state = CLIENT_STATE_FAILED;
+        }
+    }
+}
+
+/* open all connections at once and wait until all are activated (or failed) */
+static void
+runStorm(Options* options, StormClient* clients, struct pollfd* pollFds, int* pollIndex, RoundResult* result)
+{
+    int i;
+
+    uint64_t startTime = getTimeInUs();
+
+    for (i = 0; i < options->connections; i++)
+        startClient(&(clients[i]), i, options);
+
+    uint64_t timeout = startTime + (uint64_t) options->timeoutInMs * 1000;
+
+    while (getTimeInUs() < timeout) {
+        int numberOfFds = 0;
+
+        for (i = 0; i < options->connections; i++) {
+            StormClient* client = &(clients[i]);
+
+            if ((client->state == CLIENT_STATE_CONNECTING) || (client->state == CLIENT_STATE_WAIT_FOR_STARTDT_CON)) {
+                pollFds[numberOfFds].fd = client->fd;
+                pollFds[numberOfFds].events = (client->state == CLIENT_STATE_CONNECTING) ? POLLOUT : POLLIN;
+                pollFds[numberOfFds].revents = 0;
+                pollIndex[numberOfFds] = i;
+                numberOfFds++;
+            }
+        }
+
+        if (numberOfFds == 0)
+            break;
+
+        if (poll(pollFds, numberOfFds, 10) > 0) {
+            for (i = 0; i < numberOfFds; i++) {
+                if (pollFds[i].revents)
+                    handleClient(&(clients[pollIndex[i]]));
+            }
+        }
+    }
+
+    uint64_t lastCompletionTime = startTime;
+
+    result->connected = 0;
+    result->failed = 0;
+
+    for (i = 0; i < options->connections; i++) {
+        if (clients[i].state == CLIENT_STATE_DONE) {
+            result->connected++;
+
+            if (clients[i].completionTime > lastCompletionTime)
+                lastCompletionTime = clients[i].completionTime;
+        }
+        else
+            result->failed++;
+    }
+
+    result->completionTimeInMs = (lastCompletionTime - startTime) / 1000.0;
+}
+
+static void
+closeClients(Options* options, StormClient* clients)
+{
+    int i;
+
+    for (i = 0; i < options->connections; i++) {
+        if (clients[i].fd != -1) {
+            close(clients[i].fd);
+            clients[i].fd = -1;
+        }
+    }
+}
+
+/********************************************
+ * Server
+ ********************************************/
+
+static CS104_Slave
+startServer(Options* options, Configuration configuration, int tcpPort)
+{
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    CS104_Slave_setLocalAddress(slave, "0.0.0.0");
+    CS104_Slave_setLocalPort(slave, tcpPort);
+    CS104_Slave_setServerMode(slave, CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS);
+
+    int i;
+
+    for (i = 0; i < options->groups; i++) {
+        char name[32];
+        char network[32];
+
+        snprintf(name, sizeof(name), "group%i", i);
+        snprintf(network, sizeof(network), "127.1.%i.0", i);
+
+        CS104_RedundancyGroup group = CS104_RedundancyGroup_create(name);
+
+        CS104_RedundancyGroup_addAllowedClientPrefix(group, network, 24);
+
+        CS104_Slave_addRedundancyGroup(slave, group);
+    }
+
+    /* all other clients */
+    CS104_Slave_addRedundancyGroup(slave, CS104_RedundancyGroup_create("catch-all"));
+
+    if (configuration != CONFIGURATION_THREADS)
+        CS104_Slave_setWorkerThreads(slave, options->workers);
+
+    if (configuration == CONFIGURATION_LISTENERS)
+        CS104_Slave_setListenerPerWorker(slave, true);
+
+    CS104_Slave_start(slave);
+
+    if (CS104_Slave_isRunning(slave) == false) {
+        CS104_Slave_destroy(slave);
+        return NULL;
+    }
+
+    return slave;
+}
+
+static bool
+runConfiguration(FILE* out, Options* options, Configuration configuration, int tcpPort)
+{
+    CS104_Slave slave = startServer(options, configuration, tcpPort);
+
+    if (slave == NULL) {
+        fprintf(stderr, "Failed to start server on port %i\n", tcpPort);
+        return false;
+    }
+
+    Options roundOptions = *options;
+    roundOptions.tcpPort = tcpPort;
+
+    StormClient* clients = (StormClient*) calloc(options->connections, sizeof(StormClient));
+    struct pollfd* pollFds = (struct pollfd*) calloc(options->connections, sizeof(struct pollfd));
+    int* pollIndex = (int*) calloc(options->connections, sizeof(int));
+    uint64_t* setupTimes = (uint64_t*) calloc((size_t) options->connections * options->rounds, sizeof(uint64_t));
+
+    int numberOfSetupTimes = 0;
+    int connected = 0;
+    int failed = 0;
+    double completionTimeSum = 0;
+    double maxCompletionTime = 0;
+
+    int round;
+
+    for (round = 0; round < options->rounds; round++) {
+        RoundResult result;
+
+        int i;
+
+        for (i = 0; i < options->connections; i++)
+            clients[i].fd = -1;
+
+        runStorm(&roundOptions, clients, pollFds, pollIndex, &result);
+
+        for (i = 0; i < options->connections; i++) {
+            if (clients[i].state == CLIENT_STATE_DONE)
+                setupTimes[numberOfSetupTimes++] = clients[i].completionTime - clients[i].startTime;
+        }
+
+        closeClients(options, clients);
+
+        connected += result.connected;
+        failed += result.failed;
+        completionTimeSum += result.completionTimeInMs;
+
+        if (result.completionTimeInMs > maxCompletionTime)
+            maxCompletionTime = result.completionTimeInMs;
+
+        /* wait until the slave released the connections */
+        uint64_t timeout = Hal_getMonotonicTimeInMs() + 5000;
+
+        while ((CS104_Slave_getOpenConnections(slave) > 0) && (Hal_getMonotonicTimeInMs() < timeout))
+            Thread_sleep(10);
+    }
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    qsort(setupTimes, numberOfSetupTimes, sizeof(uint64_t), compareTimes);
+
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"configuration\": \"%s\",\n", configurationNames[configuration]);
+    fprintf(out, "      \"workers\": %i,\n", (configuration == CONFIGURATION_THREADS) ? 0 : options->workers);
+    fprintf(out, "      \"connected\": %i,\n", connected);
+    fprintf(out, "      \"failed\": %i,\n", failed);
+    fprintf(out, "      \"completion_ms\": {\n");
+    fprintf(out, "        \"mean\": %.2f,\n", completionTimeSum / options->rounds);
+    fprintf(out, "        \"max\": %.2f\n", maxCompletionTime);
+    fprintf(out, "      },\n");
+    fprintf(out, "      \"setup_us\": {\n");
+    fprintf(out, "        \"p50\": %llu,\n", (unsigned long long) getPercentile(setupTimes, numberOfSetupTimes, 0.5));
+    fprintf(out, "        \"p90\": %llu,\n", (unsigned long long) getPercentile(setupTimes, numberOfSetupTimes, 0.9));
+    fprintf(out, "        \"p99\": %llu,\n", (unsigned long long) getPercentile(setupTimes, numberOfSetupTimes, 0.99));
+    fprintf(out, "        \"max\": %llu\n", (unsigned long long) getPercentile(setupTimes, numberOfSetupTimes, 1.0));
+    fprintf(out, "      }\n");
+    fprintf(out, "    }");
+
+    free(setupTimes);
+    free(pollIndex);
+    free(pollFds);
+    free(clients);
+
+    return true;
+}
+
+/********************************************
+ * Main
+ ********************************************/
+
+static void
+printUsage(void)
+{
+    printf("Usage: cs104_connection_storm [options]\n\n");
+    printf("  -n <count>      number of client connections (default: 100)\n");
+    printf("  -g <count>      number of redundancy groups (default: 8)\n");
+    printf("  -w <count>      number of worker threads (default: 4)\n");
+    printf("  -r <count>      number of storms per configuration (default: 5)\n");
+    printf("  -t <ms>         timeout of a storm (default: 10000)\n");
+    printf("  -p <port>       first TCP port (default: 24404)\n");
+    printf("  -o <file>       write the JSON results to file (default: stdout)\n");
+}
+
+static bool
+parseOptions(Options* options, int argc, char** argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        const char* option = argv[i];
+
+        if (strcmp(option, "-h") == 0)
+            return false;
+
+        if (i + 1 >= argc)
+            return false;
+
+        char* value = argv[++i];
+
+        if (strcmp(option, "-n") == 0)
+            options->connections = atoi(value);
+        else if (strcmp(option, "-g") == 0)
+            options->groups = atoi(value);
+        else if (strcmp(option, "-w") == 0)
+            options->workers = atoi(value);
+        else if (strcmp(option, "-r") == 0)
+            options->rounds = atoi(value);
+        else if (strcmp(option, "-t") == 0)
+            options->timeoutInMs = atoi(value);
+        else if (strcmp(option, "-p") == 0)
+            options->tcpPort = atoi(value);
+        else if (strcmp(option, "-o") == 0)
+            options->outputFile = value;
+        else
+            return false;
+    }
+
+    if ((options->connections < 1) || (options->connections > MAX_CONNECTIONS) || (options->groups < 1) ||
+            (options->groups > 255) || (options->workers < 1) || (options->rounds < 1) || (options->timeoutInMs < 1))
+        return false;
+
+    return true;
+}
+
+int
+main(int argc, char** argv)
+{
+    Options options;
+
+    options.connections = 100;
+    options.groups = 8;
+    options.workers = 4;
+    options.rounds = 5;
+    options.timeoutInMs = 10000;
+    options.tcpPort = 24404;
+    options.outputFile = NULL;
+
+    if (parseOptions(&options, argc, argv) == false) {
+        printUsage();
+        return 1;
+    }
+
+    FILE* out = stdout;
+
+    if (options.outputFile) {
+        out = fopen(options.outputFile, "w");
+
+        if (out == NULL) {
+            fprintf(stderr, "Failed to create output file %s\n", options.outputFile);
+            return 1;
+        }
+    }
+
+    int retVal = 0;
+    int tcpPort = options.tcpPort;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"cs104_connection_storm\",\n");
+    fprintf(out, "  \"cpus\": %li,\n", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(out, "  \"connections\": %i,\n", options.connections);
+    fprintf(out, "  \"groups\": %i,\n", options.groups);
+    fprintf(out, "  \"rounds\": %i,\n", options.rounds);
+    fprintf(out, "  \"results\": [\n");
+
+    int c;
+
+    for (c = CONFIGURATION_THREADS; c <= CONFIGURATION_LISTENERS; c++) {
+        if (c > CONFIGURATION_THREADS)
+            fprintf(out, ",\n");
+
+        if (runConfiguration(out, &options, (Configuration) c, tcpPort) == false) {
+            retVal = 1;
+            break;
+        }
+
+        /* avoid TIME_WAIT conflicts with the next server instance */
+        tcpPort++;
+    }
+
+    fprintf(out, "\n  ]\n");
+    fprintf(out, "}\n");
+
+    if (out != stdout)
+        fclose(out);
+
+    return retVal;
+}
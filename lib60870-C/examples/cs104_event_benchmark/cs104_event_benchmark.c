@@ -0,0 +1,702 @@
+/*
+ * cs104_event_benchmark.c
+ *
+ * Spontaneous event fan-out benchmark for CS104_Slave. For each server mode (single redundancy
+ * group, multiple redundancy groups, connection is redundancy group) and each number of client
+ * connections the tool starts a CS104_Slave on the loopback interface, connects the clients and
+ * enqueues events (CS104_Slave_enqueueASDU) at increasing rates.
+ *
+ * For every step the sustained event rate, the CPU time per delivered event, the memory per
+ * connection and the enqueue-to-receive latency percentiles are printed as JSON. Each combination
+ * of server mode and number of connections runs in its own process (fork) so that the memory
+ * measurement is not affected by previous runs. The clients run in the same process as the
+ * server - CPU time and memory include the client side.
+ *
+ * In the multiple redundancy groups mode every client has its own redundancy group (clients
+ * are distinguished by their local address 127.1.x.y). In the single redundancy group mode only
+ * one client is active and receives the events.
+ *
+ * The number of connections is limited by CONFIG_CS104_MAX_CLIENT_CONNECTIONS of the library.
+ */
+
+#include "cs104_connection.h"
+#include "cs104_slave.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_STEPS 32
+
+/* log-linear latency histogram: 16 buckets per power of two (about 6% resolution) */
+#define HISTOGRAM_SUB_BUCKETS 16
+#define HISTOGRAM_BUCKETS (29 * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    int index;
+
+    CS104_Connection connection;
+
+    Semaphore lock;
+
+    uint64_t eventsReceived;
+    uint64_t latencyHistogram[HISTOGRAM_BUCKETS];
+} BenchmarkClient;
+
+typedef struct {
+    const char* modes;
+    int connectionCounts[MAX_STEPS];
+    int numberOfConnectionCounts;
+    int eventRates[MAX_STEPS];
+    int numberOfEventRates;
+    int stepDurationInMs;
+    int tcpPort;
+    int queueSize;
+    const char* outputFile;
+} Options;
+
+typedef struct {
+    const char* mode;
+    int connections;
+    int connected;
+    int offeredRate;
+    uint64_t eventsSent;
+    int receivers;
+    uint64_t eventsDelivered;
+    double durationInS;
+    double deliveredRate;
+    double cpuPerEventInUs;
+    double memoryInKb; /* memory of the server and the clients */
+    double memoryPerConnectionInKb;
+    uint64_t latencyHistogram[HISTOGRAM_BUCKETS];
+    bool saturated;
+} StepResult;
+
+static bool firstResult = true;
+
+/********************************************
+ * Helper functions
+ ********************************************/
+
+static uint32_t
+getTimeInUs(void)
+{
+    return (uint32_t) (Hal_getMonotonicTimeInNs() / 1000);
+}
+
+static int
+getHistogramIndex(uint32_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return (int) value;
+
+    int msb = 0;
+    uint32_t v = value;
+
+    while (v > 1) {
+        v = v >> 1;
+        msb++;
+    }
+
+    int index = (msb - 3) * HISTOGRAM_SUB_BUCKETS + (int) ((value >> (msb - 4)) & (HISTOGRAM_SUB_BUCKETS - 1));
+
+    if (index >= HISTOGRAM_BUCKETS)
+        index = HISTOGRAM_BUCKETS - 1;
+
+    return index;
+}
+
+static uint64_t
+getHistogramValue(int index)
+{
+    if (index < HISTOGRAM_SUB_BUCKETS)
+        return (uint64_t) index;
+
+    int msb = index / HISTOGRAM_SUB_BUCKETS + 3;
+    int sub = index % HISTOGRAM_SUB_BUCKETS;
+
+    return ((uint64_t) (HISTOGRAM_SUB_BUCKETS + sub)) << (msb - 4);
+}
+
+static uint64_t
+getPercentile(uint64_t* histogram, double percentile)
+{
+    uint64_t count = 0;
+    int i;
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+        count += histogram[i];
+
+    if (count == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t) (percentile * count + 0.999999);
+
+    if (rank < 1)
+        rank = 1;
+
+    uint64_t sum = 0;
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        sum += histogram[i];
+
+        if (sum >= rank)
+            return getHistogramValue(i);
+    }
+
+    return getHistogramValue(HISTOGRAM_BUCKETS - 1);
+}
+
+static double
+getCpuTimeInUs(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000.0 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static double
+getResidentMemoryInKb(void)
+{
+    FILE* statm = fopen("/proc/self/statm", "r");
+
+    if (statm == NULL)
+        return 0;
+
+    unsigned long size = 0;
+    unsigned long resident = 0;
+
+    if (fscanf(statm, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+
+    fclose(statm);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024.0);
+}
+
+static void
+getClientAddress(int index, char* buffer)
+{
+    sprintf(buffer, "127.1.%i.%i", index / 250, (index % 250) + 1);
+}
+
+/********************************************
+ * Client
+ ********************************************/
+
+static bool
+asduReceivedHandler (void* parameter, int address, CS101_ASDU asdu)
+{
+    BenchmarkClient* self = (BenchmarkClient*) parameter;
+
+    (void) address;
+
+    if ((CS101_ASDU_getTypeID(asdu) != M_BO_NA_1) || (CS101_ASDU_getCOT(asdu) != CS101_COT_SPONTANEOUS))
+        return true;
+
+    uint32_t receiveTime = getTimeInUs();
+
+    int i;
+
+    Semaphore_wait(self->lock);
+
+    for (i = 0; i < CS101_ASDU_getNumberOfElements(asdu); i++) {
+        uint8_t ioBuf[250];
+
+        BitString32 bs = (BitString32) CS101_ASDU_getElementEx(asdu, (InformationObject) ioBuf, i);
+
+        /* the value is the enqueue time in us (wraps around after ~71 minutes) */
+        uint32_t latency = receiveTime - BitString32_getValue(bs);
+
+        self->latencyHistogram[getHistogramIndex(latency)]++;
+        self->eventsReceived++;
+    }
+
+    Semaphore_post(self->lock);
+
+    return true;
+}
+
+static void
+resetClientStatistics(BenchmarkClient* clients, int numberOfClients)
+{
+    int i;
+
+    for (i = 0; i < numberOfClients; i++) {
+        Semaphore_wait(clients[i].lock);
+
+        clients[i].eventsReceived = 0;
+        memset(clients[i].latencyHistogram, 0, sizeof(clients[i].latencyHistogram));
+
+        Semaphore_post(clients[i].lock);
+    }
+}
+
+static uint64_t
+getEventsReceived(BenchmarkClient* clients, int numberOfClients)
+{
+    uint64_t eventsReceived = 0;
+    int i;
+
+    for (i = 0; i < numberOfClients; i++) {
+        Semaphore_wait(clients[i].lock);
+        eventsReceived += clients[i].eventsReceived;
+        Semaphore_post(clients[i].lock);
+    }
+
+    return eventsReceived;
+}
+
+/********************************************
+ * Benchmark steps
+ ********************************************/
+
+static CS104_Slave
+startServer(Options* options, CS104_ServerMode serverMode, int numberOfConnections, int tcpPort)
+{
+    CS104_Slave slave = CS104_Slave_create(options->queueSize, 100);
+
+    CS104_Slave_setLocalAddress(slave, "0.0.0.0");
+    CS104_Slave_setLocalPort(slave, tcpPort);
+    CS104_Slave_setServerMode(slave, serverMode);
+    CS104_Slave_setMaxOpenConnections(slave, numberOfConnections);
+
+    if (serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS) {
+        int i;
+
+        for (i = 0; i < numberOfConnections; i++) {
+            char name[32];
+            char address[32];
+
+            sprintf(name, "group%i", i);
+            getClientAddress(i, address);
+
+            CS104_RedundancyGroup group = CS104_RedundancyGroup_create(name);
+
+            CS104_RedundancyGroup_addAllowedClient(group, address);
+
+            CS104_Slave_addRedundancyGroup(slave, group);
+        }
+    }
+
+    CS104_Slave_start(slave);
+
+    if (CS104_Slave_isRunning(slave) == false) {
+        CS104_Slave_destroy(slave);
+        return NULL;
+    }
+
+    return slave;
+}
+
+static void
+runStep(CS104_Slave slave, BenchmarkClient* clients, int numberOfClients, int eventRate, Options* options,
+        StepResult* result)
+{
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    resetClientStatistics(clients, numberOfClients);
+
+    double cpuStart = getCpuTimeInUs();
+    uint64_t startTime = Hal_getMonotonicTimeInNs();
+    uint64_t sendEndTime = startTime + (uint64_t) options->stepDurationInMs * 1000000;
+
+    uint64_t eventsSent = 0;
+
+    sCS101_StaticASDU asduBuffer;
+    uint8_t ioBuf[250];
+
+    uint64_t currentTime = startTime;
+
+    while (currentTime < sendEndTime) {
+        uint64_t eventsDue = (uint64_t) ((currentTime - startTime) / 1000000000.0 * eventRate);
+
+        while (eventsSent < eventsDue) {
+            CS101_ASDU asdu = CS101_ASDU_initializeStatic(&asduBuffer, alParams, false, CS101_COT_SPONTANEOUS, 0, 1,
+                    false, false);
+
+            InformationObject io = (InformationObject) BitString32_create((BitString32) ioBuf,
+                    (int) (eventsSent % 1000) + 1, getTimeInUs());
+
+            CS101_ASDU_addInformationObject(asdu, io);
+
+            CS104_Slave_enqueueASDU(slave, asdu);
+
+            eventsSent++;
+        }
+
+        Thread_sleep(1);
+
+        currentTime = Hal_getMonotonicTimeInNs();
+    }
+
+    /* wait until the queues are drained (no progress for 200 ms) */
+    uint64_t lastEventsReceived = getEventsReceived(clients, numberOfClients);
+    uint64_t lastProgressTime = Hal_getMonotonicTimeInNs();
+    uint64_t drainEndTime = lastProgressTime;
+
+    while (Hal_getMonotonicTimeInNs() < lastProgressTime + 200000000) {
+        Thread_sleep(10);
+
+        uint64_t eventsReceived = getEventsReceived(clients, numberOfClients);
+
+        if (eventsReceived != lastEventsReceived) {
+            lastEventsReceived = eventsReceived;
+            lastProgressTime = Hal_getMonotonicTimeInNs();
+            drainEndTime = lastProgressTime;
+        }
+    }
+
+    double cpuTime = getCpuTimeInUs() - cpuStart;
+
+    result->offeredRate = eventRate;
+    result->eventsSent = eventsSent;
+    result->eventsDelivered = 0;
+    result->receivers = 0;
+    result->durationInS = (drainEndTime - startTime) / 1000000000.0;
+    memset(result->latencyHistogram, 0, sizeof(result->latencyHistogram));
+
+    int i;
+
+    for (i = 0; i < numberOfClients; i++) {
+        Semaphore_wait(clients[i].lock);
+
+        if (clients[i].eventsReceived > 0)
+            result->receivers++;
+
+        result->eventsDelivered += clients[i].eventsReceived;
+
+        int j;
+
+        for (j = 0; j < HISTOGRAM_BUCKETS; j++)
+            result->latencyHistogram[j] += clients[i].latencyHistogram[j];
+
+        Semaphore_post(clients[i].lock);
+    }
+
+    if (result->durationInS > 0)
+        result->deliveredRate = result->eventsDelivered / result->durationInS;
+    else
+        result->deliveredRate = 0;
+
+    if (result->eventsDelivered > 0)
+        result->cpuPerEventInUs = cpuTime / result->eventsDelivered;
+    else
+        result->cpuPerEventInUs = 0;
+
+    /* saturated when less than 95% of the events arrive at the active clients or the sending took much longer */
+    uint64_t expected = eventsSent * (result->receivers > 0 ? result->receivers : 1);
+
+    result->saturated = (result->eventsDelivered * 100 < expected * 95) ||
+            (result->durationInS > 2.0 * options->stepDurationInMs / 1000.0);
+}
+
+static void
+writeResult(FILE* out, StepResult* result)
+{
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"mode\": \"%s\",\n", result->mode);
+    fprintf(out, "      \"connections\": %i,\n", result->connections);
+    fprintf(out, "      \"connected\": %i,\n", result->connected);
+    fprintf(out, "      \"offered_rate\": %i,\n", result->offeredRate);
+    fprintf(out, "      \"events_sent\": %llu,\n", (unsigned long long) result->eventsSent);
+    fprintf(out, "      \"receivers\": %i,\n", result->receivers);
+    fprintf(out, "      \"events_delivered\": %llu,\n", (unsigned long long) result->eventsDelivered);
+    fprintf(out, "      \"duration_s\": %.3f,\n", result->durationInS);
+    fprintf(out, "      \"delivered_rate\": %.1f,\n", result->deliveredRate);
+    fprintf(out, "      \"cpu_us_per_event\": %.3f,\n", result->cpuPerEventInUs);
+    fprintf(out, "      \"memory_kb\": %.1f,\n", result->memoryInKb);
+    fprintf(out, "      \"memory_kb_per_connection\": %.1f,\n", result->memoryPerConnectionInKb);
+    fprintf(out, "      \"saturated\": %s,\n", result->saturated ? "true" : "false");
+    fprintf(out, "      \"latency_us\": {\n");
+    fprintf(out, "        \"p50\": %llu,\n", (unsigned long long) getPercentile(result->latencyHistogram, 0.5));
+    fprintf(out, "        \"p90\": %llu,\n", (unsigned long long) getPercentile(result->latencyHistogram, 0.9));
+    fprintf(out, "        \"p99\": %llu,\n", (unsigned long long) getPercentile(result->latencyHistogram, 0.99));
+    fprintf(out, "        \"p999\": %llu,\n", (unsigned long long) getPercentile(result->latencyHistogram, 0.999));
+    fprintf(out, "        \"max\": %llu\n", (unsigned long long) getPercentile(result->latencyHistogram, 1.0));
+    fprintf(out, "      }\n");
+    fprintf(out, "    }");
+
+    fflush(out);
+}
+
+/* runs the steps of one configuration and returns the number of results written (-1 on error) */
+static int
+runConfiguration(FILE* out, Options* options, const char* modeName, CS104_ServerMode serverMode,
+                 int numberOfConnections, int tcpPort)
+{
+    int resultCount = 0;
+
+    double memoryBefore = getResidentMemoryInKb();
+
+    CS104_Slave slave = startServer(options, serverMode, numberOfConnections, tcpPort);
+
+    if (slave == NULL) {
+        fprintf(stderr, "Failed to start server on port %i\n", tcpPort);
+        return -1;
+    }
+
+    BenchmarkClient* clients = (BenchmarkClient*) calloc(numberOfConnections, sizeof(BenchmarkClient));
+
+    int connected = 0;
+    int i;
+
+    for (i = 0; i < numberOfConnections; i++) {
+        BenchmarkClient* client = &(clients[i]);
+
+        client->index = i;
+        client->lock = Semaphore_create(1);
+        client->connection = CS104_Connection_create("127.0.0.1", tcpPort);
+
+        if (serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS) {
+            char address[32];
+
+            getClientAddress(i, address);
+
+            CS104_Connection_setLocalAddress(client->connection, address, 0);
+        }
+
+        CS104_Connection_setASDUReceivedHandler(client->connection, asduReceivedHandler, client);
+
+        if (CS104_Connection_connect(client->connection)) {
+            CS104_Connection_sendStartDT(client->connection);
+            connected++;
+        }
+    }
+
+    /* wait until the STARTDT messages are handled */
+    Thread_sleep(500);
+
+    double memory = getResidentMemoryInKb() - memoryBefore;
+
+    int r;
+
+    for (r = 0; r < options->numberOfEventRates; r++) {
+        StepResult result;
+
+        result.mode = modeName;
+        result.connections = numberOfConnections;
+        result.connected = connected;
+        result.memoryInKb = memory;
+        result.memoryPerConnectionInKb = (connected > 0) ? (memory / connected) : 0;
+
+        runStep(slave, clients, numberOfConnections, options->eventRates[r], options, &result);
+
+        if ((resultCount > 0) || (firstResult == false))
+            fprintf(out, ",\n");
+
+        writeResult(out, &result);
+
+        resultCount++;
+
+        /* higher rates are not sustainable either */
+        if (result.saturated)
+            break;
+    }
+
+    for (i = 0; i < numberOfConnections; i++) {
+        CS104_Connection_destroy(clients[i].connection);
+        Semaphore_destroy(clients[i].lock);
+    }
+
+    free(clients);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    return resultCount;
+}
+
+static bool
+runMode(FILE* out, Options* options, const char* modeName, CS104_ServerMode serverMode, int* tcpPort)
+{
+    int c;
+
+    for (c = 0; c < options->numberOfConnectionCounts; c++) {
+        fflush(out);
+
+        pid_t pid = fork();
+
+        if (pid == 0) {
+            int resultCount = runConfiguration(out, options, modeName, serverMode, options->connectionCounts[c], *tcpPort);
+
+            fflush(out);
+
+            _exit(resultCount < 0 ? 255 : resultCount);
+        }
+
+        if (pid < 0) {
+            fprintf(stderr, "Failed to start benchmark process\n");
+            return false;
+        }
+
+        int status = 0;
+
+        if ((waitpid(pid, &status, 0) != pid) || (WIFEXITED(status) == false) || (WEXITSTATUS(status) == 255))
+            return false;
+
+        if (WEXITSTATUS(status) > 0)
+            firstResult = false;
+
+        /* avoid TIME_WAIT conflicts with the next server instance */
+        (*tcpPort)++;
+    }
+
+    return true;
+}
+
+/********************************************
+ * Main
+ ********************************************/
+
+static void
+printUsage(void)
+{
+    printf("Usage: cs104_event_benchmark [options]\n\n");
+    printf("  -m <modes>      server modes: single,multi,connection (default: all)\n");
+    printf("  -n <counts>     numbers of client connections, e.g. 1,10,100 (default)\n");
+    printf("  -r <rates>      event rates in events/s, e.g. 1000,10000,50000,100000 (default)\n");
+    printf("  -t <ms>         duration of a step (default: 2000)\n");
+    printf("  -q <size>       event queue size of the server (default: 10000)\n");
+    printf("  -p <port>       first TCP port (default: 22404)\n");
+    printf("  -o <file>       write the JSON results to file (default: stdout)\n");
+}
+
+static int
+parseList(char* list, int* values)
+{
+    int count = 0;
+
+    char* token = strtok(list, ",");
+
+    while (token && (count < MAX_STEPS)) {
+        values[count] = atoi(token);
+
+        if (values[count] < 1)
+            return 0;
+
+        count++;
+
+        token = strtok(NULL, ",");
+    }
+
+    return count;
+}
+
+static bool
+parseOptions(Options* options, int argc, char** argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        const char* option = argv[i];
+
+        if (strcmp(option, "-h") == 0)
+            return false;
+
+        if (i + 1 >= argc)
+            return false;
+
+        char* value = argv[++i];
+
+        if (strcmp(option, "-m") == 0)
+            options->modes = value;
+        else if (strcmp(option, "-n") == 0)
+            options->numberOfConnectionCounts = parseList(value, options->connectionCounts);
+        else if (strcmp(option, "-r") == 0)
+            options->numberOfEventRates = parseList(value, options->eventRates);
+        else if (strcmp(option, "-t") == 0)
+            options->stepDurationInMs = atoi(value);
+        else if (strcmp(option, "-q") == 0)
+            options->queueSize = atoi(value);
+        else if (strcmp(option, "-p") == 0)
+            options->tcpPort = atoi(value);
+        else if (strcmp(option, "-o") == 0)
+            options->outputFile = value;
+        else
+            return false;
+    }
+
+    if ((options->numberOfConnectionCounts < 1) || (options->numberOfEventRates < 1) ||
+            (options->stepDurationInMs < 1) || (options->queueSize < 1))
+        return false;
+
+    return true;
+}
+
+int
+main(int argc, char** argv)
+{
+    Options options;
+
+    options.modes = "single,multi,connection";
+    options.connectionCounts[0] = 1;
+    options.connectionCounts[1] = 10;
+    options.connectionCounts[2] = 100;
+    options.numberOfConnectionCounts = 3;
+    options.eventRates[0] = 1000;
+    options.eventRates[1] = 10000;
+    options.eventRates[2] = 50000;
+    options.eventRates[3] = 100000;
+    options.numberOfEventRates = 4;
+    options.stepDurationInMs = 2000;
+    options.queueSize = 10000;
+    options.tcpPort = 22404;
+    options.outputFile = NULL;
+
+    if (parseOptions(&options, argc, argv) == false) {
+        printUsage();
+        return 1;
+    }
+
+    FILE* out = stdout;
+
+    if (options.outputFile) {
+        out = fopen(options.outputFile, "w");
+
+        if (out == NULL) {
+            fprintf(stderr, "Failed to create output file %s\n", options.outputFile);
+            return 1;
+        }
+    }
+
+    int retVal = 0;
+    int tcpPort = options.tcpPort;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"cs104_event_benchmark\",\n");
+    fprintf(out, "  \"step_duration_ms\": %i,\n", options.stepDurationInMs);
+    fprintf(out, "  \"queue_size\": %i,\n", options.queueSize);
+    fprintf(out, "  \"results\": [\n");
+
+    if (strstr(options.modes, "single")) {
+        if (runMode(out, &options, "single", CS104_MODE_SINGLE_REDUNDANCY_GROUP, &tcpPort) == false)
+            retVal = 1;
+    }
+
+    if ((retVal == 0) && strstr(options.modes, "multi")) {
+        if (runMode(out, &options, "multi", CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS, &tcpPort) == false)
+            retVal = 1;
+    }
+
+    if ((retVal == 0) && strstr(options.modes, "connection")) {
+        if (runMode(out, &options, "connection", CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP, &tcpPort) == false)
+            retVal = 1;
+    }
+
+    fprintf(out, "\n  ]\n");
+    fprintf(out, "}\n");
+
+    if (out != stdout)
+        fclose(out);
+
+    return retVal;
+}
@@ -0,0 +1,251 @@
+/*
+ * cs104_fanout_benchmark.c
+ *
+ * Benchmark for the command fan-out. The tool starts many CS104_Slave instances (stations) on the
+ * loopback interface and connects to each station. A station interrogation is then sent to all
+ * stations with a CS101_CommandFanOut using the configured concurrency and pacing.
+ *
+ * The results (aggregate completion time and per station time) are printed as JSON.
+ */
+
+#include "cs104_connection.h"
+#include "cs104_slave.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ELEMENTS_PER_ASDU 30
+
+typedef struct {
+    int numberOfStations;
+    int basePort;
+    int numberOfPoints; /* data points of each station */
+    int concurrency;    /* 0 = unlimited */
+    int pacing;         /* ms */
+    int timeout;        /* ms */
+} BenchmarkConfig;
+
+static BenchmarkConfig config;
+
+static Semaphore statisticsLock;
+static uint64_t asdusReceived = 0;
+
+static bool
+interrogationHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, uint8_t qoi)
+{
+    (void) parameter;
+
+    if (qoi != IEC60870_QOI_STATION) {
+        IMasterConnection_sendACT_CON(connection, asdu, true);
+        return true;
+    }
+
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+
+    CS101_AppLayerParameters alParams = IMasterConnection_getApplicationLayerParameters(connection);
+
+    int ca = CS101_ASDU_getCA(asdu);
+    int ioa = 1;
+
+    while (ioa <= config.numberOfPoints) {
+        CS101_ASDU response = CS101_ASDU_create(alParams, false, CS101_COT_INTERROGATED_BY_STATION, 0, ca, false,
+                false);
+
+        int i;
+
+        for (i = 0; (i < MAX_ELEMENTS_PER_ASDU) && (ioa <= config.numberOfPoints); i++) {
+            InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, ioa, ioa,
+                    IEC60870_QUALITY_GOOD);
+
+            CS101_ASDU_addInformationObject(response, io);
+
+            InformationObject_destroy(io);
+
+            ioa++;
+        }
+
+        IMasterConnection_sendASDU(connection, response);
+
+        CS101_ASDU_destroy(response);
+    }
+
+    IMasterConnection_sendACT_TERM(connection, asdu);
+
+    return true;
+}
+
+static bool
+asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    (void) parameter;
+    (void) address;
+    (void) asdu;
+
+    Semaphore_wait(statisticsLock);
+    asdusReceived++;
+    Semaphore_post(statisticsLock);
+
+    return true;
+}
+
+static void
+printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("  -n <number>   number of stations (default 50)\n");
+    printf("  -P <port>     TCP port of the first station (default 22404)\n");
+    printf("  -d <number>   data points of each station (default 300)\n");
+    printf("  -c <number>   maximum number of outstanding interrogations (default 0 = unlimited)\n");
+    printf("  -p <ms>       minimum interval between two interrogation commands (default 0)\n");
+    printf("  -T <ms>       timeout of a station (default 30000)\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    config.numberOfStations = 50;
+    config.basePort = 22404;
+    config.numberOfPoints = 300;
+    config.concurrency = 0;
+    config.pacing = 0;
+    config.timeout = 30000;
+
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if ((argv[i][0] != '-') || (i + 1 >= argc)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        const char* value = argv[++i];
+
+        switch (argv[i - 1][1]) {
+        case 'n':
+            config.numberOfStations = atoi(value);
+            break;
+        case 'P':
+            config.basePort = atoi(value);
+            break;
+        case 'd':
+            config.numberOfPoints = atoi(value);
+            break;
+        case 'c':
+            config.concurrency = atoi(value);
+            break;
+        case 'p':
+            config.pacing = atoi(value);
+            break;
+        case 'T':
+            config.timeout = atoi(value);
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((config.numberOfStations < 1) || (config.numberOfPoints < 0)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    int numberOfStations = config.numberOfStations;
+
+    statisticsLock = Semaphore_create(1);
+
+    CS104_Slave* stations = (CS104_Slave*) calloc(numberOfStations, sizeof(CS104_Slave));
+    CS104_Connection* connections = (CS104_Connection*) calloc(numberOfStations, sizeof(CS104_Connection));
+
+    for (i = 0; i < numberOfStations; i++) {
+        stations[i] = CS104_Slave_create(100, 100);
+
+        CS104_Slave_setLocalAddress(stations[i], "127.0.0.1");
+        CS104_Slave_setLocalPort(stations[i], config.basePort + i);
+        CS104_Slave_setInterrogationHandler(stations[i], interrogationHandler, NULL);
+
+        CS104_Slave_start(stations[i]);
+
+        if (CS104_Slave_isRunning(stations[i]) == false) {
+            printf("Failed to start station %i (port %i)\n", i + 1, config.basePort + i);
+            return 1;
+        }
+    }
+
+    CS101_CommandFanOut fanOut = CS101_CommandFanOut_create();
+
+    CS101_CommandFanOut_setInterrogationCommand(fanOut, IEC60870_QOI_STATION);
+    CS101_CommandFanOut_setConcurrency(fanOut, config.concurrency);
+    CS101_CommandFanOut_setPacing(fanOut, config.pacing);
+    CS101_CommandFanOut_setTimeout(fanOut, config.timeout);
+
+    for (i = 0; i < numberOfStations; i++) {
+        connections[i] = CS104_Connection_create("127.0.0.1", config.basePort + i);
+
+        CS104_Connection_setASDUReceivedHandler(connections[i], asduReceivedHandler, NULL);
+        CS104_Connection_setCommandFanOut(connections[i], fanOut);
+
+        if (CS104_Connection_connect(connections[i]) == false) {
+            printf("Failed to connect to station %i\n", i + 1);
+            return 1;
+        }
+
+        CS104_Connection_sendStartDT(connections[i]);
+
+        CS101_CommandFanOut_addCS104Target(fanOut, connections[i], i + 1);
+    }
+
+    /* wait until all STARTDT are confirmed */
+    Thread_sleep(500);
+
+    CS101_CommandFanOut_start(fanOut);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    while (CS101_CommandFanOut_run(fanOut) == false)
+        Thread_sleep(1);
+
+    uint64_t duration = Hal_getMonotonicTimeInMs() - startTime;
+
+    CS101_FanOutResult result;
+
+    CS101_CommandFanOut_getResult(fanOut, &result);
+
+    printf("{\n");
+    printf("  \"stations\": %i,\n", numberOfStations);
+    printf("  \"pointsPerStation\": %i,\n", config.numberOfPoints);
+    printf("  \"concurrency\": %i,\n", config.concurrency);
+    printf("  \"pacingMs\": %i,\n", config.pacing);
+    printf("  \"completed\": %i,\n", result.completed);
+    printf("  \"negative\": %i,\n", result.negative);
+    printf("  \"timedOut\": %i,\n", result.timedOut);
+    printf("  \"commandsSent\": %i,\n", result.commandsSent);
+    printf("  \"asdusReceived\": %llu,\n", (unsigned long long) asdusReceived);
+    printf("  \"completionTimeMs\": %i,\n", result.completionTimeMs);
+    printf("  \"durationMs\": %llu,\n", (unsigned long long) duration);
+    printf("  \"meanStationTimeMs\": %i,\n", result.meanTargetTimeMs);
+    printf("  \"maxStationTimeMs\": %i\n", result.maxTargetTimeMs);
+    printf("}\n");
+
+    for (i = 0; i < numberOfStations; i++) {
+        CS104_Connection_setCommandFanOut(connections[i], NULL);
+        CS104_Connection_destroy(connections[i]);
+    }
+
+    CS101_CommandFanOut_destroy(fanOut);
+
+    for (i = 0; i < numberOfStations; i++) {
+        CS104_Slave_stop(stations[i]);
+        CS104_Slave_destroy(stations[i]);
+    }
+
+    free(connections);
+    free(stations);
+
+    Semaphore_destroy(statisticsLock);
+
+    return 0;
+}
@@ -0,0 +1,1016 @@
+/*
+ * cs104_loadgen.c
+ *
+ * Load generator for CS 104 servers. Opens multiple client connections to a server on the
+ * loopback interface and sends a scripted mix of interrogation, read and control commands
+ * at a fixed rate. Alternatively a recorded message stream (capture file) is replayed.
+ *
+ * The tool starts its own CS104_Slave by default. The results (throughput and response
+ * latency percentiles) are printed as JSON.
+ */
+
+#include "cs104_connection.h"
+#include "cs104_slave.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_OUTSTANDING_REQUESTS 1024
+
+#define CAPTURE_RECORD_HEADER_SIZE 14
+
+typedef struct {
+    TypeID typeId;
+    int ioa;
+    uint64_t sendTime; /* ns */
+    bool done;
+} Request;
+
+typedef struct {
+    int index;
+
+    CS104_Connection connection;
+    CS101_AppLayerParameters alParameters;
+
+    Semaphore lock;
+
+    /* outstanding requests (ring buffer) */
+    Request requests[MAX_OUTSTANDING_REQUESTS];
+    int oldestRequest;
+    int numberOfRequests;
+
+    uint32_t random;
+    uint64_t nextSendTime;
+
+    bool isActive;
+
+    uint64_t requestsSent;
+    uint64_t requestsRejected;
+    uint64_t responses;
+    uint64_t asdusReceived;
+} LoadConnection;
+
+typedef struct {
+    uint64_t* samples; /* response latency in ns */
+    int count;
+    int capacity;
+    Semaphore lock;
+} LatencyRecorder;
+
+typedef struct {
+    const char* hostname;
+    int tcpPort;
+    int ca;
+
+    int numberOfConnections;
+    int durationInS;
+    int requestRate; /* requests per second and connection */
+    uint32_t seed;
+
+    int giWeight;
+    int readWeight;
+    int commandWeight;
+
+    bool startServer;
+    int numberOfPoints; /* data points of the local server */
+    int eventRate;      /* spontaneous events per second of the local server */
+
+    const char* captureFile;
+    const char* replayFile;
+    double replayScale; /* 1.0 -> original timing, 0 -> as fast as possible */
+
+    const char* outputFile;
+} Options;
+
+static LatencyRecorder latencies;
+
+static FILE* captureFile = NULL;
+static Semaphore captureLock = NULL;
+static uint64_t captureStartTime = 0;
+
+/********************************************
+ * Helper functions
+ ********************************************/
+
+static uint32_t
+nextRandom (uint32_t* state)
+{
+    /* xorshift32 - the same seed produces the same request sequence */
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    *state = x;
+
+    return x;
+}
+
+static void
+putUint(uint8_t* buffer, uint64_t value, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        buffer[i] = (uint8_t) (value >> (8 * i));
+}
+
+static uint64_t
+getUint(uint8_t* buffer, int size)
+{
+    uint64_t value = 0;
+    int i;
+
+    for (i = 0; i < size; i++)
+        value |= ((uint64_t) buffer[i]) << (8 * i);
+
+    return value;
+}
+
+static int
+getFirstIOA(CS101_AppLayerParameters alParameters, CS101_ASDU asdu)
+{
+    uint8_t* payload = CS101_ASDU_getPayload(asdu);
+
+    if (CS101_ASDU_getPayloadSize(asdu) < alParameters->sizeOfIOA)
+        return -1;
+
+    return (int) getUint(payload, alParameters->sizeOfIOA);
+}
+
+static void
+LatencyRecorder_add(LatencyRecorder* self, uint64_t latency)
+{
+    Semaphore_wait(self->lock);
+
+    if (self->count == self->capacity) {
+        int newCapacity = (self->capacity == 0) ? 4096 : self->capacity * 2;
+
+        uint64_t* newSamples = (uint64_t*) realloc(self->samples, newCapacity * sizeof(uint64_t));
+
+        if (newSamples) {
+            self->samples = newSamples;
+            self->capacity = newCapacity;
+        }
+    }
+
+    if (self->count < self->capacity)
+        self->samples[self->count++] = latency;
+
+    Semaphore_post(self->lock);
+}
+
+static int
+compareSamples(const void* a, const void* b)
+{
+    uint64_t sampleA = *((const uint64_t*) a);
+    uint64_t sampleB = *((const uint64_t*) b);
+
+    if (sampleA < sampleB)
+        return -1;
+    else if (sampleA > sampleB)
+        return 1;
+    else
+        return 0;
+}
+
+static double
+getPercentile(LatencyRecorder* self, double percentile)
+{
+    if (self->count == 0)
+        return 0;
+
+    int index = (int) (percentile * self->count + 0.999999) - 1;
+
+    if (index < 0)
+        index = 0;
+
+    if (index >= self->count)
+        index = self->count - 1;
+
+    return self->samples[index] / 1000.0;
+}
+
+/********************************************
+ * Capture file
+ *
+ * record: timestamp in ns (8 bytes), connection index (2 bytes),
+ *         direction (1 byte, 1 = sent), reserved (1 byte), length (2 bytes), message
+ ********************************************/
+
+static void
+rawMessageHandler (void* parameter, uint8_t* msg, int msgSize, bool sent)
+{
+    LoadConnection* self = (LoadConnection*) parameter;
+
+    uint8_t header[CAPTURE_RECORD_HEADER_SIZE];
+
+    Semaphore_wait(captureLock);
+
+    putUint(header, Hal_getMonotonicTimeInNs() - captureStartTime, 8);
+    putUint(header + 8, self->index, 2);
+    header[10] = sent ? 1 : 0;
+    header[11] = 0;
+    putUint(header + 12, msgSize, 2);
+
+    fwrite(header, 1, CAPTURE_RECORD_HEADER_SIZE, captureFile);
+    fwrite(msg, 1, msgSize, captureFile);
+
+    Semaphore_post(captureLock);
+}
+
+/********************************************
+ * Request tracking
+ ********************************************/
+
+static bool
+addRequest(LoadConnection* self, TypeID typeId, int ioa)
+{
+    bool added = false;
+
+    Semaphore_wait(self->lock);
+
+    if (self->numberOfRequests < MAX_OUTSTANDING_REQUESTS) {
+        Request* request = &(self->requests[(self->oldestRequest + self->numberOfRequests) % MAX_OUTSTANDING_REQUESTS]);
+
+        request->typeId = typeId;
+        request->ioa = ioa;
+        request->sendTime = Hal_getMonotonicTimeInNs();
+        request->done = false;
+
+        self->numberOfRequests++;
+
+        added = true;
+    }
+
+    Semaphore_post(self->lock);
+
+    return added;
+}
+
+static void
+removeNewestRequest(LoadConnection* self)
+{
+    Semaphore_wait(self->lock);
+
+    if (self->numberOfRequests > 0)
+        self->numberOfRequests--;
+
+    Semaphore_post(self->lock);
+}
+
+static void
+handleResponse(LoadConnection* self, TypeID typeId, int ioa)
+{
+    uint64_t receiveTime = Hal_getMonotonicTimeInNs();
+
+    Semaphore_wait(self->lock);
+
+    int i;
+
+    for (i = 0; i < self->numberOfRequests; i++) {
+        Request* request = &(self->requests[(self->oldestRequest + i) % MAX_OUTSTANDING_REQUESTS]);
+
+        if ((request->done == false) && (request->typeId == typeId) && (request->ioa == ioa)) {
+            request->done = true;
+
+            self->responses++;
+
+            LatencyRecorder_add(&latencies, receiveTime - request->sendTime);
+
+            break;
+        }
+    }
+
+    /* release answered requests at the start of the ring buffer */
+    while ((self->numberOfRequests > 0) && self->requests[self->oldestRequest].done) {
+        self->oldestRequest = (self->oldestRequest + 1) % MAX_OUTSTANDING_REQUESTS;
+        self->numberOfRequests--;
+    }
+
+    Semaphore_post(self->lock);
+}
+
+static int
+getUnansweredRequests(LoadConnection* self)
+{
+    int unanswered = 0;
+
+    Semaphore_wait(self->lock);
+
+    int i;
+
+    for (i = 0; i < self->numberOfRequests; i++) {
+        if (self->requests[(self->oldestRequest + i) % MAX_OUTSTANDING_REQUESTS].done == false)
+            unanswered++;
+    }
+
+    Semaphore_post(self->lock);
+
+    return unanswered;
+}
+
+/********************************************
+ * Client side
+ ********************************************/
+
+static void
+connectionHandler (void* parameter, CS104_Connection connection, CS104_ConnectionEvent event)
+{
+    LoadConnection* self = (LoadConnection*) parameter;
+
+    Semaphore_wait(self->lock);
+
+    if (event == CS104_CONNECTION_STARTDT_CON_RECEIVED)
+        self->isActive = true;
+    else if ((event == CS104_CONNECTION_CLOSED) || (event == CS104_CONNECTION_STOPDT_CON_RECEIVED))
+        self->isActive = false;
+
+    Semaphore_post(self->lock);
+}
+
+static bool
+asduReceivedHandler (void* parameter, int address, CS101_ASDU asdu)
+{
+    LoadConnection* self = (LoadConnection*) parameter;
+
+    Semaphore_wait(self->lock);
+    self->asdusReceived++;
+    Semaphore_post(self->lock);
+
+    CS101_CauseOfTransmission cot = CS101_ASDU_getCOT(asdu);
+
+    if (cot == CS101_COT_ACTIVATION_CON)
+        handleResponse(self, CS101_ASDU_getTypeID(asdu), getFirstIOA(self->alParameters, asdu));
+    else if (cot == CS101_COT_REQUEST)
+        handleResponse(self, C_RD_NA_1, getFirstIOA(self->alParameters, asdu));
+
+    return true;
+}
+
+/**
+ * Send an ASDU and track the response time when a response is expected
+ */
+static bool
+sendTrackedASDU(LoadConnection* self, CS101_ASDU asdu)
+{
+    TypeID typeId = CS101_ASDU_getTypeID(asdu);
+
+    bool isTracked = false;
+
+    if (typeId == C_RD_NA_1 || ((typeId >= C_SC_NA_1) && (CS101_ASDU_getCOT(asdu) == CS101_COT_ACTIVATION))) {
+
+        if (addRequest(self, typeId, getFirstIOA(self->alParameters, asdu)) == false) {
+            self->requestsRejected++;
+            return false;
+        }
+
+        isTracked = true;
+    }
+
+    if (CS104_Connection_sendASDU(self->connection, asdu)) {
+        self->requestsSent++;
+        return true;
+    }
+    else {
+        /* k-buffer full or connection lost */
+        if (isTracked)
+            removeNewestRequest(self);
+
+        self->requestsRejected++;
+        return false;
+    }
+}
+
+static void
+sendScriptedRequest(LoadConnection* self, Options* options)
+{
+    int totalWeight = options->giWeight + options->readWeight + options->commandWeight;
+
+    int selection = (int) (nextRandom(&(self->random)) % (uint32_t) totalWeight);
+
+    int ioa = 1 + (int) (nextRandom(&(self->random)) % (uint32_t) options->numberOfPoints);
+
+    CS101_ASDU asdu = CS101_ASDU_create(self->alParameters, false, CS101_COT_ACTIVATION, 0, options->ca, false, false);
+
+    InformationObject io;
+
+    if (selection < options->giWeight) {
+        io = (InformationObject) InterrogationCommand_create(NULL, 0, IEC60870_QOI_STATION);
+    }
+    else if (selection < (options->giWeight + options->readWeight)) {
+        io = (InformationObject) ReadCommand_create(NULL, ioa);
+        CS101_ASDU_setCOT(asdu, CS101_COT_REQUEST);
+    }
+    else {
+        io = (InformationObject) SingleCommand_create(NULL, 10000 + ioa, true, false, 0);
+    }
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    sendTrackedASDU(self, asdu);
+
+    CS101_ASDU_destroy(asdu);
+}
+
+/********************************************
+ * Local server
+ ********************************************/
+
+static int serverNumberOfPoints = 100;
+
+static void
+sendPoints(IMasterConnection connection, CS101_AppLayerParameters alParams, CS101_CauseOfTransmission cot, int ca)
+{
+    CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, cot, 0, ca, false, false);
+
+    int ioa;
+
+    for (ioa = 1; ioa <= serverNumberOfPoints; ioa++) {
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, ioa, ioa, IEC60870_QUALITY_GOOD);
+
+        if (CS101_ASDU_addInformationObject(newAsdu, io) == false) {
+            /* ASDU is full */
+            IMasterConnection_sendASDU(connection, newAsdu);
+
+            CS101_ASDU_removeAllElements(newAsdu);
+            CS101_ASDU_addInformationObject(newAsdu, io);
+        }
+
+        InformationObject_destroy(io);
+    }
+
+    IMasterConnection_sendASDU(connection, newAsdu);
+
+    CS101_ASDU_destroy(newAsdu);
+}
+
+static bool
+interrogationHandler (void* parameter, IMasterConnection connection, CS101_ASDU asdu, uint8_t qoi)
+{
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+
+    sendPoints(connection, IMasterConnection_getApplicationLayerParameters(connection),
+            CS101_COT_INTERROGATED_BY_STATION, CS101_ASDU_getCA(asdu));
+
+    IMasterConnection_sendACT_TERM(connection, asdu);
+
+    return true;
+}
+
+static bool
+readHandler (void* parameter, IMasterConnection connection, CS101_ASDU asdu, int ioa)
+{
+    CS101_AppLayerParameters alParams = IMasterConnection_getApplicationLayerParameters(connection);
+
+    CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_REQUEST, 0, CS101_ASDU_getCA(asdu), false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, ioa, ioa, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(newAsdu, io);
+
+    InformationObject_destroy(io);
+
+    IMasterConnection_sendASDU(connection, newAsdu);
+
+    CS101_ASDU_destroy(newAsdu);
+
+    return true;
+}
+
+static bool
+asduHandler (void* parameter, IMasterConnection connection, CS101_ASDU asdu)
+{
+    if (CS101_ASDU_getCOT(asdu) == CS101_COT_ACTIVATION) {
+        IMasterConnection_sendACT_CON(connection, asdu, false);
+        return true;
+    }
+
+    return false;
+}
+
+static CS104_Slave
+startServer(Options* options)
+{
+    serverNumberOfPoints = options->numberOfPoints;
+
+    CS104_Slave slave = CS104_Slave_create(1000, 1000);
+
+    CS104_Slave_setLocalAddress(slave, "127.0.0.1");
+    CS104_Slave_setLocalPort(slave, options->tcpPort);
+
+    /* each client connection has its own event queue and can be active at the same time */
+    CS104_Slave_setServerMode(slave, CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP);
+    CS104_Slave_setMaxOpenConnections(slave, options->numberOfConnections);
+
+    CS104_Slave_setInterrogationHandler(slave, interrogationHandler, NULL);
+    CS104_Slave_setReadHandler(slave, readHandler, NULL);
+    CS104_Slave_setASDUHandler(slave, asduHandler, NULL);
+
+    CS104_Slave_start(slave);
+
+    if (CS104_Slave_isRunning(slave) == false) {
+        CS104_Slave_destroy(slave);
+        return NULL;
+    }
+
+    return slave;
+}
+
+static void
+enqueueEvent(CS104_Slave slave, Options* options, uint32_t* random)
+{
+    CS101_ASDU newAsdu = CS101_ASDU_create(CS104_Slave_getAppLayerParameters(slave), false, CS101_COT_SPONTANEOUS, 0,
+            options->ca, false, false);
+
+    int ioa = 1 + (int) (nextRandom(random) % (uint32_t) options->numberOfPoints);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, ioa, (int) (nextRandom(random) % 1000),
+            IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(newAsdu, io);
+
+    InformationObject_destroy(io);
+
+    CS104_Slave_enqueueASDU(slave, newAsdu);
+
+    CS101_ASDU_destroy(newAsdu);
+}
+
+/********************************************
+ * Load generation
+ ********************************************/
+
+static void
+runScripted(LoadConnection* connections, Options* options, CS104_Slave slave)
+{
+    uint64_t startTime = Hal_getMonotonicTimeInNs();
+    uint64_t endTime = startTime + (uint64_t) options->durationInS * 1000000000ULL;
+
+    uint64_t requestInterval = (options->requestRate > 0) ? (1000000000ULL / options->requestRate) : 0;
+    uint64_t eventInterval = (options->eventRate > 0) ? (1000000000ULL / options->eventRate) : 0;
+
+    uint64_t nextEventTime = startTime;
+    uint32_t eventRandom = options->seed;
+
+    int i;
+
+    /* spread the requests of the connections over the request interval */
+    for (i = 0; i < options->numberOfConnections; i++)
+        connections[i].nextSendTime = startTime + (requestInterval * i) / options->numberOfConnections;
+
+    uint64_t currentTime = startTime;
+
+    while (currentTime < endTime) {
+
+        if (requestInterval > 0) {
+            for (i = 0; i < options->numberOfConnections; i++) {
+                LoadConnection* con = &(connections[i]);
+
+                while (con->nextSendTime <= currentTime) {
+                    sendScriptedRequest(con, options);
+                    con->nextSendTime += requestInterval;
+                }
+            }
+        }
+
+        if (slave && (eventInterval > 0)) {
+            while (nextEventTime <= currentTime) {
+                enqueueEvent(slave, options, &eventRandom);
+                nextEventTime += eventInterval;
+            }
+        }
+
+        Thread_sleep(1);
+
+        currentTime = Hal_getMonotonicTimeInNs();
+    }
+}
+
+static bool
+runReplay(LoadConnection* connections, Options* options)
+{
+    FILE* file = fopen(options->replayFile, "rb");
+
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open replay file %s\n", options->replayFile);
+        return false;
+    }
+
+    uint64_t startTime = Hal_getMonotonicTimeInNs();
+
+    uint8_t header[CAPTURE_RECORD_HEADER_SIZE];
+    uint8_t msg[256];
+
+    while (fread(header, 1, CAPTURE_RECORD_HEADER_SIZE, file) == CAPTURE_RECORD_HEADER_SIZE) {
+        uint64_t timestamp = getUint(header, 8);
+        int conIndex = (int) getUint(header + 8, 2);
+        bool sent = (header[10] == 1);
+        int msgSize = (int) getUint(header + 12, 2);
+
+        if ((msgSize > (int) sizeof(msg)) || (fread(msg, 1, msgSize, file) != (size_t) msgSize)) {
+            fprintf(stderr, "Invalid replay file\n");
+            break;
+        }
+
+        /* only I messages sent by the client are replayed - S and U messages are created by the stack */
+        if ((sent == false) || (msgSize <= 6) || ((msg[2] & 1) != 0))
+            continue;
+
+        if (options->replayScale > 0) {
+            uint64_t sendTime = startTime + (uint64_t) (timestamp * options->replayScale);
+
+            uint64_t currentTime = Hal_getMonotonicTimeInNs();
+
+            if (sendTime > currentTime)
+                Thread_sleep((int) ((sendTime - currentTime) / 1000000));
+        }
+
+        LoadConnection* con = &(connections[conIndex % options->numberOfConnections]);
+
+        CS101_ASDU asdu = CS101_ASDU_createFromBuffer(con->alParameters, msg + 6, msgSize - 6);
+
+        if (asdu) {
+            sendTrackedASDU(con, asdu);
+            CS101_ASDU_destroy(asdu);
+        }
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+/********************************************
+ * Results
+ ********************************************/
+
+static void
+writeResults(FILE* out, LoadConnection* connections, Options* options, double durationInS)
+{
+    uint64_t requestsSent = 0;
+    uint64_t requestsRejected = 0;
+    uint64_t responses = 0;
+    uint64_t asdusReceived = 0;
+    int unanswered = 0;
+
+    int i;
+
+    for (i = 0; i < options->numberOfConnections; i++) {
+        LoadConnection* con = &(connections[i]);
+
+        Semaphore_wait(con->lock);
+
+        requestsSent += con->requestsSent;
+        requestsRejected += con->requestsRejected;
+        responses += con->responses;
+        asdusReceived += con->asdusReceived;
+
+        Semaphore_post(con->lock);
+
+        unanswered += getUnansweredRequests(con);
+    }
+
+    Semaphore_wait(latencies.lock);
+
+    qsort(latencies.samples, latencies.count, sizeof(uint64_t), compareSamples);
+
+    double meanLatency = 0;
+
+    for (i = 0; i < latencies.count; i++)
+        meanLatency += latencies.samples[i] / 1000.0;
+
+    if (latencies.count > 0)
+        meanLatency /= latencies.count;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"mode\": \"%s\",\n", options->replayFile ? "replay" : "scripted");
+    fprintf(out, "  \"connections\": %i,\n", options->numberOfConnections);
+    fprintf(out, "  \"duration_s\": %.3f,\n", durationInS);
+    fprintf(out, "  \"requests_sent\": %llu,\n", (unsigned long long) requestsSent);
+    fprintf(out, "  \"requests_rejected\": %llu,\n", (unsigned long long) requestsRejected);
+    fprintf(out, "  \"responses\": %llu,\n", (unsigned long long) responses);
+    fprintf(out, "  \"unanswered\": %i,\n", unanswered);
+    fprintf(out, "  \"asdus_received\": %llu,\n", (unsigned long long) asdusReceived);
+    fprintf(out, "  \"throughput_rps\": %.1f,\n", responses / durationInS);
+    fprintf(out, "  \"asdu_rate\": %.1f,\n", asdusReceived / durationInS);
+    fprintf(out, "  \"latency_us\": {\n");
+    fprintf(out, "    \"samples\": %i,\n", latencies.count);
+    fprintf(out, "    \"mean\": %.1f,\n", meanLatency);
+    fprintf(out, "    \"p50\": %.1f,\n", getPercentile(&latencies, 0.5));
+    fprintf(out, "    \"p99\": %.1f,\n", getPercentile(&latencies, 0.99));
+    fprintf(out, "    \"p999\": %.1f,\n", getPercentile(&latencies, 0.999));
+    fprintf(out, "    \"max\": %.1f\n", getPercentile(&latencies, 1.0));
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n");
+
+    Semaphore_post(latencies.lock);
+}
+
+/********************************************
+ * Main
+ ********************************************/
+
+static void
+printUsage(void)
+{
+    printf("Usage: cs104_loadgen [options]\n\n");
+    printf("  -n <count>      number of client connections (default: 10)\n");
+    printf("  -t <seconds>    duration of the scripted load (default: 10)\n");
+    printf("  -r <rate>       requests per second and connection (default: 100)\n");
+    printf("  -m <mix>        request mix as weights, e.g. gi:1,read:4,cmd:5 (default)\n");
+    printf("  -s <seed>       seed of the request sequence (default: 1)\n");
+    printf("  -p <port>       TCP port (default: 2404)\n");
+    printf("  -a <ca>         common address (default: 1)\n");
+    printf("  -P <points>     number of data points of the local server (default: 100)\n");
+    printf("  -e <rate>       spontaneous events per second of the local server (default: 0)\n");
+    printf("  -x              don't start a local server (use a server running on 127.0.0.1)\n");
+    printf("  -w <file>       capture all messages to file\n");
+    printf("  -R <file>       replay the client messages of a capture file instead of the scripted load\n");
+    printf("  -S <scale>      replay timing scale (1.0 = original timing, 0 = as fast as possible, default: 1.0)\n");
+    printf("  -o <file>       write the JSON results to file (default: stdout)\n");
+}
+
+static bool
+parseMix(Options* options, char* mix)
+{
+    options->giWeight = 0;
+    options->readWeight = 0;
+    options->commandWeight = 0;
+
+    char* token = strtok(mix, ",");
+
+    while (token) {
+        char* separator = strchr(token, ':');
+
+        if (separator == NULL)
+            return false;
+
+        *separator = 0;
+
+        int weight = atoi(separator + 1);
+
+        if (strcmp(token, "gi") == 0)
+            options->giWeight = weight;
+        else if (strcmp(token, "read") == 0)
+            options->readWeight = weight;
+        else if (strcmp(token, "cmd") == 0)
+            options->commandWeight = weight;
+        else
+            return false;
+
+        token = strtok(NULL, ",");
+    }
+
+    return (options->giWeight + options->readWeight + options->commandWeight) > 0;
+}
+
+static bool
+parseOptions(Options* options, int argc, char** argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        const char* option = argv[i];
+
+        if (strcmp(option, "-x") == 0) {
+            options->startServer = false;
+            continue;
+        }
+
+        if (strcmp(option, "-h") == 0)
+            return false;
+
+        if (i + 1 >= argc)
+            return false;
+
+        char* value = argv[++i];
+
+        if (strcmp(option, "-n") == 0)
+            options->numberOfConnections = atoi(value);
+        else if (strcmp(option, "-t") == 0)
+            options->durationInS = atoi(value);
+        else if (strcmp(option, "-r") == 0)
+            options->requestRate = atoi(value);
+        else if (strcmp(option, "-m") == 0) {
+            if (parseMix(options, value) == false)
+                return false;
+        }
+        else if (strcmp(option, "-s") == 0)
+            options->seed = (uint32_t) strtoul(value, NULL, 10);
+        else if (strcmp(option, "-p") == 0)
+            options->tcpPort = atoi(value);
+        else if (strcmp(option, "-a") == 0)
+            options->ca = atoi(value);
+        else if (strcmp(option, "-P") == 0)
+            options->numberOfPoints = atoi(value);
+        else if (strcmp(option, "-e") == 0)
+            options->eventRate = atoi(value);
+        else if (strcmp(option, "-w") == 0)
+            options->captureFile = value;
+        else if (strcmp(option, "-R") == 0)
+            options->replayFile = value;
+        else if (strcmp(option, "-S") == 0)
+            options->replayScale = atof(value);
+        else if (strcmp(option, "-o") == 0)
+            options->outputFile = value;
+        else
+            return false;
+    }
+
+    if ((options->numberOfConnections < 1) || (options->numberOfPoints < 1) || (options->durationInS < 0))
+        return false;
+
+    if (options->seed == 0)
+        options->seed = 1;
+
+    return true;
+}
+
+int
+main(int argc, char** argv)
+{
+    Options options;
+
+    options.hostname = "127.0.0.1";
+    options.tcpPort = 2404;
+    options.ca = 1;
+    options.numberOfConnections = 10;
+    options.durationInS = 10;
+    options.requestRate = 100;
+    options.seed = 1;
+    options.giWeight = 1;
+    options.readWeight = 4;
+    options.commandWeight = 5;
+    options.startServer = true;
+    options.numberOfPoints = 100;
+    options.eventRate = 0;
+    options.captureFile = NULL;
+    options.replayFile = NULL;
+    options.replayScale = 1.0;
+    options.outputFile = NULL;
+
+    if (parseOptions(&options, argc, argv) == false) {
+        printUsage();
+        return 1;
+    }
+
+    int retVal = 0;
+    int i;
+
+    CS104_Slave slave = NULL;
+    LoadConnection* connections = NULL;
+
+    if (options.startServer) {
+        slave = startServer(&options);
+
+        if (slave == NULL) {
+            fprintf(stderr, "Failed to start server on port %i\n", options.tcpPort);
+            return 1;
+        }
+    }
+
+    latencies.samples = NULL;
+    latencies.count = 0;
+    latencies.capacity = 0;
+    latencies.lock = Semaphore_create(1);
+
+    if (options.captureFile) {
+        captureFile = fopen(options.captureFile, "wb");
+
+        if (captureFile == NULL) {
+            fprintf(stderr, "Failed to create capture file %s\n", options.captureFile);
+            retVal = 1;
+            goto exit_program;
+        }
+
+        captureLock = Semaphore_create(1);
+        captureStartTime = Hal_getMonotonicTimeInNs();
+    }
+
+    connections = (LoadConnection*) calloc(options.numberOfConnections, sizeof(LoadConnection));
+
+    for (i = 0; i < options.numberOfConnections; i++) {
+        LoadConnection* con = &(connections[i]);
+
+        con->index = i;
+        con->lock = Semaphore_create(1);
+        con->random = options.seed + (uint32_t) i;
+
+        if (con->random == 0)
+            con->random = 1;
+
+        con->connection = CS104_Connection_create(options.hostname, options.tcpPort);
+        con->alParameters = CS104_Connection_getAppLayerParameters(con->connection);
+
+        CS104_Connection_setConnectionHandler(con->connection, connectionHandler, con);
+        CS104_Connection_setASDUReceivedHandler(con->connection, asduReceivedHandler, con);
+
+        if (captureFile)
+            CS104_Connection_setRawMessageHandler(con->connection, rawMessageHandler, con);
+
+        if (CS104_Connection_connect(con->connection) == false) {
+            fprintf(stderr, "Connection %i failed\n", i);
+            retVal = 1;
+            break;
+        }
+
+        CS104_Connection_sendStartDT(con->connection);
+    }
+
+    if (retVal == 0) {
+        /* wait until all connections are active */
+        uint64_t timeout = Hal_getMonotonicTimeInMs() + 5000;
+
+        int activeConnections = 0;
+
+        while ((activeConnections < options.numberOfConnections) && (Hal_getMonotonicTimeInMs() < timeout)) {
+            Thread_sleep(10);
+
+            activeConnections = 0;
+
+            for (i = 0; i < options.numberOfConnections; i++) {
+                Semaphore_wait(connections[i].lock);
+
+                if (connections[i].isActive)
+                    activeConnections++;
+
+                Semaphore_post(connections[i].lock);
+            }
+        }
+
+        uint64_t startTime = Hal_getMonotonicTimeInNs();
+
+        if (options.replayFile) {
+            if (runReplay(connections, &options) == false)
+                retVal = 1;
+        }
+        else
+            runScripted(connections, &options, slave);
+
+        /* wait for outstanding responses */
+        uint64_t responseTimeout = Hal_getMonotonicTimeInMs() + 1000;
+
+        while (Hal_getMonotonicTimeInMs() < responseTimeout) {
+            int unanswered = 0;
+
+            for (i = 0; i < options.numberOfConnections; i++)
+                unanswered += getUnansweredRequests(&(connections[i]));
+
+            if (unanswered == 0)
+                break;
+
+            Thread_sleep(10);
+        }
+
+        double durationInS = (Hal_getMonotonicTimeInNs() - startTime) / 1000000000.0;
+
+        FILE* out = stdout;
+
+        if (options.outputFile) {
+            out = fopen(options.outputFile, "w");
+
+            if (out == NULL) {
+                fprintf(stderr, "Failed to create output file %s\n", options.outputFile);
+                out = stdout;
+            }
+        }
+
+        writeResults(out, connections, &options, durationInS);
+
+        if (out != stdout)
+            fclose(out);
+    }
+
+    for (i = 0; i < options.numberOfConnections; i++) {
+        if (connections[i].connection)
+            CS104_Connection_destroy(connections[i].connection);
+
+        Semaphore_destroy(connections[i].lock);
+    }
+
+    free(connections);
+
+    if (captureFile) {
+        fclose(captureFile);
+        Semaphore_destroy(captureLock);
+    }
+
+exit_program:
+
+    if (slave) {
+        CS104_Slave_stop(slave);
+        CS104_Slave_destroy(slave);
+    }
+
+    Semaphore_destroy(latencies.lock);
+    free(latencies.samples);
+
+    return retVal;
+}
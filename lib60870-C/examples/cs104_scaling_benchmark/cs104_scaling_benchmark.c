@@ -0,0 +1,778 @@
+/*
+ * cs104_scaling_benchmark.c
+ *
+ * Multi-core scaling benchmark for CS104_Slave with worker threads (CS104_Slave_setWorkerThreads).
+ * For each number of worker threads the tool starts a CS104_Slave on the loopback interface (mode
+ * connection is redundancy group), connects the clients and enqueues spontaneous events at increasing
+ * rates. Every event is delivered to all clients. The worker threads are bound to the CPUs 0, 1, ..
+ * (CS104_Slave_setWorkerAffinity) unless binding is disabled. With 0 workers the slave uses one thread
+ * per connection (the default) - use it as baseline.
+ *
+ * For every step the delivered event rate, the server CPU time per delivered event and the
+ * enqueue-to-receive latency percentiles are printed as JSON. The clients run in a separate process
+ * (fork) so that the CPU time only contains the server side (worker threads, server thread and the
+ * thread that enqueues the events). The events are enqueued by a single thread.
+ *
+ * The number of connections is limited by CONFIG_CS104_MAX_CLIENT_CONNECTIONS of the library.
+ */
+
+#include "cs104_connection.h"
+#include "cs104_slave.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_STEPS 32
+
+/* log-linear latency histogram: 16 buckets per power of two (about 6% resolution) */
+#define HISTOGRAM_SUB_BUCKETS 16
+#define HISTOGRAM_BUCKETS (29 * HISTOGRAM_SUB_BUCKETS)
+
+/* commands sent to the client process */
+#define COMMAND_RESET 'R'
+#define COMMAND_GET 'G'
+#define COMMAND_QUIT 'Q'
+
+typedef struct {
+    CS104_Connection connection;
+
+    Semaphore lock;
+
+    uint64_t eventsReceived;
+    uint64_t latencyHistogram[HISTOGRAM_BUCKETS];
+} BenchmarkClient;
+
+/* statistics of all clients (sent from the client process to the benchmark process) */
+typedef struct {
+    uint64_t eventsReceived;
+    int receivers;
+    uint64_t latencyHistogram[HISTOGRAM_BUCKETS];
+} ClientReport;
+
+typedef struct {
+    int workerCounts[MAX_STEPS];
+    int numberOfWorkerCounts;
+    int eventRates[MAX_STEPS];
+    int numberOfEventRates;
+    int connections;
+    bool bindWorkers;
+    int stepDurationInMs;
+    int tcpPort;
+    int queueSize;
+    const char* outputFile;
+} Options;
+
+typedef struct {
+    int workers;
+    int connected;
+    int offeredRate;
+    uint64_t eventsSent;
+    int receivers;
+    uint64_t eventsDelivered;
+    double durationInS;
+    double deliveredRate;
+    double cpuPerEventInUs;
+    double cpuUtilization; /* server CPU time / duration (1.0 = one core fully used) */
+    ClientReport report;
+    bool saturated;
+} StepResult;
+
+/* the client process */
+typedef struct {
+    pid_t pid;
+    int commandFd;
+    int replyFd;
+} ClientProcess;
+
+static bool firstResult = true;
+
+/********************************************
+ * Helper functions
+ ********************************************/
+
+static uint32_t
+getTimeInUs(void)
+{
+    return (uint32_t) (Hal_getMonotonicTimeInNs() / 1000);
+}
+
+static int
+getHistogramIndex(uint32_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return (int) value;
+
+    int msb = 0;
+    uint32_t v = value;
+
+    while (v > 1) {
+        v = v >> 1;
+        msb++;
+    }
+
+    int index = (msb - 3) * HISTOGRAM_SUB_BUCKETS + (int) ((value >> (msb - 4)) & (HISTOGRAM_SUB_BUCKETS - 1));
+
+    if (index >= HISTOGRAM_BUCKETS)
+        index = HISTOGRAM_BUCKETS - 1;
+
+    return index;
+}
+
+static uint64_t
+getHistogramValue(int index)
+{
+    if (index < HISTOGRAM_SUB_BUCKETS)
+        return (uint64_t) index;
+
+    int msb = index / HISTOGRAM_SUB_BUCKETS + 3;
+    int sub = index % HISTOGRAM_SUB_BUCKETS;
+
+    return ((uint64_t) (HISTOGRAM_SUB_BUCKETS + sub)) << (msb - 4);
+}
+
+static uint64_t
+getPercentile(uint64_t* histogram, double percentile)
+{
+    uint64_t count = 0;
+    int i;
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+        count += histogram[i];
+
+    if (count == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t) (percentile * count + 0.999999);
+
+    if (rank < 1)
+        rank = 1;
+
+    uint64_t sum = 0;
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        sum += histogram[i];
+
+        if (sum >= rank)
+            return getHistogramValue(i);
+    }
+
+    return getHistogramValue(HISTOGRAM_BUCKETS - 1);
+}
+
+static double
+getCpuTimeInUs(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000.0 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static bool
+readFully(int fd, void* buffer, size_t size)
+{
+    uint8_t* pos = (uint8_t*) buffer;
+
+    while (size > 0) {
+        ssize_t result = read(fd, pos, size);
+
+        if (result <= 0)
+            return false;
+
+        pos += result;
+        size -= result;
+    }
+
+    return true;
+}
+
+static bool
+writeFully(int fd, const void* buffer, size_t size)
+{
+    const uint8_t* pos = (const uint8_t*) buffer;
+
+    while (size > 0) {
+        ssize_t result = write(fd, pos, size);
+
+        if (result <= 0)
+            return false;
+
+        pos += result;
+        size -= result;
+    }
+
+    return true;
+}
+
+/********************************************
+ * Client process
+ ********************************************/
+
+static bool
+asduReceivedHandler (void* parameter, int address, CS101_ASDU asdu)
+{
+    BenchmarkClient* self = (BenchmarkClient*) parameter;
+
+    (void) address;
+
+    if ((CS101_ASDU_getTypeID(asdu) != M_BO_NA_1) || (CS101_ASDU_getCOT(asdu) != CS101_COT_SPONTANEOUS))
+        return true;
+
+    uint32_t receiveTime = getTimeInUs();
+
+    int i;
+
+    Semaphore_wait(self->lock);
+
+    for (i = 0; i < CS101_ASDU_getNumberOfElements(asdu); i++) {
+        uint8_t ioBuf[250];
+
+        BitString32 bs = (BitString32) CS101_ASDU_getElementEx(asdu, (InformationObject) ioBuf, i);
+
+        /* the value is the enqueue time in us (wraps around after ~71 minutes) */
+        uint32_t latency = receiveTime - BitString32_getValue(bs);
+
+        self->latencyHistogram[getHistogramIndex(latency)]++;
+        self->eventsReceived++;
+    }
+
+    Semaphore_post(self->lock);
+
+    return true;
+}
+
+static void
+getClientReport(BenchmarkClient* clients, int numberOfClients, ClientReport* report, bool reset)
+{
+    memset(report, 0, sizeof(ClientReport));
+
+    int i;
+
+    for (i = 0; i < numberOfClients; i++) {
+        Semaphore_wait(clients[i].lock);
+
+        if (clients[i].eventsReceived > 0)
+            report->receivers++;
+
+        report->eventsReceived += clients[i].eventsReceived;
+
+        int j;
+
+        for (j = 0; j < HISTOGRAM_BUCKETS; j++)
+            report->latencyHistogram[j] += clients[i].latencyHistogram[j];
+
+        if (reset) {
+            clients[i].eventsReceived = 0;
+            memset(clients[i].latencyHistogram, 0, sizeof(clients[i].latencyHistogram));
+        }
+
+        Semaphore_post(clients[i].lock);
+    }
+}
+
+/* connects the clients and handles the commands of the benchmark process */
+static void
+runClients(int numberOfClients, int tcpPort, int commandFd, int replyFd)
+{
+    BenchmarkClient* clients = (BenchmarkClient*) calloc(numberOfClients, sizeof(BenchmarkClient));
+    ClientReport* report = (ClientReport*) malloc(sizeof(ClientReport));
+
+    int connected = 0;
+    int i;
+
+    for (i = 0; i < numberOfClients; i++) {
+        BenchmarkClient* client = &(clients[i]);
+
+        client->lock = Semaphore_create(1);
+        client->connection = CS104_Connection_create("127.0.0.1", tcpPort);
+
+        CS104_Connection_setASDUReceivedHandler(client->connection, asduReceivedHandler, client);
+
+        if (CS104_Connection_connect(client->connection)) {
+            CS104_Connection_sendStartDT(client->connection);
+            connected++;
+        }
+    }
+
+    writeFully(replyFd, &connected, sizeof(connected));
+
+    char command;
+
+    while (readFully(commandFd, &command, 1) && (command != COMMAND_QUIT)) {
+        getClientReport(clients, numberOfClients, report, (command == COMMAND_RESET));
+
+        if (writeFully(replyFd, report, sizeof(ClientReport)) == false)
+            break;
+    }
+
+    for (i = 0; i < numberOfClients; i++) {
+        CS104_Connection_destroy(clients[i].connection);
+        Semaphore_destroy(clients[i].lock);
+    }
+
+    free(report);
+    free(clients);
+}
+
+/* returns the number of connected clients or -1 on error */
+static int
+startClientProcess(ClientProcess* process, int numberOfClients, int tcpPort)
+{
+    int commandPipe[2];
+    int replyPipe[2];
+
+    if (pipe(commandPipe) != 0)
+        return -1;
+
+    if (pipe(replyPipe) != 0) {
+        close(commandPipe[0]);
+        close(commandPipe[1]);
+        return -1;
+    }
+
+    fflush(NULL);
+
+    process->pid = fork();
+
+    if (process->pid == 0) {
+        close(commandPipe[1]);
+        close(replyPipe[0]);
+
+        runClients(numberOfClients, tcpPort, commandPipe[0], replyPipe[1]);
+
+        _exit(0);
+    }
+
+    close(commandPipe[0]);
+    close(replyPipe[1]);
+
+    process->commandFd = commandPipe[1];
+    process->replyFd = replyPipe[0];
+
+    int connected = -1;
+
+    if ((process->pid < 0) || (readFully(process->replyFd, &connected, sizeof(connected)) == false))
+        connected = -1;
+
+    return connected;
+}
+
+static bool
+requestClientReport(ClientProcess* process, char command, ClientReport* report)
+{
+    if (writeFully(process->commandFd, &command, 1) == false)
+        return false;
+
+    return readFully(process->replyFd, report, sizeof(ClientReport));
+}
+
+static void
+stopClientProcess(ClientProcess* process)
+{
+    char command = COMMAND_QUIT;
+
+    if (process->pid > 0) {
+        writeFully(process->commandFd, &command, 1);
+
+        waitpid(process->pid, NULL, 0);
+    }
+
+    close(process->commandFd);
+    close(process->replyFd);
+}
+
+/********************************************
+ * Benchmark steps
+ ********************************************/
+
+static CS104_Slave
+startServer(Options* options, int numberOfWorkers, int tcpPort)
+{
+    CS104_Slave slave = CS104_Slave_create(options->queueSize, 100);
+
+    CS104_Slave_setLocalAddress(slave, "0.0.0.0");
+    CS104_Slave_setLocalPort(slave, tcpPort);
+    CS104_Slave_setServerMode(slave, CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP);
+    CS104_Slave_setMaxOpenConnections(slave, options->connections);
+
+    if (numberOfWorkers > 0) {
+        CS104_Slave_setWorkerThreads(slave, numberOfWorkers);
+
+        if (options->bindWorkers) {
+            int numberOfCpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+            int i;
+
+            if (numberOfCpus < 1)
+                numberOfCpus = 1;
+
+            /* CPUs with adjacent numbers are usually on the same NUMA node */
+            for (i = 0; i < numberOfWorkers; i++)
+                CS104_Slave_setWorkerAffinity(slave, i, i % numberOfCpus);
+        }
+    }
+
+    CS104_Slave_start(slave);
+
+    if (CS104_Slave_isRunning(slave) == false) {
+        CS104_Slave_destroy(slave);
+        return NULL;
+    }
+
+    return slave;
+}
+
+static bool
+runStep(CS104_Slave slave, ClientProcess* clients, int eventRate, Options* options, StepResult* result)
+{
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    ClientReport* report = &(result->report);
+
+    if (requestClientReport(clients, COMMAND_RESET, report) == false)
+        return false;
+
+    double cpuStart = getCpuTimeInUs();
+    uint64_t startTime = Hal_getMonotonicTimeInNs();
+    uint64_t sendEndTime = startTime + (uint64_t) options->stepDurationInMs * 1000000;
+
+    uint64_t eventsSent = 0;
+
+    sCS101_StaticASDU asduBuffer;
+    uint8_t ioBuf[250];
+
+    uint64_t currentTime = startTime;
+
+    while (currentTime < sendEndTime) {
+        uint64_t eventsDue = (uint64_t) ((currentTime - startTime) / 1000000000.0 * eventRate);
+
+        while (eventsSent < eventsDue) {
+            CS101_ASDU asdu = CS101_ASDU_initializeStatic(&asduBuffer, alParams, false, CS101_COT_SPONTANEOUS, 0, 1,
+                    false, false);
+
+            InformationObject io = (InformationObject) BitString32_create((BitString32) ioBuf,
+                    (int) (eventsSent % 1000) + 1, getTimeInUs());
+
+            CS101_ASDU_addInformationObject(asdu, io);
+
+            CS104_Slave_enqueueASDU(slave, asdu);
+
+            eventsSent++;
+        }
+
+        Thread_sleep(1);
+
+        currentTime = Hal_getMonotonicTimeInNs();
+    }
+
+    /* wait until the queues are drained (no progress for 200 ms) */
+    if (requestClientReport(clients, COMMAND_GET, report) == false)
+        return false;
+
+    uint64_t lastEventsReceived = report->eventsReceived;
+    uint64_t lastProgressTime = Hal_getMonotonicTimeInNs();
+    uint64_t drainEndTime = lastProgressTime;
+
+    while (Hal_getMonotonicTimeInNs() < lastProgressTime + 200000000) {
+        Thread_sleep(10);
+
+        if (requestClientReport(clients, COMMAND_GET, report) == false)
+            return false;
+
+        if (report->eventsReceived != lastEventsReceived) {
+            lastEventsReceived = report->eventsReceived;
+            lastProgressTime = Hal_getMonotonicTimeInNs();
+            drainEndTime = lastProgressTime;
+        }
+    }
+
+    double cpuTime = getCpuTimeInUs() - cpuStart;
+
+    result->offeredRate = eventRate;
+    result->eventsSent = eventsSent;
+    result->eventsDelivered = report->eventsReceived;
+    result->receivers = report->receivers;
+    result->durationInS = (drainEndTime - startTime) / 1000000000.0;
+
+    if (result->durationInS > 0) {
+        result->deliveredRate = result->eventsDelivered / result->durationInS;
+        result->cpuUtilization = cpuTime / 1000000.0 / result->durationInS;
+    }
+    else {
+        result->deliveredRate = 0;
+        result->cpuUtilization = 0;
+    }
+
+    if (result->eventsDelivered > 0)
+        result->cpuPerEventInUs = cpuTime / result->eventsDelivered;
+    else
+        result->cpuPerEventInUs = 0;
+
+    /* saturated when less than 95% of the events arrive at the clients or the sending took much longer */
+    uint64_t expected = eventsSent * (result->connected > 0 ? result->connected : 1);
+
+    result->saturated = (result->eventsDelivered * 100 < expected * 95) ||
+            (result->durationInS > 2.0 * options->stepDurationInMs / 1000.0);
+
+    return true;
+}
+
+static void
+writeResult(FILE* out, StepResult* result)
+{
+    uint64_t* histogram = result->report.latencyHistogram;
+
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"workers\": %i,\n", result->workers);
+    fprintf(out, "      \"connected\": %i,\n", result->connected);
+    fprintf(out, "      \"offered_rate\": %i,\n", result->offeredRate);
+    fprintf(out, "      \"events_sent\": %llu,\n", (unsigned long long) result->eventsSent);
+    fprintf(out, "      \"receivers\": %i,\n", result->receivers);
+    fprintf(out, "      \"events_delivered\": %llu,\n", (unsigned long long) result->eventsDelivered);
+    fprintf(out, "      \"duration_s\": %.3f,\n", result->durationInS);
+    fprintf(out, "      \"delivered_rate\": %.1f,\n", result->deliveredRate);
+    fprintf(out, "      \"cpu_us_per_event\": %.3f,\n", result->cpuPerEventInUs);
+    fprintf(out, "      \"cpu_utilization\": %.2f,\n", result->cpuUtilization);
+    fprintf(out, "      \"saturated\": %s,\n", result->saturated ? "true" : "false");
+    fprintf(out, "      \"latency_us\": {\n");
+    fprintf(out, "        \"p50\": %llu,\n", (unsigned long long) getPercentile(histogram, 0.5));
+    fprintf(out, "        \"p90\": %llu,\n", (unsigned long long) getPercentile(histogram, 0.9));
+    fprintf(out, "        \"p99\": %llu,\n", (unsigned long long) getPercentile(histogram, 0.99));
+    fprintf(out, "        \"p999\": %llu,\n", (unsigned long long) getPercentile(histogram, 0.999));
+    fprintf(out, "        \"max\": %llu\n", (unsigned long long) getPercentile(histogram, 1.0));
+    fprintf(out, "      }\n");
+    fprintf(out, "    }");
+
+    fflush(out);
+}
+
+/* runs the steps for one number of worker threads */
+static bool
+runConfiguration(FILE* out, Options* options, int numberOfWorkers, int tcpPort)
+{
+    CS104_Slave slave = startServer(options, numberOfWorkers, tcpPort);
+
+    if (slave == NULL) {
+        fprintf(stderr, "Failed to start server on port %i\n", tcpPort);
+        return false;
+    }
+
+    ClientProcess clients;
+
+    int connected = startClientProcess(&clients, options->connections, tcpPort);
+
+    if (connected < 0) {
+        fprintf(stderr, "Failed to start client process\n");
+
+        CS104_Slave_destroy(slave);
+        return false;
+    }
+
+    /* wait until the STARTDT messages are handled */
+    Thread_sleep(500);
+
+    bool success = true;
+    int r;
+
+    for (r = 0; r < options->numberOfEventRates; r++) {
+        StepResult* result = (StepResult*) calloc(1, sizeof(StepResult));
+
+        result->workers = numberOfWorkers;
+        result->connected = connected;
+
+        success = runStep(slave, &clients, options->eventRates[r], options, result);
+
+        if (success) {
+            if (firstResult == false)
+                fprintf(out, ",\n");
+
+            writeResult(out, result);
+
+            firstResult = false;
+        }
+
+        /* higher rates are not sustainable either */
+        bool saturated = result->saturated;
+
+        free(result);
+
+        if ((success == false) || saturated)
+            break;
+    }
+
+    stopClientProcess(&clients);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    return success;
+}
+
+/********************************************
+ * Main
+ ********************************************/
+
+static void
+printUsage(void)
+{
+    printf("Usage: cs104_scaling_benchmark [options]\n\n");
+    printf("  -w <counts>     numbers of worker threads, e.g. 1,2,4,8,16,32 (default)\n");
+    printf("                  (0 = one thread per connection)\n");
+    printf("  -n <count>      number of client connections (default: 64)\n");
+    printf("  -r <rates>      event rates in events/s, e.g. 1000,2000,5000,10000,20000 (default)\n");
+    printf("                  (every event is delivered to all connections)\n");
+    printf("  -a <0|1>        bind the worker threads to the CPUs (default: 1)\n");
+    printf("  -t <ms>         duration of a step (default: 2000)\n");
+    printf("  -q <size>       event queue size of the connections (default: 10000)\n");
+    printf("  -p <port>       first TCP port (default: 23404)\n");
+    printf("  -o <file>       write the JSON results to file (default: stdout)\n");
+}
+
+static int
+parseList(char* list, int* values, int minValue)
+{
+    int count = 0;
+
+    char* token = strtok(list, ",");
+
+    while (token && (count < MAX_STEPS)) {
+        values[count] = atoi(token);
+
+        if (values[count] < minValue)
+            return 0;
+
+        count++;
+
+        token = strtok(NULL, ",");
+    }
+
+    return count;
+}
+
+static bool
+parseOptions(Options* options, int argc, char** argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        const char* option = argv[i];
+
+        if (strcmp(option, "-h") == 0)
+            return false;
+
+        if (i + 1 >= argc)
+            return false;
+
+        char* value = argv[++i];
+
+        if (strcmp(option, "-w") == 0)
+            options->numberOfWorkerCounts = parseList(value, options->workerCounts, 0);
+        else if (strcmp(option, "-n") == 0)
+            options->connections = atoi(value);
+        else if (strcmp(option, "-r") == 0)
+            options->numberOfEventRates = parseList(value, options->eventRates, 1);
+        else if (strcmp(option, "-a") == 0)
+            options->bindWorkers = (atoi(value) != 0);
+        else if (strcmp(option, "-t") == 0)
+            options->stepDurationInMs = atoi(value);
+        else if (strcmp(option, "-q") == 0)
+            options->queueSize = atoi(value);
+        else if (strcmp(option, "-p") == 0)
+            options->tcpPort = atoi(value);
+        else if (strcmp(option, "-o") == 0)
+            options->outputFile = value;
+        else
+            return false;
+    }
+
+    if ((options->numberOfWorkerCounts < 1) || (options->numberOfEventRates < 1) || (options->connections < 1) ||
+            (options->stepDurationInMs < 1) || (options->queueSize < 1))
+        return false;
+
+    return true;
+}
+
+int
+main(int argc, char** argv)
+{
+    Options options;
+
+    options.workerCounts[0] = 1;
+    options.workerCounts[1] = 2;
+    options.workerCounts[2] = 4;
+    options.workerCounts[3] = 8;
+    options.workerCounts[4] = 16;
+    options.workerCounts[5] = 32;
+    options.numberOfWorkerCounts = 6;
+    options.eventRates[0] = 1000;
+    options.eventRates[1] = 2000;
+    options.eventRates[2] = 5000;
+    options.eventRates[3] = 10000;
+    options.eventRates[4] = 20000;
+    options.numberOfEventRates = 5;
+    options.connections = 64;
+    options.bindWorkers = true;
+    options.stepDurationInMs = 2000;
+    options.queueSize = 10000;
+    options.tcpPort = 23404;
+    options.outputFile = NULL;
+
+    if (parseOptions(&options, argc, argv) == false) {
+        printUsage();
+        return 1;
+    }
+
+    /* the client process can terminate while a command is written */
+    signal(SIGPIPE, SIG_IGN);
+
+    FILE* out = stdout;
+
+    if (options.outputFile) {
+        out = fopen(options.outputFile, "w");
+
+        if (out == NULL) {
+            fprintf(stderr, "Failed to create output file %s\n", options.outputFile);
+            return 1;
+        }
+    }
+
+    int retVal = 0;
+    int tcpPort = options.tcpPort;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"cs104_scaling_benchmark\",\n");
+    fprintf(out, "  \"cpus\": %li,\n", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(out, "  \"connections\": %i,\n", options.connections);
+    fprintf(out, "  \"bind_workers\": %s,\n", options.bindWorkers ? "true" : "false");
+    fprintf(out, "  \"step_duration_ms\": %i,\n", options.stepDurationInMs);
+    fprintf(out, "  \"queue_size\": %i,\n", options.queueSize);
+    fprintf(out, "  \"results\": [\n");
+
+    int w;
+
+    for (w = 0; w < options.numberOfWorkerCounts; w++) {
+        if (runConfiguration(out, &options, options.workerCounts[w], tcpPort) == false) {
+            retVal = 1;
+            break;
+        }
+
+        /* avoid TIME_WAIT conflicts with the next server instance */
+        tcpPort++;
+    }
+
+    fprintf(out, "\n  ]\n");
+    fprintf(out, "}\n");
+
+    if (out != stdout)
+        fclose(out);
+
+    return retVal;
+}
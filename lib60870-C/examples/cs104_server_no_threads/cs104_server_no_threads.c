@@ -4,11 +4,17 @@
 #include <string.h>
 #include <signal.h>
 
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
 #include "cs104_slave.h"
 
 #include "hal_thread.h"
 #include "hal_time.h"
 
+#define MAX_FDS 64
+
 static bool running = true;
 
 void
@@ -261,7 +267,46 @@ main(int argc, char** argv)
 
     while (running) {
 
+#ifndef _WIN32
+        /* sleep until socket activity, a protocol timeout or the next periodic measurement */
+        int fds[MAX_FDS];
+        struct pollfd pollFds[MAX_FDS];
+
+        int numberOfFds = CS104_Slave_getPollFds(slave, fds, MAX_FDS);
+
+        if (numberOfFds > MAX_FDS)
+            numberOfFds = MAX_FDS;
+
+        int i;
+
+        for (i = 0; i < numberOfFds; i++) {
+            pollFds[i].fd = fds[i];
+            pollFds[i].events = POLLIN;
+            pollFds[i].revents = 0;
+        }
+
+        int timeout = CS104_Slave_getNextTimeoutMs(slave, 1000);
+
+        uint64_t currentTime = Hal_getTimeInMs();
+
+        if (nextSendTime <= currentTime)
+            timeout = 0;
+        else if (nextSendTime - currentTime < (uint64_t) timeout)
+            timeout = (int) (nextSendTime - currentTime);
+
+        if (poll(pollFds, numberOfFds, timeout) > 0) {
+            for (i = 0; i < numberOfFds; i++) {
+                if (pollFds[i].revents & POLLIN)
+                    CS104_Slave_handleReady(slave, pollFds[i].fd, CS104_SLAVE_FD_READABLE);
+                else if (pollFds[i].revents)
+                    CS104_Slave_handleReady(slave, pollFds[i].fd, CS104_SLAVE_FD_ERROR);
+            }
+        }
+
+        CS104_Slave_executePeriodicTasks(slave);
+#else
         CS104_Slave_tick(slave);
+#endif
 
         if (Hal_getTimeInMs() >= nextSendTime) {
 
@@ -278,7 +323,9 @@ main(int argc, char** argv)
             CS104_Slave_enqueueASDU(slave, newAsdu);
         }
 
+#ifdef _WIN32
         Thread_sleep(1);
+#endif
     }
 
     CS104_Slave_stopThreadless(slave);
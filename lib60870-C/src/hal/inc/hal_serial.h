@@ -49,7 +49,10 @@ typedef enum {
 /**
  * \brief Create a new SerialPort instance
  *
- * \param interfaceName identifier or name of the serial interface (e.g. "/dev/ttyS1" or "COM4")
+ * On Linux the interface name "tcp://<host>:<port>" can be used to connect to a serial port of a
+ * terminal server (raw TCP mode) instead of a local serial device.
+ *
+ * \param interfaceName identifier or name of the serial interface (e.g. "/dev/ttyS1", "COM4" or "tcp://10.0.0.5:4001")
  * \param baudRate the baud rate in baud (e.g. 9600)
  * \param dataBits the number of data bits (usually 8)
  * \param parity defines what kind of parity to use ('E' - even parity, 'O' - odd parity, 'N' - no parity)
@@ -110,6 +113,21 @@ SerialPort_discardInBuffer(SerialPort self);
 PAL_API int
 SerialPort_readByte(SerialPort self);
 
+/**
+ * \brief Read the available bytes from the interface
+ *
+ * Waits until at least one byte is received or the timeout elapsed. Then all bytes that are
+ * already received (up to maxSize) are copied to the buffer without further waiting.
+ *
+ * \param buffer the buffer to store the received bytes
+ * \param maxSize the size of the buffer
+ * \param timeoutInMs the maximum time to wait for the first byte in ms (0 - don't wait)
+ *
+ * \return number of read bytes (0 in case of timeout) or -1 in case of an error
+ */
+PAL_API int
+SerialPort_read(SerialPort self, uint8_t* buffer, int maxSize, int timeoutInMs);
+
 /**
  * \brief Write the number of bytes from the buffer to the serial interface
  *
@@ -122,12 +140,129 @@ SerialPort_readByte(SerialPort self);
 PAL_API int
 SerialPort_write(SerialPort self, uint8_t* buffer, int startPos, int numberOfBytes);
 
+/**
+ * \brief Enable or disable asynchronous transmission
+ *
+ * In synchronous mode (default) \ref SerialPort_write returns when all bytes are transmitted. In asynchronous
+ * mode \ref SerialPort_write returns when the bytes are passed to the driver. The time when the transmission
+ * is completed is estimated from the baud rate and the number of bytes (see \ref SerialPort_getTransmitCompleteTime).
+ * A write waits until the minimum line idle time (33 bit times) after the last transmission has elapsed.
+ *
+ * \param asyncTransmit true to enable asynchronous transmission, false otherwise
+ */
+PAL_API void
+SerialPort_setAsyncTransmit(SerialPort self, bool asyncTransmit);
+
+/**
+ * \brief Get the time when the last written byte is (or was) transmitted
+ *
+ * \return the (estimated) transmission complete time (monotonic time in ms)
+ */
+PAL_API uint64_t
+SerialPort_getTransmitCompleteTime(SerialPort self);
+
 /**
  * \brief Get the error code of the last operation
  */
 PAL_API SerialPortError
 SerialPort_getLastError(SerialPort self);
 
+/**
+ * \brief Create two connected serial ports using a pseudo terminal (Linux only)
+ *
+ * The ports are already opened. Everything written to one port can be read from the other port.
+ * The second port is the slave side of the pseudo terminal and can also be opened by other
+ * processes (the device name is the interface name of the port).
+ *
+ * \param port1 returns the first port (master side of the pseudo terminal)
+ * \param port2 returns the second port (slave side of the pseudo terminal)
+ *
+ * \return true in case of success, false otherwise
+ */
+PAL_API bool
+SerialPort_createPtyPair(int baudRate, uint8_t dataBits, char parity, uint8_t stopBits, SerialPort* port1,
+                         SerialPort* port2);
+
+/**
+ * \brief Create two connected serial ports using an in-memory pipe (Linux only)
+ *
+ * The ports are already opened. Everything written to one port can be read from the other port. By default
+ * data is passed without delay (see \ref SerialPort_setBaudRateEmulation).
+ *
+ * \param port1 returns the first port
+ * \param port2 returns the second port
+ *
+ * \return true in case of success, false otherwise
+ */
+PAL_API bool
+SerialPort_createPipePair(int baudRate, uint8_t dataBits, char parity, uint8_t stopBits, SerialPort* port1,
+                          SerialPort* port2);
+
+/**
+ * \brief Emulate the transmission time of the baud rate (only pty, pipe and TCP ports)
+ *
+ * When enabled a synchronous \ref SerialPort_write waits for the time required to transmit the data
+ * (and the line idle time after the previous transmission) before the data is passed to the peer.
+ *
+ * \param enable true to enable the baud rate emulation, false otherwise (default)
+ */
+PAL_API void
+SerialPort_setBaudRateEmulation(SerialPort self, bool enable);
+
+/**
+ * \brief Inject random bit errors into the transmitted data (only pty, pipe and TCP ports)
+ *
+ * \param errorsPerMillionBits probability of a bit error (0 = no errors, default)
+ * \param seed seed of the random generator
+ */
+PAL_API void
+SerialPort_setBitErrorRate(SerialPort self, int errorsPerMillionBits, uint32_t seed);
+
+typedef struct sSerialPortSet* SerialPortSet;
+
+/**
+ * \brief Create a new serial port set to wait for received data on multiple serial ports
+ *
+ * \return the new SerialPortSet instance
+ */
+PAL_API SerialPortSet
+SerialPortSet_create(void);
+
+/**
+ * \brief Add a serial port to the set
+ *
+ * \param port the serial port (has to be opened)
+ * \param parameter user provided parameter that is returned by \ref SerialPortSet_waitReady when the port is ready
+ *
+ * \return true in case of success, false otherwise
+ */
+PAL_API bool
+SerialPortSet_addPort(SerialPortSet self, SerialPort port, void* parameter);
+
+/**
+ * \brief Remove a serial port from the set
+ */
+PAL_API void
+SerialPortSet_removePort(SerialPortSet self, SerialPort port);
+
+/**
+ * \brief Wait until data is received on one or more serial ports of the set
+ *
+ * \param parameters array to store the parameters of the ports with received data
+ * \param maxPorts size of the parameters array
+ * \param timeoutInMs maximum time to wait in ms
+ *
+ * \return number of ports with received data (0 in case of timeout) or -1 in case of an error
+ */
+PAL_API int
+SerialPortSet_waitReady(SerialPortSet self, void** parameters, int maxPorts, int timeoutInMs);
+
+/**
+ * \brief Destroy the serial port set (the serial ports are not closed)
+ */
+PAL_API void
+SerialPortSet_destroy(SerialPortSet self);
+
 /*! @} */
 
 /*! @} */
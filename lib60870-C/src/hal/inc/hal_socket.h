@@ -51,6 +51,12 @@ typedef struct sSocket* Socket;
 /** Opaque reference for a set of server and socket handles */
 typedef struct sHandleSet* HandleSet;
 
+/** Opaque reference for a wakeup signal (file descriptor that can be made readable by another thread) */
+typedef struct sWakeupSignal* WakeupSignal;
+
+/** Maximum length of a numeric IP address string (including the terminating null character) */
+#define SOCKET_MAX_ADDRESS_STRING_LENGTH 46
+
 /** State of an asynchronous connect */
 typedef enum
 {
@@ -83,6 +89,18 @@ Handleset_reset(HandleSet self);
 PAL_API void
 Handleset_addSocket(HandleSet self, const Socket sock);
 
+/**
+ * \brief add a wakeup signal to an existing handle set
+ *
+ * \ref Handleset_waitReady returns when the signal is set. Only one wakeup signal can be added
+ * (until the next \ref Handleset_reset).
+ *
+ * \param self the HandleSet instance
+ * \param signal the wakeup signal to add
+ */
+PAL_API void
+Handleset_addWakeupSignal(HandleSet self, WakeupSignal signal);
+
 /**
  * \brief remove a socket from an existing handle set
  */
@@ -128,6 +146,25 @@ Handleset_destroy(HandleSet self);
 PAL_API ServerSocket
 TcpServerSocket_create(const char* address, int port);
 
+/**
+ * \brief Create a new TcpServerSocket instance that can share the TCP port with other server sockets
+ *
+ * With reusePort the socket is bound with the SO_REUSEPORT option. Several server sockets (e.g. one
+ * for each thread) can listen on the same address and port. The operating system distributes the
+ * incoming connections over the server sockets.
+ *
+ * Implementation of this function is OPTIONAL.
+ *
+ * \param address ip address or hostname to listen on
+ * \param port the TCP port to listen on
+ * \param reusePort true to share the port with other server sockets
+ *
+ * \return the newly create TcpServerSocket instance or NULL when the socket cannot be created
+ *         or reusePort is not supported
+ */
+PAL_API ServerSocket
+TcpServerSocket_createEx(const char* address, int port, bool reusePort);
+
 /**
  * \brief Create an IPv4 UDP socket instance
  *
@@ -232,6 +269,20 @@ Socket_activateTcpKeepAlive(Socket self, int idleTime, int interval, int count);
 PAL_API void
 ServerSocket_setBacklog(ServerSocket self, int backlog);
 
+/**
+ * \brief Get the OS handle (file descriptor) of the server socket
+ *
+ * Can be used to wait for incoming connections in an external event loop (e.g. poll, epoll).
+ *
+ * Implementation of this function is OPTIONAL.
+ *
+ * \param self the server socket instance
+ *
+ * \return the file descriptor or -1 when not available
+ */
+PAL_API int
+ServerSocket_getFd(ServerSocket self);
+
 /**
  * \brief destroy a server socket instance
  *
@@ -298,12 +349,62 @@ Socket_bind(Socket self, const char* srcAddress, int srcPort);
 PAL_API bool
 Socket_connect(Socket self, const char* address, int port);
 
+/**
+ * \brief start a non-blocking connect to a server
+ *
+ * The "address" parameter may either be a hostname or an IP address. IPv6 addresses
+ * are supported when given in numeric form (e.g. "::1"). When a hostname is used the
+ * name lookup is performed synchronously - use \ref Socket_resolveHostname to resolve
+ * the name before when blocking is not acceptable.
+ *
+ * \param self the client socket instance
+ * \param address the IP address or hostname as C string
+ * \param port the TCP port of the application to connect to
+ *
+ * \return true if the connect is in progress or established, false otherwise
+ */
 PAL_API bool
 Socket_connectAsync(Socket self, const char* address, int port);
 
 PAL_API SocketState
 Socket_checkAsyncConnectState(Socket self);
 
+/**
+ * \brief Wait until one of the connection attempts started by \ref Socket_connectAsync has finished
+ *
+ * Returns when at least one socket is connected or its connection attempt failed. The state of
+ * the sockets has to be checked with \ref Socket_checkAsyncConnectState.
+ *
+ * \param sockets the sockets with pending connection attempts (NULL entries are ignored)
+ * \param numberOfSockets number of entries of the sockets array
+ * \param timeoutMs maximum time to wait in ms
+ *
+ * \return number of sockets with a finished connection attempt, 0 on timeout, -1 on error
+ */
+PAL_API int
+Socket_waitAsyncConnect(Socket* sockets, int numberOfSockets, unsigned int timeoutMs);
+
+/**
+ * \brief Resolve a hostname to a list of numeric IP addresses
+ *
+ * IPv4 and IPv6 addresses are returned. The list is ordered for connection racing
+ * (RFC 8305): the address families are interleaved, starting with the family of the
+ * first address returned by the system resolver.
+ *
+ * NOTE: This function blocks while a DNS lookup is in progress. When numericOnly is
+ * true no name lookup is performed and the function fails for non-numeric addresses.
+ *
+ * \param hostname the hostname or numeric IP address as C string
+ * \param numericOnly when true only numeric addresses are accepted
+ * \param addresses buffer for the resulting numeric address strings
+ * \param maxAddresses maximum number of entries in the addresses buffer
+ *
+ * \return number of addresses stored in the buffer, or -1 when the lookup failed
+ */
+PAL_API int
+Socket_resolveHostname(const char* hostname, bool numericOnly, char addresses[][SOCKET_MAX_ADDRESS_STRING_LENGTH],
+                       int maxAddresses);
+
 /**
  * \brief read from socket to local buffer (non-blocking)
  *
@@ -369,6 +470,68 @@ Socket_getPeerAddress(Socket self);
 PAL_API char*
 Socket_getPeerAddressStatic(Socket self, char* peerAddressString);
 
+/**
+ * \brief Get the IP address of the connection peer in binary form
+ *
+ * The address is stored in network byte order. IPv4 addresses that are mapped to IPv6
+ * addresses (::ffff:a.b.c.d) are returned as IPv4 addresses.
+ *
+ * Implementation of this function is OPTIONAL.
+ *
+ * \param self the client, connection or server socket instance
+ * \param address buffer for the address (at least 16 bytes)
+ *
+ * \return 4 for an IPv4 address, 16 for an IPv6 address, 0 when the address is not available
+ */
+PAL_API int
+Socket_getPeerIpAddress(Socket self, uint8_t* address);
+
+/**
+ * \brief Get the OS handle (file descriptor) of the socket
+ *
+ * Can be used to wait for received data in an external event loop (e.g. poll, epoll).
+ *
+ * Implementation of this function is OPTIONAL.
+ *
+ * \param self the client or connection socket instance
+ *
+ * \return the file descriptor or -1 when not available
+ */
+PAL_API int
+Socket_getFd(Socket self);
+
+/**
+ * \brief Create a wakeup signal
+ *
+ * The file descriptor of the wakeup signal becomes readable when the signal is set. It can be
+ * used to wake up a thread that waits for sockets (e.g. with poll or select) from another thread.
+ *
+ * \return the new wakeup signal or NULL on error
+ */
+PAL_API WakeupSignal
+WakeupSignal_create(void);
+
+/**
+ * \brief Get the file descriptor of the wakeup signal (to be used with poll, select, epoll, ...)
+ */
+PAL_API int
+WakeupSignal_getFd(WakeupSignal self);
+
+/**
+ * \brief Set the signal - the file descriptor becomes readable (can be called by any thread)
+ */
+PAL_API void
+WakeupSignal_set(WakeupSignal self);
+
+/**
+ * \brief Reset the signal - the file descriptor is no longer readable
+ */
+PAL_API void
+WakeupSignal_reset(WakeupSignal self);
+
+PAL_API void
+WakeupSignal_destroy(WakeupSignal self);
+
 /**
  * \brief destroy a socket (close the socket if a connection is established)
  *
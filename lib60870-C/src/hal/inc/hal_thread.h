@@ -80,6 +80,19 @@ Thread_destroy(Thread thread);
 PAL_API void
 Thread_sleep(int millies);
 
+/**
+ * \brief Bind the calling thread to a CPU (core)
+ *
+ * The scheduler runs the thread only on the given CPU. Memory that the thread allocates
+ * and touches first is usually placed on the NUMA node of the CPU.
+ *
+ * \param cpu the index of the CPU (starting with 0)
+ *
+ * \return true on success, false when the CPU doesn't exist or the platform doesn't support CPU affinity
+ */
+PAL_API bool
+Thread_setCpuAffinity(int cpu);
+
 PAL_API Semaphore
 Semaphore_create(int initialValue);
 
@@ -87,6 +100,19 @@ Semaphore_create(int initialValue);
 PAL_API void
 Semaphore_wait(Semaphore self);
 
+/**
+ * \brief Wait until the semaphore value is greater than zero or the timeout elapsed
+ *
+ * Can be used by one thread to wait for a Semaphore_post of another thread (semaphore created
+ * with initial value 0).
+ *
+ * \param timeoutInMs maximum time to wait in ms
+ *
+ * \return true when the semaphore value was decreased, false when the timeout elapsed
+ */
+PAL_API bool
+Semaphore_timedWait(Semaphore self, int timeoutInMs);
+
 PAL_API void
 Semaphore_post(Semaphore self);
 
@@ -7,6 +7,10 @@
  *  for libiec61850, libmms, and lib60870.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* posix_openpt, cfmakeraw */
+#endif
+
 #include "lib_memory.h"
 
 #include <stdlib.h>
@@ -15,22 +19,49 @@
 #include <termios.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
 #include <sys/time.h>
 #include <sys/select.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#endif
 
 #include "hal_serial.h"
 #include "hal_time.h"
 
+typedef enum {
+    SERIAL_PORT_TYPE_DEVICE,  /* serial device (termios) */
+    SERIAL_PORT_TYPE_PTY,     /* one end of a pseudo terminal pair */
+    SERIAL_PORT_TYPE_PIPE,    /* one end of an in-memory pipe (socket pair) */
+    SERIAL_PORT_TYPE_TCP      /* serial-over-TCP (raw mode terminal server) */
+} SerialPortType;
+
+#define SERIAL_PORT_TCP_PREFIX "tcp://"
+
 struct sSerialPort {
     char interfaceName[100];
+    SerialPortType type;
     int fd;
     int baudRate;
     uint8_t dataBits;
     char parity;
     uint8_t stopBits;
     uint64_t lastSentTime;
+    bool asyncTransmit;
+    uint64_t transmitCompleteTime; /* estimated time when the last character is transmitted (monotonic us) */
     struct timeval timeout;
     SerialPortError lastError;
+
+    bool emulateBaudRate; /* only for virtual ports */
+    int bitErrorRate; /* bit errors per million bits (only for virtual ports) */
+    uint32_t randomState;
 };
 
 SerialPort
@@ -39,16 +70,26 @@ SerialPort_create(const char* interfaceName, int baudRate, uint8_t dataBits, cha
     SerialPort self = (SerialPort) GLOBAL_MALLOC(sizeof(struct sSerialPort));
 
     if (self != NULL) {
+        self->type = SERIAL_PORT_TYPE_DEVICE;
         self->fd = -1;
         self->baudRate = baudRate;
         self->dataBits = dataBits;
         self->stopBits = stopBits;
         self->parity = parity;
         self->lastSentTime = 0;
+        self->asyncTransmit = false;
+        self->transmitCompleteTime = 0;
         self->timeout.tv_sec = 0;
         self->timeout.tv_usec = 100000; /* 100 ms */
         strncpy(self->interfaceName, interfaceName, 99);
+        self->interfaceName[99] = 0;
         self->lastError = SERIAL_PORT_ERROR_NONE;
+        self->emulateBaudRate = false;
+        self->bitErrorRate = 0;
+        self->randomState = 1;
+
+        if (strncmp(self->interfaceName, SERIAL_PORT_TCP_PREFIX, strlen(SERIAL_PORT_TCP_PREFIX)) == 0)
+            self->type = SERIAL_PORT_TYPE_TCP;
     }
 
     return self;
@@ -62,9 +103,83 @@ SerialPort_destroy(SerialPort self)
     }
 }
 
+static bool
+openTcpPort(SerialPort self)
+{
+    char hostname[100];
+    const char* port;
+
+    strncpy(hostname, self->interfaceName + strlen(SERIAL_PORT_TCP_PREFIX), sizeof(hostname) - 1);
+    hostname[sizeof(hostname) - 1] = 0;
+
+    char* separator = strrchr(hostname, ':');
+
+    if (separator == NULL) {
+        self->lastError = SERIAL_PORT_ERROR_INVALID_ARGUMENT;
+        return false;
+    }
+
+    *separator = 0;
+    port = separator + 1;
+
+    struct addrinfo hints;
+    struct addrinfo* addresses = NULL;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(hostname, port, &hints, &addresses) != 0) {
+        self->lastError = SERIAL_PORT_ERROR_INVALID_ARGUMENT;
+        return false;
+    }
+
+    struct addrinfo* address;
+
+    for (address = addresses; address != NULL; address = address->ai_next) {
+        self->fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+        if (self->fd == -1)
+            continue;
+
+        if (connect(self->fd, address->ai_addr, address->ai_addrlen) == 0)
+            break;
+
+        close(self->fd);
+        self->fd = -1;
+    }
+
+    freeaddrinfo(addresses);
+
+    if (self->fd == -1) {
+        self->lastError = SERIAL_PORT_ERROR_OPEN_FAILED;
+        return false;
+    }
+
+    /* every frame is written with a single call - don't wait for more data */
+    int flag = 1;
+    setsockopt(self->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    fcntl(self->fd, F_SETFL, fcntl(self->fd, F_GETFL) | O_NONBLOCK);
+
+    return true;
+}
+
 bool
 SerialPort_open(SerialPort self)
 {
+    if (self->type != SERIAL_PORT_TYPE_DEVICE) {
+        /* pty and pipe ports are opened when created */
+        if (self->fd != -1)
+            return true;
+
+        if (self->type == SERIAL_PORT_TYPE_TCP)
+            return openTcpPort(self);
+
+        self->lastError = SERIAL_PORT_ERROR_OPEN_FAILED;
+        return false;
+    }
+
     self->fd = open(self->interfaceName, O_RDWR | O_NOCTTY | O_NDELAY | O_EXCL);
 
     if (self->fd == -1) {
@@ -192,7 +307,11 @@ SerialPort_close(SerialPort self)
 {
     if (self->fd != -1) {
         close(self->fd);
-        self->fd = 0;
+
+        if (self->type == SERIAL_PORT_TYPE_DEVICE)
+            self->fd = 0;
+        else
+            self->fd = -1;
     }
 }
 
@@ -205,7 +324,15 @@ SerialPort_getBaudRate(SerialPort self)
 void
 SerialPort_discardInBuffer(SerialPort self)
 {
-    tcflush(self->fd, TCIOFLUSH);
+    if (self->type == SERIAL_PORT_TYPE_DEVICE) {
+        tcflush(self->fd, TCIOFLUSH);
+    }
+    else {
+        uint8_t buffer[256];
+
+        /* virtual ports are non-blocking */
+        while (read(self->fd, buffer, sizeof(buffer)) > 0);
+    }
 }
 
 void
@@ -247,6 +374,222 @@ SerialPort_readByte(SerialPort self)
     }
 }
 
+int
+SerialPort_read(SerialPort self, uint8_t* buffer, int maxSize, int timeoutInMs)
+{
+    struct pollfd fds[1];
+
+    self->lastError = SERIAL_PORT_ERROR_NONE;
+
+    fds[0].fd = self->fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+
+    int ret = poll(fds, 1, timeoutInMs);
+
+    if (ret == -1) {
+        if (errno == EINTR)
+            return 0;
+
+        self->lastError = SERIAL_PORT_ERROR_UNKNOWN;
+        return -1;
+    }
+    else if (ret == 0)
+        return 0;
+
+    /* the port is opened with O_NDELAY - only the bytes already received are returned */
+    ssize_t readBytes = read(self->fd, buffer, maxSize);
+
+    if (readBytes == -1) {
+        if ((errno == EAGAIN) || (errno == EINTR))
+            return 0;
+
+        self->lastError = SERIAL_PORT_ERROR_UNKNOWN;
+        return -1;
+    }
+
+    return (int) readBytes;
+}
+
+static uint64_t
+getMonotonicTimeInUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/**
+ * Get the time in us required to transmit the given number of bits
+ */
+static uint64_t
+getTransmitTime(SerialPort self, int numberOfBits)
+{
+    int baudRate = (self->baudRate > 0) ? self->baudRate : 9600;
+
+    return (((uint64_t) numberOfBits * 1000000) + baudRate - 1) / (uint64_t) baudRate;
+}
+
+static int
+getBitsPerCharacter(SerialPort self)
+{
+    /* start bit + data bits + parity bit + stop bits */
+    return 1 + self->dataBits + ((self->parity == 'N') ? 0 : 1) + self->stopBits;
+}
+
+void
+SerialPort_setAsyncTransmit(SerialPort self, bool asyncTransmit)
+{
+    self->asyncTransmit = asyncTransmit;
+}
+
+uint64_t
+SerialPort_getTransmitCompleteTime(SerialPort self)
+{
+    return (self->transmitCompleteTime + 999) / 1000;
+}
+
+static uint32_t
+nextRandom(SerialPort self)
+{
+    /* xorshift32 */
+    self->randomState ^= self->randomState << 13;
+    self->randomState ^= self->randomState >> 17;
+    self->randomState ^= self->randomState << 5;
+
+    return self->randomState;
+}
+
+static void
+injectBitErrors(SerialPort self, uint8_t* buffer, int bufSize)
+{
+    int i;
+
+    for (i = 0; i < bufSize * 8; i++) {
+        if ((nextRandom(self) % 1000000) < (uint32_t) self->bitErrorRate)
+            buffer[i / 8] ^= (uint8_t) (1 << (i % 8));
+    }
+}
+
+static int
+writeAll(SerialPort self, uint8_t* buffer, int bufSize)
+{
+    uint8_t errorBuffer[512];
+
+    if ((self->bitErrorRate > 0) && (bufSize <= (int) sizeof(errorBuffer))) {
+        memcpy(errorBuffer, buffer, bufSize);
+        injectBitErrors(self, errorBuffer, bufSize);
+        buffer = errorBuffer;
+    }
+
+    int writtenBytes = 0;
+
+    while (writtenBytes < bufSize) {
+        ssize_t result = write(self->fd, buffer + writtenBytes, bufSize - writtenBytes);
+
+        if (result == -1) {
+            if ((errno == EAGAIN) || (errno == EINTR)) {
+                /* output buffer of the driver is full */
+                struct pollfd fds[1];
+
+                fds[0].fd = self->fd;
+                fds[0].events = POLLOUT;
+                fds[0].revents = 0;
+
+                if (poll(fds, 1, 100) > 0)
+                    continue;
+            }
+
+            self->lastError = SERIAL_PORT_ERROR_UNKNOWN;
+
+            break;
+        }
+
+        writtenBytes += result;
+    }
+
+    return writtenBytes;
+}
+
+static void
+sleepUntil(uint64_t timeInUs)
+{
+    uint64_t currentTime = getMonotonicTimeInUs();
+
+    if (timeInUs > currentTime) {
+        struct timespec waitTime;
+
+        waitTime.tv_sec = (timeInUs - currentTime) / 1000000;
+        waitTime.tv_nsec = ((timeInUs - currentTime) % 1000000) * 1000;
+
+        nanosleep(&waitTime, NULL);
+    }
+}
+
+/* synchronous write for pty, pipe and TCP ports */
+static int
+writeVirtual(SerialPort self, uint8_t* buffer, int bufSize)
+{
+    if (self->emulateBaudRate) {
+        /* the data is passed to the peer when the last character would be transmitted */
+        uint64_t startTime = getMonotonicTimeInUs();
+
+        uint64_t lineIdleTime = self->transmitCompleteTime + getTransmitTime(self, 33);
+
+        if (lineIdleTime > startTime)
+            startTime = lineIdleTime;
+
+        self->transmitCompleteTime = startTime + getTransmitTime(self, bufSize * getBitsPerCharacter(self));
+
+        sleepUntil(self->transmitCompleteTime);
+    }
+
+    int writtenBytes = writeAll(self, buffer, bufSize);
+
+    if (self->emulateBaudRate == false)
+        self->transmitCompleteTime = getMonotonicTimeInUs();
+
+    self->lastSentTime = Hal_getMonotonicTimeInMs();
+
+    if (self->lastError != SERIAL_PORT_ERROR_NONE)
+        return -1;
+
+    return writtenBytes;
+}
+
+static int
+writeAsync(SerialPort self, uint8_t* buffer, int bufSize)
+{
+    uint64_t currentTime = getMonotonicTimeInUs();
+
+    /* assure minimum line idle time of 33 bit between two frames (FT 1.2) */
+    uint64_t lineIdleTime = self->transmitCompleteTime + getTransmitTime(self, 33);
+
+    if (lineIdleTime > currentTime) {
+        struct timespec waitTime;
+
+        waitTime.tv_sec = (lineIdleTime - currentTime) / 1000000;
+        waitTime.tv_nsec = ((lineIdleTime - currentTime) % 1000000) * 1000;
+
+        nanosleep(&waitTime, NULL);
+
+        currentTime = lineIdleTime;
+    }
+
+    int writtenBytes = writeAll(self, buffer, bufSize);
+
+    self->transmitCompleteTime = currentTime + getTransmitTime(self, writtenBytes * getBitsPerCharacter(self));
+
+    self->lastSentTime = Hal_getMonotonicTimeInMs();
+
+    if (self->lastError != SERIAL_PORT_ERROR_NONE)
+        return -1;
+
+    return writtenBytes;
+}
+
 int
 SerialPort_write(SerialPort self, uint8_t* buffer, int startPos, int bufSize)
 {
@@ -254,11 +597,292 @@ SerialPort_write(SerialPort self, uint8_t* buffer, int startPos, int bufSize)
 
     self->lastError = SERIAL_PORT_ERROR_NONE;
 
+    if (self->asyncTransmit)
+        return writeAsync(self, buffer + startPos, bufSize);
+
+    if (self->type != SERIAL_PORT_TYPE_DEVICE)
+        return writeVirtual(self, buffer + startPos, bufSize);
+
     ssize_t result = write(self->fd, buffer + startPos, bufSize);
 
     tcdrain(self->fd);
 
     self->lastSentTime = Hal_getMonotonicTimeInMs();
+    self->transmitCompleteTime = getMonotonicTimeInUs();
+
+    return result;
+}
+
+void
+SerialPort_setBaudRateEmulation(SerialPort self, bool enable)
+{
+    if (self->type != SERIAL_PORT_TYPE_DEVICE)
+        self->emulateBaudRate = enable;
+}
+
+void
+SerialPort_setBitErrorRate(SerialPort self, int errorsPerMillionBits, uint32_t seed)
+{
+    if (self->type != SERIAL_PORT_TYPE_DEVICE) {
+        self->bitErrorRate = (errorsPerMillionBits < 0) ? 0 : errorsPerMillionBits;
+        self->randomState = (seed == 0) ? 1 : seed;
+    }
+}
+
+static bool
+createVirtualPair(SerialPortType type, int fd1, int fd2, const char* name2, int baudRate, uint8_t dataBits,
+                  char parity, uint8_t stopBits, SerialPort* port1, SerialPort* port2)
+{
+    *port1 = SerialPort_create((type == SERIAL_PORT_TYPE_PTY) ? "pty" : "pipe", baudRate, dataBits, parity, stopBits);
+    *port2 = SerialPort_create(name2, baudRate, dataBits, parity, stopBits);
+
+    if ((*port1 == NULL) || (*port2 == NULL)) {
+        SerialPort_destroy(*port1);
+        SerialPort_destroy(*port2);
+
+        *port1 = NULL;
+        *port2 = NULL;
+
+        close(fd1);
+        close(fd2);
+
+        return false;
+    }
+
+    fcntl(fd1, F_SETFL, fcntl(fd1, F_GETFL) | O_NONBLOCK);
+    fcntl(fd2, F_SETFL, fcntl(fd2, F_GETFL) | O_NONBLOCK);
+
+    (*port1)->type = type;
+    (*port1)->fd = fd1;
+
+    (*port2)->type = type;
+    (*port2)->fd = fd2;
+
+    return true;
+}
+
+bool
+SerialPort_createPtyPair(int baudRate, uint8_t dataBits, char parity, uint8_t stopBits, SerialPort* port1,
+                         SerialPort* port2)
+{
+    int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (masterFd == -1)
+        return false;
+
+    if ((grantpt(masterFd) != 0) || (unlockpt(masterFd) != 0)) {
+        close(masterFd);
+        return false;
+    }
+
+    const char* slaveName = ptsname(masterFd);
+
+    int slaveFd = (slaveName != NULL) ? open(slaveName, O_RDWR | O_NOCTTY) : -1;
+
+    if (slaveFd == -1) {
+        close(masterFd);
+        return false;
+    }
+
+    /* raw mode - no echo and no character translation */
+    struct termios tios;
+
+    tcgetattr(slaveFd, &tios);
+    cfmakeraw(&tios);
+    tcsetattr(slaveFd, TCSANOW, &tios);
+
+    return createVirtualPair(SERIAL_PORT_TYPE_PTY, masterFd, slaveFd, slaveName, baudRate, dataBits, parity, stopBits,
+                             port1, port2);
+}
+
+bool
+SerialPort_createPipePair(int baudRate, uint8_t dataBits, char parity, uint8_t stopBits, SerialPort* port1,
+                          SerialPort* port2)
+{
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        return false;
+
+    return createVirtualPair(SERIAL_PORT_TYPE_PIPE, fds[0], fds[1], "pipe", baudRate, dataBits, parity, stopBits,
+                             port1, port2);
+}
+
+#if defined(__linux__)
+
+struct sSerialPortSet {
+    int epollFd;
+};
+
+SerialPortSet
+SerialPortSet_create(void)
+{
+    SerialPortSet self = (SerialPortSet) GLOBAL_MALLOC(sizeof(struct sSerialPortSet));
+
+    if (self) {
+        self->epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+        if (self->epollFd == -1) {
+            GLOBAL_FREEMEM(self);
+            self = NULL;
+        }
+    }
+
+    return self;
+}
+
+bool
+SerialPortSet_addPort(SerialPortSet self, SerialPort port, void* parameter)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+
+    event.events = EPOLLIN;
+    event.data.ptr = parameter;
+
+    return (epoll_ctl(self->epollFd, EPOLL_CTL_ADD, port->fd, &event) == 0);
+}
+
+void
+SerialPortSet_removePort(SerialPortSet self, SerialPort port)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+
+    epoll_ctl(self->epollFd, EPOLL_CTL_DEL, port->fd, &event);
+}
+
+int
+SerialPortSet_waitReady(SerialPortSet self, void** parameters, int maxPorts, int timeoutInMs)
+{
+    struct epoll_event events[64];
+
+    if (maxPorts > 64)
+        maxPorts = 64;
+
+    int result = epoll_wait(self->epollFd, events, maxPorts, timeoutInMs);
+
+    if (result == -1)
+        return (errno == EINTR) ? 0 : -1;
+
+    int i;
+
+    for (i = 0; i < result; i++)
+        parameters[i] = events[i].data.ptr;
 
     return result;
 }
+
+void
+SerialPortSet_destroy(SerialPortSet self)
+{
+    if (self) {
+        close(self->epollFd);
+        GLOBAL_FREEMEM(self);
+    }
+}
+
+#else
+
+struct sSerialPortSet {
+    struct pollfd* fds;
+    void** parameters;
+    int numberOfPorts;
+    int maxNumberOfPorts;
+};
+
+SerialPortSet
+SerialPortSet_create(void)
+{
+    SerialPortSet self = (SerialPortSet) GLOBAL_CALLOC(1, sizeof(struct sSerialPortSet));
+
+    return self;
+}
+
+bool
+SerialPortSet_addPort(SerialPortSet self, SerialPort port, void* parameter)
+{
+    if (self->numberOfPorts == self->maxNumberOfPorts) {
+        int newSize = (self->maxNumberOfPorts == 0) ? 8 : (self->maxNumberOfPorts * 2);
+
+        struct pollfd* newFds = (struct pollfd*) GLOBAL_MALLOC(newSize * sizeof(struct pollfd));
+        void** newParameters = (void**) GLOBAL_MALLOC(newSize * sizeof(void*));
+
+        if ((newFds == NULL) || (newParameters == NULL)) {
+            GLOBAL_FREEMEM(newFds);
+            GLOBAL_FREEMEM(newParameters);
+            return false;
+        }
+
+        if (self->numberOfPorts > 0) {
+            memcpy(newFds, self->fds, self->numberOfPorts * sizeof(struct pollfd));
+            memcpy(newParameters, self->parameters, self->numberOfPorts * sizeof(void*));
+        }
+
+        GLOBAL_FREEMEM(self->fds);
+        GLOBAL_FREEMEM(self->parameters);
+
+        self->fds = newFds;
+        self->parameters = newParameters;
+        self->maxNumberOfPorts = newSize;
+    }
+
+    self->fds[self->numberOfPorts].fd = port->fd;
+    self->fds[self->numberOfPorts].events = POLLIN;
+    self->fds[self->numberOfPorts].revents = 0;
+    self->parameters[self->numberOfPorts] = parameter;
+
+    self->numberOfPorts++;
+
+    return true;
+}
+
+void
+SerialPortSet_removePort(SerialPortSet self, SerialPort port)
+{
+    int i;
+
+    for (i = 0; i < self->numberOfPorts; i++) {
+        if (self->fds[i].fd == port->fd) {
+            self->numberOfPorts--;
+
+            self->fds[i] = self->fds[self->numberOfPorts];
+            self->parameters[i] = self->parameters[self->numberOfPorts];
+
+            break;
+        }
+    }
+}
+
+int
+SerialPortSet_waitReady(SerialPortSet self, void** parameters, int maxPorts, int timeoutInMs)
+{
+    int result = poll(self->fds, self->numberOfPorts, timeoutInMs);
+
+    if (result == -1)
+        return (errno == EINTR) ? 0 : -1;
+
+    int readyPorts = 0;
+    int i;
+
+    for (i = 0; (i < self->numberOfPorts) && (readyPorts < maxPorts); i++) {
+        if (self->fds[i].revents & POLLIN)
+            parameters[readyPorts++] = self->parameters[i];
+    }
+
+    return readyPorts;
+}
+
+void
+SerialPortSet_destroy(SerialPortSet self)
+{
+    if (self) {
+        GLOBAL_FREEMEM(self->fds);
+        GLOBAL_FREEMEM(self->parameters);
+        GLOBAL_FREEMEM(self);
+    }
+}
+
+#endif /* defined(__linux__) */
@@ -30,7 +30,10 @@ struct sSerialPort {
 	char parity;
 	uint8_t stopBits;
 	uint64_t lastSentTime;
+	bool asyncTransmit;
+	uint64_t transmitCompleteTime; /* estimated time when the last character is transmitted (monotonic us) */
 	int timeout;
+	int readTimeout; /* timeout configured by SerialPort_read or -1 */
 	SerialPortError lastError;
 };
 
@@ -46,7 +49,10 @@ SerialPort_create(const char* interfaceName, int baudRate, uint8_t dataBits, cha
 		self->stopBits = stopBits;
 		self->parity = parity;
 		self->lastSentTime = 0;
+		self->asyncTransmit = false;
+		self->transmitCompleteTime = 0;
 		self->timeout = 100; /* 100 ms */
+		self->readTimeout = -1;
 		strncpy(self->interfaceName, interfaceName, 100);
 		self->lastError = SERIAL_PORT_ERROR_NONE;
 	}
@@ -66,11 +72,25 @@ SerialPort_destroy(SerialPort self)
 	}
 }
 
+static BOOL
+setDefaultTimeouts(SerialPort self)
+{
+	COMMTIMEOUTS timeouts = { 0 };
+
+	timeouts.ReadIntervalTimeout = 100;
+	timeouts.ReadTotalTimeoutConstant = 50;
+	timeouts.ReadTotalTimeoutMultiplier = 10;
+	timeouts.WriteTotalTimeoutConstant = 100;
+	timeouts.WriteTotalTimeoutMultiplier = 10;
+
+	self->readTimeout = -1;
+
+	return SetCommTimeouts(self->comPort, &timeouts);
+}
+
 bool
 SerialPort_open(SerialPort self)
 {
-    COMMTIMEOUTS timeouts = { 0 };
-
 	self->comPort = CreateFile(self->interfaceName, GENERIC_READ | GENERIC_WRITE,
 		0, NULL, OPEN_EXISTING, 0, NULL);
 
@@ -154,13 +174,7 @@ SerialPort_open(SerialPort self)
 		goto exit_error;
 	}
 
-	timeouts.ReadIntervalTimeout = 100;
-	timeouts.ReadTotalTimeoutConstant = 50;
-	timeouts.ReadTotalTimeoutMultiplier = 10;
-	timeouts.WriteTotalTimeoutConstant = 100;
-	timeouts.WriteTotalTimeoutMultiplier = 10;
-
-	status = SetCommTimeouts(self->comPort, &timeouts);
+	status = setDefaultTimeouts(self);
 
 	if (status == false) {
 		self->lastError = SERIAL_PORT_ERROR_UNKNOWN;
@@ -223,6 +237,40 @@ SerialPort_getLastError(SerialPort self)
 	return self->lastError;
 }
 
+bool
+SerialPort_createPtyPair(int baudRate, uint8_t dataBits, char parity, uint8_t stopBits, SerialPort* port1,
+                         SerialPort* port2)
+{
+	/* not supported */
+	*port1 = NULL;
+	*port2 = NULL;
+
+	return false;
+}
+
+bool
+SerialPort_createPipePair(int baudRate, uint8_t dataBits, char parity, uint8_t stopBits, SerialPort* port1,
+                          SerialPort* port2)
+{
+	/* not supported */
+	*port1 = NULL;
+	*port2 = NULL;
+
+	return false;
+}
+
+void
+SerialPort_setBaudRateEmulation(SerialPort self, bool enable)
+{
+	/* only supported by virtual ports */
+}
+
+void
+SerialPort_setBitErrorRate(SerialPort self, int errorsPerMillionBits, uint32_t seed)
+{
+	/* only supported by virtual ports */
+}
+
 int
 SerialPort_readByte(SerialPort self)
 {
@@ -230,6 +278,9 @@ SerialPort_readByte(SerialPort self)
 
 	DWORD bytesRead = 0;
 
+	if (self->readTimeout != -1)
+		setDefaultTimeouts(self);
+
 	BOOL status = ReadFile(self->comPort, buf, 1, &bytesRead, NULL);
 
 	if (status == false) {
@@ -245,13 +296,94 @@ SerialPort_readByte(SerialPort self)
 		return (int) buf[0];
 }
 
+int
+SerialPort_read(SerialPort self, uint8_t* buffer, int maxSize, int timeoutInMs)
+{
+	DWORD bytesRead = 0;
+
+	if (self->readTimeout != timeoutInMs) {
+		COMMTIMEOUTS timeouts = { 0 };
+
+		/* return immediately when data is available, otherwise wait for the first byte until timeout */
+		timeouts.ReadIntervalTimeout = MAXDWORD;
+
+		if (timeoutInMs > 0) {
+			timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+			timeouts.ReadTotalTimeoutConstant = timeoutInMs;
+		}
+
+		timeouts.WriteTotalTimeoutConstant = 100;
+		timeouts.WriteTotalTimeoutMultiplier = 10;
+
+		if (SetCommTimeouts(self->comPort, &timeouts) == false) {
+			self->lastError = SERIAL_PORT_ERROR_UNKNOWN;
+			return -1;
+		}
+
+		self->readTimeout = timeoutInMs;
+	}
+
+	BOOL status = ReadFile(self->comPort, buffer, maxSize, &bytesRead, NULL);
+
+	if (status == false) {
+		self->lastError = SERIAL_PORT_ERROR_UNKNOWN;
+		return -1;
+	}
+
+	self->lastError = SERIAL_PORT_ERROR_NONE;
+
+	return (int) bytesRead;
+}
+
+/**
+ * Get the time in us required to transmit the given number of bits
+ */
+static uint64_t
+getTransmitTime(SerialPort self, int numberOfBits)
+{
+	int baudRate = (self->baudRate > 0) ? self->baudRate : 9600;
+
+	return (((uint64_t) numberOfBits * 1000000) + baudRate - 1) / (uint64_t) baudRate;
+}
+
+static int
+getBitsPerCharacter(SerialPort self)
+{
+	/* start bit + data bits + parity bit + stop bits */
+	return 1 + self->dataBits + ((self->parity == 'N') ? 0 : 1) + self->stopBits;
+}
+
+void
+SerialPort_setAsyncTransmit(SerialPort self, bool asyncTransmit)
+{
+	self->asyncTransmit = asyncTransmit;
+}
+
+uint64_t
+SerialPort_getTransmitCompleteTime(SerialPort self)
+{
+	return (self->transmitCompleteTime + 999) / 1000;
+}
+
 int
 SerialPort_write(SerialPort self, uint8_t* buffer, int startPos, int bufSize)
 {
-	//TODO assure minimum line idle time
+	//TODO assure minimum line idle time in synchronous mode
 
     self->lastError = SERIAL_PORT_ERROR_NONE;
 
+	uint64_t currentTime = Hal_getMonotonicTimeInMs() * 1000;
+
+	if (self->asyncTransmit) {
+		/* assure minimum line idle time of 33 bit between two frames (FT 1.2) */
+		uint64_t lineIdleTime = self->transmitCompleteTime + getTransmitTime(self, 33);
+
+		if (lineIdleTime > currentTime) {
+			Sleep((DWORD) ((lineIdleTime - currentTime + 999) / 1000));
+			currentTime = lineIdleTime;
+		}
+	}
+
 	DWORD numberOfBytesWritten;
 
 	BOOL status = WriteFile(self->comPort, buffer + startPos, bufSize, &numberOfBytesWritten, NULL);
@@ -261,13 +393,125 @@ SerialPort_write(SerialPort self, uint8_t* buffer, int startPos, int bufSize)
 	    return -1;
 	}
 
-	status = FlushFileBuffers(self->comPort);
+	if (self->asyncTransmit) {
+		self->transmitCompleteTime = currentTime + getTransmitTime(self, numberOfBytesWritten * getBitsPerCharacter(self));
+	}
+	else {
+		status = FlushFileBuffers(self->comPort);
+
+		if (status == false) {
+			printf("FlushFileBuffers failed!\n");
+		}
 
-	if (status == false) {
-		printf("FlushFileBuffers failed!\n");
+		self->transmitCompleteTime = Hal_getMonotonicTimeInMs() * 1000;
 	}
 
 	self->lastSentTime = Hal_getMonotonicTimeInMs();
 
 	return (int) numberOfBytesWritten;
 }
+
+struct sSerialPortSet {
+	SerialPort* ports;
+	void** parameters;
+	int numberOfPorts;
+	int maxNumberOfPorts;
+};
+
+SerialPortSet
+SerialPortSet_create(void)
+{
+	SerialPortSet self = (SerialPortSet) GLOBAL_CALLOC(1, sizeof(struct sSerialPortSet));
+
+	return self;
+}
+
+bool
+SerialPortSet_addPort(SerialPortSet self, SerialPort port, void* parameter)
+{
+	if (self->numberOfPorts == self->maxNumberOfPorts) {
+		int newSize = (self->maxNumberOfPorts == 0) ? 8 : (self->maxNumberOfPorts * 2);
+
+		SerialPort* newPorts = (SerialPort*) GLOBAL_MALLOC(newSize * sizeof(SerialPort));
+		void** newParameters = (void**) GLOBAL_MALLOC(newSize * sizeof(void*));
+
+		if ((newPorts == NULL) || (newParameters == NULL)) {
+			GLOBAL_FREEMEM(newPorts);
+			GLOBAL_FREEMEM(newParameters);
+			return false;
+		}
+
+		if (self->numberOfPorts > 0) {
+			memcpy(newPorts, self->ports, self->numberOfPorts * sizeof(SerialPort));
+			memcpy(newParameters, self->parameters, self->numberOfPorts * sizeof(void*));
+		}
+
+		GLOBAL_FREEMEM(self->ports);
+		GLOBAL_FREEMEM(self->parameters);
+
+		self->ports = newPorts;
+		self->parameters = newParameters;
+		self->maxNumberOfPorts = newSize;
+	}
+
+	self->ports[self->numberOfPorts] = port;
+	self->parameters[self->numberOfPorts] = parameter;
+
+	self->numberOfPorts++;
+
+	return true;
+}
+
+void
+SerialPortSet_removePort(SerialPortSet self, SerialPort port)
+{
+	int i;
+
+	for (i = 0; i < self->numberOfPorts; i++) {
+		if (self->ports[i] == port) {
+			self->numberOfPorts--;
+
+			self->ports[i] = self->ports[self->numberOfPorts];
+			self->parameters[i] = self->parameters[self->numberOfPorts];
+
+			break;
+		}
+	}
+}
+
+int
+SerialPortSet_waitReady(SerialPortSet self, void** parameters, int maxPorts, int timeoutInMs)
+{
+	/* there is no readiness notification for multiple COM ports - check the input queues */
+	uint64_t timeout = Hal_getMonotonicTimeInMs() + timeoutInMs;
+
+	while (true) {
+		int readyPorts = 0;
+		int i;
+
+		for (i = 0; (i < self->numberOfPorts) && (readyPorts < maxPorts); i++) {
+			DWORD errors;
+			COMSTAT status;
+
+			if (ClearCommError(self->ports[i]->comPort, &errors, &status)) {
+				if (status.cbInQue > 0)
+					parameters[readyPorts++] = self->parameters[i];
+			}
+		}
+
+		if ((readyPorts > 0) || (Hal_getMonotonicTimeInMs() >= timeout))
+			return readyPorts;
+
+		Sleep(1);
+	}
+}
+
+void
+SerialPortSet_destroy(SerialPortSet self)
+{
+	if (self) {
+		GLOBAL_FREEMEM(self->ports);
+		GLOBAL_FREEMEM(self->parameters);
+		GLOBAL_FREEMEM(self);
+	}
+}
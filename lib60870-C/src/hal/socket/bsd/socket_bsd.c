@@ -62,6 +62,7 @@ struct sUdpSocket
 struct sHandleSet
 {
     LinkedList sockets;
+    int wakeupFd; /* -1 = no wakeup signal */
     bool pollfdIsUpdated;
     struct pollfd* fds;
     int nfds;
@@ -75,6 +76,7 @@ Handleset_new(void)
     if (self)
     {
         self->sockets = LinkedList_create();
+        self->wakeupFd = -1;
         self->pollfdIsUpdated = false;
         self->fds = NULL;
         self->nfds = 0;
@@ -94,6 +96,8 @@ Handleset_reset(HandleSet self)
             self->sockets = LinkedList_create();
             self->pollfdIsUpdated = false;
         }
+
+        self->wakeupFd = -1;
     }
 }
 
@@ -107,6 +111,16 @@ Handleset_addSocket(HandleSet self, const Socket sock)
     }
 }
 
+void
+Handleset_addWakeupSignal(HandleSet self, WakeupSignal signal)
+{
+    if (self != NULL && signal != NULL)
+    {
+        self->wakeupFd = WakeupSignal_getFd(signal);
+        self->pollfdIsUpdated = false;
+    }
+}
+
 void
 Handleset_removeSocket(HandleSet self, const Socket sock)
 {
@@ -129,13 +143,18 @@ Handleset_waitReady(HandleSet self, unsigned int timeoutMs)
             self->fds = NULL;
         }
 
-        self->nfds = LinkedList_size(self->sockets);
+        int numberOfSockets = LinkedList_size(self->sockets);
+
+        self->nfds = numberOfSockets;
+
+        if (self->wakeupFd != -1)
+            self->nfds++;
 
         self->fds = GLOBAL_CALLOC(self->nfds, sizeof(struct pollfd));
 
         int i;
 
-        for (i = 0; i < self->nfds; i++)
+        for (i = 0; i < numberOfSockets; i++)
         {
             LinkedList sockElem = LinkedList_get(self->sockets, i);
 
@@ -151,6 +170,12 @@ Handleset_waitReady(HandleSet self, unsigned int timeoutMs)
             }
         }
 
+        if (self->wakeupFd != -1)
+        {
+            self->fds[numberOfSockets].fd = self->wakeupFd;
+            self->fds[numberOfSockets].events = POLL_IN;
+        }
+
         self->pollfdIsUpdated = true;
     }
 
@@ -236,6 +261,66 @@ prepareAddress(const char* address, int port, struct sockaddr_in* sockaddr)
     return true;
 }
 
+static bool
+prepareRemoteAddress(const char* address, int port, struct sockaddr_storage* sockaddr, socklen_t* sockaddrLength)
+{
+    struct in6_addr ipv6Address;
+
+    memset((char*)sockaddr, 0, sizeof(struct sockaddr_storage));
+
+    /* IPv6 is only used for numeric addresses - hostnames are resolved to IPv4 as before */
+    if ((address != NULL) && (inet_pton(AF_INET6, address, &ipv6Address) == 1))
+    {
+        struct sockaddr_in6* ipv6SockAddr = (struct sockaddr_in6*)sockaddr;
+
+        ipv6SockAddr->sin6_family = AF_INET6;
+        ipv6SockAddr->sin6_addr = ipv6Address;
+        ipv6SockAddr->sin6_port = htons(port);
+
+        *sockaddrLength = sizeof(struct sockaddr_in6);
+
+        return true;
+    }
+
+    *sockaddrLength = sizeof(struct sockaddr_in);
+
+    return prepareAddress(address, port, (struct sockaddr_in*)sockaddr);
+}
+
+/* replace the socket by a socket of another address family (keeps the file descriptor number) */
+static bool
+setSocketAddressFamily(Socket self, int family)
+{
+    struct sockaddr_storage localAddress;
+    socklen_t addrLen = sizeof(localAddress);
+
+    if (self->fd == -1)
+        return false;
+
+    if (getsockname(self->fd, (struct sockaddr*)&localAddress, &addrLen) == 0)
+    {
+        if (localAddress.ss_family == family)
+            return true;
+
+        /* the socket was bound by Socket_bind - replacing it would lose the local address */
+        if ((localAddress.ss_family == AF_INET) && (((struct sockaddr_in*)&localAddress)->sin_port != 0))
+        {
+            return false;
+        }
+    }
+
+    int newFd = socket(family, SOCK_STREAM, 0);
+
+    if (newFd == -1)
+        return false;
+
+    int result = dup2(newFd, self->fd);
+
+    close(newFd);
+
+    return (result != -1);
+}
+
 static void
 setSocketNonBlocking(Socket self)
 {
@@ -253,6 +338,12 @@ activateTcpNoDelay(Socket self)
 
 ServerSocket
 TcpServerSocket_create(const char* address, int port)
+{
+    return TcpServerSocket_createEx(address, port, false);
+}
+
+ServerSocket
+TcpServerSocket_createEx(const char* address, int port, bool reusePort)
 {
     ServerSocket serverSocket = NULL;
 
@@ -271,6 +362,23 @@ TcpServerSocket_create(const char* address, int port)
         int optionReuseAddr = 1;
         setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (char*)&optionReuseAddr, sizeof(int));
 
+        if (reusePort)
+        {
+            /* SO_REUSEPORT doesn't distribute the connections on BSD systems - SO_REUSEPORT_LB does (FreeBSD) */
+#ifdef SO_REUSEPORT_LB
+            int optionReusePort = 1;
+
+            if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT_LB, (char*)&optionReusePort, sizeof(int)) < 0)
+            {
+                close(fd);
+                return NULL;
+            }
+#else
+            close(fd);
+            return NULL;
+#endif
+        }
+
         if (bind(fd, (struct sockaddr*)&serverAddress, sizeof(serverAddress)) >= 0)
         {
             serverSocket = (ServerSocket)GLOBAL_MALLOC(sizeof(struct sServerSocket));
@@ -336,6 +444,12 @@ ServerSocket_setBacklog(ServerSocket self, int backlog)
     self->backLog = backlog;
 }
 
+int
+ServerSocket_getFd(ServerSocket self)
+{
+    return self->fd;
+}
+
 static void
 closeAndShutdownSocket(int socketFd)
 {
@@ -438,14 +552,21 @@ Socket_bind(Socket self, const char* srcAddress, int srcPort)
 bool
 Socket_connectAsync(Socket self, const char* address, int port)
 {
-    struct sockaddr_in serverAddress;
+    struct sockaddr_storage serverAddress;
+    socklen_t serverAddressLength;
 
     if (DEBUG_SOCKET)
         printf("SOCKET: connect: %s:%i\n", address, port);
 
-    if (!prepareAddress(address, port, &serverAddress))
+    if (!prepareRemoteAddress(address, port, &serverAddress, &serverAddressLength))
         return false;
 
+    if (serverAddress.ss_family == AF_INET6)
+    {
+        if (!setSocketAddressFamily(self, AF_INET6))
+            return false;
+    }
+
     fd_set fdSet;
     FD_ZERO(&fdSet);
     FD_SET(self->fd, &fdSet);
@@ -454,7 +575,7 @@ Socket_connectAsync(Socket self, const char* address, int port)
 
     fcntl(self->fd, F_SETFL, O_NONBLOCK);
 
-    if (connect(self->fd, (struct sockaddr*)&serverAddress, sizeof(serverAddress)) < 0)
+    if (connect(self->fd, (struct sockaddr*)&serverAddress, serverAddressLength) < 0)
     {
 
         if (errno != EINPROGRESS)
@@ -507,6 +628,45 @@ Socket_checkAsyncConnectState(Socket self)
     }
 }
 
+int
+Socket_waitAsyncConnect(Socket* sockets, int numberOfSockets, unsigned int timeoutMs)
+{
+    if (numberOfSockets < 1)
+        return 0;
+
+    struct pollfd* fds = (struct pollfd*)GLOBAL_CALLOC(numberOfSockets, sizeof(struct pollfd));
+
+    if (fds == NULL)
+        return -1;
+
+    int nfds = 0;
+    int i;
+
+    for (i = 0; i < numberOfSockets; i++)
+    {
+        if (sockets[i] && (sockets[i]->fd != -1))
+        {
+            fds[nfds].fd = sockets[i]->fd;
+            fds[nfds].events = POLLOUT;
+            nfds++;
+        }
+    }
+
+    int result = 0;
+
+    if (nfds > 0)
+    {
+        result = poll(fds, nfds, timeoutMs);
+
+        if ((result == -1) && (errno == EINTR))
+            result = 0;
+    }
+
+    GLOBAL_FREEMEM(fds);
+
+    return result;
+}
+
 bool
 Socket_connect(Socket self, const char* address, int port)
 {
@@ -543,6 +703,76 @@ Socket_connect(Socket self, const char* address, int port)
     return false;
 }
 
+static bool
+convertAddressToNumericStr(struct sockaddr* addr, char* addrString)
+{
+    if (addr->sa_family == AF_INET)
+        return (inet_ntop(AF_INET, &(((struct sockaddr_in*)addr)->sin_addr), addrString, INET_ADDRSTRLEN) != NULL);
+    else if (addr->sa_family == AF_INET6)
+        return (inet_ntop(AF_INET6, &(((struct sockaddr_in6*)addr)->sin6_addr), addrString, INET6_ADDRSTRLEN) !=
+                NULL);
+    else
+        return false;
+}
+
+int
+Socket_resolveHostname(const char* hostname, bool numericOnly, char addresses[][SOCKET_MAX_ADDRESS_STRING_LENGTH],
+                       int maxAddresses)
+{
+    struct addrinfo addressHints;
+    struct addrinfo* lookupResult;
+
+    if (hostname == NULL)
+        return -1;
+
+    memset(&addressHints, 0, sizeof(struct addrinfo));
+    addressHints.ai_family = AF_UNSPEC;
+    addressHints.ai_socktype = SOCK_STREAM;
+
+    if (numericOnly)
+        addressHints.ai_flags = AI_NUMERICHOST;
+
+    if (getaddrinfo(hostname, NULL, &addressHints, &lookupResult) != 0)
+        return -1;
+
+    int addressCount = 0;
+
+    /* interleave the address families - start with the family preferred by the system */
+    int families[2];
+    struct addrinfo* nextResult[2];
+
+    families[0] = lookupResult->ai_family;
+    families[1] = (families[0] == AF_INET6) ? AF_INET : AF_INET6;
+    nextResult[0] = lookupResult;
+    nextResult[1] = lookupResult;
+
+    int familyIndex = 0;
+
+    while ((addressCount < maxAddresses) && ((nextResult[0] != NULL) || (nextResult[1] != NULL)))
+    {
+        struct addrinfo* entry = nextResult[familyIndex];
+
+        while ((entry != NULL) && (entry->ai_family != families[familyIndex]))
+            entry = entry->ai_next;
+
+        if (entry)
+        {
+            if (convertAddressToNumericStr(entry->ai_addr, addresses[addressCount]))
+                addressCount++;
+
+            nextResult[familyIndex] = entry->ai_next;
+        }
+        else
+            nextResult[familyIndex] = NULL;
+
+        familyIndex = (familyIndex + 1) % 2;
+    }
+
+    freeaddrinfo(lookupResult);
+
+    return addressCount;
+}
+
 static char*
 convertAddressToStr(struct sockaddr_storage* addr)
 {
@@ -644,6 +874,43 @@ Socket_getPeerAddressStatic(Socket self, char* peerAddressString)
     return peerAddressString;
 }
 
+int
+Socket_getPeerIpAddress(Socket self, uint8_t* address)
+{
+    struct sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+
+    if (getpeername(self->fd, (struct sockaddr*)&addr, &addrLen) == -1)
+        return 0;
+
+    if (addr.ss_family == AF_INET)
+    {
+        struct sockaddr_in* ipv4Addr = (struct sockaddr_in*)&addr;
+
+        memcpy(address, &(ipv4Addr->sin_addr), 4);
+
+        return 4;
+    }
+    else if (addr.ss_family == AF_INET6)
+    {
+        struct sockaddr_in6* ipv6Addr = (struct sockaddr_in6*)&addr;
+
+        if (IN6_IS_ADDR_V4MAPPED(&(ipv6Addr->sin6_addr)))
+        {
+            memcpy(address, ((uint8_t*)&(ipv6Addr->sin6_addr)) + 12, 4);
+
+            return 4;
+        }
+
+        memcpy(address, &(ipv6Addr->sin6_addr), 16);
+
+        return 16;
+    }
+    else
+        return 0;
+}
+
 int
 Socket_read(Socket self, uint8_t* buf, int size)
 {
@@ -690,6 +957,92 @@ Socket_write(Socket self, uint8_t* buf, int size)
         return retVal;
 }
 
+int
+Socket_getFd(Socket self)
+{
+    return self->fd;
+}
+
+struct sWakeupSignal
+{
+    int readFd;
+    int writeFd;
+};
+
+WakeupSignal
+WakeupSignal_create(void)
+{
+    int fds[2];
+
+    if (pipe(fds) == -1)
+    {
+        if (DEBUG_SOCKET)
+            printf("SOCKET: failed to create pipe (errno=%i)\n", errno);
+
+        return NULL;
+    }
+
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+    WakeupSignal self = (WakeupSignal)GLOBAL_MALLOC(sizeof(struct sWakeupSignal));
+
+    if (self)
+    {
+        self->readFd = fds[0];
+        self->writeFd = fds[1];
+    }
+    else
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    return self;
+}
+
+int
+WakeupSignal_getFd(WakeupSignal self)
+{
+    return self->readFd;
+}
+
+void
+WakeupSignal_set(WakeupSignal self)
+{
+    uint8_t value = 1;
+
+    /* EAGAIN -> pipe is full, the signal is set anyway */
+    if (write(self->writeFd, &value, 1) == -1)
+    {
+        if (DEBUG_SOCKET && (errno != EAGAIN))
+            printf("SOCKET: failed to set wakeup signal (errno=%i)\n", errno);
+    }
+}
+
+void
+WakeupSignal_reset(WakeupSignal self)
+{
+    uint8_t buffer[64];
+
+    while (read(self->readFd, buffer, sizeof(buffer)) > 0)
+        ;
+}
+
+void
+WakeupSignal_destroy(WakeupSignal self)
+{
+    if (self)
+    {
+        close(self->readFd);
+        close(self->writeFd);
+
+        GLOBAL_FREEMEM(self);
+    }
+}
+
 void
 Socket_destroy(Socket self)
 {
@@ -17,6 +17,7 @@
 #include <netinet/tcp.h> /* required for TCP keepalive */
 #include <stdio.h>
 #include <string.h>
+#include <sys/eventfd.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -55,6 +56,7 @@ struct sUdpSocket
 struct sHandleSet
 {
     LinkedList sockets;
+    int wakeupFd; /* -1 = no wakeup signal */
     bool pollfdIsUpdated;
     struct pollfd* fds;
     int nfds;
@@ -68,6 +70,7 @@ Handleset_new(void)
     if (self)
     {
         self->sockets = LinkedList_create();
+        self->wakeupFd = -1;
         self->pollfdIsUpdated = false;
         self->fds = NULL;
         self->nfds = 0;
@@ -87,6 +90,8 @@ Handleset_reset(HandleSet self)
             self->sockets = LinkedList_create();
             self->pollfdIsUpdated = false;
         }
+
+        self->wakeupFd = -1;
     }
 }
 
@@ -101,6 +106,16 @@ Handleset_addSocket(HandleSet self, const Socket sock)
     }
 }
 
+void
+Handleset_addWakeupSignal(HandleSet self, WakeupSignal signal)
+{
+    if (self != NULL && signal != NULL)
+    {
+        self->wakeupFd = WakeupSignal_getFd(signal);
+        self->pollfdIsUpdated = false;
+    }
+}
+
 void
 Handleset_removeSocket(HandleSet self, const Socket sock)
 {
@@ -123,13 +138,18 @@ Handleset_waitReady(HandleSet self, unsigned int timeoutMs)
             self->fds = NULL;
         }
 
-        self->nfds = LinkedList_size(self->sockets);
+        int numberOfSockets = LinkedList_size(self->sockets);
+
+        self->nfds = numberOfSockets;
+
+        if (self->wakeupFd != -1)
+            self->nfds++;
 
         self->fds = GLOBAL_CALLOC(self->nfds, sizeof(struct pollfd));
 
         int i;
 
-        for (i = 0; i < self->nfds; i++)
+        for (i = 0; i < numberOfSockets; i++)
         {
             LinkedList sockElem = LinkedList_get(self->sockets, i);
 
@@ -145,6 +165,12 @@ Handleset_waitReady(HandleSet self, unsigned int timeoutMs)
             }
         }
 
+        if (self->wakeupFd != -1)
+        {
+            self->fds[numberOfSockets].fd = self->wakeupFd;
+            self->fds[numberOfSockets].events = POLL_IN;
+        }
+
         self->pollfdIsUpdated = true;
     }
 
@@ -272,6 +298,102 @@ exit_function:
     return retVal;
 }
 
+static bool
+prepareRemoteAddress(const char* address, int port, struct sockaddr_storage* sockaddr, socklen_t* sockaddrLength)
+{
+    struct in6_addr ipv6Address;
+
+    memset((char*)sockaddr, 0, sizeof(struct sockaddr_storage));
+
+    /* IPv6 is only used for numeric addresses - hostnames are resolved to IPv4 as before */
+    if ((address != NULL) && (inet_pton(AF_INET6, address, &ipv6Address) == 1))
+    {
+        struct sockaddr_in6* ipv6SockAddr = (struct sockaddr_in6*)sockaddr;
+
+        if (port < 0)
+            port = 0;
+
+        ipv6SockAddr->sin6_family = AF_INET6;
+        ipv6SockAddr->sin6_addr = ipv6Address;
+        ipv6SockAddr->sin6_port = htons(port);
+
+        *sockaddrLength = sizeof(struct sockaddr_in6);
+
+        return true;
+    }
+
+    *sockaddrLength = sizeof(struct sockaddr_in);
+
+    return prepareAddress(address, port, (struct sockaddr_in*)sockaddr);
+}
+
+static void
+activateTcpUserTimeout(int fd)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 37)
+    int tcpUserTimeout = 10000;
+    int result = setsockopt(fd, SOL_TCP, TCP_USER_TIMEOUT, &tcpUserTimeout, sizeof(tcpUserTimeout));
+
+    if (result == -1)
+    {
+        if (DEBUG_SOCKET)
+            printf("SOCKET: failed to set TCP_USER_TIMEOUT (errno=%i)\n", errno);
+    }
+#endif
+}
+
+/* replace the socket by a socket of another address family (keeps the file descriptor number) */
+static bool
+setSocketAddressFamily(Socket self, int family)
+{
+    struct sockaddr_storage localAddress;
+    socklen_t addrLen = sizeof(localAddress);
+
+    if (self->fd == -1)
+        return false;
+
+    if (getsockname(self->fd, (struct sockaddr*)&localAddress, &addrLen) == 0)
+    {
+        if (localAddress.ss_family == family)
+            return true;
+
+        /* the socket was bound by Socket_bind - replacing it would lose the local address */
+        if ((localAddress.ss_family == AF_INET) && (((struct sockaddr_in*)&localAddress)->sin_port != 0))
+        {
+            if (DEBUG_SOCKET)
+                printf("SOCKET: socket is bound to an IPv4 address\n");
+
+            return false;
+        }
+    }
+
+    int newFd = socket(family, SOCK_STREAM, 0);
+
+    if (newFd == -1)
+    {
+        if (DEBUG_SOCKET)
+            printf("SOCKET: failed to create socket (errno=%i)\n", errno);
+
+        return false;
+    }
+
+    int result = dup2(newFd, self->fd);
+
+    close(newFd);
+
+    if (result == -1)
+    {
+        if (DEBUG_SOCKET)
+            printf("SOCKET: failed to replace socket (errno=%i)\n", errno);
+
+        return false;
+    }
+
+    activateTcpUserTimeout(self->fd);
+
+    return true;
+}
+
 static void
 setSocketNonBlocking(Socket self)
 {
@@ -289,6 +411,12 @@ activateTcpNoDelay(Socket self)
 
 ServerSocket
 TcpServerSocket_create(const char* address, int port)
+{
+    return TcpServerSocket_createEx(address, port, false);
+}
+
+ServerSocket
+TcpServerSocket_createEx(const char* address, int port, bool reusePort)
 {
     ServerSocket serverSocket = NULL;
 
@@ -307,6 +435,25 @@ TcpServerSocket_create(const char* address, int port)
         int optionReuseAddr = 1;
         setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (char*)&optionReuseAddr, sizeof(int));
 
+        if (reusePort)
+        {
+#ifdef SO_REUSEPORT
+            int optionReusePort = 1;
+
+            if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (char*)&optionReusePort, sizeof(int)) < 0)
+            {
+                if (DEBUG_SOCKET)
+                    printf("SOCKET: failed to set SO_REUSEPORT\n");
+
+                close(fd);
+                return NULL;
+            }
+#else
+            close(fd);
+            return NULL;
+#endif
+        }
+
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 37)
         int tcpUserTimeout = 10000;
         int result = setsockopt(fd, SOL_TCP, TCP_USER_TIMEOUT, &tcpUserTimeout, sizeof(tcpUserTimeout));
@@ -394,6 +541,12 @@ ServerSocket_setBacklog(ServerSocket self, int backlog)
     self->backLog = backlog;
 }
 
+int
+ServerSocket_getFd(ServerSocket self)
+{
+    return self->fd;
+}
+
 static void
 closeAndShutdownSocket(int socketFd)
 {
@@ -452,16 +605,7 @@ TcpSocket_create()
             self->fd = sock;
             self->connectTimeout = 5000;
 
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 37)
-            int tcpUserTimeout = 10000;
-            int result = setsockopt(sock, SOL_TCP, TCP_USER_TIMEOUT, &tcpUserTimeout, sizeof(tcpUserTimeout));
-
-            if (result == -1)
-            {
-                if (DEBUG_SOCKET)
-                    printf("SOCKET: failed to set TCP_USER_TIMEOUT (errno=%i)\n", errno);
-            }
-#endif
+            activateTcpUserTimeout(sock);
         }
         else
         {
@@ -514,19 +658,26 @@ Socket_bind(Socket self, const char* srcAddress, int srcPort)
 bool
 Socket_connectAsync(Socket self, const char* address, int port)
 {
-    struct sockaddr_in serverAddress;
+    struct sockaddr_storage serverAddress;
+    socklen_t serverAddressLength;
 
     if (DEBUG_SOCKET)
         printf("SOCKET: connect: %s:%i\n", address, port);
 
-    if (!prepareAddress(address, port, &serverAddress))
+    if (!prepareRemoteAddress(address, port, &serverAddress, &serverAddressLength))
         return false;
 
+    if (serverAddress.ss_family == AF_INET6)
+    {
+        if (!setSocketAddressFamily(self, AF_INET6))
+            return false;
+    }
+
     activateTcpNoDelay(self);
 
     fcntl(self->fd, F_SETFL, O_NONBLOCK);
 
-    if (connect(self->fd, (struct sockaddr*)&serverAddress, sizeof(serverAddress)) < 0)
+    if (connect(self->fd, (struct sockaddr*)&serverAddress, serverAddressLength) < 0)
     {
 
         if (errno != EINPROGRESS)
@@ -582,6 +733,45 @@ Socket_checkAsyncConnectState(Socket self)
     }
 }
 
+int
+Socket_waitAsyncConnect(Socket* sockets, int numberOfSockets, unsigned int timeoutMs)
+{
+    if (numberOfSockets < 1)
+        return 0;
+
+    struct pollfd* fds = (struct pollfd*)GLOBAL_CALLOC(numberOfSockets, sizeof(struct pollfd));
+
+    if (fds == NULL)
+        return -1;
+
+    int nfds = 0;
+    int i;
+
+    for (i = 0; i < numberOfSockets; i++)
+    {
+        if (sockets[i] && (sockets[i]->fd != -1))
+        {
+            fds[nfds].fd = sockets[i]->fd;
+            fds[nfds].events = POLLOUT;
+            nfds++;
+        }
+    }
+
+    int result = 0;
+
+    if (nfds > 0)
+    {
+        result = poll(fds, nfds, timeoutMs);
+
+        if ((result == -1) && (errno == EINTR))
+            result = 0;
+    }
+
+    GLOBAL_FREEMEM(fds);
+
+    return result;
+}
+
 bool
 Socket_connect(Socket self, const char* address, int port)
 {
@@ -617,6 +807,84 @@ Socket_connect(Socket self, const char* address, int port)
     return false;
 }
 
+static bool
+convertAddressToNumericStr(struct sockaddr* addr, char* addrString)
+{
+    if (addr->sa_family == AF_INET)
+        return (inet_ntop(AF_INET, &(((struct sockaddr_in*)addr)->sin_addr), addrString, INET_ADDRSTRLEN) != NULL);
+    else if (addr->sa_family == AF_INET6)
+        return (inet_ntop(AF_INET6, &(((struct sockaddr_in6*)addr)->sin6_addr), addrString, INET6_ADDRSTRLEN) !=
+                NULL);
+    else
+        return false;
+}
+
+int
+Socket_resolveHostname(const char* hostname, bool numericOnly, char addresses[][SOCKET_MAX_ADDRESS_STRING_LENGTH],
+                       int maxAddresses)
+{
+    struct addrinfo addressHints;
+    struct addrinfo* lookupResult;
+    int result;
+
+    if (hostname == NULL)
+        return -1;
+
+    memset(&addressHints, 0, sizeof(struct addrinfo));
+    addressHints.ai_family = AF_UNSPEC;
+    addressHints.ai_socktype = SOCK_STREAM;
+
+    if (numericOnly)
+        addressHints.ai_flags = AI_NUMERICHOST;
+
+    result = getaddrinfo(hostname, NULL, &addressHints, &lookupResult);
+
+    if (result != 0)
+    {
+        if (DEBUG_SOCKET)
+            printf("SOCKET: getaddrinfo failed (code=%i)\n", result);
+
+        return -1;
+    }
+
+    int addressCount = 0;
+
+    /* interleave the address families - start with the family preferred by the system */
+    int families[2];
+    struct addrinfo* nextResult[2];
+
+    families[0] = lookupResult->ai_family;
+    families[1] = (families[0] == AF_INET6) ? AF_INET : AF_INET6;
+    nextResult[0] = lookupResult;
+    nextResult[1] = lookupResult;
+
+    int familyIndex = 0;
+
+    while ((addressCount < maxAddresses) && ((nextResult[0] != NULL) || (nextResult[1] != NULL)))
+    {
+        struct addrinfo* entry = nextResult[familyIndex];
+
+        while ((entry != NULL) && (entry->ai_family != families[familyIndex]))
+            entry = entry->ai_next;
+
+        if (entry)
+        {
+            if (convertAddressToNumericStr(entry->ai_addr, addresses[addressCount]))
+                addressCount++;
+
+            nextResult[familyIndex] = entry->ai_next;
+        }
+        else
+            nextResult[familyIndex] = NULL;
+
+        familyIndex = (familyIndex + 1) % 2;
+    }
+
+    freeaddrinfo(lookupResult);
+
+    return addressCount;
+}
+
 static char*
 convertAddressToStr(struct sockaddr_storage* addr)
 {
@@ -725,6 +993,43 @@ Socket_getPeerAddressStatic(Socket self, char* peerAddressString)
     return peerAddressString;
 }
 
+int
+Socket_getPeerIpAddress(Socket self, uint8_t* address)
+{
+    struct sockaddr_storage addr;
+    socklen_t addrLen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+
+    if (getpeername(self->fd, (struct sockaddr*)&addr, &addrLen) == -1)
+        return 0;
+
+    if (addr.ss_family == AF_INET)
+    {
+        struct sockaddr_in* ipv4Addr = (struct sockaddr_in*)&addr;
+
+        memcpy(address, &(ipv4Addr->sin_addr), 4);
+
+        return 4;
+    }
+    else if (addr.ss_family == AF_INET6)
+    {
+        struct sockaddr_in6* ipv6Addr = (struct sockaddr_in6*)&addr;
+
+        if (IN6_IS_ADDR_V4MAPPED(&(ipv6Addr->sin6_addr)))
+        {
+            memcpy(address, ((uint8_t*)&(ipv6Addr->sin6_addr)) + 12, 4);
+
+            return 4;
+        }
+
+        memcpy(address, &(ipv6Addr->sin6_addr), 16);
+
+        return 16;
+    }
+    else
+        return 0;
+}
+
 int
 Socket_read(Socket self, uint8_t* buf, int size)
 {
@@ -785,6 +1090,83 @@ Socket_write(Socket self, uint8_t* buf, int size)
     return retVal;
 }
 
+int
+Socket_getFd(Socket self)
+{
+    return self->fd;
+}
+
+struct sWakeupSignal
+{
+    int fd;
+};
+
+WakeupSignal
+WakeupSignal_create(void)
+{
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (fd == -1)
+    {
+        if (DEBUG_SOCKET)
+            printf("SOCKET: failed to create eventfd (errno=%i)\n", errno);
+
+        return NULL;
+    }
+
+    WakeupSignal self = (WakeupSignal)GLOBAL_MALLOC(sizeof(struct sWakeupSignal));
+
+    if (self)
+        self->fd = fd;
+    else
+        close(fd);
+
+    return self;
+}
+
+int
+WakeupSignal_getFd(WakeupSignal self)
+{
+    return self->fd;
+}
+
+void
+WakeupSignal_set(WakeupSignal self)
+{
+    uint64_t value = 1;
+
+    if (write(self->fd, &value, sizeof(value)) == -1)
+    {
+        /* EAGAIN -> counter overflow, the signal is set anyway */
+        if (DEBUG_SOCKET)
+            printf("SOCKET: failed to set wakeup signal (errno=%i)\n", errno);
+    }
+}
+
+void
+WakeupSignal_reset(WakeupSignal self)
+{
+    uint64_t value;
+
+    /* reading the eventfd resets the counter */
+    if (read(self->fd, &value, sizeof(value)) == -1)
+    {
+        if (DEBUG_SOCKET && (errno != EAGAIN))
+            printf("SOCKET: failed to reset wakeup signal (errno=%i)\n", errno);
+    }
+}
+
+void
+WakeupSignal_destroy(WakeupSignal self)
+{
+    if (self)
+    {
+        close(self->fd);
+
+        GLOBAL_FREEMEM(self);
+    }
+}
+
 void
 Socket_destroy(Socket self)
 {
@@ -94,6 +94,20 @@ Handleset_addSocket(HandleSet self, const Socket sock)
     }
 }
 
+void
+Handleset_addWakeupSignal(HandleSet self, WakeupSignal signal)
+{
+    if (self != NULL && signal != NULL)
+    {
+        SOCKET fd = (SOCKET)WakeupSignal_getFd(signal);
+
+        FD_SET(fd, &self->handles);
+
+        if ((fd > self->maxHandle) || (self->maxHandle == INVALID_SOCKET))
+            self->maxHandle = fd;
+    }
+}
+
 void
 Handleset_removeSocket(HandleSet self, const Socket sock)
 {
@@ -236,6 +250,16 @@ wsaShutdown(void)
     }
 }
 
+ServerSocket
+TcpServerSocket_createEx(const char* address, int port, bool reusePort)
+{
+    /* SO_REUSEPORT is not supported */
+    if (reusePort)
+        return NULL;
+
+    return TcpServerSocket_create(address, port);
+}
+
 ServerSocket
 TcpServerSocket_create(const char* address, int port)
 {
@@ -339,6 +363,12 @@ ServerSocket_setBacklog(ServerSocket self, int backlog)
     self->backLog = backlog;
 }
 
+int
+ServerSocket_getFd(ServerSocket self)
+{
+    return (int) self->fd;
+}
+
 void
 ServerSocket_destroy(ServerSocket self)
 {
@@ -429,17 +459,51 @@ Socket_connectAsync(Socket self, const char* address, int port)
     if (DEBUG_SOCKET)
         printf("WIN32_SOCKET: Socket_connect: %s:%i\n", address, port);
 
-    struct sockaddr_in serverAddress;
+    struct sockaddr_storage serverAddress;
+    int serverAddressLength;
 
     if (wsaStartUp() == false)
         return false;
 
-    if (!prepareAddress(address, port, &serverAddress))
-        return false;
+    memset(&serverAddress, 0, sizeof(serverAddress));
+
+    /* IPv6 is only used for numeric addresses - hostnames are resolved to IPv4 as before */
+    struct sockaddr_in6* ipv6SockAddr = (struct sockaddr_in6*)&serverAddress;
+
+    if ((address != NULL) && (inet_pton(AF_INET6, address, &(ipv6SockAddr->sin6_addr)) == 1))
+    {
+        ipv6SockAddr->sin6_family = AF_INET6;
+        ipv6SockAddr->sin6_port = htons(port);
+        serverAddressLength = sizeof(struct sockaddr_in6);
+
+        struct sockaddr_in localAddress;
+        int localAddressLength = sizeof(localAddress);
+
+        /* the socket was bound by Socket_bind - replacing it would lose the local address */
+        if ((getsockname(self->fd, (struct sockaddr*)&localAddress, &localAddressLength) == 0) &&
+            (localAddress.sin_port != 0))
+            return false;
+
+        /* replace the IPv4 socket created by TcpSocket_create */
+        SOCKET ipv6Socket = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+
+        if (ipv6Socket == INVALID_SOCKET)
+            return false;
+
+        closesocket(self->fd);
+        self->fd = ipv6Socket;
+    }
+    else
+    {
+        if (!prepareAddress(address, port, (struct sockaddr_in*)&serverAddress))
+            return false;
+
+        serverAddressLength = sizeof(struct sockaddr_in);
+    }
 
     setSocketNonBlocking(self);
 
-    if (connect(self->fd, (struct sockaddr*)&serverAddress, sizeof(serverAddress)) == SOCKET_ERROR)
+    if (connect(self->fd, (struct sockaddr*)&serverAddress, serverAddressLength) == SOCKET_ERROR)
     {
         if (WSAGetLastError() != WSAEWOULDBLOCK)
         {
@@ -507,6 +571,44 @@ Socket_checkAsyncConnectState(Socket self)
     }
 }
 
+int
+Socket_waitAsyncConnect(Socket* sockets, int numberOfSockets, unsigned int timeoutMs)
+{
+    fd_set writeSet;
+    fd_set exceptSet;
+
+    FD_ZERO(&writeSet);
+    FD_ZERO(&exceptSet);
+
+    int pendingSockets = 0;
+    int i;
+
+    for (i = 0; i < numberOfSockets; i++)
+    {
+        if (sockets[i] && (sockets[i]->fd != INVALID_SOCKET))
+        {
+            /* a failed connection attempt is reported in the except set */
+            FD_SET(sockets[i]->fd, &writeSet);
+            FD_SET(sockets[i]->fd, &exceptSet);
+            pendingSockets++;
+        }
+    }
+
+    if (pendingSockets == 0)
+        return 0;
+
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+    int result = select(0, NULL, &writeSet, &exceptSet, &timeout);
+
+    if (result == SOCKET_ERROR)
+        return -1;
+
+    return result;
+}
+
 bool
 Socket_connect(Socket self, const char* address, int port)
 {
@@ -542,6 +644,84 @@ Socket_connect(Socket self, const char* address, int port)
     return false;
 }
 
+static bool
+convertAddressToNumericStr(struct sockaddr* addr, char* addrString)
+{
+    if (addr->sa_family == AF_INET)
+        return (inet_ntop(AF_INET, &(((struct sockaddr_in*)addr)->sin_addr), addrString, INET_ADDRSTRLEN) != NULL);
+    else if (addr->sa_family == AF_INET6)
+        return (inet_ntop(AF_INET6, &(((struct sockaddr_in6*)addr)->sin6_addr), addrString, INET6_ADDRSTRLEN) !=
+                NULL);
+    else
+        return false;
+}
+
+int
+Socket_resolveHostname(const char* hostname, bool numericOnly, char addresses[][SOCKET_MAX_ADDRESS_STRING_LENGTH],
+                       int maxAddresses)
+{
+    struct addrinfo addressHints;
+    struct addrinfo* lookupResult;
+
+    if (hostname == NULL)
+        return -1;
+
+    if (wsaStartUp() == false)
+        return -1;
+
+    memset(&addressHints, 0, sizeof(struct addrinfo));
+    addressHints.ai_family = AF_UNSPEC;
+    addressHints.ai_socktype = SOCK_STREAM;
+
+    if (numericOnly)
+        addressHints.ai_flags = AI_NUMERICHOST;
+
+    if (getaddrinfo(hostname, NULL, &addressHints, &lookupResult) != 0)
+    {
+        wsaShutdown();
+        return -1;
+    }
+
+    int addressCount = 0;
+
+    /* interleave the address families - start with the family preferred by the system */
+    int families[2];
+    struct addrinfo* nextResult[2];
+
+    families[0] = lookupResult->ai_family;
+    families[1] = (families[0] == AF_INET6) ? AF_INET : AF_INET6;
+    nextResult[0] = lookupResult;
+    nextResult[1] = lookupResult;
+
+    int familyIndex = 0;
+
+    while ((addressCount < maxAddresses) && ((nextResult[0] != NULL) || (nextResult[1] != NULL)))
+    {
+        struct addrinfo* entry = nextResult[familyIndex];
+
+        while ((entry != NULL) && (entry->ai_family != families[familyIndex]))
+            entry = entry->ai_next;
+
+        if (entry)
+        {
+            if (convertAddressToNumericStr(entry->ai_addr, addresses[addressCount]))
+                addressCount++;
+
+            nextResult[familyIndex] = entry->ai_next;
+        }
+        else
+            nextResult[familyIndex] = NULL;
+
+        familyIndex = (familyIndex + 1) % 2;
+    }
+
+    freeaddrinfo(lookupResult);
+
+    wsaShutdown();
+
+    return addressCount;
+}
+
 static char*
 convertAddressToStr(struct sockaddr_storage* addr)
 {
@@ -653,6 +833,43 @@ Socket_getPeerAddressStatic(Socket self, char* peerAddressString)
     return peerAddressString;
 }
 
+int
+Socket_getPeerIpAddress(Socket self, uint8_t* address)
+{
+    struct sockaddr_storage addr;
+    int addrLen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+
+    if (getpeername(self->fd, (struct sockaddr*)&addr, &addrLen) == SOCKET_ERROR)
+        return 0;
+
+    if (addr.ss_family == AF_INET)
+    {
+        struct sockaddr_in* ipv4Addr = (struct sockaddr_in*)&addr;
+
+        memcpy(address, &(ipv4Addr->sin_addr), 4);
+
+        return 4;
+    }
+    else if (addr.ss_family == AF_INET6)
+    {
+        struct sockaddr_in6* ipv6Addr = (struct sockaddr_in6*)&addr;
+
+        if (IN6_IS_ADDR_V4MAPPED(&(ipv6Addr->sin6_addr)))
+        {
+            memcpy(address, ((uint8_t*)&(ipv6Addr->sin6_addr)) + 12, 4);
+
+            return 4;
+        }
+
+        memcpy(address, &(ipv6Addr->sin6_addr), 16);
+
+        return 16;
+    }
+    else
+        return 0;
+}
+
 int
 Socket_read(Socket self, uint8_t* buf, int size)
 {
@@ -690,6 +907,107 @@ Socket_write(Socket self, uint8_t* buf, int size)
     return bytes_sent;
 }
 
+int
+Socket_getFd(Socket self)
+{
+    return (int) self->fd;
+}
+
+/* the wakeup signal is a UDP socket connected to itself (select only supports sockets) */
+struct sWakeupSignal
+{
+    SOCKET fd;
+};
+
+WakeupSignal
+WakeupSignal_create(void)
+{
+    if (wsaStartUp() == false)
+        return NULL;
+
+    SOCKET fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (fd == INVALID_SOCKET)
+    {
+        wsaShutdown();
+        return NULL;
+    }
+
+    struct sockaddr_in addr;
+    int addrLen = sizeof(addr);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    unsigned long mode = 1;
+
+    if ((bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) ||
+        (getsockname(fd, (struct sockaddr*)&addr, &addrLen) == SOCKET_ERROR) ||
+        (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) ||
+        (ioctlsocket(fd, FIONBIO, &mode) != 0))
+    {
+        if (DEBUG_SOCKET)
+            printf("WIN32_SOCKET: failed to create wakeup signal: %d\n", WSAGetLastError());
+
+        closesocket(fd);
+        wsaShutdown();
+        return NULL;
+    }
+
+    WakeupSignal self = (WakeupSignal)GLOBAL_MALLOC(sizeof(struct sWakeupSignal));
+
+    if (self)
+    {
+        self->fd = fd;
+        socketCount++;
+    }
+    else
+    {
+        closesocket(fd);
+        wsaShutdown();
+    }
+
+    return self;
+}
+
+int
+WakeupSignal_getFd(WakeupSignal self)
+{
+    return (int) self->fd;
+}
+
+void
+WakeupSignal_set(WakeupSignal self)
+{
+    char value = 1;
+
+    send(self->fd, &value, 1, 0);
+}
+
+void
+WakeupSignal_reset(WakeupSignal self)
+{
+    char buffer[64];
+
+    while (recv(self->fd, buffer, sizeof(buffer), 0) > 0)
+        ;
+}
+
+void
+WakeupSignal_destroy(WakeupSignal self)
+{
+    if (self)
+    {
+        closesocket(self->fd);
+        socketCount--;
+        wsaShutdown();
+
+        GLOBAL_FREEMEM(self);
+    }
+}
+
 void
 Socket_destroy(Socket self)
 {
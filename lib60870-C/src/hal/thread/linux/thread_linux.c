@@ -7,8 +7,15 @@
  *  for libiec61850, libmms, and lib60870.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* required for pthread_setaffinity_np */
+#endif
+
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
+#include <errno.h>
+#include <time.h>
 #include <unistd.h>
 #include "hal_thread.h"
 #include "lib_memory.h"
@@ -38,6 +45,29 @@ Semaphore_wait(Semaphore self)
     sem_wait((sem_t*) self);
 }
 
+bool
+Semaphore_timedWait(Semaphore self, int timeoutInMs)
+{
+    struct timespec abstime;
+
+    clock_gettime(CLOCK_REALTIME, &abstime);
+
+    abstime.tv_sec += timeoutInMs / 1000;
+    abstime.tv_nsec += (long) (timeoutInMs % 1000) * 1000000L;
+
+    if (abstime.tv_nsec >= 1000000000L) {
+        abstime.tv_sec++;
+        abstime.tv_nsec -= 1000000000L;
+    }
+
+    while (sem_timedwait((sem_t*) self, &abstime) == -1) {
+        if (errno != EINTR)
+            return false;
+    }
+
+    return true;
+}
+
 void
 Semaphore_post(Semaphore self)
 {
@@ -107,3 +137,16 @@ Thread_sleep(int millies)
     usleep(millies * 1000);
 }
 
+bool
+Thread_setCpuAffinity(int cpu)
+{
+    cpu_set_t cpuSet;
+
+    if ((cpu < 0) || (cpu >= CPU_SETSIZE))
+        return false;
+
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+
+    return (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0);
+}
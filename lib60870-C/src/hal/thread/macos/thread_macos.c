@@ -9,7 +9,7 @@
 
 /*
  * NOTE: MacOS needs own thread layer because it doesn't support unnamed semaphores!
- * NOTE: named semaphores were replaced by POSIX mutex
+ * NOTE: named semaphores were replaced by a POSIX mutex and condition variable
  */
 
 #include <pthread.h>
@@ -17,6 +17,8 @@
 #include <unistd.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
 #include "hal_thread.h"
 #include "lib_memory.h"
 
@@ -33,11 +35,10 @@ typedef struct sSemaphore* mSemaphore;
 struct sSemaphore
 {
     pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int value;
 };
 
-/*
- * NOTE: initialValue is ignored because semaphore was replaced by mutex
- */
 Semaphore
 Semaphore_create(int initialValue)
 {
@@ -47,37 +48,100 @@ Semaphore_create(int initialValue)
 
     if (self) {
         pthread_mutex_init(&(self->mutex), NULL);
+        pthread_cond_init(&(self->cond), NULL);
+        self->value = initialValue;
     }
 
     return (Semaphore)self;
 }
 
-/* lock mutex */
+static void
+lockMutex(mSemaphore self)
+{
+    int retVal = pthread_mutex_lock(&(self->mutex));
+
+    if (retVal) {
+       printf("FATAL ERROR: pthread_mutex_lock failed (err=%i)\n", retVal);
+       exit(-1);
+    }
+}
+
+static void
+unlockMutex(mSemaphore self)
+{
+    int retVal = pthread_mutex_unlock(&(self->mutex));
+
+    if (retVal) {
+        printf("FATAL ERROR: pthread_mutex_unlock failed (err=%i)\n", retVal);
+        exit(-1);
+    }
+}
+
+/* Wait until semaphore value is more than zero. Then decrease the semaphore value. */
 void
 Semaphore_wait(Semaphore self)
 {
     mSemaphore mSelf = (mSemaphore) self;
 
-    int retVal = pthread_mutex_lock(&(mSelf->mutex));
+    lockMutex(mSelf);
 
-    if (retVal) {
-       printf("FATAL ERROR: pthread_mutex_lock failed (err=%i)\n", retVal);
-       exit(-1);
+    while (mSelf->value < 1)
+        pthread_cond_wait(&(mSelf->cond), &(mSelf->mutex));
+
+    mSelf->value--;
+
+    unlockMutex(mSelf);
+}
+
+bool
+Semaphore_timedWait(Semaphore self, int timeoutInMs)
+{
+    mSemaphore mSelf = (mSemaphore) self;
+
+    struct timeval now;
+    struct timespec abstime;
+
+    gettimeofday(&now, NULL);
+
+    abstime.tv_sec = now.tv_sec + timeoutInMs / 1000;
+    abstime.tv_nsec = (long) now.tv_usec * 1000L + (long) (timeoutInMs % 1000) * 1000000L;
+
+    if (abstime.tv_nsec >= 1000000000L) {
+        abstime.tv_sec++;
+        abstime.tv_nsec -= 1000000000L;
+    }
+
+    bool decreased = false;
+
+    lockMutex(mSelf);
+
+    while (mSelf->value < 1) {
+        if (pthread_cond_timedwait(&(mSelf->cond), &(mSelf->mutex), &abstime) == ETIMEDOUT)
+            break;
+    }
+
+    if (mSelf->value > 0) {
+        mSelf->value--;
+        decreased = true;
     }
+
+    unlockMutex(mSelf);
+
+    return decreased;
 }
 
-/* unlock mutex */
 void
 Semaphore_post(Semaphore self)
 {
     mSemaphore mSelf = (mSemaphore) self;
 
-    int retVal = pthread_mutex_unlock(&(mSelf->mutex));
+    lockMutex(mSelf);
 
-    if (retVal) {
-        printf("FATAL ERROR: pthread_mutex_unlock failed (err=%i)\n", retVal);
-        exit(-1);
-    }
+    mSelf->value++;
+
+    pthread_cond_signal(&(mSelf->cond));
+
+    unlockMutex(mSelf);
 }
 
 void
@@ -86,10 +150,11 @@ Semaphore_destroy(Semaphore self)
     if (self) {
         mSemaphore mSelf = (mSemaphore) self;
 
+        pthread_cond_destroy(&(mSelf->cond));
         pthread_mutex_destroy(&(mSelf->mutex));
 
         GLOBAL_FREEMEM(mSelf);
-    }    
+    }
 }
 
 Thread
@@ -147,3 +212,10 @@ Thread_sleep(int millies)
 {
    usleep(millies * 1000);
 }
+
+bool
+Thread_setCpuAffinity(int cpu)
+{
+   /* not supported */
+   return false;
+}
@@ -86,10 +86,19 @@ Thread_sleep(int millies)
 	Sleep(millies);
 }
 
+bool
+Thread_setCpuAffinity(int cpu)
+{
+	if ((cpu < 0) || (cpu >= (int) (sizeof(DWORD_PTR) * 8)))
+		return false;
+
+	return (SetThreadAffinityMask(GetCurrentThread(), ((DWORD_PTR) 1) << cpu) != 0);
+}
+
 Semaphore
 Semaphore_create(int initialValue)
 {
-    HANDLE self = CreateSemaphore(NULL, 1, 1, NULL);
+    HANDLE self = CreateSemaphore(NULL, initialValue, (initialValue > 1) ? initialValue : 1, NULL);
 
     return self;
 }
@@ -101,6 +110,12 @@ Semaphore_wait(Semaphore self)
     WaitForSingleObject((HANDLE) self, INFINITE);
 }
 
+bool
+Semaphore_timedWait(Semaphore self, int timeoutInMs)
+{
+    return (WaitForSingleObject((HANDLE) self, (DWORD) timeoutInMs) == WAIT_OBJECT_0);
+}
+
 void
 Semaphore_post(Semaphore self)
 {
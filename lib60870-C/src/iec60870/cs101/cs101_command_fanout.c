@@ -0,0 +1,696 @@
+/*
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include <string.h>
+
+#include "hal_serial.h"
+#include "cs101_command_fanout.h"
+#include "cs101_master.h"
+#include "cs101_master_internal.h"
+#include "cs101_asdu_internal.h"
+#include "cs104_connection.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+#include "information_objects_internal.h"
+#include "lib60870_config.h"
+#include "lib60870_internal.h"
+#include "lib_memory.h"
+
+#define FANOUT_DEFAULT_TIMEOUT 30000
+
+typedef enum
+{
+    FANOUT_TARGET_CS101 = 0,
+    FANOUT_TARGET_CS104 = 1
+} FanOutTargetType;
+
+typedef struct
+{
+    FanOutTargetType type;
+    void* station; /* CS101_Master or CS104_Connection */
+    int address;   /* link layer address (0 for balanced CS 101 masters, -1 for CS 104) */
+    int ca;
+
+    CS101_FanOutTargetState state;
+    uint64_t sendTime;
+    uint64_t finishTime;
+} FanOutTarget;
+
+struct sCS101_CommandFanOut
+{
+    TypeID typeId; /* C_IC_NA_1, C_CI_NA_1 or C_CS_NA_1 */
+    uint8_t qualifier; /* QOI or QCC */
+    struct sCP56Time2a time;
+    bool useCurrentTime;
+
+    int maxOutstanding; /* 0 = unlimited */
+    int pacingInterval; /* ms */
+    int timeout; /* ms */
+    bool useBroadcast;
+
+    FanOutTarget* targets;
+    int numberOfTargets;
+    int maxNumberOfTargets;
+
+    bool isRunning;
+    uint64_t startTime;
+    uint64_t lastSendTime;
+    bool hasSent;
+
+    int firstPending; /* all targets before this index are not pending */
+    int firstUnfinished; /* all targets before this index are finished */
+    int outstanding; /* targets in state SENT or CONFIRMED */
+    int finished;
+
+    int commandsSent;
+    int broadcastsSent;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore lock;
+#endif
+};
+
+static void
+lock(CS101_CommandFanOut self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+}
+
+static void
+unlock(CS101_CommandFanOut self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+}
+
+CS101_CommandFanOut
+CS101_CommandFanOut_create(void)
+{
+    CS101_CommandFanOut self = (CS101_CommandFanOut)GLOBAL_CALLOC(1, sizeof(struct sCS101_CommandFanOut));
+
+    if (self)
+    {
+        self->typeId = C_IC_NA_1;
+        self->qualifier = IEC60870_QOI_STATION;
+        self->useCurrentTime = true;
+
+        self->maxOutstanding = 0;
+        self->pacingInterval = 0;
+        self->timeout = FANOUT_DEFAULT_TIMEOUT;
+        self->useBroadcast = false;
+
+        self->targets = NULL;
+        self->numberOfTargets = 0;
+        self->maxNumberOfTargets = 0;
+
+        self->isRunning = false;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        self->lock = Semaphore_create(1);
+#endif
+    }
+
+    return self;
+}
+
+void
+CS101_CommandFanOut_destroy(CS101_CommandFanOut self)
+{
+    if (self)
+    {
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_destroy(self->lock);
+#endif
+
+        if (self->targets)
+            GLOBAL_FREEMEM(self->targets);
+
+        GLOBAL_FREEMEM(self);
+    }
+}
+
+void
+CS101_CommandFanOut_setInterrogationCommand(CS101_CommandFanOut self, QualifierOfInterrogation qoi)
+{
+    self->typeId = C_IC_NA_1;
+    self->qualifier = qoi;
+}
+
+void
+CS101_CommandFanOut_setCounterInterrogationCommand(CS101_CommandFanOut self, uint8_t qcc)
+{
+    self->typeId = C_CI_NA_1;
+    self->qualifier = qcc;
+}
+
+void
+CS101_CommandFanOut_setClockSyncCommand(CS101_CommandFanOut self, CP56Time2a time)
+{
+    self->typeId = C_CS_NA_1;
+
+    if (time)
+    {
+        self->time = *time;
+        self->useCurrentTime = false;
+    }
+    else
+        self->useCurrentTime = true;
+}
+
+void
+CS101_CommandFanOut_setConcurrency(CS101_CommandFanOut self, int maxOutstanding)
+{
+    self->maxOutstanding = maxOutstanding;
+}
+
+void
+CS101_CommandFanOut_setPacing(CS101_CommandFanOut self, int intervalInMs)
+{
+    self->pacingInterval = intervalInMs;
+}
+
+void
+CS101_CommandFanOut_setTimeout(CS101_CommandFanOut self, int timeoutInMs)
+{
+    self->timeout = timeoutInMs;
+}
+
+void
+CS101_CommandFanOut_setUseBroadcast(CS101_CommandFanOut self, bool useBroadcast)
+{
+    self->useBroadcast = useBroadcast;
+}
+
+static int
+addTarget(CS101_CommandFanOut self, FanOutTargetType type, void* station, int address, int ca)
+{
+    int index = -1;
+
+    lock(self);
+
+    if (self->numberOfTargets == self->maxNumberOfTargets)
+    {
+        int newMaxNumberOfTargets = (self->maxNumberOfTargets == 0) ? 16 : (self->maxNumberOfTargets * 2);
+
+        FanOutTarget* newTargets =
+            (FanOutTarget*)GLOBAL_REALLOC(self->targets, newMaxNumberOfTargets * sizeof(FanOutTarget));
+
+        if (newTargets)
+        {
+            self->targets = newTargets;
+            self->maxNumberOfTargets = newMaxNumberOfTargets;
+        }
+    }
+
+    if (self->numberOfTargets < self->maxNumberOfTargets)
+    {
+        index = self->numberOfTargets++;
+
+        FanOutTarget* target = &(self->targets[index]);
+
+        target->type = type;
+        target->station = station;
+        target->address = address;
+        target->ca = ca;
+        target->state = CS101_FANOUT_TARGET_PENDING;
+        target->sendTime = 0;
+        target->finishTime = 0;
+    }
+
+    unlock(self);
+
+    return index;
+}
+
+int
+CS101_CommandFanOut_addCS101Target(CS101_CommandFanOut self, struct sCS101_Master* master, int linkLayerAddress, int ca)
+{
+    /* in balanced mode the received ASDUs are reported with address 0 */
+    int address = CS101_Master_isUnbalanced(master) ? linkLayerAddress : 0;
+
+    return addTarget(self, FANOUT_TARGET_CS101, master, address, ca);
+}
+
+int
+CS101_CommandFanOut_addCS104Target(CS101_CommandFanOut self, struct sCS104_Connection* connection, int ca)
+{
+    return addTarget(self, FANOUT_TARGET_CS104, connection, -1, ca);
+}
+
+static bool
+isBroadcastTarget(CS101_CommandFanOut self, FanOutTarget* target)
+{
+    return (self->useBroadcast && (target->type == FANOUT_TARGET_CS101) &&
+            CS101_Master_isUnbalanced((CS101_Master)target->station));
+}
+
+static bool
+isFinishedState(CS101_FanOutTargetState state)
+{
+    return ((state == CS101_FANOUT_TARGET_COMPLETED) || (state == CS101_FANOUT_TARGET_NEGATIVE) ||
+            (state == CS101_FANOUT_TARGET_TIMEOUT));
+}
+
+static void
+finishTarget(CS101_CommandFanOut self, FanOutTarget* target, CS101_FanOutTargetState state, uint64_t currentTime)
+{
+    if ((target->state == CS101_FANOUT_TARGET_SENT) || (target->state == CS101_FANOUT_TARGET_CONFIRMED))
+        self->outstanding--;
+
+    target->state = state;
+    target->finishTime = currentTime;
+
+    self->finished++;
+}
+
+void
+CS101_CommandFanOut_start(CS101_CommandFanOut self)
+{
+    lock(self);
+
+    int i;
+
+    for (i = 0; i < self->numberOfTargets; i++)
+    {
+        self->targets[i].state = CS101_FANOUT_TARGET_PENDING;
+        self->targets[i].sendTime = 0;
+        self->targets[i].finishTime = 0;
+    }
+
+    self->firstPending = 0;
+    self->firstUnfinished = 0;
+    self->outstanding = 0;
+    self->finished = 0;
+    self->commandsSent = 0;
+    self->broadcastsSent = 0;
+    self->hasSent = false;
+
+    self->startTime = Hal_getMonotonicTimeInMs();
+    self->isRunning = true;
+
+    unlock(self);
+}
+
+static CS101_ASDU
+createCommand(CS101_CommandFanOut self, CS101_StaticASDU asduBuffer, CS101_AppLayerParameters parameters, int ca,
+              union uInformationObject* ioBuffer)
+{
+    CS101_ASDU asdu = CS101_ASDU_initializeStatic(asduBuffer, parameters, false, CS101_COT_ACTIVATION,
+                                                  parameters->originatorAddress, ca, false, false);
+
+    InformationObject io;
+
+    if (self->typeId == C_IC_NA_1)
+        io = (InformationObject)InterrogationCommand_create((InterrogationCommand)ioBuffer, 0, self->qualifier);
+    else if (self->typeId == C_CI_NA_1)
+        io = (InformationObject)CounterInterrogationCommand_create((CounterInterrogationCommand)ioBuffer, 0,
+                                                                    self->qualifier);
+    else
+        io = (InformationObject)ClockSynchronizationCommand_create((ClockSynchronizationCommand)ioBuffer, 0,
+                                                                    &(self->time));
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    return asdu;
+}
+
+/* send the command to the target (called without holding the lock) */
+static bool
+sendCommand(CS101_CommandFanOut self, FanOutTarget* target, int address, int ca)
+{
+    if (target->type == FANOUT_TARGET_CS101)
+    {
+        CS101_Master master = (CS101_Master)target->station;
+
+        sCS101_StaticASDU _asdu;
+        union uInformationObject _io;
+
+        CS101_ASDU asdu = createCommand(self, &_asdu, CS101_Master_getAppLayerParameters(master), ca, &_io);
+
+        return CS101_Master_sendASDUToSlave(master, address, asdu);
+    }
+    else
+    {
+        CS104_Connection connection = (CS104_Connection)target->station;
+
+        if (self->typeId == C_IC_NA_1)
+            return CS104_Connection_sendInterrogationCommand(connection, CS101_COT_ACTIVATION, ca, self->qualifier);
+        else if (self->typeId == C_CI_NA_1)
+            return CS104_Connection_sendCounterInterrogationCommand(connection, CS101_COT_ACTIVATION, ca,
+                                                                    self->qualifier);
+        else
+            return CS104_Connection_sendClockSyncCommand(connection, ca, &(self->time));
+    }
+}
+
+static bool
+isPacingActive(CS101_CommandFanOut self, uint64_t currentTime)
+{
+    return ((self->pacingInterval > 0) && self->hasSent &&
+            (currentTime < self->lastSendTime + (uint64_t)self->pacingInterval));
+}
+
+/* send one broadcast message for all pending targets of the master of the given target */
+static void
+sendBroadcast(CS101_CommandFanOut self, int targetIndex, uint64_t currentTime)
+{
+    CS101_Master master = (CS101_Master)self->targets[targetIndex].station;
+
+    LinkLayerParameters llParameters = CS101_Master_getLinkLayerParameters(master);
+    CS101_AppLayerParameters alParameters = CS101_Master_getAppLayerParameters(master);
+
+    int broadcastAddress = (llParameters->addressLength == 2) ? 65535 : 255;
+    int broadcastCA = (alParameters->sizeOfCA == 2) ? 65535 : 255;
+
+    int i;
+
+    /* reserve the targets before the lock is released */
+    for (i = targetIndex; i < self->numberOfTargets; i++)
+    {
+        FanOutTarget* target = &(self->targets[i]);
+
+        if ((target->station == master) && (target->state == CS101_FANOUT_TARGET_PENDING))
+        {
+            target->state = CS101_FANOUT_TARGET_SENT;
+            target->sendTime = currentTime;
+            self->outstanding++;
+        }
+    }
+
+    unlock(self);
+
+    bool sent = sendCommand(self, &(self->targets[targetIndex]), broadcastAddress, broadcastCA);
+
+    lock(self);
+
+    for (i = targetIndex; i < self->numberOfTargets; i++)
+    {
+        FanOutTarget* target = &(self->targets[i]);
+
+        if ((target->station == master) && (target->state == CS101_FANOUT_TARGET_SENT) &&
+            (target->sendTime == currentTime))
+        {
+            if (sent == false)
+            {
+                /* link layer busy - try again later */
+                target->state = CS101_FANOUT_TARGET_PENDING;
+                self->outstanding--;
+            }
+            else if (self->typeId == C_CS_NA_1)
+            {
+                /* broadcast clock synchronization is not confirmed */
+                finishTarget(self, target, CS101_FANOUT_TARGET_COMPLETED, currentTime);
+            }
+        }
+    }
+
+    if (sent)
+    {
+        DEBUG_PRINT("FANOUT: broadcast sent\n");
+
+        self->commandsSent++;
+        self->broadcastsSent++;
+        self->lastSendTime = currentTime;
+        self->hasSent = true;
+    }
+}
+
+bool
+CS101_CommandFanOut_run(CS101_CommandFanOut self)
+{
+    lock(self);
+
+    if (self->isRunning == false)
+    {
+        unlock(self);
+        return CS101_CommandFanOut_isFinished(self);
+    }
+
+    uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+    if (self->useCurrentTime && (self->typeId == C_CS_NA_1))
+        CP56Time2a_createFromMsTimestamp(&(self->time), Hal_getTimeInMs());
+
+    int i;
+
+    /* check timeouts */
+    if (self->outstanding > 0)
+    {
+        for (i = self->firstUnfinished; i < self->numberOfTargets; i++)
+        {
+            FanOutTarget* target = &(self->targets[i]);
+
+            if ((target->state == CS101_FANOUT_TARGET_SENT) || (target->state == CS101_FANOUT_TARGET_CONFIRMED))
+            {
+                if (currentTime > target->sendTime + (uint64_t)self->timeout)
+                {
+                    DEBUG_PRINT("FANOUT: timeout of target %i\n", i);
+
+                    finishTarget(self, target, CS101_FANOUT_TARGET_TIMEOUT, currentTime);
+                }
+            }
+        }
+    }
+
+    while ((self->firstUnfinished < self->numberOfTargets) &&
+           isFinishedState(self->targets[self->firstUnfinished].state))
+        self->firstUnfinished++;
+
+    while ((self->firstPending < self->numberOfTargets) &&
+           (self->targets[self->firstPending].state != CS101_FANOUT_TARGET_PENDING))
+        self->firstPending++;
+
+    /* send commands to pending targets */
+    for (i = self->firstPending; i < self->numberOfTargets; i++)
+    {
+        FanOutTarget* target = &(self->targets[i]);
+
+        if (target->state != CS101_FANOUT_TARGET_PENDING)
+            continue;
+
+        if (isPacingActive(self, currentTime))
+            break;
+
+        if (isBroadcastTarget(self, target))
+        {
+            sendBroadcast(self, i, currentTime);
+            continue;
+        }
+
+        if ((self->maxOutstanding > 0) && (self->outstanding >= self->maxOutstanding))
+            continue; /* broadcasts can still be sent */
+
+        if ((target->type == FANOUT_TARGET_CS101) &&
+            CS101_Master_isUnbalanced((CS101_Master)target->station) &&
+            (CS101_Master_isChannelReady((CS101_Master)target->station, target->address) == false))
+            continue; /* link layer not ready or busy */
+
+        /* reserve the target before the lock is released */
+        target->state = CS101_FANOUT_TARGET_SENT;
+        target->sendTime = currentTime;
+        self->outstanding++;
+
+        int address = target->address;
+        int ca = target->ca;
+
+        /* the connection can call CS101_CommandFanOut_handleASDU while holding its own lock */
+        unlock(self);
+
+        bool sent = sendCommand(self, target, address, ca);
+
+        lock(self);
+
+        target = &(self->targets[i]);
+
+        if (sent)
+        {
+            self->commandsSent++;
+            self->lastSendTime = currentTime;
+            self->hasSent = true;
+        }
+        else if (target->state == CS101_FANOUT_TARGET_SENT)
+        {
+            target->state = CS101_FANOUT_TARGET_PENDING;
+            self->outstanding--;
+        }
+    }
+
+    bool finished = (self->finished == self->numberOfTargets);
+
+    if (finished)
+        self->isRunning = false;
+
+    unlock(self);
+
+    return finished;
+}
+
+bool
+CS101_CommandFanOut_isFinished(CS101_CommandFanOut self)
+{
+    lock(self);
+
+    bool finished = (self->finished == self->numberOfTargets);
+
+    unlock(self);
+
+    return finished;
+}
+
+CS101_FanOutTargetState
+CS101_CommandFanOut_getTargetState(CS101_CommandFanOut self, int index)
+{
+    CS101_FanOutTargetState state = CS101_FANOUT_TARGET_PENDING;
+
+    lock(self);
+
+    if ((index >= 0) && (index < self->numberOfTargets))
+        state = self->targets[index].state;
+
+    unlock(self);
+
+    return state;
+}
+
+void
+CS101_CommandFanOut_getResult(CS101_CommandFanOut self, CS101_FanOutResult* result)
+{
+    memset(result, 0, sizeof(CS101_FanOutResult));
+
+    lock(self);
+
+    uint64_t lastFinishTime = self->startTime;
+    uint64_t totalTargetTime = 0;
+
+    int i;
+
+    for (i = 0; i < self->numberOfTargets; i++)
+    {
+        FanOutTarget* target = &(self->targets[i]);
+
+        switch (target->state)
+        {
+        case CS101_FANOUT_TARGET_COMPLETED:
+            result->completed++;
+            break;
+
+        case CS101_FANOUT_TARGET_NEGATIVE:
+            result->negative++;
+            break;
+
+        case CS101_FANOUT_TARGET_TIMEOUT:
+            result->timedOut++;
+            break;
+
+        default:
+            result->pending++;
+            break;
+        }
+
+        if (isFinishedState(target->state))
+        {
+            if (target->finishTime > lastFinishTime)
+                lastFinishTime = target->finishTime;
+
+            if (target->state == CS101_FANOUT_TARGET_COMPLETED)
+            {
+                int targetTime = (int)(target->finishTime - target->sendTime);
+
+                totalTargetTime += targetTime;
+
+                if (targetTime > result->maxTargetTimeMs)
+                    result->maxTargetTimeMs = targetTime;
+            }
+        }
+    }
+
+    result->targets = self->numberOfTargets;
+    result->commandsSent = self->commandsSent;
+    result->broadcastsSent = self->broadcastsSent;
+    result->completionTimeMs = (int)(lastFinishTime - self->startTime);
+
+    if (result->completed > 0)
+        result->meanTargetTimeMs = (int)(totalTargetTime / result->completed);
+
+    unlock(self);
+}
+
+void
+CS101_CommandFanOut_handleASDU(CS101_CommandFanOut self, void* source, int address, CS101_ASDU asdu)
+{
+    if (CS101_ASDU_getTypeID(asdu) != self->typeId)
+        return;
+
+    CS101_CauseOfTransmission cot = CS101_ASDU_getCOT(asdu);
+
+    if ((cot != CS101_COT_ACTIVATION_CON) && (cot != CS101_COT_ACTIVATION_TERMINATION))
+        return;
+
+    int ca = CS101_ASDU_getCA(asdu);
+    int broadcastCA = (asdu->parameters->sizeOfCA == 2) ? 65535 : 255;
+
+    lock(self);
+
+    if (self->isRunning)
+    {
+        uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+        int i;
+
+        for (i = self->firstUnfinished; i < self->numberOfTargets; i++)
+        {
+            FanOutTarget* target = &(self->targets[i]);
+
+            if ((target->state != CS101_FANOUT_TARGET_SENT) && (target->state != CS101_FANOUT_TARGET_CONFIRMED))
+                continue;
+
+            if ((target->station != source) || ((target->type == FANOUT_TARGET_CS101) && (target->address != address)))
+                continue;
+
+            if ((target->ca != ca) && (ca != broadcastCA))
+                continue;
+
+            if (cot == CS101_COT_ACTIVATION_CON)
+            {
+                if (target->state != CS101_FANOUT_TARGET_SENT)
+                    continue;
+
+                if (CS101_ASDU_isNegative(asdu))
+                    finishTarget(self, target, CS101_FANOUT_TARGET_NEGATIVE, currentTime);
+                else if (self->typeId == C_CS_NA_1)
+                    finishTarget(self, target, CS101_FANOUT_TARGET_COMPLETED, currentTime);
+                else
+                    target->state = CS101_FANOUT_TARGET_CONFIRMED;
+            }
+            else
+            {
+                finishTarget(self, target, CS101_FANOUT_TARGET_COMPLETED, currentTime);
+            }
+
+            break;
+        }
+    }
+
+    unlock(self);
+}
@@ -33,6 +33,7 @@
 #include "serial_transceiver_ft_1_2.h"
 #include "link_layer.h"
 #include "cs101_master.h"
+#include "cs101_master_internal.h"
 #include "cs101_queue.h"
 #include "cs101_asdu_internal.h"
 
@@ -56,6 +57,10 @@ struct sCS101_Master
     CS101_ASDUReceivedHandler asduReceivedHandler;
     void* asduReceivedHandlerParameter;
 
+    CS101_PointCache pointCache;
+
+    CS101_CommandFanOut commandFanOut;
+
     struct sCS101_Queue userDataQueue;
 
 #if (CONFIG_USE_THREADS == 1)
@@ -105,6 +110,12 @@ IBalancedApplicationLayer_HandleReceivedData (void* parameter, uint8_t* msg, boo
 
     CS101_ASDU asdu = CS101_ASDU_createFromBufferEx(&_asdu, &(self->alParameters), msg + userDataStart, userDataLength);
 
+    if (asdu && self->pointCache)
+        CS101_PointCache_update(self->pointCache, asdu);
+
+    if (asdu && self->commandFanOut)
+        CS101_CommandFanOut_handleASDU(self->commandFanOut, self, 0, asdu);
+
     if (self->asduReceivedHandler)
         self->asduReceivedHandler(self->asduReceivedHandlerParameter, 0, asdu);
 
@@ -143,6 +154,12 @@ IPrimaryApplicationLayer_UserData(void* parameter, int slaveAddress, uint8_t* ms
 
     CS101_ASDU asdu = CS101_ASDU_createFromBufferEx(&_asdu, &(self->alParameters), msg + start, length);
 
+    if (asdu && self->pointCache)
+        CS101_PointCache_update(self->pointCache, asdu);
+
+    if (asdu && self->commandFanOut)
+        CS101_CommandFanOut_handleASDU(self->commandFanOut, self, slaveAddress, asdu);
+
     if (self->asduReceivedHandler)
         self->asduReceivedHandler(self->asduReceivedHandlerParameter, slaveAddress, asdu);
 }
@@ -211,6 +228,8 @@ CS101_Master_createEx(SerialPort serialPort, const LinkLayerParameters llParamet
         }
 
         self->asduReceivedHandler = NULL;
+        self->pointCache = NULL;
+        self->commandFanOut = NULL;
 
 #if (CONFIG_USE_THREADS == 1)
         self->isRunning = false;
@@ -228,6 +247,12 @@ CS101_Master_create(SerialPort serialPort, const LinkLayerParameters llParameter
     return CS101_Master_createEx(serialPort, llParameters, alParameters, linkLayerMode, CS101_MAX_QUEUE_SIZE);
 }
 
+SerialTransceiverFT12
+CS101_Master_getTransceiver(CS101_Master self)
+{
+    return self->transceiver;
+}
+
 void
 CS101_Master_run(CS101_Master self)
 {
@@ -460,8 +485,14 @@ isBroadcastAddress(CS101_Master self, int address)
     return 0;
 }
 
-void
-CS101_Master_sendASDU(CS101_Master self, CS101_ASDU asdu)
+bool
+CS101_Master_isUnbalanced(CS101_Master self)
+{
+    return (self->unbalancedLinkLayer != NULL);
+}
+
+bool
+CS101_Master_sendASDUToSlave(CS101_Master self, int address, CS101_ASDU asdu)
 {
     if (self->unbalancedLinkLayer) {
 
@@ -471,13 +502,22 @@ CS101_Master_sendASDU(CS101_Master self, CS101_ASDU asdu)
 
         CS101_ASDU_encode(asdu, (Frame) &bufferFrame);
 
-        if (isBroadcastAddress(self, self->slaveAddress))
-            LinkLayerPrimaryUnbalanced_sendNoReply(self->unbalancedLinkLayer, self->slaveAddress, &bufferFrame);
+        if (isBroadcastAddress(self, address))
+            return LinkLayerPrimaryUnbalanced_sendNoReply(self->unbalancedLinkLayer, address, &bufferFrame);
         else
-            LinkLayerPrimaryUnbalanced_sendConfirmed(self->unbalancedLinkLayer, self->slaveAddress, &bufferFrame);
+            return LinkLayerPrimaryUnbalanced_sendConfirmed(self->unbalancedLinkLayer, address, &bufferFrame);
     }
-    else
+    else {
         CS101_Queue_enqueue(&(self->userDataQueue), asdu);
+
+        return true;
+    }
+}
+
+void
+CS101_Master_sendASDU(CS101_Master self, CS101_ASDU asdu)
+{
+    CS101_Master_sendASDUToSlave(self, self->slaveAddress, asdu);
 }
 
 void
@@ -495,6 +535,56 @@ CS101_Master_pollSingleSlave(CS101_Master self, int address)
     }
 }
 
+void
+CS101_Master_setPollMode(CS101_Master self, CS101_PollMode mode)
+{
+    if (self->unbalancedLinkLayer)
+        LinkLayerPrimaryUnbalanced_setPriorityScheduling(self->unbalancedLinkLayer, (mode == CS101_POLL_MODE_PRIORITY));
+}
+
+bool
+CS101_Master_setSlavePollParameters(CS101_Master self, int address, int weight, int class2PollInterval)
+{
+    if (self->unbalancedLinkLayer)
+        return LinkLayerPrimaryUnbalanced_setSlavePollParameters(self->unbalancedLinkLayer, address, weight, class2PollInterval);
+
+    return false;
+}
+
+void
+CS101_Master_setTimeoutBackoff(CS101_Master self, int initialBackoff, int maxBackoff)
+{
+    if (self->unbalancedLinkLayer)
+        LinkLayerPrimaryUnbalanced_setTimeoutBackoff(self->unbalancedLinkLayer, initialBackoff, maxBackoff);
+}
+
+void
+CS101_Master_getLinkLayerStatistics(CS101_Master self, CS101_LinkLayerStatistics* statistics)
+{
+    if (self->unbalancedLinkLayer)
+        LinkLayerPrimaryUnbalanced_getStatistics(self->unbalancedLinkLayer, statistics);
+    else
+        LinkLayerBalanced_getStatistics(self->balancedLinkLayer, statistics);
+}
+
+bool
+CS101_Master_getSlaveLinkLayerStatistics(CS101_Master self, int address, CS101_LinkLayerStatistics* statistics)
+{
+    if (self->unbalancedLinkLayer)
+        return LinkLayerPrimaryUnbalanced_getSlaveStatistics(self->unbalancedLinkLayer, address, statistics);
+    else
+        return false;
+}
+
+void
+CS101_Master_resetLinkLayerStatistics(CS101_Master self)
+{
+    if (self->unbalancedLinkLayer)
+        LinkLayerPrimaryUnbalanced_resetStatistics(self->unbalancedLinkLayer);
+    else
+        LinkLayerBalanced_resetStatistics(self->balancedLinkLayer);
+}
+
 void
 CS101_Master_setASDUReceivedHandler(CS101_Master self, CS101_ASDUReceivedHandler handler, void* parameter)
 {
@@ -502,6 +592,18 @@ CS101_Master_setASDUReceivedHandler(CS101_Master self, CS101_ASDUReceivedHandler
     self->asduReceivedHandlerParameter = parameter;
 }
 
+void
+CS101_Master_setPointCache(CS101_Master self, CS101_PointCache pointCache)
+{
+    self->pointCache = pointCache;
+}
+
+void
+CS101_Master_setCommandFanOut(CS101_Master self, CS101_CommandFanOut fanOut)
+{
+    self->commandFanOut = fanOut;
+}
+
 void
 CS101_Master_setLinkLayerStateChanged(CS101_Master self, IEC60870_LinkLayerStateChangedHandler handler, void* parameter)
 {
@@ -68,3 +68,13 @@ IMasterConnection_getPeerAddress(IMasterConnection self, char* addrBuf, int addr
     else
         return 0;
 }
+
+bool
+IMasterConnection_startResponse(IMasterConnection self, CS101_ASDU command, CS101_ResponseGenerator generator,
+                                CS101_ResponseFinishedHandler finishedHandler, void* parameter)
+{
+    if (self->startResponse)
+        return self->startResponse(self, command, generator, finishedHandler, parameter);
+    else
+        return false;
+}
@@ -0,0 +1,615 @@
+/*
+ *  cs101_point_cache.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include <string.h>
+
+#include "cs101_point_cache.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+#include "information_objects_internal.h"
+#include "lib60870_config.h"
+#include "lib60870_internal.h"
+#include "lib_memory.h"
+
+typedef struct
+{
+    struct sCS101_PointValue point;
+
+    double reportedValue;              /* value of the last change report (for deadband check) */
+    QualityDescriptor reportedQuality; /* quality of the last change report */
+
+    double deadband; /* < 0 -> use the deadband of the point type */
+
+    bool isUsed;   /* slot of the hash table is used */
+    bool hasValue; /* false when only the deadband of the point is configured */
+} PointCacheEntry;
+
+struct sCS101_PointCache
+{
+    /* open addressing hash table with linear probing (entries are never removed except by clear) */
+    PointCacheEntry* entries;
+    int capacity; /* always a power of two */
+    int usedEntries;
+    int numberOfPoints; /* entries with a value */
+
+    double deadbands[CS101_POINT_TYPE_COUNT];
+
+    CS101_PointChangedHandler pointChangedHandler;
+    void* pointChangedHandlerParameter;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore lock;
+#endif
+};
+
+static bool
+getPointType(TypeID typeId, CS101_PointType* pointType)
+{
+    switch (typeId)
+    {
+    case M_SP_NA_1:
+    case M_SP_TA_1:
+    case M_SP_TB_1:
+        *pointType = CS101_POINT_TYPE_SINGLE_POINT;
+        break;
+
+    case M_DP_NA_1:
+    case M_DP_TA_1:
+    case M_DP_TB_1:
+        *pointType = CS101_POINT_TYPE_DOUBLE_POINT;
+        break;
+
+    case M_ST_NA_1:
+    case M_ST_TA_1:
+    case M_ST_TB_1:
+        *pointType = CS101_POINT_TYPE_STEP_POSITION;
+        break;
+
+    case M_BO_NA_1:
+    case M_BO_TA_1:
+    case M_BO_TB_1:
+        *pointType = CS101_POINT_TYPE_BITSTRING32;
+        break;
+
+    case M_ME_NA_1:
+    case M_ME_TA_1:
+    case M_ME_TD_1:
+    case M_ME_ND_1:
+        *pointType = CS101_POINT_TYPE_NORMALIZED;
+        break;
+
+    case M_ME_NB_1:
+    case M_ME_TB_1:
+    case M_ME_TE_1:
+        *pointType = CS101_POINT_TYPE_SCALED;
+        break;
+
+    case M_ME_NC_1:
+    case M_ME_TC_1:
+    case M_ME_TF_1:
+        *pointType = CS101_POINT_TYPE_SHORT_FLOAT;
+        break;
+
+    case M_IT_NA_1:
+    case M_IT_TA_1:
+    case M_IT_TB_1:
+        *pointType = CS101_POINT_TYPE_INTEGRATED_TOTALS;
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+static CP56Time2a
+getCP56Timestamp(TypeID typeId, InformationObject io)
+{
+    switch (typeId)
+    {
+    case M_SP_TB_1:
+        return SinglePointWithCP56Time2a_getTimestamp((SinglePointWithCP56Time2a)io);
+    case M_DP_TB_1:
+        return DoublePointWithCP56Time2a_getTimestamp((DoublePointWithCP56Time2a)io);
+    case M_ST_TB_1:
+        return StepPositionWithCP56Time2a_getTimestamp((StepPositionWithCP56Time2a)io);
+    case M_BO_TB_1:
+        return Bitstring32WithCP56Time2a_getTimestamp((Bitstring32WithCP56Time2a)io);
+    case M_ME_TD_1:
+        return MeasuredValueNormalizedWithCP56Time2a_getTimestamp((MeasuredValueNormalizedWithCP56Time2a)io);
+    case M_ME_TE_1:
+        return MeasuredValueScaledWithCP56Time2a_getTimestamp((MeasuredValueScaledWithCP56Time2a)io);
+    case M_ME_TF_1:
+        return MeasuredValueShortWithCP56Time2a_getTimestamp((MeasuredValueShortWithCP56Time2a)io);
+    case M_IT_TB_1:
+        return IntegratedTotalsWithCP56Time2a_getTimestamp((IntegratedTotalsWithCP56Time2a)io);
+    default:
+        return NULL;
+    }
+}
+
+static void
+decodeInformationObject(TypeID typeId, CS101_PointType pointType, InformationObject io, CS101_PointValue value)
+{
+    switch (pointType)
+    {
+    case CS101_POINT_TYPE_SINGLE_POINT:
+        value->value = SinglePointInformation_getValue((SinglePointInformation)io) ? 1 : 0;
+        value->quality = SinglePointInformation_getQuality((SinglePointInformation)io);
+        break;
+
+    case CS101_POINT_TYPE_DOUBLE_POINT:
+        value->value = DoublePointInformation_getValue((DoublePointInformation)io);
+        value->quality = DoublePointInformation_getQuality((DoublePointInformation)io);
+        break;
+
+    case CS101_POINT_TYPE_STEP_POSITION:
+        value->value = StepPositionInformation_getValue((StepPositionInformation)io);
+        value->quality = StepPositionInformation_getQuality((StepPositionInformation)io);
+        break;
+
+    case CS101_POINT_TYPE_BITSTRING32:
+        value->value = BitString32_getValue((BitString32)io);
+        value->quality = BitString32_getQuality((BitString32)io);
+        break;
+
+    case CS101_POINT_TYPE_NORMALIZED:
+        if (typeId == M_ME_ND_1)
+        {
+            value->value =
+                MeasuredValueNormalizedWithoutQuality_getValue((MeasuredValueNormalizedWithoutQuality)io);
+            value->quality = IEC60870_QUALITY_GOOD;
+        }
+        else
+        {
+            value->value = MeasuredValueNormalized_getValue((MeasuredValueNormalized)io);
+            value->quality = MeasuredValueNormalized_getQuality((MeasuredValueNormalized)io);
+        }
+        break;
+
+    case CS101_POINT_TYPE_SCALED:
+        value->value = MeasuredValueScaled_getValue((MeasuredValueScaled)io);
+        value->quality = MeasuredValueScaled_getQuality((MeasuredValueScaled)io);
+        break;
+
+    case CS101_POINT_TYPE_SHORT_FLOAT:
+        value->value = MeasuredValueShort_getValue((MeasuredValueShort)io);
+        value->quality = MeasuredValueShort_getQuality((MeasuredValueShort)io);
+        break;
+
+    case CS101_POINT_TYPE_INTEGRATED_TOTALS:
+        {
+            BinaryCounterReading bcr = IntegratedTotals_getBCR((IntegratedTotals)io);
+
+            value->value = BinaryCounterReading_getValue(bcr);
+            value->quality = BinaryCounterReading_isInvalid(bcr) ? IEC60870_QUALITY_INVALID : IEC60870_QUALITY_GOOD;
+        }
+        break;
+    }
+
+    CP56Time2a timestamp = getCP56Timestamp(typeId, io);
+
+    if (timestamp)
+    {
+        value->hasTimestamp = true;
+        memcpy(&(value->timestamp), timestamp, sizeof(struct sCP56Time2a));
+    }
+    else
+        value->hasTimestamp = false;
+}
+
+static unsigned int
+getHashIndex(CS101_PointCache self, int ca, CS101_PointType pointType, int ioa)
+{
+    uint64_t key = ((uint64_t)ca << 32) | ((uint64_t)pointType << 24) | ((uint64_t)ioa & 0xffffff);
+
+    /* Fibonacci hashing - the upper bits are well distributed */
+    key *= 0x9e3779b97f4a7c15ULL;
+
+    return (unsigned int)(key >> 32) & (unsigned int)(self->capacity - 1);
+}
+
+static PointCacheEntry*
+findEntry(CS101_PointCache self, int ca, CS101_PointType pointType, int ioa)
+{
+    unsigned int index = getHashIndex(self, ca, pointType, ioa);
+
+    while (self->entries[index].isUsed)
+    {
+        CS101_PointValue point = &(self->entries[index].point);
+
+        if ((point->ioa == ioa) && (point->ca == ca) && (point->pointType == pointType))
+            return &(self->entries[index]);
+
+        index = (index + 1) & (unsigned int)(self->capacity - 1);
+    }
+
+    return NULL;
+}
+
+static PointCacheEntry*
+insertEntry(CS101_PointCache self, int ca, CS101_PointType pointType, int ioa)
+{
+    unsigned int index = getHashIndex(self, ca, pointType, ioa);
+
+    while (self->entries[index].isUsed)
+        index = (index + 1) & (unsigned int)(self->capacity - 1);
+
+    PointCacheEntry* entry = &(self->entries[index]);
+
+    memset(entry, 0, sizeof(PointCacheEntry));
+
+    entry->isUsed = true;
+    entry->deadband = -1.0;
+    entry->point.ca = ca;
+    entry->point.pointType = pointType;
+    entry->point.ioa = ioa;
+
+    self->usedEntries++;
+
+    return entry;
+}
+
+static bool
+resizeTable(CS101_PointCache self, int newCapacity)
+{
+    PointCacheEntry* oldEntries = self->entries;
+    int oldCapacity = self->capacity;
+
+    PointCacheEntry* newEntries = (PointCacheEntry*)GLOBAL_CALLOC(newCapacity, sizeof(PointCacheEntry));
+
+    if (newEntries == NULL)
+        return false;
+
+    self->entries = newEntries;
+    self->capacity = newCapacity;
+    self->usedEntries = 0;
+
+    int i;
+
+    for (i = 0; i < oldCapacity; i++)
+    {
+        if (oldEntries[i].isUsed)
+        {
+            CS101_PointValue point = &(oldEntries[i].point);
+
+            PointCacheEntry* entry = insertEntry(self, point->ca, point->pointType, point->ioa);
+
+            memcpy(entry, &(oldEntries[i]), sizeof(PointCacheEntry));
+        }
+    }
+
+    GLOBAL_FREEMEM(oldEntries);
+
+    return true;
+}
+
+static PointCacheEntry*
+getOrCreateEntry(CS101_PointCache self, int ca, CS101_PointType pointType, int ioa)
+{
+    PointCacheEntry* entry = findEntry(self, ca, pointType, ioa);
+
+    if (entry == NULL)
+    {
+        /* keep the load factor below 75% to keep the probe sequences short */
+        if (((self->usedEntries + 1) * 4) > (self->capacity * 3))
+        {
+            if (resizeTable(self, self->capacity * 2) == false)
+                return NULL;
+        }
+
+        entry = insertEntry(self, ca, pointType, ioa);
+    }
+
+    return entry;
+}
+
+CS101_PointCache
+CS101_PointCache_create(int initialCapacity)
+{
+    CS101_PointCache self = (CS101_PointCache)GLOBAL_CALLOC(1, sizeof(struct sCS101_PointCache));
+
+    if (self)
+    {
+        int capacity = 16;
+
+        while ((capacity * 3) < (initialCapacity * 4))
+            capacity *= 2;
+
+        self->entries = (PointCacheEntry*)GLOBAL_CALLOC(capacity, sizeof(PointCacheEntry));
+
+        if (self->entries == NULL)
+        {
+            GLOBAL_FREEMEM(self);
+            return NULL;
+        }
+
+        self->capacity = capacity;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        self->lock = Semaphore_create(1);
+#endif
+    }
+
+    return self;
+}
+
+void
+CS101_PointCache_setPointChangedHandler(CS101_PointCache self, CS101_PointChangedHandler handler, void* parameter)
+{
+    self->pointChangedHandler = handler;
+    self->pointChangedHandlerParameter = parameter;
+}
+
+void
+CS101_PointCache_setDeadband(CS101_PointCache self, CS101_PointType pointType, double deadband)
+{
+    if ((pointType < 0) || (pointType >= CS101_POINT_TYPE_COUNT))
+        return;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    self->deadbands[pointType] = deadband;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+}
+
+bool
+CS101_PointCache_setPointDeadband(CS101_PointCache self, int ca, CS101_PointType pointType, int ioa, double deadband)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    PointCacheEntry* entry = getOrCreateEntry(self, ca, pointType, ioa);
+
+    if (entry)
+        entry->deadband = deadband;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return (entry != NULL);
+}
+
+/**
+ * \brief Store the new value of a point
+ *
+ * \return true when the change has to be reported
+ */
+static bool
+updateEntry(CS101_PointCache self, PointCacheEntry* entry, CS101_PointValue newValue)
+{
+    bool isChanged = false;
+
+    if (entry->hasValue == false)
+    {
+        entry->hasValue = true;
+        self->numberOfPoints++;
+
+        isChanged = true;
+    }
+    else if (newValue->quality != entry->reportedQuality)
+    {
+        isChanged = true;
+    }
+    else
+    {
+        double deadband = (entry->deadband >= 0) ? entry->deadband : self->deadbands[entry->point.pointType];
+
+        double difference = newValue->value - entry->reportedValue;
+
+        if (difference < 0)
+            difference = -difference;
+
+        if (difference > deadband)
+            isChanged = true;
+    }
+
+    uint32_t updateCount = entry->point.updateCount;
+
+    memcpy(&(entry->point), newValue, sizeof(struct sCS101_PointValue));
+
+    entry->point.updateCount = updateCount + 1;
+
+    if (isChanged)
+    {
+        entry->reportedValue = newValue->value;
+        entry->reportedQuality = newValue->quality;
+    }
+
+    return isChanged;
+}
+
+void
+CS101_PointCache_update(CS101_PointCache self, CS101_ASDU asdu)
+{
+    TypeID typeId = CS101_ASDU_getTypeID(asdu);
+
+    CS101_PointType pointType;
+
+    if (getPointType(typeId, &pointType) == false)
+        return;
+
+    uint64_t updateTime = Hal_getTimeInMs();
+
+    int ca = CS101_ASDU_getCA(asdu);
+    CS101_CauseOfTransmission cot = CS101_ASDU_getCOT(asdu);
+
+    int numberOfElements = CS101_ASDU_getNumberOfElements(asdu);
+
+    int i;
+
+    for (i = 0; i < numberOfElements; i++)
+    {
+        union uInformationObject _io;
+
+        InformationObject io = CS101_ASDU_getElementEx(asdu, (InformationObject)&_io, i);
+
+        if (io == NULL)
+            break;
+
+        struct sCS101_PointValue newValue;
+
+        newValue.ca = ca;
+        newValue.ioa = InformationObject_getObjectAddress(io);
+        newValue.pointType = pointType;
+        newValue.typeId = typeId;
+        newValue.cot = cot;
+        newValue.lastUpdateTime = updateTime;
+        newValue.updateCount = 0;
+
+        decodeInformationObject(typeId, pointType, io, &newValue);
+
+        bool isChanged = false;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_wait(self->lock);
+#endif
+
+        PointCacheEntry* entry = getOrCreateEntry(self, ca, pointType, newValue.ioa);
+
+        if (entry)
+        {
+            isChanged = updateEntry(self, entry, &newValue);
+
+            newValue.updateCount = entry->point.updateCount;
+        }
+        else
+            DEBUG_PRINT("Point cache: out of memory\n");
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_post(self->lock);
+#endif
+
+        /* the handler is called without lock so that it can access the cache */
+        if (isChanged && self->pointChangedHandler)
+            self->pointChangedHandler(self->pointChangedHandlerParameter, &newValue);
+    }
+}
+
+bool
+CS101_PointCache_getPoint(CS101_PointCache self, int ca, CS101_PointType pointType, int ioa, CS101_PointValue value)
+{
+    bool found = false;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    PointCacheEntry* entry = findEntry(self, ca, pointType, ioa);
+
+    if (entry && entry->hasValue)
+    {
+        memcpy(value, &(entry->point), sizeof(struct sCS101_PointValue));
+        found = true;
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return found;
+}
+
+int
+CS101_PointCache_getNumberOfPoints(CS101_PointCache self)
+{
+    int numberOfPoints;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    numberOfPoints = self->numberOfPoints;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return numberOfPoints;
+}
+
+int
+CS101_PointCache_getSnapshot(CS101_PointCache self, CS101_PointValue values, int maxValues)
+{
+    int count = 0;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    int i;
+
+    for (i = 0; (i < self->capacity) && (count < maxValues); i++)
+    {
+        if (self->entries[i].isUsed && self->entries[i].hasValue)
+        {
+            memcpy(&(values[count]), &(self->entries[i].point), sizeof(struct sCS101_PointValue));
+            count++;
+        }
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return count;
+}
+
+void
+CS101_PointCache_clear(CS101_PointCache self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    memset(self->entries, 0, sizeof(PointCacheEntry) * self->capacity);
+
+    self->usedEntries = 0;
+    self->numberOfPoints = 0;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+}
+
+void
+CS101_PointCache_destroy(CS101_PointCache self)
+{
+    if (self)
+    {
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_destroy(self->lock);
+#endif
+
+        GLOBAL_FREEMEM(self->entries);
+        GLOBAL_FREEMEM(self);
+    }
+}
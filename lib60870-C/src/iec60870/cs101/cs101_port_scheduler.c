@@ -0,0 +1,404 @@
+/*
+ *  cs101_port_scheduler.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include "cs101_port_scheduler.h"
+#include "cs101_master_internal.h"
+#include "cs101_slave_internal.h"
+#include "hal_serial.h"
+#include "hal_time.h"
+#include "lib60870_config.h"
+#include "lib60870_internal.h"
+#include "lib_memory.h"
+#include "linked_list.h"
+#include "serial_transceiver_ft_1_2.h"
+#include "timer_wheel.h"
+
+#if ((CONFIG_USE_THREADS == 1) || (CONFIG_USE_SEMAPHORES == 1))
+#include "hal_thread.h"
+#endif
+
+/* maximum number of ports handled after a single wait */
+#define MAX_READY_PORTS 64
+
+/* maximum number of buffered messages handled when a port is run */
+#define MAX_MESSAGES_PER_RUN 16
+
+typedef struct sSchedulerPort* SchedulerPort;
+
+struct sSchedulerPort
+{
+    CS101_PortScheduler scheduler;
+
+    CS101_Master master;
+    CS101_Slave slave;
+
+    SerialTransceiverFT12 transceiver;
+    SerialPort serialPort;
+
+    struct sTimerWheelEntry tickTimer;
+};
+
+struct sCS101_PortScheduler
+{
+    LinkedList ports;
+
+    SerialPortSet portSet;
+    TimerWheel timers;
+
+    int tickInterval;
+
+    CS101_PortTickHandler tickHandler;
+    void* tickHandlerParameter;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore lock;
+#endif
+
+#if (CONFIG_USE_THREADS == 1)
+    bool isRunning;
+    Thread workerThread;
+#endif
+};
+
+static void
+runPort(SchedulerPort port)
+{
+    int runs = 0;
+
+    /* handle all messages that are already received */
+    do {
+        if (port->master)
+            CS101_Master_run(port->master);
+        else
+            CS101_Slave_run(port->slave);
+
+        runs++;
+    }
+    while (SerialTransceiverFT12_isMessageAvailable(port->transceiver) && (runs < MAX_MESSAGES_PER_RUN));
+
+    CS101_PortScheduler self = port->scheduler;
+
+    TimerWheel_schedule(self->timers, &(port->tickTimer), Hal_getMonotonicTimeInMs() + self->tickInterval);
+}
+
+static void
+handleTick(void* parameter)
+{
+    SchedulerPort port = (SchedulerPort) parameter;
+
+    CS101_PortScheduler self = port->scheduler;
+
+    if (self->tickHandler)
+        self->tickHandler(self->tickHandlerParameter, port->master, port->slave);
+
+    runPort(port);
+}
+
+CS101_PortScheduler
+CS101_PortScheduler_create(void)
+{
+    CS101_PortScheduler self = (CS101_PortScheduler) GLOBAL_MALLOC(sizeof(struct sCS101_PortScheduler));
+
+    if (self) {
+        self->ports = LinkedList_create();
+        self->portSet = SerialPortSet_create();
+        self->timers = TimerWheel_create(256, 1, Hal_getMonotonicTimeInMs());
+        self->tickInterval = 10;
+        self->tickHandler = NULL;
+        self->tickHandlerParameter = NULL;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        self->lock = Semaphore_create(1);
+#endif
+
+#if (CONFIG_USE_THREADS == 1)
+        self->isRunning = false;
+        self->workerThread = NULL;
+#endif
+
+        if ((self->ports == NULL) || (self->portSet == NULL) || (self->timers == NULL)) {
+            CS101_PortScheduler_destroy(self);
+            self = NULL;
+        }
+    }
+
+    return self;
+}
+
+void
+CS101_PortScheduler_setTickInterval(CS101_PortScheduler self, int tickIntervalInMs)
+{
+    if (tickIntervalInMs > 0)
+        self->tickInterval = tickIntervalInMs;
+}
+
+void
+CS101_PortScheduler_setTickHandler(CS101_PortScheduler self, CS101_PortTickHandler handler, void* parameter)
+{
+    self->tickHandler = handler;
+    self->tickHandlerParameter = parameter;
+}
+
+static bool
+addPort(CS101_PortScheduler self, CS101_Master master, CS101_Slave slave, SerialTransceiverFT12 transceiver)
+{
+    SchedulerPort port = (SchedulerPort) GLOBAL_MALLOC(sizeof(struct sSchedulerPort));
+
+    if (port == NULL)
+        return false;
+
+    port->scheduler = self;
+    port->master = master;
+    port->slave = slave;
+    port->transceiver = transceiver;
+    port->serialPort = SerialTransceiverFT12_getSerialPort(transceiver);
+
+    TimerWheelEntry_initialize(&(port->tickTimer), handleTick, port);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    bool success = SerialPortSet_addPort(self->portSet, port->serialPort, port);
+
+    if (success) {
+        SerialTransceiverFT12_setNonBlocking(transceiver, true);
+
+        LinkedList_add(self->ports, port);
+
+        /* run the state machines in the next tick */
+        TimerWheel_schedule(self->timers, &(port->tickTimer), Hal_getMonotonicTimeInMs());
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    if (success == false) {
+        DEBUG_PRINT("PORT SCHEDULER: failed to add serial port\n");
+        GLOBAL_FREEMEM(port);
+    }
+
+    return success;
+}
+
+bool
+CS101_PortScheduler_addMaster(CS101_PortScheduler self, CS101_Master master)
+{
+    return addPort(self, master, NULL, CS101_Master_getTransceiver(master));
+}
+
+bool
+CS101_PortScheduler_addSlave(CS101_PortScheduler self, CS101_Slave slave)
+{
+    return addPort(self, NULL, slave, CS101_Slave_getTransceiver(slave));
+}
+
+static void
+removePort(CS101_PortScheduler self, CS101_Master master, CS101_Slave slave)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    LinkedList element = LinkedList_getNext(self->ports);
+
+    while (element) {
+        SchedulerPort port = (SchedulerPort) LinkedList_getData(element);
+
+        if ((port->master == master) && (port->slave == slave)) {
+            SerialPortSet_removePort(self->portSet, port->serialPort);
+            TimerWheel_cancel(self->timers, &(port->tickTimer));
+            SerialTransceiverFT12_setNonBlocking(port->transceiver, false);
+
+            LinkedList_remove(self->ports, port);
+
+            GLOBAL_FREEMEM(port);
+
+            break;
+        }
+
+        element = LinkedList_getNext(element);
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+}
+
+void
+CS101_PortScheduler_removeMaster(CS101_PortScheduler self, CS101_Master master)
+{
+    removePort(self, master, NULL);
+}
+
+void
+CS101_PortScheduler_removeSlave(CS101_PortScheduler self, CS101_Slave slave)
+{
+    removePort(self, NULL, slave);
+}
+
+int
+CS101_PortScheduler_getNumberOfPorts(CS101_PortScheduler self)
+{
+    return LinkedList_size(self->ports);
+}
+
+static bool
+isPortRegistered(CS101_PortScheduler self, SchedulerPort port)
+{
+    LinkedList element = LinkedList_getNext(self->ports);
+
+    while (element) {
+        if (LinkedList_getData(element) == port)
+            return true;
+
+        element = LinkedList_getNext(element);
+    }
+
+    return false;
+}
+
+int
+CS101_PortScheduler_run(CS101_PortScheduler self, int maxWaitTimeInMs)
+{
+    void* readyPorts[MAX_READY_PORTS];
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    int waitTime = TimerWheel_getNextTimeout(self->timers, Hal_getMonotonicTimeInMs(), maxWaitTimeInMs);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    int numberOfReadyPorts = SerialPortSet_waitReady(self->portSet, readyPorts, MAX_READY_PORTS, waitTime);
+
+    if (numberOfReadyPorts < 0) {
+        DEBUG_PRINT("PORT SCHEDULER: wait failed\n");
+        numberOfReadyPorts = 0;
+    }
+
+    int handledPorts = 0;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    int i;
+
+    for (i = 0; i < numberOfReadyPorts; i++) {
+        SchedulerPort port = (SchedulerPort) readyPorts[i];
+
+        /* the port can be removed while waiting */
+        if (isPortRegistered(self, port)) {
+            runPort(port);
+            handledPorts++;
+        }
+    }
+
+    handledPorts += TimerWheel_advance(self->timers, Hal_getMonotonicTimeInMs());
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return handledPorts;
+}
+
+#if (CONFIG_USE_THREADS == 1)
+static void*
+schedulerThread(void* parameter)
+{
+    CS101_PortScheduler self = (CS101_PortScheduler) parameter;
+
+    while (self->isRunning) {
+        CS101_PortScheduler_run(self, 100);
+    }
+
+    return NULL;
+}
+#endif /* (CONFIG_USE_THREADS == 1) */
+
+void
+CS101_PortScheduler_start(CS101_PortScheduler self)
+{
+#if (CONFIG_USE_THREADS == 1)
+    if (self->workerThread == NULL) {
+        self->isRunning = true;
+        self->workerThread = Thread_create(schedulerThread, self, false);
+        Thread_start(self->workerThread);
+    }
+#endif /* (CONFIG_USE_THREADS == 1) */
+}
+
+void
+CS101_PortScheduler_stop(CS101_PortScheduler self)
+{
+#if (CONFIG_USE_THREADS == 1)
+    if (self->isRunning) {
+        self->isRunning = false;
+        Thread_destroy(self->workerThread);
+        self->workerThread = NULL;
+    }
+#endif /* (CONFIG_USE_THREADS == 1) */
+}
+
+void
+CS101_PortScheduler_destroy(CS101_PortScheduler self)
+{
+    if (self) {
+        CS101_PortScheduler_stop(self);
+
+        if (self->ports) {
+            LinkedList element = LinkedList_getNext(self->ports);
+
+            while (element) {
+                SchedulerPort port = (SchedulerPort) LinkedList_getData(element);
+
+                if (self->portSet)
+                    SerialPortSet_removePort(self->portSet, port->serialPort);
+
+                SerialTransceiverFT12_setNonBlocking(port->transceiver, false);
+
+                element = LinkedList_getNext(element);
+            }
+
+            LinkedList_destroy(self->ports);
+        }
+
+        if (self->timers)
+            TimerWheel_destroy(self->timers);
+
+        if (self->portSet)
+            SerialPortSet_destroy(self->portSet);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_destroy(self->lock);
+#endif
+
+        GLOBAL_FREEMEM(self);
+    }
+}
@@ -0,0 +1,1990 @@
+/*
+ *  cs101_process_image.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cs101_process_image.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+#include "information_objects_internal.h"
+#include "lib60870_config.h"
+#include "lib60870_internal.h"
+#include "lib_memory.h"
+
+/* minimum number of points with contiguous IOAs that are sent in an ASDU with SQ=1 */
+#define PI_MIN_SEQUENCE_LENGTH 4
+
+/* maximum number of ASDUs sent by one call of the plugin task (fairness between connections) */
+#define PI_MAX_ASDUS_PER_TASK 8
+
+/* jobs without progress are removed after this time (e.g. when the connection was closed) */
+#define PI_JOB_TIMEOUT_MS 60000
+
+#define PI_MAX_RUN_LENGTH 127
+
+/* number of points of a bulk update that are checked in one pass */
+#define PI_BULK_CHUNK_SIZE 256
+
+/* number of points that are copied together when a snapshot page is preserved */
+#define PI_SNAPSHOT_PAGE_SIZE 256
+
+/* default time an interrogation snapshot is shared with new interrogation requests */
+#define PI_DEFAULT_SNAPSHOT_SHARING_TIME_MS 500
+
+typedef struct
+{
+    uint32_t ioa;
+    uint16_t ca;
+    uint8_t typeId;
+    uint8_t quality;
+    uint16_t groups;
+    uint16_t reserved;
+
+    union {
+        float f;
+        int32_t i;
+        uint32_t u;
+    } value;
+} ProcessImagePoint;
+
+/* element of the serving order - points sorted by CA, type ID and IOA */
+typedef struct
+{
+    uint64_t key;
+    int32_t index;
+    int32_t run; /* number of points of the same CA and type with contiguous IOAs starting with this point */
+} ProcessImageOrderEntry;
+
+/*
+ * Copy-on-write snapshot of the points for interrogation responses. A page is NULL as long as none of
+ * its points was written since the snapshot was taken (the live points are used). Before the first
+ * write the page is copied to the snapshot.
+ */
+typedef struct sProcessImageSnapshot ProcessImageSnapshot;
+
+struct sProcessImageSnapshot
+{
+    ProcessImageSnapshot* next;
+
+    int referenceCount;
+    int numberOfPoints; /* points added later are not part of the snapshot */
+    int numberOfPages;
+    int copiedPages;
+    uint64_t creationTime;
+
+    ProcessImagePoint** pages;
+};
+
+typedef struct
+{
+    CS101_ProcessImage image;
+    IMasterConnection connection;
+
+    ProcessImageSnapshot* snapshot;
+
+    sCS101_StaticASDU command; /* copy of the command - used for ACT_CON/ACT_TERM */
+    TypeID commandType;
+
+    CS101_CauseOfTransmission cot;
+    bool counters;      /* true: integrated totals, false: monitoring points */
+    uint16_t groupMask; /* 0 = all points */
+
+    bool broadcast;
+    bool caActive; /* ACT_CON for the current CA sent, ACT_TERM is pending */
+    int currentCa;
+
+    uint64_t nextKey; /* key of the next point to check (to continue after the order was rebuilt) */
+    int position;
+    int caEnd;
+    int generation;
+
+    uint64_t lastActivity;
+
+    bool streamed; /* sent as streamed response - removed by the finished handler of the response */
+    bool finished; /* streamed response: no more ASDUs (completed or deactivated) */
+
+    sCS101_StaticASDU asdu;
+} ProcessImageJob;
+
+struct sCS101_ProcessImage
+{
+    ProcessImagePoint* points;
+    int numberOfPoints;
+    int maxPoints;
+
+    /* open addressing hash table with linear probing (point index + 1, 0 = empty slot) */
+    int* hashTable;
+    int hashCapacity; /* always a power of two */
+
+    ProcessImageOrderEntry* order;
+    int orderSize;
+    bool orderValid;
+    int orderGeneration;
+
+    ProcessImageJob** jobs;
+    int numberOfJobs;
+    int maxJobs;
+
+    ProcessImageSnapshot* snapshots; /* snapshots used by interrogation jobs - newest first */
+    int snapshotSharingTime;
+
+    /* event detection - structure of arrays (same index as points) for the bulk deadband check */
+    float* reportedValues; /* value of the last event */
+    float* absoluteLimits; /* FLT_MAX when the check is done by the integral or events are disabled */
+    float* relativeLimits; /* factor of |reported value| - integrated deadband: limit of the integral */
+    float* integrals;
+    uint8_t* deadbandModes;
+
+    CS101_AppLayerParameters eventAlParams;
+    CS101_ProcessImageEventHandler eventHandler;
+    void* eventHandlerParameter;
+
+    sCS101_StaticASDU _eventASDU;
+    CS101_ASDU eventASDU; /* pending events - NULL when no events are pending */
+
+    struct sCS101_SlavePlugin plugin;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore lock;
+#endif
+};
+
+static inline void
+lockImage(CS101_ProcessImage self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#else
+    (void)self;
+#endif
+}
+
+static inline void
+unlockImage(CS101_ProcessImage self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#else
+    (void)self;
+#endif
+}
+
+static bool
+isSupportedType(TypeID typeId)
+{
+    switch (typeId)
+    {
+    case M_SP_NA_1:
+    case M_DP_NA_1:
+    case M_ST_NA_1:
+    case M_BO_NA_1:
+    case M_ME_NA_1:
+    case M_ME_NB_1:
+    case M_ME_NC_1:
+    case M_ME_ND_1:
+    case M_IT_NA_1:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static inline uint64_t
+getOrderKey(ProcessImagePoint* point)
+{
+    return ((uint64_t)point->ca << 40) | ((uint64_t)point->typeId << 32) | (uint64_t)point->ioa;
+}
+
+static inline uint64_t
+getCaStartKey(int ca)
+{
+    return ((uint64_t)ca << 40);
+}
+
+static unsigned int
+getHashIndex(CS101_ProcessImage self, int ca, int ioa)
+{
+    uint64_t key = ((uint64_t)ca << 32) | ((uint64_t)ioa & 0xffffffff);
+
+    /* Fibonacci hashing - the upper bits are well distributed */
+    key *= 0x9e3779b97f4a7c15ULL;
+
+    return (unsigned int)(key >> 32) & (unsigned int)(self->hashCapacity - 1);
+}
+
+static int
+findPoint(CS101_ProcessImage self, int ca, int ioa)
+{
+    unsigned int index = getHashIndex(self, ca, ioa);
+
+    while (self->hashTable[index] != 0)
+    {
+        int pointIndex = self->hashTable[index] - 1;
+
+        ProcessImagePoint* point = &(self->points[pointIndex]);
+
+        if ((point->ioa == (uint32_t)ioa) && (point->ca == (uint16_t)ca))
+            return pointIndex;
+
+        index = (index + 1) & (unsigned int)(self->hashCapacity - 1);
+    }
+
+    return -1;
+}
+
+static void
+insertHashEntry(CS101_ProcessImage self, int pointIndex)
+{
+    ProcessImagePoint* point = &(self->points[pointIndex]);
+
+    unsigned int index = getHashIndex(self, point->ca, point->ioa);
+
+    while (self->hashTable[index] != 0)
+        index = (index + 1) & (unsigned int)(self->hashCapacity - 1);
+
+    self->hashTable[index] = pointIndex + 1;
+}
+
+static bool
+resizeHashTable(CS101_ProcessImage self, int newCapacity)
+{
+    int* newTable = (int*)GLOBAL_CALLOC(newCapacity, sizeof(int));
+
+    if (newTable == NULL)
+        return false;
+
+    GLOBAL_FREEMEM(self->hashTable);
+
+    self->hashTable = newTable;
+    self->hashCapacity = newCapacity;
+
+    int i;
+
+    for (i = 0; i < self->numberOfPoints; i++)
+        insertHashEntry(self, i);
+
+    return true;
+}
+
+static int
+compareOrderEntries(const void* a, const void* b)
+{
+    uint64_t keyA = ((const ProcessImageOrderEntry*)a)->key;
+    uint64_t keyB = ((const ProcessImageOrderEntry*)b)->key;
+
+    if (keyA < keyB)
+        return -1;
+    else if (keyA > keyB)
+        return 1;
+    else
+        return 0;
+}
+
+static bool
+rebuildOrder(CS101_ProcessImage self)
+{
+    if (self->orderValid)
+        return true;
+
+    ProcessImageOrderEntry* newOrder = (ProcessImageOrderEntry*)GLOBAL_REALLOC(
+        self->order, (self->numberOfPoints > 0 ? self->numberOfPoints : 1) * sizeof(ProcessImageOrderEntry));
+
+    if (newOrder == NULL)
+        return false;
+
+    self->order = newOrder;
+
+    int i;
+
+    for (i = 0; i < self->numberOfPoints; i++)
+    {
+        self->order[i].key = getOrderKey(&(self->points[i]));
+        self->order[i].index = i;
+    }
+
+    qsort(self->order, self->numberOfPoints, sizeof(ProcessImageOrderEntry), compareOrderEntries);
+
+    /* calculate the length of the runs of contiguous IOAs from the end */
+    for (i = self->numberOfPoints - 1; i >= 0; i--)
+    {
+        self->order[i].run = 1;
+
+        if (i + 1 < self->numberOfPoints)
+        {
+            if ((self->order[i + 1].key == self->order[i].key + 1) && (self->order[i + 1].run < PI_MAX_RUN_LENGTH))
+                self->order[i].run = self->order[i + 1].run + 1;
+        }
+    }
+
+    self->orderSize = self->numberOfPoints;
+    self->orderValid = true;
+    self->orderGeneration++;
+
+    return true;
+}
+
+/* index of the first order entry with a key >= key */
+static int
+lowerBound(CS101_ProcessImage self, uint64_t key)
+{
+    int low = 0;
+    int high = self->orderSize;
+
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+
+        if (self->order[mid].key < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+static bool
+hasCommonAddress(CS101_ProcessImage self, int ca)
+{
+    int position = lowerBound(self, getCaStartKey(ca));
+
+    return ((position < self->orderSize) && ((self->order[position].key >> 40) == (uint64_t)ca));
+}
+
+static bool
+isBroadcastCA(CS101_AppLayerParameters alParams, int ca)
+{
+    if (alParams->sizeOfCA == 1)
+        return (ca == 0xff);
+    else
+        return (ca == 0xffff);
+}
+
+static InformationObject
+createInformationObject(ProcessImagePoint* point, union uInformationObject* io, BinaryCounterReading bcr)
+{
+    int ioa = (int)point->ioa;
+
+    switch (point->typeId)
+    {
+    case M_SP_NA_1:
+        return (InformationObject)SinglePointInformation_create((SinglePointInformation)io, ioa,
+                                                                (point->value.i != 0), point->quality);
+
+    case M_DP_NA_1:
+        return (InformationObject)DoublePointInformation_create((DoublePointInformation)io, ioa,
+                                                                (DoublePointValue)point->value.i, point->quality);
+
+    case M_ST_NA_1:
+        return (InformationObject)StepPositionInformation_create((StepPositionInformation)io, ioa, point->value.i,
+                                                                 false, point->quality);
+
+    case M_BO_NA_1:
+        return (InformationObject)BitString32_createEx((BitString32)io, ioa, point->value.u, point->quality);
+
+    case M_ME_NA_1:
+        return (InformationObject)MeasuredValueNormalized_create((MeasuredValueNormalized)io, ioa, point->value.f,
+                                                                 point->quality);
+
+    case M_ME_ND_1:
+        return (InformationObject)MeasuredValueNormalizedWithoutQuality_create(
+            (MeasuredValueNormalizedWithoutQuality)io, ioa, point->value.f);
+
+    case M_ME_NB_1:
+        return (InformationObject)MeasuredValueScaled_create((MeasuredValueScaled)io, ioa, point->value.i,
+                                                             point->quality);
+
+    case M_ME_NC_1:
+        return (InformationObject)MeasuredValueShort_create((MeasuredValueShort)io, ioa, point->value.f,
+                                                            point->quality);
+
+    case M_IT_NA_1:
+        BinaryCounterReading_create(bcr, point->value.i, 0, false, false,
+                                    ((point->quality & IEC60870_QUALITY_INVALID) != 0));
+
+        return (InformationObject)IntegratedTotals_create((IntegratedTotals)io, ioa, bcr);
+
+    default:
+        return NULL;
+    }
+}
+
+static bool
+addPointToASDU(ProcessImagePoint* point, CS101_ASDU asdu)
+{
+    union uInformationObject io;
+    struct sBinaryCounterReading bcr;
+
+    InformationObject infoObject = createInformationObject(point, &io, &bcr);
+
+    if (infoObject == NULL)
+        return false;
+
+    return CS101_ASDU_addInformationObject(asdu, infoObject);
+}
+
+static ProcessImageSnapshot*
+createSnapshot(CS101_ProcessImage self, uint64_t currentTime)
+{
+    ProcessImageSnapshot* snapshot = (ProcessImageSnapshot*)GLOBAL_CALLOC(1, sizeof(ProcessImageSnapshot));
+
+    if (snapshot)
+    {
+        snapshot->numberOfPoints = self->numberOfPoints;
+        snapshot->numberOfPages = (self->numberOfPoints + PI_SNAPSHOT_PAGE_SIZE - 1) / PI_SNAPSHOT_PAGE_SIZE;
+        snapshot->creationTime = currentTime;
+        snapshot->referenceCount = 1;
+
+        if (snapshot->numberOfPages > 0)
+        {
+            snapshot->pages = (ProcessImagePoint**)GLOBAL_CALLOC(snapshot->numberOfPages, sizeof(ProcessImagePoint*));
+
+            if (snapshot->pages == NULL)
+            {
+                GLOBAL_FREEMEM(snapshot);
+                return NULL;
+            }
+        }
+
+        snapshot->next = self->snapshots;
+        self->snapshots = snapshot;
+    }
+
+    return snapshot;
+}
+
+/* get a snapshot for a new interrogation job - has to be called with the lock */
+static ProcessImageSnapshot*
+getSnapshot(CS101_ProcessImage self)
+{
+    uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+    ProcessImageSnapshot* newest = self->snapshots;
+
+    /* share the snapshot with concurrent interrogations (e.g. of redundant connections) */
+    if (newest && (newest->numberOfPoints == self->numberOfPoints))
+    {
+        if ((newest->copiedPages == 0) ||
+            ((self->snapshotSharingTime > 0) && (currentTime < newest->creationTime + self->snapshotSharingTime)))
+        {
+            newest->referenceCount++;
+            return newest;
+        }
+    }
+
+    return createSnapshot(self, currentTime);
+}
+
+static void
+releaseSnapshot(CS101_ProcessImage self, ProcessImageSnapshot* snapshot)
+{
+    if (snapshot == NULL)
+        return;
+
+    snapshot->referenceCount--;
+
+    if (snapshot->referenceCount > 0)
+        return;
+
+    ProcessImageSnapshot** link = &(self->snapshots);
+
+    while (*link)
+    {
+        if (*link == snapshot)
+        {
+            *link = snapshot->next;
+            break;
+        }
+
+        link = &((*link)->next);
+    }
+
+    int i;
+
+    for (i = 0; i < snapshot->numberOfPages; i++)
+        GLOBAL_FREEMEM(snapshot->pages[i]);
+
+    GLOBAL_FREEMEM(snapshot->pages);
+    GLOBAL_FREEMEM(snapshot);
+}
+
+/* copy the page of the point to the active snapshots before the point is written - has to be called with the lock */
+static inline void
+preservePoint(CS101_ProcessImage self, int index)
+{
+    ProcessImageSnapshot* snapshot = self->snapshots;
+
+    while (snapshot)
+    {
+        if (index < snapshot->numberOfPoints)
+        {
+            int page = index / PI_SNAPSHOT_PAGE_SIZE;
+
+            if (snapshot->pages[page] == NULL)
+            {
+                int first = page * PI_SNAPSHOT_PAGE_SIZE;
+                int count = snapshot->numberOfPoints - first;
+
+                if (count > PI_SNAPSHOT_PAGE_SIZE)
+                    count = PI_SNAPSHOT_PAGE_SIZE;
+
+                ProcessImagePoint* copy = (ProcessImagePoint*)GLOBAL_MALLOC(count * sizeof(ProcessImagePoint));
+
+                if (copy)
+                {
+                    memcpy(copy, &(self->points[first]), count * sizeof(ProcessImagePoint));
+
+                    snapshot->pages[page] = copy;
+                    snapshot->copiedPages++;
+                }
+                else
+                    DEBUG_PRINT("PROCESS IMAGE: failed to preserve snapshot page\n");
+            }
+        }
+
+        snapshot = snapshot->next;
+    }
+}
+
+/* get the point as it was when the snapshot was taken */
+static inline ProcessImagePoint*
+getSnapshotPoint(CS101_ProcessImage self, ProcessImageSnapshot* snapshot, int index)
+{
+    if (snapshot)
+    {
+        ProcessImagePoint* page = snapshot->pages[index / PI_SNAPSHOT_PAGE_SIZE];
+
+        if (page)
+            return &(page[index % PI_SNAPSHOT_PAGE_SIZE]);
+    }
+
+    return &(self->points[index]);
+}
+
+static bool
+isSelected(ProcessImageJob* job, ProcessImagePoint* point)
+{
+    if (job->counters)
+    {
+        if (point->typeId != M_IT_NA_1)
+            return false;
+    }
+    else
+    {
+        if (point->typeId == M_IT_NA_1)
+            return false;
+    }
+
+    if (job->groupMask != 0)
+        return ((point->groups & job->groupMask) != 0);
+
+    return true;
+}
+
+static inline ProcessImagePoint*
+getOrderPoint(CS101_ProcessImage self, int position)
+{
+    return &(self->points[self->order[position].index]);
+}
+
+/* check if the point at the position is part of the response (and of the snapshot of the job) */
+static inline bool
+isJobPoint(CS101_ProcessImage self, ProcessImageJob* job, int position)
+{
+    if (job->snapshot && (self->order[position].index >= job->snapshot->numberOfPoints))
+        return false;
+
+    return isSelected(job, getOrderPoint(self, position));
+}
+
+/* continue at the same point when the order was rebuilt since the last call */
+static void
+synchronizeJob(CS101_ProcessImage self, ProcessImageJob* job)
+{
+    if (job->generation != self->orderGeneration)
+    {
+        job->position = lowerBound(self, job->nextKey);
+
+        if (job->caActive)
+            job->caEnd = lowerBound(self, getCaStartKey(job->currentCa + 1));
+
+        job->generation = self->orderGeneration;
+    }
+}
+
+/* encode the next response ASDU of the job - position has to point to a selected point of the current CA */
+static CS101_ASDU
+encodeNextASDU(CS101_ProcessImage self, ProcessImageJob* job)
+{
+    ProcessImagePoint* first = getOrderPoint(self, job->position);
+
+    bool isSequence = false;
+
+    if (self->order[job->position].run >= PI_MIN_SEQUENCE_LENGTH)
+    {
+        int i;
+
+        isSequence = true;
+
+        for (i = 1; i < PI_MIN_SEQUENCE_LENGTH; i++)
+        {
+            if (isJobPoint(self, job, job->position + i) == false)
+            {
+                isSequence = false;
+                break;
+            }
+        }
+    }
+
+    CS101_ASDU asdu = CS101_ASDU_initializeStatic(&(job->asdu), job->command.parameters, isSequence, job->cot,
+                                                  CS101_ASDU_getOA((CS101_ASDU)&(job->command)), job->currentCa,
+                                                  false, false);
+
+    int count = 0;
+
+    while (job->position < job->caEnd)
+    {
+        ProcessImageOrderEntry* entry = &(self->order[job->position]);
+        ProcessImagePoint* point = &(self->points[entry->index]);
+
+        if (point->typeId != first->typeId)
+            break;
+
+        if (isSequence)
+        {
+            if ((point->ioa != first->ioa + (uint32_t)count) || (isJobPoint(self, job, job->position) == false))
+                break;
+        }
+        else
+        {
+            if (isJobPoint(self, job, job->position) == false)
+            {
+                job->position++;
+                continue;
+            }
+
+            /* start a new ASDU for a sequence of contiguous IOAs */
+            if ((count > 0) && (entry->run >= PI_MIN_SEQUENCE_LENGTH))
+                break;
+        }
+
+        if (addPointToASDU(getSnapshotPoint(self, job->snapshot, entry->index), asdu) == false)
+            break;
+
+        count++;
+        job->position++;
+    }
+
+    if (count == 0)
+        return NULL;
+
+    return asdu;
+}
+
+typedef enum
+{
+    PI_ACTION_NONE,
+    PI_ACTION_SEND_ASDU,
+    PI_ACTION_SEND_ACT_CON,
+    PI_ACTION_SEND_ACT_TERM
+} ProcessImageAction;
+
+/* determine the next message of the job - has to be called with the lock */
+static ProcessImageAction
+getNextAction(CS101_ProcessImage self, ProcessImageJob* job, CS101_ASDU* asdu, bool* finished)
+{
+    *finished = false;
+
+    synchronizeJob(self, job);
+
+    if (job->caActive == false)
+    {
+        /* broadcast request - start the next CA */
+        if (job->position >= self->orderSize)
+        {
+            *finished = true;
+            return PI_ACTION_NONE;
+        }
+
+        job->currentCa = (int)(self->order[job->position].key >> 40);
+        job->caEnd = lowerBound(self, getCaStartKey(job->currentCa + 1));
+        job->caActive = true;
+
+        CS101_ASDU_setCA((CS101_ASDU)&(job->command), job->currentCa);
+
+        return PI_ACTION_SEND_ACT_CON;
+    }
+
+    while ((job->position < job->caEnd) && (isJobPoint(self, job, job->position) == false))
+        job->position++;
+
+    if (job->position < job->caEnd)
+    {
+        *asdu = encodeNextASDU(self, job);
+
+        if (*asdu)
+            return PI_ACTION_SEND_ASDU;
+    }
+
+    job->position = job->caEnd;
+    job->caActive = false;
+
+    if (job->broadcast == false)
+        *finished = true;
+
+    return PI_ACTION_SEND_ACT_TERM;
+}
+
+static void
+updateNextKey(CS101_ProcessImage self, ProcessImageJob* job)
+{
+    if (job->position < self->orderSize)
+        job->nextKey = self->order[job->position].key;
+    else
+        job->nextKey = UINT64_MAX;
+}
+
+static int
+findJob(CS101_ProcessImage self, IMasterConnection connection, TypeID commandType)
+{
+    int i;
+
+    for (i = 0; i < self->numberOfJobs; i++)
+    {
+        if ((self->jobs[i]->connection == connection) && (self->jobs[i]->commandType == commandType))
+            return i;
+    }
+
+    return -1;
+}
+
+static void
+removeJob(CS101_ProcessImage self, int jobIndex)
+{
+    releaseSnapshot(self, self->jobs[jobIndex]->snapshot);
+
+    GLOBAL_FREEMEM(self->jobs[jobIndex]);
+
+    self->numberOfJobs--;
+
+    if (jobIndex < self->numberOfJobs)
+        self->jobs[jobIndex] = self->jobs[self->numberOfJobs];
+}
+
+/* remove a job - a job with a streamed response is removed by the finished handler of the response */
+static void
+discardJob(CS101_ProcessImage self, int jobIndex)
+{
+    ProcessImageJob* job = self->jobs[jobIndex];
+
+    if (job->streamed)
+        job->finished = true;
+    else
+        removeJob(self, jobIndex);
+}
+
+static void
+removeStaleJobs(CS101_ProcessImage self, IMasterConnection connection, uint64_t currentTime)
+{
+    int i = 0;
+
+    while (i < self->numberOfJobs)
+    {
+        ProcessImageJob* job = self->jobs[i];
+
+        if ((job->connection != connection) && (job->streamed == false) &&
+            (currentTime > job->lastActivity + PI_JOB_TIMEOUT_MS))
+        {
+            DEBUG_PRINT("PROCESS IMAGE: remove stale job\n");
+            removeJob(self, i);
+        }
+        else
+            i++;
+    }
+}
+
+static ProcessImageJob*
+getOrCreateJob(CS101_ProcessImage self, IMasterConnection connection, TypeID commandType)
+{
+    int jobIndex = findJob(self, connection, commandType);
+
+    if (jobIndex != -1)
+        return self->jobs[jobIndex];
+
+    if (self->numberOfJobs == self->maxJobs)
+    {
+        int newMaxJobs = (self->maxJobs > 0) ? self->maxJobs * 2 : 4;
+
+        ProcessImageJob** newJobs =
+            (ProcessImageJob**)GLOBAL_REALLOC(self->jobs, newMaxJobs * sizeof(ProcessImageJob*));
+
+        if (newJobs == NULL)
+            return NULL;
+
+        self->jobs = newJobs;
+        self->maxJobs = newMaxJobs;
+    }
+
+    ProcessImageJob* job = (ProcessImageJob*)GLOBAL_CALLOC(1, sizeof(ProcessImageJob));
+
+    if (job)
+        self->jobs[self->numberOfJobs++] = job;
+
+    return job;
+}
+
+/* start a new (or restart an existing) interrogation job - has to be called with the lock */
+static ProcessImageJob*
+startJob(CS101_ProcessImage self, IMasterConnection connection, CS101_ASDU command, CS101_CauseOfTransmission cot,
+         bool counters, uint16_t groupMask, bool broadcast)
+{
+    ProcessImageJob* job = getOrCreateJob(self, connection, CS101_ASDU_getTypeID(command));
+
+    if (job == NULL)
+        return NULL;
+
+    ProcessImageSnapshot* snapshot = getSnapshot(self);
+
+    if (snapshot == NULL)
+    {
+        discardJob(self, findJob(self, connection, CS101_ASDU_getTypeID(command)));
+        return NULL;
+    }
+
+    releaseSnapshot(self, job->snapshot);
+
+    /* a restarted job continues with the streamed response that is already running */
+    bool streamed = job->streamed;
+
+    memset(job, 0, sizeof(ProcessImageJob));
+
+    job->snapshot = snapshot;
+    job->streamed = streamed;
+
+    job->image = self;
+    job->connection = connection;
+    job->commandType = CS101_ASDU_getTypeID(command);
+    job->cot = cot;
+    job->counters = counters;
+    job->groupMask = groupMask;
+    job->broadcast = broadcast;
+    job->generation = self->orderGeneration;
+    job->lastActivity = Hal_getMonotonicTimeInMs();
+
+    CS101_ASDU_clone(command, &(job->command));
+
+    if (broadcast)
+    {
+        job->position = 0;
+        job->caActive = false;
+    }
+    else
+    {
+        job->currentCa = CS101_ASDU_getCA(command);
+        job->position = lowerBound(self, getCaStartKey(job->currentCa));
+        job->caEnd = lowerBound(self, getCaStartKey(job->currentCa + 1));
+        job->caActive = true;
+    }
+
+    updateNextKey(self, job);
+
+    return job;
+}
+
+static void
+stopJob(CS101_ProcessImage self, IMasterConnection connection, TypeID commandType)
+{
+    int jobIndex = findJob(self, connection, commandType);
+
+    if (jobIndex != -1)
+        discardJob(self, jobIndex);
+}
+
+/* create the next ASDU of a streamed response (see IMasterConnection_startResponse) */
+static CS101_ASDU
+ProcessImage_nextResponseASDU(void* parameter, IMasterConnection connection, CS101_StaticASDU buffer)
+{
+    ProcessImageJob* job = (ProcessImageJob*)parameter;
+    CS101_ProcessImage self = job->image;
+
+    UNUSED_PARAMETER(connection);
+
+    CS101_ASDU response = NULL;
+
+    lockImage(self);
+
+    if (job->finished == false)
+    {
+        CS101_ASDU asdu = NULL;
+        bool finished = false;
+
+        rebuildOrder(self);
+
+        ProcessImageAction action = getNextAction(self, job, &asdu, &finished);
+
+        updateNextKey(self, job);
+
+        job->lastActivity = Hal_getMonotonicTimeInMs();
+
+        /* the ASDU is copied - the job can be restarted while the connection still sends the ASDU */
+        switch (action)
+        {
+        case PI_ACTION_SEND_ASDU:
+            response = CS101_ASDU_clone(asdu, buffer);
+            break;
+
+        case PI_ACTION_SEND_ACT_CON:
+            response = CS101_ASDU_clone((CS101_ASDU)&(job->command), buffer);
+            CS101_ASDU_setCOT(response, CS101_COT_ACTIVATION_CON);
+            CS101_ASDU_setNegative(response, false);
+            break;
+
+        case PI_ACTION_SEND_ACT_TERM:
+            response = CS101_ASDU_clone((CS101_ASDU)&(job->command), buffer);
+            CS101_ASDU_setCOT(response, CS101_COT_ACTIVATION_TERMINATION);
+            CS101_ASDU_setNegative(response, false);
+            break;
+
+        default:
+            break;
+        }
+
+        job->finished = finished;
+    }
+
+    unlockImage(self);
+
+    return response;
+}
+
+static void
+ProcessImage_responseFinished(void* parameter, IMasterConnection connection, bool completed)
+{
+    ProcessImageJob* job = (ProcessImageJob*)parameter;
+    CS101_ProcessImage self = job->image;
+
+    UNUSED_PARAMETER(connection);
+    UNUSED_PARAMETER(completed);
+
+    lockImage(self);
+
+    int i;
+
+    for (i = 0; i < self->numberOfJobs; i++)
+    {
+        if (self->jobs[i] == job)
+        {
+            removeJob(self, i);
+            break;
+        }
+    }
+
+    unlockImage(self);
+}
+
+/* handle C_IC_NA_1 and C_CI_NA_1 */
+static CS101_SlavePlugin_Result
+handleInterrogation(CS101_ProcessImage self, IMasterConnection connection, CS101_ASDU asdu)
+{
+    CS101_AppLayerParameters alParams = IMasterConnection_getApplicationLayerParameters(connection);
+
+    TypeID typeId = CS101_ASDU_getTypeID(asdu);
+    CS101_CauseOfTransmission cot = CS101_ASDU_getCOT(asdu);
+
+    if ((cot != CS101_COT_ACTIVATION) && (cot != CS101_COT_DEACTIVATION))
+        return CS101_PLUGIN_RESULT_NOT_HANDLED;
+
+    union uInformationObject _io;
+
+    InformationObject io = CS101_ASDU_getElementEx(asdu, (InformationObject)&_io, 0);
+
+    if (io == NULL)
+        return CS101_PLUGIN_RESULT_INVALID_ASDU;
+
+    /* the slave sends the negative response for an invalid IOA */
+    if (InformationObject_getObjectAddress(io) != 0)
+        return CS101_PLUGIN_RESULT_NOT_HANDLED;
+
+    bool counters = (typeId == C_CI_NA_1);
+    bool validQualifier = true;
+    uint16_t groupMask = 0;
+    CS101_CauseOfTransmission responseCot;
+
+    if (counters)
+    {
+        QualifierOfCIC qcc = CounterInterrogationCommand_getQCC((CounterInterrogationCommand)io);
+
+        int rqt = qcc & 0x3f;
+        int frz = (qcc >> 6) & 0x03;
+
+        /* freeze and reset requests are handled by the application */
+        if (frz != IEC60870_QCC_FRZ_READ)
+            return CS101_PLUGIN_RESULT_NOT_HANDLED;
+
+        if (rqt == IEC60870_QCC_RQT_GENERAL)
+            responseCot = CS101_COT_REQUESTED_BY_GENERAL_COUNTER;
+        else if ((rqt >= IEC60870_QCC_RQT_GROUP_1) && (rqt <= IEC60870_QCC_RQT_GROUP_4))
+        {
+            responseCot = (CS101_CauseOfTransmission)(CS101_COT_REQUESTED_BY_GENERAL_COUNTER + rqt);
+            groupMask = (uint16_t)(1 << (rqt - 1));
+        }
+        else
+        {
+            responseCot = CS101_COT_REQUESTED_BY_GENERAL_COUNTER;
+            validQualifier = false;
+        }
+    }
+    else
+    {
+        QualifierOfInterrogation qoi = InterrogationCommand_getQOI((InterrogationCommand)io);
+
+        if (qoi == IEC60870_QOI_STATION)
+            responseCot = CS101_COT_INTERROGATED_BY_STATION;
+        else if ((qoi > IEC60870_QOI_STATION) && (qoi <= IEC60870_QOI_STATION + 16))
+        {
+            responseCot = (CS101_CauseOfTransmission)qoi;
+            groupMask = (uint16_t)(1 << (qoi - IEC60870_QOI_STATION - 1));
+        }
+        else
+        {
+            responseCot = CS101_COT_INTERROGATED_BY_STATION;
+            validQualifier = false;
+        }
+    }
+
+    int ca = CS101_ASDU_getCA(asdu);
+    bool broadcast = isBroadcastCA(alParams, ca);
+
+    CS101_SlavePlugin_Result result = CS101_PLUGIN_RESULT_HANDLED;
+
+    lockImage(self);
+
+    rebuildOrder(self);
+
+    if (broadcast)
+    {
+        if (self->orderSize == 0)
+            result = CS101_PLUGIN_RESULT_NOT_HANDLED;
+    }
+    else if (hasCommonAddress(self, ca) == false)
+        result = CS101_PLUGIN_RESULT_NOT_HANDLED;
+
+    bool sendNegativeActCon = false;
+    bool sendActCon = false;
+    bool sendDeactCon = false;
+
+    ProcessImageJob* job = NULL;
+    bool startResponse = false;
+
+    if (result == CS101_PLUGIN_RESULT_HANDLED)
+    {
+        if (cot == CS101_COT_DEACTIVATION)
+        {
+            stopJob(self, connection, typeId);
+            sendDeactCon = true;
+        }
+        else if (validQualifier == false)
+            sendNegativeActCon = true;
+        else if ((job = startJob(self, connection, asdu, responseCot, counters, groupMask, broadcast)) != NULL)
+        {
+            /* for broadcast requests each CA is confirmed separately */
+            if (broadcast == false)
+                sendActCon = true;
+
+            if (job->streamed == false)
+            {
+                /* the plugin task must not send the job in the meantime */
+                job->streamed = true;
+                startResponse = true;
+            }
+        }
+        else
+            sendNegativeActCon = true;
+    }
+
+    unlockImage(self);
+
+    if (sendNegativeActCon)
+    {
+        DEBUG_PRINT("PROCESS IMAGE: reject interrogation command\n");
+        IMasterConnection_sendACT_CON(connection, asdu, true);
+    }
+    else if (sendActCon)
+        IMasterConnection_sendACT_CON(connection, asdu, false);
+    else if (sendDeactCon)
+    {
+        CS101_ASDU_setCOT(asdu, CS101_COT_DEACTIVATION_CON);
+        IMasterConnection_sendASDU(connection, asdu);
+    }
+
+    if (startResponse)
+    {
+        /* the ACT_TERM messages are created by the job (one for each CA of a broadcast request) */
+        if (IMasterConnection_startResponse(connection, NULL, ProcessImage_nextResponseASDU,
+                                            ProcessImage_responseFinished, job) == false)
+        {
+            /* the connection doesn't support streamed responses - sent from the plugin task */
+            lockImage(self);
+            job->streamed = false;
+            unlockImage(self);
+        }
+    }
+
+    return result;
+}
+
+/* handle C_RD_NA_1 */
+static CS101_SlavePlugin_Result
+handleRead(CS101_ProcessImage self, IMasterConnection connection, CS101_ASDU asdu)
+{
+    if (CS101_ASDU_getCOT(asdu) != CS101_COT_REQUEST)
+        return CS101_PLUGIN_RESULT_NOT_HANDLED;
+
+    union uInformationObject _io;
+
+    InformationObject io = CS101_ASDU_getElementEx(asdu, (InformationObject)&_io, 0);
+
+    if (io == NULL)
+        return CS101_PLUGIN_RESULT_INVALID_ASDU;
+
+    CS101_AppLayerParameters alParams = IMasterConnection_getApplicationLayerParameters(connection);
+
+    int ca = CS101_ASDU_getCA(asdu);
+    int ioa = InformationObject_getObjectAddress(io);
+
+    CS101_SlavePlugin_Result result = CS101_PLUGIN_RESULT_HANDLED;
+
+    sCS101_StaticASDU _response;
+    CS101_ASDU response = NULL;
+
+    lockImage(self);
+
+    int pointIndex = findPoint(self, ca, ioa);
+
+    if (pointIndex != -1)
+    {
+        response = CS101_ASDU_initializeStatic(&_response, alParams, false, CS101_COT_REQUEST,
+                                               CS101_ASDU_getOA(asdu), ca, false, false);
+
+        addPointToASDU(&(self->points[pointIndex]), response);
+    }
+    else
+    {
+        rebuildOrder(self);
+
+        if (hasCommonAddress(self, ca) == false)
+            result = CS101_PLUGIN_RESULT_NOT_HANDLED;
+    }
+
+    unlockImage(self);
+
+    if (response)
+        IMasterConnection_sendASDU(connection, response);
+    else if (result == CS101_PLUGIN_RESULT_HANDLED)
+    {
+        DEBUG_PRINT("PROCESS IMAGE: read command for unknown IOA %i\n", ioa);
+
+        CS101_ASDU_setCOT(asdu, CS101_COT_UNKNOWN_IOA);
+        CS101_ASDU_setNegative(asdu, true);
+        IMasterConnection_sendASDU(connection, asdu);
+    }
+
+    return result;
+}
+
+static bool
+isMeasuredValue(TypeID typeId)
+{
+    return ((typeId == M_ME_NA_1) || (typeId == M_ME_NB_1) || (typeId == M_ME_NC_1) || (typeId == M_ME_ND_1));
+}
+
+static void
+storeValue(ProcessImagePoint* point, double value)
+{
+    switch (point->typeId)
+    {
+    case M_ME_NA_1:
+    case M_ME_ND_1:
+    case M_ME_NC_1:
+        point->value.f = (float)value;
+        break;
+
+    case M_BO_NA_1:
+        point->value.u = (uint32_t)value;
+        break;
+
+    case M_ME_NB_1:
+        if (value > 32767)
+            value = 32767;
+        else if (value < -32768)
+            value = -32768;
+
+        point->value.i = (int32_t)value;
+        break;
+
+    default:
+        point->value.i = (int32_t)value;
+        break;
+    }
+}
+
+static float
+getStoredValue(ProcessImagePoint* point)
+{
+    switch (point->typeId)
+    {
+    case M_ME_NA_1:
+    case M_ME_ND_1:
+    case M_ME_NC_1:
+        return point->value.f;
+
+    case M_BO_NA_1:
+        return (float)point->value.u;
+
+    default:
+        return (float)point->value.i;
+    }
+}
+
+static inline float
+absoluteValue(float value)
+{
+    return (value < 0.f) ? -value : value;
+}
+
+static InformationObject
+createEventObject(ProcessImagePoint* point, union uInformationObject* io, BinaryCounterReading bcr,
+                  CP56Time2a timestamp)
+{
+    int ioa = (int)point->ioa;
+
+    switch (point->typeId)
+    {
+    case M_SP_NA_1:
+        return (InformationObject)SinglePointWithCP56Time2a_create((SinglePointWithCP56Time2a)io, ioa,
+                                                                   (point->value.i != 0), point->quality, timestamp);
+
+    case M_DP_NA_1:
+        return (InformationObject)DoublePointWithCP56Time2a_create(
+            (DoublePointWithCP56Time2a)io, ioa, (DoublePointValue)point->value.i, point->quality, timestamp);
+
+    case M_ST_NA_1:
+        return (InformationObject)StepPositionWithCP56Time2a_create((StepPositionWithCP56Time2a)io, ioa,
+                                                                    point->value.i, false, point->quality, timestamp);
+
+    case M_BO_NA_1:
+        return (InformationObject)Bitstring32WithCP56Time2a_createEx((Bitstring32WithCP56Time2a)io, ioa,
+                                                                     point->value.u, point->quality, timestamp);
+
+    /* there is no time tagged type without quality - normalized values are sent with quality */
+    case M_ME_NA_1:
+    case M_ME_ND_1:
+        return (InformationObject)MeasuredValueNormalizedWithCP56Time2a_create(
+            (MeasuredValueNormalizedWithCP56Time2a)io, ioa, point->value.f, point->quality, timestamp);
+
+    case M_ME_NB_1:
+        return (InformationObject)MeasuredValueScaledWithCP56Time2a_create(
+            (MeasuredValueScaledWithCP56Time2a)io, ioa, point->value.i, point->quality, timestamp);
+
+    case M_ME_NC_1:
+        return (InformationObject)MeasuredValueShortWithCP56Time2a_create(
+            (MeasuredValueShortWithCP56Time2a)io, ioa, point->value.f, point->quality, timestamp);
+
+    case M_IT_NA_1:
+        BinaryCounterReading_create(bcr, point->value.i, 0, false, false,
+                                    ((point->quality & IEC60870_QUALITY_INVALID) != 0));
+
+        return (InformationObject)IntegratedTotalsWithCP56Time2a_create((IntegratedTotalsWithCP56Time2a)io, ioa,
+                                                                        bcr, timestamp);
+
+    default:
+        return NULL;
+    }
+}
+
+/*
+ * Add an event to the pending event ASDU - has to be called with the lock.
+ *
+ * When the pending ASDU cannot take the event it is moved to "ready" and true is returned. The caller
+ * has to pass the ready ASDU to the event handler (without the lock).
+ */
+static bool
+addEvent(CS101_ProcessImage self, ProcessImagePoint* point, CP56Time2a timestamp, CS101_StaticASDU ready)
+{
+    union uInformationObject _io;
+    struct sBinaryCounterReading bcr;
+
+    bool isReady = false;
+
+    InformationObject io = createEventObject(point, &_io, &bcr, timestamp);
+
+    if (io == NULL)
+        return false;
+
+    if (self->eventASDU)
+    {
+        if ((CS101_ASDU_getCA(self->eventASDU) != point->ca) ||
+            (CS101_ASDU_getTypeID(self->eventASDU) != InformationObject_getType(io)) ||
+            (CS101_ASDU_addInformationObject(self->eventASDU, io) == false))
+        {
+            CS101_ASDU_clone(self->eventASDU, ready);
+            self->eventASDU = NULL;
+            isReady = true;
+        }
+        else
+            return false;
+    }
+
+    self->eventASDU = CS101_ASDU_initializeStatic(&(self->_eventASDU), self->eventAlParams, false,
+                                                  CS101_COT_SPONTANEOUS, 0, point->ca, false, false);
+
+    CS101_ASDU_addInformationObject(self->eventASDU, io);
+
+    return isReady;
+}
+
+/*
+ * Update a point and decide if an event is created - has to be called with the lock.
+ *
+ * \param deadbandExceeded result of the (absolute/percent) deadband check of the value
+ */
+static bool
+updatePoint(CS101_ProcessImage self, int index, double value, QualityDescriptor quality, bool deadbandExceeded)
+{
+    ProcessImagePoint* point = &(self->points[index]);
+
+    int mode = self->deadbandModes[index];
+
+    if (self->snapshots)
+        preservePoint(self, index);
+
+    bool isEvent = false;
+
+    if (isMeasuredValue((TypeID)point->typeId))
+    {
+        storeValue(point, value);
+
+        if (mode == CS101_DEADBAND_INTEGRATED)
+        {
+            self->integrals[index] += getStoredValue(point) - self->reportedValues[index];
+
+            isEvent = (absoluteValue(self->integrals[index]) > self->relativeLimits[index]);
+        }
+        else
+            isEvent = deadbandExceeded;
+    }
+    else
+    {
+        int32_t oldValue = point->value.i;
+
+        storeValue(point, value);
+
+        isEvent = (point->value.i != oldValue);
+    }
+
+    if (point->quality != quality)
+    {
+        point->quality = quality;
+        isEvent = true;
+    }
+
+    if ((mode == CS101_DEADBAND_NO_EVENTS) || (self->eventHandler == NULL))
+        isEvent = false;
+
+    if (isEvent)
+    {
+        self->reportedValues[index] = getStoredValue(point);
+        self->integrals[index] = 0.f;
+    }
+
+    return isEvent;
+}
+
+static CS101_SlavePlugin_Result
+ProcessImage_handleAsdu(void* parameter, IMasterConnection connection, CS101_ASDU asdu)
+{
+    CS101_ProcessImage self = (CS101_ProcessImage)parameter;
+
+    switch (CS101_ASDU_getTypeID(asdu))
+    {
+    case C_IC_NA_1:
+    case C_CI_NA_1:
+        return handleInterrogation(self, connection, asdu);
+
+    case C_RD_NA_1:
+        return handleRead(self, connection, asdu);
+
+    default:
+        return CS101_PLUGIN_RESULT_NOT_HANDLED;
+    }
+}
+
+static void
+ProcessImage_runTask(void* parameter, IMasterConnection connection)
+{
+    CS101_ProcessImage self = (CS101_ProcessImage)parameter;
+
+    int sentASDUs = 0;
+
+    while (sentASDUs < PI_MAX_ASDUS_PER_TASK)
+    {
+        if (IMasterConnection_isReady(connection) == false)
+            break;
+
+        uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+        ProcessImageJob* job = NULL;
+        ProcessImageAction action = PI_ACTION_NONE;
+        CS101_ASDU asdu = NULL;
+        bool finished = false;
+
+        lockImage(self);
+
+        int i;
+
+        for (i = 0; i < self->numberOfJobs; i++)
+        {
+            if ((self->jobs[i]->connection == connection) && (self->jobs[i]->streamed == false))
+            {
+                job = self->jobs[i];
+                break;
+            }
+        }
+
+        if (job)
+        {
+            rebuildOrder(self);
+
+            action = getNextAction(self, job, &asdu, &finished);
+
+            updateNextKey(self, job);
+
+            job->lastActivity = currentTime;
+        }
+
+        removeStaleJobs(self, connection, currentTime);
+
+        unlockImage(self);
+
+        if (job == NULL)
+            break;
+
+        /* only the task of the connection modifies or removes the job */
+        switch (action)
+        {
+        case PI_ACTION_SEND_ASDU:
+            IMasterConnection_sendASDU(connection, asdu);
+            break;
+
+        case PI_ACTION_SEND_ACT_CON:
+            IMasterConnection_sendACT_CON(connection, (CS101_ASDU)&(job->command), false);
+            break;
+
+        case PI_ACTION_SEND_ACT_TERM:
+            IMasterConnection_sendACT_TERM(connection, (CS101_ASDU)&(job->command));
+            break;
+
+        default:
+            break;
+        }
+
+        if (finished)
+        {
+            lockImage(self);
+
+            int jobIndex = findJob(self, connection, job->commandType);
+
+            if (jobIndex != -1)
+                removeJob(self, jobIndex);
+
+            unlockImage(self);
+        }
+
+        if (action != PI_ACTION_NONE)
+            sentASDUs++;
+    }
+}
+
+static void
+freePointArrays(CS101_ProcessImage self)
+{
+    GLOBAL_FREEMEM(self->points);
+    GLOBAL_FREEMEM(self->reportedValues);
+    GLOBAL_FREEMEM(self->absoluteLimits);
+    GLOBAL_FREEMEM(self->relativeLimits);
+    GLOBAL_FREEMEM(self->integrals);
+    GLOBAL_FREEMEM(self->deadbandModes);
+}
+
+static bool
+resizePointArrays(CS101_ProcessImage self, int newMaxPoints)
+{
+    void* newArray;
+
+    newArray = GLOBAL_REALLOC(self->points, newMaxPoints * sizeof(ProcessImagePoint));
+    if (newArray == NULL)
+        return false;
+    self->points = (ProcessImagePoint*)newArray;
+
+    newArray = GLOBAL_REALLOC(self->reportedValues, newMaxPoints * sizeof(float));
+    if (newArray == NULL)
+        return false;
+    self->reportedValues = (float*)newArray;
+
+    newArray = GLOBAL_REALLOC(self->absoluteLimits, newMaxPoints * sizeof(float));
+    if (newArray == NULL)
+        return false;
+    self->absoluteLimits = (float*)newArray;
+
+    newArray = GLOBAL_REALLOC(self->relativeLimits, newMaxPoints * sizeof(float));
+    if (newArray == NULL)
+        return false;
+    self->relativeLimits = (float*)newArray;
+
+    newArray = GLOBAL_REALLOC(self->integrals, newMaxPoints * sizeof(float));
+    if (newArray == NULL)
+        return false;
+    self->integrals = (float*)newArray;
+
+    newArray = GLOBAL_REALLOC(self->deadbandModes, newMaxPoints * sizeof(uint8_t));
+    if (newArray == NULL)
+        return false;
+    self->deadbandModes = (uint8_t*)newArray;
+
+    self->maxPoints = newMaxPoints;
+
+    return true;
+}
+
+CS101_ProcessImage
+CS101_ProcessImage_create(int initialCapacity)
+{
+    CS101_ProcessImage self = (CS101_ProcessImage)GLOBAL_CALLOC(1, sizeof(struct sCS101_ProcessImage));
+
+    if (self)
+    {
+        if (initialCapacity < 16)
+            initialCapacity = 16;
+
+        int hashCapacity = 16;
+
+        while ((hashCapacity * 3) < (initialCapacity * 4))
+            hashCapacity *= 2;
+
+        self->hashTable = (int*)GLOBAL_CALLOC(hashCapacity, sizeof(int));
+
+        if ((self->hashTable == NULL) || (resizePointArrays(self, initialCapacity) == false))
+        {
+            freePointArrays(self);
+            GLOBAL_FREEMEM(self->hashTable);
+            GLOBAL_FREEMEM(self);
+            return NULL;
+        }
+
+        self->hashCapacity = hashCapacity;
+
+        self->snapshotSharingTime = PI_DEFAULT_SNAPSHOT_SHARING_TIME_MS;
+
+        self->plugin.handleAsdu = ProcessImage_handleAsdu;
+        self->plugin.runTask = ProcessImage_runTask;
+        self->plugin.parameter = self;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        self->lock = Semaphore_create(1);
+#endif
+    }
+
+    return self;
+}
+
+void
+CS101_ProcessImage_destroy(CS101_ProcessImage self)
+{
+    if (self)
+    {
+        while (self->numberOfJobs > 0)
+            removeJob(self, 0);
+
+        GLOBAL_FREEMEM(self->jobs);
+        GLOBAL_FREEMEM(self->order);
+        GLOBAL_FREEMEM(self->hashTable);
+
+        freePointArrays(self);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_destroy(self->lock);
+#endif
+
+        GLOBAL_FREEMEM(self);
+    }
+}
+
+int
+CS101_ProcessImage_addPoint(CS101_ProcessImage self, int ca, int ioa, TypeID typeId, uint16_t groups)
+{
+    if (isSupportedType(typeId) == false)
+        return -1;
+
+    int pointIndex = -1;
+
+    lockImage(self);
+
+    if (findPoint(self, ca, ioa) != -1)
+        goto exit_function;
+
+    if (self->numberOfPoints == self->maxPoints)
+    {
+        if (resizePointArrays(self, self->maxPoints * 2) == false)
+            goto exit_function;
+    }
+
+    /* keep the load factor below 75% to keep the probe sequences short */
+    if (((self->numberOfPoints + 1) * 4) > (self->hashCapacity * 3))
+    {
+        if (resizeHashTable(self, self->hashCapacity * 2) == false)
+            goto exit_function;
+    }
+
+    pointIndex = self->numberOfPoints;
+
+    ProcessImagePoint* point = &(self->points[pointIndex]);
+
+    memset(point, 0, sizeof(ProcessImagePoint));
+
+    point->ca = (uint16_t)ca;
+    point->ioa = (uint32_t)ioa;
+    point->typeId = (uint8_t)typeId;
+    point->groups = groups;
+    point->quality = IEC60870_QUALITY_INVALID;
+
+    self->reportedValues[pointIndex] = 0.f;
+    self->absoluteLimits[pointIndex] = 0.f;
+    self->relativeLimits[pointIndex] = 0.f;
+    self->integrals[pointIndex] = 0.f;
+    self->deadbandModes[pointIndex] = CS101_DEADBAND_ABSOLUTE;
+
+    self->numberOfPoints++;
+
+    insertHashEntry(self, pointIndex);
+
+    self->orderValid = false;
+
+exit_function:
+    unlockImage(self);
+
+    return pointIndex;
+}
+
+int
+CS101_ProcessImage_getPointIndex(CS101_ProcessImage self, int ca, int ioa)
+{
+    lockImage(self);
+
+    int pointIndex = findPoint(self, ca, ioa);
+
+    unlockImage(self);
+
+    return pointIndex;
+}
+
+int
+CS101_ProcessImage_getNumberOfPoints(CS101_ProcessImage self)
+{
+    return self->numberOfPoints;
+}
+
+bool
+CS101_ProcessImage_setValue(CS101_ProcessImage self, int index, double value, QualityDescriptor quality)
+{
+    if ((index < 0) || (index >= self->numberOfPoints))
+        return false;
+
+    lockImage(self);
+
+    ProcessImagePoint* point = &(self->points[index]);
+
+    if (self->snapshots)
+        preservePoint(self, index);
+
+    storeValue(point, value);
+
+    point->quality = quality;
+
+    /* the value is the new reference for the deadband check */
+    self->reportedValues[index] = getStoredValue(point);
+    self->integrals[index] = 0.f;
+
+    unlockImage(self);
+
+    return true;
+}
+
+bool
+CS101_ProcessImage_getValue(CS101_ProcessImage self, int index, double* value, QualityDescriptor* quality)
+{
+    if ((index < 0) || (index >= self->numberOfPoints))
+        return false;
+
+    lockImage(self);
+
+    ProcessImagePoint* point = &(self->points[index]);
+
+    if (value)
+    {
+        switch (point->typeId)
+        {
+        case M_ME_NA_1:
+        case M_ME_ND_1:
+        case M_ME_NC_1:
+            *value = point->value.f;
+            break;
+
+        case M_BO_NA_1:
+            *value = point->value.u;
+            break;
+
+        default:
+            *value = point->value.i;
+            break;
+        }
+    }
+
+    if (quality)
+        *quality = point->quality;
+
+    unlockImage(self);
+
+    return true;
+}
+
+void
+CS101_ProcessImage_setSnapshotSharingTime(CS101_ProcessImage self, int timeInMs)
+{
+    lockImage(self);
+
+    self->snapshotSharingTime = timeInMs;
+
+    unlockImage(self);
+}
+
+CS101_SlavePlugin
+CS101_ProcessImage_getPlugin(CS101_ProcessImage self)
+{
+    return &(self->plugin);
+}
+
+void
+CS101_ProcessImage_setEventHandler(CS101_ProcessImage self, CS101_AppLayerParameters alParams,
+                                   CS101_ProcessImageEventHandler handler, void* parameter)
+{
+    CS101_ProcessImage_flushEvents(self);
+
+    lockImage(self);
+
+    self->eventAlParams = alParams;
+    self->eventHandler = handler;
+    self->eventHandlerParameter = parameter;
+
+    unlockImage(self);
+}
+
+bool
+CS101_ProcessImage_setDeadband(CS101_ProcessImage self, int index, CS101_DeadbandMode mode, double deadband)
+{
+    if ((index < 0) || (index >= self->numberOfPoints))
+        return false;
+
+    lockImage(self);
+
+    switch (mode)
+    {
+    case CS101_DEADBAND_ABSOLUTE:
+        self->absoluteLimits[index] = (float)deadband;
+        self->relativeLimits[index] = 0.f;
+        break;
+
+    case CS101_DEADBAND_PERCENT:
+        self->absoluteLimits[index] = 0.f;
+        self->relativeLimits[index] = (float)(deadband / 100.0);
+        break;
+
+    case CS101_DEADBAND_INTEGRATED:
+        self->absoluteLimits[index] = FLT_MAX;
+        self->relativeLimits[index] = (float)deadband;
+        break;
+
+    default:
+        mode = CS101_DEADBAND_NO_EVENTS;
+        self->absoluteLimits[index] = FLT_MAX;
+        self->relativeLimits[index] = 0.f;
+        break;
+    }
+
+    self->deadbandModes[index] = (uint8_t)mode;
+    self->integrals[index] = 0.f;
+
+    unlockImage(self);
+
+    return true;
+}
+
+bool
+CS101_ProcessImage_updateValue(CS101_ProcessImage self, int index, double value, QualityDescriptor quality,
+                               CP56Time2a timestamp)
+{
+    if ((index < 0) || (index >= self->numberOfPoints))
+        return false;
+
+    struct sCP56Time2a currentTime;
+
+    if (timestamp == NULL)
+        timestamp = CP56Time2a_createFromMsTimestamp(&currentTime, Hal_getTimeInMs());
+
+    sCS101_StaticASDU ready;
+    bool isReady = false;
+
+    lockImage(self);
+
+    float reported = self->reportedValues[index];
+
+    bool exceeded = (absoluteValue((float)value - reported) >
+                     self->absoluteLimits[index] + self->relativeLimits[index] * absoluteValue(reported));
+
+    bool isEvent = updatePoint(self, index, value, quality, exceeded);
+
+    if (isEvent)
+        isReady = addEvent(self, &(self->points[index]), timestamp, &ready);
+
+    CS101_ProcessImageEventHandler handler = self->eventHandler;
+    void* handlerParameter = self->eventHandlerParameter;
+
+    unlockImage(self);
+
+    if (isReady && handler)
+        handler(handlerParameter, (CS101_ASDU)&ready);
+
+    return isEvent;
+}
+
+int
+CS101_ProcessImage_updateValues(CS101_ProcessImage self, int firstIndex, int count, const float* values,
+                                const QualityDescriptor* qualities, CP56Time2a timestamp)
+{
+    if ((firstIndex < 0) || (count < 0) || (firstIndex + count > self->numberOfPoints))
+        return -1;
+
+    struct sCP56Time2a currentTime;
+
+    if (timestamp == NULL)
+        timestamp = CP56Time2a_createFromMsTimestamp(&currentTime, Hal_getTimeInMs());
+
+    uint8_t exceeded[PI_BULK_CHUNK_SIZE];
+    sCS101_StaticASDU ready;
+
+    int events = 0;
+    int offset = 0;
+
+    lockImage(self);
+
+    while (offset < count)
+    {
+        int chunkSize = count - offset;
+
+        if (chunkSize > PI_BULK_CHUNK_SIZE)
+            chunkSize = PI_BULK_CHUNK_SIZE;
+
+        const float* chunkValues = values + offset;
+        const float* reported = self->reportedValues + firstIndex + offset;
+        const float* absoluteLimits = self->absoluteLimits + firstIndex + offset;
+        const float* relativeLimits = self->relativeLimits + firstIndex + offset;
+
+        int i;
+
+        /* deadband check without branches over contiguous arrays */
+        for (i = 0; i < chunkSize; i++)
+        {
+            float limit = absoluteLimits[i] + relativeLimits[i] * absoluteValue(reported[i]);
+
+            exceeded[i] = (absoluteValue(chunkValues[i] - reported[i]) > limit);
+        }
+
+        for (i = 0; i < chunkSize; i++)
+        {
+            int index = firstIndex + offset + i;
+
+            QualityDescriptor quality = qualities ? qualities[offset + i] : self->points[index].quality;
+
+            if (updatePoint(self, index, chunkValues[i], quality, (exceeded[i] != 0)))
+            {
+                events++;
+
+                if (addEvent(self, &(self->points[index]), timestamp, &ready))
+                {
+                    CS101_ProcessImageEventHandler handler = self->eventHandler;
+                    void* handlerParameter = self->eventHandlerParameter;
+
+                    unlockImage(self);
+
+                    handler(handlerParameter, (CS101_ASDU)&ready);
+
+                    lockImage(self);
+                }
+            }
+        }
+
+        offset += chunkSize;
+    }
+
+    unlockImage(self);
+
+    CS101_ProcessImage_flushEvents(self);
+
+    return events;
+}
+
+void
+CS101_ProcessImage_flushEvents(CS101_ProcessImage self)
+{
+    sCS101_StaticASDU ready;
+    bool isReady = false;
+
+    lockImage(self);
+
+    if (self->eventASDU)
+    {
+        CS101_ASDU_clone(self->eventASDU, &ready);
+        self->eventASDU = NULL;
+        isReady = true;
+    }
+
+    CS101_ProcessImageEventHandler handler = self->eventHandler;
+    void* handlerParameter = self->eventHandlerParameter;
+
+    unlockImage(self);
+
+    if (isReady && handler)
+        handler(handlerParameter, (CS101_ASDU)&ready);
+}
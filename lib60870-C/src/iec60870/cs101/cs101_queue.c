@@ -31,6 +31,8 @@
 #include "lib60870_internal.h"
 #include "apl_types_internal.h"
 #include "cs101_queue.h"
+#include "cs101_asdu_internal.h"
+#include "hal_time.h"
 
 /********************************************
  * CS101_Queue
@@ -46,6 +48,15 @@ CS101_Queue_initialize(CS101_Queue self, int maxQueueSize)
 
     BufferFrame_initialize(&(self->encodeFrame), NULL, 0);
 
+    self->coalescing = false;
+
+    self->enqueuedCounter = 0;
+    self->dequeuedCounter = 0;
+    self->droppedCounter = 0;
+    self->coalescedCounter = 0;
+    self->totalAge = 0;
+    self->maxAge = 0;
+
 #if (CS101_MAX_QUEUE_SIZE == -1)
     int queueSize = maxQueueSize;
 
@@ -93,10 +104,107 @@ CS101_Queue_unlock(CS101_Queue self)
 #endif
 }
 
-void
-CS101_Queue_enqueue(CS101_Queue self, CS101_ASDU asdu)
+#if (CONFIG_CS101_QUEUE_COALESCING == 1)
+
+/* get the key of a cyclic value that can be replaced by a newer value (0 when the ASDU can't be coalesced) */
+static uint64_t
+getCoalescingKey(CS101_ASDU asdu)
 {
-    CS101_Queue_lock(self);
+    if ((CS101_ASDU_getNumberOfElements(asdu) != 1) || CS101_ASDU_isSequence(asdu))
+        return 0;
+
+    CS101_CauseOfTransmission cot = CS101_ASDU_getCOT(asdu);
+
+    if ((cot != CS101_COT_PERIODIC) && (cot != CS101_COT_BACKGROUND_SCAN))
+        return 0;
+
+    int sizeOfIOA = asdu->parameters->sizeOfIOA;
+
+    if (asdu->payloadSize < sizeOfIOA)
+        return 0;
+
+    uint64_t ioa = 0;
+
+    int i;
+
+    for (i = sizeOfIOA - 1; i >= 0; i--)
+        ioa = (ioa << 8) + asdu->payload[i];
+
+    return ((uint64_t)CS101_ASDU_getTypeID(asdu) << 56) + ((uint64_t)(CS101_ASDU_getCA(asdu) & 0xffff) << 32) + ioa;
+}
+
+/* find a queued ASDU with the same key (-1 when not found) */
+static int
+findCoalescingEntry(CS101_Queue self, uint64_t key)
+{
+    int index = self->firstMsgIndex;
+    int i;
+
+    for (i = 0; i < self->entryCounter; i++) {
+        if (self->elements[index].coalescingKey == key)
+            return index;
+
+        index++;
+
+        if (index == self->size)
+            index = 0;
+    }
+
+    return -1;
+}
+
+#endif /* (CONFIG_CS101_QUEUE_COALESCING == 1) */
+
+static void
+encodeElement(CS101_Queue self, int index, CS101_ASDU asdu, uint64_t key)
+{
+    self->encodeFrame.buffer = self->elements[index].buffer;
+    self->encodeFrame.startSize = 0;
+    self->encodeFrame.msgSize = 0;
+
+    CS101_ASDU_encode(asdu, (Frame)&(self->encodeFrame));
+
+    self->elements[index].size = self->encodeFrame.msgSize;
+
+#if (CONFIG_CS101_QUEUE_EVENT_AGE == 1)
+    self->elements[index].enqueueTime = Hal_getMonotonicTimeInMs();
+#endif
+
+#if (CONFIG_CS101_QUEUE_COALESCING == 1)
+    self->elements[index].coalescingKey = key;
+#else
+    UNUSED_PARAMETER(key);
+#endif
+}
+
+/*
+ * NOTE: Locking has to be done by caller!
+ */
+static void
+enqueueASDU(CS101_Queue self, CS101_ASDU asdu)
+{
+    self->enqueuedCounter++;
+
+    uint64_t key = 0;
+
+#if (CONFIG_CS101_QUEUE_COALESCING == 1)
+    key = getCoalescingKey(asdu);
+
+    if (self->coalescing && (key != 0)) {
+        int index = findCoalescingEntry(self, key);
+
+        if (index != -1) {
+            DEBUG_PRINT("replace entry (index:%i)\n", index);
+
+            /* the new value replaces the old value at the same position in the queue */
+            encodeElement(self, index, asdu, key);
+
+            self->coalescedCounter++;
+
+            return;
+        }
+    }
+#endif /* (CONFIG_CS101_QUEUE_COALESCING == 1) */
 
     int nextIndex;
     bool removeEntry = false;
@@ -131,19 +239,35 @@ CS101_Queue_enqueue(CS101_Queue self, CS101_ASDU asdu)
             firstIndex = 0;
 
         self->firstMsgIndex = firstIndex;
-    }
-
-    self->encodeFrame.buffer = self->elements[nextIndex].buffer;
-    self->encodeFrame.startSize = 0;
-    self->encodeFrame.msgSize = 0;
 
-    CS101_ASDU_encode(asdu, (Frame)&(self->encodeFrame));
+        self->droppedCounter++;
+    }
 
-    int srcSize = self->encodeFrame.msgSize;
-    self->elements[nextIndex].size = srcSize;
+    encodeElement(self, nextIndex, asdu, key);
 
     DEBUG_PRINT("Events in FIFO: %i (first: %i, last: %i)\n", self->entryCounter,
             self->firstMsgIndex, self->lastMsgIndex);
+}
+
+void
+CS101_Queue_enqueue(CS101_Queue self, CS101_ASDU asdu)
+{
+    CS101_Queue_lock(self);
+
+    enqueueASDU(self, asdu);
+
+    CS101_Queue_unlock(self);
+}
+
+void
+CS101_Queue_enqueueBatch(CS101_Queue self, CS101_ASDU* asdus, int numberOfAsdus)
+{
+    CS101_Queue_lock(self);
+
+    int i;
+
+    for (i = 0; i < numberOfAsdus; i++)
+        enqueueASDU(self, asdus[i]);
 
     CS101_Queue_unlock(self);
 }
@@ -166,8 +290,22 @@ CS101_Queue_dequeue(CS101_Queue self, Frame resultStorage)
 
             Frame_appendBytes(frame, self->elements[currentIndex].buffer, self->elements[currentIndex].size);
 
+#if (CONFIG_CS101_QUEUE_EVENT_AGE == 1)
+            uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+            if (currentTime > self->elements[currentIndex].enqueueTime) {
+                uint64_t age = currentTime - self->elements[currentIndex].enqueueTime;
+
+                self->totalAge += age;
+
+                if (age > self->maxAge)
+                    self->maxAge = age;
+            }
+#endif
+
             self->firstMsgIndex = (currentIndex + 1) % self->size;
             self->entryCounter--;
+            self->dequeuedCounter++;
         }
     }
 
@@ -187,6 +325,33 @@ CS101_Queue_isEmpty(CS101_Queue self)
 }
 
 
+void
+CS101_Queue_setCoalescing(CS101_Queue self, bool enable)
+{
+    CS101_Queue_lock(self);
+    self->coalescing = enable;
+    CS101_Queue_unlock(self);
+}
+
+void
+CS101_Queue_addStatistics(CS101_Queue self, CS101_QueueStatistics* statistics)
+{
+    CS101_Queue_lock(self);
+
+    statistics->entries += self->entryCounter;
+    statistics->size += self->size;
+    statistics->enqueued += self->enqueuedCounter;
+    statistics->sent += self->dequeuedCounter;
+    statistics->dropped += self->droppedCounter;
+    statistics->coalesced += self->coalescedCounter;
+    statistics->totalAgeMs += self->totalAge;
+
+    if (self->maxAge > statistics->maxAgeMs)
+        statistics->maxAgeMs = self->maxAge;
+
+    CS101_Queue_unlock(self);
+}
+
 void
 CS101_Queue_flush(CS101_Queue self)
 {
@@ -0,0 +1,231 @@
+/*
+ *  cs101_response_stream.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include <stdlib.h>
+
+#include "cs101_response_stream.h"
+#include "lib60870_internal.h"
+#include "lib_memory.h"
+
+struct sCS101_ResponseStream
+{
+    CS101_ResponseGenerator generator;
+    CS101_ResponseFinishedHandler finishedHandler;
+    void* parameter;
+
+    bool hasCommand;
+    bool generatorFinished; /* generator returned NULL - only the ACT_TERM is missing */
+
+    CS101_ASDU pendingAsdu; /* ASDU that could not be sent (sent again with the next call) */
+
+    sCS101_StaticASDU command;
+    sCS101_StaticASDU buffer;
+
+    CS101_ResponseStream next;
+};
+
+void
+CS101_ResponseStreams_initialize(CS101_ResponseStreams self)
+{
+    self->first = NULL;
+    self->last = NULL;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    self->lock = Semaphore_create(1);
+#endif
+}
+
+void
+CS101_ResponseStreams_dispose(CS101_ResponseStreams self)
+{
+    CS101_ResponseStream stream = self->first;
+
+    while (stream)
+    {
+        CS101_ResponseStream next = stream->next;
+
+        GLOBAL_FREEMEM(stream);
+
+        stream = next;
+    }
+
+    self->first = NULL;
+    self->last = NULL;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_destroy(self->lock);
+#endif
+}
+
+bool
+CS101_ResponseStreams_add(CS101_ResponseStreams self, CS101_ASDU command, CS101_ResponseGenerator generator,
+                          CS101_ResponseFinishedHandler finishedHandler, void* parameter)
+{
+    if (generator == NULL)
+        return false;
+
+    CS101_ResponseStream stream = (CS101_ResponseStream)GLOBAL_CALLOC(1, sizeof(struct sCS101_ResponseStream));
+
+    if (stream == NULL)
+    {
+        DEBUG_PRINT("RESPONSE_STREAM: Failed to allocate memory for response\n");
+        return false;
+    }
+
+    stream->generator = generator;
+    stream->finishedHandler = finishedHandler;
+    stream->parameter = parameter;
+
+    if (command)
+    {
+        CS101_ASDU_clone(command, &(stream->command));
+        stream->hasCommand = true;
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    if (self->last)
+        self->last->next = stream;
+    else
+        self->first = stream;
+
+    self->last = stream;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return true;
+}
+
+bool
+CS101_ResponseStreams_isEmpty(CS101_ResponseStreams self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    bool isEmpty = (self->first == NULL);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return isEmpty;
+}
+
+static CS101_ResponseStream
+removeFirst(CS101_ResponseStreams self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    CS101_ResponseStream stream = self->first;
+
+    if (stream)
+    {
+        self->first = stream->next;
+
+        if (self->first == NULL)
+            self->last = NULL;
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return stream;
+}
+
+bool
+CS101_ResponseStreams_sendNext(CS101_ResponseStreams self, IMasterConnection connection)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    /* only the sending thread removes responses - the first response stays valid after unlocking */
+    CS101_ResponseStream stream = self->first;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    if (stream == NULL)
+        return false;
+
+    if (stream->generatorFinished == false)
+    {
+        if (stream->pendingAsdu == NULL)
+        {
+            stream->pendingAsdu = stream->generator(stream->parameter, connection, &(stream->buffer));
+
+            if (stream->pendingAsdu == NULL)
+                stream->generatorFinished = true;
+        }
+
+        if (stream->pendingAsdu)
+        {
+            if (IMasterConnection_sendASDU(connection, stream->pendingAsdu) == false)
+                return false;
+
+            stream->pendingAsdu = NULL;
+
+            return true;
+        }
+    }
+
+    if (stream->hasCommand)
+    {
+        if (IMasterConnection_sendACT_TERM(connection, (CS101_ASDU)&(stream->command)) == false)
+            return false;
+    }
+
+    removeFirst(self);
+
+    if (stream->finishedHandler)
+        stream->finishedHandler(stream->parameter, connection, true);
+
+    GLOBAL_FREEMEM(stream);
+
+    return true;
+}
+
+void
+CS101_ResponseStreams_clear(CS101_ResponseStreams self, IMasterConnection connection)
+{
+    CS101_ResponseStream stream;
+
+    while ((stream = removeFirst(self)) != NULL)
+    {
+        DEBUG_PRINT("RESPONSE_STREAM: Response aborted\n");
+
+        if (stream->finishedHandler)
+            stream->finishedHandler(stream->parameter, connection, false);
+
+        GLOBAL_FREEMEM(stream);
+    }
+}
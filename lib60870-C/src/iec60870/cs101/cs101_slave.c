@@ -22,10 +22,12 @@
  */
 
 #include "cs101_slave.h"
+#include "cs101_slave_internal.h"
 #include "apl_types_internal.h"
 #include "buffer_frame.h"
 #include "cs101_asdu_internal.h"
 #include "cs101_queue.h"
+#include "cs101_response_stream.h"
 #include "iec60870_slave.h"
 #include "lib60870_config.h"
 #include "lib60870_internal.h"
@@ -80,12 +82,19 @@ struct sCS101_Slave
 
     struct sCS101_AppLayerParameters alParameters;
 
+    /* class 1 data generated by the stack or the callback handlers (e.g. ACT_CON, ACT_TERM, interrogation
+     * responses). It is sent before the application class 1 data. */
+    struct sCS101_Queue userDataClass1HighPrioQueue;
+
     struct sCS101_Queue userDataClass1Queue;
 
     struct sCS101_Queue userDataClass2Queue;
 
     struct sIMasterConnection iMasterConnection;
 
+    /* streamed responses - the next ASDU is created when the high priority queue is empty */
+    struct sCS101_ResponseStreams responseStreams;
+
     IEC60870_LinkLayerMode linkLayerMode;
 
 #if (CONFIG_USE_THREADS == 1)
@@ -108,7 +117,8 @@ IsClass1DataAvailable(void* parameter)
 {
     CS101_Slave self = (CS101_Slave)parameter;
 
-    return (CS101_Queue_isEmpty(&(self->userDataClass1Queue)) == false);
+    return ((CS101_Queue_isEmpty(&(self->userDataClass1HighPrioQueue)) == false) ||
+            (CS101_Queue_isEmpty(&(self->userDataClass1Queue)) == false));
 }
 
 static Frame
@@ -116,6 +126,15 @@ GetClass1Data(void* parameter, Frame frame)
 {
     CS101_Slave self = (CS101_Slave)parameter;
 
+    CS101_Queue_lock(&(self->userDataClass1HighPrioQueue));
+
+    Frame highPrioData = CS101_Queue_dequeue(&(self->userDataClass1HighPrioQueue), frame);
+
+    CS101_Queue_unlock(&(self->userDataClass1HighPrioQueue));
+
+    if (highPrioData)
+        return highPrioData;
+
     CS101_Queue_lock(&(self->userDataClass1Queue));
 
     Frame userData = CS101_Queue_dequeue(&(self->userDataClass1Queue), frame);
@@ -232,7 +251,8 @@ isReady(IMasterConnection self)
 {
     CS101_Slave slave = (CS101_Slave)self->object;
 
-    if (CS101_Slave_isClass1QueueFull(slave))
+    /* the high priority queue is sent first - a full application queue still slows down the responses */
+    if (CS101_Queue_isFull(&(slave->userDataClass1HighPrioQueue)) || CS101_Slave_isClass1QueueFull(slave))
         return false;
     else
         return true;
@@ -243,7 +263,7 @@ sendASDU(IMasterConnection self, CS101_ASDU asdu)
 {
     CS101_Slave slave = (CS101_Slave)self->object;
 
-    CS101_Slave_enqueueUserDataClass1(slave, asdu);
+    CS101_Queue_enqueue(&(slave->userDataClass1HighPrioQueue), asdu);
 
     return true;
 }
@@ -274,6 +294,15 @@ getApplicationLayerParameters(IMasterConnection self)
     return &(slave->alParameters);
 }
 
+static bool
+startResponse(IMasterConnection self, CS101_ASDU command, CS101_ResponseGenerator generator,
+              CS101_ResponseFinishedHandler finishedHandler, void* parameter)
+{
+    CS101_Slave slave = (CS101_Slave)self->object;
+
+    return CS101_ResponseStreams_add(&(slave->responseStreams), command, generator, finishedHandler, parameter);
+}
+
 /********************************************
  * END IMasterConnection
  *******************************************/
@@ -353,8 +382,12 @@ CS101_Slave_createEx(SerialPort serialPort, const LinkLayerParameters llParamete
         self->iMasterConnection.getApplicationLayerParameters = getApplicationLayerParameters;
         self->iMasterConnection.close = NULL;
         self->iMasterConnection.getPeerAddress = NULL;
+        self->iMasterConnection.startResponse = startResponse;
         self->iMasterConnection.object = self;
 
+        CS101_ResponseStreams_initialize(&(self->responseStreams));
+
+        CS101_Queue_initialize(&(self->userDataClass1HighPrioQueue), CONFIG_CS101_MESSAGE_QUEUE_HIGH_PRIO_SIZE);
         CS101_Queue_initialize(&(self->userDataClass1Queue), class1QueueSize);
         CS101_Queue_initialize(&(self->userDataClass2Queue), class2QueueSize);
 
@@ -385,9 +418,13 @@ CS101_Slave_destroy(CS101_Slave self)
 
         SerialTransceiverFT12_destroy(self->transceiver);
 
+        CS101_Queue_dispose(&(self->userDataClass1HighPrioQueue));
         CS101_Queue_dispose(&(self->userDataClass1Queue));
         CS101_Queue_dispose(&(self->userDataClass2Queue));
 
+        CS101_ResponseStreams_clear(&(self->responseStreams), &(self->iMasterConnection));
+        CS101_ResponseStreams_dispose(&(self->responseStreams));
+
         if (self->plugins)
         {
             LinkedList_destroyStatic(self->plugins);
@@ -466,6 +503,12 @@ CS101_Slave_enqueueUserDataClass1(CS101_Slave self, CS101_ASDU asdu)
     CS101_Queue_enqueue(&(self->userDataClass1Queue), asdu);
 }
 
+void
+CS101_Slave_enqueueUserDataClass1Batch(CS101_Slave self, CS101_ASDU* asdus, int numberOfAsdus)
+{
+    CS101_Queue_enqueueBatch(&(self->userDataClass1Queue), asdus, numberOfAsdus);
+}
+
 bool
 CS101_Slave_isClass2QueueFull(CS101_Slave self)
 {
@@ -478,13 +521,67 @@ CS101_Slave_enqueueUserDataClass2(CS101_Slave self, CS101_ASDU asdu)
     CS101_Queue_enqueue(&(self->userDataClass2Queue), asdu);
 }
 
+void
+CS101_Slave_enqueueUserDataClass2Batch(CS101_Slave self, CS101_ASDU* asdus, int numberOfAsdus)
+{
+    CS101_Queue_enqueueBatch(&(self->userDataClass2Queue), asdus, numberOfAsdus);
+}
+
+void
+CS101_Slave_setClass2Coalescing(CS101_Slave self, bool enable)
+{
+    CS101_Queue_setCoalescing(&(self->userDataClass2Queue), enable);
+}
+
+void
+CS101_Slave_getClass1QueueStatistics(CS101_Slave self, CS101_QueueStatistics* statistics)
+{
+    memset(statistics, 0, sizeof(CS101_QueueStatistics));
+
+    CS101_Queue_addStatistics(&(self->userDataClass1HighPrioQueue), statistics);
+    CS101_Queue_addStatistics(&(self->userDataClass1Queue), statistics);
+}
+
+void
+CS101_Slave_getClass2QueueStatistics(CS101_Slave self, CS101_QueueStatistics* statistics)
+{
+    memset(statistics, 0, sizeof(CS101_QueueStatistics));
+
+    CS101_Queue_addStatistics(&(self->userDataClass2Queue), statistics);
+}
+
+void
+CS101_Slave_getLinkLayerStatistics(CS101_Slave self, CS101_LinkLayerStatistics* statistics)
+{
+    if (self->unbalancedLinkLayer)
+        LinkLayerSecondaryUnbalanced_getStatistics(self->unbalancedLinkLayer, statistics);
+    else
+        LinkLayerBalanced_getStatistics(self->balancedLinkLayer, statistics);
+}
+
+void
+CS101_Slave_resetLinkLayerStatistics(CS101_Slave self)
+{
+    if (self->unbalancedLinkLayer)
+        LinkLayerSecondaryUnbalanced_resetStatistics(self->unbalancedLinkLayer);
+    else
+        LinkLayerBalanced_resetStatistics(self->balancedLinkLayer);
+}
+
 void
 CS101_Slave_flushQueues(CS101_Slave self)
 {
+    CS101_Queue_flush(&(self->userDataClass1HighPrioQueue));
     CS101_Queue_flush(&(self->userDataClass1Queue));
     CS101_Queue_flush(&(self->userDataClass2Queue));
 }
 
+SerialTransceiverFT12
+CS101_Slave_getTransceiver(CS101_Slave self)
+{
+    return self->transceiver;
+}
+
 void
 CS101_Slave_run(CS101_Slave self)
 {
@@ -493,6 +590,10 @@ CS101_Slave_run(CS101_Slave self)
     else
         LinkLayerBalanced_run(self->balancedLinkLayer);
 
+    /* create the next ASDU of a streamed response when the previous ASDU was sent */
+    if (CS101_Queue_isEmpty(&(self->userDataClass1HighPrioQueue)))
+        CS101_ResponseStreams_sendNext(&(self->responseStreams), &(self->iMasterConnection));
+
     /* call plugins */
     if (self->plugins)
     {
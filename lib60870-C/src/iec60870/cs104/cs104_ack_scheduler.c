@@ -0,0 +1,247 @@
+/*
+ *  cs104_ack_scheduler.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include "cs104_ack_scheduler.h"
+
+/* the smoothed values are not available before the first sample */
+#define ESTIMATION_UNKNOWN -1
+
+static void
+updateThreshold(CS104_AckScheduler self)
+{
+    if ((self->adaptive == false) || (self->interArrivalTime8 == ESTIMATION_UNKNOWN) ||
+        (self->roundTripTime8 == ESTIMATION_UNKNOWN))
+    {
+        self->threshold = self->w;
+        return;
+    }
+
+    int interArrivalTime8 = self->interArrivalTime8;
+
+    if (interArrivalTime8 < 1)
+        interArrivalTime8 = 1;
+
+    /* number of I messages the counterpart sends until an acknowledgement arrives */
+    int messagesInFlight = (self->roundTripTime8 + interArrivalTime8 - 1) / interArrivalTime8;
+
+    int threshold = self->k - messagesInFlight;
+
+    if (threshold > self->w)
+        threshold = self->w;
+
+    if (threshold < 1)
+        threshold = 1;
+
+    self->threshold = threshold;
+}
+
+static int
+getAckDelay(CS104_AckScheduler self)
+{
+    /* wait at most half a round trip time for an I message that can carry the acknowledgement */
+    int ackDelay = self->roundTripTime8 / 16;
+
+    if (ackDelay > (self->t2InMs / 4))
+        ackDelay = self->t2InMs / 4;
+
+    if (ackDelay < 1)
+        ackDelay = 1;
+
+    return ackDelay;
+}
+
+static void
+updateEstimation(int* estimation8, int sample)
+{
+    if (*estimation8 == ESTIMATION_UNKNOWN)
+        *estimation8 = sample * 8;
+    else
+        *estimation8 += sample - (*estimation8 / 8);
+}
+
+void
+CS104_AckScheduler_reset(CS104_AckScheduler self, CS104_APCIParameters parameters, bool adaptive)
+{
+    self->adaptive = adaptive;
+
+    self->k = parameters->k;
+    self->w = parameters->w;
+    self->t2InMs = parameters->t2 * 1000;
+
+    self->ackDeadline = 0;
+    self->ackPending = false;
+    self->lastIMessageTime = 0;
+    self->lastSentIMessageTime = 0;
+    self->interArrivalTime8 = ESTIMATION_UNKNOWN;
+    self->sendInterval8 = ESTIMATION_UNKNOWN;
+    self->roundTripTime8 = ESTIMATION_UNKNOWN;
+
+    updateThreshold(self);
+}
+
+void
+CS104_AckScheduler_iMessageReceived(CS104_AckScheduler self, uint64_t currentTime)
+{
+    if (self->adaptive == false)
+        return;
+
+    if ((self->lastIMessageTime != 0) && (currentTime >= self->lastIMessageTime))
+    {
+        uint64_t sample = currentTime - self->lastIMessageTime;
+
+        /* idle periods are handled by T2 - don't let them dominate the estimation */
+        if (sample > (uint64_t)self->t2InMs)
+            sample = (uint64_t)self->t2InMs;
+
+        updateEstimation(&(self->interArrivalTime8), (int)sample);
+
+        updateThreshold(self);
+    }
+
+    self->lastIMessageTime = currentTime;
+}
+
+void
+CS104_AckScheduler_updateRoundTripTime(CS104_AckScheduler self, uint64_t sentTime, uint64_t currentTime)
+{
+    if ((self->adaptive == false) || (currentTime < sentTime))
+        return;
+
+    uint64_t sample = currentTime - sentTime;
+
+    if (sample > (uint64_t)self->t2InMs)
+        sample = (uint64_t)self->t2InMs;
+
+    updateEstimation(&(self->roundTripTime8), (int)sample);
+
+    updateThreshold(self);
+}
+
+/* check if an own I message (that carries the acknowledgement) is expected until the deadline */
+static bool
+isIMessageExpected(CS104_AckScheduler self, uint64_t currentTime, uint64_t deadline)
+{
+    if ((self->lastSentIMessageTime == 0) || (self->sendInterval8 == ESTIMATION_UNKNOWN))
+        return false;
+
+    uint64_t sendInterval = (uint64_t)(self->sendInterval8 / 8);
+
+    uint64_t nextSendTime = self->lastSentIMessageTime + sendInterval;
+
+    /* an I message that is overdue by more than one interval is not expected anymore (sending stopped) */
+    if (nextSendTime + sendInterval < currentTime)
+        return false;
+
+    return (nextSendTime <= deadline);
+}
+
+bool
+CS104_AckScheduler_isAckRequired(CS104_AckScheduler self, int unconfirmed, bool iMessagePending, uint64_t currentTime)
+{
+    if (unconfirmed == 0)
+    {
+        self->ackDeadline = 0;
+        self->ackPending = false;
+        return false;
+    }
+
+    if (self->adaptive == false)
+        return (unconfirmed >= self->w);
+
+    if (unconfirmed < self->threshold)
+        return false;
+
+    /* an acknowledgement is due - it is sent by an S message or carried by an I message */
+    self->ackPending = true;
+
+    /* the pending I message confirms the received messages */
+    if (iMessagePending)
+        return false;
+
+    /* the counterpart cannot send more I messages */
+    if (unconfirmed >= self->k)
+        return true;
+
+    if (self->ackDeadline == 0)
+        self->ackDeadline = currentTime + getAckDelay(self);
+
+    if (currentTime >= self->ackDeadline)
+        return true;
+
+    /* at the limit w the S message is only held back when an I message is expected before the deadline */
+    if (unconfirmed >= self->w)
+        return (isIMessageExpected(self, currentTime, self->ackDeadline) == false);
+
+    return false;
+}
+
+int
+CS104_AckScheduler_getWaitTime(CS104_AckScheduler self, uint64_t currentTime, int maxWaitTime)
+{
+    if (self->ackDeadline == 0)
+        return maxWaitTime;
+
+    if (currentTime >= self->ackDeadline)
+        return 0;
+
+    uint64_t waitTime = self->ackDeadline - currentTime;
+
+    if (waitTime < (uint64_t)maxWaitTime)
+        return (int)waitTime;
+    else
+        return maxWaitTime;
+}
+
+void
+CS104_AckScheduler_ackSent(CS104_AckScheduler self)
+{
+    self->sentAcks++;
+    self->ackDeadline = 0;
+    self->ackPending = false;
+}
+
+void
+CS104_AckScheduler_iMessageSent(CS104_AckScheduler self, int unconfirmed, uint64_t currentTime)
+{
+    /* an S message was pending but the I message carried the acknowledgement */
+    if ((unconfirmed > 0) && self->ackPending)
+        self->savedAcks++;
+
+    self->ackDeadline = 0;
+    self->ackPending = false;
+
+    if (self->adaptive == false)
+        return;
+
+    if ((self->lastSentIMessageTime != 0) && (currentTime >= self->lastSentIMessageTime))
+    {
+        uint64_t sample = currentTime - self->lastSentIMessageTime;
+
+        if (sample > (uint64_t)self->t2InMs)
+            sample = (uint64_t)self->t2InMs;
+
+        updateEstimation(&(self->sendInterval8), (int)sample);
+    }
+
+    self->lastSentIMessageTime = currentTime;
+}
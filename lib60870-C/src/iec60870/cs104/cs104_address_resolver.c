@@ -0,0 +1,251 @@
+/*
+ *  cs104_address_resolver.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cs104_address_resolver.h"
+#include "hal_thread.h"
+#include "hal_time.h"
+#include "lib60870_config.h"
+#include "lib60870_internal.h"
+#include "lib_memory.h"
+
+#ifndef HOST_NAME_MAX
+#define HOST_NAME_MAX 64
+#endif
+
+struct sCS104_AddressLookup
+{
+    char hostname[HOST_NAME_MAX + 1];
+
+    char addresses[CONFIG_CS104_MAX_RESOLVED_ADDRESSES][SOCKET_MAX_ADDRESS_STRING_LENGTH];
+    int addressCount;
+
+    CS104_AddressLookupState state;
+    uint64_t expirationTime; /* resolved addresses are reused until this time */
+
+    /* the lookup is shared by the caller and the resolver thread */
+    int refCount;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore lock;
+    Semaphore done; /* signalled by the resolver thread when the lookup has finished */
+#endif
+};
+
+static void
+releaseLookup(CS104_AddressLookup self)
+{
+    int refCount;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    self->refCount--;
+    refCount = self->refCount;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    if (refCount == 0)
+    {
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_destroy(self->lock);
+        Semaphore_destroy(self->done);
+#endif
+
+        GLOBAL_FREEMEM(self);
+    }
+}
+
+static void
+resolveHostname(CS104_AddressLookup self)
+{
+    char addresses[CONFIG_CS104_MAX_RESOLVED_ADDRESSES][SOCKET_MAX_ADDRESS_STRING_LENGTH];
+
+    int addressCount = Socket_resolveHostname(self->hostname, false, addresses, CONFIG_CS104_MAX_RESOLVED_ADDRESSES);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    if (addressCount > 0)
+    {
+        memcpy(self->addresses, addresses, sizeof(self->addresses));
+        self->addressCount = addressCount;
+        self->expirationTime = Hal_getMonotonicTimeInMs() + CONFIG_CS104_RESOLVER_CACHE_TTL;
+        self->state = CS104_ADDRESS_LOOKUP_DONE;
+    }
+    else
+    {
+        DEBUG_PRINT("Failed to resolve hostname %s\n", self->hostname);
+
+        self->state = CS104_ADDRESS_LOOKUP_FAILED;
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+
+    Semaphore_post(self->done);
+#endif
+}
+
+#if (CONFIG_USE_THREADS == 1)
+static void*
+resolverThread(void* parameter)
+{
+    CS104_AddressLookup self = (CS104_AddressLookup)parameter;
+
+    resolveHostname(self);
+
+    releaseLookup(self);
+
+    return NULL;
+}
+#endif /* (CONFIG_USE_THREADS == 1) */
+
+CS104_AddressLookup
+CS104_AddressLookup_create(const char* hostname)
+{
+    CS104_AddressLookup self = (CS104_AddressLookup)GLOBAL_CALLOC(1, sizeof(struct sCS104_AddressLookup));
+
+    if (self)
+    {
+        strncpy(self->hostname, hostname, HOST_NAME_MAX);
+
+        self->refCount = 1;
+        self->state = CS104_ADDRESS_LOOKUP_PENDING;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        self->lock = Semaphore_create(1);
+        self->done = Semaphore_create(0);
+#endif
+
+        /* numeric addresses don't require a name lookup */
+        int addressCount =
+            Socket_resolveHostname(hostname, true, self->addresses, CONFIG_CS104_MAX_RESOLVED_ADDRESSES);
+
+        if (addressCount > 0)
+        {
+            self->addressCount = addressCount;
+            self->expirationTime = UINT64_MAX; /* numeric addresses don't expire */
+            self->state = CS104_ADDRESS_LOOKUP_DONE;
+        }
+        else
+        {
+#if (CONFIG_USE_THREADS == 1)
+            Thread thread = Thread_create(resolverThread, (void*)self, true);
+
+            if (thread)
+            {
+                self->refCount++;
+                Thread_start(thread);
+            }
+            else
+                self->state = CS104_ADDRESS_LOOKUP_FAILED;
+#else
+            resolveHostname(self);
+#endif /* (CONFIG_USE_THREADS == 1) */
+        }
+    }
+
+    return self;
+}
+
+CS104_AddressLookupState
+CS104_AddressLookup_getState(CS104_AddressLookup self)
+{
+    CS104_AddressLookupState state;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    state = self->state;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return state;
+}
+
+CS104_AddressLookupState
+CS104_AddressLookup_waitForResult(CS104_AddressLookup self, int timeoutInMs)
+{
+    CS104_AddressLookupState state = CS104_AddressLookup_getState(self);
+
+    if (state == CS104_ADDRESS_LOOKUP_PENDING)
+    {
+#if (CONFIG_USE_SEMAPHORES == 1)
+        if (Semaphore_timedWait(self->done, timeoutInMs))
+            state = CS104_AddressLookup_getState(self);
+#else
+        Thread_sleep(timeoutInMs);
+
+        state = CS104_AddressLookup_getState(self);
+#endif
+    }
+
+    return state;
+}
+
+bool
+CS104_AddressLookup_isReusable(CS104_AddressLookup self)
+{
+    CS104_AddressLookupState state = CS104_AddressLookup_getState(self);
+
+    if (state == CS104_ADDRESS_LOOKUP_PENDING)
+        return true;
+
+    if (state == CS104_ADDRESS_LOOKUP_DONE)
+        return (Hal_getMonotonicTimeInMs() < self->expirationTime);
+
+    return false;
+}
+
+int
+CS104_AddressLookup_getAddressCount(CS104_AddressLookup self)
+{
+    return self->addressCount;
+}
+
+const char*
+CS104_AddressLookup_getAddress(CS104_AddressLookup self, int index)
+{
+    if ((index < 0) || (index >= self->addressCount))
+        return NULL;
+
+    return self->addresses[index];
+}
+
+void
+CS104_AddressLookup_destroy(CS104_AddressLookup self)
+{
+    if (self)
+        releaseLookup(self);
+}
@@ -31,6 +31,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "cs104_ack_scheduler.h"
+#include "cs104_address_resolver.h"
 #include "cs104_frame.h"
 #include "hal_socket.h"
 #include "hal_thread.h"
@@ -84,6 +86,8 @@ struct sCS104_Connection
     char hostname[HOST_NAME_MAX + 1];
     int tcpPort;
 
+    CS104_AddressLookup addressLookup; /* kept to reuse the resolved addresses for reconnects */
+
     char* localIpAddress;
     int localTcpPort;
 
@@ -96,6 +100,12 @@ struct sCS104_Connection
     int connectTimeoutInMs;
     uint8_t sMessage[6];
 
+    /* reconnect backoff */
+    int backoffMinDelayInMs; /* 0 -> backoff is disabled */
+    int backoffMaxDelayInMs;
+    int failedConnectAttempts;
+    uint64_t nextConnectAttemptTime;
+
     SentASDU* sentASDUs; /* the k-buffer */
     int maxSentASDUs;    /* maximum number of ASDU to be sent without confirmation - parameter k */
     int oldestSentASDU;  /* index of oldest entry in k-buffer */
@@ -110,6 +120,9 @@ struct sCS104_Connection
 
     int unconfirmedReceivedIMessages;
 
+    bool adaptiveAck;
+    struct sCS104_AckScheduler ackScheduler;
+
     /* timeout T2 handling */
     bool timeoutT2Trigger;
     uint64_t lastConfirmationTime;
@@ -128,6 +141,7 @@ struct sCS104_Connection
 
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore conStateLock;
+    Semaphore closeSignal; /* posted by CS104_Connection_close (wakes up the reconnect backoff) */
 #endif
 
 #if (CONFIG_CS104_SUPPORT_TLS == 1)
@@ -138,6 +152,10 @@ struct sCS104_Connection
     CS101_ASDUReceivedHandler receivedHandler;
     void* receivedHandlerParameter;
 
+    CS101_PointCache pointCache;
+
+    CS101_CommandFanOut commandFanOut;
+
     CS104_ConnectionHandler connectionHandler;
     void* connectionHandlerParameter;
 
@@ -208,7 +226,10 @@ sendIMessage(CS104_Connection self, Frame frame)
 
     self->sendCount = (self->sendCount + 1) % 32768;
 
-    self->unconfirmedReceivedIMessages = false;
+    CS104_AckScheduler_iMessageSent(&(self->ackScheduler), self->unconfirmedReceivedIMessages,
+                                    Hal_getMonotonicTimeInMs());
+
+    self->unconfirmedReceivedIMessages = 0;
     self->timeoutT2Trigger = false;
 
     int sendCount = self->sendCount;
@@ -240,10 +261,18 @@ createConnection(const char* hostname, int tcpPort)
         self->rawMessageHandler = NULL;
         self->rawMessageHandlerParameter = NULL;
 
+        self->backoffMinDelayInMs = 0;
+        self->backoffMaxDelayInMs = 0;
+        self->failedConnectAttempts = 0;
+        self->nextConnectAttemptTime = 0;
+
 #if (CONFIG_USE_SEMAPHORES == 1)
         self->conStateLock = Semaphore_create(1);
+        self->closeSignal = Semaphore_create(0);
 #endif
 
+        self->addressLookup = NULL;
+
 #if (CONFIG_USE_THREADS == 1)
         self->connectionHandlingThread = NULL;
 #endif
@@ -307,9 +336,9 @@ resetConnection(CS104_Connection self)
     self->connectTimeoutInMs = self->parameters.t0 * 1000;
     self->recvBufPos = 0;
 
+    /* close flag is reset by CS104_Connection_connectAsync - a close request must not get lost here */
     self->running = false;
     self->failure = false;
-    self->close = false;
 
     self->receiveCount = 0;
     self->sendCount = 0;
@@ -318,6 +347,8 @@ resetConnection(CS104_Connection self)
     self->lastConfirmationTime = 0xffffffffffffffff;
     self->timeoutT2Trigger = false;
 
+    CS104_AckScheduler_reset(&(self->ackScheduler), &(self->parameters), self->adaptiveAck);
+
     self->oldestSentASDU = -1;
     self->newestSentASDU = -1;
 
@@ -400,6 +431,10 @@ checkSequenceNumber(CS104_Connection self, int seqNo)
                 {
                     /* we arrived at the seq# that has been confirmed */
 
+                    CS104_AckScheduler_updateRoundTripTime(&(self->ackScheduler),
+                                                           self->sentASDUs[self->oldestSentASDU].sentTime,
+                                                           Hal_getMonotonicTimeInMs());
+
                     if (self->oldestSentASDU == self->newestSentASDU)
                         self->oldestSentASDU = -1;
                     else
@@ -450,6 +485,8 @@ CS104_Connection_close(CS104_Connection self)
 
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_post(self->conStateLock);
+
+    Semaphore_post(self->closeSignal);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
 #if (CONFIG_USE_THREADS == 1)
@@ -469,8 +506,12 @@ CS104_Connection_destroy(CS104_Connection self)
     if (self->sentASDUs != NULL)
         GLOBAL_FREEMEM(self->sentASDUs);
 
+    if (self->addressLookup)
+        CS104_AddressLookup_destroy(self->addressLookup);
+
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_destroy(self->conStateLock);
+    Semaphore_destroy(self->closeSignal);
 #endif
 
     if (self->localIpAddress)
@@ -533,6 +574,51 @@ CS104_Connection_getAPCIParameters(CS104_Connection self)
     return &(self->parameters);
 }
 
+void
+CS104_Connection_setReconnectBackoff(CS104_Connection self, int minDelayInMs, int maxDelayInMs)
+{
+    if (maxDelayInMs < minDelayInMs)
+        maxDelayInMs = minDelayInMs;
+
+    self->backoffMinDelayInMs = minDelayInMs;
+    self->backoffMaxDelayInMs = maxDelayInMs;
+    self->failedConnectAttempts = 0;
+    self->nextConnectAttemptTime = 0;
+}
+
+void
+CS104_Connection_setPointCache(CS104_Connection self, CS101_PointCache pointCache)
+{
+    self->pointCache = pointCache;
+}
+
+void
+CS104_Connection_setCommandFanOut(CS104_Connection self, CS101_CommandFanOut fanOut)
+{
+    self->commandFanOut = fanOut;
+}
+
+void
+CS104_Connection_setAdaptiveAck(CS104_Connection self, bool enabled)
+{
+    self->adaptiveAck = enabled;
+}
+
+void
+CS104_Connection_getAckStatistics(CS104_Connection self, CS104_AckStatistics statistics)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->conStateLock);
+#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+
+    statistics->sentAcks = self->ackScheduler.sentAcks;
+    statistics->savedAcks = self->ackScheduler.savedAcks;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->conStateLock);
+#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+}
+
 /**
  * \return number of bytes read, or -1 in case of an error
  */
@@ -644,6 +730,7 @@ confirmOutstandingMessages(CS104_Connection self)
     self->lastConfirmationTime = Hal_getMonotonicTimeInMs();
     self->unconfirmedReceivedIMessages = 0;
     self->timeoutT2Trigger = false;
+    CS104_AckScheduler_ackSent(&(self->ackScheduler));
     sendSMessage(self);
 }
 
@@ -693,6 +780,8 @@ checkMessage(CS104_Connection self, uint8_t* buffer, int msgSize)
         self->receiveCount = (self->receiveCount + 1) % 32768;
         self->unconfirmedReceivedIMessages++;
 
+        CS104_AckScheduler_iMessageReceived(&(self->ackScheduler), Hal_getMonotonicTimeInMs());
+
         struct sCS101_ASDU _asdu;
 
         CS101_ASDU asdu = CS101_ASDU_createFromBufferEx(&_asdu, (CS101_AppLayerParameters) & (self->alParameters),
@@ -700,6 +789,12 @@ checkMessage(CS104_Connection self, uint8_t* buffer, int msgSize)
 
         if (asdu)
         {
+            if (self->pointCache)
+                CS101_PointCache_update(self->pointCache, asdu);
+
+            if (self->commandFanOut)
+                CS101_CommandFanOut_handleASDU(self->commandFanOut, self, -1, asdu);
+
             if (self->receivedHandler != NULL)
                 self->receivedHandler(self->receivedHandlerParameter, -1, asdu);
         }
@@ -714,6 +809,8 @@ checkMessage(CS104_Connection self, uint8_t* buffer, int msgSize)
     {
         DEBUG_PRINT("Received U frame\n");
 
+        uint64_t uMessageTimeout = self->uMessageTimeout;
+
         self->uMessageTimeout = 0;
 
         if (buffer[2] == 0x43)
@@ -725,6 +822,14 @@ checkMessage(CS104_Connection self, uint8_t* buffer, int msgSize)
         else if (buffer[2] == 0x83)
         { /* TESTFR_CON */
             DEBUG_PRINT("Rcvd TESTFR_CON\n");
+
+            if (uMessageTimeout != 0)
+            {
+                CS104_AckScheduler_updateRoundTripTime(&(self->ackScheduler),
+                                                       uMessageTimeout - (self->parameters.t1 * 1000),
+                                                       Hal_getMonotonicTimeInMs());
+            }
+
             self->outstandingTestFCConMessages = 0;
         }
         else if (buffer[2] == 0x07)
@@ -805,7 +910,9 @@ handleTimeouts(CS104_Connection self)
 
     if (self->unconfirmedReceivedIMessages > 0)
     {
-        if (checkConfirmTimeout(self, currentTime))
+        if (checkConfirmTimeout(self, currentTime) ||
+            CS104_AckScheduler_isAckRequired(&(self->ackScheduler), self->unconfirmedReceivedIMessages, false,
+                                             currentTime))
         {
             confirmOutstandingMessages(self);
         }
@@ -899,6 +1006,232 @@ isClose(CS104_Connection self)
 }
 
 #if (CONFIG_USE_THREADS == 1)
+static void
+updateReconnectBackoff(CS104_Connection self, bool connected)
+{
+    if (connected || (self->backoffMinDelayInMs <= 0))
+    {
+        self->failedConnectAttempts = 0;
+        self->nextConnectAttemptTime = 0;
+    }
+    else
+    {
+        int delay = self->backoffMinDelayInMs;
+        int i;
+
+        for (i = 0; (i < self->failedConnectAttempts) && (delay < self->backoffMaxDelayInMs); i++)
+            delay = delay * 2;
+
+        if (delay > self->backoffMaxDelayInMs)
+            delay = self->backoffMaxDelayInMs;
+
+        /* add up to 25% jitter so that reconnects of many connections are not synchronized */
+        delay += (int)((Hal_getMonotonicTimeInNs() / 1000) % (uint64_t)(delay / 4 + 1));
+
+        self->failedConnectAttempts++;
+        self->nextConnectAttemptTime = Hal_getMonotonicTimeInMs() + delay;
+    }
+}
+
+/**
+ * \return false when the connection was closed while waiting
+ */
+static bool
+waitForReconnectBackoff(CS104_Connection self)
+{
+    uint64_t currentTime;
+
+    while ((currentTime = Hal_getMonotonicTimeInMs()) < self->nextConnectAttemptTime)
+    {
+        if (isClose(self))
+            return false;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        /* signals of earlier close requests only cause another check of the close flag */
+        Semaphore_timedWait(self->closeSignal, (int)(self->nextConnectAttemptTime - currentTime));
+#else
+        Thread_sleep(10);
+#endif
+    }
+
+    return true;
+}
+
+/* maximum time (in ms) to wait for the name lookup or a connection attempt before checking the close flag */
+#define CONNECT_WAIT_INTERVAL 100
+
+static int
+getConnectWaitTime(uint64_t currentTime, uint64_t wakeupTime)
+{
+    if (wakeupTime <= currentTime)
+        return 0;
+
+    if (wakeupTime - currentTime > CONNECT_WAIT_INTERVAL)
+        return CONNECT_WAIT_INTERVAL;
+
+    return (int)(wakeupTime - currentTime);
+}
+
+static Socket
+startConnectAttempt(CS104_Connection self, const char* address)
+{
+    Socket socket = TcpSocket_create();
+
+    if (socket)
+    {
+        if (self->localIpAddress)
+        {
+            Socket_bind(socket, self->localIpAddress, self->localTcpPort);
+        }
+
+        if (Socket_connectAsync(socket, address, self->tcpPort) == false)
+        {
+            Socket_destroy(socket);
+            socket = NULL;
+        }
+    }
+
+    return socket;
+}
+
+/**
+ * \brief Resolve the server address and connect to the first address that accepts the connection
+ *
+ * Connection attempts to the resolved addresses (IPv6 and IPv4 interleaved) are started with a
+ * delay of CONFIG_CS104_CONNECTION_ATTEMPT_DELAY ms or as soon as the previous attempt failed (RFC 8305).
+ * The name lookup and the connection attempts are aborted when T0 elapsed or the connection is closed.
+ * An aborted name lookup is continued by the next call.
+ *
+ * \return the connected socket or NULL when no connection could be established
+ */
+static Socket
+connectToServer(CS104_Connection self)
+{
+    Socket connectedSocket = NULL;
+    Socket pendingSockets[CONFIG_CS104_MAX_RESOLVED_ADDRESSES];
+
+    uint64_t deadline = Hal_getMonotonicTimeInMs() + self->connectTimeoutInMs;
+
+    if (self->addressLookup && (CS104_AddressLookup_isReusable(self->addressLookup) == false))
+    {
+        CS104_AddressLookup_destroy(self->addressLookup);
+        self->addressLookup = NULL;
+    }
+
+    if (self->addressLookup == NULL)
+        self->addressLookup = CS104_AddressLookup_create(self->hostname);
+
+    CS104_AddressLookup lookup = self->addressLookup;
+
+    if (lookup == NULL)
+        return NULL;
+
+    CS104_AddressLookupState lookupState;
+
+    while ((lookupState = CS104_AddressLookup_getState(lookup)) == CS104_ADDRESS_LOOKUP_PENDING)
+    {
+        uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+        if (isClose(self) || (currentTime > deadline))
+            break;
+
+        CS104_AddressLookup_waitForResult(lookup, getConnectWaitTime(currentTime, deadline));
+    }
+
+    if (lookupState == CS104_ADDRESS_LOOKUP_DONE)
+    {
+        int addressCount = CS104_AddressLookup_getAddressCount(lookup);
+        int nextAddress = 0;
+        uint64_t nextAttemptTime = 0;
+        int i;
+
+        for (i = 0; i < CONFIG_CS104_MAX_RESOLVED_ADDRESSES; i++)
+            pendingSockets[i] = NULL;
+
+        while (connectedSocket == NULL)
+        {
+            uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+            if ((currentTime > deadline) || isClose(self))
+                break;
+
+            if ((nextAddress < addressCount) && (currentTime >= nextAttemptTime))
+            {
+                const char* address = CS104_AddressLookup_getAddress(lookup, nextAddress);
+
+                DEBUG_PRINT("Connecting to %s:%i\n", address, self->tcpPort);
+
+                pendingSockets[nextAddress] = startConnectAttempt(self, address);
+                nextAddress++;
+
+                nextAttemptTime = currentTime + CONFIG_CS104_CONNECTION_ATTEMPT_DELAY;
+            }
+
+            int pendingAttempts = 0;
+
+            for (i = 0; i < nextAddress; i++)
+            {
+                if (pendingSockets[i])
+                {
+                    SocketState state = Socket_checkAsyncConnectState(pendingSockets[i]);
+
+                    if (state == SOCKET_STATE_CONNECTED)
+                    {
+                        connectedSocket = pendingSockets[i];
+                        pendingSockets[i] = NULL;
+                        break;
+                    }
+                    else if (state == SOCKET_STATE_FAILED)
+                    {
+                        Socket_destroy(pendingSockets[i]);
+                        pendingSockets[i] = NULL;
+                    }
+                    else
+                        pendingAttempts++;
+                }
+            }
+
+            if (connectedSocket == NULL)
+            {
+                if (pendingAttempts == 0)
+                {
+                    if (nextAddress >= addressCount)
+                        break; /* all addresses failed */
+
+                    /* no attempt pending -> try next address immediately */
+                    nextAttemptTime = 0;
+                }
+                else
+                {
+                    uint64_t wakeupTime = deadline;
+
+                    if ((nextAddress < addressCount) && (nextAttemptTime < wakeupTime))
+                        wakeupTime = nextAttemptTime;
+
+                    Socket_waitAsyncConnect(pendingSockets, nextAddress,
+                                            getConnectWaitTime(Hal_getMonotonicTimeInMs(), wakeupTime));
+                }
+            }
+        }
+
+        /* abort the attempts that lost the race */
+        for (i = 0; i < nextAddress; i++)
+        {
+            if (pendingSockets[i])
+                Socket_destroy(pendingSockets[i]);
+        }
+
+        /* the server might have moved -> resolve the hostname again with the next attempt */
+        if ((connectedSocket == NULL) && (nextAddress >= addressCount))
+        {
+            CS104_AddressLookup_destroy(self->addressLookup);
+            self->addressLookup = NULL;
+        }
+    }
+
+    return connectedSocket;
+}
+
 static void*
 handleConnection(void* parameter)
 {
@@ -908,166 +1241,160 @@ handleConnection(void* parameter)
 
     resetConnection(self);
 
-    self->socket = TcpSocket_create();
+    if (waitForReconnectBackoff(self))
+        self->socket = connectToServer(self);
+    else
+        self->socket = NULL;
+
+    updateReconnectBackoff(self, (self->socket != NULL));
 
     if (self->socket)
     {
-        Socket_setConnectTimeout(self->socket, self->connectTimeoutInMs);
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_wait(self->conStateLock);
+#endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-        if (self->localIpAddress)
+#if (CONFIG_CS104_SUPPORT_TLS == 1)
+        if (self->tlsConfig != NULL)
         {
-            Socket_bind(self->socket, self->localIpAddress, self->localTcpPort);
+            self->tlsSocket = TLSSocket_create(self->socket, self->tlsConfig, false);
+
+            if (self->tlsSocket)
+                self->running = true;
+            else
+                self->failure = true;
         }
+        else
+            self->running = true;
+#else
+        self->running = true;
+#endif
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_post(self->conStateLock);
+#endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-        if (Socket_connect(self->socket, self->hostname, self->tcpPort))
+        if (isRunning(self))
         {
 #if (CONFIG_USE_SEMAPHORES == 1)
             Semaphore_wait(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-#if (CONFIG_CS104_SUPPORT_TLS == 1)
-            if (self->tlsConfig != NULL)
-            {
-                self->tlsSocket = TLSSocket_create(self->socket, self->tlsConfig, false);
-
-                if (self->tlsSocket)
-                    self->running = true;
-                else
-                    self->failure = true;
-            }
-            else
-                self->running = true;
-#else
-            self->running = true;
-#endif
+            self->conState = STATE_INACTIVE;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
             Semaphore_post(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-            if (isRunning(self))
+            /* Call connection handler */
+            if (self->connectionHandler)
+                self->connectionHandler(self->connectionHandlerParameter, self, CS104_CONNECTION_OPENED);
+
+            HandleSet handleSet = Handleset_new();
+
+            bool loopRunning = true;
+
+            while (loopRunning)
             {
+                Handleset_reset(handleSet);
+                Handleset_addSocket(handleSet, self->socket);
+
 #if (CONFIG_USE_SEMAPHORES == 1)
                 Semaphore_wait(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-                self->conState = STATE_INACTIVE;
+                /* wake up in time for a deferred acknowledgement */
+                int waitTime =
+                    CS104_AckScheduler_getWaitTime(&(self->ackScheduler), Hal_getMonotonicTimeInMs(), 100);
 
 #if (CONFIG_USE_SEMAPHORES == 1)
                 Semaphore_post(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-                /* Call connection handler */
-                if (self->connectionHandler)
-                    self->connectionHandler(self->connectionHandlerParameter, self, CS104_CONNECTION_OPENED);
-
-                HandleSet handleSet = Handleset_new();
-
-                bool loopRunning = true;
-
-                while (loopRunning)
+                if (Handleset_waitReady(handleSet, waitTime))
                 {
-                    Handleset_reset(handleSet);
-                    Handleset_addSocket(handleSet, self->socket);
+                    int bytesRec = receiveMessage(self);
 
-                    if (Handleset_waitReady(handleSet, 100))
+                    if (bytesRec == -1)
                     {
-                        int bytesRec = receiveMessage(self);
-
-                        if (bytesRec == -1)
-                        {
-                            loopRunning = false;
+                        loopRunning = false;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-                            Semaphore_wait(self->conStateLock);
+                        Semaphore_wait(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-                            self->failure = true;
+                        self->failure = true;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-                            Semaphore_post(self->conStateLock);
+                        Semaphore_post(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
-                        }
+                    }
 
-                        if (bytesRec > 0)
-                        {
-                            if (self->rawMessageHandler)
-                                self->rawMessageHandler(self->rawMessageHandlerParameter, self->recvBuffer, bytesRec,
-                                                        false);
+                    if (bytesRec > 0)
+                    {
+                        if (self->rawMessageHandler)
+                            self->rawMessageHandler(self->rawMessageHandlerParameter, self->recvBuffer, bytesRec,
+                                                    false);
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-                            Semaphore_wait(self->conStateLock);
+                        Semaphore_wait(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-                            CS104_ConState oldState = self->conState;
+                        CS104_ConState oldState = self->conState;
 
-                            if (checkMessage(self, self->recvBuffer, bytesRec) == false)
-                            {
-                                /* close connection on error */
-                                loopRunning = false;
+                        if (checkMessage(self, self->recvBuffer, bytesRec) == false)
+                        {
+                            /* close connection on error */
+                            loopRunning = false;
 
-                                self->failure = true;
-                            }
+                            self->failure = true;
+                        }
 
-                            CS104_ConState newState = self->conState;
+                        CS104_ConState newState = self->conState;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-                            Semaphore_post(self->conStateLock);
+                        Semaphore_post(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-                            /* call connection handler when required */
-                            if ((newState != oldState) && self->connectionHandler)
-                            {
-                                if (newState == STATE_ACTIVE)
-                                    self->connectionHandler(self->connectionHandlerParameter, self,
-                                                            CS104_CONNECTION_STARTDT_CON_RECEIVED);
-                                else if (newState == STATE_INACTIVE)
-                                    self->connectionHandler(self->connectionHandlerParameter, self,
-                                                            CS104_CONNECTION_STOPDT_CON_RECEIVED);
-                            }
+                        /* call connection handler when required */
+                        if ((newState != oldState) && self->connectionHandler)
+                        {
+                            if (newState == STATE_ACTIVE)
+                                self->connectionHandler(self->connectionHandlerParameter, self,
+                                                        CS104_CONNECTION_STARTDT_CON_RECEIVED);
+                            else if (newState == STATE_INACTIVE)
+                                self->connectionHandler(self->connectionHandlerParameter, self,
+                                                        CS104_CONNECTION_STOPDT_CON_RECEIVED);
                         }
+                    }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-                        Semaphore_wait(self->conStateLock);
+                    Semaphore_wait(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-                        if ((self->unconfirmedReceivedIMessages >= self->parameters.w) ||
-                            (self->conState == STATE_WAITING_FOR_STOPDT_CON))
-                        {
-                            confirmOutstandingMessages(self);
-                        }
+                    if (CS104_AckScheduler_isAckRequired(&(self->ackScheduler), self->unconfirmedReceivedIMessages,
+                                                         false, Hal_getMonotonicTimeInMs()) ||
+                        (self->conState == STATE_WAITING_FOR_STOPDT_CON))
+                    {
+                        confirmOutstandingMessages(self);
+                    }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-                        Semaphore_post(self->conStateLock);
+                    Semaphore_post(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
-                    }
-
-                    if (handleTimeouts(self) == false)
-                        loopRunning = false;
-
-                    if (isClose(self))
-                        loopRunning = false;
                 }
 
-                Handleset_destroy(handleSet);
+                if (handleTimeouts(self) == false)
+                    loopRunning = false;
 
-                /* register CLOSED event */
-                event = CS104_CONNECTION_CLOSED;
+                if (isClose(self))
+                    loopRunning = false;
             }
-        }
-        else
-        {
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_wait(self->conStateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
-            self->failure = true;
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_post(self->conStateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+            Handleset_destroy(handleSet);
 
             /* register CLOSED event */
-            event = CS104_CONNECTION_FAILED;
+            event = CS104_CONNECTION_CLOSED;
         }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
@@ -1101,17 +1428,20 @@ handleConnection(void* parameter)
     }
     else
     {
-        DEBUG_PRINT("Failed to create socket\n");
+        DEBUG_PRINT("Failed to connect to %s:%i\n", self->hostname, self->tcpPort);
 
 #if (CONFIG_USE_SEMAPHORES == 1)
         Semaphore_wait(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
         self->running = false;
+        self->failure = true;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
         Semaphore_post(self->conStateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
+
+        event = CS104_CONNECTION_FAILED;
     }
 
     /* Call connection handler */
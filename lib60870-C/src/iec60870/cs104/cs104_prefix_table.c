@@ -0,0 +1,180 @@
+/*
+ *  cs104_prefix_table.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include "cs104_prefix_table.h"
+#include "lib_memory.h"
+
+#define PREFIX_TABLE_NO_NODE -1
+
+typedef struct sPrefixTableNode* PrefixTableNode;
+
+struct sPrefixTableNode
+{
+    int32_t child[2]; /* index of the child node for the next bit (0/1) or PREFIX_TABLE_NO_NODE */
+    void* value;      /* value of the prefix that ends at this node or NULL */
+};
+
+struct sCS104_PrefixTable
+{
+    /* all nodes are stored in one array - children are referenced by index */
+    PrefixTableNode nodes;
+    int numberOfNodes;
+    int maxNumberOfNodes;
+
+    int32_t ipv4Root;
+    int32_t ipv6Root;
+};
+
+static int32_t
+allocateNode(CS104_PrefixTable self)
+{
+    if (self->numberOfNodes == self->maxNumberOfNodes)
+    {
+        int newMaxNumberOfNodes = self->maxNumberOfNodes * 2;
+
+        PrefixTableNode newNodes = (PrefixTableNode)GLOBAL_REALLOC(self->nodes,
+                                                                   newMaxNumberOfNodes * sizeof(struct sPrefixTableNode));
+
+        if (newNodes == NULL)
+            return PREFIX_TABLE_NO_NODE;
+
+        self->nodes = newNodes;
+        self->maxNumberOfNodes = newMaxNumberOfNodes;
+    }
+
+    int32_t index = self->numberOfNodes++;
+
+    self->nodes[index].child[0] = PREFIX_TABLE_NO_NODE;
+    self->nodes[index].child[1] = PREFIX_TABLE_NO_NODE;
+    self->nodes[index].value = NULL;
+
+    return index;
+}
+
+CS104_PrefixTable
+CS104_PrefixTable_create(void)
+{
+    CS104_PrefixTable self = (CS104_PrefixTable)GLOBAL_MALLOC(sizeof(struct sCS104_PrefixTable));
+
+    if (self)
+    {
+        self->maxNumberOfNodes = 64;
+        self->numberOfNodes = 0;
+        self->nodes = (PrefixTableNode)GLOBAL_MALLOC(self->maxNumberOfNodes * sizeof(struct sPrefixTableNode));
+
+        if (self->nodes == NULL)
+        {
+            GLOBAL_FREEMEM(self);
+            return NULL;
+        }
+
+        self->ipv4Root = allocateNode(self);
+        self->ipv6Root = allocateNode(self);
+    }
+
+    return self;
+}
+
+void
+CS104_PrefixTable_destroy(CS104_PrefixTable self)
+{
+    if (self)
+    {
+        GLOBAL_FREEMEM(self->nodes);
+        GLOBAL_FREEMEM(self);
+    }
+}
+
+static int
+getBit(const uint8_t* address, int bitIndex)
+{
+    return (address[bitIndex / 8] >> (7 - (bitIndex % 8))) & 1;
+}
+
+bool
+CS104_PrefixTable_add(CS104_PrefixTable self, const uint8_t* address, int addressSize, int prefixLength, void* value)
+{
+    if ((addressSize != 4) && (addressSize != 16))
+        return false;
+
+    if ((prefixLength < 0) || (prefixLength > addressSize * 8) || (value == NULL))
+        return false;
+
+    int32_t node = (addressSize == 4) ? self->ipv4Root : self->ipv6Root;
+
+    int i;
+
+    for (i = 0; i < prefixLength; i++)
+    {
+        int bit = getBit(address, i);
+
+        int32_t child = self->nodes[node].child[bit];
+
+        if (child == PREFIX_TABLE_NO_NODE)
+        {
+            /* can move the node array */
+            child = allocateNode(self);
+
+            if (child == PREFIX_TABLE_NO_NODE)
+                return false;
+
+            self->nodes[node].child[bit] = child;
+        }
+
+        node = child;
+    }
+
+    if (self->nodes[node].value == NULL)
+        self->nodes[node].value = value;
+
+    return true;
+}
+
+void*
+CS104_PrefixTable_lookup(CS104_PrefixTable self, const uint8_t* address, int addressSize)
+{
+    if ((addressSize != 4) && (addressSize != 16))
+        return NULL;
+
+    int32_t node = (addressSize == 4) ? self->ipv4Root : self->ipv6Root;
+
+    void* value = self->nodes[node].value;
+
+    int numberOfBits = addressSize * 8;
+
+    int i;
+
+    for (i = 0; i < numberOfBits; i++)
+    {
+        node = self->nodes[node].child[getBit(address, i)];
+
+        if (node == PREFIX_TABLE_NO_NODE)
+            break;
+
+        if (self->nodes[node].value)
+            value = self->nodes[node].value;
+    }
+
+    return value;
+}
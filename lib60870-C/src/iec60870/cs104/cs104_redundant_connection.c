@@ -0,0 +1,651 @@
+/*
+ *  cs104_redundant_connection.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cs104_redundant_connection.h"
+
+#include "hal_thread.h"
+#include "hal_time.h"
+#include "lib_memory.h"
+
+#include "cs101_asdu_internal.h"
+#include "lib60870_internal.h"
+
+/* number of received events that are remembered for duplicate detection */
+#define EVENT_HISTORY_SIZE 128
+
+typedef enum
+{
+    PATH_STATE_IDLE = 0,
+    PATH_STATE_CONNECTING = 1,
+    PATH_STATE_STANDBY = 2,
+    PATH_STATE_ACTIVATING = 3,
+    PATH_STATE_ACTIVE = 4
+} RedundantPathState;
+
+typedef struct sRedundantPath* RedundantPath;
+
+struct sRedundantPath
+{
+    CS104_RedundantConnection parent;
+    int index;
+
+    CS104_Connection connection;
+    RedundantPathState state;
+
+    uint64_t nextConnectTime;
+};
+
+struct sCS104_RedundantConnection
+{
+    struct sRedundantPath paths[CONFIG_CS104_REDUNDANT_CONNECTION_MAX_PATHS];
+    int numberOfPaths;
+
+    int activePath; /* -1 -> no active path */
+    bool hadActivePath; /* true -> next activation is a switchover */
+
+    bool interrogationOnSwitchover;
+    int interrogationCa;
+
+    int reconnectInterval;
+
+    /* duplicate detection */
+    int duplicateDetectionTime;
+    uint64_t duplicateDetectionEnd;
+    uint32_t eventHistory[EVENT_HISTORY_SIZE]; /* events received on the active path */
+    int eventHistoryPos;
+    int eventHistoryCount;
+    uint32_t oldPathEvents[EVENT_HISTORY_SIZE]; /* event history of the old path (frozen at switchover) */
+    int oldPathEventsCount;
+    int discardedDuplicates;
+
+    CS101_ASDUReceivedHandler receivedHandler;
+    void* receivedHandlerParameter;
+
+    CS104_RedundantConnectionHandler connectionHandler;
+    void* connectionHandlerParameter;
+
+    bool running;
+
+#if (CONFIG_USE_THREADS == 1)
+    Thread supervisionThread;
+#endif
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore lock;
+#endif
+};
+
+static void
+lockConnection(CS104_RedundantConnection self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+}
+
+static void
+unlockConnection(CS104_RedundantConnection self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+}
+
+/* FNV-1a hash over the complete ASDU */
+static uint32_t
+getAsduHash(CS101_ASDU asdu)
+{
+    uint32_t hash = 2166136261u;
+    int length = asdu->asduHeaderLength + asdu->payloadSize;
+    int i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash ^= asdu->asdu[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static bool
+isEvent(CS101_ASDU asdu)
+{
+    CS101_CauseOfTransmission cot = CS101_ASDU_getCOT(asdu);
+
+    return ((cot == CS101_COT_SPONTANEOUS) || (cot == CS101_COT_RETURN_INFO_REMOTE) ||
+            (cot == CS101_COT_RETURN_INFO_LOCAL));
+}
+
+/* remove the event from the old path events - each old path event discards one repetition only */
+static bool
+takeFromOldPathEvents(CS104_RedundantConnection self, uint32_t hash)
+{
+    int i;
+
+    for (i = 0; i < self->oldPathEventsCount; i++)
+    {
+        if (self->oldPathEvents[i] == hash)
+        {
+            self->oldPathEventsCount--;
+            self->oldPathEvents[i] = self->oldPathEvents[self->oldPathEventsCount];
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+addToEventHistory(CS104_RedundantConnection self, uint32_t hash)
+{
+    self->eventHistory[self->eventHistoryPos] = hash;
+    self->eventHistoryPos = (self->eventHistoryPos + 1) % EVENT_HISTORY_SIZE;
+
+    if (self->eventHistoryCount < EVENT_HISTORY_SIZE)
+        self->eventHistoryCount++;
+}
+
+/* has to be called with lock - the history of the new path starts empty */
+static void
+freezeEventHistory(CS104_RedundantConnection self)
+{
+    memcpy(self->oldPathEvents, self->eventHistory, self->eventHistoryCount * sizeof(uint32_t));
+    self->oldPathEventsCount = self->eventHistoryCount;
+
+    self->eventHistoryPos = 0;
+    self->eventHistoryCount = 0;
+}
+
+/* has to be called with lock */
+static RedundantPath
+selectStandbyPath(CS104_RedundantConnection self)
+{
+    int i;
+
+    for (i = 0; i < self->numberOfPaths; i++)
+    {
+        RedundantPath path = &(self->paths[i]);
+
+        if ((path->state == PATH_STATE_ACTIVE) || (path->state == PATH_STATE_ACTIVATING))
+            return NULL;
+    }
+
+    for (i = 0; i < self->numberOfPaths; i++)
+    {
+        RedundantPath path = &(self->paths[i]);
+
+        if (path->state == PATH_STATE_STANDBY)
+        {
+            path->state = PATH_STATE_ACTIVATING;
+            return path;
+        }
+    }
+
+    return NULL;
+}
+
+static bool
+pathAsduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    RedundantPath path = (RedundantPath)parameter;
+    CS104_RedundantConnection self = path->parent;
+
+    bool deliver = false;
+
+    lockConnection(self);
+
+    if (self->activePath == path->index)
+    {
+        deliver = true;
+
+        if ((self->duplicateDetectionTime > 0) && isEvent(asdu))
+        {
+            uint32_t hash = getAsduHash(asdu);
+
+            /* only compared with the events of the old path - repeated events of the same path are delivered */
+            if ((Hal_getMonotonicTimeInMs() < self->duplicateDetectionEnd) && takeFromOldPathEvents(self, hash))
+            {
+                DEBUG_PRINT("REDUNDANT CONNECTION: discard duplicated event after switchover\n");
+
+                self->discardedDuplicates++;
+                deliver = false;
+            }
+            else
+                addToEventHistory(self, hash);
+        }
+    }
+
+    unlockConnection(self);
+
+    if (deliver && self->receivedHandler)
+        return self->receivedHandler(self->receivedHandlerParameter, address, asdu);
+
+    return true;
+}
+
+static void
+pathConnectionHandler(void* parameter, CS104_Connection connection, CS104_ConnectionEvent event)
+{
+    RedundantPath path = (RedundantPath)parameter;
+    CS104_RedundantConnection self = path->parent;
+
+    RedundantPath pathToStart = NULL;
+    bool sendInterrogation = false;
+    bool reportEvent = false;
+    bool noPathAvailable = false;
+    CS104_RedundantConnectionEvent pathEvent = CS104_REDUNDANT_CONNECTION_PATH_OPENED;
+
+    lockConnection(self);
+
+    switch (event)
+    {
+    case CS104_CONNECTION_OPENED:
+
+        path->state = PATH_STATE_STANDBY;
+
+        pathEvent = CS104_REDUNDANT_CONNECTION_PATH_OPENED;
+        reportEvent = true;
+
+        pathToStart = selectStandbyPath(self);
+
+        break;
+
+    case CS104_CONNECTION_STARTDT_CON_RECEIVED:
+
+        if (path->state == PATH_STATE_ACTIVATING)
+        {
+            path->state = PATH_STATE_ACTIVE;
+            self->activePath = path->index;
+
+            if (self->hadActivePath)
+            {
+                freezeEventHistory(self);
+
+                self->duplicateDetectionEnd = Hal_getMonotonicTimeInMs() + self->duplicateDetectionTime;
+                sendInterrogation = self->interrogationOnSwitchover;
+            }
+
+            self->hadActivePath = true;
+
+            pathEvent = CS104_REDUNDANT_CONNECTION_PATH_ACTIVATED;
+            reportEvent = true;
+        }
+
+        break;
+
+    case CS104_CONNECTION_STOPDT_CON_RECEIVED:
+
+        path->state = PATH_STATE_STANDBY;
+
+        if (self->activePath == path->index)
+            self->activePath = -1;
+
+        break;
+
+    case CS104_CONNECTION_CLOSED:
+    case CS104_CONNECTION_FAILED:
+        {
+            bool wasActive = ((path->state == PATH_STATE_ACTIVE) || (path->state == PATH_STATE_ACTIVATING));
+
+            /* failed reconnect attempts are not reported */
+            if (path->state != PATH_STATE_CONNECTING)
+            {
+                pathEvent = CS104_REDUNDANT_CONNECTION_PATH_CLOSED;
+                reportEvent = true;
+            }
+
+            path->state = PATH_STATE_IDLE;
+            path->nextConnectTime = Hal_getMonotonicTimeInMs() + self->reconnectInterval;
+
+            if (self->activePath == path->index)
+                self->activePath = -1;
+
+            if (wasActive && self->running)
+            {
+                pathToStart = selectStandbyPath(self);
+
+                if (pathToStart == NULL)
+                    noPathAvailable = true;
+            }
+        }
+        break;
+    }
+
+    unlockConnection(self);
+
+    /* connections are only accessed without holding the lock to avoid lock order problems */
+    if (pathToStart)
+    {
+        DEBUG_PRINT("REDUNDANT CONNECTION: start path %i\n", pathToStart->index);
+
+        CS104_Connection_sendStartDT(pathToStart->connection);
+    }
+
+    if (sendInterrogation)
+        CS104_Connection_sendInterrogationCommand(connection, CS101_COT_ACTIVATION, self->interrogationCa,
+                                                  IEC60870_QOI_STATION);
+
+    if (self->connectionHandler)
+    {
+        if (reportEvent)
+            self->connectionHandler(self->connectionHandlerParameter, self, path->index, pathEvent);
+
+        if (noPathAvailable)
+            self->connectionHandler(self->connectionHandlerParameter, self, path->index,
+                                    CS104_REDUNDANT_CONNECTION_NO_PATH_AVAILABLE);
+    }
+}
+
+#if (CONFIG_USE_THREADS == 1)
+static void*
+handleSupervision(void* parameter)
+{
+    CS104_RedundantConnection self = (CS104_RedundantConnection)parameter;
+
+    RedundantPath pathsToConnect[CONFIG_CS104_REDUNDANT_CONNECTION_MAX_PATHS];
+
+    while (true)
+    {
+        int numberOfPathsToConnect = 0;
+        RedundantPath pathToStart = NULL;
+
+        lockConnection(self);
+
+        if (self->running == false)
+        {
+            unlockConnection(self);
+            break;
+        }
+
+        uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+        int i;
+
+        for (i = 0; i < self->numberOfPaths; i++)
+        {
+            RedundantPath path = &(self->paths[i]);
+
+            if ((path->state == PATH_STATE_IDLE) && (currentTime >= path->nextConnectTime))
+            {
+                path->state = PATH_STATE_CONNECTING;
+                pathsToConnect[numberOfPathsToConnect++] = path;
+            }
+        }
+
+        pathToStart = selectStandbyPath(self);
+
+        unlockConnection(self);
+
+        for (i = 0; i < numberOfPathsToConnect; i++)
+            CS104_Connection_connectAsync(pathsToConnect[i]->connection);
+
+        if (pathToStart)
+            CS104_Connection_sendStartDT(pathToStart->connection);
+
+        Thread_sleep(10);
+    }
+
+    return NULL;
+}
+#endif /* (CONFIG_USE_THREADS == 1) */
+
+CS104_RedundantConnection
+CS104_RedundantConnection_create(void)
+{
+    CS104_RedundantConnection self =
+        (CS104_RedundantConnection)GLOBAL_CALLOC(1, sizeof(struct sCS104_RedundantConnection));
+
+    if (self)
+    {
+        self->numberOfPaths = 0;
+        self->activePath = -1;
+        self->hadActivePath = false;
+
+        self->interrogationOnSwitchover = false;
+        self->interrogationCa = 1;
+
+        self->reconnectInterval = 1000;
+        self->duplicateDetectionTime = 5000;
+
+        self->running = false;
+
+#if (CONFIG_USE_THREADS == 1)
+        self->supervisionThread = NULL;
+#endif
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        self->lock = Semaphore_create(1);
+#endif
+    }
+
+    return self;
+}
+
+int
+CS104_RedundantConnection_addPath(CS104_RedundantConnection self, const char* hostname, int tcpPort)
+{
+    if (self->numberOfPaths >= CONFIG_CS104_REDUNDANT_CONNECTION_MAX_PATHS)
+        return -1;
+
+    CS104_Connection connection = CS104_Connection_create(hostname, tcpPort);
+
+    if (connection == NULL)
+        return -1;
+
+    int index = self->numberOfPaths;
+
+    RedundantPath path = &(self->paths[index]);
+
+    path->parent = self;
+    path->index = index;
+    path->connection = connection;
+    path->state = PATH_STATE_IDLE;
+    path->nextConnectTime = 0;
+
+    CS104_Connection_setASDUReceivedHandler(connection, pathAsduReceivedHandler, path);
+    CS104_Connection_setConnectionHandler(connection, pathConnectionHandler, path);
+
+    self->numberOfPaths++;
+
+    return index;
+}
+
+CS104_Connection
+CS104_RedundantConnection_getPathConnection(CS104_RedundantConnection self, int pathIndex)
+{
+    if ((pathIndex < 0) || (pathIndex >= self->numberOfPaths))
+        return NULL;
+
+    return self->paths[pathIndex].connection;
+}
+
+void
+CS104_RedundantConnection_setInterrogationOnSwitchover(CS104_RedundantConnection self, bool enabled, int ca)
+{
+    self->interrogationOnSwitchover = enabled;
+    self->interrogationCa = ca;
+}
+
+void
+CS104_RedundantConnection_setDuplicateDetectionTime(CS104_RedundantConnection self, int timeInMs)
+{
+    self->duplicateDetectionTime = timeInMs;
+}
+
+void
+CS104_RedundantConnection_setReconnectInterval(CS104_RedundantConnection self, int intervalInMs)
+{
+    self->reconnectInterval = intervalInMs;
+}
+
+void
+CS104_RedundantConnection_setASDUReceivedHandler(CS104_RedundantConnection self, CS101_ASDUReceivedHandler handler,
+                                                 void* parameter)
+{
+    self->receivedHandler = handler;
+    self->receivedHandlerParameter = parameter;
+}
+
+void
+CS104_RedundantConnection_setConnectionHandler(CS104_RedundantConnection self, CS104_RedundantConnectionHandler handler,
+                                               void* parameter)
+{
+    self->connectionHandler = handler;
+    self->connectionHandlerParameter = parameter;
+}
+
+void
+CS104_RedundantConnection_start(CS104_RedundantConnection self)
+{
+    lockConnection(self);
+
+    if (self->running)
+    {
+        unlockConnection(self);
+        return;
+    }
+
+    self->running = true;
+
+    int i;
+
+    for (i = 0; i < self->numberOfPaths; i++)
+    {
+        self->paths[i].state = PATH_STATE_IDLE;
+        self->paths[i].nextConnectTime = 0;
+    }
+
+    unlockConnection(self);
+
+#if (CONFIG_USE_THREADS == 1)
+    self->supervisionThread = Thread_create(handleSupervision, (void*)self, false);
+
+    if (self->supervisionThread)
+        Thread_start(self->supervisionThread);
+#endif
+}
+
+void
+CS104_RedundantConnection_stop(CS104_RedundantConnection self)
+{
+    lockConnection(self);
+
+    self->running = false;
+
+    unlockConnection(self);
+
+#if (CONFIG_USE_THREADS == 1)
+    if (self->supervisionThread)
+    {
+        Thread_destroy(self->supervisionThread);
+        self->supervisionThread = NULL;
+    }
+#endif
+
+    int i;
+
+    for (i = 0; i < self->numberOfPaths; i++)
+        CS104_Connection_close(self->paths[i].connection);
+
+    lockConnection(self);
+
+    for (i = 0; i < self->numberOfPaths; i++)
+        self->paths[i].state = PATH_STATE_IDLE;
+
+    self->activePath = -1;
+    self->hadActivePath = false;
+
+    unlockConnection(self);
+}
+
+int
+CS104_RedundantConnection_getActivePath(CS104_RedundantConnection self)
+{
+    int activePath;
+
+    lockConnection(self);
+
+    activePath = self->activePath;
+
+    unlockConnection(self);
+
+    return activePath;
+}
+
+int
+CS104_RedundantConnection_getNumberOfDiscardedDuplicates(CS104_RedundantConnection self)
+{
+    int discardedDuplicates;
+
+    lockConnection(self);
+
+    discardedDuplicates = self->discardedDuplicates;
+
+    unlockConnection(self);
+
+    return discardedDuplicates;
+}
+
+bool
+CS104_RedundantConnection_sendASDU(CS104_RedundantConnection self, CS101_ASDU asdu)
+{
+    CS104_Connection activeConnection = NULL;
+
+    lockConnection(self);
+
+    if (self->activePath != -1)
+        activeConnection = self->paths[self->activePath].connection;
+
+    unlockConnection(self);
+
+    if (activeConnection)
+        return CS104_Connection_sendASDU(activeConnection, asdu);
+    else
+        return false;
+}
+
+void
+CS104_RedundantConnection_destroy(CS104_RedundantConnection self)
+{
+    if (self)
+    {
+        CS104_RedundantConnection_stop(self);
+
+        int i;
+
+        for (i = 0; i < self->numberOfPaths; i++)
+            CS104_Connection_destroy(self->paths[i].connection);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_destroy(self->lock);
+#endif
+
+        GLOBAL_FREEMEM(self);
+    }
+}
@@ -24,12 +24,16 @@
 #define _CRT_NONSTDC_NO_DEPRECATE
 #endif
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "buffer_frame.h"
+#include "cs101_response_stream.h"
+#include "cs104_ack_scheduler.h"
 #include "cs104_frame.h"
+#include "cs104_prefix_table.h"
 #include "cs104_slave.h"
 #include "frame.h"
 #include "hal_socket.h"
@@ -37,6 +41,7 @@
 #include "hal_time.h"
 #include "lib_memory.h"
 #include "linked_list.h"
+#include "timer_wheel.h"
 
 #include "iec60870_slave.h"
 #include "lib60870_config.h"
@@ -64,6 +69,10 @@ typedef enum
 
 typedef struct sMasterConnection* MasterConnection;
 
+#if (CONFIG_USE_THREADS == 1)
+typedef struct sCS104_SlaveWorker* CS104_SlaveWorker;
+#endif
+
 static void
 MasterConnection_close(MasterConnection self);
 
@@ -79,8 +88,14 @@ MasterConnection_activate(MasterConnection self);
 static bool
 MasterConnection_isActive(MasterConnection self);
 
+static void
+MasterConnection_markPending(MasterConnection self, bool wakeup);
+
 #define CS104_DEFAULT_PORT 2404
 
+/* maximum wait time (ms) reported by CS104_Slave_getNextTimeoutMs when plugins are installed */
+#define CS104_SLAVE_PLUGIN_POLL_INTERVAL 10
+
 static struct sCS104_APCIParameters defaultConnectionParameters = {
     /* .k = */ 12,
     /* .w = */ 8,
@@ -926,6 +941,7 @@ struct sCS104_IPAddress
 {
     uint8_t address[16];
     eCS104_IPAddressType type;
+    int prefixLength; /* number of significant bits (32 or 128 for a single address) */
 };
 
 static void
@@ -973,30 +989,6 @@ CS104_IPAddress_setFromString(CS104_IPAddress self, const char* ipAddrStr)
     }
 }
 
-static bool
-CS104_IPAddress_equals(CS104_IPAddress self, CS104_IPAddress other)
-{
-    if (self->type != other->type)
-        return false;
-
-    int size;
-
-    if (self->type == IP_ADDRESS_TYPE_IPV4)
-        size = 4;
-    else
-        size = 16;
-
-    int i;
-
-    for (i = 0; i < size; i++)
-    {
-        if (self->address[i] != other->address[i])
-            return false;
-    }
-
-    return true;
-}
-
 struct sCS104_RedundancyGroup
 {
 
@@ -1006,8 +998,15 @@ struct sCS104_RedundancyGroup
     HighPriorityASDUQueue connectionAsduQueue; /**< high priority ASDU queue */
 
     LinkedList allowedClients;
+
+    CS104_Slave slave; /**< slave the group was added to or NULL */
 };
 
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
+static void
+CS104_Slave_addAllowedClientToGroup(CS104_Slave self, CS104_RedundancyGroup group, CS104_IPAddress ipAddr);
+#endif
+
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
 static void
 CS104_RedundancyGroup_initializeMessageQueues(CS104_RedundancyGroup self, int lowPrioMaxQueueSize,
@@ -1043,6 +1042,8 @@ CS104_RedundancyGroup_create(const char* name)
         self->connectionAsduQueue = NULL;
 
         self->allowedClients = NULL;
+
+        self->slave = NULL;
     }
 
     return self;
@@ -1076,13 +1077,10 @@ CS104_RedundancyGroup_addAllowedClient(CS104_RedundancyGroup self, const char* i
     CS104_RedundancyGroup_addAllowedClientEx(self, ipAddr.address, ipAddr.type);
 }
 
-void
-CS104_RedundancyGroup_addAllowedClientEx(CS104_RedundancyGroup self, const uint8_t* ipAddress,
-                                         eCS104_IPAddressType addressType)
+static void
+CS104_RedundancyGroup_addAllowedPrefix(CS104_RedundancyGroup self, const uint8_t* ipAddress,
+                                       eCS104_IPAddressType addressType, int prefixLength)
 {
-    if (self->allowedClients == NULL)
-        self->allowedClients = LinkedList_create();
-
     CS104_IPAddress ipAddr = (CS104_IPAddress)GLOBAL_CALLOC(1, sizeof(struct sCS104_IPAddress));
 
     if (ipAddr)
@@ -1101,7 +1099,25 @@ CS104_RedundancyGroup_addAllowedClientEx(CS104_RedundancyGroup self, const uint8
         for (i = 0; i < size; i++)
             ipAddr->address[i] = ipAddress[i];
 
-        LinkedList_add(self->allowedClients, ipAddr);
+        if ((prefixLength < 0) || (prefixLength > size * 8))
+            prefixLength = size * 8;
+
+        ipAddr->prefixLength = prefixLength;
+
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
+        if (self->slave)
+        {
+            /* the slave can already use the group */
+            CS104_Slave_addAllowedClientToGroup(self->slave, self, ipAddr);
+        }
+        else
+#endif
+        {
+            if (self->allowedClients == NULL)
+                self->allowedClients = LinkedList_create();
+
+            LinkedList_add(self->allowedClients, ipAddr);
+        }
     }
     else
     {
@@ -1109,25 +1125,22 @@ CS104_RedundancyGroup_addAllowedClientEx(CS104_RedundancyGroup self, const uint8
     }
 }
 
-static bool
-CS104_RedundancyGroup_matches(CS104_RedundancyGroup self, CS104_IPAddress ipAddress)
+void
+CS104_RedundancyGroup_addAllowedClientEx(CS104_RedundancyGroup self, const uint8_t* ipAddress,
+                                         eCS104_IPAddressType addressType)
 {
-    if (self->allowedClients == NULL)
-        return false;
-
-    LinkedList element = LinkedList_getNext(self->allowedClients);
-
-    while (element)
-    {
-        CS104_IPAddress allowedAddress = (CS104_IPAddress)LinkedList_getData(element);
+    CS104_RedundancyGroup_addAllowedPrefix(self, ipAddress, addressType, -1);
+}
 
-        if (CS104_IPAddress_equals(ipAddress, allowedAddress))
-            return true;
+void
+CS104_RedundancyGroup_addAllowedClientPrefix(CS104_RedundancyGroup self, const char* ipAddress, int prefixLength)
+{
+    struct sCS104_IPAddress ipAddr;
+    memset(&ipAddr, 0, sizeof(struct sCS104_IPAddress));
 
-        element = LinkedList_getNext(element);
-    }
+    CS104_IPAddress_setFromString(&ipAddr, ipAddress);
 
-    return false;
+    CS104_RedundancyGroup_addAllowedPrefix(self, ipAddr.address, ipAddr.type, prefixLength);
 }
 
 static bool
@@ -1202,8 +1215,22 @@ struct sCS104_Slave
     bool isThreadlessMode;
 #endif
 
+    TimerWheel connectionTimers; /**< timeouts of the connections (only used in threadless mode) */
+    WakeupSignal wakeupSignal;   /**< wakes up the event loop of the application (only used in threadless mode) */
+
+    /* connections to be handled by CS104_Slave_executePeriodicTasks (only used in threadless mode) */
+    MasterConnection pendingConnections[CONFIG_CS104_MAX_CLIENT_CONNECTIONS];
+    int numberOfPendingConnections;
+    bool allConnectionsPending; /**< ASDUs were enqueued in the shared queues */
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore pendingConnectionsLock;
+#endif
+
     int maxOpenConnections; /**< maximum accepted open client connections */
 
+    bool adaptiveAck; /**< use the adaptive acknowledgement policy for new connections */
+
     struct sCS104_APCIParameters conParameters;
 
     struct sCS101_AppLayerParameters alParameters;
@@ -1220,6 +1247,9 @@ struct sCS104_Slave
 
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS)
     LinkedList redundancyGroups;
+
+    CS104_PrefixTable redundancyGroupTable; /**< allowed clients of all groups (built when the slave is started) */
+    CS104_RedundancyGroup catchAllGroup;    /**< group for clients that don't match an allowed client or NULL */
 #endif
 
     CS104_ServerMode serverMode;
@@ -1228,6 +1258,12 @@ struct sCS104_Slave
 
 #if (CONFIG_USE_THREADS == 1)
     Thread listeningThread;
+
+    CS104_SlaveWorker* workers; /**< worker threads that handle the connections (NULL: one thread per connection) */
+    int numberOfWorkers;
+    int nextWorker; /**< worker that is checked first when a new connection is assigned */
+
+    bool listenerPerWorker; /**< each worker accepts the connections from an own server socket (SO_REUSEPORT) */
 #endif
 
     ServerSocket serverSocket;
@@ -1258,8 +1294,8 @@ struct sMasterConnection
     CS104_Slave slave;
 
     MasterConnectionState state;
-    unsigned int isUsed : 1;
-    unsigned int isRunning : 1;
+    bool isUsed;    /* separate fields - written by different threads */
+    bool isRunning; /* protected by stateLock */
     unsigned int timeoutT2Triggered : 1;
     unsigned int waitingForTestFRcon : 1;
     uint16_t maxSentASDUs;  /* k-parameter */
@@ -1273,6 +1309,8 @@ struct sMasterConnection
     /* timeout T2 handling */
     uint64_t lastConfirmationTime; /* timestamp when the last confirmation message (for I messages) was sent */
 
+    struct sCS104_AckScheduler ackScheduler; /* protected by stateLock */
+
     uint64_t nextT3Timeout;
     uint64_t nextTestFRConTimeout; /* timeout T1 when waiting for TEST FR con */
 
@@ -1283,8 +1321,7 @@ struct sMasterConnection
 #endif
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore sentASDUsLock;
-    Semaphore stateLock;
+    Semaphore stateLock; /* protects the state, the sequence counters, the timeouts and the k-buffer */
 #endif
 
     HandleSet handleSet;
@@ -1297,11 +1334,57 @@ struct sMasterConnection
     MessageQueue lowPrioQueue;
     HighPriorityASDUQueue highPrioQueue;
 
+    struct sCS101_ResponseStreams responseStreams; /* streamed responses (IMasterConnection_startResponse) */
+
+    TimerWheel timers;                    /* wheel of the timeout timer (threadless mode and worker threads) */
+    struct sTimerWheelEntry timeoutTimer; /* next timeout (see MasterConnection_scheduleTimer) */
+    uint16_t timerSendCount;              /* sendCount when the timer was scheduled */
+
+    bool isPending; /* in the pending connections of the slave (protected by pendingConnectionsLock) */
+
+#if (CONFIG_USE_THREADS == 1)
+    CS104_SlaveWorker worker; /* worker thread that handles the connection (protected by stateLock) */
+#endif
+
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
     CS104_RedundancyGroup redundancyGroup;
 #endif
 };
 
+#if (CONFIG_USE_THREADS == 1)
+
+/*
+ * Worker thread that handles a part (shard) of the client connections with a single event loop.
+ *
+ * The server thread assigns new connections via newConnections. The list of the adopted connections,
+ * the timer wheel for their timeouts and the handle set are owned (allocated and used) by the worker
+ * thread only.
+ */
+struct sCS104_SlaveWorker
+{
+    CS104_Slave slave;
+
+    int cpu; /* CPU the worker thread is bound to (-1: not bound) */
+
+    Thread thread;
+
+    bool running;
+
+    LinkedList newConnections; /* connections assigned by the server thread that are not yet adopted */
+    int numberOfConnections;   /* number of assigned connections (used to select the worker) */
+
+    ServerSocket serverSocket; /* own server socket in listener per worker mode or NULL */
+
+    WakeupSignal wakeupSignal; /* interrupts the wait of the worker (new connection, ASDUs to send, stop) */
+    bool isSignaled;           /* wakeup signal set since the last reset of the worker */
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore lock; /* protects running, newConnections, numberOfConnections, isSignaled */
+#endif
+};
+
+#endif /* (CONFIG_USE_THREADS == 1) */
+
 static uint8_t STARTDT_CON_MSG[] = {0x68, 0x04, 0x0b, 0x00, 0x00, 0x00};
 
 #define STARTDT_CON_MSG_SIZE 6
@@ -1464,6 +1547,7 @@ createSlave(int maxLowPrioQueueSize, int maxHighPrioQueueSize)
 #if (CONFIG_USE_SEMAPHORES == 1)
         self->openConnectionsLock = Semaphore_create(1);
         self->stateLock = Semaphore_create(1);
+        self->pendingConnectionsLock = Semaphore_create(1);
 #endif
 
 #if (CONFIG_USE_THREADS == 1)
@@ -1479,6 +1563,11 @@ createSlave(int maxLowPrioQueueSize, int maxHighPrioQueueSize)
 
 #if (CONFIG_USE_THREADS == 1)
         self->listeningThread = NULL;
+
+        self->workers = NULL;
+        self->numberOfWorkers = 0;
+        self->nextWorker = 0;
+        self->listenerPerWorker = false;
 #endif
 
         self->serverSocket = NULL;
@@ -1491,6 +1580,8 @@ createSlave(int maxLowPrioQueueSize, int maxHighPrioQueueSize)
 
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
         self->redundancyGroups = NULL;
+        self->redundancyGroupTable = NULL;
+        self->catchAllGroup = NULL;
 #endif
 
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
@@ -1626,6 +1717,242 @@ CS104_Slave_setMaxOpenConnections(CS104_Slave self, int maxOpenConnections)
     self->maxOpenConnections = maxOpenConnections;
 }
 
+void
+CS104_Slave_setAdaptiveAck(CS104_Slave self, bool enabled)
+{
+    self->adaptiveAck = enabled;
+}
+
+#if (CONFIG_USE_THREADS == 1)
+
+static CS104_SlaveWorker
+CS104_SlaveWorker_create(CS104_Slave slave)
+{
+    CS104_SlaveWorker self = (CS104_SlaveWorker)GLOBAL_CALLOC(1, sizeof(struct sCS104_SlaveWorker));
+
+    if (self)
+    {
+        self->slave = slave;
+        self->cpu = -1;
+        self->thread = NULL;
+        self->running = false;
+        self->numberOfConnections = 0;
+        self->serverSocket = NULL;
+        self->isSignaled = false;
+
+        self->newConnections = LinkedList_create();
+        self->wakeupSignal = WakeupSignal_create();
+
+        if ((self->newConnections == NULL) || (self->wakeupSignal == NULL))
+        {
+            if (self->newConnections)
+                LinkedList_destroyStatic(self->newConnections);
+
+            if (self->wakeupSignal)
+                WakeupSignal_destroy(self->wakeupSignal);
+
+            GLOBAL_FREEMEM(self);
+            return NULL;
+        }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        self->lock = Semaphore_create(1);
+#endif
+    }
+
+    return self;
+}
+
+static void
+CS104_SlaveWorker_destroy(CS104_SlaveWorker self)
+{
+    if (self)
+    {
+        LinkedList_destroyStatic(self->newConnections);
+        WakeupSignal_destroy(self->wakeupSignal);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_destroy(self->lock);
+#endif
+
+        GLOBAL_FREEMEM(self);
+    }
+}
+
+/* wake up the worker thread (can be called by any thread) */
+static void
+CS104_SlaveWorker_wakeup(CS104_SlaveWorker self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    /* the signal is set only once until the worker resets it */
+    bool wasSignaled = self->isSignaled;
+
+    self->isSignaled = true;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    if (wasSignaled == false)
+        WakeupSignal_set(self->wakeupSignal);
+}
+
+/* worker thread: reset the wakeup signal before the worker checks for new work */
+static void
+CS104_SlaveWorker_resetWakeup(CS104_SlaveWorker self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    bool wasSignaled = self->isSignaled;
+
+    self->isSignaled = false;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    if (wasSignaled)
+        WakeupSignal_reset(self->wakeupSignal);
+}
+
+static void
+wakeupWorkers(CS104_Slave self)
+{
+    int i;
+
+    for (i = 0; i < self->numberOfWorkers; i++)
+        CS104_SlaveWorker_wakeup(self->workers[i]);
+}
+
+static void
+releaseWorkers(CS104_Slave self)
+{
+    if (self->workers)
+    {
+        int i;
+
+        for (i = 0; i < self->numberOfWorkers; i++)
+            CS104_SlaveWorker_destroy(self->workers[i]);
+
+        GLOBAL_FREEMEM(self->workers);
+
+        self->workers = NULL;
+    }
+
+    self->numberOfWorkers = 0;
+    self->nextWorker = 0;
+}
+
+#endif /* (CONFIG_USE_THREADS == 1) */
+
+void
+CS104_Slave_setWorkerThreads(CS104_Slave self, int numberOfWorkers)
+{
+#if (CONFIG_USE_THREADS == 1)
+    if (isRunning(self))
+    {
+        DEBUG_PRINT("CS104 SLAVE: Cannot change the worker threads of a running slave\n");
+        return;
+    }
+
+    releaseWorkers(self);
+
+    if (numberOfWorkers > 0)
+    {
+        self->workers = (CS104_SlaveWorker*)GLOBAL_CALLOC(numberOfWorkers, sizeof(CS104_SlaveWorker));
+
+        if (self->workers == NULL)
+        {
+            DEBUG_PRINT("CS104 SLAVE: Failed to allocate memory for worker threads\n");
+            return;
+        }
+
+        self->numberOfWorkers = numberOfWorkers;
+
+        int i;
+
+        for (i = 0; i < numberOfWorkers; i++)
+        {
+            self->workers[i] = CS104_SlaveWorker_create(self);
+
+            if (self->workers[i] == NULL)
+            {
+                DEBUG_PRINT("CS104 SLAVE: Failed to allocate memory for worker threads\n");
+                releaseWorkers(self);
+                return;
+            }
+        }
+    }
+#else
+    DEBUG_PRINT("CS104 SLAVE: ERROR: worker threads not supported when CONFIG_USE_THREADS = 0!\n");
+#endif /* (CONFIG_USE_THREADS == 1) */
+}
+
+bool
+CS104_Slave_setWorkerAffinity(CS104_Slave self, int worker, int cpu)
+{
+#if (CONFIG_USE_THREADS == 1)
+    if ((worker < 0) || (worker >= self->numberOfWorkers))
+        return false;
+
+    self->workers[worker]->cpu = (cpu < 0) ? -1 : cpu;
+
+    return true;
+#else
+    return false;
+#endif /* (CONFIG_USE_THREADS == 1) */
+}
+
+void
+CS104_Slave_setListenerPerWorker(CS104_Slave self, bool enabled)
+{
+#if (CONFIG_USE_THREADS == 1)
+    if (isRunning(self))
+    {
+        DEBUG_PRINT("CS104 SLAVE: Cannot change the listener mode of a running slave\n");
+        return;
+    }
+
+    self->listenerPerWorker = enabled;
+#else
+    DEBUG_PRINT("CS104 SLAVE: ERROR: worker threads not supported when CONFIG_USE_THREADS = 0!\n");
+#endif /* (CONFIG_USE_THREADS == 1) */
+}
+
+void
+CS104_Slave_getAckStatistics(CS104_Slave self, CS104_AckStatistics statistics)
+{
+    statistics->sentAcks = 0;
+    statistics->savedAcks = 0;
+
+    /* connection objects are reused and keep their counters */
+    int i;
+
+    for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
+    {
+        MasterConnection con = self->masterConnections[i];
+
+        if (con)
+        {
+#if (CONFIG_USE_SEMAPHORES)
+            Semaphore_wait(con->stateLock);
+#endif
+
+            statistics->sentAcks += con->ackScheduler.sentAcks;
+            statistics->savedAcks += con->ackScheduler.savedAcks;
+
+#if (CONFIG_USE_SEMAPHORES)
+            Semaphore_post(con->stateLock);
+#endif
+        }
+    }
+}
+
 void
 CS104_Slave_setConnectionRequestHandler(CS104_Slave self, CS104_ConnectionRequestHandler handler, void* parameter)
 {
@@ -1918,13 +2245,10 @@ writeToSocket(MasterConnection self, uint8_t* buf, int size)
 #endif
 }
 
+/* unprotected - has to be called with stateLock */
 static int
 sendIMessage(MasterConnection self, uint8_t* buffer, int msgSize)
 {
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_wait(self->stateLock);
-#endif
-
     buffer[0] = (uint8_t)0x68;
     buffer[1] = (uint8_t)(msgSize - 2);
 
@@ -1939,6 +2263,8 @@ sendIMessage(MasterConnection self, uint8_t* buffer, int msgSize)
         DEBUG_PRINT("CS104 SLAVE: SEND I (size = %i) N(S) = %i N(R) = %i\n", msgSize, self->sendCount,
                     self->receiveCount);
         self->sendCount = (self->sendCount + 1) % 32768;
+        CS104_AckScheduler_iMessageSent(&(self->ackScheduler), self->unconfirmedReceivedIMessages,
+                                        Hal_getMonotonicTimeInMs());
         self->unconfirmedReceivedIMessages = 0;
         self->timeoutT2Triggered = false;
     }
@@ -1947,19 +2273,13 @@ sendIMessage(MasterConnection self, uint8_t* buffer, int msgSize)
 
     self->unconfirmedReceivedIMessages = 0;
 
-    int sendCount = self->sendCount;
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_post(self->stateLock);
-#endif
-
-    return sendCount;
-}
+    return self->sendCount;
+}
 
 static bool
 isSentBufferFull(MasterConnection self)
 {
-    /* locking of k-buffer has to be done by caller! */
+    /* locking of k-buffer (stateLock) has to be done by caller! */
     if (self->oldestSentASDU == -1)
         return false;
 
@@ -1999,47 +2319,43 @@ sendASDU(MasterConnection self, uint8_t* buffer, int msgSize, uint64_t entryId,
 static bool
 sendASDUInternal(MasterConnection self, CS101_ASDU asdu)
 {
-    bool asduSent;
+    bool asduSent = false;
+    bool isActive;
 
-    if (MasterConnection_isActive(self))
-    {
 #if (CONFIG_USE_SEMAPHORES == 1)
-        Semaphore_wait(self->sentASDUsLock);
+    Semaphore_wait(self->stateLock);
 #endif
 
-        if (isSentBufferFull(self) == false)
-        {
+    isActive = (self->state == M_CON_STATE_STARTED);
 
-            FrameBuffer frameBuffer;
+    if (isActive && (isSentBufferFull(self) == false))
+    {
+        FrameBuffer frameBuffer;
 
-            struct sBufferFrame bufferFrame;
+        struct sBufferFrame bufferFrame;
 
-            Frame frame = BufferFrame_initialize(&bufferFrame, frameBuffer.msg, IEC60870_5_104_APCI_LENGTH);
-            CS101_ASDU_encode(asdu, frame);
+        Frame frame = BufferFrame_initialize(&bufferFrame, frameBuffer.msg, IEC60870_5_104_APCI_LENGTH);
+        CS101_ASDU_encode(asdu, frame);
 
-            frameBuffer.msgSize = Frame_getMsgSize(frame);
+        frameBuffer.msgSize = Frame_getMsgSize(frame);
 
-            sendASDU(self, frameBuffer.msg, frameBuffer.msgSize, 0, NULL);
+        sendASDU(self, frameBuffer.msg, frameBuffer.msgSize, 0, NULL);
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_post(self->sentASDUsLock);
-#endif
+        asduSent = true;
+    }
 
-            asduSent = true;
-        }
-        else
-        {
 #if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_post(self->sentASDUsLock);
+    Semaphore_post(self->stateLock);
 #endif
-            asduSent = HighPriorityASDUQueue_enqueue(self->highPrioQueue, asdu);
-        }
-    }
-    else
-        asduSent = false;
+
+    /* k-buffer full -> send later */
+    if (isActive && (asduSent == false))
+        asduSent = HighPriorityASDUQueue_enqueue(self->highPrioQueue, asdu);
 
     if (asduSent == false)
         DEBUG_PRINT("CS104 SLAVE: unable to send response (state=%i)\n", self->state);
+    else
+        MasterConnection_markPending(self, false); /* T1 has to be scheduled */
 
     return asduSent;
 }
@@ -2535,13 +2851,10 @@ handleASDU(MasterConnection self, CS101_ASDU asdu)
     return true;
 }
 
+/* unprotected - has to be called with stateLock */
 static bool
 checkSequenceNumber(MasterConnection self, int seqNo)
 {
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_wait(self->sentASDUsLock);
-#endif
-
     /* check if received sequence number is valid */
 
     bool seqNoIsValid = false;
@@ -2619,6 +2932,10 @@ checkSequenceNumber(MasterConnection self, int seqNo)
                 {
                     /* we arrived at the seq# that has been confirmed */
 
+                    CS104_AckScheduler_updateRoundTripTime(&(self->ackScheduler),
+                                                           self->sentASDUs[self->oldestSentASDU].sentTime,
+                                                           Hal_getMonotonicTimeInMs());
+
                     if (self->oldestSentASDU == self->newestSentASDU)
                         self->oldestSentASDU = -1;
                     else
@@ -2643,10 +2960,6 @@ checkSequenceNumber(MasterConnection self, int seqNo)
     else
         DEBUG_PRINT("CS104 SLAVE: Received sequence number out of range");
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_post(self->sentASDUsLock);
-#endif
-
     return seqNoIsValid;
 }
 
@@ -2687,6 +3000,21 @@ MasterConnection_isActive(MasterConnection self)
     return isActive;
 }
 
+/* close the connection (has to be called without stateLock) */
+static void
+MasterConnection_stopRunning(MasterConnection self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->stateLock);
+#endif
+
+    self->isRunning = false;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->stateLock);
+#endif
+}
+
 static void
 _resetT3Timeout(MasterConnection self, uint64_t currentTime)
 {
@@ -2707,17 +3035,12 @@ resetT3Timeout(MasterConnection self, uint64_t currentTime)
 #endif
 }
 
+/* unprotected - has to be called with stateLock */
 static bool
 checkT3Timeout(MasterConnection self, uint64_t currentTime)
 {
-    bool retVal = false;
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_wait(self->stateLock);
-#endif
-
     if (self->waitingForTestFRcon)
-        goto exit_function;
+        return false;
 
     if (self->nextT3Timeout > (currentTime + (uint64_t)(self->slave->conParameters.t3 * 1000)))
     {
@@ -2726,15 +3049,9 @@ checkT3Timeout(MasterConnection self, uint64_t currentTime)
     }
 
     if (currentTime > self->nextT3Timeout)
-        retVal = true;
-
-exit_function:
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_post(self->stateLock);
-#endif
-
-    return retVal;
+        return true;
+    else
+        return false;
 }
 
 static void
@@ -2758,7 +3075,7 @@ checkTestFRConTimeout(MasterConnection self, uint64_t currentTime)
         return false;
 }
 
-/* unprotected version of sendSMessage */
+/* unprotected version of sendSMessage - has to be called with stateLock */
 static void
 _sendSMessage(MasterConnection self)
 {
@@ -2775,14 +3092,63 @@ _sendSMessage(MasterConnection self)
         self->isRunning = false;
 }
 
+/* unprotected - confirm all received I messages with an S message */
 static void
-sendSMessage(MasterConnection self)
+_confirmReceivedIMessages(MasterConnection self, uint64_t currentTime)
+{
+    self->lastConfirmationTime = currentTime;
+
+    self->unconfirmedReceivedIMessages = 0;
+
+    self->timeoutT2Triggered = false;
+
+    CS104_AckScheduler_ackSent(&(self->ackScheduler));
+
+    _sendSMessage(self);
+}
+
+/**
+ * Check if an I message is sent immediately by sendWaitingASDUs (and can carry the acknowledgement)
+ *
+ * unprotected - has to be called with stateLock
+ */
+static bool
+isIMessagePending(MasterConnection self)
+{
+    if ((self->state == M_CON_STATE_STARTED) && (isSentBufferFull(self) == false))
+    {
+        if (HighPriorityASDUQueue_isAsduAvailable(self->highPrioQueue) ||
+            MessageQueue_isAsduAvailable(self->lowPrioQueue))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Send an S message when required by the acknowledgement policy
+ *
+ * \param iMessagePending true when the caller calls sendWaitingASDUs next
+ */
+static void
+checkAcknowledgement(MasterConnection self, bool iMessagePending)
 {
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_wait(self->stateLock);
 #endif
 
-    _sendSMessage(self);
+    if (iMessagePending)
+        iMessagePending = isIMessagePending(self);
+
+    uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+    if (CS104_AckScheduler_isAckRequired(&(self->ackScheduler), self->unconfirmedReceivedIMessages, iMessagePending,
+                                         currentTime))
+    {
+        _confirmReceivedIMessages(self, currentTime);
+    }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_post(self->stateLock);
@@ -2818,18 +3184,24 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
                 return false;
             }
 
+            int frameSendSequenceNumber = ((buffer[3] * 0x100) + (buffer[2] & 0xfe)) / 2;
+            int frameRecvSequenceNumber = ((buffer[5] * 0x100) + (buffer[4] & 0xfe)) / 2;
+
+            DEBUG_PRINT("CS104 SLAVE: Received I frame: N(S) = %i N(R) = %i\n", frameSendSequenceNumber,
+                        frameRecvSequenceNumber);
+
+            /* update the connection state with a single lock - the ASDU handlers are called without lock */
 #if (CONFIG_USE_SEMAPHORES == 1)
             Semaphore_wait(self->stateLock);
 #endif
 
             if (self->state != M_CON_STATE_STARTED)
             {
-                DEBUG_PRINT("CS104 SLAVE: Received I message while connection not active -> close connection");
-
 #if (CONFIG_USE_SEMAPHORES == 1)
                 Semaphore_post(self->stateLock);
 #endif
 
+                DEBUG_PRINT("CS104 SLAVE: Received I message while connection not active -> close connection");
                 return false;
             }
 
@@ -2838,22 +3210,9 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
                 self->timeoutT2Triggered = true;
                 self->lastConfirmationTime = currentTime; /* start timeout T2 */
             }
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_post(self->stateLock);
-#endif
-
-            int frameSendSequenceNumber = ((buffer[3] * 0x100) + (buffer[2] & 0xfe)) / 2;
-            int frameRecvSequenceNumber = ((buffer[5] * 0x100) + (buffer[4] & 0xfe)) / 2;
 
-            DEBUG_PRINT("CS104 SLAVE: Received I frame: N(S) = %i N(R) = %i\n", frameSendSequenceNumber,
-                        frameRecvSequenceNumber);
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_wait(self->stateLock);
-#endif
             if (frameSendSequenceNumber != self->receiveCount)
             {
-
 #if (CONFIG_USE_SEMAPHORES == 1)
                 Semaphore_post(self->stateLock);
 #endif
@@ -2861,26 +3220,30 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
                 DEBUG_PRINT("CS104 SLAVE: Sequence error - close connection");
                 return false;
             }
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_post(self->stateLock);
-#endif
 
             if (checkSequenceNumber(self, frameRecvSequenceNumber) == false)
             {
+#if (CONFIG_USE_SEMAPHORES == 1)
+                Semaphore_post(self->stateLock);
+#endif
+
                 DEBUG_PRINT("CS104 SLAVE: Sequence number check failed - close connection");
                 return false;
             }
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_wait(self->stateLock);
-#endif
             self->receiveCount = (self->receiveCount + 1) % 32768;
             self->unconfirmedReceivedIMessages++;
+            CS104_AckScheduler_iMessageReceived(&(self->ackScheduler), currentTime);
+
+            _resetT3Timeout(self, currentTime);
+
+            bool isActive = (self->state == M_CON_STATE_STARTED);
+
 #if (CONFIG_USE_SEMAPHORES == 1)
             Semaphore_post(self->stateLock);
 #endif
 
-            if (MasterConnection_isActive(self))
+            if (isActive)
             {
                 struct sCS101_ASDU _asdu;
 
@@ -2908,6 +3271,8 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
                 DEBUG_PRINT("CS104 SLAVE: Received I message while connection not activate -> close connection");
                 return false;
             }
+
+            return true;
         }
 
         /* Check for TESTFR_ACT message */
@@ -2939,26 +3304,15 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
 
             MasterConnection_deactivate(self);
 
-            /* Send S-Message to confirm all outstanding messages */
+            bool sendStopDtCon = false;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
             Semaphore_wait(self->stateLock);
 #endif
 
+            /* Send S-Message to confirm all outstanding messages */
             if (self->unconfirmedReceivedIMessages > 0)
-            {
-                self->lastConfirmationTime = Hal_getMonotonicTimeInMs();
-
-                self->unconfirmedReceivedIMessages = 0;
-
-                self->timeoutT2Triggered = false;
-
-                _sendSMessage(self);
-            }
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_post(self->stateLock);
-#endif
+                _confirmReceivedIMessages(self, Hal_getMonotonicTimeInMs());
 
             if (MasterConnection_hasUnconfirmedMessages(self))
             {
@@ -2967,23 +3321,22 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
             }
             else
             {
-                DEBUG_PRINT("CS104 SLAVE: Send STOPDT_CON\n");
-
                 self->state = M_CON_STATE_STOPPED;
 
-                if (writeToSocket(self, STOPDT_CON_MSG, STOPDT_CON_MSG_SIZE) < 0)
-                {
-#if (CONFIG_USE_SEMAPHORES == 1)
-                    Semaphore_post(self->stateLock);
-#endif
-
-                    return false;
-                }
+                sendStopDtCon = true;
             }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
             Semaphore_post(self->stateLock);
 #endif
+
+            if (sendStopDtCon)
+            {
+                DEBUG_PRINT("CS104 SLAVE: Send STOPDT_CON\n");
+
+                if (writeToSocket(self, STOPDT_CON_MSG, STOPDT_CON_MSG_SIZE) < 0)
+                    return false;
+            }
         }
 
         /* Check for TESTFR_CON message */
@@ -2994,6 +3347,13 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
 #if (CONFIG_USE_SEMAPHORES == 1)
             Semaphore_wait(self->stateLock);
 #endif
+            if (self->waitingForTestFRcon)
+            {
+                CS104_AckScheduler_updateRoundTripTime(
+                    &(self->ackScheduler), self->nextTestFRConTimeout - (uint64_t)(self->slave->conParameters.t1 * 1000),
+                    currentTime);
+            }
+
             self->waitingForTestFRcon = false;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
@@ -3007,13 +3367,18 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
 
             DEBUG_PRINT("CS104 SLAVE: Rcvd S(%i) (own sendcounter = %i)\n", seqNo, self->sendCount);
 
+            bool messageOk = true;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+            Semaphore_wait(self->stateLock);
+#endif
+
             if (checkSequenceNumber(self, seqNo) == false)
             {
                 DEBUG_PRINT("CS104 SLAVE: S message - sequence number mismatch");
-                return false;
+                messageOk = false;
             }
-
-            if (self->state == M_CON_STATE_UNCONFIRMED_STOPPED)
+            else if (self->state == M_CON_STATE_UNCONFIRMED_STOPPED)
             {
                 if (MasterConnection_hasUnconfirmedMessages(self) == false)
                 {
@@ -3022,15 +3387,24 @@ handleMessage(MasterConnection self, uint8_t* buffer, int msgSize)
                     DEBUG_PRINT("CS104 SLAVE: Send STOPDT_CON\n");
 
                     if (writeToSocket(self, STOPDT_CON_MSG, STOPDT_CON_MSG_SIZE) < 0)
-                        return false;
+                        messageOk = false;
                 }
             }
             else if (self->state == M_CON_STATE_STOPPED)
             {
                 DEBUG_PRINT("CS104 SLAVE: S message in stopped state -> active close\n");
                 /* actively close connection */
-                return false;
+                messageOk = false;
             }
+
+            if (messageOk)
+                _resetT3Timeout(self, currentTime);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+            Semaphore_post(self->stateLock);
+#endif
+
+            return messageOk;
         }
 
         else
@@ -3066,7 +3440,23 @@ MasterConnection_deinit(MasterConnection self)
             self->socket = NULL;
         }
 
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_wait(self->stateLock);
+#endif
+
         self->state = M_CON_STATE_STOPPED;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_post(self->stateLock);
+#endif
+
+        if (self->timers)
+        {
+            TimerWheel_cancel(self->timers, &(self->timeoutTimer));
+            self->timers = NULL;
+        }
+
+        CS101_ResponseStreams_clear(&(self->responseStreams), &(self->iMasterConnection));
     }
 }
 
@@ -3078,8 +3468,10 @@ MasterConnection_destroy(MasterConnection self)
 
         GLOBAL_FREEMEM(self->sentASDUs);
 
+        CS101_ResponseStreams_clear(&(self->responseStreams), &(self->iMasterConnection));
+        CS101_ResponseStreams_dispose(&(self->responseStreams));
+
 #if (CONFIG_USE_SEMAPHORES == 1)
-        Semaphore_destroy(self->sentASDUsLock);
         Semaphore_destroy(self->stateLock);
 #endif
 
@@ -3101,7 +3493,7 @@ static void
 sendNextLowPriorityASDU(MasterConnection self)
 {
 #if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_wait(self->sentASDUsLock);
+    Semaphore_wait(self->stateLock);
 #endif
 
     uint8_t* asduBuffer;
@@ -3131,7 +3523,7 @@ sendNextLowPriorityASDU(MasterConnection self)
 exit_function:
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_post(self->sentASDUsLock);
+    Semaphore_post(self->stateLock);
 #endif
 
     return;
@@ -3145,7 +3537,7 @@ sendNextHighPriorityASDU(MasterConnection self)
     int msgSize = 0;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_wait(self->sentASDUsLock);
+    Semaphore_wait(self->stateLock);
 #endif
 
     if (isSentBufferFull(self))
@@ -3170,7 +3562,7 @@ sendNextHighPriorityASDU(MasterConnection self)
 
 exit_function:
 #if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_post(self->sentASDUsLock);
+    Semaphore_post(self->stateLock);
 #endif
 
     return retVal;
@@ -3209,45 +3601,62 @@ sendWaitingASDUs(MasterConnection self)
     }
 }
 
-static bool
-handleTimeouts(MasterConnection self)
+/**
+ * Pull the ASDUs of the streamed responses while they can be sent immediately (free slot in the
+ * k-buffer and no waiting high-priority ASDUs). When the k-buffer is full the next ASDU is created
+ * after the confirmation of the master was received.
+ */
+static void
+sendResponseStreams(MasterConnection self)
 {
-    uint64_t currentTime = Hal_getMonotonicTimeInMs();
-
-    bool timeoutsOk = true;
+    if (CS101_ResponseStreams_isEmpty(&(self->responseStreams)))
+        return;
 
-    /* check T3 timeout */
-    if (checkT3Timeout(self, currentTime))
+    while (true)
     {
-        if (writeToSocket(self, TESTFR_ACT_MSG, TESTFR_ACT_MSG_SIZE) < 0)
-        {
-
-            DEBUG_PRINT("CS104 SLAVE: Failed to write TESTFR ACT message\n");
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_wait(self->stateLock);
-#endif
-            self->isRunning = false;
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-            Semaphore_post(self->stateLock);
-#endif
-        }
+        if (HighPriorityASDUQueue_isAsduAvailable(self->highPrioQueue))
+            break;
 
 #if (CONFIG_USE_SEMAPHORES == 1)
         Semaphore_wait(self->stateLock);
 #endif
-        self->waitingForTestFRcon = true;
-        resetTestFRConTimeout(self, currentTime);
+
+        bool canSend = (self->state == M_CON_STATE_STARTED) && (isSentBufferFull(self) == false);
 
 #if (CONFIG_USE_SEMAPHORES == 1)
         Semaphore_post(self->stateLock);
 #endif
+
+        if (canSend == false)
+            break;
+
+        if (CS101_ResponseStreams_sendNext(&(self->responseStreams), &(self->iMasterConnection)) == false)
+            break;
     }
+}
+
+static bool
+handleTimeouts(MasterConnection self)
+{
+    uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+    bool timeoutsOk = true;
+    bool sendTestFrAct = false;
 
+    /* all timeouts are checked with a single lock */
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_wait(self->stateLock);
 #endif
 
+    /* check T3 timeout - TESTFR_ACT is sent after the lock is released */
+    if (checkT3Timeout(self, currentTime))
+    {
+        sendTestFrAct = true;
+
+        self->waitingForTestFRcon = true;
+        resetTestFRConTimeout(self, currentTime);
+    }
+
     /* Check for TEST FR con timeout */
     if (self->waitingForTestFRcon)
     {
@@ -3275,22 +3684,11 @@ handleTimeouts(MasterConnection self)
         {
             if ((currentTime - self->lastConfirmationTime) >= (uint64_t)(self->slave->conParameters.t2 * 1000))
             {
-                self->lastConfirmationTime = currentTime;
-                self->unconfirmedReceivedIMessages = 0;
-                self->timeoutT2Triggered = false;
-                _sendSMessage(self);
+                _confirmReceivedIMessages(self, currentTime);
             }
         }
     }
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_post(self->stateLock);
-#endif
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_wait(self->sentASDUsLock);
-#endif
-
     /* check if counterpart confirmed I message */
     if (self->oldestSentASDU != -1)
     {
@@ -3320,13 +3718,24 @@ handleTimeouts(MasterConnection self)
     }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_post(self->sentASDUsLock);
+    Semaphore_post(self->stateLock);
 #endif
 
-    return timeoutsOk;
-}
-
-static void
+    /* written without the lock - the raw message handler may call IMasterConnection functions */
+    if (sendTestFrAct)
+    {
+        if (writeToSocket(self, TESTFR_ACT_MSG, TESTFR_ACT_MSG_SIZE) < 0)
+        {
+            DEBUG_PRINT("CS104 SLAVE: Failed to write TESTFR ACT message\n");
+
+            MasterConnection_stopRunning(self);
+        }
+    }
+
+    return timeoutsOk;
+}
+
+static void
 CS104_Slave_closeAllConnections(CS104_Slave self)
 {
 #if (CONFIG_USE_SEMAPHORES)
@@ -3383,7 +3792,18 @@ connectionHandlingThread(void* parameter)
         if (isAsduWaiting)
             socketTimeout = 0;
         else
-            socketTimeout = 100;
+        {
+#if (CONFIG_USE_SEMAPHORES == 1)
+            Semaphore_wait(self->stateLock);
+#endif
+
+            /* wake up in time for a deferred acknowledgement */
+            socketTimeout = CS104_AckScheduler_getWaitTime(&(self->ackScheduler), Hal_getMonotonicTimeInMs(), 100);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+            Semaphore_post(self->stateLock);
+#endif
+        }
 
         if (Handleset_waitReady(self->handleSet, socketTimeout))
         {
@@ -3415,16 +3835,7 @@ connectionHandlingThread(void* parameter)
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
                 }
 
-                if (self->unconfirmedReceivedIMessages >= self->slave->conParameters.w)
-                {
-                    self->lastConfirmationTime = Hal_getMonotonicTimeInMs();
-
-                    self->unconfirmedReceivedIMessages = 0;
-
-                    self->timeoutT2Triggered = false;
-
-                    sendSMessage(self);
-                }
+                checkAcknowledgement(self, true);
             }
         }
 
@@ -3446,7 +3857,12 @@ connectionHandlingThread(void* parameter)
             if (MasterConnection_isActive(self))
             {
                 isAsduWaiting = sendWaitingASDUs(self);
+
+                sendResponseStreams(self);
             }
+
+            /* the acknowledgement can be due when no I message was sent */
+            checkAcknowledgement(self, false);
         }
 
         /* call plugins */
@@ -3465,6 +3881,9 @@ connectionHandlingThread(void* parameter)
         }
     }
 
+    /* abort the streamed responses before the application is informed about the closed connection */
+    CS101_ResponseStreams_clear(&(self->responseStreams), &(self->iMasterConnection));
+
     if (self->slave->connectionEventHandler)
     {
         self->slave->connectionEventHandler(self->slave->connectionEventHandlerParameter, &(self->iMasterConnection),
@@ -3495,9 +3914,20 @@ _IMasterConnection_isReady(IMasterConnection self)
 {
     MasterConnection con = (MasterConnection)self->object;
 
-    if (MasterConnection_isActive(con))
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(con->stateLock);
+#endif
+
+    bool isActive = (con->state == M_CON_STATE_STARTED);
+    bool isFull = isSentBufferFull(con);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(con->stateLock);
+#endif
+
+    if (isActive)
     {
-        if (isSentBufferFull(con) == false)
+        if (isFull == false)
             return true;
 
         if (HighPriorityASDUQueue_isFull(con->highPrioQueue))
@@ -3579,10 +4009,157 @@ _IMasterConnection_getApplicationLayerParameters(IMasterConnection self)
     return &(con->slave->alParameters);
 }
 
+static bool
+_IMasterConnection_startResponse(IMasterConnection self, CS101_ASDU command, CS101_ResponseGenerator generator,
+                                 CS101_ResponseFinishedHandler finishedHandler, void* parameter)
+{
+    MasterConnection con = (MasterConnection)self->object;
+
+    if (MasterConnection_isRunning(con) == false)
+        return false;
+
+    if (CS101_ResponseStreams_add(&(con->responseStreams), command, generator, finishedHandler, parameter) == false)
+        return false;
+
+    MasterConnection_markPending(con, false);
+
+    return true;
+}
+
 /********************************************
  * END IMasterConnection
  *******************************************/
 
+/*
+ * Get the time when the next timeout of the connection (T1, T2, T3, deferred acknowledgement)
+ * has to be checked
+ */
+static uint64_t
+MasterConnection_getNextDeadline(MasterConnection self, uint64_t currentTime)
+{
+    uint64_t deadline;
+    uint64_t timeout;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->stateLock);
+#endif
+
+    /* T1 when waiting for TESTFR CON, T3 otherwise (timeouts are checked with ">") */
+    if (self->waitingForTestFRcon)
+        deadline = self->nextTestFRConTimeout + 1;
+    else
+        deadline = self->nextT3Timeout + 1;
+
+    /* T2 */
+    if ((self->unconfirmedReceivedIMessages > 0) && (self->lastConfirmationTime != UINT64_MAX))
+    {
+        timeout = self->lastConfirmationTime + (uint64_t)(self->slave->conParameters.t2 * 1000);
+
+        if (timeout < deadline)
+            deadline = timeout;
+    }
+
+    /* deferred acknowledgement */
+    if (deadline > currentTime)
+    {
+        deadline = currentTime + (uint64_t)CS104_AckScheduler_getWaitTime(&(self->ackScheduler), currentTime,
+                                                                           (int)(deadline - currentTime));
+    }
+
+    /* T1 for the oldest unconfirmed I message */
+    if (self->oldestSentASDU != -1)
+    {
+        timeout = self->sentASDUs[self->oldestSentASDU].sentTime + (uint64_t)(self->slave->conParameters.t1 * 1000);
+
+        if (timeout < deadline)
+            deadline = timeout;
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->stateLock);
+#endif
+
+    return deadline;
+}
+
+/*
+ * threadless mode and worker threads: (re)schedule the timeout timer of the connection
+ *
+ * Has to be called after events that change the timeouts (received message, sent I message).
+ * With checkAcknowledgementNow the timer expires with the next tick (acknowledgement that was
+ * deferred because of a pending I message).
+ */
+static void
+MasterConnection_scheduleTimer(MasterConnection self, bool checkAcknowledgementNow)
+{
+    TimerWheel timers = self->timers;
+
+    if (timers == NULL)
+        return;
+
+    uint64_t currentTime = Hal_getMonotonicTimeInMs();
+
+    uint64_t deadline = MasterConnection_getNextDeadline(self, currentTime);
+
+    if (checkAcknowledgementNow)
+        deadline = currentTime;
+
+    self->timerSendCount = self->sendCount;
+
+    TimerWheel_schedule(timers, &(self->timeoutTimer), deadline);
+}
+
+/* threadless mode and worker threads: timeout timer of the connection expired */
+static void
+MasterConnection_handleTimer(void* parameter)
+{
+    MasterConnection self = (MasterConnection)parameter;
+
+    if ((self->isUsed == false) || (MasterConnection_isRunning(self) == false))
+        return;
+
+    checkAcknowledgement(self, false);
+
+    if (handleTimeouts(self) == false)
+        MasterConnection_stopRunning(self);
+
+    /* connection closed by a timeout or a failed send -> has to be released */
+    if (MasterConnection_isRunning(self) == false)
+    {
+        MasterConnection_markPending(self, false);
+        return;
+    }
+
+    MasterConnection_scheduleTimer(self, false);
+}
+
+/* check if ASDUs can be sent immediately */
+static bool
+MasterConnection_hasDataToSend(MasterConnection self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->stateLock);
+#endif
+
+    bool canSend = (self->state == M_CON_STATE_STARTED) && (isSentBufferFull(self) == false);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->stateLock);
+#endif
+
+    if (canSend)
+    {
+        if (HighPriorityASDUQueue_isAsduAvailable(self->highPrioQueue) ||
+            MessageQueue_isAsduAvailable(self->lowPrioQueue) ||
+            (CS101_ResponseStreams_isEmpty(&(self->responseStreams)) == false))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static MasterConnection
 MasterConnection_create(CS104_Slave slave)
 {
@@ -3603,13 +4180,14 @@ MasterConnection_create(CS104_Slave slave)
         self->iMasterConnection.sendACT_TERM = _IMasterConnection_sendACT_TERM;
         self->iMasterConnection.close = _IMasterConnection_close;
         self->iMasterConnection.getPeerAddress = _IMasterConnection_getPeerAddress;
+        self->iMasterConnection.startResponse = _IMasterConnection_startResponse;
 
 #if (CONFIG_USE_THREADS == 1)
         self->connectionThread = NULL;
+        self->worker = NULL;
 #endif
 
 #if (CONFIG_USE_SEMAPHORES == 1)
-        self->sentASDUsLock = Semaphore_create(1);
         self->stateLock = Semaphore_create(1);
 #endif
         self->handleSet = Handleset_new();
@@ -3625,6 +4203,11 @@ MasterConnection_create(CS104_Slave slave)
 #endif
         self->lowPrioQueue = NULL;
         self->highPrioQueue = NULL;
+
+        CS101_ResponseStreams_initialize(&(self->responseStreams));
+
+        self->timers = NULL;
+        TimerWheelEntry_initialize(&(self->timeoutTimer), MasterConnection_handleTimer, self);
     }
 
     return self;
@@ -3636,7 +4219,8 @@ MasterConnection_init(MasterConnection self, Socket skt, MessageQueue lowPrioQue
     if (self)
     {
         self->socket = skt;
-        self->isRunning = false;
+
+        MasterConnection_stopRunning(self);
         self->receiveCount = 0;
         self->sendCount = 0;
         self->recvBufPos = 0;
@@ -3667,6 +4251,8 @@ MasterConnection_init(MasterConnection self, Socket skt, MessageQueue lowPrioQue
 
         self->timeoutT2Triggered = false;
 
+        CS104_AckScheduler_reset(&(self->ackScheduler), &(self->slave->conParameters), self->slave->adaptiveAck);
+
         self->oldestSentASDU = -1;
         self->newestSentASDU = -1;
 
@@ -3740,9 +4326,17 @@ MasterConnection_start(MasterConnection self)
         self->connectionThread = NULL;
     }
 
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->stateLock);
+#endif
+
     self->isRunning = true;
     self->state = M_CON_STATE_STOPPED;
 
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->stateLock);
+#endif
+
     self->connectionThread = Thread_create((ThreadExecutionFunction)connectionHandlingThread, (void*)self, false);
 
     Thread_start(self->connectionThread);
@@ -3762,6 +4356,9 @@ MasterConnection_close(MasterConnection self)
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_post(self->stateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
+
+    /* can be called by another thread - the closed connection has to be released by the event loop */
+    MasterConnection_markPending(self, true);
 }
 
 static bool
@@ -3838,141 +4435,298 @@ MasterConnection_handleTcpConnection(MasterConnection self)
     if (bytesRec < 0)
     {
         DEBUG_PRINT("CS104 SLAVE: Error reading from socket\n");
-        self->isRunning = false;
+        MasterConnection_stopRunning(self);
     }
 
-    if ((bytesRec > 0) && (self->isRunning))
+    if ((bytesRec > 0) && MasterConnection_isRunning(self))
     {
         if (self->slave->rawMessageHandler)
             self->slave->rawMessageHandler(self->slave->rawMessageHandlerParameter, &(self->iMasterConnection),
                                            self->recvBuffer, bytesRec, false);
 
         if (handleMessage(self, self->recvBuffer, bytesRec) == false)
-            self->isRunning = false;
+            MasterConnection_stopRunning(self);
 
-        if (self->unconfirmedReceivedIMessages >= self->slave->conParameters.w)
-        {
-            self->lastConfirmationTime = Hal_getMonotonicTimeInMs();
-
-            self->unconfirmedReceivedIMessages = 0;
+        checkAcknowledgement(self, true);
 
-            self->timeoutT2Triggered = false;
-
-            sendSMessage(self);
+        if (MasterConnection_isRunning(self))
+        {
+            /* the acknowledgement can be due when the pending I message cannot be sent */
+            MasterConnection_scheduleTimer(self, (self->unconfirmedReceivedIMessages > 0));
         }
     }
 }
 
+/* threadless mode and worker threads: send waiting ASDUs (the timeouts are handled by the timer of the connection) */
 static void
 MasterConnection_executePeriodicTasks(MasterConnection self)
 {
     if (self->state == M_CON_STATE_STARTED)
     {
         sendWaitingASDUs(self);
-    }
 
-    if (handleTimeouts(self) == false)
-    {
-        self->isRunning = false;
+        sendResponseStreams(self);
     }
+
+    /* an I message was sent -> T1 can start */
+    if (self->sendCount != self->timerSendCount)
+        MasterConnection_scheduleTimer(self, false);
+}
+
+static bool
+isThreadlessMode(CS104_Slave self)
+{
+#if (CONFIG_USE_THREADS == 1)
+    return self->isThreadlessMode;
+#else
+    UNUSED_PARAMETER(self);
+    return true;
+#endif
 }
 
+/*
+ * threadless mode: the connection has to be handled by CS104_Slave_executePeriodicTasks
+ * (received message, ASDU to send, closed connection)
+ *
+ * worker threads: the worker of the connection is woken up (the call can come from another thread)
+ */
 static void
-handleClientConnections(CS104_Slave self)
+MasterConnection_markPending(MasterConnection self, bool wakeup)
 {
-    HandleSet handleset = NULL;
+    CS104_Slave slave = self->slave;
 
-    if (self->openConnections > 0)
-    {
-        int i;
+#if (CONFIG_USE_THREADS == 1)
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->stateLock);
+#endif
 
-        bool first = true;
+    CS104_SlaveWorker worker = self->worker;
 
-        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
-        {
-            MasterConnection con = self->masterConnections[i];
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->stateLock);
+#endif
 
-            if (con && con->isUsed)
-            {
-                if (con->isRunning)
-                {
-                    if (first)
-                    {
-                        handleset = con->handleSet;
-                        Handleset_reset(handleset);
+    if (worker)
+    {
+        CS104_SlaveWorker_wakeup(worker);
+        return;
+    }
+#endif /* (CONFIG_USE_THREADS == 1) */
 
-                        first = false;
-                    }
+    if (isThreadlessMode(slave) == false)
+        return;
 
-                    Handleset_addSocket(handleset, con->socket);
-                }
-                else
-                {
-                    if (self->connectionEventHandler)
-                    {
-                        self->connectionEventHandler(self->connectionEventHandlerParameter, &(con->iMasterConnection),
-                                                     CS104_CON_EVENT_CONNECTION_CLOSED);
-                    }
+    bool wasEmpty;
 
-                    DEBUG_PRINT("CS104 SLAVE: Connection closed\n");
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(slave->pendingConnectionsLock);
+#endif
 
-                    self->masterConnections[i]->isUsed = false;
+    wasEmpty = (slave->numberOfPendingConnections == 0);
 
-                    MessageQueue_setWaitingForTransmissionWhenNotConfirmed(self->masterConnections[i]->lowPrioQueue);
+    if (self->isPending == false)
+    {
+        self->isPending = true;
+        slave->pendingConnections[slave->numberOfPendingConnections++] = self;
+    }
 
-                    self->openConnections--;
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(slave->pendingConnectionsLock);
+#endif
 
-                    MasterConnection_deinit(con);
-                }
-            }
-        }
+    if (wakeup && wasEmpty && slave->wakeupSignal)
+        WakeupSignal_set(slave->wakeupSignal);
+}
 
-        /* handle incoming messages when available */
-        if (handleset && Handleset_waitReady(handleset, 0))
-        {
-            for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
-            {
-                MasterConnection con = self->masterConnections[i];
+/* threadless mode: all connections have to be handled (ASDUs were enqueued in the shared queues) */
+static void
+markAllConnectionsPending(CS104_Slave self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->pendingConnectionsLock);
+#endif
 
-                if (con && con->isUsed)
-                    MasterConnection_handleTcpConnection(con);
-            }
-        }
+    self->allConnectionsPending = true;
 
-        /* handle periodic tasks for running connections */
-        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
-        {
-            MasterConnection con = self->masterConnections[i];
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->pendingConnectionsLock);
+#endif
+}
 
-            if (con && con->isUsed && con->isRunning)
-            {
-                MasterConnection_executePeriodicTasks(con);
+/*
+ * threadless mode: get and reset the pending connections
+ *
+ * \return the number of pending connections or -1 when all connections are pending
+ */
+static int
+takePendingConnections(CS104_Slave self, MasterConnection* connections)
+{
+    int count;
 
-                /* call plugins */
-                if (self->plugins)
-                {
-                    LinkedList pluginElem = LinkedList_getNext(self->plugins);
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->pendingConnectionsLock);
+#endif
 
-                    while (pluginElem)
-                    {
-                        CS101_SlavePlugin plugin = (CS101_SlavePlugin)LinkedList_getData(pluginElem);
+    count = self->numberOfPendingConnections;
 
-                        plugin->runTask(plugin->parameter, &(con->iMasterConnection));
+    int i;
 
-                        pluginElem = LinkedList_getNext(pluginElem);
-                    }
-                }
-            }
-        }
+    for (i = 0; i < count; i++)
+    {
+        connections[i] = self->pendingConnections[i];
+        connections[i]->isPending = false;
     }
-}
 
-static char*
-getPeerAddress(Socket socket, char* ipAddress)
-{
-    char* ipAddrStr = NULL;
+    self->numberOfPendingConnections = 0;
 
-    if (Socket_getPeerAddressStatic(socket, ipAddress))
+    if (self->allConnectionsPending)
+    {
+        self->allConnectionsPending = false;
+        count = -1;
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->pendingConnectionsLock);
+#endif
+
+    return count;
+}
+
+static bool
+hasPendingConnections(CS104_Slave self)
+{
+    bool hasPending;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->pendingConnectionsLock);
+#endif
+
+    hasPending = (self->numberOfPendingConnections > 0) || self->allConnectionsPending;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->pendingConnectionsLock);
+#endif
+
+    return hasPending;
+}
+
+/* threadless mode: release a connection that was closed */
+static void
+removeClosedConnection(CS104_Slave self, MasterConnection con)
+{
+    if (self->connectionEventHandler)
+    {
+        self->connectionEventHandler(self->connectionEventHandlerParameter, &(con->iMasterConnection),
+                                     CS104_CON_EVENT_CONNECTION_CLOSED);
+    }
+
+    DEBUG_PRINT("CS104 SLAVE: Connection closed\n");
+
+    con->isUsed = false;
+
+    MessageQueue_setWaitingForTransmissionWhenNotConfirmed(con->lowPrioQueue);
+
+    /* the unconfirmed ASDUs can be sent by the other connections of the redundancy group */
+    markAllConnectionsPending(self);
+
+    self->openConnections--;
+
+    MasterConnection_deinit(con);
+}
+
+/* threadless mode and worker threads: send waiting ASDUs and call the plugins */
+static void
+executePeriodicTasksThreadless(CS104_Slave self, MasterConnection con)
+{
+    MasterConnection_executePeriodicTasks(con);
+
+    /* call plugins */
+    if (self->plugins)
+    {
+        LinkedList pluginElem = LinkedList_getNext(self->plugins);
+
+        while (pluginElem)
+        {
+            CS101_SlavePlugin plugin = (CS101_SlavePlugin)LinkedList_getData(pluginElem);
+
+            plugin->runTask(plugin->parameter, &(con->iMasterConnection));
+
+            pluginElem = LinkedList_getNext(pluginElem);
+        }
+    }
+}
+
+static void
+handleClientConnections(CS104_Slave self)
+{
+    HandleSet handleset = NULL;
+
+    if (self->openConnections > 0)
+    {
+        int i;
+
+        bool first = true;
+
+        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
+        {
+            MasterConnection con = self->masterConnections[i];
+
+            if (con && con->isUsed)
+            {
+                if (MasterConnection_isRunning(con))
+                {
+                    if (first)
+                    {
+                        handleset = con->handleSet;
+                        Handleset_reset(handleset);
+
+                        first = false;
+                    }
+
+                    Handleset_addSocket(handleset, con->socket);
+                }
+                else
+                {
+                    removeClosedConnection(self, con);
+                }
+            }
+        }
+
+        /* handle incoming messages when available */
+        if (handleset && Handleset_waitReady(handleset, 0))
+        {
+            for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
+            {
+                MasterConnection con = self->masterConnections[i];
+
+                if (con && con->isUsed)
+                    MasterConnection_handleTcpConnection(con);
+            }
+        }
+
+        /* handle periodic tasks for running connections */
+        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
+        {
+            MasterConnection con = self->masterConnections[i];
+
+            if (con && con->isUsed && MasterConnection_isRunning(con))
+            {
+                executePeriodicTasksThreadless(self, con);
+            }
+        }
+    }
+
+    /* handle the expired timeouts */
+    if (self->connectionTimers)
+        TimerWheel_advance(self->connectionTimers, Hal_getMonotonicTimeInMs());
+}
+
+static char*
+getPeerAddress(Socket socket, char* ipAddress)
+{
+    char* ipAddrStr = NULL;
+
+    if (Socket_getPeerAddressStatic(socket, ipAddress))
     {
         /* remove TCP port part */
         if (ipAddress[0] == '[')
@@ -4003,6 +4757,10 @@ getPeerAddress(Socket socket, char* ipAddress)
 static bool
 callConnectionRequestHandler(CS104_Slave self, Socket newSocket)
 {
+    /* the address string is only required by the handler */
+    if (self->connectionRequestHandler == NULL)
+        return true;
+
     char ipAddress[60];
 
     char* ipAddrStr = getPeerAddress(newSocket, ipAddress);
@@ -4010,52 +4768,70 @@ callConnectionRequestHandler(CS104_Slave self, Socket newSocket)
     if (ipAddrStr == NULL)
         return false;
 
-    if (self->connectionRequestHandler)
-        return self->connectionRequestHandler(self->connectionRequestHandlerParameter, ipAddrStr);
-    else
-        return true;
+    return self->connectionRequestHandler(self->connectionRequestHandlerParameter, ipAddrStr);
 }
 
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
+/* NOTE: the caller has to hold openConnectionsLock */
 static CS104_RedundancyGroup
-getMatchingRedundancyGroup(CS104_Slave self, char* ipAddrStr)
+getMatchingRedundancyGroup(CS104_Slave self, const uint8_t* ipAddress, int ipAddressSize)
 {
-    struct sCS104_IPAddress ipAddress;
-    memset(&ipAddress, 0, sizeof(struct sCS104_IPAddress));
+    CS104_RedundancyGroup matchingGroup = NULL;
 
-    CS104_IPAddress_setFromString(&ipAddress, ipAddrStr);
+    /* the group with the longest matching allowed client prefix */
+    if (self->redundancyGroupTable)
+        matchingGroup = (CS104_RedundancyGroup)CS104_PrefixTable_lookup(self->redundancyGroupTable, ipAddress,
+                                                                        ipAddressSize);
 
-    CS104_RedundancyGroup catchAllGroup = NULL;
-    CS104_RedundancyGroup matchingGroup = NULL;
+    if (matchingGroup == NULL)
+        matchingGroup = self->catchAllGroup;
 
-    LinkedList element = LinkedList_getNext(self->redundancyGroups);
+    if (matchingGroup == NULL)
+    {
+        DEBUG_PRINT("CS104 SLAVE: Found no matching redundancy group -> close connection\n");
+    }
 
-    while (element)
+    return matchingGroup;
+}
+
+/* get the group of a new connection and assign a free connection object (connection is NULL on failure) */
+static MasterConnection
+getFreeConnectionForGroup(CS104_Slave self, Socket newSocket, const uint8_t* ipAddress, int ipAddressSize)
+{
+    MasterConnection connection = NULL;
+
+    CS104_RedundancyGroup matchingGroup = getMatchingRedundancyGroup(self, ipAddress, ipAddressSize);
+
+    if (matchingGroup)
     {
-        CS104_RedundancyGroup redGroup = (CS104_RedundancyGroup)LinkedList_getData(element);
+        connection = getFreeConnection(self);
 
-        if (CS104_RedundancyGroup_matches(redGroup, &ipAddress))
+        if (connection)
         {
-            matchingGroup = redGroup;
-            break;
-        }
-
-        if (CS104_RedundancyGroup_isCatchAll(redGroup))
-            catchAllGroup = redGroup;
+            if (MasterConnection_initEx(connection, newSocket, matchingGroup))
+            {
+                self->openConnections++;
 
-        element = LinkedList_getNext(element);
+                if (matchingGroup->name)
+                {
+                    DEBUG_PRINT("CS104 SLAVE: Add connection to group: %s\n", matchingGroup->name);
+                }
+            }
+            else
+            {
+                connection->isUsed = false;
+                connection = NULL;
+            }
+        }
     }
 
-    if (matchingGroup == NULL)
-        matchingGroup = catchAllGroup;
-
-    return matchingGroup;
+    return connection;
 }
 #endif /* (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1) */
 
 /* handle TCP connections in non-threaded mode */
 static void
-handleConnectionsThreadless(CS104_Slave self)
+acceptConnectionThreadless(CS104_Slave self)
 {
     if ((self->maxOpenConnections < 1) || (self->openConnections < self->maxOpenConnections))
     {
@@ -4086,48 +4862,21 @@ handleConnectionsThreadless(CS104_Slave self)
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
                 if (self->serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS)
                 {
-                    char ipAddress[60];
+                    uint8_t ipAddress[16];
 
-                    char* ipAddrStr = getPeerAddress(newSocket, ipAddress);
+                    int ipAddressSize = Socket_getPeerIpAddress(newSocket, ipAddress);
 
-                    if (ipAddrStr)
+                    if (ipAddressSize > 0)
                     {
-                        CS104_RedundancyGroup matchingGroup = getMatchingRedundancyGroup(self, ipAddrStr);
-
-                        if (matchingGroup)
-                        {
 #if (CONFIG_USE_SEMAPHORES)
-                            Semaphore_wait(self->openConnectionsLock);
+                        Semaphore_wait(self->openConnectionsLock);
 #endif
 
-                            connection = getFreeConnection(self);
-
-                            if (connection)
-                            {
-                                if (MasterConnection_initEx(connection, newSocket, matchingGroup))
-                                {
-                                    self->openConnections++;
-
-                                    if (matchingGroup->name)
-                                    {
-                                        DEBUG_PRINT("CS104 SLAVE: Add connection to group: %s\n", matchingGroup->name);
-                                    }
-                                }
-                                else
-                                {
-                                    connection->isUsed = false;
-                                    connection = NULL;
-                                }
-                            }
+                        connection = getFreeConnectionForGroup(self, newSocket, ipAddress, ipAddressSize);
 
 #if (CONFIG_USE_SEMAPHORES)
-                            Semaphore_post(self->openConnectionsLock);
+                        Semaphore_post(self->openConnectionsLock);
 #endif
-                        }
-                        else
-                        {
-                            DEBUG_PRINT("CS104 SLAVE: Found no matching redundancy group -> close connection\n");
-                        }
                     }
                     else
                     {
@@ -4173,8 +4922,20 @@ handleConnectionsThreadless(CS104_Slave self)
 
                 if (connection)
                 {
+#if (CONFIG_USE_SEMAPHORES == 1)
+                    Semaphore_wait(connection->stateLock);
+#endif
+
                     connection->isRunning = true;
 
+#if (CONFIG_USE_SEMAPHORES == 1)
+                    Semaphore_post(connection->stateLock);
+#endif
+
+                    connection->timers = self->connectionTimers;
+
+                    MasterConnection_scheduleTimer(connection, false);
+
                     if (self->connectionEventHandler)
                     {
                         self->connectionEventHandler(self->connectionEventHandlerParameter,
@@ -4194,209 +4955,639 @@ handleConnectionsThreadless(CS104_Slave self)
             }
         }
     }
+}
+
+static void
+handleConnectionsThreadless(CS104_Slave self)
+{
+    /* all connections are handled - the pending connections are only used by CS104_Slave_executePeriodicTasks */
+    MasterConnection connections[CONFIG_CS104_MAX_CLIENT_CONNECTIONS];
+
+    takePendingConnections(self, connections);
+
+    acceptConnectionThreadless(self);
 
     handleClientConnections(self);
 }
 
 #if (CONFIG_USE_THREADS == 1)
 
-static void*
-serverThread(void* parameter)
+/*
+ * check and initialize a new client connection - the socket is released when the connection is refused
+ *
+ * Called by the server thread or by the worker threads with own server socket (at the same time).
+ */
+static MasterConnection
+CS104_Slave_acceptConnection(CS104_Slave self, Socket newSocket)
 {
-    CS104_Slave self = (CS104_Slave)parameter;
-
-    if (self->localAddress)
-        self->serverSocket = TcpServerSocket_create(self->localAddress, self->tcpPort);
-    else
-        self->serverSocket = TcpServerSocket_create("0.0.0.0", self->tcpPort);
+    bool acceptConnection = true;
 
-    if (self->serverSocket == NULL)
+    /* don't call the request handler when the maximum number of open connections is reached (checked again below) */
+    if (self->maxOpenConnections > 0)
     {
-        DEBUG_PRINT("CS104 SLAVE: Cannot create server socket\n");
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-        Semaphore_wait(self->stateLock);
-#endif
-        self->isStarting = false;
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-        Semaphore_post(self->stateLock);
-#endif
-
-        goto exit_function;
+        if (CS104_Slave_getOpenConnections(self) >= self->maxOpenConnections)
+            acceptConnection = false;
     }
 
-    ServerSocket_listen(self->serverSocket);
+    if (acceptConnection)
+        acceptConnection = callConnectionRequestHandler(self, newSocket);
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_wait(self->stateLock);
-#endif
+    MasterConnection connection = NULL;
 
-    self->isRunning = true;
-    self->isStarting = false;
+    if (acceptConnection)
+    {
+        MessageQueue lowPrioQueue = NULL;
+        HighPriorityASDUQueue highPrioQueue = NULL;
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-    Semaphore_post(self->stateLock);
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
+        if (self->serverMode == CS104_MODE_SINGLE_REDUNDANCY_GROUP)
+        {
+            lowPrioQueue = self->asduQueue;
+            highPrioQueue = self->connectionAsduQueue;
+        }
 #endif
 
-    while (isStopRunningSet(self) == false)
-    {
-        Socket newSocket = ServerSocket_accept(self->serverSocket);
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
+        uint8_t ipAddress[16];
+        int ipAddressSize = 0;
 
-        if (newSocket)
+        if (self->serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS)
         {
-            bool acceptConnection = true;
+            ipAddressSize = Socket_getPeerIpAddress(newSocket, ipAddress);
 
-            /* check if maximum number of open connections is reached */
-            if (self->maxOpenConnections > 0)
+            if (ipAddressSize == 0)
             {
-                if (CS104_Slave_getOpenConnections(self) >= self->maxOpenConnections)
-                    acceptConnection = false;
+                DEBUG_PRINT("CS104 SLAVE: cannot determine peer IP address -> close connection\n");
+                acceptConnection = false;
             }
-
-            if (acceptConnection)
-                acceptConnection = callConnectionRequestHandler(self, newSocket);
-
-            if (acceptConnection)
-            {
-                MessageQueue lowPrioQueue = NULL;
-                HighPriorityASDUQueue highPrioQueue = NULL;
-
-#if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
-                if (self->serverMode == CS104_MODE_SINGLE_REDUNDANCY_GROUP)
-                {
-                    lowPrioQueue = self->asduQueue;
-                    highPrioQueue = self->connectionAsduQueue;
-                }
+        }
 #endif
 
-#if (CONFIG_CS104_SUPPORT_SERVER_MODE_CONNECTION_IS_REDUNDANCY_GROUP == 1)
-                if (self->serverMode == CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP)
-                {
-                    lowPrioQueue = NULL;
-                    highPrioQueue = NULL;
-                }
+#if (CONFIG_USE_SEMAPHORES)
+        Semaphore_wait(self->openConnectionsLock);
 #endif
 
-                MasterConnection connection = NULL;
+        /* checked with the lock held - several workers can accept connections at the same time */
+        if ((self->maxOpenConnections > 0) && (self->openConnections >= self->maxOpenConnections))
+            acceptConnection = false;
 
+        if (acceptConnection)
+        {
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
-                if (self->serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS)
-                {
-                    char ipAddress[60];
-
-                    char* ipAddrStr = getPeerAddress(newSocket, ipAddress);
-
-                    if (ipAddrStr)
-                    {
-                        CS104_RedundancyGroup matchingGroup = getMatchingRedundancyGroup(self, ipAddrStr);
-
-                        if (matchingGroup)
-                        {
-#if (CONFIG_USE_SEMAPHORES)
-                            Semaphore_wait(self->openConnectionsLock);
+            if (self->serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS)
+            {
+                connection = getFreeConnectionForGroup(self, newSocket, ipAddress, ipAddressSize);
+            }
+            else
 #endif
+            {
+                connection = getFreeConnection(self);
 
-                            connection = getFreeConnection(self);
-
-                            if (connection)
-                            {
-                                if (MasterConnection_initEx(connection, newSocket, matchingGroup))
-                                {
-                                    self->openConnections++;
-
-                                    if (matchingGroup->name)
-                                    {
-                                        DEBUG_PRINT("CS104 SLAVE: Add connection to group: %s\n", matchingGroup->name);
-                                    }
-                                }
-                                else
-                                {
-                                    connection->isUsed = false;
-                                    connection = NULL;
-                                }
-                            }
-
-#if (CONFIG_USE_SEMAPHORES)
-                            Semaphore_post(self->openConnectionsLock);
-#endif
-                        }
-                        else
-                        {
-                            DEBUG_PRINT("CS104 SLAVE: Found no matching redundancy group -> close connection\n");
-                        }
+                if (connection)
+                {
+                    if (MasterConnection_init(connection, newSocket, lowPrioQueue, highPrioQueue))
+                    {
+                        self->openConnections++;
                     }
                     else
                     {
-                        DEBUG_PRINT("CS104 SLAVE: cannot determine peer IP address -> close connection\n");
+                        connection->isUsed = false;
+                        connection = NULL;
                     }
                 }
-                else
-                {
+            }
+        }
+
 #if (CONFIG_USE_SEMAPHORES)
-                    Semaphore_wait(self->openConnectionsLock);
+        Semaphore_post(self->openConnectionsLock);
 #endif
 
-                    connection = getFreeConnection(self);
+        if (connection == NULL)
+        {
+            DEBUG_PRINT("CS104 SLAVE: Connection attempt failed!\n");
+        }
+    }
 
-                    if (connection)
-                    {
-                        if (MasterConnection_init(connection, newSocket, lowPrioQueue, highPrioQueue))
-                        {
-                            self->openConnections++;
-                        }
-                        else
-                        {
-                            connection->isUsed = false;
-                            connection = NULL;
-                        }
-                    }
+    if (connection == NULL)
+        Socket_destroy(newSocket);
+
+    return connection;
+}
+
+/* max. time (in ms) a worker thread waits when plugins are installed (the plugin tasks are polled) */
+#define CS104_WORKER_PLUGIN_TASK_INTERVAL 10
+
+/* max. number of connections a worker with own server socket accepts before it handles the other connections */
+#define CS104_WORKER_MAX_ACCEPTS 32
+
+static bool
+CS104_SlaveWorker_isRunning(CS104_SlaveWorker self)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    bool running = self->running;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return running;
+}
+
+/* mark a connection as handled by the worker (the connection is not released by the server thread) */
+static void
+CS104_SlaveWorker_attachConnection(CS104_SlaveWorker self, MasterConnection connection)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(connection->stateLock);
+#endif
+
+    connection->isRunning = true;
+    connection->state = M_CON_STATE_STOPPED;
+    connection->worker = self;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(connection->stateLock);
+#endif
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    self->numberOfConnections++;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+}
+
+/* server thread: pass a new connection to the worker with the fewest connections */
+static void
+CS104_Slave_assignConnectionToWorker(CS104_Slave self, MasterConnection connection)
+{
+    CS104_SlaveWorker worker = NULL;
+    int workerIndex = 0;
+    int minConnections = 0;
+
+    int i;
+
+    /* start with the next worker -> round-robin when all workers have the same number of connections */
+    for (i = 0; i < self->numberOfWorkers; i++)
+    {
+        int index = (self->nextWorker + i) % self->numberOfWorkers;
+
+        CS104_SlaveWorker candidate = self->workers[index];
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_wait(candidate->lock);
+#endif
+
+        int numberOfConnections = candidate->numberOfConnections;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_post(candidate->lock);
+#endif
+
+        if ((worker == NULL) || (numberOfConnections < minConnections))
+        {
+            worker = candidate;
+            workerIndex = index;
+            minConnections = numberOfConnections;
+        }
+    }
+
+    self->nextWorker = (workerIndex + 1) % self->numberOfWorkers;
+
+    CS104_SlaveWorker_attachConnection(worker, connection);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(worker->lock);
+#endif
+
+    LinkedList_add(worker->newConnections, connection);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(worker->lock);
+#endif
+
+    CS104_SlaveWorker_wakeup(worker);
+}
+
+/* worker thread: get the next connection that was assigned by the server thread */
+static MasterConnection
+CS104_SlaveWorker_getNewConnection(CS104_SlaveWorker self)
+{
+    MasterConnection connection = NULL;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    LinkedList element = LinkedList_getNext(self->newConnections);
+
+    if (element)
+    {
+        connection = (MasterConnection)LinkedList_getData(element);
+
+        LinkedList_remove(self->newConnections, connection);
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+    return connection;
+}
+
+/* worker thread: start handling a new connection */
+static void
+CS104_SlaveWorker_openConnection(CS104_SlaveWorker self, MasterConnection con, LinkedList connections,
+                                 TimerWheel timers)
+{
+    CS104_Slave slave = self->slave;
+
+    LinkedList_add(connections, con);
+
+    con->timers = timers;
+
+    resetT3Timeout(con, Hal_getMonotonicTimeInMs());
+
+    if (slave->connectionEventHandler)
+    {
+        slave->connectionEventHandler(slave->connectionEventHandlerParameter, &(con->iMasterConnection),
+                                      CS104_CON_EVENT_CONNECTION_OPENED);
+    }
+
+    MasterConnection_scheduleTimer(con, false);
+}
+
+/*
+ * worker thread: stop handling a closed connection
+ *
+ * The connection is passed back to the server thread that releases the socket (see serverThread).
+ */
+static void
+CS104_SlaveWorker_closeConnection(CS104_SlaveWorker self, MasterConnection con, LinkedList connections)
+{
+    CS104_Slave slave = self->slave;
+
+    /* abort the streamed responses before the application is informed about the closed connection */
+    CS101_ResponseStreams_clear(&(con->responseStreams), &(con->iMasterConnection));
+
+    if (slave->connectionEventHandler)
+    {
+        slave->connectionEventHandler(slave->connectionEventHandlerParameter, &(con->iMasterConnection),
+                                      CS104_CON_EVENT_CONNECTION_CLOSED);
+    }
+
+    DEBUG_PRINT("CS104 SLAVE: Connection closed\n");
+
+    MessageQueue_setWaitingForTransmissionWhenNotConfirmed(con->lowPrioQueue);
+
+    if (con->timers)
+    {
+        TimerWheel_cancel(con->timers, &(con->timeoutTimer));
+        con->timers = NULL;
+    }
+
+    LinkedList_remove(connections, con);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->lock);
+#endif
+
+    self->numberOfConnections--;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->lock);
+#endif
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(con->stateLock);
+#endif
+
+    con->isRunning = false;
+    con->worker = NULL;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(con->stateLock);
+#endif
+}
+
+/* worker thread: accept the pending connections of the own server socket (listener per worker mode) */
+static void
+CS104_SlaveWorker_acceptConnections(CS104_SlaveWorker self, LinkedList connections, TimerWheel timers)
+{
+    int i;
+
+    for (i = 0; i < CS104_WORKER_MAX_ACCEPTS; i++)
+    {
+        Socket newSocket = ServerSocket_accept(self->serverSocket);
+
+        if (newSocket == NULL)
+            break;
+
+        MasterConnection con = CS104_Slave_acceptConnection(self->slave, newSocket);
+
+        if (con)
+        {
+            CS104_SlaveWorker_attachConnection(self, con);
+            CS104_SlaveWorker_openConnection(self, con, connections, timers);
+        }
+    }
+}
+
+/* worker thread: close all connections that are no longer running (or all connections) */
+static void
+CS104_SlaveWorker_closeConnections(CS104_SlaveWorker self, LinkedList connections, bool closeAll)
+{
+    LinkedList element = LinkedList_getNext(connections);
+
+    while (element)
+    {
+        MasterConnection con = (MasterConnection)LinkedList_getData(element);
+
+        /* the element is released when the connection is removed */
+        element = LinkedList_getNext(element);
+
+        if (closeAll || (MasterConnection_isRunning(con) == false))
+            CS104_SlaveWorker_closeConnection(self, con, connections);
+    }
+}
+
+static void*
+CS104_SlaveWorker_thread(void* parameter)
+{
+    CS104_SlaveWorker self = (CS104_SlaveWorker)parameter;
+    CS104_Slave slave = self->slave;
+
+    /* bind the thread before the data structures of the worker are allocated (NUMA first touch) */
+    if (self->cpu != -1)
+    {
+        if (Thread_setCpuAffinity(self->cpu) == false)
+        {
+            DEBUG_PRINT("CS104 SLAVE: Failed to bind worker thread to CPU %i\n", self->cpu);
+        }
+    }
+
+    LinkedList connections = LinkedList_create();
+    TimerWheel timers = TimerWheel_create(256, 1, Hal_getMonotonicTimeInMs());
+    HandleSet handleSet = Handleset_new();
+
+    while (CS104_SlaveWorker_isRunning(self))
+    {
+        MasterConnection con;
+        LinkedList element;
+
+        /* reset before the checks - a wakeup after the checks interrupts the wait */
+        CS104_SlaveWorker_resetWakeup(self);
+
+        while ((con = CS104_SlaveWorker_getNewConnection(self)) != NULL)
+            CS104_SlaveWorker_openConnection(self, con, connections, timers);
+
+        /* without plugins the worker waits for the next timeout or a wakeup */
+        int waitTime = (slave->plugins) ? CS104_WORKER_PLUGIN_TASK_INTERVAL : INT_MAX;
+
+        Handleset_reset(handleSet);
+
+        Handleset_addWakeupSignal(handleSet, self->wakeupSignal);
+
+        if (self->serverSocket)
+            Handleset_addSocket(handleSet, (Socket)self->serverSocket);
+
+        for (element = LinkedList_getNext(connections); element; element = LinkedList_getNext(element))
+        {
+            con = (MasterConnection)LinkedList_getData(element);
+
+            if (MasterConnection_isRunning(con))
+            {
+                Handleset_addSocket(handleSet, con->socket);
+
+                /* only have a short look for received messages when ASDUs are waiting */
+                if (MasterConnection_hasDataToSend(con))
+                    waitTime = 0;
+            }
+        }
+
+        waitTime = TimerWheel_getNextTimeout(timers, Hal_getMonotonicTimeInMs(), waitTime);
+
+        if (Handleset_waitReady(handleSet, waitTime) > 0)
+        {
+            for (element = LinkedList_getNext(connections); element; element = LinkedList_getNext(element))
+            {
+                con = (MasterConnection)LinkedList_getData(element);
+
+                if (MasterConnection_isRunning(con))
+                    MasterConnection_handleTcpConnection(con);
+            }
+
+            /* new connections are added at the end of the list (not handled before the next iteration) */
+            if (self->serverSocket)
+                CS104_SlaveWorker_acceptConnections(self, connections, timers);
+        }
+
+        for (element = LinkedList_getNext(connections); element; element = LinkedList_getNext(element))
+        {
+            con = (MasterConnection)LinkedList_getData(element);
+
+            if (MasterConnection_isRunning(con))
+                executePeriodicTasksThreadless(slave, con);
+        }
+
+        /* handle the expired timeouts */
+        TimerWheel_advance(timers, Hal_getMonotonicTimeInMs());
+
+        CS104_SlaveWorker_closeConnections(self, connections, false);
+    }
+
+    /* the slave is stopped (the server thread doesn't assign new connections any more) */
+    MasterConnection con;
+
+    while ((con = CS104_SlaveWorker_getNewConnection(self)) != NULL)
+        CS104_SlaveWorker_openConnection(self, con, connections, timers);
+
+    CS104_SlaveWorker_closeConnections(self, connections, true);
+
+    Handleset_destroy(handleSet);
+    TimerWheel_destroy(timers);
+    LinkedList_destroyStatic(connections);
+
+    return NULL;
+}
+
+static void
+startWorkers(CS104_Slave self)
+{
+    int i;
+
+    for (i = 0; i < self->numberOfWorkers; i++)
+    {
+        CS104_SlaveWorker worker = self->workers[i];
+
+        worker->running = true;
+        worker->numberOfConnections = 0;
+
+        worker->thread = Thread_create(CS104_SlaveWorker_thread, (void*)worker, false);
+
+        Thread_start(worker->thread);
+    }
+
+    self->nextWorker = 0;
+}
+
+/* stop the worker threads (the workers close their connections before they terminate) */
+static void
+stopWorkers(CS104_Slave self)
+{
+    int i;
+
+    for (i = 0; i < self->numberOfWorkers; i++)
+    {
+        CS104_SlaveWorker worker = self->workers[i];
+
+        if (worker->thread)
+        {
+#if (CONFIG_USE_SEMAPHORES == 1)
+            Semaphore_wait(worker->lock);
+#endif
+
+            worker->running = false;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+            Semaphore_post(worker->lock);
+#endif
+
+            CS104_SlaveWorker_wakeup(worker);
+
+            Thread_destroy(worker->thread);
+            worker->thread = NULL;
+        }
+
+        if (worker->serverSocket)
+        {
+            ServerSocket_destroy(worker->serverSocket);
+            worker->serverSocket = NULL;
+        }
+    }
+}
+
+/*
+ * create a server socket for each worker that shares the TCP port with the other workers
+ *
+ * \return false when the sockets cannot be created (e.g. SO_REUSEPORT not supported)
+ */
+static bool
+createWorkerServerSockets(CS104_Slave self, const char* localAddress)
+{
+    int i;
+
+    for (i = 0; i < self->numberOfWorkers; i++)
+    {
+        CS104_SlaveWorker worker = self->workers[i];
+
+        worker->serverSocket = TcpServerSocket_createEx(localAddress, self->tcpPort, true);
+
+        if (worker->serverSocket == NULL)
+        {
+            while (i > 0)
+            {
+                i--;
+                ServerSocket_destroy(self->workers[i]->serverSocket);
+                self->workers[i]->serverSocket = NULL;
+            }
+
+            return false;
+        }
+
+        ServerSocket_setBacklog(worker->serverSocket, CONFIG_CS104_MAX_CLIENT_CONNECTIONS);
+        ServerSocket_listen(worker->serverSocket);
+    }
+
+    return true;
+}
+
+static void*
+serverThread(void* parameter)
+{
+    CS104_Slave self = (CS104_Slave)parameter;
+
+    const char* localAddress = self->localAddress ? self->localAddress : "0.0.0.0";
+
+    bool listenerPerWorker = false;
+
+    if (self->workers && self->listenerPerWorker)
+    {
+        listenerPerWorker = createWorkerServerSockets(self, localAddress);
+
+        if (listenerPerWorker == false)
+        {
+            DEBUG_PRINT("CS104 SLAVE: Cannot create server socket per worker -> use single server socket\n");
+        }
+    }
+
+    if (listenerPerWorker)
+        self->serverSocket = NULL;
+    else
+        self->serverSocket = TcpServerSocket_create(localAddress, self->tcpPort);
 
-#if (CONFIG_USE_SEMAPHORES)
-                    Semaphore_post(self->openConnectionsLock);
+    if ((listenerPerWorker == false) && (self->serverSocket == NULL))
+    {
+        DEBUG_PRINT("CS104 SLAVE: Cannot create server socket\n");
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_wait(self->stateLock);
 #endif
-                }
-#else
+        self->isStarting = false;
 
-#if (CONFIG_USE_SEMAPHORES)
-                Semaphore_wait(self->openConnectionsLock);
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_post(self->stateLock);
 #endif
-                connection = getFreeConnection(self);
 
-                if (connection)
-                {
-                    if (MasterConnection_init(connection, newSocket, lowPrioQueue, highPrioQueue))
-                    {
-                        self->openConnections++;
-                    }
-                    else
-                    {
-                        connection->isUsed = false;
-                        connection = NULL;
-                    }
-                }
+        goto exit_function;
+    }
 
-#if (CONFIG_USE_SEMAPHORES)
-                Semaphore_post(self->openConnectionsLock);
+    if (self->serverSocket)
+    {
+        /* queue the connection requests of many clients that reconnect at the same time */
+        ServerSocket_setBacklog(self->serverSocket, CONFIG_CS104_MAX_CLIENT_CONNECTIONS);
+        ServerSocket_listen(self->serverSocket);
+    }
+
+    /* the workers are started after the server sockets are created (listener per worker mode) */
+    startWorkers(self);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->stateLock);
 #endif
 
-#endif /* (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1) */
+    self->isRunning = true;
+    self->isStarting = false;
 
-                if (connection)
-                {
-                    /* now start the connection handling (thread) */
-                    MasterConnection_start(connection);
-                }
-                else
-                {
-                    Socket_destroy(newSocket);
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->stateLock);
+#endif
 
-                    DEBUG_PRINT("CS104 SLAVE: Connection attempt failed!\n");
-                }
-            }
-            else
+    while (isStopRunningSet(self) == false)
+    {
+        Socket newSocket = NULL;
+
+        /* in listener per worker mode the worker threads accept the connections */
+        if (self->serverSocket)
+            newSocket = ServerSocket_accept(self->serverSocket);
+
+        if (newSocket)
+        {
+            MasterConnection connection = CS104_Slave_acceptConnection(self, newSocket);
+
+            if (connection)
             {
-                Socket_destroy(newSocket);
+                /* now start the connection handling (worker thread or connection thread) */
+                if (self->workers)
+                    CS104_Slave_assignConnectionToWorker(self, connection);
+                else
+                    MasterConnection_start(connection);
             }
         }
         else
@@ -4421,11 +5612,14 @@ serverThread(void* parameter)
 
                 bool isConnectionUsed = connection->isUsed;
 
+                /* the connection is released by the worker thread first */
+                bool isHandledByWorker = (connection->worker != NULL);
+
 #if (CONFIG_USE_SEMAPHORES == 1)
                 Semaphore_post(connection->stateLock);
 #endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-                if (isConnectionUsed)
+                if (isConnectionUsed && (isHandledByWorker == false))
                 {
                     if (MasterConnection_isRunning(connection) == false)
                     {
@@ -4468,7 +5662,10 @@ serverThread(void* parameter)
     }
 
     if (self->serverSocket)
+    {
         Socket_destroy((Socket)self->serverSocket);
+        self->serverSocket = NULL;
+    }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_wait(self->stateLock);
@@ -4543,6 +5740,20 @@ CS104_Slave_enqueueASDU(CS104_Slave self, CS101_ASDU asdu)
 #endif
     }
 #endif /* (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1) */
+
+    /* threadless mode: the event loop of the application has to send the ASDU */
+    if (isThreadlessMode(self))
+    {
+        markAllConnectionsPending(self);
+
+        if (self->wakeupSignal)
+            WakeupSignal_set(self->wakeupSignal);
+    }
+
+#if (CONFIG_USE_THREADS == 1)
+    /* the connections of all workers can use the shared queues */
+    wakeupWorkers(self);
+#endif
 }
 
 void
@@ -4555,12 +5766,101 @@ CS104_Slave_addRedundancyGroup(CS104_Slave self, CS104_RedundancyGroup redundanc
             self->redundancyGroups = LinkedList_create();
 
         LinkedList_add(self->redundancyGroups, redundancyGroup);
+
+        redundancyGroup->slave = self;
     }
 
 #endif /* (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1) */
 }
 
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
+/*
+ * Add the allowed clients of all groups to the prefix table that is used to find the group of a new connection.
+ * Groups are added in the order they were added to the slave - for identical prefixes the first group is used.
+ * The last group without allowed clients is used for all other clients.
+ *
+ * NOTE: the caller has to hold openConnectionsLock when the slave is running
+ */
+static void
+buildRedundancyGroupTable(CS104_Slave self)
+{
+    CS104_PrefixTable table = CS104_PrefixTable_create();
+
+    if (table == NULL)
+    {
+        DEBUG_PRINT("CS104 SLAVE: Failed to allocate memory for redundancy group table\n");
+        return;
+    }
+
+    CS104_RedundancyGroup catchAllGroup = NULL;
+
+    LinkedList element = LinkedList_getNext(self->redundancyGroups);
+
+    while (element)
+    {
+        CS104_RedundancyGroup redGroup = (CS104_RedundancyGroup)LinkedList_getData(element);
+
+        if (CS104_RedundancyGroup_isCatchAll(redGroup))
+        {
+            catchAllGroup = redGroup;
+        }
+        else
+        {
+            LinkedList clientElement = LinkedList_getNext(redGroup->allowedClients);
+
+            while (clientElement)
+            {
+                CS104_IPAddress ipAddr = (CS104_IPAddress)LinkedList_getData(clientElement);
+
+                int size = (ipAddr->type == IP_ADDRESS_TYPE_IPV4) ? 4 : 16;
+
+                if (CS104_PrefixTable_add(table, ipAddr->address, size, ipAddr->prefixLength, redGroup) == false)
+                {
+                    /* keep the old table */
+                    DEBUG_PRINT("CS104 SLAVE: Failed to add allowed client to redundancy group table\n");
+
+                    CS104_PrefixTable_destroy(table);
+                    return;
+                }
+
+                clientElement = LinkedList_getNext(clientElement);
+            }
+        }
+
+        element = LinkedList_getNext(element);
+    }
+
+    CS104_PrefixTable_destroy(self->redundancyGroupTable);
+
+    self->redundancyGroupTable = table;
+    self->catchAllGroup = catchAllGroup;
+}
+
+/* add an allowed client to a group of the slave (the slave can be running) */
+static void
+CS104_Slave_addAllowedClientToGroup(CS104_Slave self, CS104_RedundancyGroup group, CS104_IPAddress ipAddr)
+{
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->openConnectionsLock);
+#endif
+
+    if (group->allowedClients == NULL)
+        group->allowedClients = LinkedList_create();
+
+    LinkedList_add(group->allowedClients, ipAddr);
+
+    /* the table is built when the slave is started */
+    if (self->redundancyGroupTable)
+    {
+        /* rebuild - the group can change from catch-all group to group with allowed clients */
+        buildRedundancyGroupTable(self);
+    }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->openConnectionsLock);
+#endif
+}
+
 static void
 initializeRedundancyGroups(CS104_Slave self, int lowPrioMaxQueueSize, int highPrioMaxQueueSize)
 {
@@ -4581,6 +5881,16 @@ initializeRedundancyGroups(CS104_Slave self, int lowPrioMaxQueueSize, int highPr
 
         element = LinkedList_getNext(element);
     }
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->openConnectionsLock);
+#endif
+
+    buildRedundancyGroupTable(self);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->openConnectionsLock);
+#endif
 }
 #endif /* (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1) */
 
@@ -4664,6 +5974,13 @@ CS104_Slave_startThreadless(CS104_Slave self)
         self->isThreadlessMode = true;
 #endif
 
+        if (self->connectionTimers == NULL)
+            self->connectionTimers = TimerWheel_create(256, 1, Hal_getMonotonicTimeInMs());
+
+        /* kept until the slave is destroyed - CS104_Slave_enqueueASDU can be called by other threads */
+        if (self->wakeupSignal == NULL)
+            self->wakeupSignal = WakeupSignal_create();
+
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
         if (self->serverMode == CS104_MODE_SINGLE_REDUNDANCY_GROUP)
             initializeMessageQueues(self, self->maxLowPrioQueueSize, self->maxHighPrioQueueSize);
@@ -4737,6 +6054,16 @@ CS104_Slave_stopThreadless(CS104_Slave self)
 #endif
 
     CS104_Slave_closeAllConnections(self);
+
+    if (self->connectionTimers)
+    {
+        TimerWheel_destroy(self->connectionTimers);
+        self->connectionTimers = NULL;
+    }
+
+    MasterConnection connections[CONFIG_CS104_MAX_CLIENT_CONNECTIONS];
+
+    takePendingConnections(self, connections);
 }
 
 void
@@ -4745,6 +6072,162 @@ CS104_Slave_tick(CS104_Slave self)
     handleConnectionsThreadless(self);
 }
 
+int
+CS104_Slave_getPollFds(CS104_Slave self, int* fds, int maxFds)
+{
+    int numberOfFds = 0;
+
+    if (self->serverSocket == NULL)
+        return 0;
+
+    if (numberOfFds < maxFds)
+        fds[numberOfFds] = ServerSocket_getFd(self->serverSocket);
+
+    numberOfFds++;
+
+    if (self->wakeupSignal)
+    {
+        if (numberOfFds < maxFds)
+            fds[numberOfFds] = WakeupSignal_getFd(self->wakeupSignal);
+
+        numberOfFds++;
+    }
+
+    int i;
+
+    for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
+    {
+        MasterConnection con = self->masterConnections[i];
+
+        if (con && con->isUsed && con->socket && MasterConnection_isRunning(con))
+        {
+            if (numberOfFds < maxFds)
+                fds[numberOfFds] = Socket_getFd(con->socket);
+
+            numberOfFds++;
+        }
+    }
+
+    return numberOfFds;
+}
+
+int
+CS104_Slave_getNextTimeoutMs(CS104_Slave self, int maxTimeoutMs)
+{
+    int timeout = maxTimeoutMs;
+
+    if (self->serverSocket == NULL)
+        return timeout;
+
+    /* plugins have no deadlines -> poll them regularly */
+    if (self->plugins && (timeout > CS104_SLAVE_PLUGIN_POLL_INTERVAL))
+        timeout = CS104_SLAVE_PLUGIN_POLL_INTERVAL;
+
+    /* ASDUs can be sent or a closed connection has to be released */
+    if (hasPendingConnections(self))
+        return 0;
+
+    /* timeouts of the connections */
+    if (self->connectionTimers)
+        timeout = TimerWheel_getNextTimeout(self->connectionTimers, Hal_getMonotonicTimeInMs(), timeout);
+
+    return timeout;
+}
+
+void
+CS104_Slave_handleReady(CS104_Slave self, int fd, int events)
+{
+    if ((self->serverSocket == NULL) || (fd < 0) || (events == 0))
+        return;
+
+    if (fd == ServerSocket_getFd(self->serverSocket))
+    {
+        acceptConnectionThreadless(self);
+        return;
+    }
+
+    /* ASDUs were enqueued -> they are sent by CS104_Slave_executePeriodicTasks */
+    if (self->wakeupSignal && (fd == WakeupSignal_getFd(self->wakeupSignal)))
+    {
+        WakeupSignal_reset(self->wakeupSignal);
+        return;
+    }
+
+    int i;
+
+    for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
+    {
+        MasterConnection con = self->masterConnections[i];
+
+        if (con && con->isUsed && con->socket && (Socket_getFd(con->socket) == fd) && MasterConnection_isRunning(con))
+        {
+            if (events & CS104_SLAVE_FD_ERROR)
+            {
+                DEBUG_PRINT("CS104 SLAVE: Socket error\n");
+                MasterConnection_stopRunning(con);
+            }
+            else
+                MasterConnection_handleTcpConnection(con);
+
+            /* the received message can allow to send ASDUs (STARTDT, confirmation) or close the connection */
+            MasterConnection_markPending(con, false);
+
+            break;
+        }
+    }
+}
+
+void
+CS104_Slave_executePeriodicTasks(CS104_Slave self)
+{
+    MasterConnection connections[CONFIG_CS104_MAX_CLIENT_CONNECTIONS];
+
+    int numberOfConnections = takePendingConnections(self, connections);
+
+    int i;
+
+    /* ASDUs were enqueued in the shared queues or plugins are installed (plugins are polled) */
+    if ((numberOfConnections == -1) || self->plugins)
+    {
+        numberOfConnections = 0;
+
+        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
+        {
+            MasterConnection con = self->masterConnections[i];
+
+            if (con && con->isUsed)
+                connections[numberOfConnections++] = con;
+        }
+    }
+
+    for (i = 0; i < numberOfConnections; i++)
+    {
+        MasterConnection con = connections[i];
+
+        if (con->isUsed && MasterConnection_isRunning(con))
+        {
+            executePeriodicTasksThreadless(self, con);
+
+            /* only one low priority ASDU is sent per call */
+            if (MasterConnection_isRunning(con) && MasterConnection_hasDataToSend(con))
+                MasterConnection_markPending(con, false);
+        }
+    }
+
+    /* handle the expired timeouts (connections closed by a timeout are pending) */
+    if (self->connectionTimers)
+        TimerWheel_advance(self->connectionTimers, Hal_getMonotonicTimeInMs());
+
+    for (i = 0; i < numberOfConnections; i++)
+    {
+        MasterConnection con = connections[i];
+
+        /* the connection can be closed by the received message or the periodic tasks */
+        if (con->isUsed && (MasterConnection_isRunning(con) == false))
+            removeClosedConnection(self, con);
+    }
+}
+
 bool
 CS104_Slave_isRunning(CS104_Slave self)
 {
@@ -4783,6 +6266,8 @@ CS104_Slave_stop(CS104_Slave self)
             Thread_destroy(self->listeningThread);
         }
 
+        stopWorkers(self);
+
         /*
          * Stop all connections
          * */
@@ -4831,6 +6316,11 @@ CS104_Slave_stop(CS104_Slave self)
 
                             connection->connectionThread = NULL;
                         }
+                        else
+                        {
+                            /* connection of a worker thread (already closed by the worker) */
+                            MasterConnection_deinit(connection);
+                        }
 #endif /* (CONFIG_USE_THREADS == 1) */
 
                         self->openConnections--;
@@ -4869,6 +6359,7 @@ CS104_Slave_destroy(CS104_Slave self)
 #if (CONFIG_USE_SEMAPHORES == 1)
         Semaphore_destroy(self->openConnectionsLock);
         Semaphore_destroy(self->stateLock);
+        Semaphore_destroy(self->pendingConnectionsLock);
 #endif
 
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
@@ -4888,6 +6379,8 @@ CS104_Slave_destroy(CS104_Slave self)
                                        (LinkedListValueDeleteFunction)CS104_RedundancyGroup_destroy);
         }
 
+        CS104_PrefixTable_destroy(self->redundancyGroupTable);
+
 #endif /* (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1) */
 
         {
@@ -4908,6 +6401,16 @@ CS104_Slave_destroy(CS104_Slave self)
             LinkedList_destroyStatic(self->plugins);
         }
 
+        if (self->connectionTimers)
+            TimerWheel_destroy(self->connectionTimers);
+
+        if (self->wakeupSignal)
+            WakeupSignal_destroy(self->wakeupSignal);
+
+#if (CONFIG_USE_THREADS == 1)
+        releaseWorkers(self);
+#endif
+
         GLOBAL_FREEMEM(self);
     }
 }
@@ -30,7 +30,6 @@
 #include "lib60870_internal.h"
 #include "lib_memory.h"
 #include "link_layer_private.h"
-#include "linked_list.h"
 #include "serial_transceiver_ft_1_2.h"
 
 typedef struct sLinkLayerSecondaryUnbalanced* LL_Sec_Unb; /* short cut definition */
@@ -68,11 +67,40 @@ llsu_setState(LL_Sec_Unb self, LinkLayerState newState);
 void
 LinkLayerPrimaryUnbalanced_runStateMachine(LinkLayerPrimaryUnbalanced self);
 
+static CS101_LinkLayerStatistics*
+LinkLayerPrimaryUnbalanced_getSlaveStatisticsRef(LinkLayerPrimaryUnbalanced self, int slaveAddress);
+
+/* position of the user data in the send buffer (start + 2 x length + start + control + 2 byte address) */
+#define LL_USER_DATA_OFFSET 7
+
+/* pre-encoded fixed length frame - only the control field and the checksum change between frames */
+typedef struct sFixedFrameTemplate* FixedFrameTemplate;
+
+struct sFixedFrameTemplate
+{
+    uint8_t frame[6];
+    uint8_t frameSize;
+    uint8_t addressChecksum; /* checksum of the address field */
+    int address; /* encoded address (-1 = not encoded) */
+    int addressLength;
+};
+
 struct sLinkLayer
 {
-    uint8_t buffer[261]; /* 261 = maximum FT1.2 frame length */
-    uint8_t userDataBuffer[255];
+    uint8_t recvBuffer[261]; /* 261 = maximum FT1.2 frame length */
+
+    /* variable length frames are encoded in place around the user data */
+    uint8_t sendBuffer[LL_USER_DATA_OFFSET + 255 + 2];
+    uint8_t* userDataBuffer; /* user data part of the send buffer */
     uint8_t userDataSize; /* > 0 when last sent message is available */
+
+    struct sFixedFrameTemplate fixedFrame;
+
+    struct sCS101_LinkLayerStatistics statistics;
+    uint64_t requestTime; /* time when the last request was sent (ns, 0 = no response expected) */
+    CS101_LinkLayerStatistics* requestSlaveStatistics; /* statistics of the addressed slave (unbalanced primary) */
+    uint64_t indicationTime; /* time when the last request was received (ns, 0 = no response pending) */
+
     int address;
     SerialTransceiverFT12 transceiver;
     LinkLayerParameters linkLayerParameters;
@@ -122,6 +150,16 @@ LinkLayer_init(LinkLayer self, int address, SerialTransceiverFT12 transceiver, L
         self->transceiver = transceiver;
         self->linkLayerParameters = linkLayerParameters;
 
+        self->userDataBuffer = self->sendBuffer + LL_USER_DATA_OFFSET;
+        self->userDataSize = 0;
+
+        self->fixedFrame.address = -1;
+
+        memset(&(self->statistics), 0, sizeof(struct sCS101_LinkLayerStatistics));
+        self->requestTime = 0;
+        self->requestSlaveStatistics = NULL;
+        self->indicationTime = 0;
+
         self->dir = false;
 
         self->llSecUnbalanced = NULL;
@@ -205,72 +243,151 @@ LinkLayerSecondaryUnbalanced_setStateChangeHandler(LinkLayerSecondaryUnbalanced
     self->stateChangedHandlerParameter = parameter;
 }
 
-static void
-SendSingleCharCharacter(LinkLayer self)
+/**
+ * Get the start time of the response timeout for a frame sent at currentTime
+ *
+ * The timeout starts when the frame is completely transmitted. With asynchronous
+ * transmission this time is an estimation and can be in the future.
+ */
+static uint64_t
+getSendTime(LinkLayer self, uint64_t currentTime)
 {
-    uint8_t singleCharAck[] = {0xe5};
+    uint64_t transmitCompleteTime = SerialTransceiverFT12_getTransmitCompleteTime(self->transceiver);
 
-    SerialTransceiverFT12_sendMessage(self->transceiver, singleCharAck, 1);
+    if (transmitCompleteTime > currentTime)
+        return transmitCompleteTime;
+    else
+        return currentTime;
 }
 
 static void
-SendFixedFrame(LinkLayer self, uint8_t fc, int address, bool prm, bool dir, bool acd /*FCB*/, bool dfc /*FCV*/)
+LatencyHistogram_addSample(CS101_LatencyHistogram* self, uint64_t timeInNs)
 {
-    uint8_t* buffer = self->buffer;
+    uint64_t timeInUs = timeInNs / 1000;
 
-    int bufPos = 0;
+    uint32_t sample = (timeInUs > 0xffffffff) ? 0xffffffff : (uint32_t)timeInUs;
 
-    buffer[bufPos++] = 0x10; /* START */
+    if ((self->count == 0) || (sample < self->minUs))
+        self->minUs = sample;
 
-    uint8_t c = fc & 0x0f;
+    if (sample > self->maxUs)
+        self->maxUs = sample;
 
-    if (prm)
-        c += 0x40;
+    self->count++;
+    self->sumUs += sample;
 
-    if (dir)
-        c += 0x80;
+    int bucket = 0;
+    uint32_t limit = 250;
 
-    if (acd)
-        c += 0x20;
+    while ((sample >= limit) && (bucket < CS101_LATENCY_HISTOGRAM_SIZE - 1))
+    {
+        limit = limit * 2;
+        bucket++;
+    }
 
-    if (dfc)
-        c += 0x10;
+    self->buckets[bucket]++;
+}
+
+/* update the statistics before a frame is sent */
+static void
+LinkLayer_countSentFrame(LinkLayer self, uint8_t fc, int address, bool prm)
+{
+    if (prm)
+    {
+        if (fc != LL_FC_04_USER_DATA_NO_REPLY)
+        {
+            self->statistics.requests++;
+            self->requestTime = Hal_getMonotonicTimeInNs();
+            self->requestSlaveStatistics = NULL;
 
-    buffer[bufPos++] = c;
+            if (self->llPriUnbalanced)
+            {
+                self->requestSlaveStatistics =
+                    LinkLayerPrimaryUnbalanced_getSlaveStatisticsRef(self->llPriUnbalanced, address);
 
-    if (self->linkLayerParameters->addressLength > 0)
+                if (self->requestSlaveStatistics)
+                    self->requestSlaveStatistics->requests++;
+            }
+        }
+    }
+    else if (self->indicationTime != 0)
     {
-        buffer[bufPos++] = (uint8_t)(address % 0x100);
+        LatencyHistogram_addSample(&(self->statistics.responseTime), Hal_getMonotonicTimeInNs() - self->indicationTime);
 
-        if (self->linkLayerParameters->addressLength > 1)
-            buffer[bufPos++] = (uint8_t)((address / 0x100) % 0x100);
+        self->indicationTime = 0;
     }
+}
 
-    uint8_t checksum = 0;
+/* update the statistics when a response (secondary frame) is received */
+static void
+LinkLayer_countResponse(LinkLayer self)
+{
+    if (self->requestTime != 0)
+    {
+        uint64_t roundTripTime = Hal_getMonotonicTimeInNs() - self->requestTime;
 
-    int i;
+        self->statistics.responses++;
+        LatencyHistogram_addSample(&(self->statistics.roundTripTime), roundTripTime);
+
+        if (self->requestSlaveStatistics)
+        {
+            self->requestSlaveStatistics->responses++;
+            LatencyHistogram_addSample(&(self->requestSlaveStatistics->roundTripTime), roundTripTime);
+        }
 
-    for (i = 1; i < bufPos; i++)
-        checksum += buffer[i];
+        self->requestTime = 0;
+    }
+}
 
-    buffer[bufPos++] = checksum;
+/* update the statistics when no response was received in time */
+static void
+LinkLayer_countTimeout(LinkLayer self, CS101_LinkLayerStatistics* slaveStatistics, bool retransmission)
+{
+    self->statistics.timeouts++;
 
-    buffer[bufPos++] = 0x16; /* END */
+    if (retransmission)
+        self->statistics.retransmissions++;
 
-    DEBUG_PRINT("Send fixed frame (fc=%i)\n", fc);
+    if (slaveStatistics)
+    {
+        slaveStatistics->timeouts++;
 
-    SerialTransceiverFT12_sendMessage(self->transceiver, buffer, bufPos);
+        if (retransmission)
+            slaveStatistics->retransmissions++;
+    }
+
+    self->requestTime = 0;
 }
 
 static void
-SendVariableLengthFrame(LinkLayer self, uint8_t fc, int address, bool prm, bool dir, bool acd, bool dfc, Frame frame)
+LinkLayer_getStatistics(LinkLayer self, CS101_LinkLayerStatistics* statistics)
 {
-    uint8_t* buffer = self->buffer;
-    int addressLength = self->linkLayerParameters->addressLength;
+    *statistics = self->statistics;
 
-    buffer[0] = 0x68; /* START */
-    buffer[3] = 0x68; /* START */
+    SerialTransceiverFT12_getStatistics(self->transceiver, statistics);
+}
+
+static void
+LinkLayer_resetStatistics(LinkLayer self)
+{
+    memset(&(self->statistics), 0, sizeof(struct sCS101_LinkLayerStatistics));
+
+    SerialTransceiverFT12_resetStatistics(self->transceiver);
+}
 
+static void
+SendSingleCharCharacter(LinkLayer self)
+{
+    static uint8_t singleCharAck[] = {0xe5};
+
+    LinkLayer_countSentFrame(self, LL_FC_00_ACK, self->address, false);
+
+    SerialTransceiverFT12_sendMessage(self->transceiver, singleCharAck, 1);
+}
+
+static uint8_t
+getControlField(uint8_t fc, bool prm, bool dir, bool acd /*FCB*/, bool dfc /*FCV*/)
+{
     uint8_t c = fc & 0x0f;
 
     if (prm)
@@ -285,18 +402,83 @@ SendVariableLengthFrame(LinkLayer self, uint8_t fc, int address, bool prm, bool
     if (dfc)
         c += 0x10;
 
-    buffer[4] = c;
+    return c;
+}
 
-    int bufPos = 5;
+/* encode the address field and return its checksum */
+static uint8_t
+encodeAddress(uint8_t* buffer, int address, int addressLength)
+{
+    uint8_t checksum = 0;
 
     if (addressLength > 0)
     {
-        buffer[bufPos++] = (uint8_t)(address % 0x100);
+        buffer[0] = (uint8_t)(address % 0x100);
+        checksum += buffer[0];
 
         if (addressLength > 1)
-            buffer[bufPos++] = (uint8_t)((address / 0x100) % 0x100);
+        {
+            buffer[1] = (uint8_t)((address / 0x100) % 0x100);
+            checksum += buffer[1];
+        }
     }
 
+    return checksum;
+}
+
+static void
+FixedFrameTemplate_encode(FixedFrameTemplate self, int address, int addressLength)
+{
+    int bufPos = 0;
+
+    self->frame[bufPos++] = 0x10; /* START */
+    self->frame[bufPos++] = 0; /* control field */
+
+    self->addressChecksum = encodeAddress(self->frame + bufPos, address, addressLength);
+
+    if (addressLength > 0)
+        bufPos += (addressLength > 1) ? 2 : 1;
+
+    self->frame[bufPos++] = 0; /* checksum */
+    self->frame[bufPos++] = 0x16; /* END */
+
+    self->frameSize = (uint8_t)bufPos;
+    self->address = address;
+    self->addressLength = addressLength;
+}
+
+static void
+SendFixedFrameFromTemplate(LinkLayer self, FixedFrameTemplate template, uint8_t fc, int address, bool prm, bool dir,
+                           bool acd /*FCB*/, bool dfc /*FCV*/)
+{
+    int addressLength = self->linkLayerParameters->addressLength;
+
+    if ((template->address != address) || (template->addressLength != addressLength))
+        FixedFrameTemplate_encode(template, address, addressLength);
+
+    uint8_t c = getControlField(fc, prm, dir, acd, dfc);
+
+    template->frame[1] = c;
+    template->frame[template->frameSize - 2] = (uint8_t)(c + template->addressChecksum);
+
+    DEBUG_PRINT("Send fixed frame (fc=%i)\n", fc);
+
+    LinkLayer_countSentFrame(self, fc, address, prm);
+
+    SerialTransceiverFT12_sendMessage(self->transceiver, template->frame, template->frameSize);
+}
+
+static void
+SendFixedFrame(LinkLayer self, uint8_t fc, int address, bool prm, bool dir, bool acd /*FCB*/, bool dfc /*FCV*/)
+{
+    SendFixedFrameFromTemplate(self, &(self->fixedFrame), fc, address, prm, dir, acd, dfc);
+}
+
+static void
+SendVariableLengthFrame(LinkLayer self, uint8_t fc, int address, bool prm, bool dir, bool acd, bool dfc, Frame frame)
+{
+    int addressLength = self->linkLayerParameters->addressLength;
+
     uint8_t* userData = Frame_getBuffer(frame);
     int userDataLength = Frame_getMsgSize(frame);
 
@@ -305,33 +487,53 @@ SendVariableLengthFrame(LinkLayer self, uint8_t fc, int address, bool prm, bool
     if (l > 255)
         return;
 
+    /* the header is placed in front of the user data */
+    int frameStart = LL_USER_DATA_OFFSET - (4 + l - userDataLength);
+
+    uint8_t* buffer = self->sendBuffer + frameStart;
+
+    buffer[0] = 0x68; /* START */
     buffer[1] = (uint8_t)l;
     buffer[2] = (uint8_t)l;
+    buffer[3] = 0x68; /* START */
+
+    uint8_t c = getControlField(fc, prm, dir, acd, dfc);
+
+    buffer[4] = c;
+
+    uint8_t checksum = c + encodeAddress(buffer + 5, address, addressLength);
+
+    /* user data that is not already encoded in the send buffer has to be copied */
+    if (userData != self->userDataBuffer)
+        memcpy(self->userDataBuffer, userData, userDataLength);
 
     int i;
 
     for (i = 0; i < userDataLength; i++)
-        buffer[bufPos++] = userData[i];
+        checksum += self->userDataBuffer[i];
 
-    uint8_t checksum = 0;
+    int bufPos = LL_USER_DATA_OFFSET + userDataLength;
 
-    for (i = 4; i < bufPos; i++)
-        checksum += buffer[i];
+    self->sendBuffer[bufPos++] = checksum;
+    self->sendBuffer[bufPos++] = 0x16; /* END */
 
-    buffer[bufPos++] = checksum;
+    int frameSize = bufPos - frameStart;
 
-    buffer[bufPos++] = 0x16; /* END */
+    DEBUG_PRINT("Send variable frame (fc=%i, size=%i)\n", (int)fc, frameSize);
 
-    DEBUG_PRINT("Send variable frame (fc=%i, size=%i)\n", (int)fc, bufPos);
+    LinkLayer_countSentFrame(self, fc, address, prm);
 
-    SerialTransceiverFT12_sendMessage(self->transceiver, buffer, bufPos);
+    SerialTransceiverFT12_sendMessage(self->transceiver, buffer, frameSize);
 }
 
 static bool
 checkFCB(LL_Sec_Unb self, bool fcb)
 {
     if (fcb != self->expectedFcb)
+    {
+        self->linkLayer->statistics.repeatedRequests++;
         return false;
+    }
     else
     {
         self->expectedFcb = !(self->expectedFcb);
@@ -642,6 +844,7 @@ ParserHeaderSecondaryUnbalanced(void* parameter, uint8_t* msg, int msgSize)
         if (msg[1] != msg[2])
         {
             DEBUG_PRINT("ERROR: L fields differ!\n");
+            self->linkLayer->statistics.invalidFrames++;
             llsu_setState(self, LL_STATE_ERROR);
             return;
         }
@@ -656,6 +859,7 @@ ParserHeaderSecondaryUnbalanced(void* parameter, uint8_t* msg, int msgSize)
         if (msgSize != (userDataStart + userDataLength + 2 /* CS + END */))
         {
             DEBUG_PRINT("ERROR: Invalid message length\n");
+            self->linkLayer->statistics.invalidFrames++;
             llsu_setState(self, LL_STATE_ERROR);
             return;
         }
@@ -671,6 +875,7 @@ ParserHeaderSecondaryUnbalanced(void* parameter, uint8_t* msg, int msgSize)
     else
     {
         DEBUG_PRINT("ERROR: Received unexpected message type in unbalanced slave mode!\n");
+        self->linkLayer->statistics.invalidFrames++;
         llsu_setState(self, LL_STATE_ERROR);
         return;
     }
@@ -727,6 +932,7 @@ ParserHeaderSecondaryUnbalanced(void* parameter, uint8_t* msg, int msgSize)
     if (checksum != msg[csIndex])
     {
         DEBUG_PRINT("ERROR: checksum invalid!\n");
+        self->linkLayer->statistics.checksumErrors++;
         llsu_setState(self, LL_STATE_ERROR);
         return;
     }
@@ -744,6 +950,9 @@ ParserHeaderSecondaryUnbalanced(void* parameter, uint8_t* msg, int msgSize)
     bool fcb = ((c & 0x20) == 0x20);
     bool fcv = ((c & 0x10) == 0x10);
 
+    if ((isBroadcast == false) && (fc != LL_FC_04_USER_DATA_NO_REPLY))
+        self->linkLayer->indicationTime = Hal_getMonotonicTimeInNs();
+
     LinkLayerSecondaryUnbalanced_handleMessage(self, fc, isBroadcast, fcb, fcv, msg, userDataStart, userDataLength);
 }
 
@@ -766,6 +975,7 @@ HandleMessageBalancedAndPrimaryUnbalanced(void* parameter, uint8_t* msg, int msg
         if (msg[1] != msg[2])
         {
             DEBUG_PRINT("ERROR: L fields differ!\n");
+            self->statistics.invalidFrames++;
             return;
         }
 
@@ -779,6 +989,7 @@ HandleMessageBalancedAndPrimaryUnbalanced(void* parameter, uint8_t* msg, int msg
         if (msgSize != (userDataStart + userDataLength + 2 /* CS + END */))
         {
             DEBUG_PRINT("ERROR: Invalid message length\n");
+            self->statistics.invalidFrames++;
             return;
         }
 
@@ -810,6 +1021,7 @@ HandleMessageBalancedAndPrimaryUnbalanced(void* parameter, uint8_t* msg, int msg
     else
     {
         DEBUG_PRINT("ERROR: Received unexpected message type!\n");
+        self->statistics.invalidFrames++;
         return;
     }
 
@@ -826,6 +1038,7 @@ HandleMessageBalancedAndPrimaryUnbalanced(void* parameter, uint8_t* msg, int msg
         if (checksum != msg[csIndex])
         {
             DEBUG_PRINT("ERROR: checksum invalid!\n");
+            self->statistics.checksumErrors++;
             return;
         }
 
@@ -838,6 +1051,9 @@ HandleMessageBalancedAndPrimaryUnbalanced(void* parameter, uint8_t* msg, int msg
             bool fcb = ((c & 0x20) == 0x20);
             bool fcv = ((c & 0x10) == 0x10);
 
+            if (fc != LL_FC_04_USER_DATA_NO_REPLY)
+                self->indicationTime = Hal_getMonotonicTimeInNs();
+
             if (self->llSecBalanced != NULL)
                 LinkLayerSecondaryBalanced_handleMessage(self->llSecBalanced, fc, false, fcb, fcv, msg, userDataStart,
                                                          userDataLength);
@@ -854,6 +1070,8 @@ HandleMessageBalancedAndPrimaryUnbalanced(void* parameter, uint8_t* msg, int msg
             bool dir = ((c & 0x80) == 0x80); /* DIR - direction for balanced transmission */
             bool dfc = ((c & 0x10) == 0x10); /* DFC - Data flow control */
 
+            LinkLayer_countResponse(self);
+
             if (self->llPriBalanced != NULL)
             {
                 LinkLayerPrimaryBalanced_handleMessage(self->llPriBalanced, fc, dir, dfc, address, msg, userDataStart,
@@ -874,6 +1092,8 @@ HandleMessageBalancedAndPrimaryUnbalanced(void* parameter, uint8_t* msg, int msg
     else
     {
         /* Single byte ACK */
+        LinkLayer_countResponse(self);
+
         if (self->llPriBalanced != NULL)
         {
             LinkLayerPrimaryBalanced_handleMessage(self->llPriBalanced, LL_FC_00_ACK, false, false, -1, NULL, 0, 0);
@@ -899,12 +1119,24 @@ LinkLayerSecondaryUnbalanced_setAddress(LinkLayerSecondaryUnbalanced self, int a
     self->_linkLayer.address = address;
 }
 
+void
+LinkLayerSecondaryUnbalanced_getStatistics(LinkLayerSecondaryUnbalanced self, CS101_LinkLayerStatistics* statistics)
+{
+    LinkLayer_getStatistics(self->linkLayer, statistics);
+}
+
+void
+LinkLayerSecondaryUnbalanced_resetStatistics(LinkLayerSecondaryUnbalanced self)
+{
+    LinkLayer_resetStatistics(self->linkLayer);
+}
+
 void
 LinkLayerSecondaryUnbalanced_run(LinkLayerSecondaryUnbalanced self)
 {
     LinkLayer ll = self->linkLayer;
 
-    SerialTransceiverFT12_readNextMessage(ll->transceiver, ll->buffer, ParserHeaderSecondaryUnbalanced, self);
+    SerialTransceiverFT12_readNextMessage(ll->transceiver, ll->recvBuffer, ParserHeaderSecondaryUnbalanced, self);
 
     if (self->state != LL_STATE_IDLE)
     {
@@ -938,6 +1170,7 @@ LinkLayerSecondaryBalanced_checkFCB(LinkLayerSecondaryBalanced self, bool fcb)
     {
         DEBUG_PRINT("ERROR: Frame count bit (FCB) invalid!\n");
         /* TODO change link status */
+        self->linkLayer->statistics.repeatedRequests++;
         return false;
     }
     else
@@ -1247,7 +1480,7 @@ LinkLayerPrimaryBalanced_handleMessage(LinkLayerPrimaryBalanced self, uint8_t fc
             SendFixedFrame(self->linkLayer, LL_FC_00_RESET_REMOTE_LINK, self->otherStationAddress, true,
                            self->linkLayer->dir, false, false);
 
-            self->lastSendTime = Hal_getMonotonicTimeInMs();
+            self->lastSendTime = getSendTime(self->linkLayer, Hal_getMonotonicTimeInMs());
             self->waitingForResponse = true;
             newState = PLL_EXECUTE_RESET_REMOTE_LINK;
             llpb_setNewState(self, LL_STATE_BUSY);
@@ -1307,7 +1540,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
         SendFixedFrame(self->linkLayer, LL_FC_09_REQUEST_LINK_STATUS, self->otherStationAddress, true,
                        self->linkLayer->dir, false, false);
 
-        self->lastSendTime = currentTime;
+        self->lastSendTime = getSendTime(self->linkLayer, currentTime);
         self->waitingForResponse = true;
 
         newState = PLL_EXECUTE_REQUEST_STATUS_OF_LINK;
@@ -1318,7 +1551,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
 
         if (self->waitingForResponse)
         {
-            if (self->lastSendTime > currentTime)
+            if (self->lastSendTime > getSendTime(self->linkLayer, currentTime))
             {
                 /* last sent time not plausible! */
                 self->lastSendTime = currentTime;
@@ -1326,6 +1559,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
 
             if (currentTime > (self->lastSendTime + self->linkLayer->linkLayerParameters->timeoutForAck))
             {
+                LinkLayer_countTimeout(self->linkLayer, NULL, false);
                 newState = PLL_IDLE;
             }
         }
@@ -1336,7 +1570,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
             SendFixedFrame(self->linkLayer, LL_FC_00_RESET_REMOTE_LINK, self->otherStationAddress, true,
                            self->linkLayer->dir, false, false);
 
-            self->lastSendTime = currentTime;
+            self->lastSendTime = getSendTime(self->linkLayer, currentTime);
             self->waitingForResponse = true;
             newState = PLL_EXECUTE_RESET_REMOTE_LINK;
         }
@@ -1347,7 +1581,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
 
         if (self->waitingForResponse)
         {
-            if (self->lastSendTime > currentTime)
+            if (self->lastSendTime > getSendTime(self->linkLayer, currentTime))
             {
                 /* last sent time not plausible! */
                 self->lastSendTime = currentTime;
@@ -1355,6 +1589,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
 
             if (currentTime > (self->lastSendTime + self->linkLayer->linkLayerParameters->timeoutForAck))
             {
+                LinkLayer_countTimeout(self->linkLayer, NULL, false);
                 self->waitingForResponse = false;
                 newState = PLL_IDLE;
                 llpb_setNewState(self, LL_STATE_ERROR);
@@ -1390,7 +1625,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
                            self->linkLayer->dir, self->nextFcb, true);
 
             self->nextFcb = !(self->nextFcb);
-            self->lastSendTime = currentTime;
+            self->lastSendTime = getSendTime(self->linkLayer, currentTime);
             self->originalSendTime = self->lastSendTime;
             newState = PLL_EXECUTE_SERVICE_SEND_CONFIRM;
         }
@@ -1409,7 +1644,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
                                         self->linkLayer->dir, self->nextFcb, true, asdu);
 
                 self->nextFcb = !(self->nextFcb);
-                self->lastSendTime = currentTime;
+                self->lastSendTime = getSendTime(self->linkLayer, currentTime);
                 self->originalSendTime = self->lastSendTime;
                 self->waitingForResponse = true;
 
@@ -1421,7 +1656,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
 
     case PLL_EXECUTE_SERVICE_SEND_CONFIRM:
 
-        if (self->lastSendTime > currentTime)
+        if (self->lastSendTime > getSendTime(self->linkLayer, currentTime))
         {
             /* last sent time not plausible! */
             self->lastSendTime = currentTime;
@@ -1433,6 +1668,8 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
             {
                 DEBUG_PRINT("TIMEOUT: ASDU not confirmed after repeated transmission\n");
 
+                LinkLayer_countTimeout(self->linkLayer, NULL, false);
+
                 newState = PLL_IDLE;
                 llpb_setNewState(self, LL_STATE_ERROR);
             }
@@ -1440,6 +1677,8 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
             {
                 DEBUG_PRINT("TIMEOUT: ASDU not confirmed\n");
 
+                LinkLayer_countTimeout(self->linkLayer, NULL, true);
+
                 if (self->sendLinkLayerTestFunction)
                 {
                     DEBUG_PRINT("PLL - repeat send test function\n");
@@ -1456,7 +1695,7 @@ LinkLayerPrimaryBalanced_runStateMachine(LinkLayerPrimaryBalanced self)
                                             (Frame) & (self->lastSendAsdu));
                 }
 
-                self->lastSendTime = currentTime;
+                self->lastSendTime = getSendTime(self->linkLayer, currentTime);
             }
         }
 
@@ -1557,6 +1796,18 @@ LinkLayerBalanced_setOtherStationAddress(LinkLayerBalanced self, int address)
     self->primaryLinkLayer.otherStationAddress = address;
 }
 
+void
+LinkLayerBalanced_getStatistics(LinkLayerBalanced self, CS101_LinkLayerStatistics* statistics)
+{
+    LinkLayer_getStatistics(self->linkLayer, statistics);
+}
+
+void
+LinkLayerBalanced_resetStatistics(LinkLayerBalanced self)
+{
+    LinkLayer_resetStatistics(self->linkLayer);
+}
+
 void
 LinkLayerBalanced_destroy(LinkLayerBalanced self)
 {
@@ -1571,7 +1822,7 @@ LinkLayerBalanced_run(LinkLayerBalanced self)
 {
     LinkLayer ll = self->linkLayer;
 
-    SerialTransceiverFT12_readNextMessage(ll->transceiver, ll->buffer, HandleMessageBalancedAndPrimaryUnbalanced,
+    SerialTransceiverFT12_readNextMessage(ll->transceiver, ll->recvBuffer, HandleMessageBalancedAndPrimaryUnbalanced,
                                           (void*)ll);
 
     LinkLayerPrimaryBalanced_runStateMachine(&(self->primaryLinkLayer));
@@ -1589,11 +1840,29 @@ LinkLayerBalanced_run(LinkLayerBalanced self)
 
 typedef struct sLinkLayerSlaveConnection* LinkLayerSlaveConnection;
 
+/* maximum number of class 1 requests sent to a slave in a row while it is signaling ACD */
+#define PLL_MAX_CLASS1_FOLLOW_UPS 8
+
+/* default back-off (in ms) after a slave stopped responding (priority scheduling only) */
+#define PLL_DEFAULT_INITIAL_BACKOFF 1000
+#define PLL_DEFAULT_MAX_BACKOFF 30000
+
+typedef LinkLayerSlaveConnection (*PollSchedulerFunction)(LinkLayerPrimaryUnbalanced self, uint64_t currentTime);
+
 struct sLinkLayerPrimaryUnbalanced
 {
     LinkLayerSlaveConnection currentSlave;
     int currentSlaveIndex;
 
+    PollSchedulerFunction selectNextSlave;
+
+    LinkLayerSlaveConnection lastSlave; /* slave that was served last (priority scheduling) */
+    int remainingTurns; /* remaining consecutive turns of the last slave (according to its weight) */
+    int class1FollowUps; /* number of immediate class 1 requests sent to the last slave */
+
+    int initialBackoff; /* back-off time in ms after the first timeout */
+    int maxBackoff; /* upper limit of the back-off time in ms */
+
     bool hasNextBroadcastToSend;
     struct sBufferFrame nextBroadcastMessage;
     uint8_t buffer[256];
@@ -1604,12 +1873,22 @@ struct sLinkLayerPrimaryUnbalanced
     struct sLinkLayer _linkLayer;
     LinkLayer linkLayer;
 
-    LinkedList slaveConnections;
+    /* slave connections in round-robin polling order */
+    LinkLayerSlaveConnection* slaveConnections;
+    int numberOfSlaves;
+    int maxNumberOfSlaves;
+
+    /* open addressing hash table (linear probing) that maps the link address to the slave connection */
+    LinkLayerSlaveConnection* slaveTable;
+    int slaveTableSize; /* always a power of two */
 
     IEC60870_LinkLayerStateChangedHandler stateChangedHandler;
     void* stateChangedHandlerParameter;
 };
 
+static LinkLayerSlaveConnection
+selectNextSlaveRoundRobin(LinkLayerPrimaryUnbalanced self, uint64_t currentTime);
+
 LinkLayerPrimaryUnbalanced
 LinkLayerPrimaryUnbalanced_create(SerialTransceiverFT12 transceiver, LinkLayerParameters linkLayerParameters,
                                   IPrimaryApplicationLayer applicationLayer, void* applicationLayerParam)
@@ -1622,6 +1901,15 @@ LinkLayerPrimaryUnbalanced_create(SerialTransceiverFT12 transceiver, LinkLayerPa
         self->currentSlave = NULL;
         self->currentSlaveIndex = 0;
 
+        self->selectNextSlave = selectNextSlaveRoundRobin;
+
+        self->lastSlave = NULL;
+        self->remainingTurns = 0;
+        self->class1FollowUps = 0;
+
+        self->initialBackoff = PLL_DEFAULT_INITIAL_BACKOFF;
+        self->maxBackoff = PLL_DEFAULT_MAX_BACKOFF;
+
         self->hasNextBroadcastToSend = false;
 
         self->applicationLayer = applicationLayer;
@@ -1635,7 +1923,12 @@ LinkLayerPrimaryUnbalanced_create(SerialTransceiverFT12 transceiver, LinkLayerPa
 
         BufferFrame_initialize(&(self->nextBroadcastMessage), self->buffer, 0);
 
-        self->slaveConnections = LinkedList_create();
+        self->slaveConnections = NULL;
+        self->numberOfSlaves = 0;
+        self->maxNumberOfSlaves = 0;
+
+        self->slaveTable = NULL;
+        self->slaveTableSize = 0;
 
         self->stateChangedHandler = NULL;
     }
@@ -1656,8 +1949,16 @@ LinkLayerPrimaryUnbalanced_destroy(LinkLayerPrimaryUnbalanced self)
 {
     if (self)
     {
+        int i;
+
+        for (i = 0; i < self->numberOfSlaves; i++)
+            GLOBAL_FREEMEM(self->slaveConnections[i]);
+
         if (self->slaveConnections)
-            LinkedList_destroy(self->slaveConnections);
+            GLOBAL_FREEMEM(self->slaveConnections);
+
+        if (self->slaveTable)
+            GLOBAL_FREEMEM(self->slaveTable);
 
         GLOBAL_FREEMEM(self);
     }
@@ -1689,6 +1990,17 @@ struct sLinkLayerSlaveConnection
     bool sendLinkLayerTestFunction;
 
     bool nextFcb;
+
+    struct sFixedFrameTemplate fixedFrame; /* pre-encoded fixed frame with the slave address */
+
+    int weight; /* number of consecutive exchanges per scheduling turn (priority scheduling) */
+    int class2PollInterval; /* interval for automatic class 2 requests in ms (0 = disabled) */
+    uint64_t nextClass2PollTime;
+
+    int consecutiveTimeouts;
+    uint64_t backoffUntil; /* slave is not scheduled before this time (priority scheduling) */
+
+    struct sCS101_LinkLayerStatistics statistics;
 };
 
 static LinkLayerSlaveConnection
@@ -1702,6 +2014,8 @@ LinkLayerSlaveConnection_create(LinkLayerSlaveConnection self, LinkLayerPrimaryU
         self->primaryLink = primaryLink;
         self->address = slaveAddress;
 
+        self->fixedFrame.address = -1;
+
         self->state = LL_STATE_IDLE;
 
         self->lastSendTime = 0;
@@ -1718,6 +2032,15 @@ LinkLayerSlaveConnection_create(LinkLayerSlaveConnection self, LinkLayerPrimaryU
         self->requestClass1Data = false;
         self->requestClass2Data = false;
 
+        self->weight = 1;
+        self->class2PollInterval = 0;
+        self->nextClass2PollTime = 0;
+
+        self->consecutiveTimeouts = 0;
+        self->backoffUntil = 0;
+
+        memset(&(self->statistics), 0, sizeof(struct sCS101_LinkLayerStatistics));
+
         BufferFrame_initialize(&(self->nextMessage), self->buffer, 0);
     }
 
@@ -1737,6 +2060,40 @@ llsc_setState(LinkLayerSlaveConnection self, LinkLayerState newState)
     }
 }
 
+static void
+llsc_handleTimeout(LinkLayerSlaveConnection self, uint64_t currentTime)
+{
+    LinkLayerPrimaryUnbalanced primaryLink = self->primaryLink;
+
+    self->consecutiveTimeouts++;
+
+    /* exponential back-off for slaves that repeatedly do not respond */
+    uint64_t backoff = (uint64_t)primaryLink->initialBackoff;
+
+    int i;
+
+    for (i = 1; (i < self->consecutiveTimeouts) && (backoff < (uint64_t)primaryLink->maxBackoff); i++)
+        backoff = backoff * 2;
+
+    if (backoff > (uint64_t)primaryLink->maxBackoff)
+        backoff = (uint64_t)primaryLink->maxBackoff;
+
+    self->backoffUntil = currentTime + backoff;
+
+    DEBUG_PRINT("[SLAVE %i] PLL - timeout %i (back-off %i ms)\n", self->address, self->consecutiveTimeouts,
+                (int)backoff);
+
+    if (primaryLink->applicationLayer->Timeout)
+        primaryLink->applicationLayer->Timeout(primaryLink->applicationLayerParam, self->address);
+}
+
+static void
+llsc_sendFixedFrame(LinkLayerSlaveConnection self, uint8_t fc, bool fcb, bool fcv)
+{
+    SendFixedFrameFromTemplate(self->primaryLink->linkLayer, &(self->fixedFrame), fc, self->address, true, false, fcb,
+                               fcv);
+}
+
 static void
 LinkLayerSlaveConnection_HandleMessage(LinkLayerSlaveConnection self, uint8_t fc, bool acd, bool dfc, int address,
                                        uint8_t* msg, int userDataStart, int userDataLength)
@@ -1779,6 +2136,9 @@ LinkLayerSlaveConnection_HandleMessage(LinkLayerSlaveConnection self, uint8_t fc
         self->dontSendMessages = false;
     }
 
+    self->consecutiveTimeouts = 0;
+    self->backoffUntil = 0;
+
     if (acd)
         self->requestClass1Data = true;
 
@@ -1841,10 +2201,9 @@ LinkLayerSlaveConnection_HandleMessage(LinkLayerSlaveConnection self, uint8_t fc
         {
             DEBUG_PRINT("[SLAVE %i] PLL - SEND RESET REMOTE LINK\n", self->address);
 
-            SendFixedFrame(self->primaryLink->linkLayer, LL_FC_00_RESET_REMOTE_LINK, self->address, true, false, false,
-                           false);
+            llsc_sendFixedFrame(self, LL_FC_00_RESET_REMOTE_LINK, false, false);
 
-            self->lastSendTime = Hal_getMonotonicTimeInMs();
+            self->lastSendTime = getSendTime(self->primaryLink->linkLayer, Hal_getMonotonicTimeInMs());
             self->waitingForResponse = true;
             newState = PLL_EXECUTE_RESET_REMOTE_LINK;
 
@@ -1966,7 +2325,7 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
     {
     case PLL_TIMEOUT:
 
-        if (self->lastSendTime > currentTime)
+        if (self->lastSendTime > getSendTime(self->primaryLink->linkLayer, currentTime))
         {
             /* last sent time not plausible! */
             self->lastSendTime = currentTime;
@@ -1986,10 +2345,9 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
 
         DEBUG_PRINT("[SLAVE %i] PLL - SEND FC 09 - REQUEST LINK STATUS\n", self->address);
 
-        SendFixedFrame(self->primaryLink->linkLayer, LL_FC_09_REQUEST_LINK_STATUS, self->address, true, false, false,
-                       false);
+        llsc_sendFixedFrame(self, LL_FC_09_REQUEST_LINK_STATUS, false, false);
 
-        self->lastSendTime = currentTime;
+        self->lastSendTime = getSendTime(self->primaryLink->linkLayer, currentTime);
         self->waitingForResponse = true;
         newState = PLL_EXECUTE_REQUEST_STATUS_OF_LINK;
 
@@ -1999,7 +2357,7 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
 
         if (self->waitingForResponse)
         {
-            if (self->lastSendTime > currentTime)
+            if (self->lastSendTime > getSendTime(self->primaryLink->linkLayer, currentTime))
             {
                 /* last sent time not plausible! */
                 self->lastSendTime = currentTime;
@@ -2007,19 +2365,22 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
 
             if (currentTime > (self->lastSendTime + self->primaryLink->linkLayer->linkLayerParameters->timeoutForAck))
             {
+                LinkLayer_countTimeout(self->primaryLink->linkLayer, &(self->statistics), false);
+
                 self->waitingForResponse = false;
                 self->lastSendTime = currentTime;
                 newState = PLL_TIMEOUT;
+
+                llsc_handleTimeout(self, currentTime);
             }
         }
         else
         {
             DEBUG_PRINT("[SLAVE %i] PLL - SEND FC 00 - RESET REMOTE LINK\n", self->address);
 
-            SendFixedFrame(self->primaryLink->linkLayer, LL_FC_00_RESET_REMOTE_LINK, self->address, true, false, false,
-                           false);
+            llsc_sendFixedFrame(self, LL_FC_00_RESET_REMOTE_LINK, false, false);
 
-            self->lastSendTime = currentTime;
+            self->lastSendTime = getSendTime(self->primaryLink->linkLayer, currentTime);
             self->waitingForResponse = true;
             self->nextFcb = true;
             newState = PLL_EXECUTE_RESET_REMOTE_LINK;
@@ -2031,7 +2392,7 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
 
         if (self->waitingForResponse)
         {
-            if (self->lastSendTime > currentTime)
+            if (self->lastSendTime > getSendTime(self->primaryLink->linkLayer, currentTime))
             {
                 /* last sent time not plausible! */
                 self->lastSendTime = currentTime;
@@ -2039,11 +2400,15 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
 
             if (currentTime > (self->lastSendTime + self->primaryLink->linkLayer->linkLayerParameters->timeoutForAck))
             {
+                LinkLayer_countTimeout(self->primaryLink->linkLayer, &(self->statistics), false);
+
                 self->waitingForResponse = false;
                 self->lastSendTime = currentTime;
                 newState = PLL_TIMEOUT;
 
                 llsc_setState(self, LL_STATE_ERROR);
+
+                llsc_handleTimeout(self, currentTime);
             }
         }
         else
@@ -2061,11 +2426,10 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
         {
             DEBUG_PRINT("[SLAVE %i] PLL - FC 02 - SEND TEST LINK\n", self->address);
 
-            SendFixedFrame(self->primaryLink->linkLayer, LL_FC_02_TEST_FUNCTION_FOR_LINK, self->address, true, false,
-                           self->nextFcb, true);
+            llsc_sendFixedFrame(self, LL_FC_02_TEST_FUNCTION_FOR_LINK, self->nextFcb, true);
 
             self->nextFcb = !(self->nextFcb);
-            self->lastSendTime = currentTime;
+            self->lastSendTime = getSendTime(self->primaryLink->linkLayer, currentTime);
             self->originalSendTime = currentTime;
             self->waitingForResponse = true;
 
@@ -2079,7 +2443,7 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
                                     false, self->nextFcb, true, (Frame) & (self->nextMessage));
 
             self->nextFcb = !(self->nextFcb);
-            self->lastSendTime = currentTime;
+            self->lastSendTime = getSendTime(self->primaryLink->linkLayer, currentTime);
             self->originalSendTime = currentTime;
             self->waitingForResponse = true;
 
@@ -2091,8 +2455,7 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
             {
                 DEBUG_PRINT("[SLAVE %i] PLL - SEND FC 10 - REQ UD 1\n", self->address);
 
-                SendFixedFrame(self->primaryLink->linkLayer, LL_FC_10_REQUEST_USER_DATA_CLASS_1, self->address, true,
-                               false, self->nextFcb, true);
+                llsc_sendFixedFrame(self, LL_FC_10_REQUEST_USER_DATA_CLASS_1, self->nextFcb, true);
 
                 self->requestClass1Data = false;
             }
@@ -2100,14 +2463,13 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
             {
                 DEBUG_PRINT("[SLAVE %i] PLL - SEND FC 11 - REQ UD 2\n", self->address);
 
-                SendFixedFrame(self->primaryLink->linkLayer, LL_FC_11_REQUEST_USER_DATA_CLASS_2, self->address, true,
-                               false, self->nextFcb, true);
+                llsc_sendFixedFrame(self, LL_FC_11_REQUEST_USER_DATA_CLASS_2, self->nextFcb, true);
 
                 self->requestClass2Data = false;
             }
 
             self->nextFcb = !(self->nextFcb);
-            self->lastSendTime = currentTime;
+            self->lastSendTime = getSendTime(self->primaryLink->linkLayer, currentTime);
             self->originalSendTime = currentTime;
             self->waitingForResponse = true;
             newState = PLL_EXECUTE_SERVICE_REQUEST_RESPOND;
@@ -2117,7 +2479,7 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
 
     case PLL_EXECUTE_SERVICE_SEND_CONFIRM:
 
-        if (self->lastSendTime > currentTime)
+        if (self->lastSendTime > getSendTime(self->primaryLink->linkLayer, currentTime))
         {
             /* last sent time not plausible! */
             self->lastSendTime = currentTime;
@@ -2130,22 +2492,27 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
             {
                 DEBUG_PRINT("[SLAVE %i] TIMEOUT: ASDU not confirmed after repeated transmission\n", self->address);
 
+                LinkLayer_countTimeout(self->primaryLink->linkLayer, &(self->statistics), false);
+
                 self->waitingForResponse = false;
                 self->lastSendTime = currentTime;
                 newState = PLL_TIMEOUT;
 
                 llsc_setState(self, LL_STATE_ERROR);
+
+                llsc_handleTimeout(self, currentTime);
             }
             else
             {
                 DEBUG_PRINT("[SLAVE %i] TIMEOUT: ASDU not confirmed\n", self->address);
 
+                LinkLayer_countTimeout(self->primaryLink->linkLayer, &(self->statistics), true);
+
                 if (self->sendLinkLayerTestFunction)
                 {
                     DEBUG_PRINT("[SLAVE %i] PLL - SEND FC 02 - RESET REMOTE LINK [REPEAT]\n", self->address);
 
-                    SendFixedFrame(self->primaryLink->linkLayer, LL_FC_02_TEST_FUNCTION_FOR_LINK, self->address, true,
-                                   false, !(self->nextFcb), true);
+                    llsc_sendFixedFrame(self, LL_FC_02_TEST_FUNCTION_FOR_LINK, !(self->nextFcb), true);
                 }
                 else
                 {
@@ -2155,7 +2522,7 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
                                             true, false, !(self->nextFcb), true, (Frame) & (self->nextMessage));
                 }
 
-                self->lastSendTime = currentTime;
+                self->lastSendTime = getSendTime(self->primaryLink->linkLayer, currentTime);
             }
         }
 
@@ -2163,7 +2530,7 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
 
     case PLL_EXECUTE_SERVICE_REQUEST_RESPOND:
 
-        if (self->lastSendTime > currentTime)
+        if (self->lastSendTime > getSendTime(self->primaryLink->linkLayer, currentTime))
         {
             /* last sent time not plausible! */
             self->lastSendTime = currentTime;
@@ -2176,32 +2543,36 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
             {
                 DEBUG_PRINT("[SLAVE %i] TIMEOUT: ASDU not confirmed after repeated transmission\n", self->address);
 
+                LinkLayer_countTimeout(self->primaryLink->linkLayer, &(self->statistics), false);
+
                 newState = PLL_IDLE;
                 self->requestClass1Data = false;
                 self->requestClass2Data = false;
 
                 llsc_setState(self, LL_STATE_ERROR);
+
+                llsc_handleTimeout(self, currentTime);
             }
             else
             {
                 DEBUG_PRINT("[SLAVE %i] TIMEOUT: ASDU not confirmed\n", self->address);
 
+                LinkLayer_countTimeout(self->primaryLink->linkLayer, &(self->statistics), true);
+
                 if (self->requestClass1Data)
                 {
                     DEBUG_PRINT("[SLAVE %i] PLL - SEND FC 10 - REQ UD 1 [REPEAT]\n", self->address);
 
-                    SendFixedFrame(self->primaryLink->linkLayer, LL_FC_10_REQUEST_USER_DATA_CLASS_1, self->address,
-                                   true, false, !(self->nextFcb), true);
+                    llsc_sendFixedFrame(self, LL_FC_10_REQUEST_USER_DATA_CLASS_1, !(self->nextFcb), true);
                 }
                 else
                 {
                     DEBUG_PRINT("[SLAVE %i] PLL - SEND FC 11 - REQ UD 2 [REPEAT]\n", self->address);
 
-                    SendFixedFrame(self->primaryLink->linkLayer, LL_FC_11_REQUEST_USER_DATA_CLASS_2, self->address,
-                                   true, false, !(self->nextFcb), true);
+                    llsc_sendFixedFrame(self, LL_FC_11_REQUEST_USER_DATA_CLASS_2, !(self->nextFcb), true);
                 }
 
-                self->lastSendTime = currentTime;
+                self->lastSendTime = getSendTime(self->primaryLink->linkLayer, currentTime);
             }
         }
 
@@ -2220,24 +2591,68 @@ LinkLayerSlaveConnection_runStateMachine(LinkLayerSlaveConnection self)
 static LinkLayerSlaveConnection
 LinkLayerPrimaryUnbalanced_getSlaveConnection(LinkLayerPrimaryUnbalanced self, int slaveAddress)
 {
-    LinkLayerSlaveConnection retVal = NULL;
+    if (self->slaveTableSize == 0)
+        return NULL;
 
-    LinkedList element = LinkedList_getNext(self->slaveConnections);
+    unsigned int mask = (unsigned int)(self->slaveTableSize - 1);
+    unsigned int index = (unsigned int)slaveAddress & mask;
 
-    while (element)
+    /* the table is never full so the probing always terminates at an empty slot */
+    while (self->slaveTable[index])
     {
-        LinkLayerSlaveConnection slaveConnection = (LinkLayerSlaveConnection)LinkedList_getData(element);
-
-        if (slaveConnection->address == slaveAddress)
-        {
-            retVal = slaveConnection;
-            break;
-        }
+        if (self->slaveTable[index]->address == slaveAddress)
+            return self->slaveTable[index];
 
-        element = LinkedList_getNext(element);
+        index = (index + 1) & mask;
     }
 
-    return retVal;
+    return NULL;
+}
+
+static CS101_LinkLayerStatistics*
+LinkLayerPrimaryUnbalanced_getSlaveStatisticsRef(LinkLayerPrimaryUnbalanced self, int slaveAddress)
+{
+    LinkLayerSlaveConnection slave = LinkLayerPrimaryUnbalanced_getSlaveConnection(self, slaveAddress);
+
+    if (slave)
+        return &(slave->statistics);
+    else
+        return NULL;
+}
+
+static void
+insertIntoSlaveTable(LinkLayerSlaveConnection* table, int tableSize, LinkLayerSlaveConnection slaveConnection)
+{
+    unsigned int mask = (unsigned int)(tableSize - 1);
+    unsigned int index = (unsigned int)slaveConnection->address & mask;
+
+    while (table[index])
+        index = (index + 1) & mask;
+
+    table[index] = slaveConnection;
+}
+
+static bool
+resizeSlaveTable(LinkLayerPrimaryUnbalanced self, int newSize)
+{
+    LinkLayerSlaveConnection* newTable =
+        (LinkLayerSlaveConnection*)GLOBAL_CALLOC(newSize, sizeof(LinkLayerSlaveConnection));
+
+    if (newTable == NULL)
+        return false;
+
+    int i;
+
+    for (i = 0; i < self->numberOfSlaves; i++)
+        insertIntoSlaveTable(newTable, newSize, self->slaveConnections[i]);
+
+    if (self->slaveTable)
+        GLOBAL_FREEMEM(self->slaveTable);
+
+    self->slaveTable = newTable;
+    self->slaveTableSize = newSize;
+
+    return true;
 }
 
 void
@@ -2247,9 +2662,45 @@ LinkLayerPrimaryUnbalanced_addSlaveConnection(LinkLayerPrimaryUnbalanced self, i
 
     if (slaveConnection == NULL)
     {
+        if (self->numberOfSlaves == self->maxNumberOfSlaves)
+        {
+            int newMaxNumberOfSlaves = (self->maxNumberOfSlaves == 0) ? 4 : (self->maxNumberOfSlaves * 2);
+
+            LinkLayerSlaveConnection* newSlaveConnections = (LinkLayerSlaveConnection*)GLOBAL_MALLOC(
+                newMaxNumberOfSlaves * sizeof(LinkLayerSlaveConnection));
+
+            if (newSlaveConnections == NULL)
+                return;
+
+            if (self->slaveConnections)
+            {
+                memcpy(newSlaveConnections, self->slaveConnections,
+                       self->numberOfSlaves * sizeof(LinkLayerSlaveConnection));
+
+                GLOBAL_FREEMEM(self->slaveConnections);
+            }
+
+            self->slaveConnections = newSlaveConnections;
+            self->maxNumberOfSlaves = newMaxNumberOfSlaves;
+        }
+
+        /* keep the load factor of the address table below 1/2 */
+        if (((self->numberOfSlaves + 1) * 2) > self->slaveTableSize)
+        {
+            int newSize = (self->slaveTableSize == 0) ? 8 : (self->slaveTableSize * 2);
+
+            if (resizeSlaveTable(self, newSize) == false)
+                return;
+        }
+
         LinkLayerSlaveConnection newSlave = LinkLayerSlaveConnection_create(NULL, self, slaveAddress);
 
-        LinkedList_add(self->slaveConnections, newSlave);
+        if (newSlave)
+        {
+            self->slaveConnections[self->numberOfSlaves++] = newSlave;
+
+            insertIntoSlaveTable(self->slaveTable, self->slaveTableSize, newSlave);
+        }
     }
 }
 
@@ -2392,6 +2843,188 @@ LinkLayerPrimaryUnbalanced_handleMessage(LinkLayerPrimaryUnbalanced self, uint8_
     }
 }
 
+static void
+llsc_checkClass2PollTimer(LinkLayerSlaveConnection self, uint64_t currentTime)
+{
+    if (self->class2PollInterval > 0)
+    {
+        if ((currentTime >= self->nextClass2PollTime) ||
+            (self->nextClass2PollTime > currentTime + (uint64_t)self->class2PollInterval))
+        {
+            self->requestClass2Data = true;
+            self->nextClass2PollTime = currentTime + (uint64_t)self->class2PollInterval;
+        }
+    }
+}
+
+static bool
+llsc_needsService(LinkLayerSlaveConnection self, uint64_t currentTime)
+{
+    switch (self->primaryState)
+    {
+    case PLL_LINK_LAYERS_AVAILABLE:
+
+        llsc_checkClass2PollTimer(self, currentTime);
+
+        return (self->sendLinkLayerTestFunction || llsc_isMessageWaitingToSend(self));
+
+    case PLL_SECONDARY_LINK_LAYER_BUSY:
+        return false;
+
+    default:
+        return true;
+    }
+}
+
+/* default scheduler: every slave gets one state machine step in turn */
+static LinkLayerSlaveConnection
+selectNextSlaveRoundRobin(LinkLayerPrimaryUnbalanced self, uint64_t currentTime)
+{
+    LinkLayerSlaveConnection slave = self->slaveConnections[self->currentSlaveIndex];
+
+    self->currentSlaveIndex++;
+
+    if (self->currentSlaveIndex >= self->numberOfSlaves)
+        self->currentSlaveIndex = 0;
+
+    llsc_checkClass2PollTimer(slave, currentTime);
+
+    return slave;
+}
+
+/*
+ * priority scheduler: slaves signaling ACD are asked for class 1 data immediately, a slave can
+ * keep the line for up to "weight" exchanges, idle slaves are skipped and slaves that repeatedly
+ * time out are not scheduled until their back-off time has elapsed
+ */
+static LinkLayerSlaveConnection
+selectNextSlavePriority(LinkLayerPrimaryUnbalanced self, uint64_t currentTime)
+{
+    LinkLayerSlaveConnection lastSlave = self->lastSlave;
+
+    if (lastSlave)
+    {
+        if (lastSlave->requestClass1Data && (lastSlave->primaryState == PLL_LINK_LAYERS_AVAILABLE) &&
+            (self->class1FollowUps < PLL_MAX_CLASS1_FOLLOW_UPS))
+        {
+            self->class1FollowUps++;
+            return lastSlave;
+        }
+
+        if ((self->remainingTurns > 0) && (lastSlave->backoffUntil <= currentTime) &&
+            llsc_needsService(lastSlave, currentTime))
+        {
+            self->remainingTurns--;
+            return lastSlave;
+        }
+    }
+
+    self->class1FollowUps = 0;
+
+    int i;
+
+    for (i = 0; i < self->numberOfSlaves; i++)
+    {
+        LinkLayerSlaveConnection slave = self->slaveConnections[self->currentSlaveIndex];
+
+        self->currentSlaveIndex++;
+
+        if (self->currentSlaveIndex >= self->numberOfSlaves)
+            self->currentSlaveIndex = 0;
+
+        if (slave->backoffUntil > currentTime)
+        {
+            /* time jumped backwards */
+            if (slave->backoffUntil > currentTime + (uint64_t)self->maxBackoff)
+                slave->backoffUntil = currentTime;
+            else
+                continue;
+        }
+
+        if (llsc_needsService(slave, currentTime))
+        {
+            self->lastSlave = slave;
+            self->remainingTurns = slave->weight - 1;
+
+            return slave;
+        }
+    }
+
+    self->lastSlave = NULL;
+
+    return NULL;
+}
+
+void
+LinkLayerPrimaryUnbalanced_setPriorityScheduling(LinkLayerPrimaryUnbalanced self, bool enable)
+{
+    if (enable)
+        self->selectNextSlave = selectNextSlavePriority;
+    else
+        self->selectNextSlave = selectNextSlaveRoundRobin;
+
+    self->lastSlave = NULL;
+    self->remainingTurns = 0;
+    self->class1FollowUps = 0;
+}
+
+bool
+LinkLayerPrimaryUnbalanced_setSlavePollParameters(LinkLayerPrimaryUnbalanced self, int slaveAddress, int weight,
+                                                  int class2PollInterval)
+{
+    LinkLayerSlaveConnection slave = LinkLayerPrimaryUnbalanced_getSlaveConnection(self, slaveAddress);
+
+    if (slave)
+    {
+        slave->weight = (weight < 1) ? 1 : weight;
+        slave->class2PollInterval = (class2PollInterval < 0) ? 0 : class2PollInterval;
+        slave->nextClass2PollTime = 0;
+
+        return true;
+    }
+
+    return false;
+}
+
+void
+LinkLayerPrimaryUnbalanced_setTimeoutBackoff(LinkLayerPrimaryUnbalanced self, int initialBackoff, int maxBackoff)
+{
+    self->initialBackoff = (initialBackoff < 0) ? 0 : initialBackoff;
+    self->maxBackoff = (maxBackoff < self->initialBackoff) ? self->initialBackoff : maxBackoff;
+}
+
+void
+LinkLayerPrimaryUnbalanced_getStatistics(LinkLayerPrimaryUnbalanced self, CS101_LinkLayerStatistics* statistics)
+{
+    LinkLayer_getStatistics(self->linkLayer, statistics);
+}
+
+bool
+LinkLayerPrimaryUnbalanced_getSlaveStatistics(LinkLayerPrimaryUnbalanced self, int slaveAddress,
+                                              CS101_LinkLayerStatistics* statistics)
+{
+    CS101_LinkLayerStatistics* slaveStatistics = LinkLayerPrimaryUnbalanced_getSlaveStatisticsRef(self, slaveAddress);
+
+    if (slaveStatistics)
+    {
+        *statistics = *slaveStatistics;
+        return true;
+    }
+
+    return false;
+}
+
+void
+LinkLayerPrimaryUnbalanced_resetStatistics(LinkLayerPrimaryUnbalanced self)
+{
+    LinkLayer_resetStatistics(self->linkLayer);
+
+    int i;
+
+    for (i = 0; i < self->numberOfSlaves; i++)
+        memset(&(self->slaveConnections[i]->statistics), 0, sizeof(struct sCS101_LinkLayerStatistics));
+}
+
 void
 LinkLayerPrimaryUnbalanced_runStateMachine(LinkLayerPrimaryUnbalanced self)
 {
@@ -2407,7 +3040,7 @@ LinkLayerPrimaryUnbalanced_runStateMachine(LinkLayerPrimaryUnbalanced self)
     }
 
     /* run all the link layer state machines for the registered slaves */
-    if (LinkedList_size(self->slaveConnections) > 0)
+    if (self->numberOfSlaves > 0)
     {
 
         if (self->currentSlave != NULL)
@@ -2419,9 +3052,7 @@ LinkLayerPrimaryUnbalanced_runStateMachine(LinkLayerPrimaryUnbalanced self)
         if (self->currentSlave == NULL)
         {
             /* schedule next slave connection */
-            self->currentSlave = (LinkLayerSlaveConnection)LinkedList_getData(
-                LinkedList_get(self->slaveConnections, self->currentSlaveIndex));
-            self->currentSlaveIndex = (self->currentSlaveIndex + 1) % LinkedList_size(self->slaveConnections);
+            self->currentSlave = self->selectNextSlave(self, Hal_getMonotonicTimeInMs());
         }
 
         if (self->currentSlave)
@@ -2434,7 +3065,7 @@ LinkLayerPrimaryUnbalanced_run(LinkLayerPrimaryUnbalanced self)
 {
     LinkLayer ll = self->linkLayer;
 
-    SerialTransceiverFT12_readNextMessage(ll->transceiver, ll->buffer, HandleMessageBalancedAndPrimaryUnbalanced,
+    SerialTransceiverFT12_readNextMessage(ll->transceiver, ll->recvBuffer, HandleMessageBalancedAndPrimaryUnbalanced,
                                           (void*)ll);
 
     LinkLayerPrimaryUnbalanced_runStateMachine(self);
@@ -23,11 +23,16 @@
 
 #include "hal_serial.h"
 #include "serial_transceiver_ft_1_2.h"
+#include "hal_time.h"
 #include "lib_memory.h"
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include "lib60870_internal.h"
 
+/* has to be a power of two and larger than the maximum frame size (261 bytes) */
+#define RX_BUFFER_SIZE 512
+
 struct sSerialTransceiverFT12 {
     int messageTimeout;
     int characterTimeout;
@@ -35,6 +40,22 @@ struct sSerialTransceiverFT12 {
     SerialPort serialPort;
     IEC60870_RawMessageHandler rawMessageHandler;
     void* rawMessageHandlerParameter;
+
+    /* receive ring buffer - filled with bulk reads from the serial port */
+    uint8_t rxBuffer[RX_BUFFER_SIZE];
+    int rxStart;
+    int rxCount;
+    uint64_t lastRxTime; /* time when the last bytes were received (monotonic ms) */
+
+    bool nonBlocking; /* don't wait for data in readNextMessage (used by event loops) */
+
+    /* statistics */
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint32_t framesSent;
+    uint32_t framesReceived;
+    uint32_t syncErrors;
+    uint32_t characterTimeouts;
 };
 
 SerialTransceiverFT12
@@ -48,6 +69,12 @@ SerialTransceiverFT12_create(SerialPort serialPort, LinkLayerParameters linkLaye
         self->linkLayerParameters = linkLayerParameters;
         self->serialPort = serialPort;
         self->rawMessageHandler = NULL;
+        self->rxStart = 0;
+        self->rxCount = 0;
+        self->lastRxTime = 0;
+        self->nonBlocking = false;
+
+        SerialTransceiverFT12_resetStatistics(self);
     }
 
     return self;
@@ -80,48 +107,278 @@ SerialTransceiverFT12_getBaudRate(SerialTransceiverFT12 self)
     return SerialPort_getBaudRate(self->serialPort);
 }
 
+uint64_t
+SerialTransceiverFT12_getTransmitCompleteTime(SerialTransceiverFT12 self)
+{
+    return SerialPort_getTransmitCompleteTime(self->serialPort);
+}
+
+SerialPort
+SerialTransceiverFT12_getSerialPort(SerialTransceiverFT12 self)
+{
+    return self->serialPort;
+}
+
+void
+SerialTransceiverFT12_setNonBlocking(SerialTransceiverFT12 self, bool nonBlocking)
+{
+    self->nonBlocking = nonBlocking;
+}
+
+void
+SerialTransceiverFT12_getStatistics(SerialTransceiverFT12 self, CS101_LinkLayerStatistics* statistics)
+{
+    statistics->bytesSent = self->bytesSent;
+    statistics->bytesReceived = self->bytesReceived;
+    statistics->framesSent = self->framesSent;
+    statistics->framesReceived = self->framesReceived;
+    statistics->syncErrors = self->syncErrors;
+    statistics->characterTimeouts = self->characterTimeouts;
+}
+
+void
+SerialTransceiverFT12_resetStatistics(SerialTransceiverFT12 self)
+{
+    self->bytesSent = 0;
+    self->bytesReceived = 0;
+    self->framesSent = 0;
+    self->framesReceived = 0;
+    self->syncErrors = 0;
+    self->characterTimeouts = 0;
+}
+
 void
 SerialTransceiverFT12_sendMessage(SerialTransceiverFT12 self, uint8_t* msg, int msgSize)
 {
+    self->bytesSent += msgSize;
+    self->framesSent++;
+
     if (self->rawMessageHandler)
         self->rawMessageHandler(self->rawMessageHandlerParameter, msg, msgSize, true);
 
     SerialPort_write(self->serialPort, msg, 0, msgSize);
 }
 
+/**
+ * Receive the available bytes from the serial port into the ring buffer
+ *
+ * \return number of received bytes (0 in case of timeout or error)
+ */
+static int
+fillRxBuffer(SerialTransceiverFT12 self, int timeout)
+{
+    if (self->rxCount == 0)
+        self->rxStart = 0;
+
+    int rxEnd = (self->rxStart + self->rxCount) & (RX_BUFFER_SIZE - 1);
+
+    /* read into the contiguous free space after the end of the buffered data */
+    int maxSize;
+
+    if (rxEnd >= self->rxStart)
+        maxSize = RX_BUFFER_SIZE - rxEnd;
+    else
+        maxSize = self->rxStart - rxEnd;
+
+    if ((self->rxCount == RX_BUFFER_SIZE) || (maxSize == 0))
+        return 0;
+
+    int readBytes = SerialPort_read(self->serialPort, self->rxBuffer + rxEnd, maxSize, timeout);
+
+    if (readBytes > 0) {
+        self->rxCount += readBytes;
+        self->bytesReceived += readBytes;
+        self->lastRxTime = Hal_getMonotonicTimeInMs();
+
+        return readBytes;
+    }
+
+    return 0;
+}
+
+/**
+ * Get the next byte from the ring buffer - wait for new bytes when the buffer is empty
+ *
+ * \return the next byte or -1 in case of timeout
+ */
+static int
+readByteWithTimeout(SerialTransceiverFT12 self, int timeout)
+{
+    if (self->rxCount == 0) {
+        if (fillRxBuffer(self, timeout) == 0)
+            return -1;
+    }
+
+    int value = self->rxBuffer[self->rxStart];
+
+    self->rxStart = (self->rxStart + 1) & (RX_BUFFER_SIZE - 1);
+    self->rxCount--;
+
+    return value;
+}
+
+/**
+ * Get the time to wait for the next character
+ *
+ * The character timeout is measured from the time when the last bytes were received
+ * (and not from the time the frame parser requests the next byte).
+ */
+static int
+getCharacterWaitTime(SerialTransceiverFT12 self)
+{
+    uint64_t currentTime = Hal_getMonotonicTimeInMs();
+    uint64_t deadline = self->lastRxTime + (uint64_t) self->characterTimeout;
+
+    if (currentTime >= deadline)
+        return 0; /* only check for bytes already received by the OS */
+
+    return (int) (deadline - currentTime);
+}
+
 static int
 readBytesWithTimeout(SerialTransceiverFT12 self, uint8_t* buffer, int startIndex, int count)
 {
-    int readByte;
     int readBytes = 0;
 
-    while ((readByte = SerialPort_readByte(self->serialPort)) != -1) {
-        buffer[startIndex++] = (uint8_t) readByte;
+    while (readBytes < count) {
+
+        if (self->rxCount == 0) {
+            if (fillRxBuffer(self, getCharacterWaitTime(self)) == 0)
+                break;
+        }
+
+        /* copy the contiguous part of the buffered data */
+        int available = RX_BUFFER_SIZE - self->rxStart;
+
+        if (available > self->rxCount)
+            available = self->rxCount;
+
+        if (available > (count - readBytes))
+            available = count - readBytes;
+
+        memcpy(buffer + startIndex + readBytes, self->rxBuffer + self->rxStart, available);
 
-        readBytes++;
+        self->rxStart = (self->rxStart + available) & (RX_BUFFER_SIZE - 1);
+        self->rxCount -= available;
 
-        if (readBytes >= count)
-            break;
+        readBytes += available;
     }
 
     return readBytes;
 }
 
+static void
+discardInBuffer(SerialTransceiverFT12 self)
+{
+    self->rxStart = 0;
+    self->rxCount = 0;
+
+    SerialPort_discardInBuffer(self->serialPort);
+}
+
+/**
+ * Get the length of the frame at the start of the ring buffer
+ *
+ * \return the frame length, 0 when the buffer doesn't start with a valid start character,
+ *         or -1 when the length is not yet known
+ */
+static int
+getFrameLength(SerialTransceiverFT12 self)
+{
+    if (self->rxCount == 0)
+        return -1;
+
+    uint8_t startCharacter = self->rxBuffer[self->rxStart];
+
+    if (startCharacter == 0x68) {
+        if (self->rxCount < 2)
+            return -1;
+
+        return self->rxBuffer[(self->rxStart + 1) & (RX_BUFFER_SIZE - 1)] + 6;
+    }
+    else if (startCharacter == 0x10)
+        return 4 + self->linkLayerParameters->addressLength;
+    else if (startCharacter == 0xe5)
+        return 1;
+    else
+        return 0;
+}
+
+bool
+SerialTransceiverFT12_isMessageAvailable(SerialTransceiverFT12 self)
+{
+    int frameLength = getFrameLength(self);
+
+    return (frameLength == 0) || ((frameLength > 0) && (self->rxCount >= frameLength));
+}
+
+/**
+ * Handle the next message without waiting - the same framing rules as in the blocking
+ * version apply, but incomplete frames are kept in the buffer until the character timeout.
+ */
+static void
+readNextMessageNonBlocking(SerialTransceiverFT12 self, uint8_t* buffer,
+        SerialTXMessageHandler messageHandler, void* parameter)
+{
+    /* receive all bytes that are already available */
+    while ((self->rxCount < RX_BUFFER_SIZE) && (fillRxBuffer(self, 0) > 0));
+
+    if (self->rxCount == 0)
+        return;
+
+    int msgSize = getFrameLength(self);
+
+    if (msgSize == 0) {
+        DEBUG_PRINT("RECV: SYNC ERROR\n");
+
+        self->syncErrors++;
+
+        discardInBuffer(self);
+
+        return;
+    }
+
+    if ((msgSize == -1) || (self->rxCount < msgSize)) {
+
+        if (Hal_getMonotonicTimeInMs() > (self->lastRxTime + (uint64_t) self->characterTimeout)) {
+            DEBUG_PRINT("RECV: Timeout reading frame size = %i (expected = %i)\n", self->rxCount, msgSize);
+
+            self->characterTimeouts++;
+
+            /* drop the incomplete frame */
+            self->rxStart = 0;
+            self->rxCount = 0;
+        }
+
+        return;
+    }
+
+    readBytesWithTimeout(self, buffer, 0, msgSize);
+
+    self->framesReceived++;
+
+    if (self->rawMessageHandler)
+        self->rawMessageHandler(self->rawMessageHandlerParameter, buffer, msgSize, false);
+
+    messageHandler(parameter, buffer, msgSize);
+}
+
 void
 SerialTransceiverFT12_readNextMessage(SerialTransceiverFT12 self, uint8_t* buffer,
         SerialTXMessageHandler messageHandler, void* parameter)
 {
-    SerialPort_setTimeout(self->serialPort, self->messageTimeout);
+    if (self->nonBlocking) {
+        readNextMessageNonBlocking(self, buffer, messageHandler, parameter);
+        return;
+    }
 
-    int read = SerialPort_readByte(self->serialPort);
+    int read = readByteWithTimeout(self, self->messageTimeout);
 
     if (read != -1) {
 
         if (read == 0x68) {
 
-            SerialPort_setTimeout(self->serialPort, self->characterTimeout);
-
-            int msgSize = SerialPort_readByte(self->serialPort);
+            int msgSize = readByteWithTimeout(self, getCharacterWaitTime(self));
 
             if (msgSize == -1)
                 goto sync_error;
@@ -136,6 +393,8 @@ SerialTransceiverFT12_readNextMessage(SerialTransceiverFT12 self, uint8_t* buffe
             if (readBytes == msgSize) {
                 msgSize += 2;
 
+                self->framesReceived++;
+
                 if (self->rawMessageHandler)
                     self->rawMessageHandler(self->rawMessageHandlerParameter, buffer, msgSize, false);
 
@@ -143,13 +402,13 @@ SerialTransceiverFT12_readNextMessage(SerialTransceiverFT12 self, uint8_t* buffe
             }
             else {
                 DEBUG_PRINT("RECV: Timeout reading variable length frame size = %i (expected = %i)\n", readBytes, msgSize);
+
+                self->characterTimeouts++;
             }
 
         }
         else if (read == 0x10) {
 
-            SerialPort_setTimeout(self->serialPort, self->characterTimeout);
-
             buffer[0] = 0x10;
 
             int msgSize = 3 + self->linkLayerParameters->addressLength;
@@ -159,6 +418,8 @@ SerialTransceiverFT12_readNextMessage(SerialTransceiverFT12 self, uint8_t* buffe
             if (readBytes == msgSize) {
                 msgSize += 1;
 
+                self->framesReceived++;
+
                 if (self->rawMessageHandler)
                     self->rawMessageHandler(self->rawMessageHandlerParameter, buffer, msgSize, false);
 
@@ -166,6 +427,8 @@ SerialTransceiverFT12_readNextMessage(SerialTransceiverFT12 self, uint8_t* buffe
             }
             else {
                 DEBUG_PRINT("RECV: Timeout reading fixed length frame size = %i (expected = %i)\n", readBytes, msgSize);
+
+                self->characterTimeouts++;
             }
 
         }
@@ -173,6 +436,8 @@ SerialTransceiverFT12_readNextMessage(SerialTransceiverFT12 self, uint8_t* buffe
             int msgSize = 1;
             buffer[0] = (uint8_t) read;
 
+            self->framesReceived++;
+
             if (self->rawMessageHandler)
                 self->rawMessageHandler(self->rawMessageHandlerParameter, buffer, msgSize, false);
 
@@ -190,7 +455,9 @@ sync_error:
 
     DEBUG_PRINT("RECV: SYNC ERROR\n");
 
-    SerialPort_discardInBuffer(self->serialPort);
+    self->syncErrors++;
+
+    discardInBuffer(self);
 
     return;
 }
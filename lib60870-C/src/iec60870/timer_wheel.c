@@ -0,0 +1,432 @@
+/*
+ *  timer_wheel.c
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#include "timer_wheel.h"
+#include "lib_memory.h"
+
+struct sTimerWheel
+{
+    struct sTimerWheelEntry* slots; /* list heads (circular doubly linked lists) - TIMER_WHEEL_LEVELS * numberOfSlots */
+    int numberOfSlots;
+    int slotBits; /* log2(numberOfSlots) */
+    int resolution;
+
+    uint64_t lastTick; /* all slots up to this tick are processed */
+    int numberOfTimers;
+    int timersInLevel[TIMER_WHEEL_LEVELS];
+};
+
+static void
+listInit(TimerWheelEntry head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static void
+listAppend(TimerWheelEntry head, TimerWheelEntry entry)
+{
+    entry->prev = head->prev;
+    entry->next = head;
+    head->prev->next = entry;
+    head->prev = entry;
+}
+
+static void
+listUnlink(TimerWheelEntry entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->next = NULL;
+    entry->prev = NULL;
+}
+
+/* move all entries of the list to the (empty) list newHead */
+static void
+listMove(TimerWheelEntry head, TimerWheelEntry newHead)
+{
+    if (head->next == head) {
+        listInit(newHead);
+    }
+    else {
+        newHead->next = head->next;
+        newHead->prev = head->prev;
+        newHead->next->prev = newHead;
+        newHead->prev->next = newHead;
+
+        listInit(head);
+    }
+}
+
+static TimerWheelEntry
+getSlot(TimerWheel self, int level, uint64_t index)
+{
+    return &(self->slots[(level * self->numberOfSlots) + (int) (index & (uint64_t) (self->numberOfSlots - 1))]);
+}
+
+/* tick when the timer is expired by TimerWheel_advance */
+static uint64_t
+getExpiryTick(TimerWheel self, TimerWheelEntry entry)
+{
+    /* round up - a timer never expires before its expiry time */
+    uint64_t tick = (entry->expiryTime + self->resolution - 1) / self->resolution;
+
+    /* slots up to lastTick are already processed */
+    if (tick <= self->lastTick)
+        tick = self->lastTick + 1;
+
+    return tick;
+}
+
+/* store the entry in the lowest level that can hold the expiry tick */
+static void
+insertEntry(TimerWheel self, TimerWheelEntry entry)
+{
+    uint64_t tick = getExpiryTick(self, entry);
+
+    int level;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        int shift = level * self->slotBits;
+
+        if ((tick >> shift) - (self->lastTick >> shift) <= (uint64_t) self->numberOfSlots) {
+            listAppend(getSlot(self, level, tick >> shift), entry);
+            break;
+        }
+    }
+
+    if (level == TIMER_WHEEL_LEVELS) {
+        /* beyond the range of the wheel - the timer is moved again when the wheel reaches the last slot */
+        level = TIMER_WHEEL_LEVELS - 1;
+
+        listAppend(getSlot(self, level, self->lastTick >> (level * self->slotBits)), entry);
+    }
+
+    entry->level = level;
+    self->timersInLevel[level]++;
+}
+
+static void
+removeEntry(TimerWheel self, TimerWheelEntry entry)
+{
+    listUnlink(entry);
+    self->timersInLevel[entry->level]--;
+}
+
+TimerWheel
+TimerWheel_create(int numberOfSlots, int resolutionInMs, uint64_t currentTime)
+{
+    TimerWheel self = (TimerWheel) GLOBAL_MALLOC(sizeof(struct sTimerWheel));
+
+    if (self) {
+        self->slots = (struct sTimerWheelEntry*) GLOBAL_MALLOC(TIMER_WHEEL_LEVELS * numberOfSlots * sizeof(struct sTimerWheelEntry));
+
+        if (self->slots == NULL) {
+            GLOBAL_FREEMEM(self);
+            return NULL;
+        }
+
+        int i;
+
+        for (i = 0; i < TIMER_WHEEL_LEVELS * numberOfSlots; i++)
+            listInit(&(self->slots[i]));
+
+        for (i = 0; i < TIMER_WHEEL_LEVELS; i++)
+            self->timersInLevel[i] = 0;
+
+        self->numberOfSlots = numberOfSlots;
+        self->slotBits = 0;
+
+        while ((1 << self->slotBits) < numberOfSlots)
+            self->slotBits++;
+
+        self->resolution = (resolutionInMs > 0) ? resolutionInMs : 1;
+        self->lastTick = currentTime / self->resolution;
+        self->numberOfTimers = 0;
+    }
+
+    return self;
+}
+
+void
+TimerWheel_destroy(TimerWheel self)
+{
+    if (self) {
+        int i;
+
+        /* mark the remaining timers as not scheduled */
+        for (i = 0; i < TIMER_WHEEL_LEVELS * self->numberOfSlots; i++) {
+            TimerWheelEntry head = &(self->slots[i]);
+
+            while (head->next != head) {
+                TimerWheelEntry entry = head->next;
+
+                listUnlink(entry);
+                entry->isScheduled = false;
+            }
+        }
+
+        GLOBAL_FREEMEM(self->slots);
+        GLOBAL_FREEMEM(self);
+    }
+}
+
+void
+TimerWheelEntry_initialize(TimerWheelEntry entry, TimerWheelHandler handler, void* parameter)
+{
+    entry->next = NULL;
+    entry->prev = NULL;
+    entry->expiryTime = 0;
+    entry->isScheduled = false;
+    entry->level = 0;
+    entry->handler = handler;
+    entry->parameter = parameter;
+}
+
+void
+TimerWheel_schedule(TimerWheel self, TimerWheelEntry entry, uint64_t expiryTime)
+{
+    if (entry->isScheduled)
+        TimerWheel_cancel(self, entry);
+
+    entry->expiryTime = expiryTime;
+    entry->isScheduled = true;
+
+    insertEntry(self, entry);
+
+    self->numberOfTimers++;
+}
+
+void
+TimerWheel_cancel(TimerWheel self, TimerWheelEntry entry)
+{
+    if (entry->isScheduled) {
+        removeEntry(self, entry);
+        entry->isScheduled = false;
+
+        self->numberOfTimers--;
+    }
+}
+
+int
+TimerWheel_getNextTimeout(TimerWheel self, uint64_t currentTime, int maxTimeout)
+{
+    if (self->numberOfTimers == 0)
+        return maxTimeout;
+
+    uint64_t nextTick = UINT64_MAX;
+
+    uint64_t maxTick = (currentTime + maxTimeout) / self->resolution + 1;
+
+    int level;
+
+    /* the first non-empty slot of each level contains the next timer of the level */
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (self->timersInLevel[level] == 0)
+            continue;
+
+        int shift = level * self->slotBits;
+        uint64_t index = self->lastTick >> shift;
+        int i;
+
+        for (i = 1; i <= self->numberOfSlots; i++) {
+            uint64_t slotTick = (index + i) << shift;
+
+            if ((slotTick >= nextTick) || (slotTick > maxTick))
+                break;
+
+            TimerWheelEntry head = getSlot(self, level, index + i);
+
+            if (head->next != head) {
+                if (level == 0) {
+                    nextTick = slotTick;
+                }
+                else {
+                    TimerWheelEntry entry;
+
+                    for (entry = head->next; entry != head; entry = entry->next) {
+                        uint64_t tick = getExpiryTick(self, entry);
+
+                        if (tick < nextTick)
+                            nextTick = tick;
+                    }
+                }
+
+                break;
+            }
+        }
+    }
+
+    if (nextTick == UINT64_MAX)
+        return maxTimeout;
+
+    uint64_t nextTime = nextTick * self->resolution;
+
+    if (nextTime <= currentTime)
+        return 0;
+
+    if (nextTime - currentTime < (uint64_t) maxTimeout)
+        return (int) (nextTime - currentTime);
+    else
+        return maxTimeout;
+}
+
+/* move the timers of the higher level slots that start with this tick to the lower levels (self->lastTick = tick - 1) */
+static void
+cascade(TimerWheel self, uint64_t tick)
+{
+    int level;
+
+    for (level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+        int shift = level * self->slotBits;
+
+        if ((tick & ((((uint64_t) 1) << shift) - 1)) != 0)
+            continue;
+
+        if (self->timersInLevel[level] == 0)
+            continue;
+
+        struct sTimerWheelEntry entries;
+
+        listMove(getSlot(self, level, tick >> shift), &entries);
+
+        while (entries.next != &entries) {
+            TimerWheelEntry entry = entries.next;
+
+            listUnlink(entry);
+            self->timersInLevel[level]--;
+
+            insertEntry(self, entry);
+        }
+    }
+}
+
+static void
+collectAllTimers(TimerWheel self, TimerWheelEntry list)
+{
+    int i;
+
+    for (i = 0; i < TIMER_WHEEL_LEVELS * self->numberOfSlots; i++) {
+        TimerWheelEntry head = &(self->slots[i]);
+
+        while (head->next != head) {
+            TimerWheelEntry entry = head->next;
+
+            listUnlink(entry);
+            listAppend(list, entry);
+        }
+    }
+
+    for (i = 0; i < TIMER_WHEEL_LEVELS; i++)
+        self->timersInLevel[i] = 0;
+}
+
+int
+TimerWheel_advance(TimerWheel self, uint64_t currentTime)
+{
+    uint64_t currentTick = currentTime / self->resolution;
+
+    if (currentTick <= self->lastTick)
+        return 0;
+
+    struct sTimerWheelEntry expired;
+    listInit(&expired);
+
+    /* collect the expired timers first - the handlers can modify the wheel */
+    if (currentTick - self->lastTick > ((uint64_t) self->numberOfSlots << self->slotBits)) {
+        /* large time step (e.g. time jump) - sort all timers again instead of walking the wheel */
+        struct sTimerWheelEntry timers;
+        listInit(&timers);
+
+        collectAllTimers(self, &timers);
+
+        self->lastTick = currentTick;
+
+        while (timers.next != &timers) {
+            TimerWheelEntry entry = timers.next;
+
+            listUnlink(entry);
+
+            if (entry->expiryTime <= currentTime)
+                listAppend(&expired, entry);
+            else
+                insertEntry(self, entry);
+        }
+    }
+    else {
+        while (self->lastTick < currentTick) {
+            /* skip the ticks until the next slot of the lowest level that has timers */
+            int level = 0;
+
+            while ((level < TIMER_WHEEL_LEVELS) && (self->timersInLevel[level] == 0))
+                level++;
+
+            if (level == TIMER_WHEEL_LEVELS) {
+                self->lastTick = currentTick;
+                break;
+            }
+
+            int shift = level * self->slotBits;
+            uint64_t tick = ((self->lastTick >> shift) + 1) << shift;
+
+            if (tick > currentTick) {
+                self->lastTick = currentTick;
+                break;
+            }
+
+            self->lastTick = tick - 1;
+
+            cascade(self, tick);
+
+            /* all timers of the first level slot expire with this tick */
+            TimerWheelEntry head = getSlot(self, 0, tick);
+
+            while (head->next != head) {
+                TimerWheelEntry entry = head->next;
+
+                removeEntry(self, entry);
+                listAppend(&expired, entry);
+            }
+
+            self->lastTick = tick;
+        }
+    }
+
+    int expiredTimers = 0;
+
+    while (expired.next != &expired) {
+        TimerWheelEntry entry = expired.next;
+
+        listUnlink(entry);
+
+        entry->isScheduled = false;
+        self->numberOfTimers--;
+
+        expiredTimers++;
+
+        if (entry->handler)
+            entry->handler(entry->parameter);
+    }
+
+    return expiredTimers;
+}
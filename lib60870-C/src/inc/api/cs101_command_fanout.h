@@ -0,0 +1,264 @@
+/*
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_API_CS101_COMMAND_FANOUT_H_
+#define SRC_INC_API_CS101_COMMAND_FANOUT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iec60870_common.h"
+#include "cs101_information_objects.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file cs101_command_fanout.h
+ * \brief Send a station command (interrogation, counter interrogation, clock synchronization) to many stations
+ */
+
+/**
+ * @addtogroup MASTER Master related functions
+ *
+ * @{
+ */
+
+/**
+ * @defgroup COMMAND_FANOUT Command fan-out
+ *
+ * The command fan-out sends the same command to a set of targets. A target is a common address (CA) of
+ * a station that is reached by a CS101_Master (link layer address) or a CS104_Connection. The number of
+ * outstanding commands and the interval between two commands can be limited to avoid response storms.
+ * For unbalanced CS101 masters the command can be sent once with the broadcast address to all targets
+ * of the master.
+ *
+ * The fan-out has to be attached to the masters and connections of the targets (\ref CS101_Master_setCommandFanOut,
+ * \ref CS104_Connection_setCommandFanOut) to track the ACT_CON and ACT_TERM messages of the targets. The
+ * application calls \ref CS101_CommandFanOut_run periodically until all targets are finished.
+ *
+ * @{
+ */
+
+typedef struct sCS101_CommandFanOut* CS101_CommandFanOut;
+
+struct sCS101_Master;
+struct sCS104_Connection;
+
+/**
+ * \brief State of a command fan-out target
+ */
+typedef enum {
+    CS101_FANOUT_TARGET_PENDING = 0,   /**< command not sent yet */
+    CS101_FANOUT_TARGET_SENT = 1,      /**< command sent - waiting for ACT_CON */
+    CS101_FANOUT_TARGET_CONFIRMED = 2, /**< positive ACT_CON received - waiting for ACT_TERM */
+    CS101_FANOUT_TARGET_COMPLETED = 3, /**< command completed */
+    CS101_FANOUT_TARGET_NEGATIVE = 4,  /**< negative ACT_CON received */
+    CS101_FANOUT_TARGET_TIMEOUT = 5    /**< no response within the timeout */
+} CS101_FanOutTargetState;
+
+/**
+ * \brief Aggregate result of a command fan-out
+ */
+typedef struct sCS101_FanOutResult CS101_FanOutResult;
+
+struct sCS101_FanOutResult
+{
+    int targets;          /**< number of targets */
+    int completed;        /**< targets in state COMPLETED */
+    int negative;         /**< targets in state NEGATIVE */
+    int timedOut;         /**< targets in state TIMEOUT */
+    int pending;          /**< targets that are not finished */
+    int commandsSent;     /**< number of sent messages (a broadcast counts as one message) */
+    int broadcastsSent;   /**< number of sent broadcast messages */
+    int completionTimeMs; /**< time from start until the last target was finished */
+    int meanTargetTimeMs; /**< mean time from sending the command until completion of a target */
+    int maxTargetTimeMs;  /**< maximum time from sending the command until completion of a target */
+};
+
+/**
+ * \brief Create a new command fan-out instance
+ *
+ * Default: interrogation command (station interrogation), no concurrency limit, no pacing,
+ * 30 s timeout, no broadcast.
+ *
+ * \return the new instance
+ */
+CS101_CommandFanOut
+CS101_CommandFanOut_create(void);
+
+/**
+ * \brief Destroy the command fan-out instance
+ *
+ * NOTE: The fan-out has to be detached from all masters and connections before.
+ */
+void
+CS101_CommandFanOut_destroy(CS101_CommandFanOut self);
+
+/**
+ * \brief Send an interrogation command (C_IC_NA_1) - completed by ACT_TERM
+ *
+ * \param qoi qualifier of interrogation (20 for station interrogation)
+ */
+void
+CS101_CommandFanOut_setInterrogationCommand(CS101_CommandFanOut self, QualifierOfInterrogation qoi);
+
+/**
+ * \brief Send a counter interrogation command (C_CI_NA_1) - completed by ACT_TERM
+ *
+ * \param qcc qualifier of counter interrogation
+ */
+void
+CS101_CommandFanOut_setCounterInterrogationCommand(CS101_CommandFanOut self, uint8_t qcc);
+
+/**
+ * \brief Send a clock synchronization command (C_CS_NA_1) - completed by ACT_CON
+ *
+ * Broadcast clock synchronization commands are not confirmed. The targets are completed when the
+ * broadcast message is sent.
+ *
+ * \param time the time to send or NULL to use the current time when the command is sent
+ */
+void
+CS101_CommandFanOut_setClockSyncCommand(CS101_CommandFanOut self, CP56Time2a time);
+
+/**
+ * \brief Set the maximum number of targets with an outstanding command
+ *
+ * \param maxOutstanding maximum number of outstanding commands (0 = unlimited)
+ */
+void
+CS101_CommandFanOut_setConcurrency(CS101_CommandFanOut self, int maxOutstanding);
+
+/**
+ * \brief Set the minimum interval between two sent commands
+ *
+ * \param intervalInMs interval in ms (0 = no pacing)
+ */
+void
+CS101_CommandFanOut_setPacing(CS101_CommandFanOut self, int intervalInMs);
+
+/**
+ * \brief Set the time to wait for the completion of a target after the command was sent
+ *
+ * \param timeoutInMs timeout in ms
+ */
+void
+CS101_CommandFanOut_setTimeout(CS101_CommandFanOut self, int timeoutInMs);
+
+/**
+ * \brief Send the command with the broadcast link address and broadcast CA when possible
+ *
+ * Only used for targets of unbalanced CS101 masters. All targets of a master get the command with a
+ * single message.
+ *
+ * \param useBroadcast true to use broadcast messages, false otherwise (default)
+ */
+void
+CS101_CommandFanOut_setUseBroadcast(CS101_CommandFanOut self, bool useBroadcast);
+
+/**
+ * \brief Add a target that is reached by a CS 101 master
+ *
+ * \param master the CS101_Master instance
+ * \param linkLayerAddress link layer address of the slave (only used in unbalanced mode)
+ * \param ca the common address of the target
+ *
+ * \return index of the target or -1 when the target cannot be added
+ */
+int
+CS101_CommandFanOut_addCS101Target(CS101_CommandFanOut self, struct sCS101_Master* master, int linkLayerAddress, int ca);
+
+/**
+ * \brief Add a target that is reached by a CS 104 connection
+ *
+ * \param connection the CS104_Connection instance
+ * \param ca the common address of the target
+ *
+ * \return index of the target or -1 when the target cannot be added
+ */
+int
+CS101_CommandFanOut_addCS104Target(CS101_CommandFanOut self, struct sCS104_Connection* connection, int ca);
+
+/**
+ * \brief Reset all targets to PENDING and start the fan-out
+ */
+void
+CS101_CommandFanOut_start(CS101_CommandFanOut self);
+
+/**
+ * \brief Send commands to pending targets and check the timeouts
+ *
+ * Has to be called periodically after \ref CS101_CommandFanOut_start.
+ *
+ * \return true when all targets are finished, false otherwise
+ */
+bool
+CS101_CommandFanOut_run(CS101_CommandFanOut self);
+
+/**
+ * \brief Check if all targets are finished (completed, negative or timeout)
+ */
+bool
+CS101_CommandFanOut_isFinished(CS101_CommandFanOut self);
+
+/**
+ * \brief Get the state of a target
+ *
+ * \param index the index returned when the target was added
+ */
+CS101_FanOutTargetState
+CS101_CommandFanOut_getTargetState(CS101_CommandFanOut self, int index);
+
+/**
+ * \brief Get the aggregate result of the fan-out
+ *
+ * \param result the structure that receives the result
+ */
+void
+CS101_CommandFanOut_getResult(CS101_CommandFanOut self, CS101_FanOutResult* result);
+
+/**
+ * \brief Track the responses of the targets
+ *
+ * Is called automatically when the fan-out is attached to a master or connection.
+ *
+ * \param source the CS101_Master or CS104_Connection that received the ASDU
+ * \param address the link layer address of the sender (CS 101 unbalanced mode)
+ * \param asdu the received ASDU
+ */
+void
+CS101_CommandFanOut_handleASDU(CS101_CommandFanOut self, void* source, int address, CS101_ASDU asdu);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_API_CS101_COMMAND_FANOUT_H_ */
@@ -31,6 +31,8 @@
 #define SRC_INC_API_CS101_MASTER_H_
 
 #include "iec60870_master.h"
+#include "cs101_command_fanout.h"
+#include "cs101_point_cache.h"
 #include "link_layer_parameters.h"
 
 #ifdef __cplusplus
@@ -137,6 +139,88 @@ CS101_Master_addSlave(CS101_Master self, int address);
 void
 CS101_Master_pollSingleSlave(CS101_Master self, int address);
 
+/**
+ * \brief Polling strategy of the unbalanced master
+ */
+typedef enum {
+    /** every slave gets one link layer state machine step in turn (default) */
+    CS101_POLL_MODE_ROUND_ROBIN = 0,
+
+    /**
+     * slaves signaling ACD are asked for class 1 data immediately, idle slaves are skipped,
+     * slaves are served according to their weight and slaves that repeatedly do not respond
+     * are suspended for an exponentially growing back-off time
+     */
+    CS101_POLL_MODE_PRIORITY = 1
+} CS101_PollMode;
+
+/**
+ * \brief Set the polling strategy (only unbalanced mode)
+ *
+ * \param mode the polling strategy to use
+ */
+void
+CS101_Master_setPollMode(CS101_Master self, CS101_PollMode mode);
+
+/**
+ * \brief Set the polling parameters of a slave (only unbalanced mode)
+ *
+ * NOTE: The slave has to be added with \ref CS101_Master_addSlave before.
+ *
+ * \param address the link layer address of the slave
+ * \param weight number of consecutive exchanges with the slave per scheduling turn (default 1, only used
+ *        by \ref CS101_POLL_MODE_PRIORITY)
+ * \param class2PollInterval interval in ms for automatic class 2 requests (0 = disabled, default). When
+ *        enabled \ref CS101_Master_pollSingleSlave has not to be called for this slave.
+ *
+ * \return true when the slave exists, false otherwise
+ */
+bool
+CS101_Master_setSlavePollParameters(CS101_Master self, int address, int weight, int class2PollInterval);
+
+/**
+ * \brief Set the back-off times for slaves that do not respond (only unbalanced mode)
+ *
+ * The back-off time is doubled with every consecutive timeout until the maximum is reached.
+ * It is only used by \ref CS101_POLL_MODE_PRIORITY.
+ *
+ * \param initialBackoff back-off time in ms after the first timeout (default 1000)
+ * \param maxBackoff maximum back-off time in ms (default 30000)
+ */
+void
+CS101_Master_setTimeoutBackoff(CS101_Master self, int initialBackoff, int maxBackoff);
+
+/**
+ * \brief Get the statistics of the link layer (all slaves)
+ *
+ * NOTE: When the master runs in a separate thread the counters are read without synchronization.
+ *
+ * \param statistics the structure that receives the statistics
+ */
+void
+CS101_Master_getLinkLayerStatistics(CS101_Master self, CS101_LinkLayerStatistics* statistics);
+
+/**
+ * \brief Get the link layer statistics of a single slave (only unbalanced mode)
+ *
+ * Only the request related counters (requests, responses, retransmissions, timeouts and round trip
+ * time) are available for a single slave. The byte, frame and error counters are only available for
+ * the whole link (\ref CS101_Master_getLinkLayerStatistics).
+ *
+ * \param address the link layer address of the slave
+ * \param statistics the structure that receives the statistics
+ *
+ * \return true when the slave exists, false otherwise
+ */
+bool
+CS101_Master_getSlaveLinkLayerStatistics(CS101_Master self, int address, CS101_LinkLayerStatistics* statistics);
+
+/**
+ * \brief Reset the link layer statistics of the link and of all slaves
+ */
+void
+CS101_Master_resetLinkLayerStatistics(CS101_Master self);
+
 /**
  * \brief Destroy the master instance and release all resources
  */
@@ -301,6 +385,24 @@ CS101_Master_sendASDU(CS101_Master self, CS101_ASDU asdu);
 void
 CS101_Master_setASDUReceivedHandler(CS101_Master self, CS101_ASDUReceivedHandler handler, void* parameter);
 
+/**
+ * \brief Attach a point cache that is updated with the received monitoring information
+ *
+ * The cache is updated before the ASDU received handler is called.
+ *
+ * \param pointCache the point cache or NULL to detach the cache
+ */
+void
+CS101_Master_setPointCache(CS101_Master self, CS101_PointCache pointCache);
+
+/**
+ * \brief Attach a command fan-out that tracks the responses to its commands
+ *
+ * \param fanOut the command fan-out or NULL to detach the fan-out
+ */
+void
+CS101_Master_setCommandFanOut(CS101_Master self, CS101_CommandFanOut fanOut);
+
 /**
  * \brief Set a callback handler for link layer state changes
  */
@@ -0,0 +1,217 @@
+/*
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_API_CS101_POINT_CACHE_H_
+#define SRC_INC_API_CS101_POINT_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iec60870_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file cs101_point_cache.h
+ * \brief Master side process image (point cache) for received monitoring information
+ */
+
+/**
+ * @addtogroup MASTER Master related functions
+ *
+ * @{
+ */
+
+/**
+ * @defgroup POINT_CACHE Point cache (process image)
+ *
+ * The point cache stores the last received value of each data point. A data point is identified by
+ * the common address (CA), the point type (the type family of the information object, e.g. measured
+ * value scaled with and without time tag) and the information object address (IOA).
+ *
+ * The cache can be attached to a CS104_Connection or CS101_Master. It is then updated with each received
+ * ASDU before the ASDU received handler is called. The application can read single points or a snapshot
+ * of all points and can install a handler that is only called when a point changed.
+ *
+ * @{
+ */
+
+typedef struct sCS101_PointCache* CS101_PointCache;
+
+/**
+ * \brief Point type - combines the type IDs with and without time tag of the same kind of information
+ */
+typedef enum {
+    CS101_POINT_TYPE_SINGLE_POINT = 0,      /**< M_SP_NA_1, M_SP_TA_1, M_SP_TB_1 */
+    CS101_POINT_TYPE_DOUBLE_POINT = 1,      /**< M_DP_NA_1, M_DP_TA_1, M_DP_TB_1 */
+    CS101_POINT_TYPE_STEP_POSITION = 2,     /**< M_ST_NA_1, M_ST_TA_1, M_ST_TB_1 */
+    CS101_POINT_TYPE_BITSTRING32 = 3,       /**< M_BO_NA_1, M_BO_TA_1, M_BO_TB_1 */
+    CS101_POINT_TYPE_NORMALIZED = 4,        /**< M_ME_NA_1, M_ME_TA_1, M_ME_TD_1, M_ME_ND_1 */
+    CS101_POINT_TYPE_SCALED = 5,            /**< M_ME_NB_1, M_ME_TB_1, M_ME_TE_1 */
+    CS101_POINT_TYPE_SHORT_FLOAT = 6,       /**< M_ME_NC_1, M_ME_TC_1, M_ME_TF_1 */
+    CS101_POINT_TYPE_INTEGRATED_TOTALS = 7  /**< M_IT_NA_1, M_IT_TA_1, M_IT_TB_1 */
+} CS101_PointType;
+
+#define CS101_POINT_TYPE_COUNT 8
+
+typedef struct sCS101_PointValue* CS101_PointValue;
+
+/**
+ * \brief Cached state of a data point
+ */
+struct sCS101_PointValue {
+    int ca;                        /**< common address */
+    int ioa;                       /**< information object address */
+    CS101_PointType pointType;     /**< point type */
+    TypeID typeId;                 /**< type ID of the last received information object */
+    CS101_CauseOfTransmission cot; /**< cause of transmission of the last received information object */
+
+    /**
+     * Value of the point: 0/1 for single points, 0-3 for double points, the step position value,
+     * the bitstring value, the normalized value (-1.0 .. 1.0), the scaled value, the short floating
+     * point value or the counter value of integrated totals.
+     */
+    double value;
+
+    QualityDescriptor quality; /**< quality (integrated totals: only IEC60870_QUALITY_INVALID is used) */
+
+    bool hasTimestamp;              /**< the last received information object had a CP56Time2a time tag */
+    struct sCP56Time2a timestamp;   /**< time tag of the last received information object */
+
+    uint64_t lastUpdateTime; /**< local time (ms since epoch) of the last update */
+    uint32_t updateCount;    /**< number of received updates */
+};
+
+/**
+ * \brief Handler that is called when a point is added or changed (according to the deadband)
+ *
+ * The handler is called in the context of the thread that handles the received messages. The
+ * point cache can be accessed inside the handler.
+ *
+ * \param parameter user provided parameter
+ * \param point the new state of the point (only valid inside the handler)
+ */
+typedef void (*CS101_PointChangedHandler) (void* parameter, CS101_PointValue point);
+
+/**
+ * \brief Create a new point cache
+ *
+ * \param initialCapacity the number of points that can be stored before the table has to be resized
+ *
+ * \return the new point cache instance
+ */
+CS101_PointCache
+CS101_PointCache_create(int initialCapacity);
+
+/**
+ * \brief Set the handler that is called when a point is added or changed
+ *
+ * \param handler user provided callback handler function
+ * \param parameter user provided parameter that is passed to the callback handler
+ */
+void
+CS101_PointCache_setPointChangedHandler(CS101_PointCache self, CS101_PointChangedHandler handler, void* parameter);
+
+/**
+ * \brief Set the deadband for all points of a point type
+ *
+ * A value update is only reported as change when the difference to the last reported value is larger
+ * than the deadband. Quality changes are always reported. The cached value is always updated.
+ *
+ * \param pointType the point type
+ * \param deadband the absolute deadband (default: 0 - every value change is reported)
+ */
+void
+CS101_PointCache_setDeadband(CS101_PointCache self, CS101_PointType pointType, double deadband);
+
+/**
+ * \brief Set the deadband for a single point (overrides the deadband of the point type)
+ *
+ * \param deadband the absolute deadband. A negative value restores the deadband of the point type.
+ *
+ * \return true on success, false when out of memory
+ */
+bool
+CS101_PointCache_setPointDeadband(CS101_PointCache self, int ca, CS101_PointType pointType, int ioa, double deadband);
+
+/**
+ * \brief Update the cache with the monitoring information of an ASDU
+ *
+ * Is called automatically when the cache is attached to a connection. ASDUs with other than
+ * monitoring information are ignored.
+ *
+ * \param asdu the received ASDU
+ */
+void
+CS101_PointCache_update(CS101_PointCache self, CS101_ASDU asdu);
+
+/**
+ * \brief Get the cached state of a point
+ *
+ * \param value the structure to be filled with the point state
+ *
+ * \return true when the point is in the cache, false otherwise
+ */
+bool
+CS101_PointCache_getPoint(CS101_PointCache self, int ca, CS101_PointType pointType, int ioa, CS101_PointValue value);
+
+/**
+ * \brief Get the number of points in the cache
+ */
+int
+CS101_PointCache_getNumberOfPoints(CS101_PointCache self);
+
+/**
+ * \brief Get a consistent copy of all cached points
+ *
+ * \param values array to be filled with the point states
+ * \param maxValues the size of the array
+ *
+ * \return the number of points stored in the array
+ */
+int
+CS101_PointCache_getSnapshot(CS101_PointCache self, CS101_PointValue values, int maxValues);
+
+/**
+ * \brief Remove all points from the cache (the deadband settings of the point types are kept)
+ */
+void
+CS101_PointCache_clear(CS101_PointCache self);
+
+/**
+ * \brief Release all resources of the point cache
+ *
+ * The cache has to be detached from all connections before.
+ */
+void
+CS101_PointCache_destroy(CS101_PointCache self);
+
+/*! @} */
+
+/*! @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_API_CS101_POINT_CACHE_H_ */
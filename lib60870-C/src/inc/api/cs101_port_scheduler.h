@@ -0,0 +1,173 @@
+/*
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_API_CS101_PORT_SCHEDULER_H_
+#define SRC_INC_API_CS101_PORT_SCHEDULER_H_
+
+#include <stdbool.h>
+
+#include "hal_serial.h"
+#include "cs101_master.h"
+#include "cs101_slave.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file cs101_port_scheduler.h
+ * \brief Single threaded event loop for many CS 101 masters and slaves
+ */
+
+/**
+ * @defgroup CS101_PORT_SCHEDULER CS 101 port scheduler (event loop for multiple serial lines)
+ *
+ * The port scheduler runs any number of CS101_Master and CS101_Slave instances in a single thread.
+ * Instead of one thread per serial line that polls the serial port, the scheduler waits for received
+ * data on all serial ports at the same time (epoll on Linux). A master or slave instance is run when
+ * data is received on its serial port and when its tick timer expires (to handle the link layer timeouts
+ * and to send queued messages). The tick timers of all instances are handled by a common timer wheel.
+ *
+ * The CS101_Master_run/CS101_Slave_run and CS101_Master_start/CS101_Slave_start functions must not be
+ * used for instances that are added to the scheduler. The serial ports have to be opened before the instances
+ * are added.
+ *
+ * @{
+ */
+
+typedef struct sCS101_PortScheduler* CS101_PortScheduler;
+
+/**
+ * \brief Handler that is called in each tick of a master or slave instance
+ *
+ * Can be used to call the functions of the master or slave that have to be called periodically
+ * (e.g. \ref CS101_Master_pollSingleSlave) in the context of the scheduler.
+ *
+ * \param parameter user provided parameter
+ * \param master the master instance or NULL
+ * \param slave the slave instance or NULL
+ */
+typedef void (*CS101_PortTickHandler) (void* parameter, CS101_Master master, CS101_Slave slave);
+
+/**
+ * \brief Create a new port scheduler
+ *
+ * \return the new instance or NULL when the required OS resources are not available
+ */
+CS101_PortScheduler
+CS101_PortScheduler_create(void);
+
+/**
+ * \brief Set the tick interval (default: 10 ms)
+ *
+ * The master and slave instances are run at least once in each tick interval. The tick interval
+ * determines the precision of the link layer timeouts.
+ *
+ * \param tickIntervalInMs the tick interval in ms
+ */
+void
+CS101_PortScheduler_setTickInterval(CS101_PortScheduler self, int tickIntervalInMs);
+
+/**
+ * \brief Set a handler that is called in each tick of the master and slave instances
+ */
+void
+CS101_PortScheduler_setTickHandler(CS101_PortScheduler self, CS101_PortTickHandler handler, void* parameter);
+
+/**
+ * \brief Add a master instance to the scheduler
+ *
+ * \return true in case of success, false otherwise (e.g. the serial port is not open)
+ */
+bool
+CS101_PortScheduler_addMaster(CS101_PortScheduler self, CS101_Master master);
+
+/**
+ * \brief Add a slave instance to the scheduler
+ *
+ * \return true in case of success, false otherwise (e.g. the serial port is not open)
+ */
+bool
+CS101_PortScheduler_addSlave(CS101_PortScheduler self, CS101_Slave slave);
+
+/**
+ * \brief Remove a master instance from the scheduler
+ *
+ * NOTE: must not be called inside of a callback handler of an instance of the scheduler
+ */
+void
+CS101_PortScheduler_removeMaster(CS101_PortScheduler self, CS101_Master master);
+
+/**
+ * \brief Remove a slave instance from the scheduler
+ *
+ * NOTE: must not be called inside of a callback handler of an instance of the scheduler
+ */
+void
+CS101_PortScheduler_removeSlave(CS101_PortScheduler self, CS101_Slave slave);
+
+/**
+ * \brief Get the number of master and slave instances of the scheduler
+ */
+int
+CS101_PortScheduler_getNumberOfPorts(CS101_PortScheduler self);
+
+/**
+ * \brief Wait for received data or expired tick timers and run the affected instances
+ *
+ * Has to be called in a loop when \ref CS101_PortScheduler_start is not used.
+ *
+ * \param maxWaitTimeInMs maximum time to wait for an event
+ *
+ * \return the number of times a master or slave instance was run
+ */
+int
+CS101_PortScheduler_run(CS101_PortScheduler self, int maxWaitTimeInMs);
+
+/**
+ * \brief Start a background thread that calls \ref CS101_PortScheduler_run
+ *
+ * NOTE: This requires threads.
+ */
+void
+CS101_PortScheduler_start(CS101_PortScheduler self);
+
+/**
+ * \brief Stop the background thread
+ */
+void
+CS101_PortScheduler_stop(CS101_PortScheduler self);
+
+/**
+ * \brief Release all resources of the scheduler
+ *
+ * The master and slave instances are not destroyed.
+ */
+void
+CS101_PortScheduler_destroy(CS101_PortScheduler self);
+
+/*! @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_API_CS101_PORT_SCHEDULER_H_ */
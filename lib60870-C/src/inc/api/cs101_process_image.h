@@ -0,0 +1,291 @@
+/*
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_API_CS101_PROCESS_IMAGE_H_
+#define SRC_INC_API_CS101_PROCESS_IMAGE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iec60870_common.h"
+#include "iec60870_slave.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file cs101_process_image.h
+ * \brief Slave side process image (point database) that serves interrogation and read commands
+ */
+
+/**
+ * @addtogroup SLAVE Slave related functions
+ *
+ * @{
+ */
+
+/**
+ * @defgroup PROCESS_IMAGE Process image (point database)
+ *
+ * The process image stores the current value of the monitoring points of a slave. A point is identified
+ * by the common address (CA) and the information object address (IOA).
+ *
+ * The process image is attached to a CS101_Slave or CS104_Slave as slave plugin (\ref CS101_ProcessImage_getPlugin).
+ * It then serves the following commands for the common addresses that have points in the process image:
+ *
+ * - interrogation command (C_IC_NA_1) - station interrogation (QOI 20) and group interrogation (QOI 21-36)
+ * - counter interrogation command (C_CI_NA_1) - only read requests (FRZ = 0). Freeze and reset requests are
+ *   passed to the counter interrogation handler of the application.
+ * - read command (C_RD_NA_1)
+ *
+ * The responses are packed into as few ASDUs as possible. Points of the same type with contiguous IOAs are
+ * sent in ASDUs with SQ=1. The responses are sent step by step as streamed responses of the connection
+ * (\ref IMasterConnection_startResponse) whenever an ASDU can be sent without queuing, so a large interrogation
+ * doesn't block the connection and no ASDUs are lost. For connections that don't support streamed responses
+ * the responses are sent from the plugin task while the connection is ready (\ref IMasterConnection_isReady).
+ *
+ * Commands for other common addresses are handled by the application callbacks as usual.
+ *
+ * An interrogation response is consistent: it contains the values at the time the command was received.
+ * The interrogation reads a copy-on-write snapshot of the points - value updates are not blocked while the
+ * response is sent. Interrogations of different connections that start at about the same time share
+ * the same snapshot (\ref CS101_ProcessImage_setSnapshotSharingTime).
+ *
+ * Value updates (\ref CS101_ProcessImage_updateValue, \ref CS101_ProcessImage_updateValues) are compared with
+ * the last reported value of the point (deadband) and create time tagged spontaneous events only for significant
+ * changes. The events are packed into ASDUs and passed to the event handler.
+ *
+ * @{
+ */
+
+typedef struct sCS101_ProcessImage* CS101_ProcessImage;
+
+/**
+ * \brief Deadband mode of a point - decides when a value update creates a spontaneous event
+ *
+ * The deadband is only used for measured values (M_ME_NA_1, M_ME_NB_1, M_ME_NC_1, M_ME_ND_1). For the other
+ * types every change of the value creates an event. A change of the quality always creates an event
+ * (except for CS101_DEADBAND_NO_EVENTS).
+ */
+typedef enum
+{
+    CS101_DEADBAND_ABSOLUTE = 0,   /**< event when |value - reported value| > deadband (default: deadband 0) */
+    CS101_DEADBAND_PERCENT = 1,    /**< event when |value - reported value| > deadband % of |reported value| */
+    CS101_DEADBAND_INTEGRATED = 2, /**< event when |sum of (value - reported value) of all updates| > deadband */
+    CS101_DEADBAND_NO_EVENTS = 3   /**< value updates never create events */
+} CS101_DeadbandMode;
+
+/**
+ * \brief Handler that is called with the spontaneous events created by value updates
+ *
+ * The ASDU contains one or more time tagged information objects (COT = spontaneous) of the same type and
+ * CA. Usually the handler forwards the ASDU with \ref CS104_Slave_enqueueASDU or
+ * \ref CS101_Slave_enqueueUserDataClass1. The ASDU is only valid during the call.
+ *
+ * \param parameter user provided parameter
+ * \param asdu the ASDU with the events
+ */
+typedef void (*CS101_ProcessImageEventHandler) (void* parameter, CS101_ASDU asdu);
+
+/**
+ * \brief Create a new process image
+ *
+ * \param initialCapacity the number of points that can be added before the tables have to be resized
+ *
+ * \return the new process image instance
+ */
+CS101_ProcessImage
+CS101_ProcessImage_create(int initialCapacity);
+
+/**
+ * \brief Release all resources of the process image
+ *
+ * The process image has to be removed from the slave before (i.e. the slave has to be destroyed before).
+ */
+void
+CS101_ProcessImage_destroy(CS101_ProcessImage self);
+
+/**
+ * \brief Add a point to the process image
+ *
+ * Supported type IDs (types without time tag): M_SP_NA_1, M_DP_NA_1, M_ST_NA_1, M_BO_NA_1, M_ME_NA_1, M_ME_NB_1,
+ * M_ME_NC_1, M_ME_ND_1 and M_IT_NA_1 (integrated totals - only sent in response to counter interrogation commands).
+ *
+ * The initial value of the point is 0 with quality IEC60870_QUALITY_INVALID.
+ *
+ * \param ca the common address
+ * \param ioa the information object address
+ * \param typeId the type ID that is used to send the point
+ * \param groups interrogation groups of the point. Bit n (0-15) is set when the point is a member of
+ *        group n + 1 (QOI 21 + n). For integrated totals the bits 0-3 represent the counter groups 1-4.
+ *
+ * \return the index of the point or -1 when the point already exists, the type is not supported or
+ *         out of memory
+ */
+int
+CS101_ProcessImage_addPoint(CS101_ProcessImage self, int ca, int ioa, TypeID typeId, uint16_t groups);
+
+/**
+ * \brief Get the index of a point
+ *
+ * \return the index of the point or -1 when the point doesn't exist
+ */
+int
+CS101_ProcessImage_getPointIndex(CS101_ProcessImage self, int ca, int ioa);
+
+/**
+ * \brief Get the number of points in the process image
+ */
+int
+CS101_ProcessImage_getNumberOfPoints(CS101_ProcessImage self);
+
+/**
+ * \brief Set the value of a point
+ *
+ * The value is converted to the type of the point: 0/1 for single points, 0-3 for double points, the step
+ * position value, the bitstring value, the normalized value (-1.0 .. 1.0), the scaled value, the short floating
+ * point value or the counter value of integrated totals.
+ *
+ * \param index the index of the point
+ * \param value the new value
+ * \param quality the new quality (integrated totals: only IEC60870_QUALITY_INVALID is used)
+ *
+ * \return true on success, false when the index is invalid
+ */
+bool
+CS101_ProcessImage_setValue(CS101_ProcessImage self, int index, double value, QualityDescriptor quality);
+
+/**
+ * \brief Get the value of a point
+ *
+ * \param index the index of the point
+ * \param value pointer to a variable that receives the value (can be NULL)
+ * \param quality pointer to a variable that receives the quality (can be NULL)
+ *
+ * \return true on success, false when the index is invalid
+ */
+bool
+CS101_ProcessImage_getValue(CS101_ProcessImage self, int index, double* value, QualityDescriptor* quality);
+
+/**
+ * \brief Set the handler for the spontaneous events created by value updates
+ *
+ * Without event handler value updates don't create events.
+ *
+ * \param alParams application layer parameters used to encode the event ASDUs (e.g. from \ref CS104_Slave_getAppLayerParameters)
+ * \param handler the event handler (NULL to disable events)
+ * \param parameter user provided parameter that is passed to the handler
+ */
+void
+CS101_ProcessImage_setEventHandler(CS101_ProcessImage self, CS101_AppLayerParameters alParams,
+                                   CS101_ProcessImageEventHandler handler, void* parameter);
+
+/**
+ * \brief Set the deadband of a point
+ *
+ * \param index the index of the point
+ * \param mode the deadband mode
+ * \param deadband the deadband (in units of the value or in percent for CS101_DEADBAND_PERCENT)
+ *
+ * \return true on success, false when the index is invalid
+ */
+bool
+CS101_ProcessImage_setDeadband(CS101_ProcessImage self, int index, CS101_DeadbandMode mode, double deadband);
+
+/**
+ * \brief Update the value of a point and create a spontaneous event on a significant change
+ *
+ * The new value is compared with the last reported value of the point. When the difference exceeds
+ * the deadband or the quality changed, a time tagged event (CP56Time2a) is added to the pending
+ * event ASDU. Events of the same type and CA are packed into the same ASDU. Full ASDUs are passed
+ * to the event handler immediately, the last ASDU when \ref CS101_ProcessImage_flushEvents is called.
+ *
+ * \param index the index of the point
+ * \param value the new value
+ * \param quality the new quality
+ * \param timestamp the time tag of the event or NULL to use the current time
+ *
+ * \return true when an event was created, false otherwise
+ */
+bool
+CS101_ProcessImage_updateValue(CS101_ProcessImage self, int index, double value, QualityDescriptor quality,
+                               CP56Time2a timestamp);
+
+/**
+ * \brief Update the values of a range of points (bulk update)
+ *
+ * Intended for the cyclic update of many measured values. The deadband check of the range is done in
+ * a tight loop over contiguous arrays (can be vectorized by the compiler). The pending events are passed
+ * to the event handler before the function returns.
+ *
+ * \param firstIndex index of the first point
+ * \param count number of points
+ * \param values the new values (count elements)
+ * \param qualities the new qualities (count elements) or NULL to keep the qualities
+ * \param timestamp the time tag of the events or NULL to use the current time
+ *
+ * \return the number of created events or -1 when the index range is invalid
+ */
+int
+CS101_ProcessImage_updateValues(CS101_ProcessImage self, int firstIndex, int count, const float* values,
+                                const QualityDescriptor* qualities, CP56Time2a timestamp);
+
+/**
+ * \brief Pass the pending events to the event handler
+ */
+void
+CS101_ProcessImage_flushEvents(CS101_ProcessImage self);
+
+/**
+ * \brief Set the time an interrogation snapshot is shared with new interrogation requests
+ *
+ * A new interrogation uses the snapshot of a running interrogation when the snapshot is not older than
+ * this time or no value was changed since the snapshot was taken. Otherwise a new snapshot is taken.
+ *
+ * \param timeInMs time in ms (default 500 ms - 0 to share only unchanged snapshots)
+ */
+void
+CS101_ProcessImage_setSnapshotSharingTime(CS101_ProcessImage self, int timeInMs);
+
+/**
+ * \brief Get the slave plugin that serves the commands from the process image
+ *
+ * The plugin has to be added to the slave with \ref CS101_Slave_addPlugin or \ref CS104_Slave_addPlugin.
+ *
+ * \return the plugin (owned by the process image)
+ */
+CS101_SlavePlugin
+CS101_ProcessImage_getPlugin(CS101_ProcessImage self);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_API_CS101_PROCESS_IMAGE_H_ */
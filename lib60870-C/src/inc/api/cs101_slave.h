@@ -58,6 +58,23 @@ extern "C" {
  */
 typedef struct sCS101_Slave* CS101_Slave;
 
+/**
+ * \brief Statistics of a CS101_Slave data queue
+ */
+typedef struct sCS101_QueueStatistics CS101_QueueStatistics;
+
+struct sCS101_QueueStatistics
+{
+    int entries; /**< number of ASDUs currently in the queue */
+    int size; /**< maximum number of ASDUs in the queue */
+    uint64_t enqueued; /**< number of enqueued ASDUs */
+    uint64_t sent; /**< number of ASDUs removed from the queue for transmission */
+    uint64_t dropped; /**< number of ASDUs overwritten because the queue was full */
+    uint64_t coalesced; /**< number of cyclic values replaced by a newer value of the same IOA */
+    uint64_t totalAgeMs; /**< sum of the time the sent ASDUs spent in the queue (0 without CONFIG_CS101_QUEUE_EVENT_AGE) */
+    uint64_t maxAgeMs; /**< maximum time an ASDU spent in the queue (0 without CONFIG_CS101_QUEUE_EVENT_AGE) */
+};
+
 /**
  * \brief Create a new balanced or unbalanced CS101 slave
  *
@@ -174,6 +191,18 @@ CS101_Slave_isClass1QueueFull(CS101_Slave self);
 void
 CS101_Slave_enqueueUserDataClass1(CS101_Slave self, CS101_ASDU asdu);
 
+/**
+ * \brief Enqueue multiple ASDUs into the class 1 data queue
+ *
+ * The queue is only locked once for all ASDUs.
+ *
+ * \param self CS101_Slave instance
+ * \param asdus array of ASDU instances to enqueue
+ * \param numberOfAsdus number of ASDUs in the array
+ */
+void
+CS101_Slave_enqueueUserDataClass1Batch(CS101_Slave self, CS101_ASDU* asdus, int numberOfAsdus);
+
 /**
  * \brief Check if the class 2 ASDU is full
  *
@@ -193,6 +222,71 @@ CS101_Slave_isClass2QueueFull(CS101_Slave self);
 void
 CS101_Slave_enqueueUserDataClass2(CS101_Slave self, CS101_ASDU asdu);
 
+/**
+ * \brief Enqueue multiple ASDUs into the class 2 data queue
+ *
+ * The queue is only locked once for all ASDUs.
+ *
+ * \param self CS101_Slave instance
+ * \param asdus array of ASDU instances to enqueue
+ * \param numberOfAsdus number of ASDUs in the array
+ */
+void
+CS101_Slave_enqueueUserDataClass2Batch(CS101_Slave self, CS101_ASDU* asdus, int numberOfAsdus);
+
+/**
+ * \brief Enable or disable coalescing of cyclic values in the class 2 data queue
+ *
+ * When enabled an ASDU with a single information object and COT periodic or background scan
+ * replaces a queued ASDU with the same type ID, CA and IOA. Only the latest value is sent.
+ *
+ * NOTE: Has no effect when the library is compiled with CONFIG_CS101_QUEUE_COALESCING = 0.
+ *
+ * \param self CS101_Slave instance
+ * \param enable true to enable coalescing, false to disable (default)
+ */
+void
+CS101_Slave_setClass2Coalescing(CS101_Slave self, bool enable);
+
+/**
+ * \brief Get the statistics of the class 1 data queue
+ *
+ * NOTE: Includes the class 1 data generated by the stack (e.g. ACT_CON).
+ *
+ * \param self CS101_Slave instance
+ * \param statistics the structure that receives the statistics
+ */
+void
+CS101_Slave_getClass1QueueStatistics(CS101_Slave self, CS101_QueueStatistics* statistics);
+
+/**
+ * \brief Get the statistics of the class 2 data queue
+ *
+ * \param self CS101_Slave instance
+ * \param statistics the structure that receives the statistics
+ */
+void
+CS101_Slave_getClass2QueueStatistics(CS101_Slave self, CS101_QueueStatistics* statistics);
+
+/**
+ * \brief Get the statistics of the link layer
+ *
+ * NOTE: When the slave runs in a separate thread the counters are read without synchronization.
+ *
+ * \param self CS101_Slave instance
+ * \param statistics the structure that receives the statistics
+ */
+void
+CS101_Slave_getLinkLayerStatistics(CS101_Slave self, CS101_LinkLayerStatistics* statistics);
+
+/**
+ * \brief Reset the statistics of the link layer
+ *
+ * \param self CS101_Slave instance
+ */
+void
+CS101_Slave_resetLinkLayerStatistics(CS101_Slave self);
+
 /**
  * \brief Remove all ASDUs from the class 1/2 data queues
  *
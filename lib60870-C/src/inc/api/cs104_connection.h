@@ -27,6 +27,8 @@
 
 #include "tls_config.h"
 #include "iec60870_master.h"
+#include "cs101_command_fanout.h"
+#include "cs101_point_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -142,11 +144,59 @@ CS104_Connection_getAppLayerParameters(CS104_Connection self);
 void
 CS104_Connection_setConnectTimeout(CS104_Connection self, int millies);
 
+/**
+ * \brief Set the backoff for repeated connection attempts
+ *
+ * When the backoff is enabled a connection attempt that follows a failed attempt is delayed.
+ * The delay starts with minDelayInMs and is doubled with each further failed attempt until
+ * maxDelayInMs is reached. A small random part is added to the delay so that many connections
+ * that failed at the same time don't reconnect at the same time. The delay is reset when a
+ * connection was established.
+ *
+ * NOTE: The backoff is disabled by default.
+ *
+ * \param self CS104_Connection instance
+ * \param minDelayInMs the delay after the first failed attempt (in ms). Set to 0 to disable the backoff.
+ * \param maxDelayInMs the maximum delay (in ms)
+ */
+void
+CS104_Connection_setReconnectBackoff(CS104_Connection self, int minDelayInMs, int maxDelayInMs);
+
+/**
+ * \brief Enable the adaptive acknowledgement of received I messages
+ *
+ * By default an S message is sent when w received I messages are unconfirmed or when T2 elapses.
+ * With the adaptive policy the acknowledgement is sent earlier when the message rate is high compared
+ * to the round trip time (so that the server doesn't have to wait at its k limit). The S message is
+ * deferred for a short time (at most half the round trip time) so that an I message sent by the
+ * application can carry the acknowledgement instead. The limits w and T2 are not exceeded.
+ *
+ * NOTE: Takes effect with the next connection establishment.
+ *
+ * \param self CS104_Connection instance
+ * \param enabled true to enable the adaptive policy (default: false)
+ */
+void
+CS104_Connection_setAdaptiveAck(CS104_Connection self, bool enabled);
+
+/**
+ * \brief Get the counters for sent and saved acknowledgements (S messages)
+ *
+ * \param self CS104_Connection instance
+ * \param statistics the structure to be filled with the counter values
+ */
+void
+CS104_Connection_getAckStatistics(CS104_Connection self, CS104_AckStatistics statistics);
+
 /**
  * \brief non-blocking connect.
  *
  * Invokes a connection establishment to the server and returns immediately.
  *
+ * The hostname is resolved without blocking the connection thread. When the hostname
+ * resolves to multiple addresses (e.g. IPv6 and IPv4) the connection attempts are
+ * started in parallel with a short delay and the first established connection is used.
+ *
  * \param self CS104_Connection instance
  */
 void
@@ -310,6 +360,27 @@ CS104_Connection_sendASDU(CS104_Connection self, CS101_ASDU asdu);
 void
 CS104_Connection_setASDUReceivedHandler(CS104_Connection self, CS101_ASDUReceivedHandler handler, void* parameter);
 
+/**
+ * \brief Attach a point cache that is updated with the received monitoring information
+ *
+ * The cache is updated before the ASDU received handler is called. The same cache can be
+ * attached to multiple connections.
+ *
+ * \param pointCache the point cache or NULL to detach the cache
+ */
+void
+CS104_Connection_setPointCache(CS104_Connection self, CS101_PointCache pointCache);
+
+/**
+ * \brief Attach a command fan-out that tracks the responses to its commands
+ *
+ * The same fan-out can be attached to multiple connections.
+ *
+ * \param fanOut the command fan-out or NULL to detach the fan-out
+ */
+void
+CS104_Connection_setCommandFanOut(CS104_Connection self, CS101_CommandFanOut fanOut);
+
 typedef enum {
     CS104_CONNECTION_OPENED = 0,
     CS104_CONNECTION_CLOSED = 1,
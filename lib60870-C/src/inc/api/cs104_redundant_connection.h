@@ -0,0 +1,213 @@
+/*
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_CS104_REDUNDANT_CONNECTION_H_
+#define SRC_INC_CS104_REDUNDANT_CONNECTION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cs104_connection.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file cs104_redundant_connection.h
+ * \brief CS 104 master side redundant connection (one active and multiple standby connections)
+ */
+
+/**
+ * @addtogroup MASTER Master related functions
+ *
+ * @{
+ */
+
+/**
+ * @defgroup CS104_REDUNDANT_MASTER CS 104 master redundant connection
+ *
+ * A redundant connection keeps connections to all configured server addresses (paths) open.
+ * Only one path is started (STARTDT). The other paths are kept in stopped state (STOPDT) and
+ * are supervised by test frames (TESTFR). When the active path fails the next standby path is
+ * started immediately.
+ *
+ * @{
+ */
+
+typedef struct sCS104_RedundantConnection* CS104_RedundantConnection;
+
+typedef enum {
+    CS104_REDUNDANT_CONNECTION_PATH_OPENED = 0,    /**< a path is connected and in standby (STOPDT) */
+    CS104_REDUNDANT_CONNECTION_PATH_CLOSED = 1,    /**< a path was closed or the connection failed */
+    CS104_REDUNDANT_CONNECTION_PATH_ACTIVATED = 2, /**< a path is started and delivers data (STARTDT confirmed) */
+    CS104_REDUNDANT_CONNECTION_NO_PATH_AVAILABLE = 3 /**< the active path failed and no standby path is available */
+} CS104_RedundantConnectionEvent;
+
+/**
+ * \brief Handler that is called when the state of a path changes
+ *
+ * \param parameter user provided parameter
+ * \param connection the redundant connection object
+ * \param pathIndex the index of the path (as returned by \ref CS104_RedundantConnection_addPath)
+ * \param event event type
+ */
+typedef void (*CS104_RedundantConnectionHandler) (void* parameter, CS104_RedundantConnection connection, int pathIndex,
+                                                  CS104_RedundantConnectionEvent event);
+
+/**
+ * \brief Create a new redundant connection object
+ *
+ * \return the new redundant connection object
+ */
+CS104_RedundantConnection
+CS104_RedundantConnection_create(void);
+
+/**
+ * \brief Add a path (server address) to the redundant connection
+ *
+ * The order of the paths defines the order in which standby paths are activated.
+ * Paths have to be added before \ref CS104_RedundantConnection_start is called.
+ *
+ * \param hostname host name of IP address of the server
+ * \param tcpPort tcp port of the server. If set to -1 use default port (2404)
+ *
+ * \return the index of the path, or -1 when the maximum number of paths is reached
+ */
+int
+CS104_RedundantConnection_addPath(CS104_RedundantConnection self, const char* hostname, int tcpPort);
+
+/**
+ * \brief Get the connection object of a path
+ *
+ * Can be used to configure the APCI and application layer parameters of the path. The handlers
+ * of the connection object must not be changed.
+ *
+ * \param pathIndex the index of the path
+ *
+ * \return the connection object or NULL when the path doesn't exist
+ */
+CS104_Connection
+CS104_RedundantConnection_getPathConnection(CS104_RedundantConnection self, int pathIndex);
+
+/**
+ * \brief Send a general interrogation after a standby path was activated
+ *
+ * \param enabled true to send the interrogation command after a switchover (default: false)
+ * \param ca the common address to be used for the interrogation command
+ */
+void
+CS104_RedundantConnection_setInterrogationOnSwitchover(CS104_RedundantConnection self, bool enabled, int ca);
+
+/**
+ * \brief Set the time after a switchover in which duplicated events are discarded
+ *
+ * After a switchover the server can repeat events that were already received on the old active
+ * path but not confirmed. Spontaneous events (COT 3, 11, 12) that are identical to an event that was
+ * received on the old path are discarded during this time. Each event of the old path discards at
+ * most one event of the new path. Repeated identical events on the same path are always delivered.
+ *
+ * \param timeInMs duplicate detection time in ms (default: 5000). 0 disables duplicate detection.
+ */
+void
+CS104_RedundantConnection_setDuplicateDetectionTime(CS104_RedundantConnection self, int timeInMs);
+
+/**
+ * \brief Set the delay between reconnect attempts of a failed path
+ *
+ * \param intervalInMs the reconnect interval in ms (default: 1000)
+ */
+void
+CS104_RedundantConnection_setReconnectInterval(CS104_RedundantConnection self, int intervalInMs);
+
+/**
+ * \brief Register a callback handler for received ASDUs
+ *
+ * Only ASDUs that are received on the active path are forwarded to the handler.
+ *
+ * \param handler user provided callback handler function
+ * \param parameter user provided parameter that is passed to the callback handler
+ */
+void
+CS104_RedundantConnection_setASDUReceivedHandler(CS104_RedundantConnection self, CS101_ASDUReceivedHandler handler,
+                                                 void* parameter);
+
+/**
+ * \brief Set the path event handler
+ *
+ * \param handler user provided callback handler function
+ * \param parameter user provided parameter that is passed to the callback handler
+ */
+void
+CS104_RedundantConnection_setConnectionHandler(CS104_RedundantConnection self, CS104_RedundantConnectionHandler handler,
+                                               void* parameter);
+
+/**
+ * \brief Connect all paths and activate the first available path
+ */
+void
+CS104_RedundantConnection_start(CS104_RedundantConnection self);
+
+/**
+ * \brief Close all paths
+ */
+void
+CS104_RedundantConnection_stop(CS104_RedundantConnection self);
+
+/**
+ * \brief Get the index of the active path
+ *
+ * \return the index of the active path, or -1 when no path is active
+ */
+int
+CS104_RedundantConnection_getActivePath(CS104_RedundantConnection self);
+
+/**
+ * \brief Get the number of events that were discarded as duplicates after a switchover
+ */
+int
+CS104_RedundantConnection_getNumberOfDiscardedDuplicates(CS104_RedundantConnection self);
+
+/**
+ * \brief Send an ASDU over the active path
+ *
+ * \param asdu the ASDU to send
+ *
+ * \return true if message was sent, false otherwise (e.g. no path is active)
+ */
+bool
+CS104_RedundantConnection_sendASDU(CS104_RedundantConnection self, CS101_ASDU asdu);
+
+/**
+ * \brief Close all paths and free all related resources
+ */
+void
+CS104_RedundantConnection_destroy(CS104_RedundantConnection self);
+
+/*! @} */
+
+/*! @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_CS104_REDUNDANT_CONNECTION_H_ */
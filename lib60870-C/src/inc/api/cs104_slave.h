@@ -97,6 +97,9 @@ typedef void (*CS104_ConnectionEventHandler) (void* parameter, IMasterConnection
  * messages. It can be used for debugging purposes. Usually it is not used nor required
  * for applications.
  *
+ * \note For sent I and S messages the handler is called while the connection is locked.
+ * It must not call the IMasterConnection functions of the connection for these messages.
+ *
  * \param parameter user provided parameter
  * \param connection the connection that sent or received the message
  * \param msg the message buffer
@@ -170,6 +173,90 @@ CS104_Slave_getOpenConnections(CS104_Slave self);
 void
 CS104_Slave_setMaxOpenConnections(CS104_Slave self, int maxOpenConnections);
 
+/**
+ * \brief Enable the adaptive acknowledgement of received I messages
+ *
+ * With the adaptive policy no S message is sent when an I message that confirms the received
+ * messages is sent immediately (a waiting ASDU and a free k-buffer slot). The acknowledgement
+ * threshold is lowered when the message rate of the client is high compared to the round trip time.
+ * The limits w and T2 are not exceeded.
+ *
+ * NOTE: Takes effect for new client connections.
+ *
+ * \param self the slave instance
+ * \param enabled true to enable the adaptive policy (default: false)
+ */
+void
+CS104_Slave_setAdaptiveAck(CS104_Slave self, bool enabled);
+
+/**
+ * \brief Handle the client connections with a fixed number of worker threads
+ *
+ * By default (CS104_Slave_start) each client connection is handled by its own thread. With worker
+ * threads the connections are distributed over the workers instead: a new connection is assigned to
+ * the worker with the fewest connections (round-robin when the workers have the same number of connections).
+ * A worker handles the messages, the timeouts and the sent ASDUs of its connections with a single
+ * event loop. Use this for many client connections on a multi-core system.
+ *
+ * An idle worker sleeps until the next timeout of its connections or until it is woken up (new connection,
+ * enqueued ASDU). When plugins are installed the worker calls the plugin tasks every 10 ms.
+ *
+ * NOTE: Only used by CS104_Slave_start (not in threadless mode). Has to be called before the slave is started.
+ *
+ * \param self the slave instance
+ * \param numberOfWorkers the number of worker threads (0 - one thread per connection - default)
+ */
+void
+CS104_Slave_setWorkerThreads(CS104_Slave self, int numberOfWorkers);
+
+/**
+ * \brief Bind a worker thread to a CPU (core)
+ *
+ * The worker allocates its data structures after it is bound to the CPU. On NUMA systems they are
+ * usually placed on the memory node of the CPU.
+ *
+ * NOTE: Has to be called after CS104_Slave_setWorkerThreads and before the slave is started. Binding
+ * is not supported on all platforms (the worker runs unbound in this case).
+ *
+ * \param self the slave instance
+ * \param worker the index of the worker thread (0 .. numberOfWorkers - 1)
+ * \param cpu the index of the CPU or -1 to not bind the worker (default)
+ *
+ * \return true on success, false when the worker index is invalid
+ */
+bool
+CS104_Slave_setWorkerAffinity(CS104_Slave self, int worker, int cpu);
+
+/**
+ * \brief Let each worker thread accept its connections from an own server socket
+ *
+ * Each worker listens on the TCP port with its own server socket (bound with SO_REUSEPORT). The
+ * operating system distributes the connection requests over the workers. New connections are accepted
+ * and checked in parallel - e.g. when many clients reconnect at the same time after a failover.
+ *
+ * When the server sockets cannot be created (e.g. SO_REUSEPORT is not supported by the platform) the
+ * slave uses a single server socket.
+ *
+ * The connection request handler (\ref CS104_Slave_setConnectionRequestHandler) is called by the worker
+ * threads in this mode and has to be thread-safe.
+ *
+ * NOTE: Requires worker threads (\ref CS104_Slave_setWorkerThreads). Has to be called before the slave is started.
+ *
+ * \param self the slave instance
+ * \param enabled true to use a server socket per worker (default: false)
+ */
+void
+CS104_Slave_setListenerPerWorker(CS104_Slave self, bool enabled);
+
+/**
+ * \brief Get the counters for sent and saved acknowledgements (S messages) of all client connections
+ *
+ * \param self the slave instance
+ * \param statistics the structure to be filled with the counter values
+ */
+void
+CS104_Slave_getAckStatistics(CS104_Slave self, CS104_AckStatistics statistics);
+
 /**
  * \brief Set one of the server modes
  *
@@ -196,6 +283,9 @@ CS104_Slave_setAllowedCAHandler(CS104_Slave self, CS101_IsCAAllowedHandler handl
  * This handler can be used to implement access control mechanisms as it allows the user to decide
  * if the new connection is accepted or not.
  *
+ * NOTE: With a server socket per worker (\ref CS104_Slave_setListenerPerWorker) the handler is called
+ * by the worker threads and can run concurrently on several threads.
+ *
  * \param self the slave instance
  * \param handler the callback function to be used
  * \param parameter user provided context parameter that will be passed to the callback function (or NULL if not required).
@@ -365,6 +455,98 @@ CS104_Slave_stopThreadless(CS104_Slave self);
 void
 CS104_Slave_tick(CS104_Slave self);
 
+/**
+ * \brief Flag for \ref CS104_Slave_handleReady: the file descriptor is readable
+ */
+#define CS104_SLAVE_FD_READABLE 1
+
+/**
+ * \brief Flag for \ref CS104_Slave_handleReady: error or hang up reported for the file descriptor
+ */
+#define CS104_SLAVE_FD_ERROR 2
+
+/**
+ * \brief Get the file descriptors of the server (non-threaded mode)
+ *
+ * Allows to integrate the server into an external event loop (e.g. poll, epoll, libevent, libuv) instead of
+ * calling \ref CS104_Slave_tick periodically. The first file descriptor is the server socket, the second
+ * one is a wakeup file descriptor that becomes readable when an ASDU is enqueued with
+ * \ref CS104_Slave_enqueueASDU (also by another thread), the others are the sockets of the open connections.
+ * The application has to wait until a file descriptor is readable and then call \ref CS104_Slave_handleReady. The set of file descriptors changes when connections are
+ * opened or closed, so the function has to be called again for every iteration of the event loop.
+ *
+ * A typical event loop looks like this:
+ *
+ * \code
+ * while (running) {
+ *     int count = CS104_Slave_getPollFds(slave, fds, MAX_FDS);
+ *     int timeout = CS104_Slave_getNextTimeoutMs(slave, 1000);
+ *
+ *     // wait with poll(), epoll_wait(), ... for the fds (up to timeout ms)
+ *     // call CS104_Slave_handleReady(slave, fd, CS104_SLAVE_FD_READABLE) for each readable fd
+ *
+ *     CS104_Slave_executePeriodicTasks(slave);
+ * }
+ * \endcode
+ *
+ * \param self CS104_Slave instance
+ * \param fds array that receives the file descriptors
+ * \param maxFds size of the array
+ *
+ * \return the number of file descriptors of the server (can be larger than maxFds - then only maxFds
+ *         file descriptors are stored) or 0 when the server is not running
+ */
+int
+CS104_Slave_getPollFds(CS104_Slave self, int* fds, int maxFds);
+
+/**
+ * \brief Get the time until the server has to be handled again (non-threaded mode)
+ *
+ * The time depends on the protocol timeouts (t1, t2, t3) and the deferred acknowledgements of the open
+ * connections. The time is 0 when ASDUs can be sent immediately (e.g. after an ASDU was enqueued with
+ * \ref CS104_Slave_enqueueASDU) or a closed connection has to be released. When plugins are installed
+ * the time is limited to 10 ms (plugins are polled).
+ *
+ * ASDUs that are enqueued by another thread while the application waits make the wakeup file descriptor
+ * (see \ref CS104_Slave_getPollFds) readable.
+ *
+ * \param self CS104_Slave instance
+ * \param maxTimeoutMs maximum time to return
+ *
+ * \return the time in ms until \ref CS104_Slave_executePeriodicTasks has to be called (0..maxTimeoutMs)
+ */
+int
+CS104_Slave_getNextTimeoutMs(CS104_Slave self, int maxTimeoutMs);
+
+/**
+ * \brief Handle a file descriptor that is ready (non-threaded mode)
+ *
+ * Accepts a new connection (server socket), resets the wakeup file descriptor or receives and handles a
+ * message (connection socket).
+ * Only one message is handled per call - the event loop has to use level triggered notifications
+ * (e.g. poll or epoll without EPOLLET).
+ *
+ * \param self CS104_Slave instance
+ * \param fd the file descriptor (from \ref CS104_Slave_getPollFds)
+ * \param events CS104_SLAVE_FD_READABLE and/or CS104_SLAVE_FD_ERROR (closes the connection)
+ */
+void
+CS104_Slave_handleReady(CS104_Slave self, int fd, int events);
+
+/**
+ * \brief Send waiting ASDUs, handle the protocol timeouts and release closed connections (non-threaded mode)
+ *
+ * Has to be called in every iteration of the event loop - after the ready file descriptors have been handled
+ * or the time returned by \ref CS104_Slave_getNextTimeoutMs has elapsed.
+ *
+ * Only the connections with received messages, waiting ASDUs, expired timeouts or that were closed are handled
+ * (all connections when plugins are installed).
+ *
+ * \param self CS104_Slave instance
+ */
+void
+CS104_Slave_executePeriodicTasks(CS104_Slave self);
+
 /*
  * \brief Gets the number of ASDU in the low-priority queue
  *
@@ -430,6 +612,22 @@ CS104_RedundancyGroup_addAllowedClient(CS104_RedundancyGroup self, const char* i
 void
 CS104_RedundancyGroup_addAllowedClientEx(CS104_RedundancyGroup self, const uint8_t* ipAddress, eCS104_IPAddressType addressType);
 
+/**
+ * \brief Add a network (address prefix) of allowed clients to the redundancy group
+ *
+ * A client is assigned to the group with the longest matching prefix (a single allowed client
+ * is a prefix with 32 or 128 bits). When the same prefix is added to several groups the group
+ * that was added to the slave first is used.
+ *
+ * Allowed clients (also \ref CS104_RedundancyGroup_addAllowedClient) can be added while the slave is
+ * running. They are used for the following connection requests.
+ *
+ * \param ipAddress the network address as string (e.g. "192.168.2.0")
+ * \param prefixLength the number of significant bits of the address (e.g. 24)
+ */
+void
+CS104_RedundancyGroup_addAllowedClientPrefix(CS104_RedundancyGroup self, const char* ipAddress, int prefixLength);
+
 /**
  * \brief Destroy the instance and release all resources.
  *
@@ -104,6 +104,55 @@ typedef void (*IEC60870_LinkLayerStateChangedHandler) (void* parameter, int addr
  */
 typedef void (*IEC60870_RawMessageHandler) (void* parameter, uint8_t* msg, int msgSize, bool sent);
 
+/** \brief Number of buckets of a \ref CS101_LatencyHistogram */
+#define CS101_LATENCY_HISTOGRAM_SIZE 16
+
+/**
+ * \brief Latency histogram of the serial link layer
+ *
+ * The limits of the buckets are powers of two: bucket i counts the samples below 250 us * 2^i
+ * (250 us, 500 us, 1 ms, 2 ms, ... 4.096 s). The last bucket also counts all larger samples.
+ */
+typedef struct sCS101_LatencyHistogram CS101_LatencyHistogram;
+
+struct sCS101_LatencyHistogram
+{
+    uint32_t count; /**< number of samples */
+    uint64_t sumUs; /**< sum of all samples in us */
+    uint32_t minUs; /**< smallest sample in us */
+    uint32_t maxUs; /**< largest sample in us */
+    uint32_t buckets[CS101_LATENCY_HISTOGRAM_SIZE];
+};
+
+/**
+ * \brief Counters of the serial link layer (CS 101)
+ *
+ * The counters are updated by the link layer with a few instructions per frame and are
+ * always enabled.
+ */
+typedef struct sCS101_LinkLayerStatistics CS101_LinkLayerStatistics;
+
+struct sCS101_LinkLayerStatistics
+{
+    uint64_t bytesSent; /**< bytes written to the serial port */
+    uint64_t bytesReceived; /**< bytes read from the serial port (including discarded bytes) */
+    uint32_t framesSent; /**< sent frames (including single character ACKs) */
+    uint32_t framesReceived; /**< received complete frames */
+    uint32_t syncErrors; /**< received bytes that are not the start of a frame */
+    uint32_t characterTimeouts; /**< incomplete frames (character timeout) */
+    uint32_t checksumErrors; /**< frames with an invalid checksum */
+    uint32_t invalidFrames; /**< frames with invalid length fields or an unexpected format */
+
+    uint32_t requests; /**< sent primary frames that require a response (including repetitions) */
+    uint32_t responses; /**< received responses to these frames */
+    uint32_t retransmissions; /**< repeated primary frames because of a missing response */
+    uint32_t timeouts; /**< response timeouts */
+    uint32_t repeatedRequests; /**< received requests with unchanged FCB (repetitions of the other station) */
+
+    CS101_LatencyHistogram roundTripTime; /**< time from sending a request until the response is received */
+    CS101_LatencyHistogram responseTime; /**< time from receiving a request until the response is sent */
+};
+
 /**
  * \brief Parameters for the CS101/CS104 application layer
  */
@@ -279,6 +328,16 @@ struct sCS104_APCIParameters {
     int t3;
 };
 
+/**
+ * \brief Counters for the acknowledgement of received I messages (CS 104)
+ */
+typedef struct sCS104_AckStatistics* CS104_AckStatistics;
+
+struct sCS104_AckStatistics {
+    uint32_t sentAcks;  /**< number of sent S messages */
+    uint32_t savedAcks; /**< number of due acknowledgements that were carried by an I message instead of an S message */
+};
+
 #include "cs101_information_objects.h"
 
 typedef enum {
@@ -62,6 +62,34 @@ extern "C" {
  */
 typedef struct sIMasterConnection* IMasterConnection;
 
+/**
+ * \brief Generator that creates the ASDUs of a streamed response (see \ref IMasterConnection_startResponse)
+ *
+ * The generator is called by the connection whenever the next ASDU can be sent without queuing
+ * (free slot in the k-window for CS 104, empty class 1 queue for CS 101). It is never called from
+ * within \ref IMasterConnection_startResponse.
+ *
+ * \param parameter user provided parameter
+ * \param connection the connection the response is sent to
+ * \param buffer buffer that can be used to create the ASDU (\ref CS101_ASDU_initializeStatic)
+ *
+ * \return the next ASDU of the response or NULL when the response is complete. The ASDU has to stay valid
+ *         until the next call of the generator or the finished handler.
+ */
+typedef CS101_ASDU (*CS101_ResponseGenerator) (void* parameter, IMasterConnection connection, CS101_StaticASDU buffer);
+
+/**
+ * \brief Handler that is called when a streamed response is finished
+ *
+ * Can be used to release the resources of the generator.
+ *
+ * \param parameter user provided parameter
+ * \param connection the connection the response was sent to
+ * \param completed true when all ASDUs (and the ACT_TERM) have been sent, false when the response was
+ *        aborted (connection closed)
+ */
+typedef void (*CS101_ResponseFinishedHandler) (void* parameter, IMasterConnection connection, bool completed);
+
 struct sIMasterConnection {
     bool (*isReady) (IMasterConnection self);
     bool (*sendASDU) (IMasterConnection self, CS101_ASDU asdu);
@@ -71,6 +99,8 @@ struct sIMasterConnection {
     int (*getPeerAddress) (IMasterConnection self, char* addrBuf, int addrBufSize);
     CS101_AppLayerParameters (*getApplicationLayerParameters) (IMasterConnection self);
     void* object;
+    bool (*startResponse) (IMasterConnection self, CS101_ASDU command, CS101_ResponseGenerator generator,
+                           CS101_ResponseFinishedHandler finishedHandler, void* parameter);
 };
 
 /*
@@ -152,6 +182,33 @@ IMasterConnection_close(IMasterConnection self);
 CS101_AppLayerParameters
 IMasterConnection_getApplicationLayerParameters(IMasterConnection self);
 
+/**
+ * \brief Start a streamed response (e.g. the response to an interrogation command)
+ *
+ * Instead of sending all ASDUs of a large response from within the callback handler (and losing
+ * ASDUs when the queues are full) the handler registers a generator. The connection calls the generator
+ * whenever the next ASDU can be sent and sends the ASDU. When the generator returns NULL the ACT_TERM
+ * of the command is sent and the finished handler is called. Only one ASDU of the response is buffered
+ * at a time.
+ *
+ * The ACT_CON has to be sent by the handler before the response is started. When more than one response
+ * is started for a connection the responses are sent one after another.
+ *
+ * NOTE: Has to be called from within a callback handler of the connection.
+ *
+ * \param command the command ASDU (the ACT_TERM is sent with a copy of this ASDU when the response is
+ *        complete) or NULL when no ACT_TERM is required
+ * \param generator the generator that creates the ASDUs of the response
+ * \param finishedHandler handler that is called when the response is finished or aborted (optional - can be NULL)
+ * \param parameter user provided parameter that is passed to the generator and the finished handler
+ *
+ * \return true when the response was started, false when the connection doesn't support streamed
+ *         responses or out of memory (the finished handler is not called)
+ */
+bool
+IMasterConnection_startResponse(IMasterConnection self, CS101_ASDU command, CS101_ResponseGenerator generator,
+                                CS101_ResponseFinishedHandler finishedHandler, void* parameter);
+
 /**
  * @}
  */
@@ -0,0 +1,54 @@
+/*
+ *  cs101_master_internal.h
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_INTERNAL_CS101_MASTER_INTERNAL_H_
+#define SRC_INC_INTERNAL_CS101_MASTER_INTERNAL_H_
+
+#include "serial_transceiver_ft_1_2.h"
+#include "cs101_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+SerialTransceiverFT12
+CS101_Master_getTransceiver(CS101_Master self);
+
+bool
+CS101_Master_isUnbalanced(CS101_Master self);
+
+/**
+ * \brief Send an ASDU to the slave with the given link layer address (unbalanced mode)
+ *
+ * In balanced mode the ASDU is added to the user data queue and the address is ignored.
+ *
+ * \return false when the link layer cannot accept the message
+ */
+bool
+CS101_Master_sendASDUToSlave(CS101_Master self, int address, CS101_ASDU asdu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_INTERNAL_CS101_MASTER_INTERNAL_H_ */
@@ -32,6 +32,8 @@ extern "C" {
 #include "hal_thread.h"
 #endif
 
+#include "cs101_slave.h"
+
 #ifdef CONFIG_SLAVE_MESSAGE_QUEUE_SIZE
 #define CS101_MAX_QUEUE_SIZE CONFIG_SLAVE_MESSAGE_QUEUE_SIZE
 #else
@@ -43,6 +45,12 @@ typedef struct sCS101_QueueElement* CS101_QueueElement;
 struct sCS101_QueueElement {
     uint8_t size;
     uint8_t buffer[256];
+#if (CONFIG_CS101_QUEUE_EVENT_AGE == 1)
+    uint64_t enqueueTime; /* monotonic time when the ASDU was added (used for the event age) */
+#endif
+#if (CONFIG_CS101_QUEUE_COALESCING == 1)
+    uint64_t coalescingKey; /* type ID, CA and IOA of a cyclic value (0 = can not be coalesced) */
+#endif
 };
 
 typedef struct sCS101_Queue* CS101_Queue;
@@ -56,6 +64,16 @@ struct sCS101_Queue {
 
     struct sBufferFrame encodeFrame;
 
+    bool coalescing; /* replace queued cyclic values with newer values of the same IOA */
+
+    /* statistics */
+    uint64_t enqueuedCounter;
+    uint64_t dequeuedCounter;
+    uint64_t droppedCounter;
+    uint64_t coalescedCounter;
+    uint64_t totalAge;
+    uint64_t maxAge;
+
 #if (CS101_MAX_QUEUE_SIZE == -1)
     struct sCS101_QueueElement* elements;
 #else
@@ -82,6 +100,25 @@ CS101_Queue_unlock(CS101_Queue self);
 void
 CS101_Queue_enqueue(CS101_Queue self, CS101_ASDU asdu);
 
+/*
+ * Enqueue multiple ASDUs with a single lock operation
+ */
+void
+CS101_Queue_enqueueBatch(CS101_Queue self, CS101_ASDU* asdus, int numberOfAsdus);
+
+/*
+ * Enable coalescing of cyclic values (COT periodic or background scan) with a single
+ * information object. A new value replaces a queued value of the same IOA.
+ */
+void
+CS101_Queue_setCoalescing(CS101_Queue self, bool enable);
+
+/*
+ * Add the statistics of the queue to the given statistics structure
+ */
+void
+CS101_Queue_addStatistics(CS101_Queue self, CS101_QueueStatistics* statistics);
+
     /*
      * NOTE: Locking has to be done by caller!
      */
@@ -0,0 +1,112 @@
+/*
+ *  cs101_response_stream.h
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_INTERNAL_CS101_RESPONSE_STREAM_H_
+#define SRC_INC_INTERNAL_CS101_RESPONSE_STREAM_H_
+
+#include <stdbool.h>
+
+#include "iec60870_slave.h"
+#include "lib60870_config.h"
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+#include "hal_thread.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Streamed responses of a master connection (see IMasterConnection_startResponse).
+ *
+ * The responses are sent one after another in the order they were started. The connection
+ * calls CS101_ResponseStreams_sendNext whenever it can send an ASDU without queuing it. Each
+ * call sends a single ASDU of the active response (or its ACT_TERM), so at most one ASDU
+ * per response is buffered.
+ *
+ * Responses can be added from the callback handlers while the connection sends. The ASDUs
+ * are only created and sent by the caller of CS101_ResponseStreams_sendNext.
+ */
+typedef struct sCS101_ResponseStream* CS101_ResponseStream;
+
+typedef struct sCS101_ResponseStreams* CS101_ResponseStreams;
+
+struct sCS101_ResponseStreams
+{
+    CS101_ResponseStream first;
+    CS101_ResponseStream last;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore lock;
+#endif
+};
+
+void
+CS101_ResponseStreams_initialize(CS101_ResponseStreams self);
+
+/**
+ * \brief Release all resources (the remaining responses are aborted without calling the finished handlers)
+ */
+void
+CS101_ResponseStreams_dispose(CS101_ResponseStreams self);
+
+/**
+ * \brief Add a new response
+ *
+ * \param command the command ASDU that is used for the ACT_TERM (is copied) or NULL
+ *
+ * \return true on success, false when out of memory
+ */
+bool
+CS101_ResponseStreams_add(CS101_ResponseStreams self, CS101_ASDU command, CS101_ResponseGenerator generator,
+                          CS101_ResponseFinishedHandler finishedHandler, void* parameter);
+
+bool
+CS101_ResponseStreams_isEmpty(CS101_ResponseStreams self);
+
+/**
+ * \brief Send the next ASDU of the active response
+ *
+ * The caller has to check that the connection can send the ASDU without queuing it. When sending fails
+ * the ASDU is kept and sent again with the next call.
+ *
+ * \return true when an ASDU was sent or the active response was finished, false when no response is active
+ *         or the ASDU could not be sent
+ */
+bool
+CS101_ResponseStreams_sendNext(CS101_ResponseStreams self, IMasterConnection connection);
+
+/**
+ * \brief Abort all responses (e.g. when the connection is closed)
+ *
+ * The finished handlers are called with completed = false.
+ */
+void
+CS101_ResponseStreams_clear(CS101_ResponseStreams self, IMasterConnection connection);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_INTERNAL_CS101_RESPONSE_STREAM_H_ */
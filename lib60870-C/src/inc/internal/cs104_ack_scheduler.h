@@ -0,0 +1,133 @@
+/*
+ *  cs104_ack_scheduler.h
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_INTERNAL_CS104_ACK_SCHEDULER_H_
+#define SRC_INC_INTERNAL_CS104_ACK_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iec60870_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Decides when received I messages have to be confirmed by an S message.
+ *
+ * Without the adaptive policy an S message is sent when w I messages are unconfirmed (or
+ * when T2 elapses). With the adaptive policy the acknowledgement threshold is lowered when
+ * the counterpart would otherwise run into its k limit before the acknowledgement arrives
+ * (high message rate compared to the round trip time). When the threshold is reached the
+ * S message is deferred for a short time so that an outgoing I message can carry N(R)
+ * instead. At the limit w the S message is only deferred when an own I message is expected
+ * before the deadline (estimated from the send interval). The deferral is bounded by T2/4
+ * and ends when k messages are unconfirmed (the counterpart cannot send more).
+ *
+ * The caller is responsible for locking and for the T2 timeout.
+ */
+typedef struct sCS104_AckScheduler* CS104_AckScheduler;
+
+struct sCS104_AckScheduler
+{
+    bool adaptive;
+
+    int k;
+    int w;
+    int t2InMs;
+
+    int threshold;          /* current acknowledgement threshold (1..w) */
+    uint64_t ackDeadline;   /* time when a deferred acknowledgement has to be sent (0 -> not deferred) */
+    bool ackPending;        /* an acknowledgement is due (S message deferred or replaced by a pending I message) */
+
+    uint64_t lastIMessageTime;
+    int interArrivalTime8;  /* smoothed time between received I messages (ms * 8) */
+
+    uint64_t lastSentIMessageTime;
+    int sendInterval8;      /* smoothed time between sent I messages (ms * 8) */
+    int roundTripTime8;     /* smoothed acknowledgement round trip time (ms * 8) */
+
+    /* counters are kept when the scheduler is reset */
+    uint32_t sentAcks;
+    uint32_t savedAcks;
+};
+
+/**
+ * \brief Reset the scheduler state for a new connection (the counters are kept)
+ */
+void
+CS104_AckScheduler_reset(CS104_AckScheduler self, CS104_APCIParameters parameters, bool adaptive);
+
+/**
+ * \brief Update the rate estimation when an I message was received
+ */
+void
+CS104_AckScheduler_iMessageReceived(CS104_AckScheduler self, uint64_t currentTime);
+
+/**
+ * \brief Update the round trip estimation with the time between sending a message and receiving its confirmation
+ */
+void
+CS104_AckScheduler_updateRoundTripTime(CS104_AckScheduler self, uint64_t sentTime, uint64_t currentTime);
+
+/**
+ * \brief Check if an S message has to be sent now
+ *
+ * \param unconfirmed number of unconfirmed received I messages
+ * \param iMessagePending true when the caller sends an I message immediately after this call
+ *
+ * \return true when an S message has to be sent
+ */
+bool
+CS104_AckScheduler_isAckRequired(CS104_AckScheduler self, int unconfirmed, bool iMessagePending, uint64_t currentTime);
+
+/**
+ * \brief Get the time until a deferred acknowledgement is due
+ *
+ * \param maxWaitTime the value to be returned when no acknowledgement is deferred
+ *
+ * \return the wait time in ms (at most maxWaitTime)
+ */
+int
+CS104_AckScheduler_getWaitTime(CS104_AckScheduler self, uint64_t currentTime, int maxWaitTime);
+
+/**
+ * \brief Has to be called when an S message was sent
+ */
+void
+CS104_AckScheduler_ackSent(CS104_AckScheduler self);
+
+/**
+ * \brief Has to be called when an I message (that confirms all received I messages) was sent
+ *
+ * \param unconfirmed number of unconfirmed received I messages before the I message was sent
+ */
+void
+CS104_AckScheduler_iMessageSent(CS104_AckScheduler self, int unconfirmed, uint64_t currentTime);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_INTERNAL_CS104_ACK_SCHEDULER_H_ */
@@ -0,0 +1,106 @@
+/*
+ *  cs104_address_resolver.h
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_INTERNAL_CS104_ADDRESS_RESOLVER_H_
+#define SRC_INC_INTERNAL_CS104_ADDRESS_RESOLVER_H_
+
+#include <stdbool.h>
+
+#include "hal_socket.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Asynchronous hostname lookup used by the CS104 client.
+ *
+ * Numeric addresses are resolved immediately. Other hostnames are resolved by a
+ * separate resolver thread so the connection thread can still handle timeouts and
+ * close requests while the DNS lookup is in progress. A connection keeps its lookup
+ * and reuses the resolved addresses for reconnects until CONFIG_CS104_RESOLVER_CACHE_TTL
+ * elapsed. Reusing a pending lookup ensures that there is at most one resolver thread
+ * per connection even when the DNS server doesn't respond.
+ */
+typedef struct sCS104_AddressLookup* CS104_AddressLookup;
+
+typedef enum
+{
+    CS104_ADDRESS_LOOKUP_PENDING = 0,
+    CS104_ADDRESS_LOOKUP_DONE = 1,
+    CS104_ADDRESS_LOOKUP_FAILED = 2
+} CS104_AddressLookupState;
+
+/**
+ * \brief Start the lookup of a hostname
+ *
+ * \return the lookup object or NULL when out of memory
+ */
+CS104_AddressLookup
+CS104_AddressLookup_create(const char* hostname);
+
+CS104_AddressLookupState
+CS104_AddressLookup_getState(CS104_AddressLookup self);
+
+/**
+ * \brief Wait until the lookup has finished or the timeout elapsed
+ *
+ * \return the state of the lookup (CS104_ADDRESS_LOOKUP_PENDING when the timeout elapsed)
+ */
+CS104_AddressLookupState
+CS104_AddressLookup_waitForResult(CS104_AddressLookup self, int timeoutInMs);
+
+/**
+ * \brief Check if the lookup can be used for the next connection attempt
+ *
+ * \return true when the lookup is still pending or the resolved addresses did not expire
+ */
+bool
+CS104_AddressLookup_isReusable(CS104_AddressLookup self);
+
+/**
+ * \brief Get the number of resolved addresses (only valid in state CS104_ADDRESS_LOOKUP_DONE)
+ */
+int
+CS104_AddressLookup_getAddressCount(CS104_AddressLookup self);
+
+/**
+ * \brief Get a resolved numeric address (ordered for connection racing)
+ */
+const char*
+CS104_AddressLookup_getAddress(CS104_AddressLookup self, int index);
+
+/**
+ * \brief Release the lookup object
+ *
+ * Can be called while the lookup is still pending. The resolver thread will then
+ * release the object when the lookup has finished.
+ */
+void
+CS104_AddressLookup_destroy(CS104_AddressLookup self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_INTERNAL_CS104_ADDRESS_RESOLVER_H_ */
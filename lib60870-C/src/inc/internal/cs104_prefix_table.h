@@ -0,0 +1,82 @@
+/*
+ *  cs104_prefix_table.h
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_INTERNAL_CS104_PREFIX_TABLE_H_
+#define SRC_INC_INTERNAL_CS104_PREFIX_TABLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * IP address prefix table used by the CS104 slave to find the redundancy group of a client
+ *
+ * The table maps IPv4 and IPv6 address prefixes (network address and prefix length) to
+ * a value. A lookup returns the value of the longest prefix that matches the address
+ * (a single address is a prefix with the full length). The prefixes are stored in a
+ * binary trie (one bit per level) so the lookup time only depends on the address length
+ * and not on the number of prefixes.
+ */
+typedef struct sCS104_PrefixTable* CS104_PrefixTable;
+
+CS104_PrefixTable
+CS104_PrefixTable_create(void);
+
+void
+CS104_PrefixTable_destroy(CS104_PrefixTable self);
+
+/**
+ * \brief Add a prefix to the table
+ *
+ * When the same prefix is added more than once the first value is kept.
+ *
+ * \param address the network address in network byte order
+ * \param addressSize 4 for an IPv4 address, 16 for an IPv6 address
+ * \param prefixLength number of significant bits of the address (0 - 32 or 0 - 128)
+ * \param value the value for the prefix (must not be NULL)
+ *
+ * \return true on success, false when the parameters are invalid or out of memory
+ */
+bool
+CS104_PrefixTable_add(CS104_PrefixTable self, const uint8_t* address, int addressSize, int prefixLength, void* value);
+
+/**
+ * \brief Find the value of the longest prefix that matches the address
+ *
+ * \param address the address in network byte order
+ * \param addressSize 4 for an IPv4 address, 16 for an IPv6 address
+ *
+ * \return the value or NULL when no prefix matches
+ */
+void*
+CS104_PrefixTable_lookup(CS104_PrefixTable self, const uint8_t* address, int addressSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_INTERNAL_CS104_PREFIX_TABLE_H_ */
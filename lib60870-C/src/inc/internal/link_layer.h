@@ -111,6 +111,26 @@ LinkLayerPrimaryUnbalanced_sendNoReply(LinkLayerPrimaryUnbalanced self, int slav
 void
 LinkLayerPrimaryUnbalanced_run(LinkLayerPrimaryUnbalanced self);
 
+void
+LinkLayerPrimaryUnbalanced_setPriorityScheduling(LinkLayerPrimaryUnbalanced self, bool enable);
+
+bool
+LinkLayerPrimaryUnbalanced_setSlavePollParameters(LinkLayerPrimaryUnbalanced self, int slaveAddress, int weight,
+                                                  int class2PollInterval);
+
+void
+LinkLayerPrimaryUnbalanced_setTimeoutBackoff(LinkLayerPrimaryUnbalanced self, int initialBackoff, int maxBackoff);
+
+void
+LinkLayerPrimaryUnbalanced_getStatistics(LinkLayerPrimaryUnbalanced self, CS101_LinkLayerStatistics* statistics);
+
+bool
+LinkLayerPrimaryUnbalanced_getSlaveStatistics(LinkLayerPrimaryUnbalanced self, int slaveAddress,
+                                              CS101_LinkLayerStatistics* statistics);
+
+void
+LinkLayerPrimaryUnbalanced_resetStatistics(LinkLayerPrimaryUnbalanced self);
+
 
 
 
@@ -139,6 +159,12 @@ LinkLayerSecondaryUnbalanced_setStateChangeHandler(LinkLayerSecondaryUnbalanced
 void
 LinkLayerSecondaryUnbalanced_setAddress(LinkLayerSecondaryUnbalanced self, int address);
 
+void
+LinkLayerSecondaryUnbalanced_getStatistics(LinkLayerSecondaryUnbalanced self, CS101_LinkLayerStatistics* statistics);
+
+void
+LinkLayerSecondaryUnbalanced_resetStatistics(LinkLayerSecondaryUnbalanced self);
+
 LinkLayerBalanced
 LinkLayerBalanced_create(
         int linkLayerAddress,
@@ -167,6 +193,12 @@ LinkLayerBalanced_setAddress(LinkLayerBalanced self, int address);
 void
 LinkLayerBalanced_setOtherStationAddress(LinkLayerBalanced self, int address);
 
+void
+LinkLayerBalanced_getStatistics(LinkLayerBalanced self, CS101_LinkLayerStatistics* statistics);
+
+void
+LinkLayerBalanced_resetStatistics(LinkLayerBalanced self);
+
 void
 LinkLayerBalanced_destroy(LinkLayerBalanced self);
 
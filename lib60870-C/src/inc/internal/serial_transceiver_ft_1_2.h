@@ -51,6 +51,24 @@ SerialTransceiverFT12_setRawMessageHandler(SerialTransceiverFT12 self, IEC60870_
 int
 SerialTransceiverFT12_getBaudRate(SerialTransceiverFT12 self);
 
+uint64_t
+SerialTransceiverFT12_getTransmitCompleteTime(SerialTransceiverFT12 self);
+
+SerialPort
+SerialTransceiverFT12_getSerialPort(SerialTransceiverFT12 self);
+
+void
+SerialTransceiverFT12_setNonBlocking(SerialTransceiverFT12 self, bool nonBlocking);
+
+bool
+SerialTransceiverFT12_isMessageAvailable(SerialTransceiverFT12 self);
+
+void
+SerialTransceiverFT12_getStatistics(SerialTransceiverFT12 self, CS101_LinkLayerStatistics* statistics);
+
+void
+SerialTransceiverFT12_resetStatistics(SerialTransceiverFT12 self);
+
 void
 SerialTransceiverFT12_sendMessage(SerialTransceiverFT12 self, uint8_t* msg, int msgSize);
 
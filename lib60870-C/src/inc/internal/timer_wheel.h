@@ -0,0 +1,126 @@
+/*
+ *  timer_wheel.h
+ *
+ *  Copyright 2024 Michael Zillgith
+ *
+ *  This file is part of lib60870-C
+ *
+ *  lib60870-C is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  lib60870-C is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with lib60870-C.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  See COPYING file for the complete license text.
+ */
+
+#ifndef SRC_INC_INTERNAL_TIMER_WHEEL_H_
+#define SRC_INC_INTERNAL_TIMER_WHEEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Hierarchical timer wheel for many timers with millisecond resolution
+ *
+ * The wheel has TIMER_WHEEL_LEVELS levels with the same number of slots. A slot of the
+ * first level covers one tick, a slot of the next level covers all ticks of the level
+ * below. Timers are stored in the lowest level that can hold their expiry tick and move
+ * down (cascade) when the wheel reaches their slot. Timers that expire beyond the range
+ * of the highest level are stored in its last slot and moved again later.
+ *
+ * Scheduling and canceling a timer is O(1). Advancing the wheel only touches the slots
+ * of the elapsed ticks and the expired or cascaded timers - not the other timers. The
+ * timer entries are provided by the user (usually embedded in the object that owns the
+ * timer).
+ */
+#define TIMER_WHEEL_LEVELS 4
+
+typedef struct sTimerWheel* TimerWheel;
+
+typedef struct sTimerWheelEntry* TimerWheelEntry;
+
+typedef void (*TimerWheelHandler) (void* parameter);
+
+struct sTimerWheelEntry
+{
+    TimerWheelEntry next;
+    TimerWheelEntry prev;
+
+    uint64_t expiryTime;
+    bool isScheduled;
+    int level; /* level of the wheel that holds the entry */
+
+    TimerWheelHandler handler;
+    void* parameter;
+};
+
+/**
+ * \brief Create a new timer wheel
+ *
+ * \param numberOfSlots number of slots of each level (has to be a power of two - at least 2)
+ * \param resolutionInMs duration of a tick in ms
+ * \param currentTime the current time in ms
+ */
+TimerWheel
+TimerWheel_create(int numberOfSlots, int resolutionInMs, uint64_t currentTime);
+
+void
+TimerWheel_destroy(TimerWheel self);
+
+/**
+ * \brief Initialize a timer entry (has to be called before the entry is used)
+ */
+void
+TimerWheelEntry_initialize(TimerWheelEntry entry, TimerWheelHandler handler, void* parameter);
+
+/**
+ * \brief Schedule a timer (an already scheduled timer is rescheduled)
+ *
+ * \param expiryTime the time when the handler is called (in ms)
+ */
+void
+TimerWheel_schedule(TimerWheel self, TimerWheelEntry entry, uint64_t expiryTime);
+
+/**
+ * \brief Cancel a timer (has no effect when the timer is not scheduled)
+ */
+void
+TimerWheel_cancel(TimerWheel self, TimerWheelEntry entry);
+
+/**
+ * \brief Get the time until the next timer expires
+ *
+ * \param maxTimeout the value returned when no timer expires before
+ *
+ * \return the time to wait in ms (0 when timers are already expired)
+ */
+int
+TimerWheel_getNextTimeout(TimerWheel self, uint64_t currentTime, int maxTimeout);
+
+/**
+ * \brief Call the handlers of all expired timers
+ *
+ * The handlers can schedule and cancel timers.
+ *
+ * \return number of expired timers
+ */
+int
+TimerWheel_advance(TimerWheel self, uint64_t currentTime);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_INC_INTERNAL_TIMER_WHEEL_H_ */
@@ -1,13 +1,31 @@
+#if defined(__linux__)
+#define _GNU_SOURCE /* posix_openpt */
+#endif
+
 #include "unity.h"
 #include "iec60870_common.h"
 #include "cs104_slave.h"
 #include "cs104_connection.h"
+#include "cs104_redundant_connection.h"
+#include "cs101_port_scheduler.h"
+#include "cs101_process_image.h"
 #include "hal_time.h"
 #include "hal_thread.h"
+#include "hal_socket.h"
 #include "buffer_frame.h"
+#include "timer_wheel.h"
+#include "cs104_ack_scheduler.h"
+#include "cs104_prefix_table.h"
+#include "serial_transceiver_ft_1_2.h"
 #include <string.h>
 #include <stdlib.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 #ifndef CONFIG_CS104_SUPPORT_TLS
 #define CONFIG_CS104_SUPPORT_TLS 0
 #endif
@@ -5604,6 +5622,4325 @@ test_CS104_Connection_async_timeout(void)
 	CS104_Connection_destroy(con);
 }
 
+void
+test_Socket_resolveHostname(void)
+{
+    char addresses[4][SOCKET_MAX_ADDRESS_STRING_LENGTH];
+
+    int count = Socket_resolveHostname("127.0.0.1", true, addresses, 4);
+
+    TEST_ASSERT_EQUAL_INT(1, count);
+    TEST_ASSERT_EQUAL_STRING("127.0.0.1", addresses[0]);
+
+    count = Socket_resolveHostname("::1", true, addresses, 4);
+
+    TEST_ASSERT_EQUAL_INT(1, count);
+    TEST_ASSERT_EQUAL_STRING("::1", addresses[0]);
+
+    /* hostnames are rejected when only numeric addresses are allowed */
+    count = Socket_resolveHostname("localhost", true, addresses, 4);
+
+    TEST_ASSERT_EQUAL_INT(-1, count);
+
+    count = Socket_resolveHostname("localhost", false, addresses, 4);
+
+    TEST_ASSERT_TRUE(count > 0);
+}
+
+void
+test_CS104_Connection_connectUsingHostname(void)
+{
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    TEST_ASSERT_NOT_NULL(slave);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_start(slave);
+
+    /* "localhost" can resolve to ::1 first - the slave only listens on IPv4 */
+    CS104_Connection con = CS104_Connection_create("localhost", 20004);
+
+    TEST_ASSERT_NOT_NULL(con);
+
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        bool result = CS104_Connection_connect(con);
+
+        TEST_ASSERT_TRUE(result);
+
+        CS104_Connection_close(con);
+    }
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_destroy(slave);
+}
+
+static char test_CS104_Connection_localAddress_clientAddress[100];
+
+static bool
+test_CS104_Connection_localAddress_connectionRequestHandler(void* parameter, const char* ipAddress)
+{
+    (void)parameter;
+
+    strncpy(test_CS104_Connection_localAddress_clientAddress, ipAddress, 99);
+
+    return true;
+}
+
+void
+test_CS104_Connection_connectUsingHostnameKeepsLocalAddress(void)
+{
+#ifndef _WIN32
+    char* clientAddress = test_CS104_Connection_localAddress_clientAddress;
+
+    memset(clientAddress, 0, sizeof(test_CS104_Connection_localAddress_clientAddress));
+
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    TEST_ASSERT_NOT_NULL(slave);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setConnectionRequestHandler(slave, test_CS104_Connection_localAddress_connectionRequestHandler,
+                                            NULL);
+    CS104_Slave_start(slave);
+
+    /* an IPv6 candidate of "localhost" must not replace the socket bound to the IPv4 local address */
+    CS104_Connection con = CS104_Connection_create("localhost", 20004);
+
+    TEST_ASSERT_NOT_NULL(con);
+
+    CS104_Connection_setLocalAddress(con, "127.0.0.2", 0);
+
+    bool connected = CS104_Connection_connect(con);
+
+    /* the connection request handler is called by the slave thread */
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    while ((clientAddress[0] == 0) && (Hal_getMonotonicTimeInMs() < startTime + 1000))
+        Thread_sleep(10);
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_destroy(slave);
+
+    TEST_ASSERT_TRUE(connected);
+    TEST_ASSERT_EQUAL_STRING("127.0.0.2", clientAddress);
+#endif
+}
+
+void
+test_CS104_Connection_reconnectBackoff(void)
+{
+    test_CS104_Connection_async_timeout_event = CS104_CONNECTION_CLOSED;
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    TEST_ASSERT_NOT_NULL(con);
+
+    CS104_Connection_setReconnectBackoff(con, 200, 1000);
+
+    /* no server -> connection is refused */
+    bool result = CS104_Connection_connect(con);
+
+    TEST_ASSERT_FALSE(result);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    result = CS104_Connection_connect(con);
+
+    TEST_ASSERT_FALSE(result);
+
+    /* second attempt is delayed by the backoff */
+    TEST_ASSERT_TRUE((Hal_getMonotonicTimeInMs() - startTime) >= 200);
+
+    /* close interrupts the backoff delay */
+    CS104_Connection_setConnectionHandler(con, test_CS104_Connection_async_timeout_connectionHandler, NULL);
+
+    startTime = Hal_getMonotonicTimeInMs();
+
+    CS104_Connection_connectAsync(con);
+    CS104_Connection_close(con);
+
+    TEST_ASSERT_TRUE((Hal_getMonotonicTimeInMs() - startTime) < 400);
+    TEST_ASSERT_EQUAL_INT(CS104_CONNECTION_FAILED, test_CS104_Connection_async_timeout_event);
+
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_start(slave);
+
+    result = CS104_Connection_connect(con);
+
+    TEST_ASSERT_TRUE(result);
+
+    CS104_Connection_close(con);
+
+    /* backoff is reset after a successful connection */
+    startTime = Hal_getMonotonicTimeInMs();
+
+    result = CS104_Connection_connect(con);
+
+    TEST_ASSERT_TRUE(result);
+    TEST_ASSERT_TRUE((Hal_getMonotonicTimeInMs() - startTime) < 200);
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_destroy(slave);
+}
+
+struct stest_CS104RedundantConnection {
+    int spontCount;
+    int interrogationCount;
+    int activatedPath;
+};
+
+static bool
+test_CS104RedundantConnection_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    struct stest_CS104RedundantConnection* info = (struct stest_CS104RedundantConnection*) parameter;
+
+    if (CS101_ASDU_getCOT(asdu) == CS101_COT_SPONTANEOUS)
+        info->spontCount++;
+
+    return true;
+}
+
+static void
+test_CS104RedundantConnection_connectionHandler(void* parameter, CS104_RedundantConnection connection, int pathIndex,
+                                                CS104_RedundantConnectionEvent event)
+{
+    struct stest_CS104RedundantConnection* info = (struct stest_CS104RedundantConnection*) parameter;
+
+    if (event == CS104_REDUNDANT_CONNECTION_PATH_ACTIVATED)
+        info->activatedPath = pathIndex;
+}
+
+static bool
+test_CS104RedundantConnection_interrogationHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu,
+                                                   uint8_t qoi)
+{
+    struct stest_CS104RedundantConnection* info = (struct stest_CS104RedundantConnection*) parameter;
+
+    info->interrogationCount++;
+
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+    IMasterConnection_sendACT_TERM(connection, asdu);
+
+    return true;
+}
+
+static void
+test_CS104RedundantConnection_enqueueEvent(CS104_Slave slave, int value)
+{
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 110, value, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(newAsdu, io);
+
+    InformationObject_destroy(io);
+
+    CS104_Slave_enqueueASDU(slave, newAsdu);
+
+    CS101_ASDU_destroy(newAsdu);
+}
+
+void
+test_CS104RedundantConnection_switchover(void)
+{
+    struct stest_CS104RedundantConnection info;
+    info.spontCount = 0;
+    info.interrogationCount = 0;
+    info.activatedPath = -1;
+
+    CS104_Slave slave1 = CS104_Slave_create(10, 10);
+    CS104_Slave_setLocalPort(slave1, 20004);
+    CS104_Slave_start(slave1);
+
+    CS104_Slave slave2 = CS104_Slave_create(10, 10);
+    CS104_Slave_setLocalPort(slave2, 20005);
+    CS104_Slave_setInterrogationHandler(slave2, test_CS104RedundantConnection_interrogationHandler, &info);
+    CS104_Slave_start(slave2);
+
+    CS104_RedundantConnection con = CS104_RedundantConnection_create();
+
+    TEST_ASSERT_NOT_NULL(con);
+
+    TEST_ASSERT_EQUAL_INT(0, CS104_RedundantConnection_addPath(con, "127.0.0.1", 20004));
+    TEST_ASSERT_EQUAL_INT(1, CS104_RedundantConnection_addPath(con, "127.0.0.1", 20005));
+
+    CS104_RedundantConnection_setASDUReceivedHandler(con, test_CS104RedundantConnection_asduReceivedHandler, &info);
+    CS104_RedundantConnection_setConnectionHandler(con, test_CS104RedundantConnection_connectionHandler, &info);
+    CS104_RedundantConnection_setInterrogationOnSwitchover(con, true, 1);
+
+    CS104_RedundantConnection_start(con);
+
+    Thread_sleep(500);
+
+    TEST_ASSERT_EQUAL_INT(0, CS104_RedundantConnection_getActivePath(con));
+    TEST_ASSERT_EQUAL_INT(0, info.activatedPath);
+
+    test_CS104RedundantConnection_enqueueEvent(slave1, 1);
+
+    Thread_sleep(200);
+
+    TEST_ASSERT_EQUAL_INT(1, info.spontCount);
+
+    /* the standby server repeats the event that was already received on the active path */
+    test_CS104RedundantConnection_enqueueEvent(slave2, 1);
+    test_CS104RedundantConnection_enqueueEvent(slave2, 2);
+
+    Thread_sleep(200);
+
+    /* standby path doesn't deliver data */
+    TEST_ASSERT_EQUAL_INT(1, info.spontCount);
+
+    uint64_t failureTime = Hal_getMonotonicTimeInMs();
+
+    CS104_Slave_destroy(slave1);
+
+    while ((CS104_RedundantConnection_getActivePath(con) != 1) && (Hal_getMonotonicTimeInMs() < failureTime + 1000))
+        Thread_sleep(1);
+
+    TEST_ASSERT_EQUAL_INT(1, CS104_RedundantConnection_getActivePath(con));
+    TEST_ASSERT_EQUAL_INT(1, info.activatedPath);
+
+    Thread_sleep(200);
+
+    /* only the new event is delivered - the repeated event is discarded */
+    TEST_ASSERT_EQUAL_INT(2, info.spontCount);
+    TEST_ASSERT_EQUAL_INT(1, CS104_RedundantConnection_getNumberOfDiscardedDuplicates(con));
+    TEST_ASSERT_EQUAL_INT(1, info.interrogationCount);
+
+    CS104_RedundantConnection_destroy(con);
+
+    CS104_Slave_destroy(slave2);
+}
+
+
+void
+test_CS104RedundantConnection_repeatedEvents(void)
+{
+    struct stest_CS104RedundantConnection info;
+    info.spontCount = 0;
+    info.interrogationCount = 0;
+    info.activatedPath = -1;
+
+    CS104_Slave slave1 = CS104_Slave_create(10, 10);
+    CS104_Slave_setLocalPort(slave1, 20004);
+    CS104_Slave_start(slave1);
+
+    CS104_Slave slave2 = CS104_Slave_create(10, 10);
+    CS104_Slave_setLocalPort(slave2, 20005);
+    CS104_Slave_start(slave2);
+
+    CS104_RedundantConnection con = CS104_RedundantConnection_create();
+
+    TEST_ASSERT_EQUAL_INT(0, CS104_RedundantConnection_addPath(con, "127.0.0.1", 20004));
+    TEST_ASSERT_EQUAL_INT(1, CS104_RedundantConnection_addPath(con, "127.0.0.1", 20005));
+
+    CS104_RedundantConnection_setASDUReceivedHandler(con, test_CS104RedundantConnection_asduReceivedHandler, &info);
+    CS104_RedundantConnection_setConnectionHandler(con, test_CS104RedundantConnection_connectionHandler, &info);
+
+    CS104_RedundantConnection_start(con);
+
+    Thread_sleep(500);
+
+    TEST_ASSERT_EQUAL_INT(0, CS104_RedundantConnection_getActivePath(con));
+
+    test_CS104RedundantConnection_enqueueEvent(slave1, 1);
+
+    Thread_sleep(200);
+
+    TEST_ASSERT_EQUAL_INT(1, info.spontCount);
+
+    uint64_t failureTime = Hal_getMonotonicTimeInMs();
+
+    CS104_Slave_destroy(slave1);
+
+    while ((CS104_RedundantConnection_getActivePath(con) != 1) && (Hal_getMonotonicTimeInMs() < failureTime + 1000))
+        Thread_sleep(1);
+
+    TEST_ASSERT_EQUAL_INT(1, CS104_RedundantConnection_getActivePath(con));
+
+    /* the new server repeats the last event and then reports OFF -> ON and the same value twice */
+    test_CS104RedundantConnection_enqueueEvent(slave2, 1);
+    test_CS104RedundantConnection_enqueueEvent(slave2, 0);
+    test_CS104RedundantConnection_enqueueEvent(slave2, 1);
+    test_CS104RedundantConnection_enqueueEvent(slave2, 2);
+    test_CS104RedundantConnection_enqueueEvent(slave2, 2);
+
+    Thread_sleep(200);
+
+    /* only the repetition is discarded - repeated events of the new path are delivered */
+    TEST_ASSERT_EQUAL_INT(1 + 4, info.spontCount);
+    TEST_ASSERT_EQUAL_INT(1, CS104_RedundantConnection_getNumberOfDiscardedDuplicates(con));
+
+    CS104_RedundantConnection_destroy(con);
+
+    CS104_Slave_destroy(slave2);
+}
+
+struct stest_CS104Slave_adaptiveAck {
+    CS104_Slave slave;
+    int commandCount;
+};
+
+static bool
+test_CS104Slave_adaptiveAck_asduHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu)
+{
+    struct stest_CS104Slave_adaptiveAck* info = (struct stest_CS104Slave_adaptiveAck*) parameter;
+
+    info->commandCount++;
+
+    /* every w-th command causes an event (the event is sent after the w-th I message was received) */
+    if ((info->commandCount % 8) == 0)
+    {
+        CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(info->slave);
+
+        CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) SinglePointInformation_create(NULL, 100, true, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(newAsdu, io);
+
+        InformationObject_destroy(io);
+
+        CS104_Slave_enqueueASDU(info->slave, newAsdu);
+
+        CS101_ASDU_destroy(newAsdu);
+    }
+
+    return true;
+}
+
+static void
+test_CS104Slave_adaptiveAck_run(bool adaptive, CS104_AckStatistics statistics)
+{
+    struct stest_CS104Slave_adaptiveAck info;
+    info.commandCount = 0;
+
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+    info.slave = slave;
+
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setAdaptiveAck(slave, adaptive);
+    CS104_Slave_setASDUHandler(slave, test_CS104Slave_adaptiveAck_asduHandler, &info);
+    CS104_Slave_start(slave);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    Thread_sleep(100);
+
+    for (int i = 0; i < 32; i++) {
+        InformationObject sc = (InformationObject) SingleCommand_create(NULL, 5000, true, false, 0);
+
+        TEST_ASSERT_TRUE(CS104_Connection_sendProcessCommandEx(con, CS101_COT_ACTIVATION, 1, sc));
+
+        InformationObject_destroy(sc);
+
+        if ((i % 8) == 7)
+            Thread_sleep(100);
+    }
+
+    TEST_ASSERT_EQUAL_INT(32, info.commandCount);
+
+    CS104_Slave_getAckStatistics(slave, statistics);
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+}
+
+void
+test_CS104Slave_adaptiveAck(void)
+{
+    struct sCS104_AckStatistics statistics;
+
+    /* classic policy: an S message is sent after w received I messages */
+    test_CS104Slave_adaptiveAck_run(false, &statistics);
+
+    TEST_ASSERT_EQUAL_UINT32(4, statistics.sentAcks);
+    TEST_ASSERT_EQUAL_UINT32(0, statistics.savedAcks);
+
+    /* adaptive policy: the event that is sent immediately carries the acknowledgement */
+    test_CS104Slave_adaptiveAck_run(true, &statistics);
+
+    TEST_ASSERT_EQUAL_UINT32(0, statistics.sentAcks);
+    TEST_ASSERT_EQUAL_UINT32(4, statistics.savedAcks);
+}
+
+static bool
+test_CS104_Connection_adaptiveAck_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    int* receivedCount = (int*) parameter;
+
+    (*receivedCount)++;
+
+    return true;
+}
+
+void
+test_CS104_Connection_adaptiveAck(void)
+{
+    int receivedCount = 0;
+
+    CS104_Slave slave = CS104_Slave_create(200, 10);
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_start(slave);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    CS104_Connection_setAdaptiveAck(con, true);
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104_Connection_adaptiveAck_asduReceivedHandler, &receivedCount);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    Thread_sleep(100);
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    for (int i = 0; i < 100; i++) {
+        CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 110, i, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(newAsdu, io);
+
+        InformationObject_destroy(io);
+
+        CS104_Slave_enqueueASDU(slave, newAsdu);
+
+        CS101_ASDU_destroy(newAsdu);
+    }
+
+    Thread_sleep(500);
+
+    TEST_ASSERT_EQUAL_INT(100, receivedCount);
+
+    struct sCS104_AckStatistics statistics;
+
+    CS104_Connection_getAckStatistics(con, &statistics);
+
+    /* the client doesn't send I messages - all acknowledgements are S messages and not later than after w */
+    TEST_ASSERT_TRUE(statistics.sentAcks >= (100 / 8));
+    TEST_ASSERT_EQUAL_UINT32(0, statistics.savedAcks);
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+}
+
+void
+test_CS104_AckScheduler_holdAtW(void)
+{
+    struct sCS104_APCIParameters parameters = {12, 8, 10, 15, 10, 20};
+    struct sCS104_AckScheduler scheduler;
+
+    memset(&scheduler, 0, sizeof(scheduler));
+
+    CS104_AckScheduler_reset(&scheduler, &parameters, true);
+
+    /* round trip time 40 ms -> an acknowledgement can be deferred by 20 ms */
+    CS104_AckScheduler_updateRoundTripTime(&scheduler, 0, 40);
+
+    /* own I messages are sent every 10 ms */
+    CS104_AckScheduler_iMessageSent(&scheduler, 0, 1000);
+    CS104_AckScheduler_iMessageSent(&scheduler, 0, 1010);
+    CS104_AckScheduler_iMessageSent(&scheduler, 0, 1020);
+
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.savedAcks);
+
+    /* w reached - the next I message is expected before the deadline */
+    TEST_ASSERT_FALSE(CS104_AckScheduler_isAckRequired(&scheduler, 8, false, 1025));
+    TEST_ASSERT_EQUAL_INT(20, CS104_AckScheduler_getWaitTime(&scheduler, 1025, 1000));
+
+    /* the I message didn't arrive - S message at the deadline */
+    TEST_ASSERT_TRUE(CS104_AckScheduler_isAckRequired(&scheduler, 9, false, 1045));
+    CS104_AckScheduler_ackSent(&scheduler);
+
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.sentAcks);
+
+    CS104_AckScheduler_iMessageSent(&scheduler, 0, 1050);
+
+    /* the counterpart reached k - S message even when an I message is expected */
+    TEST_ASSERT_TRUE(CS104_AckScheduler_isAckRequired(&scheduler, 12, false, 1052));
+    CS104_AckScheduler_ackSent(&scheduler);
+
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler.sentAcks);
+
+    /* the I message carries the acknowledgement */
+    TEST_ASSERT_FALSE(CS104_AckScheduler_isAckRequired(&scheduler, 8, false, 1055));
+
+    CS104_AckScheduler_iMessageSent(&scheduler, 8, 1060);
+
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.savedAcks);
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler.sentAcks);
+
+    /* the I messages stopped - S message at w */
+    TEST_ASSERT_TRUE(CS104_AckScheduler_isAckRequired(&scheduler, 8, false, 5000));
+    CS104_AckScheduler_ackSent(&scheduler);
+
+    TEST_ASSERT_EQUAL_UINT32(3, scheduler.sentAcks);
+
+    /* no S message was pending -> the I message doesn't save an acknowledgement */
+    TEST_ASSERT_FALSE(CS104_AckScheduler_isAckRequired(&scheduler, 3, false, 5050));
+    CS104_AckScheduler_iMessageSent(&scheduler, 3, 5050);
+
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.savedAcks);
+
+    /* classic policy: S message at w */
+    CS104_AckScheduler_reset(&scheduler, &parameters, false);
+
+    TEST_ASSERT_FALSE(CS104_AckScheduler_isAckRequired(&scheduler, 7, false, 6000));
+    TEST_ASSERT_TRUE(CS104_AckScheduler_isAckRequired(&scheduler, 8, false, 6000));
+}
+
+struct stest_CS101_PointCache {
+    int changeCount;
+    double lastValue;
+};
+
+static void
+test_CS101_PointCache_pointChangedHandler(void* parameter, CS101_PointValue point)
+{
+    struct stest_CS101_PointCache* info = (struct stest_CS101_PointCache*) parameter;
+
+    info->changeCount++;
+    info->lastValue = point->value;
+}
+
+static void
+test_CS101_PointCache_updateScaled(CS101_PointCache cache, int ca, int ioa, int value, QualityDescriptor quality)
+{
+    CS101_ASDU asdu = CS101_ASDU_create(&defaultAppLayerParameters, false, CS101_COT_SPONTANEOUS, 0, ca, false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, ioa, value, quality);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    CS101_PointCache_update(cache, asdu);
+
+    CS101_ASDU_destroy(asdu);
+}
+
+void
+test_CS101_PointCache(void)
+{
+    struct stest_CS101_PointCache info;
+    info.changeCount = 0;
+    info.lastValue = 0;
+
+    CS101_PointCache cache = CS101_PointCache_create(4);
+
+    CS101_PointCache_setPointChangedHandler(cache, test_CS101_PointCache_pointChangedHandler, &info);
+    CS101_PointCache_setDeadband(cache, CS101_POINT_TYPE_SCALED, 10);
+
+    /* more points than the initial capacity - the table has to grow */
+    for (int ioa = 1; ioa <= 1000; ioa++)
+        test_CS101_PointCache_updateScaled(cache, 1, ioa, ioa, IEC60870_QUALITY_GOOD);
+
+    TEST_ASSERT_EQUAL_INT(1000, info.changeCount);
+    TEST_ASSERT_EQUAL_INT(1000, CS101_PointCache_getNumberOfPoints(cache));
+
+    /* within the deadband - value is stored but no change is reported */
+    test_CS101_PointCache_updateScaled(cache, 1, 100, 105, IEC60870_QUALITY_GOOD);
+    TEST_ASSERT_EQUAL_INT(1000, info.changeCount);
+
+    struct sCS101_PointValue point;
+
+    TEST_ASSERT_TRUE(CS101_PointCache_getPoint(cache, 1, CS101_POINT_TYPE_SCALED, 100, &point));
+    TEST_ASSERT_EQUAL_INT(105, (int) point.value);
+    TEST_ASSERT_EQUAL_INT(2, point.updateCount);
+    TEST_ASSERT_EQUAL_INT(M_ME_NB_1, point.typeId);
+    TEST_ASSERT_FALSE(point.hasTimestamp);
+
+    /* the deadband refers to the last reported value */
+    test_CS101_PointCache_updateScaled(cache, 1, 100, 111, IEC60870_QUALITY_GOOD);
+    TEST_ASSERT_EQUAL_INT(1001, info.changeCount);
+    TEST_ASSERT_EQUAL_INT(111, (int) info.lastValue);
+
+    /* quality changes are always reported */
+    test_CS101_PointCache_updateScaled(cache, 1, 100, 111, IEC60870_QUALITY_INVALID);
+    TEST_ASSERT_EQUAL_INT(1002, info.changeCount);
+
+    /* point deadband overrides the type deadband */
+    TEST_ASSERT_TRUE(CS101_PointCache_setPointDeadband(cache, 1, CS101_POINT_TYPE_SCALED, 200, 0));
+    test_CS101_PointCache_updateScaled(cache, 1, 200, 201, IEC60870_QUALITY_GOOD);
+    TEST_ASSERT_EQUAL_INT(1003, info.changeCount);
+
+    /* same IOA with other CA or other point type is another point */
+    test_CS101_PointCache_updateScaled(cache, 2, 100, 1, IEC60870_QUALITY_GOOD);
+    TEST_ASSERT_EQUAL_INT(1004, info.changeCount);
+    TEST_ASSERT_FALSE(CS101_PointCache_getPoint(cache, 1, CS101_POINT_TYPE_SHORT_FLOAT, 100, &point));
+
+    TEST_ASSERT_EQUAL_INT(1001, CS101_PointCache_getNumberOfPoints(cache));
+
+    CS101_PointValue snapshot = (CS101_PointValue) calloc(1001, sizeof(struct sCS101_PointValue));
+
+    TEST_ASSERT_EQUAL_INT(1001, CS101_PointCache_getSnapshot(cache, snapshot, 1001));
+    TEST_ASSERT_EQUAL_INT(10, CS101_PointCache_getSnapshot(cache, snapshot, 10));
+
+    free(snapshot);
+
+    CS101_PointCache_clear(cache);
+
+    TEST_ASSERT_EQUAL_INT(0, CS101_PointCache_getNumberOfPoints(cache));
+    TEST_ASSERT_FALSE(CS101_PointCache_getPoint(cache, 1, CS101_POINT_TYPE_SCALED, 100, &point));
+
+    CS101_PointCache_destroy(cache);
+}
+
+static bool
+test_CS104_Connection_pointCache_interrogationHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, uint8_t qoi)
+{
+    CS101_AppLayerParameters alParams = IMasterConnection_getApplicationLayerParameters(connection);
+
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+
+    CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_INTERROGATED_BY_STATION, 0, 1, false, false);
+
+    for (int i = 0; i < 10; i++) {
+        InformationObject io = (InformationObject) SinglePointInformation_create(NULL, 100 + i, (i % 2) == 0, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(newAsdu, io);
+
+        InformationObject_destroy(io);
+    }
+
+    IMasterConnection_sendASDU(connection, newAsdu);
+
+    CS101_ASDU_destroy(newAsdu);
+
+    IMasterConnection_sendACT_TERM(connection, asdu);
+
+    return true;
+}
+
+void
+test_CS104_Connection_pointCache(void)
+{
+    struct stest_CS101_PointCache info;
+    info.changeCount = 0;
+    info.lastValue = 0;
+
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setInterrogationHandler(slave, test_CS104_Connection_pointCache_interrogationHandler, NULL);
+    CS104_Slave_start(slave);
+
+    CS101_PointCache cache = CS101_PointCache_create(100);
+    CS101_PointCache_setPointChangedHandler(cache, test_CS101_PointCache_pointChangedHandler, &info);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+    CS104_Connection_setPointCache(con, cache);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    Thread_sleep(100);
+
+    CS104_Connection_sendInterrogationCommand(con, CS101_COT_ACTIVATION, 1, IEC60870_QOI_STATION);
+
+    Thread_sleep(200);
+
+    TEST_ASSERT_EQUAL_INT(10, info.changeCount);
+
+    /* unchanged values of the second interrogation are not reported */
+    CS104_Connection_sendInterrogationCommand(con, CS101_COT_ACTIVATION, 1, IEC60870_QOI_STATION);
+
+    Thread_sleep(200);
+
+    TEST_ASSERT_EQUAL_INT(10, info.changeCount);
+
+    struct sCS101_PointValue point;
+
+    TEST_ASSERT_TRUE(CS101_PointCache_getPoint(cache, 1, CS101_POINT_TYPE_SINGLE_POINT, 102, &point));
+    TEST_ASSERT_EQUAL_INT(1, (int) point.value);
+    TEST_ASSERT_EQUAL_INT(2, point.updateCount);
+    TEST_ASSERT_EQUAL_INT(CS101_COT_INTERROGATED_BY_STATION, point.cot);
+    TEST_ASSERT_TRUE(point.lastUpdateTime > 0);
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    CS101_PointCache_destroy(cache);
+}
+
+#ifndef _WIN32
+struct stest_SerialTransceiverFT12 {
+    int messageCount;
+    int messageSizes[10];
+    uint8_t messages[10][300];
+};
+
+static void
+test_SerialTransceiverFT12_messageHandler(void* parameter, uint8_t* msg, int msgSize)
+{
+    struct stest_SerialTransceiverFT12* info = (struct stest_SerialTransceiverFT12*) parameter;
+
+    if (info->messageCount < 10) {
+        info->messageSizes[info->messageCount] = msgSize;
+        memcpy(info->messages[info->messageCount], msg, msgSize);
+    }
+
+    info->messageCount++;
+}
+#endif
+
+void
+test_SerialTransceiverFT12_bulkRead(void)
+{
+#ifndef _WIN32
+    struct stest_SerialTransceiverFT12 info;
+    info.messageCount = 0;
+
+    int ptyMaster = posix_openpt(O_RDWR | O_NOCTTY);
+
+    TEST_ASSERT_TRUE(ptyMaster != -1);
+    TEST_ASSERT_EQUAL_INT(0, grantpt(ptyMaster));
+    TEST_ASSERT_EQUAL_INT(0, unlockpt(ptyMaster));
+
+    SerialPort port = SerialPort_create(ptsname(ptyMaster), 9600, 8, 'E', 1);
+
+    TEST_ASSERT_TRUE(SerialPort_open(port));
+
+    struct sLinkLayerParameters llParameters;
+    llParameters.addressLength = 1;
+    llParameters.timeoutForAck = 200;
+    llParameters.timeoutRepeat = 1000;
+    llParameters.useSingleCharACK = true;
+    llParameters.timeoutLinkState = 5000;
+
+    SerialTransceiverFT12 transceiver = SerialTransceiverFT12_create(port, &llParameters);
+    SerialTransceiverFT12_setTimeouts(transceiver, 10, 100);
+
+    uint8_t buffer[300];
+
+    /* fixed frame, single char ACK and variable frame received with a single write */
+    uint8_t frames[] = { 0x10, 0x49, 0x01, 0x4a, 0x16,
+                         0xe5,
+                         0x68, 0x09, 0x09, 0x68, 0x08, 0x01, 0x64, 0x01, 0x06, 0x01, 0x00, 0x00, 0x14, 0x89, 0x16 };
+
+    TEST_ASSERT_EQUAL_INT(sizeof(frames), write(ptyMaster, frames, sizeof(frames)));
+
+    Thread_sleep(50);
+
+    for (int i = 0; i < 4; i++)
+        SerialTransceiverFT12_readNextMessage(transceiver, buffer, test_SerialTransceiverFT12_messageHandler, &info);
+
+    TEST_ASSERT_EQUAL_INT(3, info.messageCount);
+    TEST_ASSERT_EQUAL_INT(5, info.messageSizes[0]);
+    TEST_ASSERT_EQUAL_MEMORY(frames, info.messages[0], 5);
+    TEST_ASSERT_EQUAL_INT(1, info.messageSizes[1]);
+    TEST_ASSERT_EQUAL_INT(0xe5, info.messages[1][0]);
+    TEST_ASSERT_EQUAL_INT(15, info.messageSizes[2]);
+    TEST_ASSERT_EQUAL_MEMORY(frames + 6, info.messages[2], 15);
+
+    /* frame is completed within the character timeout */
+    TEST_ASSERT_EQUAL_INT(3, write(ptyMaster, frames, 3));
+
+    Thread_sleep(20);
+
+    TEST_ASSERT_EQUAL_INT(2, write(ptyMaster, frames + 3, 2));
+
+    SerialTransceiverFT12_readNextMessage(transceiver, buffer, test_SerialTransceiverFT12_messageHandler, &info);
+
+    TEST_ASSERT_EQUAL_INT(4, info.messageCount);
+
+    /* incomplete frame is dropped after the character timeout */
+    TEST_ASSERT_EQUAL_INT(3, write(ptyMaster, frames, 3));
+
+    SerialTransceiverFT12_readNextMessage(transceiver, buffer, test_SerialTransceiverFT12_messageHandler, &info);
+
+    TEST_ASSERT_EQUAL_INT(4, info.messageCount);
+
+    SerialTransceiverFT12_destroy(transceiver);
+
+    SerialPort_close(port);
+    SerialPort_destroy(port);
+
+    close(ptyMaster);
+#endif
+}
+
+
+void
+test_SerialPort_asyncTransmit(void)
+{
+#ifndef _WIN32
+    int ptyMaster = posix_openpt(O_RDWR | O_NOCTTY);
+
+    TEST_ASSERT_TRUE(ptyMaster != -1);
+    TEST_ASSERT_EQUAL_INT(0, grantpt(ptyMaster));
+    TEST_ASSERT_EQUAL_INT(0, unlockpt(ptyMaster));
+
+    SerialPort port = SerialPort_create(ptsname(ptyMaster), 9600, 8, 'E', 1);
+
+    TEST_ASSERT_TRUE(SerialPort_open(port));
+
+    SerialPort_setAsyncTransmit(port, true);
+
+    uint8_t frame[] = { 0x10, 0x49, 0x01, 0x4a, 0x16 };
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    TEST_ASSERT_EQUAL_INT(5, SerialPort_write(port, frame, 0, 5));
+
+    /* 5 characters with 11 bit at 9600 baud -> 5.7 ms */
+    uint64_t transmitCompleteTime = SerialPort_getTransmitCompleteTime(port);
+
+    TEST_ASSERT_TRUE(transmitCompleteTime >= startTime + 5);
+    TEST_ASSERT_TRUE(transmitCompleteTime <= Hal_getMonotonicTimeInMs() + 7);
+
+    /* second frame is delayed until the line idle time (33 bit) after the first frame */
+    TEST_ASSERT_EQUAL_INT(5, SerialPort_write(port, frame, 0, 5));
+
+    TEST_ASSERT_TRUE(Hal_getMonotonicTimeInMs() >= transmitCompleteTime + 2);
+    TEST_ASSERT_TRUE(SerialPort_getTransmitCompleteTime(port) >= transmitCompleteTime + 8);
+
+    uint8_t buffer[20];
+    int receivedBytes = 0;
+
+    while (receivedBytes < 10) {
+        int result = read(ptyMaster, buffer + receivedBytes, sizeof(buffer) - receivedBytes);
+
+        if (result <= 0)
+            break;
+
+        receivedBytes += result;
+    }
+
+    TEST_ASSERT_EQUAL_INT(10, receivedBytes);
+    TEST_ASSERT_EQUAL_MEMORY(frame, buffer + 5, 5);
+
+    SerialPort_close(port);
+    SerialPort_destroy(port);
+
+    close(ptyMaster);
+#endif
+}
+
+
+#ifndef _WIN32
+#define TEST_PORT_SCHEDULER_LINES 4
+
+static bool
+test_CS101_PortScheduler_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    int* asduCount = (int*) parameter;
+
+    (*asduCount)++;
+
+    return true;
+}
+
+static void
+test_CS101_PortScheduler_tickHandler(void* parameter, CS101_Master master, CS101_Slave slave)
+{
+    if (master)
+        CS101_Master_pollSingleSlave(master, 1);
+}
+
+static int
+test_CS101_PortScheduler_openPty(SerialPort* port)
+{
+    int ptyMaster = posix_openpt(O_RDWR | O_NOCTTY);
+
+    TEST_ASSERT_TRUE(ptyMaster != -1);
+    TEST_ASSERT_EQUAL_INT(0, grantpt(ptyMaster));
+    TEST_ASSERT_EQUAL_INT(0, unlockpt(ptyMaster));
+
+    fcntl(ptyMaster, F_SETFL, fcntl(ptyMaster, F_GETFL) | O_NONBLOCK);
+
+    *port = SerialPort_create(ptsname(ptyMaster), 9600, 8, 'E', 1);
+
+    TEST_ASSERT_TRUE(SerialPort_open(*port));
+
+    return ptyMaster;
+}
+
+/* connect two pseudo terminals like a null modem cable */
+static void
+test_CS101_PortScheduler_forward(int fromFd, int toFd)
+{
+    uint8_t buffer[256];
+
+    int readBytes = read(fromFd, buffer, sizeof(buffer));
+
+    if (readBytes > 0)
+        TEST_ASSERT_EQUAL_INT(readBytes, write(toFd, buffer, readBytes));
+}
+#endif
+
+void
+test_CS101_PortScheduler(void)
+{
+#ifndef _WIN32
+    int ptys[TEST_PORT_SCHEDULER_LINES][2];
+    SerialPort ports[TEST_PORT_SCHEDULER_LINES][2];
+    CS101_Master masters[TEST_PORT_SCHEDULER_LINES];
+    CS101_Slave slaves[TEST_PORT_SCHEDULER_LINES];
+    int asduCount[TEST_PORT_SCHEDULER_LINES];
+
+    CS101_PortScheduler scheduler = CS101_PortScheduler_create();
+
+    TEST_ASSERT_NOT_NULL(scheduler);
+
+    CS101_PortScheduler_setTickHandler(scheduler, test_CS101_PortScheduler_tickHandler, NULL);
+
+    for (int i = 0; i < TEST_PORT_SCHEDULER_LINES; i++) {
+        ptys[i][0] = test_CS101_PortScheduler_openPty(&(ports[i][0]));
+        ptys[i][1] = test_CS101_PortScheduler_openPty(&(ports[i][1]));
+
+        asduCount[i] = 0;
+
+        masters[i] = CS101_Master_create(ports[i][0], NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+        CS101_Master_addSlave(masters[i], 1);
+        CS101_Master_setASDUReceivedHandler(masters[i], test_CS101_PortScheduler_asduReceivedHandler, &(asduCount[i]));
+
+        slaves[i] = CS101_Slave_create(ports[i][1], NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+        CS101_Slave_setLinkLayerAddress(slaves[i], 1);
+
+        CS101_ASDU asdu = CS101_ASDU_create(CS101_Slave_getAppLayerParameters(slaves[i]), false, CS101_COT_PERIODIC, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 100 + i, i, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(asdu, io);
+
+        InformationObject_destroy(io);
+
+        CS101_Slave_enqueueUserDataClass2(slaves[i], asdu);
+
+        CS101_ASDU_destroy(asdu);
+
+        TEST_ASSERT_TRUE(CS101_PortScheduler_addMaster(scheduler, masters[i]));
+        TEST_ASSERT_TRUE(CS101_PortScheduler_addSlave(scheduler, slaves[i]));
+    }
+
+    TEST_ASSERT_EQUAL_INT(2 * TEST_PORT_SCHEDULER_LINES, CS101_PortScheduler_getNumberOfPorts(scheduler));
+
+    /* all lines are handled by the calling thread */
+    uint64_t timeout = Hal_getMonotonicTimeInMs() + 3000;
+
+    bool allReceived = false;
+
+    while ((allReceived == false) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        CS101_PortScheduler_run(scheduler, 2);
+
+        allReceived = true;
+
+        for (int i = 0; i < TEST_PORT_SCHEDULER_LINES; i++) {
+            test_CS101_PortScheduler_forward(ptys[i][0], ptys[i][1]);
+            test_CS101_PortScheduler_forward(ptys[i][1], ptys[i][0]);
+
+            if (asduCount[i] == 0)
+                allReceived = false;
+        }
+    }
+
+    for (int i = 0; i < TEST_PORT_SCHEDULER_LINES; i++)
+        TEST_ASSERT_EQUAL_INT(1, asduCount[i]);
+
+    CS101_PortScheduler_removeMaster(scheduler, masters[0]);
+    CS101_PortScheduler_removeSlave(scheduler, slaves[0]);
+
+    TEST_ASSERT_EQUAL_INT(2 * TEST_PORT_SCHEDULER_LINES - 2, CS101_PortScheduler_getNumberOfPorts(scheduler));
+
+    CS101_PortScheduler_destroy(scheduler);
+
+    for (int i = 0; i < TEST_PORT_SCHEDULER_LINES; i++) {
+        CS101_Master_destroy(masters[i]);
+        CS101_Slave_destroy(slaves[i]);
+
+        for (int j = 0; j < 2; j++) {
+            SerialPort_close(ports[i][j]);
+            SerialPort_destroy(ports[i][j]);
+            close(ptys[i][j]);
+        }
+    }
+#endif
+}
+
+
+static uint64_t test_TimerWheel_currentTime;
+
+struct stest_TimerWheel {
+    struct sTimerWheelEntry entry;
+    TimerWheel wheel;
+    uint64_t expiryTime;
+    uint64_t firedAt;
+    int fired;
+    int period; /* > 0: the handler schedules the timer again */
+    bool canceled;
+};
+
+static void
+test_TimerWheel_handler(void* parameter)
+{
+    struct stest_TimerWheel* timer = (struct stest_TimerWheel*) parameter;
+
+    timer->fired++;
+    timer->firedAt = test_TimerWheel_currentTime;
+
+    if (timer->period > 0) {
+        timer->expiryTime = test_TimerWheel_currentTime + timer->period;
+        TimerWheel_schedule(timer->wheel, &(timer->entry), timer->expiryTime);
+    }
+}
+
+static void
+test_TimerWheel_init(struct stest_TimerWheel* timer, TimerWheel wheel, uint64_t expiryTime, int period)
+{
+    TimerWheelEntry_initialize(&(timer->entry), test_TimerWheel_handler, timer);
+
+    timer->wheel = wheel;
+    timer->expiryTime = expiryTime;
+    timer->firedAt = 0;
+    timer->fired = 0;
+    timer->period = period;
+    timer->canceled = false;
+
+    TimerWheel_schedule(wheel, &(timer->entry), expiryTime);
+}
+
+void
+test_TimerWheel_Levels(void)
+{
+    /* small wheel (16 slots per level) to use all levels and timers beyond the range of the wheel */
+    int offsets[] = {5, 16, 17, 100, 256, 257, 300, 3000, 4096, 20000, 65536, 70000, 200000, 50000};
+    int numberOfTimers = sizeof(offsets) / sizeof(int);
+
+    struct stest_TimerWheel timers[15];
+
+    uint64_t startTime = 1000;
+    uint64_t endTime = startTime + 200001;
+
+    TimerWheel wheel = TimerWheel_create(16, 1, startTime);
+    TEST_ASSERT_NOT_NULL(wheel);
+
+    int i;
+
+    for (i = 0; i < numberOfTimers; i++)
+        test_TimerWheel_init(&(timers[i]), wheel, startTime + offsets[i], 0);
+
+    /* periodic timer */
+    test_TimerWheel_init(&(timers[numberOfTimers]), wheel, startTime + 7, 7);
+
+    TEST_ASSERT_EQUAL_INT(5, TimerWheel_getNextTimeout(wheel, startTime, 1000000));
+
+    uint64_t t;
+
+    for (t = startTime + 1; t <= endTime; t++) {
+        test_TimerWheel_currentTime = t;
+
+        if (t == startTime + 10000) {
+            TimerWheel_cancel(wheel, &(timers[numberOfTimers - 1].entry));
+            timers[numberOfTimers - 1].canceled = true;
+        }
+
+        TimerWheel_advance(wheel, t);
+
+        /* the next timeout is the exact time until the next timer expires */
+        uint64_t nextExpiry = UINT64_MAX;
+
+        for (i = 0; i <= numberOfTimers; i++) {
+            if ((timers[i].canceled == false) && ((timers[i].fired == 0) || (timers[i].period > 0))) {
+                if (timers[i].expiryTime < nextExpiry)
+                    nextExpiry = timers[i].expiryTime;
+            }
+        }
+
+        int timeout = TimerWheel_getNextTimeout(wheel, t, 1000000);
+
+        if (nextExpiry == UINT64_MAX)
+            TEST_ASSERT_EQUAL_INT(1000000, timeout);
+        else if ((uint64_t) timeout != nextExpiry - t)
+            TEST_FAIL_MESSAGE("wrong next timeout");
+    }
+
+    for (i = 0; i < numberOfTimers - 1; i++) {
+        TEST_ASSERT_EQUAL_INT(1, timers[i].fired);
+
+        if (timers[i].firedAt != timers[i].expiryTime)
+            TEST_FAIL_MESSAGE("timer expired at the wrong time");
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, timers[numberOfTimers - 1].fired);
+    TEST_ASSERT_EQUAL_INT(200001 / 7, timers[numberOfTimers].fired);
+
+    TimerWheel_destroy(wheel);
+
+    for (i = 0; i <= numberOfTimers; i++)
+        TEST_ASSERT_FALSE(timers[i].entry.isScheduled);
+}
+
+void
+test_TimerWheel_LargeTimeSteps(void)
+{
+    struct stest_TimerWheel timers[3];
+
+    TimerWheel wheel = TimerWheel_create(16, 1, 0);
+
+    test_TimerWheel_init(&(timers[0]), wheel, 100, 0);
+    test_TimerWheel_init(&(timers[1]), wheel, 5000, 0);
+    test_TimerWheel_init(&(timers[2]), wheel, 1000000, 0);
+
+    /* step over the first slots of the wheel */
+    test_TimerWheel_currentTime = 99;
+    TEST_ASSERT_EQUAL_INT(0, TimerWheel_advance(wheel, 99));
+    TEST_ASSERT_EQUAL_INT(1, TimerWheel_getNextTimeout(wheel, 99, 1000));
+
+    test_TimerWheel_currentTime = 150;
+    TEST_ASSERT_EQUAL_INT(1, TimerWheel_advance(wheel, 150));
+    TEST_ASSERT_EQUAL_INT(1, timers[0].fired);
+
+    /* step over the range of the first two levels */
+    test_TimerWheel_currentTime = 10000;
+    TEST_ASSERT_EQUAL_INT(1, TimerWheel_advance(wheel, 10000));
+    TEST_ASSERT_EQUAL_INT(1, timers[1].fired);
+    TEST_ASSERT_EQUAL_INT(0, timers[2].fired);
+
+    TEST_ASSERT_EQUAL_INT(990000, TimerWheel_getNextTimeout(wheel, 10000, 2000000));
+    TEST_ASSERT_EQUAL_INT(1000, TimerWheel_getNextTimeout(wheel, 10000, 1000));
+
+    /* time jump beyond the timer */
+    test_TimerWheel_currentTime = 5000000;
+    TEST_ASSERT_EQUAL_INT(1, TimerWheel_advance(wheel, 5000000));
+    TEST_ASSERT_EQUAL_INT(1, timers[2].fired);
+
+    TEST_ASSERT_EQUAL_INT(1000, TimerWheel_getNextTimeout(wheel, 5000000, 1000));
+
+    TimerWheel_destroy(wheel);
+
+    /* resolution 10 ms - timers never expire early */
+    wheel = TimerWheel_create(16, 10, 0);
+
+    test_TimerWheel_init(&(timers[0]), wheel, 25, 0);
+
+    TEST_ASSERT_EQUAL_INT(10, TimerWheel_getNextTimeout(wheel, 20, 100));
+    TEST_ASSERT_EQUAL_INT(0, TimerWheel_advance(wheel, 29));
+    TEST_ASSERT_EQUAL_INT(1, TimerWheel_advance(wheel, 30));
+
+    TimerWheel_destroy(wheel);
+}
+
+
+void
+test_CS101_Master_manySlaves(void)
+{
+    SerialPort port = SerialPort_create("/dev/null", 9600, 8, 'E', 1);
+
+    CS101_Master master = CS101_Master_create(port, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    CS101_Master_getLinkLayerParameters(master)->addressLength = 2;
+
+    /* add slaves with sparse addresses and some duplicates */
+    for (int i = 0; i < 1000; i++)
+        CS101_Master_addSlave(master, (i * 37) % 65000);
+
+    for (int i = 0; i < 1000; i++)
+        CS101_Master_addSlave(master, (i * 37) % 65000);
+
+    for (int i = 0; i < 1000; i++)
+        TEST_ASSERT_TRUE(CS101_Master_isChannelReady(master, (i * 37) % 65000));
+
+    TEST_ASSERT_FALSE(CS101_Master_isChannelReady(master, 1));
+    TEST_ASSERT_FALSE(CS101_Master_isChannelReady(master, 65001));
+
+    CS101_Master_destroy(master);
+    SerialPort_destroy(port);
+}
+
+
+#ifndef _WIN32
+struct stest_PollModePriority {
+    int class1Count;
+    int class2Count;
+};
+
+static bool
+test_CS101_Master_pollModePriority_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    struct stest_PollModePriority* info = (struct stest_PollModePriority*) parameter;
+
+    if (CS101_ASDU_getCOT(asdu) == CS101_COT_SPONTANEOUS)
+        info->class1Count++;
+    else if (CS101_ASDU_getCOT(asdu) == CS101_COT_PERIODIC)
+        info->class2Count++;
+
+    return true;
+}
+#endif
+
+void
+test_CS101_Master_pollModePriority(void)
+{
+#ifndef _WIN32
+    int ptys[2];
+    SerialPort ports[2];
+
+    struct stest_PollModePriority info;
+
+    info.class1Count = 0;
+    info.class2Count = 0;
+
+    ptys[0] = test_CS101_PortScheduler_openPty(&(ports[0]));
+    ptys[1] = test_CS101_PortScheduler_openPty(&(ports[1]));
+
+    CS101_Master master = CS101_Master_create(ports[0], NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    CS101_Master_setASDUReceivedHandler(master, test_CS101_Master_pollModePriority_asduReceivedHandler, &info);
+    CS101_Master_setPollMode(master, CS101_POLL_MODE_PRIORITY);
+    CS101_Master_setTimeoutBackoff(master, 500, 2000);
+
+    /* slave 2 does not exist and has to be suspended by the back-off */
+    CS101_Master_addSlave(master, 1);
+    CS101_Master_addSlave(master, 2);
+
+    TEST_ASSERT_TRUE(CS101_Master_setSlavePollParameters(master, 1, 2, 100));
+    TEST_ASSERT_TRUE(CS101_Master_setSlavePollParameters(master, 2, 1, 100));
+    TEST_ASSERT_FALSE(CS101_Master_setSlavePollParameters(master, 3, 1, 100));
+
+    CS101_Slave slave = CS101_Slave_create(ports[1], NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+    CS101_Slave_setLinkLayerAddress(slave, 1);
+
+    for (int i = 0; i < 3; i++) {
+        CS101_ASDU asdu = CS101_ASDU_create(CS101_Slave_getAppLayerParameters(slave), false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 100 + i, i, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(asdu, io);
+
+        InformationObject_destroy(io);
+
+        CS101_Slave_enqueueUserDataClass1(slave, asdu);
+
+        CS101_ASDU_setCOT(asdu, CS101_COT_PERIODIC);
+
+        CS101_Slave_enqueueUserDataClass2(slave, asdu);
+
+        CS101_ASDU_destroy(asdu);
+    }
+
+    /* no explicit polling - class 2 data is requested by the poll interval and class 1 data by ACD */
+    uint64_t timeout = Hal_getMonotonicTimeInMs() + 5000;
+
+    while (((info.class1Count < 3) || (info.class2Count < 3)) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        CS101_Master_run(master);
+
+        test_CS101_PortScheduler_forward(ptys[0], ptys[1]);
+
+        CS101_Slave_run(slave);
+
+        test_CS101_PortScheduler_forward(ptys[1], ptys[0]);
+    }
+
+    TEST_ASSERT_EQUAL_INT(3, info.class1Count);
+    TEST_ASSERT_EQUAL_INT(3, info.class2Count);
+
+    CS101_Master_destroy(master);
+    CS101_Slave_destroy(slave);
+
+    for (int j = 0; j < 2; j++) {
+        SerialPort_close(ports[j]);
+        SerialPort_destroy(ports[j]);
+        close(ptys[j]);
+    }
+#endif
+}
+
+
+#ifndef _WIN32
+/* write a message to one port and read it from the other port */
+static int
+test_SerialPort_transfer(SerialPort from, SerialPort to, uint8_t* message, int messageSize, uint8_t* buffer)
+{
+    TEST_ASSERT_EQUAL_INT(messageSize, SerialPort_write(from, message, 0, messageSize));
+
+    int readBytes = 0;
+
+    uint64_t timeout = Hal_getMonotonicTimeInMs() + 1000;
+
+    while ((readBytes < messageSize) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        int result = SerialPort_read(to, buffer + readBytes, messageSize - readBytes, 10);
+
+        TEST_ASSERT_TRUE(result >= 0);
+
+        readBytes += result;
+    }
+
+    return readBytes;
+}
+#endif
+
+void
+test_SerialPort_virtualPorts(void)
+{
+#ifndef _WIN32
+    uint8_t message[200];
+    uint8_t buffer[200];
+
+    for (int i = 0; i < 200; i++)
+        message[i] = (uint8_t) i;
+
+    SerialPort port1;
+    SerialPort port2;
+
+    /* pseudo terminal pair */
+    TEST_ASSERT_TRUE(SerialPort_createPtyPair(9600, 8, 'E', 1, &port1, &port2));
+    TEST_ASSERT_TRUE(SerialPort_open(port1));
+
+    TEST_ASSERT_EQUAL_INT(200, test_SerialPort_transfer(port1, port2, message, 200, buffer));
+    TEST_ASSERT_EQUAL_MEMORY(message, buffer, 200);
+
+    TEST_ASSERT_EQUAL_INT(200, test_SerialPort_transfer(port2, port1, message, 200, buffer));
+    TEST_ASSERT_EQUAL_MEMORY(message, buffer, 200);
+
+    SerialPort_close(port1);
+    SerialPort_close(port2);
+    SerialPort_destroy(port1);
+    SerialPort_destroy(port2);
+
+    /* in-memory pipe with baud rate emulation */
+    TEST_ASSERT_TRUE(SerialPort_createPipePair(9600, 8, 'E', 1, &port1, &port2));
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    TEST_ASSERT_EQUAL_INT(100, test_SerialPort_transfer(port1, port2, message, 100, buffer));
+    TEST_ASSERT_EQUAL_MEMORY(message, buffer, 100);
+
+    TEST_ASSERT_TRUE(Hal_getMonotonicTimeInMs() - startTime < 50);
+
+    SerialPort_setBaudRateEmulation(port1, true);
+
+    startTime = Hal_getMonotonicTimeInMs();
+
+    /* 100 characters with 11 bit at 9600 baud take 115 ms */
+    TEST_ASSERT_EQUAL_INT(100, test_SerialPort_transfer(port1, port2, message, 100, buffer));
+    TEST_ASSERT_EQUAL_MEMORY(message, buffer, 100);
+
+    TEST_ASSERT_TRUE(Hal_getMonotonicTimeInMs() - startTime >= 114);
+
+    SerialPort_setBaudRateEmulation(port1, false);
+
+    /* bit error injection */
+    SerialPort_setBitErrorRate(port2, 100000, 1234);
+
+    TEST_ASSERT_EQUAL_INT(200, test_SerialPort_transfer(port2, port1, message, 200, buffer));
+
+    int differentBytes = 0;
+
+    for (int i = 0; i < 200; i++) {
+        if (buffer[i] != message[i])
+            differentBytes++;
+    }
+
+    /* ~160 bit errors expected */
+    TEST_ASSERT_TRUE(differentBytes > 50);
+    TEST_ASSERT_TRUE(differentBytes < 200);
+
+    SerialPort_setBitErrorRate(port2, 0, 0);
+
+    TEST_ASSERT_EQUAL_INT(200, test_SerialPort_transfer(port2, port1, message, 200, buffer));
+    TEST_ASSERT_EQUAL_MEMORY(message, buffer, 200);
+
+    SerialPort_close(port1);
+    SerialPort_close(port2);
+    SerialPort_destroy(port1);
+    SerialPort_destroy(port2);
+
+    /* serial-over-TCP */
+    ServerSocket serverSocket = TcpServerSocket_create("127.0.0.1", 20404);
+    TEST_ASSERT_NOT_NULL(serverSocket);
+
+    ServerSocket_listen(serverSocket);
+
+    SerialPort tcpPort = SerialPort_create("tcp://127.0.0.1:20404", 9600, 8, 'E', 1);
+
+    TEST_ASSERT_TRUE(SerialPort_open(tcpPort));
+
+    Socket socket = NULL;
+
+    uint64_t timeout = Hal_getMonotonicTimeInMs() + 1000;
+
+    while ((socket == NULL) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        socket = ServerSocket_accept(serverSocket);
+
+        if (socket == NULL)
+            Thread_sleep(1);
+    }
+
+    TEST_ASSERT_NOT_NULL(socket);
+
+    TEST_ASSERT_EQUAL_INT(50, SerialPort_write(tcpPort, message, 0, 50));
+
+    int readBytes = 0;
+
+    while ((readBytes < 50) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        int result = Socket_read(socket, buffer + readBytes, 50 - readBytes);
+
+        TEST_ASSERT_TRUE(result >= 0);
+
+        readBytes += result;
+    }
+
+    TEST_ASSERT_EQUAL_INT(50, readBytes);
+    TEST_ASSERT_EQUAL_MEMORY(message, buffer, 50);
+
+    TEST_ASSERT_EQUAL_INT(50, Socket_write(socket, message + 50, 50));
+
+    readBytes = 0;
+
+    while ((readBytes < 50) && (Hal_getMonotonicTimeInMs() < timeout))
+        readBytes += SerialPort_read(tcpPort, buffer + readBytes, 50 - readBytes, 10);
+
+    TEST_ASSERT_EQUAL_INT(50, readBytes);
+    TEST_ASSERT_EQUAL_MEMORY(message + 50, buffer, 50);
+
+    SerialPort_close(tcpPort);
+    SerialPort_destroy(tcpPort);
+
+    Socket_destroy(socket);
+    ServerSocket_destroy(serverSocket);
+#endif
+}
+
+
+#ifndef _WIN32
+struct stest_SlaveQueues {
+    int class1Count;
+    int class2Count;
+    int class2ValueSum;
+};
+
+static bool
+test_CS101_Slave_queues_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    (void) address;
+
+    struct stest_SlaveQueues* info = (struct stest_SlaveQueues*) parameter;
+
+    if (CS101_ASDU_getCOT(asdu) == CS101_COT_SPONTANEOUS)
+        info->class1Count++;
+    else if (CS101_ASDU_getCOT(asdu) == CS101_COT_PERIODIC) {
+        MeasuredValueScaled mv = (MeasuredValueScaled) CS101_ASDU_getElement(asdu, 0);
+
+        info->class2Count++;
+        info->class2ValueSum += MeasuredValueScaled_getValue(mv);
+
+        MeasuredValueScaled_destroy(mv);
+    }
+
+    return true;
+}
+
+static CS101_ASDU
+test_CS101_Slave_queues_createASDU(CS101_Slave slave, CS101_CauseOfTransmission cot, int ioa, int value)
+{
+    CS101_ASDU asdu = CS101_ASDU_create(CS101_Slave_getAppLayerParameters(slave), false, cot, 0, 1, false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, ioa, value, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    return asdu;
+}
+#endif
+
+void
+test_CS101_Slave_queues(void)
+{
+#ifndef _WIN32
+    SerialPort masterPort;
+    SerialPort slavePort;
+
+    TEST_ASSERT_TRUE(SerialPort_createPipePair(9600, 8, 'E', 1, &masterPort, &slavePort));
+
+    struct stest_SlaveQueues info;
+
+    info.class1Count = 0;
+    info.class2Count = 0;
+    info.class2ValueSum = 0;
+
+    CS101_Slave slave = CS101_Slave_createEx(slavePort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED, 5, 10);
+    CS101_Slave_setLinkLayerAddress(slave, 1);
+    CS101_Slave_setClass2Coalescing(slave, true);
+
+    CS101_QueueStatistics statistics;
+
+    /* the second value of each IOA replaces the first value */
+    for (int i = 0; i < 6; i++) {
+        CS101_ASDU asdu = test_CS101_Slave_queues_createASDU(slave, CS101_COT_PERIODIC, (i % 3) + 1, i);
+
+        CS101_Slave_enqueueUserDataClass2(slave, asdu);
+
+        CS101_ASDU_destroy(asdu);
+    }
+
+    CS101_Slave_getClass2QueueStatistics(slave, &statistics);
+
+    TEST_ASSERT_EQUAL_INT(3, statistics.entries);
+    TEST_ASSERT_EQUAL_INT(6, (int) statistics.enqueued);
+    TEST_ASSERT_EQUAL_INT(3, (int) statistics.coalesced);
+    TEST_ASSERT_EQUAL_INT(0, (int) statistics.dropped);
+
+    /* events are not coalesced - the oldest events are dropped when the queue is full */
+    CS101_ASDU events[8];
+
+    for (int i = 0; i < 8; i++)
+        events[i] = test_CS101_Slave_queues_createASDU(slave, CS101_COT_SPONTANEOUS, 1, i);
+
+    CS101_Slave_enqueueUserDataClass1Batch(slave, events, 8);
+
+    for (int i = 0; i < 8; i++)
+        CS101_ASDU_destroy(events[i]);
+
+    CS101_Slave_getClass1QueueStatistics(slave, &statistics);
+
+    TEST_ASSERT_EQUAL_INT(5, statistics.entries);
+    TEST_ASSERT_EQUAL_INT(8, (int) statistics.enqueued);
+    TEST_ASSERT_EQUAL_INT(3, (int) statistics.dropped);
+    TEST_ASSERT_EQUAL_INT(0, (int) statistics.coalesced);
+
+    CS101_Master master = CS101_Master_create(masterPort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    CS101_Master_setASDUReceivedHandler(master, test_CS101_Slave_queues_asduReceivedHandler, &info);
+    CS101_Master_addSlave(master, 1);
+    CS101_Master_setSlavePollParameters(master, 1, 1, 10);
+
+    uint64_t timeout = Hal_getMonotonicTimeInMs() + 5000;
+
+    while (((info.class1Count < 5) || (info.class2Count < 3)) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        CS101_Master_run(master);
+        CS101_Slave_run(slave);
+    }
+
+    TEST_ASSERT_EQUAL_INT(5, info.class1Count);
+    TEST_ASSERT_EQUAL_INT(3, info.class2Count);
+    TEST_ASSERT_EQUAL_INT(3 + 4 + 5, info.class2ValueSum);
+
+    CS101_Slave_getClass1QueueStatistics(slave, &statistics);
+
+    TEST_ASSERT_EQUAL_INT(0, statistics.entries);
+    TEST_ASSERT_EQUAL_INT(5, (int) statistics.sent);
+    TEST_ASSERT_TRUE(statistics.maxAgeMs < 5000);
+
+    CS101_Master_destroy(master);
+    CS101_Slave_destroy(slave);
+
+    SerialPort_close(masterPort);
+    SerialPort_destroy(masterPort);
+    SerialPort_close(slavePort);
+    SerialPort_destroy(slavePort);
+#endif
+}
+
+
+#ifndef _WIN32
+struct stest_CS101_Slave_isReady {
+    CS101_Slave slave;
+    int interrogations;
+    bool readyBefore;
+    bool readyWhenFull;
+};
+
+static bool
+test_CS101_Slave_isReady_interrogationHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, uint8_t qoi)
+{
+    struct stest_CS101_Slave_isReady* info = (struct stest_CS101_Slave_isReady*) parameter;
+
+    (void) qoi;
+
+    info->readyBefore = IMasterConnection_isReady(connection);
+
+    /* the responses are sent before the application data but have to respect a full application queue */
+    while (CS101_Slave_isClass1QueueFull(info->slave) == false) {
+        CS101_ASDU event = test_CS101_Slave_queues_createASDU(info->slave, CS101_COT_SPONTANEOUS, 1, 0);
+
+        CS101_Slave_enqueueUserDataClass1(info->slave, event);
+
+        CS101_ASDU_destroy(event);
+    }
+
+    info->readyWhenFull = IMasterConnection_isReady(connection);
+
+    info->interrogations++;
+
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+
+    return true;
+}
+#endif
+
+void
+test_CS101_Slave_isReadyClass1QueueFull(void)
+{
+#ifndef _WIN32
+    SerialPort masterPort;
+    SerialPort slavePort;
+
+    TEST_ASSERT_TRUE(SerialPort_createPipePair(9600, 8, 'E', 1, &masterPort, &slavePort));
+
+    struct stest_CS101_Slave_isReady info;
+
+    CS101_Slave slave = CS101_Slave_createEx(slavePort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED, 5, 10);
+    CS101_Slave_setLinkLayerAddress(slave, 1);
+    CS101_Slave_setInterrogationHandler(slave, test_CS101_Slave_isReady_interrogationHandler, &info);
+
+    info.slave = slave;
+    info.interrogations = 0;
+    info.readyBefore = false;
+    info.readyWhenFull = true;
+
+    CS101_Master master = CS101_Master_create(masterPort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    CS101_Master_addSlave(master, 1);
+    CS101_Master_useSlaveAddress(master, 1);
+    CS101_Master_sendInterrogationCommand(master, CS101_COT_ACTIVATION, 1, IEC60870_QOI_STATION);
+
+    uint64_t timeout = Hal_getMonotonicTimeInMs() + 5000;
+
+    while ((info.interrogations == 0) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        CS101_Master_run(master);
+        CS101_Slave_run(slave);
+    }
+
+    CS101_Master_destroy(master);
+    CS101_Slave_destroy(slave);
+
+    SerialPort_close(masterPort);
+    SerialPort_destroy(masterPort);
+    SerialPort_close(slavePort);
+    SerialPort_destroy(slavePort);
+
+    TEST_ASSERT_EQUAL_INT(1, info.interrogations);
+    TEST_ASSERT_TRUE(info.readyBefore);
+    TEST_ASSERT_FALSE(info.readyWhenFull);
+#endif
+}
+
+
+#ifndef _WIN32
+/* encode a fixed length frame like the counterpart would do */
+static int
+test_LinkLayer_encodeFixedFrame(uint8_t* buffer, uint8_t c, int address, int addressLength)
+{
+    int bufPos = 0;
+
+    buffer[bufPos++] = 0x10;
+    buffer[bufPos++] = c;
+
+    if (addressLength > 0)
+        buffer[bufPos++] = (uint8_t) (address % 0x100);
+
+    if (addressLength > 1)
+        buffer[bufPos++] = (uint8_t) ((address / 0x100) % 0x100);
+
+    uint8_t checksum = 0;
+
+    for (int i = 1; i < bufPos; i++)
+        checksum += buffer[i];
+
+    buffer[bufPos++] = checksum;
+    buffer[bufPos++] = 0x16;
+
+    return bufPos;
+}
+
+/* run the master or the slave until the counterpart received a complete frame */
+static int
+test_LinkLayer_readFrame(CS101_Master master, CS101_Slave slave, SerialPort port, uint8_t* buffer, int addressLength)
+{
+    int readBytes = 0;
+    int frameSize = 1;
+
+    uint64_t timeout = Hal_getMonotonicTimeInMs() + 2000;
+
+    while ((readBytes < frameSize) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        if (master)
+            CS101_Master_run(master);
+
+        if (slave)
+            CS101_Slave_run(slave);
+
+        int result = SerialPort_read(port, buffer + readBytes, frameSize - readBytes, 1);
+
+        TEST_ASSERT_TRUE(result >= 0);
+
+        readBytes += result;
+
+        if ((readBytes == 1) && (buffer[0] == 0x10))
+            frameSize = 4 + addressLength;
+        else if ((readBytes == 1) && (buffer[0] == 0x68))
+            frameSize = 4;
+        else if ((readBytes == 4) && (buffer[0] == 0x68))
+            frameSize = 4 + buffer[1] + 2;
+    }
+
+    return readBytes;
+}
+
+static void
+test_LinkLayer_checkFixedFrame(uint8_t* frame, uint8_t c, int address, int addressLength)
+{
+    uint8_t expected[6];
+
+    int frameSize = test_LinkLayer_encodeFixedFrame(expected, c, address, addressLength);
+
+    TEST_ASSERT_EQUAL_MEMORY(expected, frame, frameSize);
+}
+
+static void
+test_LinkLayer_fixedFrames_run(int address, int addressLength)
+{
+    SerialPort masterPort;
+    SerialPort peerPort;
+
+    uint8_t buffer[300];
+
+    TEST_ASSERT_TRUE(SerialPort_createPipePair(9600, 8, 'E', 1, &masterPort, &peerPort));
+
+    CS101_Master master = CS101_Master_create(masterPort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    CS101_Master_getLinkLayerParameters(master)->addressLength = addressLength;
+    CS101_Master_addSlave(master, address);
+
+    CS101_Master_pollSingleSlave(master, address);
+
+    /* FC 09 - request link status (PRM) */
+    TEST_ASSERT_EQUAL_INT(4 + addressLength, test_LinkLayer_readFrame(master, NULL, peerPort, buffer, addressLength));
+    test_LinkLayer_checkFixedFrame(buffer, 0x49, address, addressLength);
+
+    /* FC 11 - status of link */
+    int frameSize = test_LinkLayer_encodeFixedFrame(buffer, 0x0b, address, addressLength);
+    TEST_ASSERT_EQUAL_INT(frameSize, SerialPort_write(peerPort, buffer, 0, frameSize));
+
+    /* FC 00 - reset remote link (PRM) */
+    TEST_ASSERT_EQUAL_INT(4 + addressLength, test_LinkLayer_readFrame(master, NULL, peerPort, buffer, addressLength));
+    test_LinkLayer_checkFixedFrame(buffer, 0x40, address, addressLength);
+
+    /* FC 00 - ACK */
+    frameSize = test_LinkLayer_encodeFixedFrame(buffer, 0x00, address, addressLength);
+    TEST_ASSERT_EQUAL_INT(frameSize, SerialPort_write(peerPort, buffer, 0, frameSize));
+
+    /* FC 11 - request class 2 data (PRM, FCB, FCV) */
+    CS101_Master_pollSingleSlave(master, address);
+
+    TEST_ASSERT_EQUAL_INT(4 + addressLength, test_LinkLayer_readFrame(master, NULL, peerPort, buffer, addressLength));
+    test_LinkLayer_checkFixedFrame(buffer, 0x7b, address, addressLength);
+
+    /* FC 09 - no data */
+    frameSize = test_LinkLayer_encodeFixedFrame(buffer, 0x09, address, addressLength);
+    TEST_ASSERT_EQUAL_INT(frameSize, SerialPort_write(peerPort, buffer, 0, frameSize));
+
+    /* the FCB toggles - only the control field and the checksum of the template change */
+    CS101_Master_pollSingleSlave(master, address);
+
+    TEST_ASSERT_EQUAL_INT(4 + addressLength, test_LinkLayer_readFrame(master, NULL, peerPort, buffer, addressLength));
+    test_LinkLayer_checkFixedFrame(buffer, 0x5b, address, addressLength);
+
+    CS101_Master_destroy(master);
+
+    SerialPort_close(masterPort);
+    SerialPort_destroy(masterPort);
+    SerialPort_close(peerPort);
+    SerialPort_destroy(peerPort);
+}
+#endif
+
+void
+test_LinkLayer_fixedFrames(void)
+{
+#ifndef _WIN32
+    test_LinkLayer_fixedFrames_run(5, 1);
+    test_LinkLayer_fixedFrames_run(0xfe, 1);
+    test_LinkLayer_fixedFrames_run(0x1234, 2);
+    test_LinkLayer_fixedFrames_run(0xfffe, 2);
+#endif
+}
+
+void
+test_LinkLayer_balancedRepeatAfterReceivedFrame(void)
+{
+#ifndef _WIN32
+    SerialPort slavePort;
+    SerialPort peerPort;
+
+    uint8_t buffer[300];
+    uint8_t sentFrame[300];
+
+    TEST_ASSERT_TRUE(SerialPort_createPipePair(9600, 8, 'E', 1, &slavePort, &peerPort));
+
+    CS101_Slave slave = CS101_Slave_create(slavePort, NULL, NULL, IEC60870_LINK_LAYER_BALANCED);
+    CS101_Slave_setLinkLayerAddress(slave, 1);
+    CS101_Slave_setLinkLayerAddressOtherStation(slave, 2);
+
+    CS101_ASDU asdu = CS101_ASDU_create(CS101_Slave_getAppLayerParameters(slave), false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 100, 1234, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    CS101_Slave_enqueueUserDataClass1(slave, asdu);
+
+    CS101_ASDU_destroy(asdu);
+
+    /* FC 09 - request link status */
+    TEST_ASSERT_EQUAL_INT(5, test_LinkLayer_readFrame(NULL, slave, peerPort, buffer, 1));
+    TEST_ASSERT_EQUAL_INT(0x49, buffer[1] & 0x7f);
+
+    /* FC 11 - status of link (DIR) */
+    int frameSize = test_LinkLayer_encodeFixedFrame(buffer, 0x8b, 2, 1);
+    TEST_ASSERT_EQUAL_INT(frameSize, SerialPort_write(peerPort, buffer, 0, frameSize));
+
+    /* FC 00 - reset remote link */
+    TEST_ASSERT_EQUAL_INT(5, test_LinkLayer_readFrame(NULL, slave, peerPort, buffer, 1));
+    TEST_ASSERT_EQUAL_INT(0x40, buffer[1] & 0x7f);
+
+    buffer[0] = 0xe5;
+    TEST_ASSERT_EQUAL_INT(1, SerialPort_write(peerPort, buffer, 0, 1));
+
+    /* FC 03 - user data confirmed */
+    int sentFrameSize = test_LinkLayer_readFrame(NULL, slave, peerPort, sentFrame, 1);
+
+    TEST_ASSERT_TRUE(sentFrameSize > 9);
+    TEST_ASSERT_EQUAL_INT(0x68, sentFrame[0]);
+    TEST_ASSERT_EQUAL_INT(0x73, sentFrame[4] & 0x7f);
+
+    /* the counterpart sends its own user data instead of the ACK (FC 04 - user data no reply) */
+    uint8_t userData[] = {0x2d, 0x01, 0x06, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x81, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55};
+
+    int bufPos = 0;
+
+    buffer[bufPos++] = 0x68;
+    buffer[bufPos++] = (uint8_t) (2 + sizeof(userData));
+    buffer[bufPos++] = (uint8_t) (2 + sizeof(userData));
+    buffer[bufPos++] = 0x68;
+    buffer[bufPos++] = 0xc4;
+    buffer[bufPos++] = 0x02;
+
+    memcpy(buffer + bufPos, userData, sizeof(userData));
+    bufPos += sizeof(userData);
+
+    uint8_t checksum = 0;
+
+    for (int i = 4; i < bufPos; i++)
+        checksum += buffer[i];
+
+    buffer[bufPos++] = checksum;
+    buffer[bufPos++] = 0x16;
+
+    TEST_ASSERT_EQUAL_INT(bufPos, SerialPort_write(peerPort, buffer, 0, bufPos));
+
+    /* the ACK timeout causes a repetition of the unchanged frame */
+    TEST_ASSERT_EQUAL_INT(sentFrameSize, test_LinkLayer_readFrame(NULL, slave, peerPort, buffer, 1));
+    TEST_ASSERT_EQUAL_MEMORY(sentFrame, buffer, sentFrameSize);
+
+    CS101_Slave_destroy(slave);
+
+    SerialPort_close(slavePort);
+    SerialPort_destroy(slavePort);
+    SerialPort_close(peerPort);
+    SerialPort_destroy(peerPort);
+#endif
+}
+
+
+#ifndef _WIN32
+static bool
+test_CS101_CommandFanOut_interrogationHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, uint8_t qoi)
+{
+    (void) parameter;
+    (void) qoi;
+
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+    IMasterConnection_sendACT_TERM(connection, asdu);
+
+    return true;
+}
+
+static bool
+test_CS101_CommandFanOut_run(CS101_CommandFanOut fanOut, CS101_Master master, CS101_Slave slave)
+{
+    uint64_t timeout = Hal_getMonotonicTimeInMs() + 5000;
+
+    bool finished = false;
+
+    while ((finished == false) && (Hal_getMonotonicTimeInMs() < timeout)) {
+        finished = CS101_CommandFanOut_run(fanOut);
+
+        CS101_Master_run(master);
+        CS101_Slave_run(slave);
+    }
+
+    return finished;
+}
+#endif
+
+void
+test_CS101_CommandFanOut(void)
+{
+#ifndef _WIN32
+    SerialPort masterPort;
+    SerialPort slavePort;
+
+    TEST_ASSERT_TRUE(SerialPort_createPipePair(9600, 8, 'E', 1, &masterPort, &slavePort));
+
+    CS101_Slave slave = CS101_Slave_create(slavePort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+    CS101_Slave_setLinkLayerAddress(slave, 1);
+    CS101_Slave_setInterrogationHandler(slave, test_CS101_CommandFanOut_interrogationHandler, NULL);
+
+    CS101_Master master = CS101_Master_create(masterPort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    /* slave 2 does not exist */
+    CS101_Master_addSlave(master, 1);
+    CS101_Master_addSlave(master, 2);
+
+    CS101_CommandFanOut fanOut = CS101_CommandFanOut_create();
+
+    CS101_Master_setCommandFanOut(master, fanOut);
+
+    CS101_CommandFanOut_setConcurrency(fanOut, 1);
+    CS101_CommandFanOut_setTimeout(fanOut, 500);
+
+    TEST_ASSERT_EQUAL_INT(0, CS101_CommandFanOut_addCS101Target(fanOut, master, 2, 2));
+    TEST_ASSERT_EQUAL_INT(1, CS101_CommandFanOut_addCS101Target(fanOut, master, 1, 1));
+
+    CS101_CommandFanOut_start(fanOut);
+
+    TEST_ASSERT_FALSE(CS101_CommandFanOut_isFinished(fanOut));
+
+    TEST_ASSERT_TRUE(test_CS101_CommandFanOut_run(fanOut, master, slave));
+
+    TEST_ASSERT_EQUAL_INT(CS101_FANOUT_TARGET_TIMEOUT, CS101_CommandFanOut_getTargetState(fanOut, 0));
+    TEST_ASSERT_EQUAL_INT(CS101_FANOUT_TARGET_COMPLETED, CS101_CommandFanOut_getTargetState(fanOut, 1));
+
+    CS101_FanOutResult result;
+
+    CS101_CommandFanOut_getResult(fanOut, &result);
+
+    TEST_ASSERT_EQUAL_INT(2, result.targets);
+    TEST_ASSERT_EQUAL_INT(1, result.completed);
+    TEST_ASSERT_EQUAL_INT(1, result.timedOut);
+    TEST_ASSERT_EQUAL_INT(0, result.pending);
+    TEST_ASSERT_EQUAL_INT(2, result.commandsSent);
+    TEST_ASSERT_EQUAL_INT(0, result.broadcastsSent);
+
+    /* concurrency 1 - the second target is sent after the timeout of the first target */
+    TEST_ASSERT_TRUE(result.completionTimeMs >= 500);
+
+    /* a single broadcast message for all targets of the master */
+    CS101_CommandFanOut_setUseBroadcast(fanOut, true);
+    CS101_CommandFanOut_setClockSyncCommand(fanOut, NULL);
+
+    CS101_CommandFanOut_start(fanOut);
+
+    TEST_ASSERT_TRUE(test_CS101_CommandFanOut_run(fanOut, master, slave));
+
+    CS101_CommandFanOut_getResult(fanOut, &result);
+
+    TEST_ASSERT_EQUAL_INT(2, result.completed);
+    TEST_ASSERT_EQUAL_INT(1, result.commandsSent);
+    TEST_ASSERT_EQUAL_INT(1, result.broadcastsSent);
+
+    CS101_Master_setCommandFanOut(master, NULL);
+    CS101_CommandFanOut_destroy(fanOut);
+
+    CS101_Master_destroy(master);
+    CS101_Slave_destroy(slave);
+
+    SerialPort_close(masterPort);
+    SerialPort_destroy(masterPort);
+    SerialPort_close(slavePort);
+    SerialPort_destroy(slavePort);
+#endif
+}
+
+
+#ifndef _WIN32
+static uint32_t
+test_CS101_LinkLayerStatistics_sumBuckets(CS101_LatencyHistogram* histogram)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < CS101_LATENCY_HISTOGRAM_SIZE; i++)
+        sum += histogram->buckets[i];
+
+    return sum;
+}
+#endif
+
+void
+test_CS101_LinkLayerStatistics(void)
+{
+#ifndef _WIN32
+    SerialPort masterPort;
+    SerialPort slavePort;
+
+    TEST_ASSERT_TRUE(SerialPort_createPipePair(9600, 8, 'E', 1, &masterPort, &slavePort));
+
+    CS101_Slave slave = CS101_Slave_create(slavePort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+    CS101_Slave_setLinkLayerAddress(slave, 1);
+
+    CS101_Master master = CS101_Master_create(masterPort, NULL, NULL, IEC60870_LINK_LAYER_UNBALANCED);
+
+    /* slave 2 does not exist */
+    CS101_Master_addSlave(master, 1);
+    CS101_Master_addSlave(master, 2);
+    CS101_Master_setSlavePollParameters(master, 1, 1, 10);
+
+    uint64_t endTime = Hal_getMonotonicTimeInMs() + 600;
+
+    while (Hal_getMonotonicTimeInMs() < endTime) {
+        CS101_Master_run(master);
+        CS101_Slave_run(slave);
+    }
+
+    CS101_LinkLayerStatistics statistics;
+
+    CS101_Master_getLinkLayerStatistics(master, &statistics);
+
+    TEST_ASSERT_TRUE(statistics.requests > 10);
+    TEST_ASSERT_TRUE(statistics.responses > 10);
+    TEST_ASSERT_TRUE(statistics.timeouts >= 1);
+    TEST_ASSERT_TRUE(statistics.bytesSent > 0);
+    TEST_ASSERT_TRUE(statistics.bytesReceived > 0);
+    TEST_ASSERT_EQUAL_INT(statistics.responses, statistics.framesReceived);
+    TEST_ASSERT_EQUAL_INT(0, statistics.checksumErrors);
+    TEST_ASSERT_EQUAL_INT(statistics.responses, statistics.roundTripTime.count);
+    TEST_ASSERT_EQUAL_INT(statistics.roundTripTime.count,
+                          test_CS101_LinkLayerStatistics_sumBuckets(&statistics.roundTripTime));
+    TEST_ASSERT_TRUE(statistics.roundTripTime.minUs <= statistics.roundTripTime.maxUs);
+
+    uint32_t totalRequests = statistics.requests;
+
+    TEST_ASSERT_TRUE(CS101_Master_getSlaveLinkLayerStatistics(master, 1, &statistics));
+
+    TEST_ASSERT_TRUE(statistics.responses > 10);
+    TEST_ASSERT_EQUAL_INT(0, statistics.timeouts);
+    TEST_ASSERT_EQUAL_INT(0, statistics.bytesSent);
+
+    uint32_t slave1Requests = statistics.requests;
+
+    TEST_ASSERT_TRUE(CS101_Master_getSlaveLinkLayerStatistics(master, 2, &statistics));
+
+    TEST_ASSERT_EQUAL_INT(0, statistics.responses);
+    TEST_ASSERT_TRUE(statistics.timeouts >= 1);
+    TEST_ASSERT_EQUAL_INT(totalRequests, slave1Requests + statistics.requests);
+
+    TEST_ASSERT_FALSE(CS101_Master_getSlaveLinkLayerStatistics(master, 3, &statistics));
+
+    CS101_Slave_getLinkLayerStatistics(slave, &statistics);
+
+    TEST_ASSERT_TRUE(statistics.responseTime.count > 10);
+    TEST_ASSERT_EQUAL_INT(0, statistics.requests);
+    TEST_ASSERT_EQUAL_INT(0, statistics.checksumErrors);
+    TEST_ASSERT_EQUAL_INT(0, statistics.syncErrors);
+
+    /* frame with invalid checksum and a byte that is not the start of a frame */
+    uint8_t invalidFrame[] = {0x10, 0x5b, 0x01, 0x00, 0x16};
+    uint8_t noise[] = {0x55};
+
+    SerialPort_write(masterPort, invalidFrame, 0, sizeof(invalidFrame));
+
+    endTime = Hal_getMonotonicTimeInMs() + 100;
+
+    while (Hal_getMonotonicTimeInMs() < endTime)
+        CS101_Slave_run(slave);
+
+    SerialPort_write(masterPort, noise, 0, sizeof(noise));
+
+    endTime = Hal_getMonotonicTimeInMs() + 100;
+
+    while (Hal_getMonotonicTimeInMs() < endTime)
+        CS101_Slave_run(slave);
+
+    CS101_Slave_getLinkLayerStatistics(slave, &statistics);
+
+    TEST_ASSERT_EQUAL_INT(1, statistics.checksumErrors);
+    TEST_ASSERT_EQUAL_INT(1, statistics.syncErrors);
+
+    CS101_Slave_resetLinkLayerStatistics(slave);
+    CS101_Master_resetLinkLayerStatistics(master);
+
+    CS101_Slave_getLinkLayerStatistics(slave, &statistics);
+
+    TEST_ASSERT_EQUAL_INT(0, statistics.checksumErrors);
+    TEST_ASSERT_EQUAL_INT(0, statistics.bytesReceived);
+
+    CS101_Master_getLinkLayerStatistics(master, &statistics);
+
+    TEST_ASSERT_EQUAL_INT(0, statistics.requests);
+    TEST_ASSERT_EQUAL_INT(0, statistics.bytesSent);
+
+    TEST_ASSERT_TRUE(CS101_Master_getSlaveLinkLayerStatistics(master, 1, &statistics));
+    TEST_ASSERT_EQUAL_INT(0, statistics.responses);
+
+    CS101_Master_destroy(master);
+    CS101_Slave_destroy(slave);
+
+    SerialPort_close(masterPort);
+    SerialPort_destroy(masterPort);
+    SerialPort_close(slavePort);
+    SerialPort_destroy(slavePort);
+#endif
+}
+
+
+#define TEST_PROCESS_IMAGE_MAX_RECORDS 200
+
+typedef struct
+{
+    TypeID typeId;
+    int cot;
+    int ca;
+    int elements;
+    bool isSequence;
+    bool isNegative;
+    int firstIoa;
+    float floatValue;
+} test_CS101_ProcessImage_Record;
+
+static test_CS101_ProcessImage_Record test_CS101_ProcessImage_records[TEST_PROCESS_IMAGE_MAX_RECORDS];
+static volatile int test_CS101_ProcessImage_numberOfRecords = 0;
+static volatile int test_CS101_ProcessImage_handlerCalls = 0;
+
+static bool
+test_CS101_ProcessImage_asduHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    int index = test_CS101_ProcessImage_numberOfRecords;
+
+    if (index < TEST_PROCESS_IMAGE_MAX_RECORDS)
+    {
+        test_CS101_ProcessImage_Record* record = &(test_CS101_ProcessImage_records[index]);
+
+        record->typeId = CS101_ASDU_getTypeID(asdu);
+        record->cot = CS101_ASDU_getCOT(asdu);
+        record->ca = CS101_ASDU_getCA(asdu);
+        record->elements = CS101_ASDU_getNumberOfElements(asdu);
+        record->isSequence = CS101_ASDU_isSequence(asdu);
+        record->isNegative = CS101_ASDU_isNegative(asdu);
+        record->firstIoa = -1;
+        record->floatValue = 0.f;
+
+        if (record->elements > 0)
+        {
+            InformationObject io = CS101_ASDU_getElement(asdu, 0);
+
+            if (io)
+            {
+                record->firstIoa = InformationObject_getObjectAddress(io);
+
+                if (record->typeId == M_ME_NC_1)
+                    record->floatValue = MeasuredValueShort_getValue((MeasuredValueShort)io);
+
+                InformationObject_destroy(io);
+            }
+        }
+
+        test_CS101_ProcessImage_numberOfRecords = index + 1;
+    }
+
+    return true;
+}
+
+static bool
+test_CS101_ProcessImage_interrogationHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, uint8_t qoi)
+{
+    test_CS101_ProcessImage_handlerCalls++;
+
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+    IMasterConnection_sendACT_TERM(connection, asdu);
+
+    return true;
+}
+
+static int
+test_CS101_ProcessImage_count(TypeID typeId, int cot, int ca)
+{
+    int count = 0;
+    int i;
+
+    for (i = 0; i < test_CS101_ProcessImage_numberOfRecords; i++)
+    {
+        test_CS101_ProcessImage_Record* record = &(test_CS101_ProcessImage_records[i]);
+
+        if ((record->typeId == typeId) && (record->cot == cot) && (record->ca == ca))
+            count++;
+    }
+
+    return count;
+}
+
+/* wait until the number of received messages of the given type, COT and CA is reached */
+static bool
+test_CS101_ProcessImage_waitFor(TypeID typeId, int cot, int ca, int expected)
+{
+    int i;
+
+    for (i = 0; i < 300; i++)
+    {
+        if (test_CS101_ProcessImage_count(typeId, cot, ca) >= expected)
+            return true;
+
+        Thread_sleep(10);
+    }
+
+    return false;
+}
+
+void
+test_CS101_ProcessImage(void)
+{
+    CS101_ProcessImage image = CS101_ProcessImage_create(10);
+
+    TEST_ASSERT_NOT_NULL(image);
+
+    int i;
+
+    for (i = 1; i <= 100; i++)
+    {
+        int index = CS101_ProcessImage_addPoint(image, 1, i, M_SP_NA_1, 0x0001);
+
+        TEST_ASSERT_EQUAL_INT(i - 1, index);
+        TEST_ASSERT_TRUE(CS101_ProcessImage_setValue(image, index, i % 2, IEC60870_QUALITY_GOOD));
+    }
+
+    /* 200 scaled values with a gap at IOA 1100 */
+    for (i = 1000; i < 1200; i++)
+    {
+        if (i != 1100)
+        {
+            TEST_ASSERT_TRUE(CS101_ProcessImage_addPoint(image, 1, i, M_ME_NB_1, 0) >= 0);
+        }
+    }
+
+    int floatIndex = CS101_ProcessImage_addPoint(image, 1, 5000, M_ME_NC_1, 0x0002);
+
+    TEST_ASSERT_TRUE(floatIndex >= 0);
+    TEST_ASSERT_TRUE(CS101_ProcessImage_setValue(image, floatIndex, 12.5, IEC60870_QUALITY_GOOD));
+
+    for (i = 7000; i < 7004; i++)
+        TEST_ASSERT_TRUE(CS101_ProcessImage_addPoint(image, 1, i, M_IT_NA_1, 0x0001) >= 0);
+
+    for (i = 1; i <= 3; i++)
+        TEST_ASSERT_TRUE(CS101_ProcessImage_addPoint(image, 2, i, M_DP_NA_1, 0) >= 0);
+
+    /* duplicate point and unsupported type */
+    TEST_ASSERT_EQUAL_INT(-1, CS101_ProcessImage_addPoint(image, 1, 5000, M_SP_NA_1, 0));
+    TEST_ASSERT_EQUAL_INT(-1, CS101_ProcessImage_addPoint(image, 1, 9000, M_SP_TB_1, 0));
+
+    TEST_ASSERT_EQUAL_INT(100 + 199 + 1 + 4 + 3, CS101_ProcessImage_getNumberOfPoints(image));
+    TEST_ASSERT_EQUAL_INT(floatIndex, CS101_ProcessImage_getPointIndex(image, 1, 5000));
+    TEST_ASSERT_EQUAL_INT(-1, CS101_ProcessImage_getPointIndex(image, 3, 5000));
+
+    double value;
+    QualityDescriptor quality;
+
+    TEST_ASSERT_TRUE(CS101_ProcessImage_getValue(image, floatIndex, &value, &quality));
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, (float)value);
+    TEST_ASSERT_EQUAL_INT(IEC60870_QUALITY_GOOD, quality);
+
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    TEST_ASSERT_NOT_NULL(slave);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setInterrogationHandler(slave, test_CS101_ProcessImage_interrogationHandler, NULL);
+    CS104_Slave_addPlugin(slave, CS101_ProcessImage_getPlugin(image));
+    CS104_Slave_start(slave);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    TEST_ASSERT_NOT_NULL(con);
+
+    test_CS101_ProcessImage_numberOfRecords = 0;
+    test_CS101_ProcessImage_handlerCalls = 0;
+
+    CS104_Connection_setASDUReceivedHandler(con, test_CS101_ProcessImage_asduHandler, NULL);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    Thread_sleep(100);
+
+    /* station interrogation - served from the process image */
+    CS104_Connection_sendInterrogationCommand(con, CS101_COT_ACTIVATION, 1, IEC60870_QOI_STATION);
+
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_waitFor(C_IC_NA_1, CS101_COT_ACTIVATION_TERMINATION, 1, 1));
+
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_count(C_IC_NA_1, CS101_COT_ACTIVATION_CON, 1));
+    TEST_ASSERT_EQUAL_INT(C_IC_NA_1, test_CS101_ProcessImage_records[0].typeId);
+    TEST_ASSERT_EQUAL_INT(C_IC_NA_1, test_CS101_ProcessImage_records[test_CS101_ProcessImage_numberOfRecords - 1].typeId);
+
+    int elements = 0;
+
+    for (i = 0; i < test_CS101_ProcessImage_numberOfRecords; i++)
+    {
+        test_CS101_ProcessImage_Record* record = &(test_CS101_ProcessImage_records[i]);
+
+        if (record->cot == CS101_COT_INTERROGATED_BY_STATION)
+        {
+            elements += record->elements;
+
+            /* the contiguous points are packed into ASDUs with SQ=1 */
+            if (record->typeId != M_ME_NC_1)
+            {
+                TEST_ASSERT_TRUE(record->isSequence);
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(100 + 199 + 1, elements);
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_count(M_SP_NA_1, CS101_COT_INTERROGATED_BY_STATION, 1));
+    TEST_ASSERT_EQUAL_INT(4, test_CS101_ProcessImage_count(M_ME_NB_1, CS101_COT_INTERROGATED_BY_STATION, 1));
+    TEST_ASSERT_EQUAL_INT(0, test_CS101_ProcessImage_count(M_IT_NA_1, CS101_COT_INTERROGATED_BY_STATION, 1));
+    TEST_ASSERT_EQUAL_INT(0, test_CS101_ProcessImage_handlerCalls);
+
+    /* group interrogation (group 2) */
+    test_CS101_ProcessImage_numberOfRecords = 0;
+
+    CS104_Connection_sendInterrogationCommand(con, CS101_COT_ACTIVATION, 1, IEC60870_QOI_STATION + 2);
+
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_waitFor(C_IC_NA_1, CS101_COT_ACTIVATION_TERMINATION, 1, 1));
+    TEST_ASSERT_EQUAL_INT(3, test_CS101_ProcessImage_numberOfRecords);
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_count(M_ME_NC_1, CS101_COT_INTERROGATED_BY_GROUP_2, 1));
+    TEST_ASSERT_EQUAL_INT(5000, test_CS101_ProcessImage_records[1].firstIoa);
+
+    /* general counter interrogation */
+    test_CS101_ProcessImage_numberOfRecords = 0;
+
+    CS104_Connection_sendCounterInterrogationCommand(con, CS101_COT_ACTIVATION, 1, IEC60870_QCC_RQT_GENERAL);
+
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_waitFor(C_CI_NA_1, CS101_COT_ACTIVATION_TERMINATION, 1, 1));
+    TEST_ASSERT_EQUAL_INT(3, test_CS101_ProcessImage_numberOfRecords);
+    TEST_ASSERT_EQUAL_INT(M_IT_NA_1, test_CS101_ProcessImage_records[1].typeId);
+    TEST_ASSERT_EQUAL_INT(CS101_COT_REQUESTED_BY_GENERAL_COUNTER, test_CS101_ProcessImage_records[1].cot);
+    TEST_ASSERT_EQUAL_INT(4, test_CS101_ProcessImage_records[1].elements);
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_records[1].isSequence);
+
+    /* read command - known and unknown IOA */
+    test_CS101_ProcessImage_numberOfRecords = 0;
+
+    CS104_Connection_sendReadCommand(con, 1, 5000);
+    CS104_Connection_sendReadCommand(con, 1, 4242);
+
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_waitFor(C_RD_NA_1, CS101_COT_UNKNOWN_IOA, 1, 1));
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_count(M_ME_NC_1, CS101_COT_REQUEST, 1));
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, test_CS101_ProcessImage_records[0].floatValue);
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_records[1].isNegative);
+
+    /* broadcast station interrogation - every CA is confirmed and terminated */
+    test_CS101_ProcessImage_numberOfRecords = 0;
+
+    CS104_Connection_sendInterrogationCommand(con, CS101_COT_ACTIVATION, 0xffff, IEC60870_QOI_STATION);
+
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_waitFor(C_IC_NA_1, CS101_COT_ACTIVATION_TERMINATION, 2, 1));
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_count(C_IC_NA_1, CS101_COT_ACTIVATION_CON, 1));
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_count(C_IC_NA_1, CS101_COT_ACTIVATION_TERMINATION, 1));
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_count(C_IC_NA_1, CS101_COT_ACTIVATION_CON, 2));
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_count(M_DP_NA_1, CS101_COT_INTERROGATED_BY_STATION, 2));
+
+    /* CA without points - handled by the application */
+    test_CS101_ProcessImage_numberOfRecords = 0;
+
+    CS104_Connection_sendInterrogationCommand(con, CS101_COT_ACTIVATION, 3, IEC60870_QOI_STATION);
+
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_waitFor(C_IC_NA_1, CS101_COT_ACTIVATION_TERMINATION, 3, 1));
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_handlerCalls);
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    CS101_ProcessImage_destroy(image);
+}
+
+
+static int test_CS101_ProcessImage_Events_asdus = 0;
+static int test_CS101_ProcessImage_Events_elements = 0;
+static TypeID test_CS101_ProcessImage_Events_lastType;
+static int test_CS101_ProcessImage_Events_lastCot;
+
+static void
+test_CS101_ProcessImage_Events_handler(void* parameter, CS101_ASDU asdu)
+{
+    test_CS101_ProcessImage_Events_asdus++;
+    test_CS101_ProcessImage_Events_elements += CS101_ASDU_getNumberOfElements(asdu);
+    test_CS101_ProcessImage_Events_lastType = CS101_ASDU_getTypeID(asdu);
+    test_CS101_ProcessImage_Events_lastCot = CS101_ASDU_getCOT(asdu);
+}
+
+void
+test_CS101_ProcessImage_Events(void)
+{
+    struct sCS101_AppLayerParameters alParams = {
+        /* .sizeOfTypeId =  */ 1,
+        /* .sizeOfVSQ = */ 1,
+        /* .sizeOfCOT = */ 2,
+        /* .originatorAddress = */ 0,
+        /* .sizeOfCA = */ 2,
+        /* .sizeOfIOA = */ 3,
+        /* .maxSizeOfASDU = */ 249
+    };
+
+    CS101_ProcessImage image = CS101_ProcessImage_create(100);
+
+    TEST_ASSERT_NOT_NULL(image);
+
+    int absIndex = CS101_ProcessImage_addPoint(image, 1, 100, M_ME_NC_1, 0);
+    int pctIndex = CS101_ProcessImage_addPoint(image, 1, 101, M_ME_NC_1, 0);
+    int intIndex = CS101_ProcessImage_addPoint(image, 1, 102, M_ME_NC_1, 0);
+    int spIndex = CS101_ProcessImage_addPoint(image, 1, 200, M_SP_NA_1, 0);
+
+    CS101_ProcessImage_setValue(image, absIndex, 10.0, IEC60870_QUALITY_GOOD);
+    CS101_ProcessImage_setValue(image, pctIndex, 100.0, IEC60870_QUALITY_GOOD);
+    CS101_ProcessImage_setValue(image, intIndex, 0.0, IEC60870_QUALITY_GOOD);
+    CS101_ProcessImage_setValue(image, spIndex, 0, IEC60870_QUALITY_GOOD);
+
+    TEST_ASSERT_TRUE(CS101_ProcessImage_setDeadband(image, absIndex, CS101_DEADBAND_ABSOLUTE, 1.0));
+    TEST_ASSERT_TRUE(CS101_ProcessImage_setDeadband(image, pctIndex, CS101_DEADBAND_PERCENT, 5.0));
+    TEST_ASSERT_TRUE(CS101_ProcessImage_setDeadband(image, intIndex, CS101_DEADBAND_INTEGRATED, 2.0));
+
+    /* without event handler no events are created */
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, spIndex, 1, IEC60870_QUALITY_GOOD, NULL));
+
+    CS101_ProcessImage_setEventHandler(image, &alParams, test_CS101_ProcessImage_Events_handler, NULL);
+
+    test_CS101_ProcessImage_Events_asdus = 0;
+    test_CS101_ProcessImage_Events_elements = 0;
+
+    /* absolute deadband */
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, absIndex, 10.5, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, absIndex, 10.9, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_TRUE(CS101_ProcessImage_updateValue(image, absIndex, 11.5, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, absIndex, 12.0, IEC60870_QUALITY_GOOD, NULL));
+
+    /* quality change always creates an event */
+    TEST_ASSERT_TRUE(CS101_ProcessImage_updateValue(image, absIndex, 12.0, IEC60870_QUALITY_INVALID, NULL));
+
+    /* percent deadband (5% of 100) */
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, pctIndex, 104.0, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_TRUE(CS101_ProcessImage_updateValue(image, pctIndex, 106.0, IEC60870_QUALITY_GOOD, NULL));
+
+    /* integrated deadband - small deviations add up */
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, intIndex, 0.5, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, intIndex, 0.5, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, intIndex, 0.5, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, intIndex, 0.5, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_TRUE(CS101_ProcessImage_updateValue(image, intIndex, 0.5, IEC60870_QUALITY_GOOD, NULL));
+
+    /* events of the same type and CA are packed into one ASDU */
+    TEST_ASSERT_EQUAL_INT(0, test_CS101_ProcessImage_Events_asdus);
+
+    /* single point - every change is an event (other type -> pending ASDU is passed to the handler) */
+    TEST_ASSERT_FALSE(CS101_ProcessImage_updateValue(image, spIndex, 1, IEC60870_QUALITY_GOOD, NULL));
+    TEST_ASSERT_TRUE(CS101_ProcessImage_updateValue(image, spIndex, 0, IEC60870_QUALITY_GOOD, NULL));
+
+    TEST_ASSERT_EQUAL_INT(1, test_CS101_ProcessImage_Events_asdus);
+    TEST_ASSERT_EQUAL_INT(4, test_CS101_ProcessImage_Events_elements);
+    TEST_ASSERT_EQUAL_INT(M_ME_TF_1, test_CS101_ProcessImage_Events_lastType);
+    TEST_ASSERT_EQUAL_INT(CS101_COT_SPONTANEOUS, test_CS101_ProcessImage_Events_lastCot);
+
+    CS101_ProcessImage_flushEvents(image);
+
+    TEST_ASSERT_EQUAL_INT(2, test_CS101_ProcessImage_Events_asdus);
+    TEST_ASSERT_EQUAL_INT(M_SP_TB_1, test_CS101_ProcessImage_Events_lastType);
+
+    /* bulk update of many measured values */
+    CS101_ProcessImage bulkImage = CS101_ProcessImage_create(10);
+
+    int i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        int index = CS101_ProcessImage_addPoint(bulkImage, 1, 1000 + i, M_ME_NC_1, 0);
+
+        CS101_ProcessImage_setValue(bulkImage, index, 0.0, IEC60870_QUALITY_GOOD);
+        CS101_ProcessImage_setDeadband(bulkImage, index, CS101_DEADBAND_ABSOLUTE, 0.5);
+    }
+
+    CS101_ProcessImage_setEventHandler(bulkImage, &alParams, test_CS101_ProcessImage_Events_handler, NULL);
+
+    float values[1000];
+
+    /* every 10th value exceeds the deadband */
+    for (i = 0; i < 1000; i++)
+        values[i] = (i % 10 == 0) ? 1.0f : 0.25f;
+
+    test_CS101_ProcessImage_Events_asdus = 0;
+    test_CS101_ProcessImage_Events_elements = 0;
+
+    TEST_ASSERT_EQUAL_INT(100, CS101_ProcessImage_updateValues(bulkImage, 0, 1000, values, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(100, test_CS101_ProcessImage_Events_elements);
+    TEST_ASSERT_TRUE(test_CS101_ProcessImage_Events_asdus < 20);
+
+    /* same values again - no events */
+    TEST_ASSERT_EQUAL_INT(0, CS101_ProcessImage_updateValues(bulkImage, 0, 1000, values, NULL, NULL));
+
+    double value;
+
+    TEST_ASSERT_TRUE(CS101_ProcessImage_getValue(bulkImage, 1, &value, NULL));
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, (float)value);
+
+    TEST_ASSERT_EQUAL_INT(-1, CS101_ProcessImage_updateValues(bulkImage, 990, 20, values, NULL, NULL));
+
+    CS101_ProcessImage_destroy(bulkImage);
+    CS101_ProcessImage_destroy(image);
+}
+
+
+typedef struct
+{
+    struct sIMasterConnection iMasterConnection;
+    bool ready;
+    int actCon;
+    int actTerm;
+    int elements;
+    double sum;
+    CS101_ResponseGenerator generator;
+    CS101_ResponseFinishedHandler finishedHandler;
+    void* responseParameter;
+} test_CS101_ProcessImage_Snapshot_Connection;
+
+static struct sCS101_AppLayerParameters test_CS101_ProcessImage_Snapshot_alParams = {
+    /* .sizeOfTypeId =  */ 1,
+    /* .sizeOfVSQ = */ 1,
+    /* .sizeOfCOT = */ 2,
+    /* .originatorAddress = */ 0,
+    /* .sizeOfCA = */ 2,
+    /* .sizeOfIOA = */ 3,
+    /* .maxSizeOfASDU = */ 249
+};
+
+static bool
+test_CS101_ProcessImage_Snapshot_isReady(IMasterConnection self)
+{
+    return ((test_CS101_ProcessImage_Snapshot_Connection*)self->object)->ready;
+}
+
+static bool
+test_CS101_ProcessImage_Snapshot_sendASDU(IMasterConnection self, CS101_ASDU asdu)
+{
+    test_CS101_ProcessImage_Snapshot_Connection* con = (test_CS101_ProcessImage_Snapshot_Connection*)self->object;
+
+    int i;
+
+    for (i = 0; i < CS101_ASDU_getNumberOfElements(asdu); i++)
+    {
+        InformationObject io = CS101_ASDU_getElement(asdu, i);
+
+        if (CS101_ASDU_getTypeID(asdu) == M_ME_NB_1)
+            con->sum += MeasuredValueScaled_getValue((MeasuredValueScaled)io);
+
+        InformationObject_destroy(io);
+
+        con->elements++;
+    }
+
+    return true;
+}
+
+static bool
+test_CS101_ProcessImage_Snapshot_sendACT_CON(IMasterConnection self, CS101_ASDU asdu, bool negative)
+{
+    ((test_CS101_ProcessImage_Snapshot_Connection*)self->object)->actCon++;
+    return true;
+}
+
+static bool
+test_CS101_ProcessImage_Snapshot_sendACT_TERM(IMasterConnection self, CS101_ASDU asdu)
+{
+    ((test_CS101_ProcessImage_Snapshot_Connection*)self->object)->actTerm++;
+    return true;
+}
+
+static CS101_AppLayerParameters
+test_CS101_ProcessImage_Snapshot_getAlParams(IMasterConnection self)
+{
+    return &test_CS101_ProcessImage_Snapshot_alParams;
+}
+
+static void
+test_CS101_ProcessImage_Snapshot_init(test_CS101_ProcessImage_Snapshot_Connection* con)
+{
+    memset(con, 0, sizeof(test_CS101_ProcessImage_Snapshot_Connection));
+
+    con->iMasterConnection.isReady = test_CS101_ProcessImage_Snapshot_isReady;
+    con->iMasterConnection.sendASDU = test_CS101_ProcessImage_Snapshot_sendASDU;
+    con->iMasterConnection.sendACT_CON = test_CS101_ProcessImage_Snapshot_sendACT_CON;
+    con->iMasterConnection.sendACT_TERM = test_CS101_ProcessImage_Snapshot_sendACT_TERM;
+    con->iMasterConnection.getApplicationLayerParameters = test_CS101_ProcessImage_Snapshot_getAlParams;
+    con->iMasterConnection.object = con;
+    con->ready = true;
+}
+
+static void
+test_CS101_ProcessImage_Snapshot_interrogate(CS101_SlavePlugin plugin, test_CS101_ProcessImage_Snapshot_Connection* con)
+{
+    CS101_ASDU asdu = CS101_ASDU_create(&test_CS101_ProcessImage_Snapshot_alParams, false, CS101_COT_ACTIVATION, 0, 1,
+                                        false, false);
+
+    InformationObject io = (InformationObject)InterrogationCommand_create(NULL, 0, IEC60870_QOI_STATION);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    TEST_ASSERT_EQUAL_INT(CS101_PLUGIN_RESULT_HANDLED,
+                          plugin->handleAsdu(plugin->parameter, &(con->iMasterConnection), asdu));
+
+    CS101_ASDU_destroy(asdu);
+}
+
+void
+test_CS101_ProcessImage_Snapshot(void)
+{
+    CS101_ProcessImage image = CS101_ProcessImage_create(1000);
+
+    int i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        int index = CS101_ProcessImage_addPoint(image, 1, i + 1, M_ME_NB_1, 0);
+
+        CS101_ProcessImage_setValue(image, index, 1, IEC60870_QUALITY_GOOD);
+    }
+
+    CS101_SlavePlugin plugin = CS101_ProcessImage_getPlugin(image);
+
+    test_CS101_ProcessImage_Snapshot_Connection conA;
+    test_CS101_ProcessImage_Snapshot_Connection conB;
+    test_CS101_ProcessImage_Snapshot_Connection conC;
+
+    test_CS101_ProcessImage_Snapshot_init(&conA);
+    test_CS101_ProcessImage_Snapshot_init(&conB);
+    test_CS101_ProcessImage_Snapshot_init(&conC);
+
+    test_CS101_ProcessImage_Snapshot_interrogate(plugin, &conA);
+
+    TEST_ASSERT_EQUAL_INT(1, conA.actCon);
+
+    /* the response is sent step by step */
+    plugin->runTask(plugin->parameter, &(conA.iMasterConnection));
+
+    TEST_ASSERT_TRUE(conA.elements > 0);
+    TEST_ASSERT_TRUE(conA.elements < 1000);
+
+    /* connection not ready (e.g. k-window full) - nothing is sent */
+    int sentElements = conA.elements;
+
+    conA.ready = false;
+    plugin->runTask(plugin->parameter, &(conA.iMasterConnection));
+    TEST_ASSERT_EQUAL_INT(sentElements, conA.elements);
+    conA.ready = true;
+
+    /* value updates during the interrogation don't change the response */
+    float values[1000];
+
+    for (i = 0; i < 1000; i++)
+        values[i] = 2.f;
+
+    TEST_ASSERT_EQUAL_INT(0, CS101_ProcessImage_updateValues(image, 0, 1000, values, NULL, NULL));
+
+    /* interrogation of another connection shares the snapshot */
+    test_CS101_ProcessImage_Snapshot_interrogate(plugin, &conB);
+
+    /* no sharing -> new snapshot with the new values */
+    CS101_ProcessImage_setSnapshotSharingTime(image, 0);
+
+    test_CS101_ProcessImage_Snapshot_interrogate(plugin, &conC);
+
+    for (i = 0; i < 100; i++)
+    {
+        plugin->runTask(plugin->parameter, &(conA.iMasterConnection));
+        plugin->runTask(plugin->parameter, &(conB.iMasterConnection));
+        plugin->runTask(plugin->parameter, &(conC.iMasterConnection));
+    }
+
+    TEST_ASSERT_EQUAL_INT(1, conA.actTerm);
+    TEST_ASSERT_EQUAL_INT(1, conB.actTerm);
+    TEST_ASSERT_EQUAL_INT(1, conC.actTerm);
+
+    TEST_ASSERT_EQUAL_INT(1000, conA.elements);
+    TEST_ASSERT_EQUAL_INT(1000, conB.elements);
+    TEST_ASSERT_EQUAL_INT(1000, conC.elements);
+
+    TEST_ASSERT_EQUAL_INT(1000, (int)conA.sum);
+    TEST_ASSERT_EQUAL_INT(1000, (int)conB.sum);
+    TEST_ASSERT_EQUAL_INT(2000, (int)conC.sum);
+
+    CS101_ProcessImage_destroy(image);
+}
+
+
+static bool
+test_CS101_ProcessImage_Stream_startResponse(IMasterConnection self, CS101_ASDU command, CS101_ResponseGenerator generator,
+                                             CS101_ResponseFinishedHandler finishedHandler, void* parameter)
+{
+    test_CS101_ProcessImage_Snapshot_Connection* con = (test_CS101_ProcessImage_Snapshot_Connection*)self->object;
+
+    (void) command;
+
+    con->generator = generator;
+    con->finishedHandler = finishedHandler;
+    con->responseParameter = parameter;
+
+    return true;
+}
+
+/* pull up to maxAsdus ASDUs of the streamed response (the finished handler is called when the response is complete) */
+static int
+test_CS101_ProcessImage_Stream_pull(test_CS101_ProcessImage_Snapshot_Connection* con, int maxAsdus)
+{
+    sCS101_StaticASDU buffer;
+
+    int asdus = 0;
+
+    while (con->generator && (asdus < maxAsdus))
+    {
+        CS101_ASDU asdu = con->generator(con->responseParameter, &(con->iMasterConnection), &buffer);
+
+        if (asdu == NULL)
+        {
+            con->generator = NULL;
+            con->finishedHandler(con->responseParameter, &(con->iMasterConnection), true);
+            break;
+        }
+
+        if (CS101_ASDU_getCOT(asdu) == CS101_COT_ACTIVATION_TERMINATION)
+            con->actTerm++;
+        else
+            test_CS101_ProcessImage_Snapshot_sendASDU(&(con->iMasterConnection), asdu);
+
+        asdus++;
+    }
+
+    return asdus;
+}
+
+static void
+test_CS101_ProcessImage_Stream_command(CS101_SlavePlugin plugin, test_CS101_ProcessImage_Snapshot_Connection* con,
+                                       CS101_CauseOfTransmission cot)
+{
+    CS101_ASDU asdu = CS101_ASDU_create(&test_CS101_ProcessImage_Snapshot_alParams, false, cot, 0, 1, false, false);
+
+    InformationObject io = (InformationObject)InterrogationCommand_create(NULL, 0, IEC60870_QOI_STATION);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    TEST_ASSERT_EQUAL_INT(CS101_PLUGIN_RESULT_HANDLED,
+                          plugin->handleAsdu(plugin->parameter, &(con->iMasterConnection), asdu));
+
+    CS101_ASDU_destroy(asdu);
+}
+
+void
+test_CS101_ProcessImage_StreamedResponse(void)
+{
+    CS101_ProcessImage image = CS101_ProcessImage_create(1000);
+
+    int i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        int index = CS101_ProcessImage_addPoint(image, 1, i + 1, M_ME_NB_1, 0);
+
+        CS101_ProcessImage_setValue(image, index, 1, IEC60870_QUALITY_GOOD);
+    }
+
+    CS101_SlavePlugin plugin = CS101_ProcessImage_getPlugin(image);
+
+    test_CS101_ProcessImage_Snapshot_Connection con;
+
+    test_CS101_ProcessImage_Snapshot_init(&con);
+
+    con.iMasterConnection.startResponse = test_CS101_ProcessImage_Stream_startResponse;
+
+    test_CS101_ProcessImage_Stream_command(plugin, &con, CS101_COT_ACTIVATION);
+
+    TEST_ASSERT_EQUAL_INT(1, con.actCon);
+    TEST_ASSERT_NOT_NULL(con.generator);
+
+    /* the response is created by the connection - not by the plugin task */
+    plugin->runTask(plugin->parameter, &(con.iMasterConnection));
+
+    TEST_ASSERT_EQUAL_INT(0, con.elements);
+
+    test_CS101_ProcessImage_Stream_pull(&con, 1000);
+
+    TEST_ASSERT_NULL(con.generator);
+    TEST_ASSERT_EQUAL_INT(1000, con.elements);
+    TEST_ASSERT_EQUAL_INT(1000, (int)con.sum);
+    TEST_ASSERT_EQUAL_INT(1, con.actTerm);
+
+    /* deactivation stops the running response */
+    test_CS101_ProcessImage_Stream_command(plugin, &con, CS101_COT_ACTIVATION);
+
+    TEST_ASSERT_EQUAL_INT(2, test_CS101_ProcessImage_Stream_pull(&con, 2));
+
+    test_CS101_ProcessImage_Stream_command(plugin, &con, CS101_COT_DEACTIVATION);
+
+    TEST_ASSERT_EQUAL_INT(0, test_CS101_ProcessImage_Stream_pull(&con, 1000));
+    TEST_ASSERT_NULL(con.generator);
+    TEST_ASSERT_EQUAL_INT(1, con.actTerm);
+
+    /* restart - the job is sent as a new streamed response */
+    con.elements = 0;
+
+    test_CS101_ProcessImage_Stream_command(plugin, &con, CS101_COT_ACTIVATION);
+
+    TEST_ASSERT_NOT_NULL(con.generator);
+
+    test_CS101_ProcessImage_Stream_pull(&con, 1000);
+
+    TEST_ASSERT_EQUAL_INT(1000, con.elements);
+    TEST_ASSERT_EQUAL_INT(2, con.actTerm);
+
+    CS101_ProcessImage_destroy(image);
+}
+
+
+struct stest_CS104Slave_StreamedResponse {
+    int nextIoa;
+    int numberOfPoints;
+    int finishedCalls;
+    bool completed;
+
+    int elementsReceived;
+    int actConReceived;
+    int actTermReceived;
+    int lastIoa;
+    bool orderOk;
+};
+
+static CS101_ASDU
+test_CS104Slave_StreamedResponse_generator(void* parameter, IMasterConnection connection, CS101_StaticASDU buffer)
+{
+    struct stest_CS104Slave_StreamedResponse* info = (struct stest_CS104Slave_StreamedResponse*) parameter;
+
+    if (info->nextIoa > info->numberOfPoints)
+        return NULL;
+
+    CS101_ASDU asdu = CS101_ASDU_initializeStatic(buffer, IMasterConnection_getApplicationLayerParameters(connection),
+            false, CS101_COT_INTERROGATED_BY_STATION, 0, 1, false, false);
+
+    int i;
+
+    for (i = 0; (i < 10) && (info->nextIoa <= info->numberOfPoints); i++) {
+        uint8_t ioBuf[250];
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create((MeasuredValueScaled) ioBuf, info->nextIoa, i, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(asdu, io);
+
+        info->nextIoa++;
+    }
+
+    return asdu;
+}
+
+static void
+test_CS104Slave_StreamedResponse_finished(void* parameter, IMasterConnection connection, bool completed)
+{
+    struct stest_CS104Slave_StreamedResponse* info = (struct stest_CS104Slave_StreamedResponse*) parameter;
+
+    info->finishedCalls++;
+    info->completed = completed;
+}
+
+static bool
+test_CS104Slave_StreamedResponse_interrogationHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, uint8_t qoi)
+{
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+
+    return IMasterConnection_startResponse(connection, asdu, test_CS104Slave_StreamedResponse_generator,
+            test_CS104Slave_StreamedResponse_finished, parameter);
+}
+
+static bool
+test_CS104Slave_StreamedResponse_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    struct stest_CS104Slave_StreamedResponse* info = (struct stest_CS104Slave_StreamedResponse*) parameter;
+
+    CS101_CauseOfTransmission cot = CS101_ASDU_getCOT(asdu);
+
+    if (cot == CS101_COT_ACTIVATION_CON)
+        info->actConReceived++;
+    else if (cot == CS101_COT_ACTIVATION_TERMINATION) {
+        /* ACT_TERM has to be sent after the last element */
+        if (info->elementsReceived != info->numberOfPoints)
+            info->orderOk = false;
+
+        info->actTermReceived++;
+    }
+    else if (cot == CS101_COT_INTERROGATED_BY_STATION) {
+        int i;
+
+        for (i = 0; i < CS101_ASDU_getNumberOfElements(asdu); i++) {
+            uint8_t ioBuf[250];
+
+            InformationObject io = CS101_ASDU_getElementEx(asdu, (InformationObject) ioBuf, i);
+
+            if (InformationObject_getObjectAddress(io) != info->lastIoa + 1)
+                info->orderOk = false;
+
+            info->lastIoa = InformationObject_getObjectAddress(io);
+            info->elementsReceived++;
+        }
+    }
+
+    return true;
+}
+
+void
+test_CS104Slave_StreamedResponse(void)
+{
+    struct stest_CS104Slave_StreamedResponse info;
+    memset(&info, 0, sizeof(info));
+
+    info.nextIoa = 1;
+    info.numberOfPoints = 1000;
+    info.orderOk = true;
+
+    /* the high priority queue is much smaller than the response (100 ASDUs) */
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setInterrogationHandler(slave, test_CS104Slave_StreamedResponse_interrogationHandler, &info);
+
+    CS104_Slave_start(slave);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104Slave_StreamedResponse_asduReceivedHandler, &info);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    Thread_sleep(100);
+
+    CS104_Connection_sendInterrogationCommand(con, CS101_COT_ACTIVATION, 1, IEC60870_QOI_STATION);
+
+    int waitTime = 0;
+
+    while ((info.actTermReceived == 0) && (waitTime < 5000)) {
+        Thread_sleep(10);
+        waitTime += 10;
+    }
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    TEST_ASSERT_EQUAL_INT(1, info.actConReceived);
+    TEST_ASSERT_EQUAL_INT(1, info.actTermReceived);
+    TEST_ASSERT_EQUAL_INT(1000, info.elementsReceived);
+    TEST_ASSERT_TRUE(info.orderOk);
+    TEST_ASSERT_EQUAL_INT(1, info.finishedCalls);
+    TEST_ASSERT_TRUE(info.completed);
+}
+
+struct stest_CS104Slave_StreamedResponseAbort {
+    int finishedCalls;
+    bool completed;
+    int asdusCreated;
+};
+
+static CS101_ASDU
+test_CS104Slave_StreamedResponseAbort_generator(void* parameter, IMasterConnection connection, CS101_StaticASDU buffer)
+{
+    struct stest_CS104Slave_StreamedResponseAbort* info = (struct stest_CS104Slave_StreamedResponseAbort*) parameter;
+
+    CS101_ASDU asdu = CS101_ASDU_initializeStatic(buffer, IMasterConnection_getApplicationLayerParameters(connection),
+            false, CS101_COT_INTERROGATED_BY_STATION, 0, 1, false, false);
+
+    uint8_t ioBuf[250];
+
+    InformationObject io = (InformationObject) SinglePointInformation_create((SinglePointInformation) ioBuf, 100, true, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    info->asdusCreated++;
+
+    /* endless response */
+    return asdu;
+}
+
+static void
+test_CS104Slave_StreamedResponseAbort_finished(void* parameter, IMasterConnection connection, bool completed)
+{
+    struct stest_CS104Slave_StreamedResponseAbort* info = (struct stest_CS104Slave_StreamedResponseAbort*) parameter;
+
+    info->finishedCalls++;
+    info->completed = completed;
+}
+
+static bool
+test_CS104Slave_StreamedResponseAbort_interrogationHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, uint8_t qoi)
+{
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+
+    return IMasterConnection_startResponse(connection, asdu, test_CS104Slave_StreamedResponseAbort_generator,
+            test_CS104Slave_StreamedResponseAbort_finished, parameter);
+}
+
+static bool
+test_CS104Slave_StreamedResponseAbort_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    return true;
+}
+
+void
+test_CS104Slave_StreamedResponseAbort(void)
+{
+    struct stest_CS104Slave_StreamedResponseAbort info;
+    memset(&info, 0, sizeof(info));
+
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setInterrogationHandler(slave, test_CS104Slave_StreamedResponseAbort_interrogationHandler, &info);
+
+    CS104_Slave_start(slave);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104Slave_StreamedResponseAbort_asduReceivedHandler, NULL);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    Thread_sleep(100);
+
+    CS104_Connection_sendInterrogationCommand(con, CS101_COT_ACTIVATION, 1, IEC60870_QOI_STATION);
+
+    Thread_sleep(200);
+
+    TEST_ASSERT_TRUE(info.asdusCreated > 0);
+    TEST_ASSERT_EQUAL_INT(0, info.finishedCalls);
+
+    CS104_Connection_destroy(con);
+
+    int waitTime = 0;
+
+    while ((info.finishedCalls == 0) && (waitTime < 2000)) {
+        Thread_sleep(10);
+        waitTime += 10;
+    }
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    TEST_ASSERT_EQUAL_INT(1, info.finishedCalls);
+    TEST_ASSERT_FALSE(info.completed);
+}
+
+
+#ifndef _WIN32
+struct stest_CS104Slave_EventLoop {
+    int asdusReceived;
+};
+
+static bool
+test_CS104Slave_EventLoop_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    struct stest_CS104Slave_EventLoop* info = (struct stest_CS104Slave_EventLoop*) parameter;
+
+    if (CS101_ASDU_getCOT(asdu) == CS101_COT_SPONTANEOUS)
+        info->asdusReceived++;
+
+    return true;
+}
+
+/* run one iteration of the event loop and return the number of server fds */
+static int
+test_CS104Slave_EventLoop_run(CS104_Slave slave, int maxTimeout)
+{
+    int fds[10];
+    struct pollfd pollFds[10];
+
+    int numberOfFds = CS104_Slave_getPollFds(slave, fds, 10);
+
+    int i;
+
+    for (i = 0; i < numberOfFds; i++) {
+        pollFds[i].fd = fds[i];
+        pollFds[i].events = POLLIN;
+        pollFds[i].revents = 0;
+    }
+
+    if (poll(pollFds, numberOfFds, CS104_Slave_getNextTimeoutMs(slave, maxTimeout)) > 0) {
+        for (i = 0; i < numberOfFds; i++) {
+            if (pollFds[i].revents & POLLIN)
+                CS104_Slave_handleReady(slave, pollFds[i].fd, CS104_SLAVE_FD_READABLE);
+            else if (pollFds[i].revents)
+                CS104_Slave_handleReady(slave, pollFds[i].fd, CS104_SLAVE_FD_ERROR);
+        }
+    }
+
+    CS104_Slave_executePeriodicTasks(slave);
+
+    return numberOfFds;
+}
+#endif
+
+void
+test_CS104Slave_EventLoop(void)
+{
+#ifndef _WIN32
+    struct stest_CS104Slave_EventLoop info;
+    info.asdusReceived = 0;
+
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+
+    int fds[10];
+
+    TEST_ASSERT_EQUAL_INT(0, CS104_Slave_getPollFds(slave, fds, 10));
+
+    CS104_Slave_startThreadless(slave);
+
+    TEST_ASSERT_TRUE(CS104_Slave_isRunning(slave));
+
+    /* only the server socket and the wakeup fd - no deadline */
+    TEST_ASSERT_EQUAL_INT(2, CS104_Slave_getPollFds(slave, fds, 10));
+    TEST_ASSERT_EQUAL_INT(1000, CS104_Slave_getNextTimeoutMs(slave, 1000));
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104Slave_EventLoop_asduReceivedHandler, &info);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    int i;
+
+    for (i = 0; i < 20; i++)
+        test_CS104Slave_EventLoop_run(slave, 10);
+
+    TEST_ASSERT_EQUAL_INT(3, CS104_Slave_getPollFds(slave, fds, 10));
+
+    /* only the T3 timeout is pending */
+    int timeout = CS104_Slave_getNextTimeoutMs(slave, 100000);
+    TEST_ASSERT_TRUE(timeout > 15000);
+    TEST_ASSERT_TRUE(timeout <= 20001);
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    CS101_ASDU asdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 110, 1, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    CS104_Slave_enqueueASDU(slave, asdu);
+
+    CS101_ASDU_destroy(asdu);
+
+    /* the enqueued ASDU has to be sent immediately */
+    TEST_ASSERT_EQUAL_INT(0, CS104_Slave_getNextTimeoutMs(slave, 1000));
+
+    for (i = 0; (i < 100) && (info.asdusReceived == 0); i++)
+        test_CS104Slave_EventLoop_run(slave, 10);
+
+    TEST_ASSERT_EQUAL_INT(1, info.asdusReceived);
+
+    /* the I message is not yet confirmed by the client -> t1 */
+    timeout = CS104_Slave_getNextTimeoutMs(slave, 100000);
+    TEST_ASSERT_TRUE(timeout > 0);
+    TEST_ASSERT_TRUE(timeout <= 15000);
+
+    CS104_Connection_destroy(con);
+
+    for (i = 0; (i < 100) && (CS104_Slave_getPollFds(slave, fds, 10) > 2); i++)
+        test_CS104Slave_EventLoop_run(slave, 10);
+
+    TEST_ASSERT_EQUAL_INT(2, CS104_Slave_getPollFds(slave, fds, 10));
+    TEST_ASSERT_EQUAL_INT(0, CS104_Slave_getOpenConnections(slave));
+
+    CS104_Slave_stopThreadless(slave);
+
+    CS104_Slave_destroy(slave);
+#endif
+}
+
+#ifndef _WIN32
+static void*
+test_CS104Slave_EventLoopWakeup_enqueueThread(void* parameter)
+{
+    CS104_Slave slave = (CS104_Slave) parameter;
+
+    Thread_sleep(100);
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    CS101_ASDU asdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 110, 1, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(asdu, io);
+
+    InformationObject_destroy(io);
+
+    CS104_Slave_enqueueASDU(slave, asdu);
+
+    CS101_ASDU_destroy(asdu);
+
+    return NULL;
+}
+#endif
+
+void
+test_CS104Slave_EventLoopWakeup(void)
+{
+#ifndef _WIN32
+    struct stest_CS104Slave_EventLoop info;
+    info.asdusReceived = 0;
+
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+
+    CS104_Slave_startThreadless(slave);
+
+    TEST_ASSERT_TRUE(CS104_Slave_isRunning(slave));
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104Slave_EventLoop_asduReceivedHandler, &info);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    int i;
+
+    for (i = 0; i < 20; i++)
+        test_CS104Slave_EventLoop_run(slave, 10);
+
+    /* the event loop waits up to 10 s - the enqueued ASDU has to wake it up */
+    Thread thread = Thread_create(test_CS104Slave_EventLoopWakeup_enqueueThread, slave, false);
+
+    Thread_start(thread);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    for (i = 0; (i < 10) && (info.asdusReceived == 0); i++) {
+        test_CS104Slave_EventLoop_run(slave, 10000);
+
+        /* the ASDU is received by the connection thread of the client */
+        Thread_sleep(50);
+    }
+
+    uint64_t duration = Hal_getMonotonicTimeInMs() - startTime;
+
+    Thread_destroy(thread);
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stopThreadless(slave);
+
+    CS104_Slave_destroy(slave);
+
+    TEST_ASSERT_EQUAL_INT(1, info.asdusReceived);
+    TEST_ASSERT_TRUE(duration < 2000);
+#endif
+}
+
+#ifndef _WIN32
+static IMasterConnection test_CS104Slave_EventLoopPending_connection = NULL;
+
+static void
+test_CS104Slave_EventLoopPending_connectionEventHandler(void* parameter, IMasterConnection connection,
+                                                        CS104_PeerConnectionEvent event)
+{
+    (void) parameter;
+
+    if (event == CS104_CON_EVENT_CONNECTION_OPENED)
+        test_CS104Slave_EventLoopPending_connection = connection;
+}
+
+static void*
+test_CS104Slave_EventLoopPending_closeThread(void* parameter)
+{
+    (void) parameter;
+
+    Thread_sleep(100);
+
+    IMasterConnection_close(test_CS104Slave_EventLoopPending_connection);
+
+    return NULL;
+}
+#endif
+
+void
+test_CS104Slave_EventLoopPendingConnections(void)
+{
+#ifndef _WIN32
+    struct stest_CS104Slave_EventLoop info;
+    info.asdusReceived = 0;
+
+    test_CS104Slave_EventLoopPending_connection = NULL;
+
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setConnectionEventHandler(slave, test_CS104Slave_EventLoopPending_connectionEventHandler, NULL);
+
+    CS104_Slave_startThreadless(slave);
+
+    TEST_ASSERT_TRUE(CS104_Slave_isRunning(slave));
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104Slave_EventLoop_asduReceivedHandler, &info);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    int i;
+
+    for (i = 0; i < 20; i++)
+        test_CS104Slave_EventLoop_run(slave, 10);
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    for (i = 0; i < 5; i++) {
+        CS101_ASDU asdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 110, i, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(asdu, io);
+
+        InformationObject_destroy(io);
+
+        CS104_Slave_enqueueASDU(slave, asdu);
+
+        CS101_ASDU_destroy(asdu);
+    }
+
+    /* only one low priority ASDU is sent per iteration - the connection stays pending until all are sent */
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    for (i = 0; (i < 50) && (info.asdusReceived < 5); i++) {
+        test_CS104Slave_EventLoop_run(slave, 10000);
+
+        Thread_sleep(10);
+    }
+
+    uint64_t sendDuration = Hal_getMonotonicTimeInMs() - startTime;
+
+    /* a connection closed by another thread is released without waiting for the next timeout */
+    Thread thread = Thread_create(test_CS104Slave_EventLoopPending_closeThread, NULL, false);
+
+    if (test_CS104Slave_EventLoopPending_connection)
+        Thread_start(thread);
+
+    startTime = Hal_getMonotonicTimeInMs();
+
+    for (i = 0; (i < 10) && test_CS104Slave_EventLoopPending_connection && (CS104_Slave_getOpenConnections(slave) > 0); i++)
+        test_CS104Slave_EventLoop_run(slave, 10000);
+
+    uint64_t closeDuration = Hal_getMonotonicTimeInMs() - startTime;
+
+    Thread_destroy(thread);
+
+    int openConnections = CS104_Slave_getOpenConnections(slave);
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stopThreadless(slave);
+
+    CS104_Slave_destroy(slave);
+
+    TEST_ASSERT_EQUAL_INT(5, info.asdusReceived);
+    TEST_ASSERT_TRUE(sendDuration < 2000);
+    TEST_ASSERT_NOT_NULL(test_CS104Slave_EventLoopPending_connection);
+    TEST_ASSERT_EQUAL_INT(0, openConnections);
+    TEST_ASSERT_TRUE(closeDuration < 2000);
+#endif
+}
+
+
+#ifndef _WIN32
+static void
+test_CS104Slave_EventLoopTimeouts_rawMessageHandler(void* parameter, IMasterConnection connection, uint8_t* msg,
+                                                    int msgSize, bool sent)
+{
+    int* testFrActSent = (int*) parameter;
+
+    if (sent && (msgSize == 6) && (msg[2] == 0x43))
+        (*testFrActSent)++;
+}
+#endif
+
+void
+test_CS104Slave_EventLoopTimeouts(void)
+{
+#ifndef _WIN32
+    int testFrActSent = 0;
+
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+
+    CS104_APCIParameters apciParams = CS104_Slave_getConnectionParameters(slave);
+    apciParams->t3 = 1;
+
+    CS104_Slave_setRawMessageHandler(slave, test_CS104Slave_EventLoopTimeouts_rawMessageHandler, &testFrActSent);
+
+    CS104_Slave_startThreadless(slave);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    int iterations = 0;
+
+    /* the server sleeps until t3 expires (no polling) */
+    while ((testFrActSent < 2) && (Hal_getMonotonicTimeInMs() < startTime + 5000)) {
+        test_CS104Slave_EventLoop_run(slave, 1000);
+        iterations++;
+    }
+
+    TEST_ASSERT_EQUAL_INT(2, testFrActSent);
+    TEST_ASSERT_TRUE(iterations < 50);
+
+    uint64_t duration = Hal_getMonotonicTimeInMs() - startTime;
+    TEST_ASSERT_TRUE(duration >= 2000);
+    TEST_ASSERT_TRUE(duration < 3000);
+
+    /* the client confirmed the TESTFR ACT messages */
+    TEST_ASSERT_EQUAL_INT(1, CS104_Slave_getOpenConnections(slave));
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stopThreadless(slave);
+
+    CS104_Slave_destroy(slave);
+#endif
+}
+
+
+struct stest_CS104Slave_RawMessageHandlerLock {
+    int testFrActSent;
+    int stopDtConSent;
+    int notReady;
+};
+
+static void
+test_CS104Slave_RawMessageHandlerLock_rawMessageHandler(void* parameter, IMasterConnection connection, uint8_t* msg,
+                                                        int msgSize, bool sent)
+{
+    struct stest_CS104Slave_RawMessageHandlerLock* info = (struct stest_CS104Slave_RawMessageHandlerLock*) parameter;
+
+    if (sent && (msgSize == 6)) {
+
+        /* TESTFR ACT and STOPDT CON are sent without the connection lock -> must not block */
+        if (msg[2] == 0x43) {
+            IMasterConnection_isReady(connection);
+            info->testFrActSent++;
+        }
+        else if (msg[2] == 0x23) {
+            if (IMasterConnection_isReady(connection) == false)
+                info->notReady++;
+
+            info->stopDtConSent++;
+        }
+    }
+}
+
+void
+test_CS104Slave_RawMessageHandlerLock(void)
+{
+    struct stest_CS104Slave_RawMessageHandlerLock info;
+    info.testFrActSent = 0;
+    info.stopDtConSent = 0;
+    info.notReady = 0;
+
+    CS104_Slave slave = CS104_Slave_create(10, 10);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+
+    CS104_APCIParameters apciParams = CS104_Slave_getConnectionParameters(slave);
+    apciParams->t3 = 1;
+
+    CS104_Slave_setRawMessageHandler(slave, test_CS104Slave_RawMessageHandlerLock_rawMessageHandler, &info);
+
+    CS104_Slave_start(slave);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    while ((info.testFrActSent < 1) && (Hal_getMonotonicTimeInMs() < startTime + 3000))
+        Thread_sleep(10);
+
+    TEST_ASSERT_EQUAL_INT(1, info.testFrActSent);
+
+    CS104_Connection_sendStopDT(con);
+
+    startTime = Hal_getMonotonicTimeInMs();
+
+    while ((info.stopDtConSent < 1) && (Hal_getMonotonicTimeInMs() < startTime + 1000))
+        Thread_sleep(10);
+
+    TEST_ASSERT_EQUAL_INT(1, info.stopDtConSent);
+    TEST_ASSERT_EQUAL_INT(1, info.notReady);
+
+    /* the connection is still served after the STOPDT */
+    TEST_ASSERT_EQUAL_INT(1, CS104_Slave_getOpenConnections(slave));
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stop(slave);
+
+    CS104_Slave_destroy(slave);
+}
+
+struct stest_CS104Slave_ConcurrentSend {
+    bool running;
+    int sent;
+    int toSend;
+    IMasterConnection connection;
+    CS104_Slave slave;
+    int activated;
+    int enqueuedReceived;
+    int directReceived;
+    int outOfOrder;
+    int lastEnqueuedValue;
+};
+
+static void
+test_CS104Slave_ConcurrentSend_connectionEventHandler(void* parameter, IMasterConnection connection, CS104_PeerConnectionEvent event)
+{
+    struct stest_CS104Slave_ConcurrentSend* info = (struct stest_CS104Slave_ConcurrentSend*) parameter;
+
+    if (event == CS104_CON_EVENT_ACTIVATED) {
+        info->connection = connection;
+        info->activated++;
+    }
+}
+
+static void*
+test_CS104Slave_ConcurrentSend_sendThreadFunction(void* parameter)
+{
+    struct stest_CS104Slave_ConcurrentSend* info = (struct stest_CS104Slave_ConcurrentSend*) parameter;
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(info->slave);
+
+    while (info->running && (info->sent < info->toSend)) {
+
+        /* sent directly -> shares the k-buffer with the connection thread */
+        CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_REQUEST, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 200, (int16_t) info->sent, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(newAsdu, io);
+
+        InformationObject_destroy(io);
+
+        if (IMasterConnection_isReady(info->connection) && IMasterConnection_sendASDU(info->connection, newAsdu))
+            info->sent++;
+        else
+            Thread_sleep(1);
+
+        CS101_ASDU_destroy(newAsdu);
+    }
+
+    return NULL;
+}
+
+static bool
+test_CS104Slave_ConcurrentSend_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    struct stest_CS104Slave_ConcurrentSend* info = (struct stest_CS104Slave_ConcurrentSend*) parameter;
+
+    if (CS101_ASDU_getTypeID(asdu) == M_ME_NB_1) {
+        uint8_t ioBuf[250];
+
+        MeasuredValueScaled mv = (MeasuredValueScaled) CS101_ASDU_getElementEx(asdu, (InformationObject) ioBuf, 0);
+
+        if (InformationObject_getObjectAddress((InformationObject) mv) == 100) {
+            int value = MeasuredValueScaled_getValue(mv);
+
+            if (value != info->lastEnqueuedValue + 1)
+                info->outOfOrder++;
+
+            info->lastEnqueuedValue = value;
+            info->enqueuedReceived++;
+        }
+        else if (InformationObject_getObjectAddress((InformationObject) mv) == 200) {
+            info->directReceived++;
+        }
+    }
+
+    return true;
+}
+
+void
+test_CS104Slave_ConcurrentSend(void)
+{
+    struct stest_CS104Slave_ConcurrentSend info;
+    info.running = true;
+    info.sent = 0;
+    info.toSend = 300;
+    info.connection = NULL;
+    info.activated = 0;
+    info.enqueuedReceived = 0;
+    info.directReceived = 0;
+    info.outOfOrder = 0;
+    info.lastEnqueuedValue = -1;
+
+    CS104_Slave slave = CS104_Slave_create(1000, 1000);
+
+    info.slave = slave;
+
+    CS104_Slave_setLocalPort(slave, 20004);
+
+    CS104_Slave_setConnectionEventHandler(slave, test_CS104Slave_ConcurrentSend_connectionEventHandler, &info);
+
+    CS104_Slave_start(slave);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104Slave_ConcurrentSend_asduReceivedHandler, &info);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    while ((info.activated < 1) && (Hal_getMonotonicTimeInMs() < startTime + 1000))
+        Thread_sleep(1);
+
+    TEST_ASSERT_EQUAL_INT(1, info.activated);
+
+    Thread sendThread = Thread_create(test_CS104Slave_ConcurrentSend_sendThreadFunction, &info, false);
+    Thread_start(sendThread);
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    int i;
+
+    for (i = 0; i < 300; i++) {
+        CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 100, (int16_t) i, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(newAsdu, io);
+
+        InformationObject_destroy(io);
+
+        CS104_Slave_enqueueASDU(slave, newAsdu);
+
+        CS101_ASDU_destroy(newAsdu);
+
+        if (i % 10 == 0)
+            Thread_sleep(1);
+    }
+
+    startTime = Hal_getMonotonicTimeInMs();
+
+    while (((info.enqueuedReceived < 300) || (info.directReceived < 300)) &&
+           (Hal_getMonotonicTimeInMs() < startTime + 10000))
+        Thread_sleep(10);
+
+    info.running = false;
+    Thread_destroy(sendThread);
+
+    TEST_ASSERT_EQUAL_INT(300, info.enqueuedReceived);
+    TEST_ASSERT_EQUAL_INT(300, info.directReceived);
+    TEST_ASSERT_EQUAL_INT(0, info.outOfOrder);
+
+    /* a sequence number error would have closed the connection */
+    TEST_ASSERT_EQUAL_INT(1, CS104_Slave_getOpenConnections(slave));
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stop(slave);
+
+    CS104_Slave_destroy(slave);
+}
+
+static bool
+test_CS104Slave_StopDtCycles_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    int* received = (int*) parameter;
+
+    if (CS101_ASDU_getTypeID(asdu) == M_ME_NB_1)
+        (*received)++;
+
+    return true;
+}
+
+void
+test_CS104Slave_StopDtCycles(void)
+{
+    int received = 0;
+
+    CS104_Slave slave = CS104_Slave_create(1000, 1000);
+
+    CS104_Slave_setLocalPort(slave, 20004);
+
+    CS104_Slave_start(slave);
+
+    struct test_CS104SlaveConnectionIsRedundancyGroup_Info info;
+    info.running = true;
+    info.slave = slave;
+
+    /* events are enqueued while the client repeatedly stops and starts data transfer */
+    Thread enqueueThread = Thread_create(test_CS104SlaveConnectionIsRedundancyGroup_enqueueThreadFunction, &info, false);
+    Thread_start(enqueueThread);
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104Slave_StopDtCycles_asduReceivedHandler, &received);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    int i;
+
+    for (i = 0; i < 20; i++) {
+        CS104_Connection_sendStartDT(con);
+
+        Thread_sleep(20);
+
+        CS104_Connection_sendStopDT(con);
+
+        Thread_sleep(5);
+    }
+
+    info.running = false;
+    Thread_destroy(enqueueThread);
+
+    /* events that are still in the queue are sent after the last STARTDT */
+    CS104_Connection_sendStartDT(con);
+
+    Thread_sleep(200);
+
+    TEST_ASSERT_TRUE(received > 0);
+
+    /* STOPDT ACT did not unbalance the connection lock or close the connection */
+    TEST_ASSERT_EQUAL_INT(1, CS104_Slave_getOpenConnections(slave));
+
+    CS104_Connection_destroy(con);
+
+    CS104_Slave_stop(slave);
+
+    CS104_Slave_destroy(slave);
+}
+
+
+struct stest_CS104Slave_WorkerThreads {
+    Semaphore lock;
+    int openedEvents;
+    int closedEvents;
+};
+
+static void
+test_CS104Slave_WorkerThreads_connectionEventHandler(void* parameter, IMasterConnection connection, CS104_PeerConnectionEvent event)
+{
+    struct stest_CS104Slave_WorkerThreads* info = (struct stest_CS104Slave_WorkerThreads*) parameter;
+
+    Semaphore_wait(info->lock);
+
+    if (event == CS104_CON_EVENT_CONNECTION_OPENED)
+        info->openedEvents++;
+    else if (event == CS104_CON_EVENT_CONNECTION_CLOSED)
+        info->closedEvents++;
+
+    Semaphore_post(info->lock);
+}
+
+static bool
+test_CS104Slave_WorkerThreads_asduReceivedHandler(void* parameter, int address, CS101_ASDU asdu)
+{
+    int* received = (int*) parameter;
+
+    if (CS101_ASDU_getTypeID(asdu) == M_ME_NB_1)
+        (*received)++;
+
+    return true;
+}
+
+void
+test_CS104Slave_WorkerThreads(void)
+{
+    struct stest_CS104Slave_WorkerThreads info;
+    info.lock = Semaphore_create(1);
+    info.openedEvents = 0;
+    info.closedEvents = 0;
+
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    CS104_Slave_setServerMode(slave, CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP);
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setConnectionEventHandler(slave, test_CS104Slave_WorkerThreads_connectionEventHandler, &info);
+
+    CS104_Slave_setWorkerThreads(slave, 2);
+
+    TEST_ASSERT_TRUE(CS104_Slave_setWorkerAffinity(slave, 0, 0));
+    TEST_ASSERT_TRUE(CS104_Slave_setWorkerAffinity(slave, 1, -1));
+    TEST_ASSERT_FALSE(CS104_Slave_setWorkerAffinity(slave, 2, 0));
+
+    CS104_Slave_start(slave);
+
+    TEST_ASSERT_TRUE(CS104_Slave_isRunning(slave));
+
+    CS104_Connection cons[4];
+    int received[4];
+
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        received[i] = 0;
+
+        cons[i] = CS104_Connection_create("127.0.0.1", 20004);
+        CS104_Connection_setASDUReceivedHandler(cons[i], test_CS104Slave_WorkerThreads_asduReceivedHandler, &(received[i]));
+
+        TEST_ASSERT_TRUE(CS104_Connection_connect(cons[i]));
+
+        CS104_Connection_sendStartDT(cons[i]);
+    }
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    while ((CS104_Slave_getOpenConnections(slave) < 4) && (Hal_getMonotonicTimeInMs() < startTime + 2000))
+        Thread_sleep(10);
+
+    TEST_ASSERT_EQUAL_INT(4, CS104_Slave_getOpenConnections(slave));
+
+    /* wait until all connections are activated */
+    Thread_sleep(100);
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    for (i = 0; i < 20; i++) {
+        CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 110, i, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(newAsdu, io);
+
+        InformationObject_destroy(io);
+
+        CS104_Slave_enqueueASDU(slave, newAsdu);
+
+        CS101_ASDU_destroy(newAsdu);
+    }
+
+    startTime = Hal_getMonotonicTimeInMs();
+
+    while (((received[0] + received[1] + received[2] + received[3]) < 80) && (Hal_getMonotonicTimeInMs() < startTime + 2000))
+        Thread_sleep(10);
+
+    /* every connection has its own queue */
+    for (i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_INT(20, received[i]);
+
+    /* closed connections are released by the workers */
+    CS104_Connection_destroy(cons[0]);
+    CS104_Connection_destroy(cons[1]);
+
+    startTime = Hal_getMonotonicTimeInMs();
+
+    while ((CS104_Slave_getOpenConnections(slave) > 2) && (Hal_getMonotonicTimeInMs() < startTime + 2000))
+        Thread_sleep(10);
+
+    TEST_ASSERT_EQUAL_INT(2, CS104_Slave_getOpenConnections(slave));
+
+    /* the remaining connections are closed when the slave is stopped */
+    CS104_Slave_stop(slave);
+
+    TEST_ASSERT_FALSE(CS104_Slave_isRunning(slave));
+    TEST_ASSERT_EQUAL_INT(0, CS104_Slave_getOpenConnections(slave));
+    TEST_ASSERT_EQUAL_INT(4, info.openedEvents);
+    TEST_ASSERT_EQUAL_INT(4, info.closedEvents);
+
+    CS104_Connection_destroy(cons[2]);
+    CS104_Connection_destroy(cons[3]);
+
+    CS104_Slave_destroy(slave);
+
+    Semaphore_destroy(info.lock);
+}
+
+
+void
+test_CS104Slave_WorkerWakeup(void)
+{
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    CS104_Slave_setServerMode(slave, CS104_MODE_SINGLE_REDUNDANCY_GROUP);
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setWorkerThreads(slave, 1);
+
+    CS104_Slave_start(slave);
+
+    int received = 0;
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+    CS104_Connection_setASDUReceivedHandler(con, test_CS104Slave_WorkerThreads_asduReceivedHandler, &received);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(con));
+
+    CS104_Connection_sendStartDT(con);
+
+    /* the idle worker waits for the next timeout (t3 = 20 s) */
+    Thread_sleep(300);
+
+    CS101_ASDU newAsdu = CS101_ASDU_create(CS104_Slave_getAppLayerParameters(slave), false, CS101_COT_SPONTANEOUS,
+                                           0, 1, false, false);
+
+    InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 110, 1, IEC60870_QUALITY_GOOD);
+
+    CS101_ASDU_addInformationObject(newAsdu, io);
+
+    InformationObject_destroy(io);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    CS104_Slave_enqueueASDU(slave, newAsdu);
+
+    CS101_ASDU_destroy(newAsdu);
+
+    while ((received == 0) && (Hal_getMonotonicTimeInMs() < startTime + 5000))
+        Thread_sleep(1);
+
+    uint64_t deliveryTime = Hal_getMonotonicTimeInMs() - startTime;
+
+    /* the stop request wakes up the worker */
+    startTime = Hal_getMonotonicTimeInMs();
+
+    CS104_Slave_stop(slave);
+
+    uint64_t stopTime = Hal_getMonotonicTimeInMs() - startTime;
+
+    CS104_Connection_destroy(con);
+    CS104_Slave_destroy(slave);
+
+    TEST_ASSERT_EQUAL_INT(1, received);
+    TEST_ASSERT_TRUE(deliveryTime < 1000);
+    TEST_ASSERT_TRUE(stopTime < 1000);
+}
+
+
+void
+test_CS104_PrefixTable(void)
+{
+    CS104_PrefixTable table = CS104_PrefixTable_create();
+
+    int net8, net24, host, ipv6Net, first, second;
+
+    uint8_t addr10[4] = {10, 0, 0, 0};
+    uint8_t addr10_1_2[4] = {10, 1, 2, 0};
+    uint8_t addr10_1_2_3[4] = {10, 1, 2, 3};
+    uint8_t addr192[4] = {192, 168, 1, 0};
+
+    uint8_t ipv6Addr[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+
+    TEST_ASSERT_TRUE(CS104_PrefixTable_add(table, addr10, 4, 8, &net8));
+    TEST_ASSERT_TRUE(CS104_PrefixTable_add(table, addr10_1_2, 4, 24, &net24));
+    TEST_ASSERT_TRUE(CS104_PrefixTable_add(table, addr10_1_2_3, 4, 32, &host));
+    TEST_ASSERT_TRUE(CS104_PrefixTable_add(table, ipv6Addr, 16, 32, &ipv6Net));
+
+    /* the first value is kept for the same prefix */
+    TEST_ASSERT_TRUE(CS104_PrefixTable_add(table, addr192, 4, 24, &first));
+    TEST_ASSERT_TRUE(CS104_PrefixTable_add(table, addr192, 4, 24, &second));
+
+    TEST_ASSERT_FALSE(CS104_PrefixTable_add(table, addr10, 4, 33, &net8));
+    TEST_ASSERT_FALSE(CS104_PrefixTable_add(table, addr10, 6, 8, &net8));
+    TEST_ASSERT_FALSE(CS104_PrefixTable_add(table, addr10, 4, 8, NULL));
+
+    /* longest matching prefix */
+    uint8_t lookup1[4] = {10, 1, 2, 3};
+    uint8_t lookup2[4] = {10, 1, 2, 4};
+    uint8_t lookup3[4] = {10, 200, 2, 3};
+    uint8_t lookup4[4] = {11, 1, 2, 3};
+    uint8_t lookup5[4] = {192, 168, 1, 77};
+
+    TEST_ASSERT_EQUAL_PTR(&host, CS104_PrefixTable_lookup(table, lookup1, 4));
+    TEST_ASSERT_EQUAL_PTR(&net24, CS104_PrefixTable_lookup(table, lookup2, 4));
+    TEST_ASSERT_EQUAL_PTR(&net8, CS104_PrefixTable_lookup(table, lookup3, 4));
+    TEST_ASSERT_NULL(CS104_PrefixTable_lookup(table, lookup4, 4));
+    TEST_ASSERT_EQUAL_PTR(&first, CS104_PrefixTable_lookup(table, lookup5, 4));
+
+    /* IPv4 and IPv6 prefixes are separated */
+    uint8_t lookup6[16] = {0x20, 0x01, 0x0d, 0xb8, 0xff, 0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7};
+    uint8_t lookup7[16] = {10, 1, 2, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    TEST_ASSERT_EQUAL_PTR(&ipv6Net, CS104_PrefixTable_lookup(table, lookup6, 16));
+    TEST_ASSERT_NULL(CS104_PrefixTable_lookup(table, lookup7, 16));
+
+    /* a prefix of length 0 matches all addresses of the type */
+    int all;
+
+    TEST_ASSERT_TRUE(CS104_PrefixTable_add(table, addr10, 4, 0, &all));
+    TEST_ASSERT_EQUAL_PTR(&all, CS104_PrefixTable_lookup(table, lookup4, 4));
+    TEST_ASSERT_EQUAL_PTR(&host, CS104_PrefixTable_lookup(table, lookup1, 4));
+    TEST_ASSERT_NULL(CS104_PrefixTable_lookup(table, lookup7, 16));
+
+    CS104_PrefixTable_destroy(table);
+}
+
+static int
+test_CS104Slave_ListenerPerWorker_waitForQueueEntries(CS104_Slave slave, CS104_RedundancyGroup group, int entries)
+{
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    while ((CS104_Slave_getNumberOfQueueEntries(slave, group) != entries) && (Hal_getMonotonicTimeInMs() < startTime + 2000))
+        Thread_sleep(10);
+
+    return CS104_Slave_getNumberOfQueueEntries(slave, group);
+}
+
+void
+test_CS104Slave_ListenerPerWorker(void)
+{
+#ifndef _WIN32
+    struct stest_CS104Slave_WorkerThreads info;
+    info.lock = Semaphore_create(1);
+    info.openedEvents = 0;
+    info.closedEvents = 0;
+
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    CS104_Slave_setServerMode(slave, CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS);
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setConnectionEventHandler(slave, test_CS104Slave_WorkerThreads_connectionEventHandler, &info);
+
+    /* the network group is added first - the host group has the longer prefix */
+    CS104_RedundancyGroup netGroup = CS104_RedundancyGroup_create("net");
+    CS104_RedundancyGroup_addAllowedClientPrefix(netGroup, "127.0.0.0", 8);
+    CS104_Slave_addRedundancyGroup(slave, netGroup);
+
+    CS104_RedundancyGroup hostGroup = CS104_RedundancyGroup_create("host");
+    CS104_RedundancyGroup_addAllowedClient(hostGroup, "127.0.0.1");
+    CS104_Slave_addRedundancyGroup(slave, hostGroup);
+
+    CS104_RedundancyGroup otherGroup = CS104_RedundancyGroup_create("other");
+    CS104_RedundancyGroup_addAllowedClientPrefix(otherGroup, "10.0.0.0", 8);
+    CS104_Slave_addRedundancyGroup(slave, otherGroup);
+
+    CS104_Slave_setWorkerThreads(slave, 2);
+    CS104_Slave_setListenerPerWorker(slave, true);
+
+    CS104_Slave_start(slave);
+
+    TEST_ASSERT_TRUE(CS104_Slave_isRunning(slave));
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+
+    int i;
+
+    /* w = 8 -> the client confirms the ASDUs immediately */
+    for (i = 0; i < 8; i++) {
+        CS101_ASDU newAsdu = CS101_ASDU_create(alParams, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+
+        InformationObject io = (InformationObject) MeasuredValueScaled_create(NULL, 110, i, IEC60870_QUALITY_GOOD);
+
+        CS101_ASDU_addInformationObject(newAsdu, io);
+
+        InformationObject_destroy(io);
+
+        CS104_Slave_enqueueASDU(slave, newAsdu);
+
+        CS101_ASDU_destroy(newAsdu);
+    }
+
+    TEST_ASSERT_EQUAL_INT(8, CS104_Slave_getNumberOfQueueEntries(slave, netGroup));
+    TEST_ASSERT_EQUAL_INT(8, CS104_Slave_getNumberOfQueueEntries(slave, hostGroup));
+
+    CS104_Connection cons[2];
+    int received[2];
+
+    const char* localAddresses[2] = {"127.0.0.1", "127.0.0.2"};
+
+    for (i = 0; i < 2; i++) {
+        received[i] = 0;
+
+        cons[i] = CS104_Connection_create("127.0.0.1", 20004);
+        CS104_Connection_setLocalAddress(cons[i], localAddresses[i], 0);
+        CS104_Connection_setASDUReceivedHandler(cons[i], test_CS104Slave_WorkerThreads_asduReceivedHandler, &(received[i]));
+
+        TEST_ASSERT_TRUE(CS104_Connection_connect(cons[i]));
+
+        CS104_Connection_sendStartDT(cons[i]);
+
+        if (i == 0) {
+            /* 127.0.0.1 -> host group (only the queue of this group is confirmed) */
+            TEST_ASSERT_EQUAL_INT(0, test_CS104Slave_ListenerPerWorker_waitForQueueEntries(slave, hostGroup, 0));
+            TEST_ASSERT_EQUAL_INT(8, CS104_Slave_getNumberOfQueueEntries(slave, netGroup));
+        }
+    }
+
+    /* 127.0.0.2 -> network group */
+    TEST_ASSERT_EQUAL_INT(0, test_CS104Slave_ListenerPerWorker_waitForQueueEntries(slave, netGroup, 0));
+    TEST_ASSERT_EQUAL_INT(8, CS104_Slave_getNumberOfQueueEntries(slave, otherGroup));
+
+    TEST_ASSERT_EQUAL_INT(8, received[0]);
+    TEST_ASSERT_EQUAL_INT(8, received[1]);
+    TEST_ASSERT_EQUAL_INT(2, CS104_Slave_getOpenConnections(slave));
+
+    /* closed connections are released by the workers */
+    CS104_Connection_destroy(cons[0]);
+
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    while ((CS104_Slave_getOpenConnections(slave) > 1) && (Hal_getMonotonicTimeInMs() < startTime + 2000))
+        Thread_sleep(10);
+
+    TEST_ASSERT_EQUAL_INT(1, CS104_Slave_getOpenConnections(slave));
+
+    CS104_Slave_stop(slave);
+
+    TEST_ASSERT_FALSE(CS104_Slave_isRunning(slave));
+    TEST_ASSERT_EQUAL_INT(0, CS104_Slave_getOpenConnections(slave));
+    TEST_ASSERT_EQUAL_INT(2, info.openedEvents);
+    TEST_ASSERT_EQUAL_INT(2, info.closedEvents);
+
+    CS104_Connection_destroy(cons[1]);
+
+    /* the port is released when the slave is stopped */
+    CS104_Slave_start(slave);
+
+    TEST_ASSERT_TRUE(CS104_Slave_isRunning(slave));
+
+    cons[0] = CS104_Connection_create("127.0.0.1", 20004);
+
+    TEST_ASSERT_TRUE(CS104_Connection_connect(cons[0]));
+
+    CS104_Connection_destroy(cons[0]);
+
+    CS104_Slave_stop(slave);
+
+    CS104_Slave_destroy(slave);
+
+    Semaphore_destroy(info.lock);
+#endif
+}
+
+
+static int
+test_CS104Slave_waitForOpenConnections(CS104_Slave slave, int expected)
+{
+    uint64_t startTime = Hal_getMonotonicTimeInMs();
+
+    while ((CS104_Slave_getOpenConnections(slave) != expected) && (Hal_getMonotonicTimeInMs() < startTime + 2000))
+        Thread_sleep(10);
+
+    /* give the slave time to accept more connections than expected */
+    Thread_sleep(100);
+
+    return CS104_Slave_getOpenConnections(slave);
+}
+
+void
+test_CS104Slave_AddAllowedClientWhileRunning(void)
+{
+#ifndef _WIN32
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+
+    CS104_Slave_setServerMode(slave, CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS);
+    CS104_Slave_setLocalPort(slave, 20004);
+    CS104_Slave_setMaxOpenConnections(slave, 2);
+
+    /* no catch-all group -> clients that don't match are refused */
+    CS104_RedundancyGroup group = CS104_RedundancyGroup_create("group");
+    CS104_RedundancyGroup_addAllowedClient(group, "127.0.0.1");
+    CS104_Slave_addRedundancyGroup(slave, group);
+
+    CS104_Slave_setWorkerThreads(slave, 2);
+    CS104_Slave_setListenerPerWorker(slave, true);
+
+    CS104_Slave_start(slave);
+
+    TEST_ASSERT_TRUE(CS104_Slave_isRunning(slave));
+
+    CS104_Connection con = CS104_Connection_create("127.0.0.1", 20004);
+    CS104_Connection_setLocalAddress(con, "127.0.0.2", 0);
+
+    CS104_Connection_connect(con);
+
+    TEST_ASSERT_EQUAL_INT(0, test_CS104Slave_waitForOpenConnections(slave, 0));
+
+    CS104_Connection_destroy(con);
+
+    /* the new allowed client is used for the next connection requests */
+    CS104_RedundancyGroup_addAllowedClientPrefix(group, "127.0.0.0", 24);
+
+    CS104_Connection cons[4];
+
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        cons[i] = CS104_Connection_create("127.0.0.1", 20004);
+        CS104_Connection_setLocalAddress(cons[i], "127.0.0.2", 0);
+    }
+
+    for (i = 0; i < 4; i++)
+        CS104_Connection_connect(cons[i]);
+
+    /* the workers accept the connections concurrently - the limit is not exceeded */
+    TEST_ASSERT_EQUAL_INT(2, test_CS104Slave_waitForOpenConnections(slave, 2));
+
+    CS104_Slave_stop(slave);
+
+    TEST_ASSERT_EQUAL_INT(0, CS104_Slave_getOpenConnections(slave));
+
+    for (i = 0; i < 4; i++)
+        CS104_Connection_destroy(cons[i]);
+
+    CS104_Slave_destroy(slave);
+#endif
+}
+
 void
 test_CS101_ASDU_addObjectOfWrongType(void)
 {
@@ -7370,6 +11707,49 @@ main(int argc, char** argv)
 
     RUN_TEST(test_CS104_Connection_async_success);
     RUN_TEST(test_CS104_Connection_async_timeout);
+    RUN_TEST(test_Socket_resolveHostname);
+    RUN_TEST(test_CS104_Connection_connectUsingHostname);
+    RUN_TEST(test_CS104_Connection_connectUsingHostnameKeepsLocalAddress);
+    RUN_TEST(test_CS104_Connection_reconnectBackoff);
+    RUN_TEST(test_CS104RedundantConnection_switchover);
+    RUN_TEST(test_CS104RedundantConnection_repeatedEvents);
+    RUN_TEST(test_CS104Slave_adaptiveAck);
+    RUN_TEST(test_CS104_Connection_adaptiveAck);
+    RUN_TEST(test_CS104_AckScheduler_holdAtW);
+    RUN_TEST(test_CS101_PointCache);
+    RUN_TEST(test_CS104_Connection_pointCache);
+    RUN_TEST(test_SerialTransceiverFT12_bulkRead);
+    RUN_TEST(test_SerialPort_asyncTransmit);
+    RUN_TEST(test_CS101_PortScheduler);
+    RUN_TEST(test_TimerWheel_Levels);
+    RUN_TEST(test_TimerWheel_LargeTimeSteps);
+    RUN_TEST(test_CS101_Master_manySlaves);
+    RUN_TEST(test_CS101_Master_pollModePriority);
+    RUN_TEST(test_SerialPort_virtualPorts);
+    RUN_TEST(test_CS101_Slave_queues);
+    RUN_TEST(test_CS101_Slave_isReadyClass1QueueFull);
+    RUN_TEST(test_LinkLayer_fixedFrames);
+    RUN_TEST(test_LinkLayer_balancedRepeatAfterReceivedFrame);
+    RUN_TEST(test_CS101_CommandFanOut);
+    RUN_TEST(test_CS101_LinkLayerStatistics);
+    RUN_TEST(test_CS101_ProcessImage);
+    RUN_TEST(test_CS101_ProcessImage_Events);
+    RUN_TEST(test_CS101_ProcessImage_Snapshot);
+    RUN_TEST(test_CS101_ProcessImage_StreamedResponse);
+    RUN_TEST(test_CS104Slave_StreamedResponse);
+    RUN_TEST(test_CS104Slave_StreamedResponseAbort);
+    RUN_TEST(test_CS104Slave_EventLoop);
+    RUN_TEST(test_CS104Slave_EventLoopWakeup);
+    RUN_TEST(test_CS104Slave_EventLoopPendingConnections);
+    RUN_TEST(test_CS104Slave_EventLoopTimeouts);
+    RUN_TEST(test_CS104Slave_RawMessageHandlerLock);
+    RUN_TEST(test_CS104Slave_ConcurrentSend);
+    RUN_TEST(test_CS104Slave_StopDtCycles);
+    RUN_TEST(test_CS104Slave_WorkerThreads);
+    RUN_TEST(test_CS104Slave_WorkerWakeup);
+    RUN_TEST(test_CS104_PrefixTable);
+    RUN_TEST(test_CS104Slave_ListenerPerWorker);
+    RUN_TEST(test_CS104Slave_AddAllowedClientWhileRunning);
 
     RUN_TEST(test_CS101_ASDU_addObjectOfWrongType);
     RUN_TEST(test_CS101_ASDU_addUntilOverflow);